@@ -0,0 +1,50 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_BENCHMARK_H
+#define DOSBOX_BENCHMARK_H
+
+#include <string>
+
+/*
+Benchmark Mode
+~~~~~~~~~~~~~~
+Started with the '--benchmark <seconds>' command line option, which runs
+without a visible window or audio device. The machine runs for the given
+number of emulated seconds, then the emulated throughput and the host time
+the subsystems took are printed and the emulator exits.
+
+With fixed cycles the emulation isn't paced to the host's clock and runs as
+fast as the host allows, so the host time taken is deterministic to
+measure. With 'cycles = max' it runs in real time and the throughput tells
+how many cycles the host kept up with.
+
+With '--benchmark-report <file>' the results are also written as JSON,
+together with the peak resident memory and the event counters (dynrec
+translations, the busiest I/O ports, ...), so runs of different builds can
+be compared by scripts. 'meson test --benchmark' runs the reference
+workloads in 'tests/files/benchmarks' this way.
+*/
+
+// Starts counting with the first emulated millisecond after the call. The
+// JSON report is skipped if the path is empty.
+void BENCHMARK_Start(int emulated_seconds, const std::string& report_path);
+
+#endif
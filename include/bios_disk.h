@@ -23,11 +23,16 @@
 
 #include <cstdio>
 #include <array>
+#include <list>
 #include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
 
 #include "bios.h"
 #include "dos_inc.h"
 #include "mem.h"
+#include "std_filesystem.h"
 
 /* The Section handling Bios Disk Access */
 #define BIOS_MAX_DISK 10
@@ -42,6 +47,9 @@ struct diskGeo {
 };
 extern diskGeo DiskGeometryList[];
 
+class CompressedImage;
+class DiskDelta;
+
 class imageDisk  {
 public:
 	uint8_t Read_Sector(uint32_t head,uint32_t cylinder,uint32_t sector,void * data);
@@ -54,15 +62,42 @@ public:
 	uint8_t GetBiosType(void);
 	uint32_t getSectSize(void);
 
+	// Writes out the sectors that are only in the cache so far
+	void Flush();
+
+	// Compressed images are only read, their writes can go to deltas
+	bool IsCompressed() const
+	{
+		return compressed != nullptr;
+	}
+
+	// Leaves the image file as it is and keeps the writes in the delta
+	// file instead, along with the snapshots taken on top of it. These
+	// are named after the delta file with their number appended (.1,
+	// .2, and so on).
+	bool AttachDeltas(const std_fs::path& path);
+	bool HasDeltas() const
+	{
+		return !deltas.empty();
+	}
+	size_t GetNumSnapshots() const
+	{
+		return deltas.empty() ? 0 : deltas.size() - 1;
+	}
+
+	// Adds a delta on top that takes the writes from now on
+	bool TakeSnapshot();
+
+	// Discards the writes since the last snapshot. A snapshot without
+	// any writes is dropped first, so rolling back again goes back to
+	// the snapshot before it, and eventually to the image itself.
+	bool RollBack();
+
 	imageDisk(FILE *img_file, const char *img_name, uint32_t img_size_k, bool is_hdd);
 	imageDisk(const imageDisk&) = delete; // prevent copy
 	imageDisk& operator=(const imageDisk&) = delete; // prevent assignment
 
-	virtual ~imageDisk()
-	{
-		if (diskimg != nullptr)
-			fclose(diskimg);
-	}
+	virtual ~imageDisk();
 
 	bool hardDrive;
 	bool active;
@@ -75,6 +110,52 @@ public:
 private:
 	cross_off_t current_fpos;
 	enum { NONE,READ,WRITE } last_action;
+
+	// Recently used sectors, so the file systems on the image don't
+	// turn every FAT, directory, and data sector into a seek and a read.
+	// Writes stay in the cache until enough of them pile up to be
+	// written out in runs of consecutive sectors.
+	struct CachedSector {
+		std::vector<uint8_t> data = {};
+		std::list<uint32_t>::iterator lru_pos = {};
+		bool is_dirty = false;
+	};
+	std::unordered_map<uint32_t, CachedSector> sector_cache = {};
+	// Most recently used first
+	std::list<uint32_t> lru_sectors = {};
+	uint32_t num_dirty = 0;
+	std::optional<uint32_t> last_read_sectnum = {};
+	// Known once the first write went through or failed
+	std::optional<bool> is_writable = {};
+
+	// The whole image mapped into memory, the sectors in it bypass the
+	// cache. Writable only if the image file was opened for writing.
+	uint8_t* mapped_data    = nullptr;
+	size_t mapped_size      = 0;
+	bool is_mapped_writable = false;
+
+	// Reads the image when the file holds it compressed
+	std::unique_ptr<CompressedImage> compressed;
+
+	void MapImage();
+	uint8_t* GetMappedSector(uint32_t sectnum, bool for_writing) const;
+
+	// The first one is the oldest, the last one takes the writes
+	std::vector<std::unique_ptr<DiskDelta>> deltas;
+	std_fs::path delta_path = {};
+	uint64_t image_size     = 0;
+
+	std::optional<size_t> ReadBytes(cross_off_t bytenum,
+	                                std::vector<uint8_t>& buffer);
+	uint8_t WriteToDeltas(cross_off_t bytenum, uint32_t num_bytes,
+	                      const uint8_t* data);
+	std::unique_ptr<DiskDelta> OpenDelta(size_t index) const;
+
+	uint8_t ReadFromImage(uint32_t sectnum, uint32_t num_sectors, uint8_t* data);
+	uint8_t WriteToImage(uint32_t sectnum, uint32_t num_sectors,
+	                     const uint8_t* data);
+	CachedSector& CacheSector(uint32_t sectnum);
+	void ClearCache();
 };
 
 void updateDPT(void);
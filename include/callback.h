@@ -28,6 +28,13 @@
 typedef Bitu (*CallBack_Handler)(void);
 extern CallBack_Handler CallBack_Handlers[];
 
+// Fast callbacks are run by the CPU cores in place, without leaving the
+// decode loop. They return false to take the regular path instead, which
+// they must do for anything beyond reading or changing registers, the
+// flags image on the stack and memory (idling, mode switches, I/O, ...).
+typedef bool (*CallBack_FastHandler)(void);
+extern CallBack_FastHandler CallBack_FastHandlers[];
+
 enum {
 	CB_RETN,
 	CB_RETF,
@@ -99,6 +106,19 @@ callback_number_t CALLBACK_Setup(callback_number_t cb_number, CallBack_Handler h
 
 const char* CALLBACK_GetDescription(callback_number_t cb_number);
 
+void CALLBACK_SetFastHandler(callback_number_t cb_number, CallBack_FastHandler handler);
+
+// Called by the CPU cores on the callback instruction, with the flags
+// filled in and IP saved; returns true if the call has been served
+static inline bool CALLBACK_RunFast(const Bitu cb_number)
+{
+	if (cb_number >= CB_MAX) {
+		return false;
+	}
+	const auto handler = CallBack_FastHandlers[cb_number];
+	return handler && handler();
+}
+
 void CALLBACK_SCF(bool val);
 void CALLBACK_SZF(bool val);
 void CALLBACK_SIF(bool val);
@@ -130,6 +150,8 @@ public:
 
 	//Only allocate a callback number
 	void Allocate(CallBack_Handler handler,const char* description=nullptr);
+
+	void SetFastHandler(CallBack_FastHandler handler);
 	uint16_t Get_callback() {
 		return m_cb_number;
 	}
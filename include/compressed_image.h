@@ -0,0 +1,136 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_COMPRESSED_IMAGE_H
+#define DOSBOX_COMPRESSED_IMAGE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "std_filesystem.h"
+
+/*
+CompressedImage Class
+~~~~~~~~~~~~~~~~~~~~~
+Random access to disk and CD images compressed in the BGZF format, the
+blocked gzip that bgzip (part of htslib) writes. The file is a series of
+gzip members, each holding up to 64 KB of the image and recording its own
+compressed size. Walking the headers gives an index of the blocks, so any
+part of the image can be read by inflating just the blocks holding it. The
+files are valid gzip files too, so gzip -d still restores the raw image.
+
+The most recently used blocks are kept inflated. When the image is read
+one block after the other, a worker thread inflates the next blocks ahead
+of time.
+*/
+
+class CompressedImage {
+public:
+	// Returns nothing if the file isn't in the BGZF format or is damaged
+	static std::unique_ptr<CompressedImage> Open(const std_fs::path& path);
+
+	// Whether the file starts like one in the BGZF format. Leaves the
+	// file position as it was.
+	static bool IsCompressed(FILE* file);
+	static bool IsCompressed(const std_fs::path& path);
+
+	// Size of the uncompressed image, or nothing if the file isn't in the
+	// BGZF format or is damaged. Leaves the file position as it was.
+	static std::optional<uint64_t> ReadImageSize(FILE* file);
+
+	// prevent copying
+	CompressedImage(const CompressedImage&) = delete;
+	// prevent assignment
+	CompressedImage& operator=(const CompressedImage&) = delete;
+
+	~CompressedImage();
+
+	// Size of the uncompressed image
+	uint64_t GetSize() const
+	{
+		return size;
+	}
+
+	// Returns how many bytes were read, fewer than asked for at the end
+	// of the image, or nothing if a block couldn't be read
+	std::optional<size_t> Read(uint64_t offset, size_t num_bytes,
+	                           uint8_t* data);
+
+private:
+	struct Block {
+		uint64_t file_offset     = 0;
+		uint64_t image_offset    = 0;
+		uint32_t compressed_size = 0;
+		uint32_t size            = 0;
+	};
+
+	struct InflatedBlock {
+		std::vector<uint8_t> data = {};
+		uint64_t last_used        = 0;
+		size_t index              = 0;
+	};
+
+	CompressedImage(const std_fs::path& path, FILE* file,
+	                std::vector<Block>&& blocks);
+
+	static bool ReadIndex(FILE* file, std::vector<Block>& blocks);
+
+	size_t FindBlock(uint64_t offset) const;
+	bool InflateBlock(size_t index, std::vector<uint8_t>& data);
+	const InflatedBlock* GetBlock(std::unique_lock<std::mutex>& lock,
+	                              size_t index);
+	InflatedBlock* FindInflated(size_t index);
+	InflatedBlock& InsertInflated(InflatedBlock&& block);
+	void QueueReadAhead(size_t index);
+	void InflateAhead();
+
+	std_fs::path path         = {};
+	FILE* file                = nullptr;
+	std::vector<Block> blocks = {};
+	uint64_t size             = 0;
+
+	// Guards the file position, the worker reads from the file too
+	std::mutex file_mutex = {};
+
+	std::vector<InflatedBlock> inflated   = {};
+	uint64_t use_count                    = 0;
+	std::optional<size_t> last_read_block = {};
+	std::thread worker                    = {};
+	std::mutex mutex                      = {};
+	std::condition_variable waiter        = {};
+	std::deque<size_t> queued_blocks      = {};
+	std::optional<size_t> inflating_block = {};
+	bool should_stop                      = false;
+};
+
+// Size of the image in the file, which for compressed images is the size
+// they have uncompressed. Leaves the file position as it was. Negative if
+// the size can't be determined.
+int64_t image_file_size_bytes(FILE* file);
+int64_t image_file_size_kb(FILE* file);
+
+#endif
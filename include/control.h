@@ -59,10 +59,12 @@ struct CommandLineArguments {
 	std::string working_dir;
 	std::string lang;
 	std::string machine;
+	std::string benchmark_report;
 	std::vector<std::string> conf;
 	std::vector<std::string> set;
 	std::optional<std::vector<std::string>> editconf;
 	std::optional<int> socket;
+	std::optional<int> benchmark;
 };
 
 class Config {
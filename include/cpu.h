@@ -62,6 +62,8 @@ extern int32_t CPU_CyclePercUsed;
 extern int32_t CPU_CycleLimit;
 extern int64_t CPU_IODelayRemoved;
 extern bool CPU_CycleAutoAdjust;
+extern bool CPU_UseCyclesGovernor;
+extern int CPU_CyclesHeadroom;
 extern Bitu CPU_AutoDetermineMode;
 
 extern ArchitectureType CPU_ArchitectureType;
@@ -87,6 +89,7 @@ Bits CPU_Core_Dyn_X86_Run() noexcept;
 Bits CPU_Core_Dyn_X86_Trap_Run() noexcept;
 Bits CPU_Core_Dynrec_Run() noexcept;
 Bits CPU_Core_Dynrec_Trap_Run() noexcept;
+void CPU_Core_Dynrec_LogStats();
 Bits CPU_Core_Prefetch_Run() noexcept;
 Bits CPU_Core_Prefetch_Trap_Run() noexcept;
 
@@ -136,6 +139,31 @@ void CPU_RET(bool use32,Bitu bytes,Bitu oldeip);
 void CPU_IRET(bool use32,Bitu oldeip);
 void CPU_HLT(Bitu oldeip);
 
+// Ways the guest tells us it's waiting for something to happen
+enum class IdleSource : uint8_t {
+	Halt,             // HLT instruction
+	KeyboardPoll,     // INT 16h keystroke checks and waits
+	DosIdle,          // INT 28h DOS idle interrupt
+	ReleaseTimeSlice, // INT 2Fh, AX=1680h
+	NumSources,
+};
+
+// Gives up the cycles left until the next PIC event. Emulated time then
+// runs ahead and the main loop sleeps once it's ahead of the host.
+void CPU_Idle(const IdleSource source);
+
+// For services the guest polls in a loop while it waits. A poll that found
+// nothing counts towards the guest being idle, and many of them within one
+// tick give up the rest of the time slice; a poll that found something
+// resets the count.
+void CPU_IdlePoll(const IdleSource source, const bool found_something);
+
+// Share of the emulated time spent idle since the start or the last reset,
+// in percent
+double CPU_GetIdlePercent(const IdleSource source);
+double CPU_GetIdlePercent();
+void CPU_ResetIdleStats();
+
 bool CPU_POPF(Bitu use32);
 bool CPU_PUSHF(Bitu use32);
 bool CPU_CLI(void);
@@ -194,6 +222,8 @@ void CPU_Push32(const uint32_t value);
 #define CR0_FPUPRESENT			0x00000010
 #define CR0_PAGING				0x80000000
 
+#define CR4_PAGESIZEEXTENSIONS	0x00000010
+
 // reasons for triggering a debug exception
 #define DBINT_BP0               0x00000001
 #define DBINT_BP1               0x00000002
@@ -500,6 +530,7 @@ struct CPUBlock {
 	Bitu cpl;							/* Current Privilege */
 	Bitu mpl;
 	Bitu cr0;
+	Bitu cr4;
 	bool pmode;							/* Is Protected mode enabled */
 	GDTDescriptorTable gdt;
 	DescriptorTable idt;
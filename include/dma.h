@@ -22,8 +22,10 @@
 
 #include "dosbox.h"
 
+#include <array>
 #include <cassert>
 #include <functional>
+#include <optional>
 
 #include "inout.h"
 #include "support.h"
@@ -36,6 +38,17 @@ enum DMAEvent {
 	DMA_UNMASKED,
 };
 
+// A block of guest memory a transfer reads from or writes to, addressed
+// directly in host memory
+struct DmaSpan {
+	uint8_t* data    = nullptr;
+	size_t num_bytes = 0;
+};
+
+// The second span is only used when the block isn't contiguous in host
+// memory, such as when it crosses into a remapped page
+using DmaSpans = std::array<DmaSpan, 2>;
+
 class Section;
 using DMA_ReservationCallback = std::function<void(Section*)>;
 
@@ -77,6 +90,16 @@ public:
 	size_t Read(size_t words, uint8_t* const dest_buffer);
 	size_t Write(size_t words, uint8_t* const src_buffer);
 
+	// Returns the memory the next words of the transfer cover, up to the
+	// terminal count, without moving the transfer along. This lets
+	// devices stream to or from guest RAM without a copy, followed by an
+	// Advance() over the words they used. Returns nothing if the memory
+	// isn't made of at most two host blocks; use Read() or Write() then.
+	std::optional<DmaSpans> GetSpans(size_t words) const;
+
+	// Moves the transfer along as Read() or Write() would, without copying
+	size_t Advance(size_t words);
+
 	// Reset the channel back to defaults, without callbacks or reservations.
 	void Reset();
 
@@ -121,7 +121,10 @@ enum { STDIN=0,STDOUT=1,STDERR=2,STDAUX=3,STDPRN=4};
 enum { HAND_NONE=0,HAND_FILE,HAND_DEVICE};
 
 void DOS_SetupFiles (void);
+void DOS_ShutDownFiles();
+void DOS_SetFileWriteBuffer(size_t num_bytes);
 bool DOS_ReadFile(uint16_t handle,uint8_t * data,uint16_t * amount, bool fcb = false);
+bool DOS_ReadFileToGuest(uint16_t handle, PhysPt dest, uint16_t* amount);
 bool DOS_WriteFile(uint16_t handle,uint8_t * data,uint16_t * amount,bool fcb = false);
 bool DOS_SeekFile(uint16_t handle,uint32_t * pos,uint32_t type,bool fcb = false);
 bool DOS_CloseFile(uint16_t handle,bool fcb = false,uint8_t * refcnt = nullptr);
@@ -131,6 +134,11 @@ bool DOS_ForceDuplicateEntry(uint16_t entry,uint16_t newentry);
 bool DOS_GetFileDate(uint16_t entry, uint16_t* otime, uint16_t* odate);
 bool DOS_SetFileDate(uint16_t entry, uint16_t ntime, uint16_t ndate);
 
+// Counts the changes to the files and directories made through DOS or seen
+// by the drive caches, so what was looked up can be kept until the next one
+void DOS_NoteFileSystemChange();
+uint32_t DOS_GetFileSystemChanges();
+
 uint16_t DOS_GetBiosTimePacked();
 uint16_t DOS_GetBiosDatePacked();
 
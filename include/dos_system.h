@@ -22,7 +22,10 @@
 
 #include "dosbox.h"
 
+#include <memory>
+#include <optional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "bit_view.h"
@@ -116,6 +119,8 @@ public:
 	}
 
 	virtual bool	Read(uint8_t * data,uint16_t * size)=0;
+	// Reads into guest memory; by default staged through dos_copybuf
+	virtual bool ReadToGuest(PhysPt dest, uint16_t* size);
 	virtual bool	Write(uint8_t * data,uint16_t * size)=0;
 	virtual bool	Seek(uint32_t * pos,uint32_t type)=0;
 	virtual bool	Close()=0;
@@ -126,6 +131,8 @@ public:
 	virtual Bits RemoveRef() { return --refCtr; }
 	virtual bool UpdateDateTimeFromHost() { return true; }
 	virtual void SetFlagReadOnlyMedium() {}
+	// Hands the writes held back in buffers over to the host
+	virtual void Flush() {}
 
 	void SetDrive(uint8_t drv) { hdrive=drv;}
 	uint8_t GetDrive(void) { return hdrive;}
@@ -186,13 +193,15 @@ public:
 	          const char* basedir);
 	localFile(const localFile&)            = delete; // prevent copying
 	localFile& operator=(const localFile&) = delete; // prevent assignment
+	~localFile() override;
 	bool Read(uint8_t* data, uint16_t* size) override;
+	bool ReadToGuest(PhysPt dest, uint16_t* size) override;
 	bool Write(uint8_t* data, uint16_t* size) override;
 	bool Seek(uint32_t* pos, uint32_t type) override;
 	bool Close() override;
 	uint16_t GetInformation() override;
 	bool UpdateDateTimeFromHost() override;
-	void Flush();
+	void Flush() override;
 	void SetFlagReadOnlyMedium() override
 	{
 		read_only_medium = true;
@@ -215,8 +224,19 @@ private:
 	void fseek_and_check(int whence);
 	bool fseek_to_and_check(long pos, int whence);
 
+	// Files opened read-only are read from a mapping of the whole file.
+	// The position then lives in stream_pos until the mapping is dropped.
+	void map_for_reading();
+	bool mapping_matches_file() const;
+	void unmap();
+
+	const uint8_t* mapped_data = nullptr;
+	size_t mapped_size         = 0;
+	bool tried_mapping         = false;
+
 	bool read_only_medium     = false;
 	bool set_archive_on_close = false;
+	bool has_faked_motion     = false;
 
 	enum class LastAction : uint8_t { None, Read, Write };
 	LastAction last_action = LastAction::None;
@@ -228,6 +248,8 @@ private:
 #define MAX_OPENDIRS 2048
 //Can be high as it's only storage (16 bit variable)
 
+class HostDirPrefetcher;
+
 class DOS_Drive_Cache {
 public:
 	enum TDirSort { NOSORT, ALPHABETICAL, DIRALPHABETICAL, ALPHABETICALREV, DIRALPHABETICALREV };
@@ -240,6 +262,10 @@ public:
 	void SetBaseDir(const char *path);
 	void SetDirSort(TDirSort sort) { sortDirType = sort; }
 
+	// Reads the base directory's tree in the background and follows the
+	// changes made to it on the host, where that's supported
+	void StartPrefetching();
+
 	bool  OpenDir              (const char* path, uint16_t& id);
 	bool  ReadDir              (uint16_t id, char* &result);
 
@@ -260,6 +286,21 @@ public:
 	void SetLabel(const char *name, bool cdrom, bool allowupdate);
 	const char *GetLabel() const { return label; }
 
+	// What FindNext reports about a file
+	struct FileMetadata {
+		uint32_t size                = 0;
+		uint16_t date                = 0;
+		uint16_t time                = 0;
+		FatAttributeFlags attributes = {};
+	};
+
+	// The metadata of the file at the host path as it was recently looked
+	// up, so directory searches can skip asking the host again. It's
+	// dropped on any change to the file system made through DOS, and
+	// after a short while for the changes made on the host.
+	std::optional<FileMetadata> GetMetadata(const std::string& host_path);
+	void SetMetadata(const std::string& host_path, const FileMetadata& metadata);
+
 	class CFileInfo {
 	public:
 		CFileInfo(void)
@@ -281,6 +322,7 @@ public:
 			}
 			fileList.clear();
 			longNameList.clear();
+			longNameIndex.clear();
 		}
 
 		char        orgname[CROSS_LEN];
@@ -293,6 +335,9 @@ public:
 		// contents
 		std::vector<CFileInfo*> fileList;
 		std::vector<CFileInfo*> longNameList;
+		// The longNameList entries by their host name, upper-cased on
+		// hosts with case-insensitive file systems
+		std::unordered_map<std::string, CFileInfo*> longNameIndex;
 	};
 
 private:
@@ -314,6 +359,12 @@ private:
 	uint16_t		GetFreeID		(CFileInfo* dir);
 	void		Clear			(void);
 
+	bool CacheInPrefetched(CFileInfo* dir);
+	void ApplyHostChanges();
+	CFileInfo* FindCachedHostDir(const std::string& host_dir);
+	void AddHostEntry(CFileInfo* dir, const std::string& name, bool is_directory);
+	void RemoveHostEntry(CFileInfo* dir, size_t index);
+
 	CFileInfo*	dirBase;
 	char		dirPath				[CROSS_LEN];
 	char		basePath			[CROSS_LEN];
@@ -329,6 +380,16 @@ private:
 
 	char		label				[CROSS_LEN];
 	bool		updatelabel;
+
+	std::unique_ptr<HostDirPrefetcher> prefetcher;
+	bool is_applying_host_changes = false;
+
+	struct CachedMetadata {
+		FileMetadata metadata = {};
+		int64_t looked_up_ms  = 0;
+	};
+	std::unordered_map<std::string, CachedMetadata> metadata_cache = {};
+	uint32_t metadata_fs_changes = 0;
 };
 
 enum class DosDriveType : uint16_t {
@@ -338,6 +399,7 @@ enum class DosDriveType : uint16_t {
 	Fat     = 3,
 	Iso     = 4,
 	Virtual = 5,
+	Zip     = 6,
 };
 
 class DOS_Drive {
@@ -390,6 +452,8 @@ public:
 		case DosDriveType::Iso:
 			return MSG_Get("MOUNT_TYPE_ISO") + std::string(" ") + info;
 		case DosDriveType::Virtual: return MSG_Get("MOUNT_TYPE_VIRTUAL");
+		case DosDriveType::Zip:
+			return MSG_Get("MOUNT_TYPE_ZIP") + std::string(" ") + info;
 		default: return MSG_Get("MOUNT_TYPE_UNKNOWN");
 		}
 	}
@@ -22,6 +22,7 @@
 #include "dosbox.h"
 
 #include <memory>
+#include <unordered_map>
 #include <unordered_set>
 #include <string>
 #include <vector>
@@ -193,11 +194,27 @@ struct partTable {
 #endif
 //Forward
 class imageDisk;
+
+// The clusters of a file's chain as runs of consecutive clusters, so the
+// cluster at a position is found without walking the FAT. Only links are
+// kept; whether the chain ends is read from the FAT again, as appending
+// to the chain doesn't change the links already in it.
+struct FatClusterChain {
+	struct Run {
+		uint32_t first_index   = 0;
+		uint32_t first_cluster = 0;
+		uint32_t num_clusters  = 0;
+	};
+	uint32_t start_cluster  = 0;
+	uint32_t fat_generation = 0;
+	std::vector<Run> runs   = {};
+};
+
 class fatDrive final : public DOS_Drive {
 public:
 	fatDrive(const char* sysFilename, uint32_t bytesector,
 	         uint32_t cylsector, uint32_t headscyl, uint32_t cylinders,
-	         bool roflag);
+	         bool roflag, const std::string& delta_filename = {});
 	fatDrive(const fatDrive&)            = delete; // prevent copying
 	fatDrive& operator=(const fatDrive&) = delete; // prevent assignment
 	bool FileOpen(DOS_File** file, char* name, uint32_t flags) override;
@@ -226,11 +243,13 @@ public:
 public:
 	uint8_t readSector(uint32_t sectnum, void * data);
 	uint8_t writeSector(uint32_t sectnum, void * data);
-	uint32_t getAbsoluteSectFromBytePos(uint32_t startClustNum, uint32_t bytePos);
+	uint32_t getAbsoluteSectFromBytePos(uint32_t startClustNum, uint32_t bytePos,
+	                                    FatClusterChain* chain = nullptr);
 	uint32_t getSectorCount();
 	uint32_t getSectorSize(void);
 	uint32_t getClusterSize(void);
-	uint32_t getAbsoluteSectFromChain(uint32_t startClustNum, uint32_t logicalSector);
+	uint32_t getAbsoluteSectFromChain(uint32_t startClustNum, uint32_t logicalSector,
+	                                  FatClusterChain* chain = nullptr);
 	bool allocateCluster(uint32_t useCluster, uint32_t prevCluster);
 	uint32_t appendCluster(uint32_t startCluster);
 	void deleteClustChain(uint32_t startCluster, uint32_t bytePos);
@@ -238,13 +257,22 @@ public:
 	bool directoryBrowse(uint32_t dirClustNumber, direntry *useEntry, int32_t entNum, int32_t start=0);
 	bool directoryChange(uint32_t dirClustNumber, direntry *useEntry, int32_t entNum);
 	bool isReadOnly() const { return readonly; }
+
+	// After the sectors changed underneath, such as when the image was
+	// rolled back to a snapshot
+	void DiscardDecodedFat();
 	std::shared_ptr<imageDisk> loadedDisk;
 	bool created_successfully;
 	uint32_t partSectOff;
 
 private:
 	uint32_t getClusterValue(uint32_t clustNum);
+	uint32_t readClusterValue(uint32_t clustNum);
 	void setClusterValue(uint32_t clustNum, uint32_t clustValue);
+	void loadFatTable();
+	bool isEndOfChain(uint32_t clustValue) const;
+	bool findChainCluster(FatClusterChain& chain, uint32_t index,
+	                      uint32_t& cluster);
 	uint32_t getClustFirstSect(uint32_t clustNum);
 	bool FindNextInternal(uint32_t dirClustNumber, DOS_DTA & dta, direntry *foundEntry);
 	bool getDirClustNum(char * dir, uint32_t * clustNum, bool parDir);
@@ -267,6 +295,13 @@ private:
 
 	uint8_t fatSectBuffer[1024];
 	uint32_t curFatSect;
+
+	// The first FAT decoded, with the value of every cluster. Only links
+	// changing bump the generation, which invalidates the cached chains.
+	std::vector<uint32_t> fat_table = {};
+	bool tried_loading_fat_table    = false;
+	uint32_t fat_generation         = 0;
+	bool is_writing_fat             = false;
 };
 
 class cdromDrive final : public localDrive
@@ -395,7 +430,10 @@ public:
 	bool FileExists(const char* name) override;
 	bool FileStat(const char* name, FileStat_Block* const stat_block) override;
 	uint8_t GetMediaByte(void) override;
-	void EmptyCache(void) override {}
+	void EmptyCache(void) override
+	{
+		dirRecordsCache.clear();
+	}
 	bool isRemote(void) override;
 	bool isRemovable(void) override;
 	Bits UnMount(void) override;
@@ -416,13 +454,26 @@ private:
 	bool GetNextDirEntry(const int dirIterator, isoDirEntry* de);
 	void FreeDirIterator(const int dirIterator);
 	bool ReadCachedSector(uint8_t** buffer, const uint32_t sector);
-	
+
+	// The parsed records of a directory in disk order, and their
+	// indexes sorted by upper-case name for binary-search lookups
+	struct DirRecords {
+		std::vector<isoDirEntry> entries = {};
+		std::vector<std::string> names   = {};
+		std::vector<uint32_t> byName     = {};
+	};
+	using dir_records_t = std::shared_ptr<const DirRecords>;
+
+	dir_records_t GetDirRecords(const isoDirEntry* de);
+
+	// Keyed by the directory's extent location
+	std::unordered_map<uint32_t, dir_records_t> dirRecordsCache = {};
+
 	struct DirIterator {
-		bool valid;
-		bool root;
-		uint32_t currentSector;
-		uint32_t endSector;
-		uint32_t pos;
+		bool valid            = false;
+		bool root             = false;
+		dir_records_t records = {};
+		size_t pos            = 0;
 	} dirIterators[MAX_OPENDIRS];
 	
 	int nextFreeDirIterator;
@@ -443,6 +494,53 @@ private:
 	char discLabel[32];
 };
 
+class ZipArchive; // forward declare
+
+// Mounts a ZIP archive as a read-only drive. The central directory is read
+// once when mounting, stored files are read straight from the archive, and
+// deflated ones are inflated when first read.
+class zipDrive final : public DOS_Drive {
+public:
+	zipDrive(const char* archive_path, uint8_t mediaid, int& error);
+	bool FileOpen(DOS_File** file, char* name, uint32_t flags) override;
+	bool FileCreate(DOS_File** file, char* name,
+	                FatAttributeFlags attributes) override;
+	bool FileUnlink(char* name) override;
+	bool RemoveDir(char* dir) override;
+	bool MakeDir(char* dir) override;
+	bool TestDir(char* dir) override;
+	bool FindFirst(char* _dir, DOS_DTA& dta, bool fcb_findfirst) override;
+	bool FindNext(DOS_DTA& dta) override;
+	bool GetFileAttr(char* name, FatAttributeFlags* attr) override;
+	bool SetFileAttr(const char* name, const FatAttributeFlags attr) override;
+	bool Rename(char* oldname, char* newname) override;
+	bool AllocationInfo(uint16_t* bytes_sector, uint8_t* sectors_cluster,
+	                    uint16_t* total_clusters,
+	                    uint16_t* free_clusters) override;
+	bool FileExists(const char* name) override;
+	bool FileStat(const char* name, FileStat_Block* const stat_block) override;
+	uint8_t GetMediaByte() override;
+	void EmptyCache() override {}
+	bool isRemote() override;
+	bool isRemovable() override;
+	Bits UnMount() override;
+
+private:
+	zipDrive(const zipDrive&) = delete;            // prevent copying
+	zipDrive& operator=(const zipDrive&) = delete; // prevent assignment
+
+	// A directory being listed and the position within its entries
+	struct Search {
+		uint32_t dir = 0;
+		uint32_t pos = 0;
+	};
+
+	std::shared_ptr<ZipArchive> archive = {};
+	std::vector<Search> searches        = {};
+	uint16_t next_search                = 0;
+	uint8_t mediaid                     = 0;
+};
+
 class VFILE_Block;
 using vfile_block_t = std::shared_ptr<VFILE_Block>;
 
@@ -524,7 +622,7 @@ private:
 	void remove_DOSdir_from_cache(const char* name);
 	void update_cache(bool read_directory_contents = false);
 
-	std::vector<std::string> deleted_files_in_base; //Set is probably better, or some other solution (involving the disk).
+	std::unordered_set<std::string> deleted_files_in_base;
 	std::vector<std::string> deleted_paths_in_base; //Currently only used to hide the overlay folder.
 	std::string overlap_folder;
 	void add_deleted_file(const char* name, bool create_on_disk);
@@ -546,6 +644,26 @@ private:
 	std::vector<std::string> DOSnames_cache; //Also set is probably better.
 	std::vector<std::string> DOSdirs_cache; //Can not blindly change its type. it is important that subdirs come after the parent directory.
 	const std::string special_prefix;
+
+	// The overlay's directory listings by their path relative to the
+	// overlay, kept on disk so mounting only reads the directories that
+	// changed since
+	struct OverlayEntry {
+		std::string name  = {};
+		bool is_directory = false;
+	};
+	struct OverlayListing {
+		std_fs::file_time_type mtime       = {};
+		std::vector<OverlayEntry> entries = {};
+	};
+	using OverlayIndex = std::unordered_map<std::string, OverlayListing>;
+	OverlayIndex overlay_index = {};
+	bool overlay_index_changed = false;
+
+	std::string get_overlay_index_path() const;
+	void load_overlay_index();
+	void save_overlay_index() const;
+	bool read_overlay_dir(const std::string& dir, OverlayIndex& new_index);
 };
 
 #endif
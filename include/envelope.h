@@ -74,6 +74,13 @@ public:
 
 	void Reactivate();
 
+	// True once the envelope has gone dormant, so Process() would leave
+	// the frames untouched
+	bool IsDone() const
+	{
+		return is_done;
+	}
+
 	// prevent copying
 	Envelope(const Envelope&) = delete;
 
@@ -91,6 +98,7 @@ private:
 
 	using process_f   = std::function<void(Envelope&, bool, AudioFrame&)>;
 	process_f process = &Envelope::Apply;
+	bool is_done      = false;
 
 	std::string channel_name = {};
 
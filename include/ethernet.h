@@ -23,6 +23,8 @@
 
 #include "dosbox.h"
 
+#include <array>
+#include <cstdint>
 #include <functional>
 #include <string>
 
@@ -79,6 +81,18 @@ public:
 	virtual void GetPackets(std::function<int(const uint8_t *, int)> callback) = 0;
 };
 
+/** An Ethernet frame as queued between a backend's network thread and the
+ * emulated adapter.
+ */
+struct EthernetFrame {
+	static constexpr int MaxSize = 14 + 1500; /*!< header + payload */
+
+	int len = 0;
+	std::array<uint8_t, MaxSize> data = {};
+
+	int64_t received_us = 0; /*!< when the host received it */
+};
+
 /** Opens a virtual Ethernet connection to a backend.
  * This function will try to create a new EthernetConnection based on whichever
  * implementation is most appropriate for the backend requested.
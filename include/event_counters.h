@@ -0,0 +1,103 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_EVENT_COUNTERS_H
+#define DOSBOX_EVENT_COUNTERS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/*
+EventCounter Class
+~~~~~~~~~~~~~~~~~~
+A named count of how often something happens on a hot path (I/O port
+accesses, TLB refills, DOS calls, ...), cheap enough to always be compiled
+in. Modules keep their counters as static objects, which register
+themselves; STATS.COM lists and resets them.
+
+A counter can have a slot per index (the port, the function number), which
+are then listed separately.
+
+Each counter has to be counted up from one thread only. The slots are
+atomics that are only ever loaded and stored with relaxed ordering, so
+counting costs a plain increment and readers on other threads still see
+sane values.
+*/
+
+class EventCounter {
+public:
+	// The name and the slot format, which gets the slot index, have to
+	// outlive the counter (usually they're string literals)
+	EventCounter(const char* name, const size_t num_slots = 1,
+	             const char* slot_format = "%zu");
+	~EventCounter();
+
+	EventCounter(const EventCounter&)            = delete; // prevent copying
+	EventCounter& operator=(const EventCounter&) = delete; // prevent assignment
+
+	void Add(const size_t slot = 0, const uint64_t amount = 1)
+	{
+		auto& count = slots[slot];
+		count.store(count.load(std::memory_order_relaxed) + amount,
+		            std::memory_order_relaxed);
+	}
+
+	const char* GetName() const
+	{
+		return name;
+	}
+
+	const char* GetSlotFormat() const
+	{
+		return slot_format;
+	}
+
+	size_t GetNumSlots() const
+	{
+		return num_slots;
+	}
+
+	uint64_t Get(const size_t slot) const
+	{
+		return slots[slot].load(std::memory_order_relaxed);
+	}
+
+	uint64_t GetTotal() const;
+
+	// Counts that race the reset can survive it
+	void Reset();
+
+private:
+	const char* name        = nullptr;
+	const char* slot_format = nullptr;
+	const size_t num_slots  = 0;
+
+	std::unique_ptr<std::atomic<uint64_t>[]> slots = {};
+};
+
+// All the counters, in the order they were registered
+std::vector<EventCounter*> COUNTERS_GetAll();
+
+void COUNTERS_ResetAll();
+
+#endif
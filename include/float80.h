@@ -0,0 +1,620 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_FLOAT80_H
+#define DOSBOX_FLOAT80_H
+
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Software x87 extended precision arithmetic
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Implements the basic operations on the 80-bit format (a sign bit, a 15-bit
+// exponent with a bias of 16383 and a 64-bit significand with an explicit
+// integer bit) using integer arithmetic only, so the results are identical on
+// every host. Results are correctly rounded to the requested precision (24,
+// 53 or 64 significand bits, as selected by the x87 precision control) using
+// the x87 rounding modes.
+//
+// Exceptions aren't reported: invalid operations return the default NaN,
+// overflows return infinity (or the largest finite value, depending on the
+// rounding mode) and tiny results are rounded to denormals or zero.
+// Unnormals and pseudo-NaNs are treated as invalid operands, as the 387 and
+// later do.
+
+struct Float80 {
+	uint64_t mant     = 0;
+	uint16_t sign_exp = 0;
+
+	constexpr bool operator==(const Float80& other) const
+	{
+		return mant == other.mant && sign_exp == other.sign_exp;
+	}
+};
+
+// Same encoding as the x87 control word's rounding control field
+enum class F80Rounding : uint8_t { Nearest = 0, Down = 1, Up = 2, Chop = 3 };
+
+constexpr int F80Bias         = 16383;
+constexpr int F80MaxExp       = 0x7fff;
+constexpr uint64_t F80IntBit  = UINT64_C(1) << 63;
+constexpr uint64_t F80QuietBit = UINT64_C(1) << 62;
+
+constexpr Float80 F80DefaultNaN = {F80IntBit | F80QuietBit, 0xffff};
+
+namespace float80_detail {
+
+// 128-bit unsigned helper, hosts like MSVC don't have a native type
+struct U128 {
+	uint64_t hi = 0;
+	uint64_t lo = 0;
+};
+
+constexpr bool operator>=(const U128 a, const U128 b)
+{
+	return a.hi != b.hi ? a.hi > b.hi : a.lo >= b.lo;
+}
+
+constexpr U128 operator+(const U128 a, const U128 b)
+{
+	const uint64_t lo = a.lo + b.lo;
+	return {a.hi + b.hi + (lo < a.lo ? 1 : 0), lo};
+}
+
+constexpr U128 operator-(const U128 a, const U128 b)
+{
+	return {a.hi - b.hi - (a.lo < b.lo ? 1 : 0), a.lo - b.lo};
+}
+
+constexpr U128 shift_left(const U128 a, const int n)
+{
+	if (n == 0) {
+		return a;
+	}
+	if (n >= 64) {
+		return {a.lo << (n - 64), 0};
+	}
+	return {(a.hi << n) | (a.lo >> (64 - n)), a.lo << n};
+}
+
+// Shifts right and ORs everything shifted out into the lowest bit
+constexpr U128 shift_right_sticky(const U128 a, const int n)
+{
+	if (n == 0) {
+		return a;
+	}
+	if (n >= 128) {
+		return {0, (a.hi | a.lo) ? 1u : 0u};
+	}
+	if (n >= 64) {
+		const auto lost = (n == 64) ? a.lo
+		                            : (a.lo | (a.hi << (128 - n)));
+		const auto lo   = (n == 64) ? a.hi : (a.hi >> (n - 64));
+		return {0, lo | (lost ? 1 : 0)};
+	}
+	const auto lost = a.lo << (64 - n);
+	return {a.hi >> n, (a.lo >> n) | (a.hi << (64 - n)) | (lost ? 1 : 0)};
+}
+
+constexpr int leading_zeros(const uint64_t val)
+{
+	return std::countl_zero(val);
+}
+
+constexpr U128 mul_64x64(const uint64_t a, const uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+	const auto product = static_cast<unsigned __int128>(a) * b;
+	return {static_cast<uint64_t>(product >> 64), static_cast<uint64_t>(product)};
+#else
+	const uint64_t a_lo = a & 0xffffffff;
+	const uint64_t a_hi = a >> 32;
+	const uint64_t b_lo = b & 0xffffffff;
+	const uint64_t b_hi = b >> 32;
+
+	const uint64_t lo_lo = a_lo * b_lo;
+	const uint64_t hi_lo = a_hi * b_lo;
+	const uint64_t lo_hi = a_lo * b_hi;
+	const uint64_t hi_hi = a_hi * b_hi;
+
+	const uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi;
+	return {hi_hi + (hi_lo >> 32) + (cross >> 32),
+	        (cross << 32) | (lo_lo & 0xffffffff)};
+#endif
+}
+
+// Divides hi:lo by the divisor, the quotient has to fit into 64 bits
+// (hi < divisor)
+constexpr uint64_t div_128x64(const U128 num, const uint64_t divisor,
+                              uint64_t& remainder)
+{
+#if defined(__SIZEOF_INT128__)
+	const auto n = (static_cast<unsigned __int128>(num.hi) << 64) | num.lo;
+	remainder    = static_cast<uint64_t>(n % divisor);
+	return static_cast<uint64_t>(n / divisor);
+#else
+	uint64_t rem      = num.hi;
+	uint64_t quotient = 0;
+	for (int i = 63; i >= 0; --i) {
+		const bool carry = (rem >> 63) != 0;
+		rem = (rem << 1) | ((num.lo >> i) & 1);
+		quotient <<= 1;
+		if (carry || rem >= divisor) {
+			rem -= divisor;
+			quotient |= 1;
+		}
+	}
+	remainder = rem;
+	return quotient;
+#endif
+}
+
+struct Unpacked {
+	bool sign    = false;
+	int32_t exp  = 0; // biased, can be out of range for denormals
+	uint64_t sig = 0; // normalized, bit 63 set unless zero
+};
+
+enum class Kind : uint8_t { Zero, Normal, Inf, NaN };
+
+constexpr Kind unpack(const Float80 f, Unpacked& u)
+{
+	u.sign = (f.sign_exp & 0x8000) != 0;
+	u.exp  = f.sign_exp & F80MaxExp;
+	u.sig  = f.mant;
+
+	if (u.exp == F80MaxExp) {
+		if ((u.sig & ~F80IntBit) == 0 && (u.sig & F80IntBit)) {
+			return Kind::Inf;
+		}
+		return Kind::NaN;
+	}
+	if (u.exp == 0) {
+		if (u.sig == 0) {
+			return Kind::Zero;
+		}
+		// denormal (or pseudo-denormal), normalize it
+		const auto shift = leading_zeros(u.sig);
+		u.sig <<= shift;
+		u.exp = 1 - shift;
+		return Kind::Normal;
+	}
+	if (!(u.sig & F80IntBit)) {
+		return Kind::NaN; // unnormal
+	}
+	return Kind::Normal;
+}
+
+constexpr Float80 make(const bool sign, const int32_t exp, const uint64_t mant)
+{
+	return {mant, static_cast<uint16_t>((sign ? 0x8000 : 0) | exp)};
+}
+
+constexpr Float80 make_inf(const bool sign)
+{
+	return make(sign, F80MaxExp, F80IntBit);
+}
+
+constexpr Float80 make_zero(const bool sign)
+{
+	return make(sign, 0, 0);
+}
+
+// Returns a NaN operand quieted, or the default NaN for unnormals
+constexpr Float80 propagate_nan(const Float80 a)
+{
+	Unpacked u = {};
+	if (unpack(a, u) == Kind::NaN && (a.sign_exp & F80MaxExp) == F80MaxExp &&
+	    (a.mant & F80IntBit)) {
+		return {a.mant | F80QuietBit, a.sign_exp};
+	}
+	return F80DefaultNaN;
+}
+
+constexpr Float80 propagate_nan(const Float80 a, const Float80 b)
+{
+	Unpacked u = {};
+	return unpack(a, u) == Kind::NaN ? propagate_nan(a) : propagate_nan(b);
+}
+
+// Rounds the significand (sig with the bits below it in extra) to the given
+// number of bits and packs the result. The integer bit of sig must be set.
+constexpr Float80 round_pack(const bool sign, int32_t exp, uint64_t sig,
+                             uint64_t extra, const int precision,
+                             const F80Rounding rounding)
+{
+	if (exp <= 0) {
+		// denormal result, the exponent stays at the minimum
+		const auto shifted = shift_right_sticky({sig, extra}, 1 - exp);
+		sig   = shifted.hi;
+		extra = shifted.lo;
+		exp   = 0;
+	}
+
+	const int drop_bits = 64 - precision;
+
+	// Compare the discarded part against one half
+	bool above_half = false;
+	bool exact_half = false;
+	bool inexact    = false;
+	uint64_t unit   = 1;
+	if (drop_bits == 0) {
+		above_half = extra > F80IntBit;
+		exact_half = extra == F80IntBit;
+		inexact    = extra != 0;
+	} else {
+		unit              = UINT64_C(1) << drop_bits;
+		const auto half   = unit >> 1;
+		const auto dropped = sig & (unit - 1);
+		above_half = dropped > half || (dropped == half && extra);
+		exact_half = dropped == half && !extra;
+		inexact    = dropped || extra;
+		sig &= ~(unit - 1);
+	}
+
+	bool round_up = false;
+	switch (rounding) {
+	case F80Rounding::Nearest:
+		round_up = above_half || (exact_half && (sig & unit));
+		break;
+	case F80Rounding::Down: round_up = inexact && sign; break;
+	case F80Rounding::Up: round_up = inexact && !sign; break;
+	case F80Rounding::Chop: break;
+	}
+
+	if (round_up) {
+		const auto before = sig;
+		sig += unit;
+		if (sig < before) {
+			// carried out of the significand
+			sig = F80IntBit;
+			++exp;
+		} else if (exp == 0 && (sig & F80IntBit)) {
+			// a denormal rounded up to the smallest normal
+			exp = 1;
+		}
+	}
+
+	if (exp >= F80MaxExp) {
+		const bool to_inf = rounding == F80Rounding::Nearest ||
+		                    (rounding == F80Rounding::Up && !sign) ||
+		                    (rounding == F80Rounding::Down && sign);
+		if (to_inf) {
+			return make_inf(sign);
+		}
+		const auto max_sig = ~UINT64_C(0) << drop_bits;
+		return make(sign, F80MaxExp - 1, max_sig);
+	}
+	if (sig == 0) {
+		return make_zero(sign);
+	}
+	return make(sign, exp, sig);
+}
+
+// Normalizes a 128-bit significand and rounds it
+constexpr Float80 normalize_round_pack(const bool sign, int32_t exp, U128 sig,
+                                       const int precision,
+                                       const F80Rounding rounding)
+{
+	if (sig.hi == 0 && sig.lo == 0) {
+		return make_zero(sign);
+	}
+	const auto shift = sig.hi ? leading_zeros(sig.hi)
+	                          : 64 + leading_zeros(sig.lo);
+	sig = shift_left(sig, shift);
+	exp -= shift;
+	return round_pack(sign, exp, sig.hi, sig.lo, precision, rounding);
+}
+
+constexpr Float80 add_magnitudes(const bool sign, const Unpacked& a,
+                                 const Unpacked& b, const int precision,
+                                 const F80Rounding rounding)
+{
+	// a has the larger exponent
+	const auto b_sig = shift_right_sticky({b.sig, 0}, a.exp - b.exp);
+	auto sum         = U128{a.sig, 0} + b_sig;
+	auto exp         = a.exp;
+	if (sum.hi < a.sig) {
+		// carry out of bit 127
+		sum    = shift_right_sticky(sum, 1);
+		sum.hi |= F80IntBit;
+		++exp;
+	}
+	return round_pack(sign, exp, sum.hi, sum.lo, precision, rounding);
+}
+
+constexpr Float80 sub_magnitudes(const bool sign, const Unpacked& a,
+                                 const Unpacked& b, const int precision,
+                                 const F80Rounding rounding)
+{
+	// a has the larger magnitude
+	const auto b_sig = shift_right_sticky({b.sig, 0}, a.exp - b.exp);
+	const auto diff  = U128{a.sig, 0} - b_sig;
+	if (diff.hi == 0 && diff.lo == 0) {
+		// exact zero is positive, except when rounding down
+		return make_zero(rounding == F80Rounding::Down);
+	}
+	return normalize_round_pack(sign, a.exp, diff, precision, rounding);
+}
+
+constexpr Float80 add(const Float80 x, const Float80 y, const bool negate_y,
+                      const int precision, const F80Rounding rounding)
+{
+	Unpacked a     = {};
+	Unpacked b     = {};
+	const auto k_a = unpack(x, a);
+	const auto k_b = unpack(y, b);
+	b.sign ^= negate_y;
+
+	if (k_a == Kind::NaN || k_b == Kind::NaN) {
+		return propagate_nan(x, y);
+	}
+	if (k_a == Kind::Inf || k_b == Kind::Inf) {
+		if (k_a == Kind::Inf && k_b == Kind::Inf && a.sign != b.sign) {
+			return F80DefaultNaN;
+		}
+		return make_inf(k_a == Kind::Inf ? a.sign : b.sign);
+	}
+	if (k_a == Kind::Zero && k_b == Kind::Zero) {
+		if (a.sign == b.sign) {
+			return make_zero(a.sign);
+		}
+		return make_zero(rounding == F80Rounding::Down);
+	}
+	if (k_a == Kind::Zero) {
+		return round_pack(b.sign, b.exp, b.sig, 0, precision, rounding);
+	}
+	if (k_b == Kind::Zero) {
+		return round_pack(a.sign, a.exp, a.sig, 0, precision, rounding);
+	}
+
+	const bool a_larger = a.exp != b.exp ? a.exp > b.exp : a.sig >= b.sig;
+	const auto& big     = a_larger ? a : b;
+	const auto& small   = a_larger ? b : a;
+	if (a.sign == b.sign) {
+		return add_magnitudes(a.sign, big, small, precision, rounding);
+	}
+	return sub_magnitudes(big.sign, big, small, precision, rounding);
+}
+
+} // namespace float80_detail
+
+constexpr Float80 f80_add(const Float80 a, const Float80 b, const int precision = 64,
+                          const F80Rounding rounding = F80Rounding::Nearest)
+{
+	return float80_detail::add(a, b, false, precision, rounding);
+}
+
+constexpr Float80 f80_sub(const Float80 a, const Float80 b, const int precision = 64,
+                          const F80Rounding rounding = F80Rounding::Nearest)
+{
+	return float80_detail::add(a, b, true, precision, rounding);
+}
+
+constexpr Float80 f80_mul(const Float80 x, const Float80 y, const int precision = 64,
+                          const F80Rounding rounding = F80Rounding::Nearest)
+{
+	using namespace float80_detail;
+	Unpacked a     = {};
+	Unpacked b     = {};
+	const auto k_a = unpack(x, a);
+	const auto k_b = unpack(y, b);
+	const bool sign = a.sign != b.sign;
+
+	if (k_a == Kind::NaN || k_b == Kind::NaN) {
+		return propagate_nan(x, y);
+	}
+	if (k_a == Kind::Inf || k_b == Kind::Inf) {
+		if (k_a == Kind::Zero || k_b == Kind::Zero) {
+			return F80DefaultNaN;
+		}
+		return make_inf(sign);
+	}
+	if (k_a == Kind::Zero || k_b == Kind::Zero) {
+		return make_zero(sign);
+	}
+
+	auto product = mul_64x64(a.sig, b.sig);
+	auto exp     = a.exp + b.exp - F80Bias + 1;
+	if (!(product.hi & F80IntBit)) {
+		product = shift_left(product, 1);
+		--exp;
+	}
+	return round_pack(sign, exp, product.hi, product.lo, precision, rounding);
+}
+
+constexpr Float80 f80_div(const Float80 x, const Float80 y, const int precision = 64,
+                          const F80Rounding rounding = F80Rounding::Nearest)
+{
+	using namespace float80_detail;
+	Unpacked a     = {};
+	Unpacked b     = {};
+	const auto k_a = unpack(x, a);
+	const auto k_b = unpack(y, b);
+	const bool sign = a.sign != b.sign;
+
+	if (k_a == Kind::NaN || k_b == Kind::NaN) {
+		return propagate_nan(x, y);
+	}
+	if (k_a == Kind::Inf) {
+		return k_b == Kind::Inf ? F80DefaultNaN : make_inf(sign);
+	}
+	if (k_b == Kind::Inf) {
+		return make_zero(sign);
+	}
+	if (k_b == Kind::Zero) {
+		return k_a == Kind::Zero ? F80DefaultNaN : make_inf(sign);
+	}
+	if (k_a == Kind::Zero) {
+		return make_zero(sign);
+	}
+
+	// Scale the dividend so the quotient has its integer bit at bit 63
+	auto exp = a.exp - b.exp + F80Bias;
+	U128 num = {a.sig >> 1, a.sig << 63};
+	if (a.sig < b.sig) {
+		num = {a.sig, 0};
+		--exp;
+	}
+	uint64_t rem      = 0;
+	const auto q_high = div_128x64(num, b.sig, rem);
+
+	// One more quotient word for rounding, the remainder makes it sticky
+	uint64_t rem_low  = 0;
+	const auto q_low  = div_128x64({rem, 0}, b.sig, rem_low);
+	const auto extra  = q_low | (rem_low ? 1 : 0);
+	return round_pack(sign, exp, q_high, extra, precision, rounding);
+}
+
+inline Float80 f80_sqrt(const Float80 x, const int precision = 64,
+                        const F80Rounding rounding = F80Rounding::Nearest)
+{
+	using namespace float80_detail;
+	Unpacked a   = {};
+	const auto k = unpack(x, a);
+
+	if (k == Kind::NaN) {
+		return propagate_nan(x);
+	}
+	if (k == Kind::Zero) {
+		return x; // keeps the sign
+	}
+	if (a.sign) {
+		return F80DefaultNaN;
+	}
+	if (k == Kind::Inf) {
+		return x;
+	}
+
+	// With an even unbiased exponent the root of sig * 2^63 has its
+	// integer bit at bit 63, with an odd one that of sig * 2^64
+	const auto unbiased = a.exp - F80Bias;
+	const bool odd      = (unbiased & 1) != 0;
+	const U128 radicand = odd ? U128{a.sig, 0} : U128{a.sig >> 1, a.sig << 63};
+	const auto exp = (odd ? unbiased - 1 : unbiased) / 2 + F80Bias;
+
+	// The host's double square root is good for 53 bits, one Newton step
+	// brings that to within one of the integer root
+	constexpr double TwoPow64 = 18446744073709551616.0;
+	const auto estimate = std::sqrt(static_cast<double>(radicand.hi) * TwoPow64 +
+	                                static_cast<double>(radicand.lo));
+	auto sig = estimate >= TwoPow64 ? UINT64_MAX
+	                                : static_cast<uint64_t>(estimate);
+	if (radicand.hi < sig) {
+		uint64_t unused = 0;
+		const auto quot = div_128x64(radicand, sig, unused);
+		sig = (sig >> 1) + (quot >> 1) + (sig & quot & 1);
+	} else {
+		sig = UINT64_MAX;
+	}
+
+	// Correct the root, so that root^2 <= radicand < (root + 1)^2
+	while (!(radicand >= mul_64x64(sig, sig))) {
+		--sig;
+	}
+	while (sig != UINT64_MAX && radicand >= mul_64x64(sig + 1, sig + 1)) {
+		++sig;
+	}
+	const auto rem = radicand - mul_64x64(sig, sig);
+
+	// The root is never exactly halfway, so the remainder tells whether
+	// the discarded part is above one half and whether it's inexact
+	uint64_t extra = 0;
+	if (rem.hi || rem.lo) {
+		extra = (rem.hi || rem.lo > sig) ? (F80IntBit | 1) : 1;
+	}
+	return round_pack(false, exp, sig, extra, precision, rounding);
+}
+
+// Exact, every double is representable
+inline Float80 f80_from_double(const double d)
+{
+	uint64_t bits = 0;
+	std::memcpy(&bits, &d, sizeof(bits));
+
+	const bool sign = (bits >> 63) != 0;
+	const auto exp  = static_cast<int32_t>((bits >> 52) & 0x7ff);
+	const auto frac = bits & ((UINT64_C(1) << 52) - 1);
+
+	using namespace float80_detail;
+	if (exp == 0x7ff) {
+		return frac ? make(sign, F80MaxExp, F80IntBit | (frac << 11))
+		            : make_inf(sign);
+	}
+	if (exp == 0) {
+		if (frac == 0) {
+			return make_zero(sign);
+		}
+		const auto shift = leading_zeros(frac);
+		return make(sign, 1 - 1023 + F80Bias - (shift - 11), frac << shift);
+	}
+	return make(sign, exp - 1023 + F80Bias, F80IntBit | (frac << 11));
+}
+
+// Rounds to the nearest double
+inline double f80_to_double(const Float80 f)
+{
+	using namespace float80_detail;
+	Unpacked u   = {};
+	const auto k = unpack(f, u);
+	switch (k) {
+	case Kind::Zero: return u.sign ? -0.0 : 0.0;
+	case Kind::Inf: return u.sign ? -HUGE_VAL : HUGE_VAL;
+	case Kind::NaN: {
+		const auto payload = (f.sign_exp & F80MaxExp) == F80MaxExp
+		                           ? (f.mant & ~F80IntBit) >> 11
+		                           : 0;
+		const uint64_t bits = (u.sign ? F80IntBit : 0) |
+		                      (UINT64_C(0x7ff) << 52) |
+		                      (UINT64_C(1) << 51) | payload;
+		double d = 0;
+		std::memcpy(&d, &bits, sizeof(d));
+		return d;
+	}
+	case Kind::Normal: break;
+	}
+
+	// Round to the precision of the double at this magnitude first, so the
+	// conversion below is exact
+	const auto unbiased = u.exp - F80Bias;
+	auto precision      = 53;
+	if (unbiased < -1022) {
+		precision = 53 - (-1022 - unbiased);
+		if (precision < 1) {
+			// below half the smallest denormal, or just above it
+			const bool above = precision == 0 && (u.sig != F80IntBit);
+			const auto tiny  = above ? std::ldexp(1.0, -1074) : 0.0;
+			return u.sign ? -tiny : tiny;
+		}
+	}
+	const auto rounded = round_pack(u.sign, u.exp, u.sig, 0, precision,
+	                                F80Rounding::Nearest);
+	Unpacked r = {};
+	if (unpack(rounded, r) == Kind::Inf) {
+		return u.sign ? -HUGE_VAL : HUGE_VAL;
+	}
+	const auto value = std::ldexp(static_cast<double>(r.sig >> 11),
+	                              r.exp - F80Bias - 52);
+	return u.sign ? -value : value;
+}
+
+#endif
@@ -31,6 +31,10 @@
 
 #include "mmx.h"
 
+#if !C_FPU_X86
+#include "float80.h"
+#endif
+
 void FPU_ESC0_Normal(Bitu rm);
 void FPU_ESC0_EA(Bitu func,PhysPt ea);
 void FPU_ESC1_Normal(Bitu rm);
@@ -91,6 +95,14 @@ struct FPU_rec {
 #if !C_FPU_X86
 	int64_t regs_memcpy[9]  = {}; // for FILD/FIST 64-bit memcpy fix
 	bool use_regs_memcpy[9] = {};
+
+	// Exact 80-bit values of the registers, only used with the extended
+	// precision fast path. A shadow is only valid while the register
+	// still holds the double it was rounded to (regs_80_ll[i] ==
+	// regs[i].ll), so any write that bypasses it simply invalidates it.
+	Float80 regs_80[9]      = {};
+	int64_t regs_80_ll[9]   = {};
+	bool extended_precision = false;
 #endif
 	FPU_P_Reg p_regs[9]     = {};
 	MMX_reg mmx_regs[8]     = {};
@@ -0,0 +1,57 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_GUEST_PROFILER_H
+#define DOSBOX_GUEST_PROFILER_H
+
+#include <cstdint>
+
+/*
+Guest Profiler
+~~~~~~~~~~~~~~
+Samples the address the guest executes at every given number of emulated
+cycles, to find the code that takes the emulation's time. The samples are
+counted per address and written to the capture directory in the folded
+stack format that flame graph tools read (flamegraph.pl, inferno,
+speedscope): a line per address with its frames separated by semicolons,
+followed by the number of samples.
+
+Real and virtual 8086 mode addresses within a program loaded by DOS are
+written as the program's name, then the segment relative to its load
+segment, as in the linker's map files, then the offset. Protected mode
+code is written by selector and offset, as the DOS extenders that load the
+NE and LE executables keep their segment maps to themselves.
+*/
+
+constexpr int DefaultProfilerInterval = 5000;
+
+void PROFILER_Start(int interval_cycles);
+
+// Stops sampling and writes the profile
+void PROFILER_Stop();
+
+bool PROFILER_IsRunning();
+int PROFILER_GetInterval();
+int64_t PROFILER_GetNumSamples();
+
+// Called when DOS loads a program or an overlay, the size being in bytes
+void PROFILER_AddProgram(const char* name, uint16_t load_seg, uint32_t size);
+
+#endif
@@ -0,0 +1,44 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_HOST_MEMORY_H
+#define DOSBOX_HOST_MEMORY_H
+
+#include <cstddef>
+#include <optional>
+
+// Records how many bytes of host memory a subsystem has allocated for the
+// emulated machine, replacing its previous amount. The subsystem name has
+// to outlive the program (usually it's a string literal).
+void HOSTMEM_SetUsage(const char* subsystem, const size_t num_bytes);
+
+// Adds to or subtracts from the subsystem's amount
+void HOSTMEM_AddUsage(const char* subsystem, const ptrdiff_t num_bytes);
+
+// The process' resident memory as reported by the host, if it can tell
+std::optional<size_t> HOSTMEM_GetResidentBytes();
+
+// The most resident memory the process has had so far, if the host can tell
+std::optional<size_t> HOSTMEM_GetPeakResidentBytes();
+
+// Logs the recorded amounts and the process' resident memory
+void HOSTMEM_LogUsage();
+
+#endif // DOSBOX_HOST_MEMORY_H
@@ -72,6 +72,26 @@ void IO_FreeWriteHandler(io_port_t port,
                          io_width_t max_width,
                          io_port_t range = 1);
 
+// Devices with a data port that streams a buffer, like the IDE data
+// register, can serve REP INS and OUTS a run of elements at a time. The
+// handlers copy up to num elements of the given width from or to the
+// host buffer in port order, and return how many they did. Returning 0
+// makes the caller do the next element through the regular handlers.
+using io_block_read_f = std::function<size_t(io_port_t port, io_width_t width,
+                                             uint8_t* data, size_t num)>;
+using io_block_write_f = std::function<size_t(io_port_t port, io_width_t width,
+                                              const uint8_t* data, size_t num)>;
+
+void IO_RegisterBlockHandlers(io_port_t port, io_block_read_f read_handler,
+                              io_block_write_f write_handler);
+
+void IO_FreeBlockHandlers(io_port_t port);
+
+size_t IO_ReadBlock(io_port_t port, io_width_t width, uint8_t* data,
+                    size_t num);
+size_t IO_WriteBlock(io_port_t port, io_width_t width, const uint8_t* data,
+                     size_t num);
+
 /* Classes to manage the IO objects created by the various devices.
  * The io objects will remove itself on destruction.*/
 class IO_Base{
@@ -108,6 +108,7 @@ class ECBClass {
 public:
 	RealPt ECBAddr;
 	bool isInESRList;
+	bool isListening;	// Indexed by socket in the listening ECBs
    	ECBClass *prevECB;	// Linked List
 	ECBClass *nextECB;
 	
@@ -131,6 +132,9 @@ public:
 
 	void setInUseFlag(uint8_t flagval);
 
+	// Takes the ECB out of the listening ECBs of its socket
+	void stopListening();
+
 	void setCompletionFlag(uint8_t flagval);
 
 	uint16_t getFragCount(void);
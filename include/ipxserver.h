@@ -21,8 +21,13 @@
 
 #if C_IPX
 
+#include <atomic>
+#include <cstdint>
+
 #include <SDL_net.h>
 
+#include "enet/include/enet.h"
+
 struct packetBuffer {
 	uint8_t buffer[1024];
 	int16_t packetSize;  // Packet size remaining in read
@@ -32,14 +37,43 @@ struct packetBuffer {
 	bool waitsize;
 };
 
-#define SOCKETTABLESIZE 16
+// Traffic the server saw from and sent to a client, kept up to date by
+// the server thread
+struct IPXClientStats {
+	std::atomic<uint64_t> packets_in  = 0;
+	std::atomic<uint64_t> bytes_in    = 0;
+	std::atomic<uint64_t> packets_out = 0;
+	std::atomic<uint64_t> bytes_out   = 0;
+
+	void Reset()
+	{
+		packets_in  = 0;
+		bytes_in    = 0;
+		packets_out = 0;
+		bytes_out   = 0;
+	}
+};
+
+#define SOCKETTABLESIZE 64
 #define CONVIP(hostvar) hostvar & 0xff, (hostvar >> 8) & 0xff, (hostvar >> 16) & 0xff, (hostvar >> 24) & 0xff
 #define CONVIPX(hostvar) hostvar[0], hostvar[1], hostvar[2], hostvar[3], hostvar[4], hostvar[5]
 
 
+// The ENet tunnel's channels: registrations and pings go reliably, the
+// guest's packets unreliably but in order, so late ones are dropped
+// instead of holding up the newer ones
+constexpr uint8_t IPX_EnetControlChannel = 0;
+constexpr uint8_t IPX_EnetDataChannel    = 1;
+constexpr size_t IPX_EnetNumChannels     = 2;
+
+// Queues the IPX packet on the channel its kind belongs to; it's sent
+// with the next service or flush of the host
+bool IPX_EnetSend(ENetPeer* peer, const uint8_t* data, int len);
+
 void IPX_StopServer();
-bool IPX_StartServer(uint16_t portnum);
+bool IPX_StartServer(uint16_t portnum, bool use_enet);
 bool IPX_isConnectedToServer(Bits tableNum, IPaddress ** ptrAddr);
+const IPXClientStats& IPX_GetServerClientStats(Bits tableNum);
 
 uint8_t packetCRC(uint8_t *buffer, uint16_t bufSize);
 
@@ -166,6 +166,21 @@ static inline uint64_t phys_readq(PhysPt addr)
 void MEM_BlockWrite(PhysPt pt, const void *data, size_t size);
 void MEM_BlockRead(PhysPt pt, void *data, Bitu size);
 void MEM_BlockCopy(PhysPt dest, PhysPt src, Bitu size);
+
+// Like memmove, the destination ends up with the bytes the source had, also
+// when the two overlap
+void MEM_BlockMove(PhysPt dest, PhysPt src, size_t size);
+
+// Host memory that the start of a guest range can be written through
+// directly, i.e. where it is plain RAM with a write pointer in the TLB. Spans
+// over as many following pages as stay contiguous on the host. Without a
+// host pointer, num_bytes covers the part of the first page that has to go
+// through its page handler.
+struct MemHostSpan {
+	uint8_t* data    = nullptr;
+	size_t num_bytes = 0;
+};
+MemHostSpan MEM_GetWritableSpan(PhysPt pt, size_t size);
 void MEM_StrCopy(PhysPt pt, char *data, Bitu size);
 
 void mem_memcpy(PhysPt dest, PhysPt src, Bitu size);
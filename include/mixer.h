@@ -35,6 +35,7 @@
 #include <vector>
 
 #include "../src/hardware/compressor.h"
+#include "../src/hardware/polyphase_resampler.h"
 #include "audio_frame.h"
 #include "envelope.h"
 
@@ -146,10 +147,12 @@ enum class ResampleMethod {
 	// faithfully emulates the metallic, crunchy sound of old DACs.
 	ZeroOrderHoldAndResample,
 
-	// Resample from the channel sample rate to the mixer rate with Speex.
-	// This is mathematically correct, high-quality resampling that cuts all
-	// frequencies below the Nyquist frequency using a brickwall filter
-	// (everything below half the channel's sample rate is cut).
+	// Resample from the channel sample rate to the mixer rate with Speex,
+	// or with the built-in polyphase resampler if the 'resampler' setting
+	// asks for it. This is mathematically correct, high-quality resampling
+	// that cuts all frequencies below the Nyquist frequency using a
+	// brickwall filter (everything below half the channel's sample rate is
+	// cut).
 	Resample
 };
 
@@ -169,6 +172,26 @@ constexpr auto DefaultChorusPreset = ChorusPreset::Normal;
 struct SpeexResamplerState_;
 typedef SpeexResamplerState_ SpeexResamplerState;
 
+// Host time a channel took and the frames it delivered since its stats were
+// last taken
+struct MixerChannelStats {
+	// Time spent in the device's handler, not counting the time the mixer
+	// spent on the frames the handler added
+	int64_t device_ns = 0;
+	// Time spent converting and resampling the device's frames
+	int64_t resample_ns = 0;
+	// Time spent filtering the frames and mixing them into the output
+	int64_t filter_ns = 0;
+
+	int64_t frames_requested = 0;
+	int64_t frames_delivered = 0;
+
+	// Only reported by devices that render ahead on their own thread:
+	// the current depth of their queue and the underruns since last taken
+	int render_ahead_frames  = 0;
+	int64_t render_underruns = 0;
+};
+
 class MixerChannel {
 public:
 	MixerChannel(MIXER_Handler _handler, const char* name,
@@ -255,6 +278,13 @@ public:
 	// Pass-through to the sleeper
 	bool WakeUp();
 
+	// Returns the stats accumulated since the last call and restarts them
+	MixerChannelStats TakeStats();
+
+	// Lets devices that render ahead on their own thread report how many
+	// frames they keep queued and whether the mixer had to wait for them
+	void ReportRenderAhead(const int depth_frames, const bool had_underrun);
+
 	// Timing on how many sample frames have been done by the mixer
 	std::atomic<int> frames_done = 0;
 
@@ -272,6 +302,10 @@ private:
 	void ConvertSamples(const Type* data, const uint16_t frames,
 	                    std::vector<float>& out);
 
+	template <class Type, bool stereo>
+	void ConvertSamplesInBulk(const Type* data, const uint16_t frames,
+	                          std::vector<float>& out);
+
 	void ConfigureResampler();
 	void ClearResampler();
 	void InitZohUpsamplerState();
@@ -280,6 +314,9 @@ private:
 	AudioFrame ApplyCrossfeed(const AudioFrame frame) const;
 
 	std::string name = {};
+	// Tracy keeps the pointer to the plot name, so it lives as long as
+	// the channel
+	std::string plot_name = {};
 	Envelope envelope;
 	MIXER_Handler handler = nullptr;
 
@@ -294,6 +331,17 @@ private:
 	// Timing on how many samples were needed by the mixer
 	int frames_needed = 0u;
 
+	// Updated by the emulation and device threads, taken by MIXER /STATS
+	struct {
+		std::atomic<int64_t> device_ns        = 0;
+		std::atomic<int64_t> resample_ns      = 0;
+		std::atomic<int64_t> filter_ns        = 0;
+		std::atomic<int64_t> frames_requested = 0;
+		std::atomic<int64_t> frames_delivered = 0;
+		std::atomic<int> render_ahead_frames  = 0;
+		std::atomic<int64_t> render_underruns = 0;
+	} stats = {};
+
 	// Previous and next sample fames
 	AudioFrame prev_frame = {};
 	AudioFrame next_frame = {};
@@ -367,6 +415,9 @@ private:
 		SpeexResamplerState* state = nullptr;
 	} speex_resampler = {};
 
+	// Replaces Speex when the polyphase resampler is selected
+	std::unique_ptr<PolyphaseResampler> polyphase_resampler = {};
+
 	struct {
 		struct {
 			std::array<Iir::Butterworth::HighPass<max_filter_order>, 2> hpf = {};
@@ -456,9 +507,43 @@ void MIXER_SetMasterVolume(const AudioFrame volume);
 void MIXER_Mute();
 void MIXER_Unmute();
 
+// Guards the channels and the mixer's work buffers; the audio device
+// callback only reads the finished frames and never takes this lock
 void MIXER_LockAudioDevice();
 void MIXER_UnlockAudioDevice();
 
+// Mixes the frames up to the current position within the tick, so they
+// reach the audio device before the tick completes
+void MIXER_MixPartialTick();
+
+// Audio buffer levels seen by the audio device since the last call
+struct MixerBufferStats {
+	// Lowest fill level, 1.0 being the prebuffer on top of the request
+	float min_fill = 1.0f;
+	// Number of requests that couldn't be served from the buffer
+	int underruns = 0;
+	// Number of times mixed frames were dropped because the audio device
+	// stopped pulling them
+	int overruns = 0;
+};
+MixerBufferStats MIXER_TakeBufferStats();
+
+// Host time the mixer itself took since the stats were last taken; unlike
+// the buffer stats above these are only taken by MIXER /STATS
+struct MixerStats {
+	int64_t elapsed_ns = 0;
+	// Time spent in the master effects chain
+	int64_t effects_ns = 0;
+	// Time spent in the audio device callback
+	int64_t callback_ns = 0;
+
+	int64_t frames_mixed   = 0;
+	int64_t frames_played  = 0;
+	int underruns = 0;
+	int overruns  = 0;
+};
+MixerStats MIXER_TakeStats();
+
 // Return true if the mixer was explicitly muted by the user (as opposed to
 // auto-muted when `mute_when_inactive` is enabled)
 bool MIXER_IsManuallyMuted();
@@ -196,6 +196,14 @@ struct bx_ne2k_t {
 	uint8_t base_irq = 0;
 	int tx_timer_index = 0;
 	int tx_timer_active = 0;
+
+	// Receive interrupts are raised once per burst of frames, and at most
+	// once per coalescing window (0 raises them right away)
+	double rx_irq_window_ms = 0.0;
+	double last_rx_irq_ms = 0.0;
+	bool rx_burst = false;
+	bool rx_irq_pending = false;
+	bool rx_irq_scheduled = false;
 };
 
 class bx_ne2k_c  {
@@ -235,6 +243,9 @@ public:
   //static void rx_handler(void *arg, const void *buf, unsigned len);
   BX_NE2K_SMF unsigned mcast_index(const void *dst);
   BX_NE2K_SMF int rx_frame(const void *buf, unsigned bytes);
+  BX_NE2K_SMF void begin_rx_burst();
+  BX_NE2K_SMF void end_rx_burst();
+  BX_NE2K_SMF void raise_rx_irq();
 
   static uint32_t read_handler(void *this_ptr, io_port_t address, io_width_t io_len);
   static void   write_handler(void *this_ptr, io_port_t address, io_val_t value, io_width_t io_len);
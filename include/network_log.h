@@ -0,0 +1,130 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_NETWORK_LOG_H
+#define DOSBOX_NETWORK_LOG_H
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+Network Logs
+~~~~~~~~~~~~
+A compact binary log of every packet an emulated network device handed to
+the guest or got from it, stamped with the emulated time since the log was
+started. Replaying the packets received at the same emulated times lets
+network-bound titles run without any network, which is what regression
+tests and offline benchmarks need.
+
+The file starts with a header:
+  8 bytes  "DBNETLOG"
+  1 byte   format version
+  1 byte   the device kind (NetworkLogSource)
+  6 bytes  the guest's address: the MAC for Ethernet, the node for IPX
+
+Then, per packet, all little-endian:
+  8 bytes  emulated time in microseconds
+  1 byte   direction (NetworkLogDirection)
+  2 bytes  length
+  n bytes  the packet
+*/
+
+enum class NetworkLogSource : uint8_t { Ethernet = 1, Ipx = 2 };
+
+enum class NetworkLogDirection : uint8_t { ToGuest = 0, FromGuest = 1 };
+
+using NetworkLogAddress = std::array<uint8_t, 6>;
+
+class NetworkLogWriter {
+public:
+	// Starts a new log at the path; returns nullptr when it can't be written
+	static std::unique_ptr<NetworkLogWriter> Create(const std::string& path,
+	                                                NetworkLogSource source,
+	                                                const NetworkLogAddress& address);
+
+	NetworkLogWriter(const NetworkLogWriter&)            = delete; // prevent copying
+	NetworkLogWriter& operator=(const NetworkLogWriter&) = delete; // prevent assignment
+
+	~NetworkLogWriter();
+
+	// Stamps the packet with the current emulated time
+	void Write(NetworkLogDirection direction, const uint8_t* data, int len);
+
+private:
+	NetworkLogWriter(FILE* file);
+
+	FILE* file       = nullptr;
+	double start_ms  = 0.0;
+};
+
+struct NetworkLogRecord {
+	int64_t time_us               = 0;
+	NetworkLogDirection direction = NetworkLogDirection::ToGuest;
+	std::vector<uint8_t> data     = {};
+};
+
+class NetworkLogReader {
+public:
+	// Opens a log made for the given kind of device; returns nullptr when
+	// it can't be read or was made for another device
+	static std::unique_ptr<NetworkLogReader> Open(const std::string& path,
+	                                              NetworkLogSource source);
+
+	NetworkLogReader(const NetworkLogReader&)            = delete; // prevent copying
+	NetworkLogReader& operator=(const NetworkLogReader&) = delete; // prevent assignment
+
+	~NetworkLogReader();
+
+	const NetworkLogAddress& GetAddress() const
+	{
+		return address;
+	}
+
+	// Emulated time since the replay started, on the log's time scale
+	int64_t GetElapsedUs() const;
+
+	// The next packet, if its time has come; false when there's none
+	// due yet or the log ended
+	bool NextDue(NetworkLogRecord& record);
+
+	bool IsAtEnd() const
+	{
+		return at_end;
+	}
+
+private:
+	NetworkLogReader(FILE* file, const NetworkLogAddress& address);
+
+	bool ReadNext();
+
+	FILE* file                = nullptr;
+	NetworkLogAddress address = {};
+	double start_ms           = 0.0;
+
+	NetworkLogRecord next = {};
+	bool has_next         = false;
+	bool at_end           = false;
+};
+
+#endif
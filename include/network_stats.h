@@ -0,0 +1,128 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_NETWORK_STATS_H
+#define DOSBOX_NETWORK_STATS_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+NetworkStats Class
+~~~~~~~~~~~~~~~~~~
+Traffic counters of a network backend (the Ethernet connections, the IPX
+tunnel and the serial sockets), to tell why a networked session lags.
+
+The counters can be updated from the backend's network thread and the
+emulation thread alike. Every backend calls Tick() from its per-tick poll,
+which turns the counts into per-second rates once a second and plots them
+for Tracy.
+
+Backends register their stats while they're active; NETSTAT.COM lists
+them.
+*/
+
+class NetworkStats {
+public:
+	NetworkStats(const std::string& name);
+	~NetworkStats();
+
+	NetworkStats(const NetworkStats&)            = delete; // prevent copying
+	NetworkStats& operator=(const NetworkStats&) = delete; // prevent assignment
+
+	void AddReceived(const uint64_t num_bytes)
+	{
+		++rx_packets;
+		rx_bytes += num_bytes;
+	}
+
+	void AddSent(const uint64_t num_bytes)
+	{
+		++tx_packets;
+		tx_bytes += num_bytes;
+	}
+
+	void AddDropped()
+	{
+		++drops;
+	}
+
+	// Items waiting in the receive ring when the emulation polled it
+	void SetQueued(const uint64_t num_items);
+
+	// Time from the host receiving a packet to the emulation delivering
+	// it to the guest
+	void AddLatency(const int64_t latency_us);
+
+	// Time the emulation spent in the backend's poll this tick; also
+	// updates the rates once a second
+	void Tick(const int64_t poll_us);
+
+	struct Rates {
+		uint64_t rx_packets = 0;
+		uint64_t rx_bytes   = 0;
+		uint64_t tx_packets = 0;
+		uint64_t tx_bytes   = 0;
+	};
+
+	const std::string& GetName() const
+	{
+		return name;
+	}
+
+	Rates GetRates() const;
+
+	std::atomic<uint64_t> rx_packets = 0;
+	std::atomic<uint64_t> rx_bytes   = 0;
+	std::atomic<uint64_t> tx_packets = 0;
+	std::atomic<uint64_t> tx_bytes   = 0;
+	std::atomic<uint64_t> drops      = 0;
+
+	// Only touched by the emulation thread
+	uint64_t queued     = 0;
+	uint64_t max_queued = 0;
+
+	uint64_t num_latencies   = 0;
+	int64_t total_latency_us = 0;
+	int64_t max_latency_us   = 0;
+
+	uint64_t num_polls    = 0;
+	int64_t total_poll_us = 0;
+	int64_t max_poll_us   = 0;
+
+private:
+	const std::string name;
+
+	// Names of the Tracy plots, which have to outlive them
+	const std::string rx_plot_name;
+	const std::string tx_plot_name;
+	const std::string latency_plot_name;
+
+	int64_t last_rates_ms = 0;
+	Rates last_counts     = {};
+	Rates rates           = {};
+};
+
+// The stats of all the active backends, in the order they were created
+std::vector<const NetworkStats*> NETSTATS_GetAll();
+
+#endif
@@ -73,4 +73,29 @@ private:
 	bool was_reset = false;
 };
 
+/*
+Precise Waits
+~~~~~~~~~~~~~
+PACER_WaitUntilUs() waits until the deadline, given in GetTicksUs() time.
+It sleeps on the host's high-resolution timer (a high-resolution waitable
+timer on Windows, clock_nanosleep() on POSIX hosts) for the bulk of the
+wait and spins through the rest. The spin starts early enough to cover
+how late the host's sleeps have recently woken up.
+
+How late each wait returned is tracked as the pacing error.
+*/
+
+struct PacingStats {
+	int64_t num_waits      = 0;
+	int64_t total_error_us = 0;
+	int64_t max_error_us   = 0;
+	int64_t spin_margin_us = 0;
+};
+
+// Only to be called from the emulation thread
+void PACER_WaitUntilUs(const int64_t deadline_us);
+
+PacingStats PACER_GetPacingStats();
+void PACER_ResetPacingStats();
+
 #endif
@@ -51,6 +51,7 @@ class PageDirectory;
 #define PFLAG_INIT			0x20			//No dynamic code can be generated here
 #define PFLAG_HASCODE16		0x40			//Page contains 16-bit dynamic code
 #define PFLAG_HASCODE		(PFLAG_HASCODE32|PFLAG_HASCODE16)
+#define PFLAG_BLOCKWRITE	0x80			//Handler implements write_block
 
 #define LINK_START	((1024+64)/4)			//Start right after the HMA
 
@@ -80,6 +81,13 @@ public:
 	virtual bool writed_checked(PhysPt addr, uint32_t val);
 	virtual bool writeq_checked(PhysPt addr, uint64_t val);
 
+	// Writes a run of bytes that stays within the page, as num_writes
+	// writes of equal size. The handlers that can do this faster than
+	// element by element override it and set PFLAG_BLOCKWRITE; it returns
+	// false otherwise, and the caller has to go through the regular writes.
+	virtual bool write_block(PhysPt addr, const uint8_t* data,
+	                         Bitu num_bytes, Bitu num_writes);
+
 	uint_fast8_t flags = 0x0;
 };
 
@@ -92,6 +100,14 @@ void PAGING_SetDirBase(Bitu cr3);
 void PAGING_InitTLB();
 void PAGING_ClearTLB();
 
+// Drops all links, including the ones the tagged TLB keeps aside; used when
+// the way the page tables are read changes (e.g., CR4.PSE is toggled)
+void PAGING_FlushTLB();
+
+// Keep the links of recently used page directories across CR3 loads
+void PAGING_SetTaggedTLB(bool enabled);
+void PAGING_LogStats();
+
 void PAGING_LinkPage(uint32_t lin_page,uint32_t phys_page);
 void PAGING_LinkPage_ReadOnly(uint32_t lin_page,uint32_t phys_page);
 void PAGING_UnlinkPages(Bitu lin_page,Bitu pages);
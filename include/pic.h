@@ -68,8 +68,24 @@ void PIC_DeActivateIRQ(uint8_t irq);
 void PIC_runIRQs();
 bool PIC_RunQueue();
 
+// Splits each millisecond tick into the given number of slices, after each
+// slice PIC_RunQueue returns false so the main loop can sync with the host
+void PIC_SetTickSlices(int num_slices);
+
+// Releases the next slice of the current tick, returns false when the tick
+// has no slices left and a new tick has to be started
+bool PIC_NextTickSlice();
+
+// Handle to a scheduled event, can be used to cancel just that event
+using PIC_EventId = uint32_t;
+constexpr PIC_EventId PIC_NoEvent = 0;
+
 //Delay in milliseconds
-void PIC_AddEvent(PIC_EventHandler handler, double delay, uint32_t val = 0);
+PIC_EventId PIC_AddEvent(PIC_EventHandler handler, double delay, uint32_t val = 0);
+
+// Returns false if the event already ran or was removed
+bool PIC_RemoveEvent(PIC_EventId id);
+
 void PIC_RemoveEvents(PIC_EventHandler handler);
 void PIC_RemoveSpecificEvents(PIC_EventHandler handler, uint32_t val);
 
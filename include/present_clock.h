@@ -0,0 +1,219 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_PRESENT_CLOCK_H
+#define DOSBOX_PRESENT_CLOCK_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+
+/*
+PresentClock Class
+~~~~~~~~~~~~~~~~~~
+Predicts the host's vertical blanks from the times frame presentations
+returned. With vsync, presenting blocks until the next vblank, so the
+timestamps fall on a grid of the refresh period plus some jitter from the
+scheduler. The clock locks its phase onto that grid and slowly trims the
+period, so callers can tell how far away the next vblank is.
+
+It also keeps a histogram of the intervals between presentations.
+
+Usage:
+ 1. SetNominalPeriod() with the period the display reports.
+ 2. Call AddPresent() with the time right after each presentation returned.
+ 3. Use IsLocked() and PredictNextVblank() to schedule the next one.
+*/
+
+class PresentClock {
+public:
+	// Intervals are binned per millisecond, the last bin holds all the
+	// longer ones
+	static constexpr int HistogramBins = 64;
+	using Histogram = std::array<uint32_t, HistogramBins>;
+
+	void SetNominalPeriod(const int period_us)
+	{
+		if (period_us <= 0 || period_us == nominal_period_us) {
+			return;
+		}
+		nominal_period_us = period_us;
+		period_us_f       = period_us;
+		Unlock();
+	}
+
+	void AddPresent(const int64_t present_us)
+	{
+		if (last_present_us) {
+			AddToHistogram(present_us - last_present_us);
+		}
+		last_present_us = present_us;
+
+		if (nominal_period_us <= 0) {
+			return;
+		}
+		if (!phase_us) {
+			phase_us = present_us;
+			return;
+		}
+
+		// Distance to the nearest vblank on the predicted grid
+		const auto since_phase = static_cast<double>(present_us - *phase_us);
+		const auto num_periods = std::max(std::round(since_phase / period_us_f),
+		                                  1.0);
+		const auto error = since_phase - num_periods * period_us_f;
+
+		// Presents that returned far off the grid didn't wait for a
+		// vblank (or waited for a later one than expected), so start
+		// over from this one once that keeps happening
+		if (std::fabs(error) > period_us_f / 4) {
+			if (++num_misses >= MaxMisses) {
+				Unlock();
+				phase_us = present_us;
+			}
+			return;
+		}
+		num_misses = 0;
+
+		// Follow the jitter-free part of the error; the period only
+		// moves within a few percent of the nominal one
+		const auto vblank_us = *phase_us + num_periods * period_us_f;
+		phase_us = static_cast<int64_t>(std::llround(vblank_us + PhaseGain * error));
+
+		period_us_f += PeriodGain * error / num_periods;
+		period_us_f = std::clamp(period_us_f,
+		                         nominal_period_us * (1.0 - MaxPeriodDrift),
+		                         nominal_period_us * (1.0 + MaxPeriodDrift));
+
+		if (num_locked < LockedAfter) {
+			++num_locked;
+		}
+	}
+
+	bool IsLocked() const
+	{
+		return num_locked >= LockedAfter;
+	}
+
+	// The first predicted vblank after the given time
+	int64_t PredictNextVblank(const int64_t now_us) const
+	{
+		if (!phase_us || period_us_f <= 0) {
+			return now_us;
+		}
+		const auto since_phase = static_cast<double>(now_us - *phase_us);
+		const auto num_periods = std::floor(since_phase / period_us_f) + 1;
+		return *phase_us + static_cast<int64_t>(
+		                           std::llround(num_periods * period_us_f));
+	}
+
+	// The last predicted vblank at or before the given time
+	int64_t PredictLastVblank(const int64_t now_us) const
+	{
+		if (!phase_us || period_us_f <= 0) {
+			return now_us;
+		}
+		return PredictNextVblank(now_us) -
+		       static_cast<int64_t>(std::llround(period_us_f));
+	}
+
+	double GetPeriodUs() const
+	{
+		return period_us_f;
+	}
+
+	const Histogram& GetHistogram() const
+	{
+		return histogram;
+	}
+
+	uint32_t GetNumIntervals() const
+	{
+		return num_intervals;
+	}
+
+	// Interval in milliseconds below which the given percentage of
+	// intervals fell
+	int GetPercentileMs(const int percent) const
+	{
+		if (!num_intervals) {
+			return 0;
+		}
+		const auto wanted = (static_cast<uint64_t>(num_intervals) *
+		                             std::clamp(percent, 1, 100) +
+		                     99) /
+		                    100;
+		uint64_t count = 0;
+		for (int bin = 0; bin < HistogramBins; ++bin) {
+			count += histogram[bin];
+			if (count >= wanted) {
+				return bin + 1;
+			}
+		}
+		return HistogramBins;
+	}
+
+	void ClearHistogram()
+	{
+		histogram     = {};
+		num_intervals = 0;
+	}
+
+private:
+	void Unlock()
+	{
+		phase_us   = {};
+		num_locked = 0;
+		num_misses = 0;
+	}
+
+	void AddToHistogram(const int64_t interval_us)
+	{
+		if (interval_us < 0) {
+			return;
+		}
+		const auto bin = std::min(interval_us / 1000,
+		                          static_cast<int64_t>(HistogramBins - 1));
+		++histogram[static_cast<size_t>(bin)];
+		++num_intervals;
+	}
+
+	static constexpr double PhaseGain      = 0.1;
+	static constexpr double PeriodGain     = 0.01;
+	static constexpr double MaxPeriodDrift = 0.05;
+	static constexpr int LockedAfter       = 8;
+	static constexpr int MaxMisses         = 4;
+
+	Histogram histogram    = {};
+	uint32_t num_intervals = 0;
+
+	int nominal_period_us   = 0;
+	double period_us_f      = 0.0;
+	int64_t last_present_us = 0;
+
+	// Time of a predicted vblank the grid is anchored to
+	std::optional<int64_t> phase_us = {};
+	int num_locked = 0;
+	int num_misses = 0;
+};
+
+#endif
@@ -21,6 +21,7 @@
 
 #include <cstring>
 #include <deque>
+#include <memory>
 #include <optional>
 #include <string>
 
@@ -143,35 +144,16 @@ struct RenderedImage {
 	// B1, X1, etc.)
 	uint8_t* palette_data = nullptr;
 
+	// Optional, one entry per row that is non-zero if the row differs
+	// from the previous rendered image. Only valid during the call the
+	// image was passed to.
+	const uint8_t* changed_rows = nullptr;
+
 	inline bool is_paletted() const
 	{
 		return (params.pixel_format == PixelFormat::Indexed8);
 	}
 
-	RenderedImage deep_copy() const
-	{
-		RenderedImage copy = *this;
-
-		// Deep-copy image and palette data
-		const auto image_data_num_bytes = static_cast<uint32_t>(
-		        params.height * pitch);
-
-		copy.image_data = new uint8_t[image_data_num_bytes];
-
-		assert(image_data);
-		std::memcpy(copy.image_data, image_data, image_data_num_bytes);
-
-		// TODO it's bad that we need to make this assumption downstream
-		// on the size and alignment of the palette...
-		if (palette_data) {
-			constexpr uint16_t PaletteNumBytes = 256 * 4;
-			copy.palette_data = new uint8_t[PaletteNumBytes];
-
-			std::memcpy(copy.palette_data, palette_data, PaletteNumBytes);
-		}
-		return copy;
-	}
-
 	void free()
 	{
 		delete[] image_data;
@@ -182,6 +164,19 @@ struct RenderedImage {
 	}
 };
 
+// An immutable rendered image shared by consumers that keep it around after
+// the call it was passed to, possibly on other threads. The pixel and palette
+// data stay valid until the last reference goes away.
+using SharedRenderedImage = std::shared_ptr<const RenderedImage>;
+
+// Snapshots the image into one of the render's pooled buffers; the buffer is
+// returned to the pool once the image is released
+SharedRenderedImage RENDER_ShareImage(const RenderedImage& image);
+
+// Takes ownership of an image whose pixel and palette data were allocated
+// with new[], without copying them
+SharedRenderedImage RENDER_AdoptImage(const RenderedImage& image);
+
 extern Render_t render;
 extern ScalerLineHandler_t RENDER_DrawLine;
 
@@ -206,6 +201,9 @@ void RENDER_SetSize(const ImageInfo& image_info, const double frames_per_second)
 bool RENDER_StartUpdate(void);
 void RENDER_EndUpdate(bool abort);
 
+// Number of frames the emulated video output ended since startup
+int64_t RENDER_GetFrameCount();
+
 void RENDER_SetPalette(const uint8_t entry, const uint8_t red,
                        const uint8_t green, const uint8_t blue);
 
@@ -0,0 +1,108 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_RENDER_AHEAD_H
+#define DOSBOX_RENDER_AHEAD_H
+
+#include <algorithm>
+#include <limits>
+
+/*
+RenderAhead Class
+~~~~~~~~~~~~~~~~~
+Picks how many frames a device that renders on its own thread should keep
+queued for the mixer. Too few and host hiccups starve the mixer; too many
+and everything the device plays is delayed by that much.
+
+The depth grows quickly when the mixer had to wait for frames and shrinks
+slowly when the queue never came close to running dry, by half of the
+smallest margin seen over a window of callbacks. The depth stays within the
+configured limits.
+
+Usage:
+ 1. Configure() with the limits and the depth to start at.
+ 2. Call Update() in each mixer callback with the frames that were queued
+    and the frames the mixer asked for, then size the queue to the result.
+*/
+
+class RenderAhead {
+public:
+	void Configure(const int min_frames, const int max_frames,
+	               const int initial_frames)
+	{
+		min_depth = std::max(min_frames, 1);
+		max_depth = std::max(max_frames, min_depth);
+		depth     = std::clamp(initial_frames, min_depth, max_depth);
+		ResetWindow();
+	}
+
+	// Returns the depth to keep queued from now on
+	int Update(const int queued_frames, const int requested_frames)
+	{
+		if (queued_frames < requested_frames) {
+			++num_underruns;
+			depth = std::min(depth + std::max(requested_frames, depth / 4),
+			                 max_depth);
+			ResetWindow();
+			return depth;
+		}
+
+		min_margin = std::min(min_margin, queued_frames - requested_frames);
+
+		if (++num_callbacks >= WindowCallbacks) {
+			// Keep at least one callback's worth as margin
+			if (min_margin > requested_frames) {
+				depth = std::max(depth - min_margin / 2, min_depth);
+			}
+			ResetWindow();
+		}
+		return depth;
+	}
+
+	int GetDepth() const
+	{
+		return depth;
+	}
+
+	int GetNumUnderruns() const
+	{
+		return num_underruns;
+	}
+
+private:
+	void ResetWindow()
+	{
+		num_callbacks = 0;
+		min_margin    = std::numeric_limits<int>::max();
+	}
+
+	// A few seconds of callbacks at the usual block sizes
+	static constexpr int WindowCallbacks = 256;
+
+	int min_depth = 1;
+	int max_depth = 1;
+	int depth     = 1;
+
+	int num_callbacks = 0;
+	int min_margin    = std::numeric_limits<int>::max();
+	int num_underruns = 0;
+};
+
+#endif
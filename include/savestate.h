@@ -0,0 +1,137 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_SAVESTATE_H
+#define DOSBOX_SAVESTATE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/*
+Save States
+~~~~~~~~~~~
+Snapshots of the emulated machine, kept in memory so the session can be
+rolled back to them (kiosks), or long boot and loading sequences only have
+to run once (benchmarks). Each subsystem adds a component that writes its
+state to a snapshot and reads it back.
+
+Snapshots are incremental. Areas of guest memory are saved through
+SaveStatePages, which only stores the pages changed since the snapshot
+before, and loading a snapshot replays the chain of snapshots it builds
+on, oldest first. Each component's data is compressed with zlib's fastest
+level.
+
+Some of the state holds host pointers, so snapshots are only valid within
+the session that took them.
+*/
+
+class SaveStateWriter {
+public:
+	SaveStateWriter(std::vector<uint8_t>& out, bool is_full)
+	        : out(out),
+	          is_full(is_full)
+	{}
+
+	// Full snapshots start a new chain; the others only need what
+	// changed since the snapshot before
+	bool IsFull() const
+	{
+		return is_full;
+	}
+
+	void Write(const void* data, size_t num_bytes);
+
+	template <typename T>
+	void Write(const T& value)
+	{
+		Write(&value, sizeof(value));
+	}
+
+private:
+	std::vector<uint8_t>& out;
+	bool is_full = false;
+};
+
+class SaveStateReader {
+public:
+	SaveStateReader(const std::vector<uint8_t>& in) : in(in) {}
+
+	// Reads nothing once the data ran out, see HasFailed()
+	void Read(void* data, size_t num_bytes);
+
+	template <typename T>
+	void Read(T& value)
+	{
+		Read(&value, sizeof(value));
+	}
+
+	bool HasFailed() const
+	{
+		return has_failed;
+	}
+
+private:
+	const std::vector<uint8_t>& in;
+	size_t pos      = 0;
+	bool has_failed = false;
+};
+
+// Finds the pages of a guest memory area changed since the last snapshot
+// was taken or loaded, by comparing it with a copy made back then.
+// Writing through the host pointers the CPU cores and devices keep doesn't
+// pass any common place that could mark the pages instead.
+class SaveStatePages {
+public:
+	static constexpr size_t PageSize = 4096;
+
+	// Writes the pages that changed, or all of them for full snapshots
+	// and areas that changed size
+	void Save(SaveStateWriter& writer, const uint8_t* area, size_t size);
+
+	// Copies the pages held by the snapshot into the area
+	void Load(SaveStateReader& reader, uint8_t* area, size_t size);
+
+private:
+	std::vector<uint8_t> reference = {};
+};
+
+using SaveStateSaveFunction = std::function<void(SaveStateWriter&)>;
+using SaveStateLoadFunction = std::function<void(SaveStateReader&)>;
+
+// Components are saved in the order they were added, and added again
+// under the same name when their subsystem gets restarted
+void SAVESTATE_AddComponent(const std::string& name,
+                            SaveStateSaveFunction save,
+                            SaveStateLoadFunction load);
+void SAVESTATE_RemoveComponent(const std::string& name);
+
+// Mapper events ask for saves and loads, which are run from here once the
+// emulation is between two ticks. The run depth tells how deep the host is
+// in nested emulation loops (the shell and DOS programs run the machine
+// from within calls into DOS); snapshots only load at the depth they were
+// taken at, as they can't restore the host's call stack.
+void SAVESTATE_RunPending(int run_depth);
+
+void SAVESTATE_AddMapperHandlers();
+
+#endif
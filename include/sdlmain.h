@@ -103,10 +103,11 @@
 #define SDL_NOFRAME 0x00000020
 
 // Texture buffer and presentation functions and type-defines
-using update_frame_buffer_f = void(const uint16_t*);
+using update_frame_buffer_f = void(const uint16_t*, const ChangedColumns&);
 using present_frame_f       = bool();
 
-constexpr void update_frame_noop([[maybe_unused]] const uint16_t*)
+constexpr void update_frame_noop([[maybe_unused]] const uint16_t*,
+                                 [[maybe_unused]] const ChangedColumns&)
 {
 	// no-op
 }
@@ -266,6 +267,29 @@ struct SDL_Block {
 		SDL_GLContext context;
 		int pitch      = 0;
 		void* framebuf = nullptr;
+
+		// Set when the frame buffer is mapped from a pixel buffer
+		GLuint pixel_buffer         = 0;
+		GLsync pixel_buffer_fence   = nullptr;
+		bool pixel_buffer_supported = false;
+
+		bool program_binary_supported = false;
+
+		// Indexed frames are uploaded as they are and converted into
+		// the frame texture by a palette lookup pass
+		bool indexed_supported      = false;
+		bool use_indexed            = false;
+		bool needs_palette_lookup   = false;
+		GLuint index_texture        = 0;
+		GLuint palette_texture      = 0;
+		GLuint palette_framebuffer  = 0;
+		GLuint palette_program      = 0;
+
+		// Indexed frames of double-scanned and double-width modes are
+		// uploaded undoubled and stretched by the palette lookup pass
+		int index_width_px  = 0;
+		int index_height_px = 0;
+
 		GLuint texture;
 		GLuint displaylist;
 		GLint max_texsize;
@@ -272,6 +272,15 @@ public:
 	// depratched
 	// connected device checks, if port can receive data:
 	bool CanReceiveByte();
+
+	// With the FIFO on, devices can move a burst of bytes per event
+	// instead of one: up to the trigger level, as far as the FIFO has
+	// room. Without the FIFO it's a single byte.
+	size_t GetRxBurstSize();
+
+	// The bytes received between these only update the FIFO timeout once
+	void beginReceiveBurst();
+	void endReceiveBurst();
 	
 	// when THR was shifted to TX
 	void ByteTransmitting();
@@ -282,6 +291,11 @@ public:
 	// Transmit byte to prepherial
 	virtual void transmitByte(uint8_t val, bool first) = 0;
 
+	// Devices that set tx_burst take the whole TX FIFO at once; they must
+	// call ByteTransmitted() when the last byte would've been sent
+	virtual void transmitBytes(const uint8_t* /*data*/, size_t /*n*/) {}
+	bool tx_burst = false;
+
 	// switch break state to the passed value
 	virtual void setBreak(bool value)=0;
 	
@@ -465,6 +479,9 @@ private:
 	MyFifo *errorfifo = nullptr;
 	uint32_t errors_in_fifo = 0;
 	uint32_t rx_interrupt_threshold = 0;
+	bool in_rx_burst = false;
+	bool rx_burst_received = false;
+	bool rx_burst_timeout = false;
 	uint32_t fifosize = 0;
 	uint8_t FCR = 0;
 	bool sync_guardtime = false;
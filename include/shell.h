@@ -24,8 +24,10 @@
 
 #include <memory>
 #include <optional>
+#include <array>
 #include <stack>
 #include <string>
+#include <unordered_map>
 
 #include "callback.h"
 #include "programs.h"
@@ -45,6 +47,14 @@ public:
 	virtual void Reset()       = 0;
 	virtual std::optional<std::string> Read() = 0;
 
+	// Where the next line starts, to continue reading from there later
+	virtual uint32_t GetPosition() const        = 0;
+	virtual void SetPosition(uint32_t position) = 0;
+
+	// Changes whenever the contents do, so what was parsed from them can
+	// be kept until then
+	virtual uint32_t GetRevision() = 0;
+
 	virtual ~LineReader() = default;
 };
 
@@ -68,11 +78,17 @@ public:
 private:
 	[[nodiscard]] std::string ExpandedBatchLine(std::string_view line) const;
 	[[nodiscard]] std::optional<std::string> GetLine();
+	void IndexLabels();
 
 	const Environment& shell;
 	CommandLine cmd;
 	std::unique_ptr<LineReader> reader;
 	bool echo;
+
+	// Where reading continues after each label, by lowercase name, for
+	// the revision of the contents they were found in
+	std::unordered_map<std::string, uint32_t> labels = {};
+	std::optional<uint32_t> labels_revision          = {};
 };
 
 class AutoexecEditor;
@@ -123,6 +139,16 @@ private:
 	bool exit_cmd_called                   = false;
 	static inline bool help_list_populated = false;
 
+	// The files found in the PATH by command name, kept while the PATH,
+	// the mounted drives and the files on them stay the same
+	struct WhichCache {
+		std::string path             = {};
+		uint32_t file_system_changes = 0;
+		std::array<DOS_Drive*, DOS_DRIVES> drives = {};
+		std::unordered_map<std::string, std::string> files = {};
+	};
+	mutable WhichCache which_cache = {};
+
 public:
 	DOS_Shell();
 	~DOS_Shell() override                  = default;
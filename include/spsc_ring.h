@@ -0,0 +1,165 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_SPSC_RING_H
+#define DOSBOX_SPSC_RING_H
+
+/*  SPSC (Single-Producer/Single-Consumer) Ring
+ *  -------------------------------------------
+ *  A fixed-size lock-free ring buffer for handing items from exactly one
+ *  producer thread to exactly one consumer thread. Neither side ever blocks:
+ *  the producer writes what fits and the consumer reads what's available.
+ *
+ *  The read and write counters only ever grow (and wrap around as unsigned
+ *  integers); the capacity is a power of two so they map onto the storage
+ *  with a mask. Each side only stores its own counter, so the two threads
+ *  never write to the same memory.
+ *
+ *  Producer: GetNumWritable(), Write(), BeginWrite(), CommitWrite()
+ *  Consumer: GetNumReadable(), Peek(), Consume(), Read()
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+template <typename T>
+class SpscRing {
+public:
+	SpscRing()                                       = delete;
+	SpscRing(const SpscRing<T>& other)               = delete;
+	SpscRing<T>& operator=(const SpscRing<T>& other) = delete;
+
+	// The capacity is rounded up to the next power of two
+	explicit SpscRing(const size_t min_capacity)
+	{
+		size_t capacity = 1;
+		while (capacity < min_capacity) {
+			capacity <<= 1;
+		}
+		items.resize(capacity);
+		mask = capacity - 1;
+	}
+
+	size_t MaxCapacity() const
+	{
+		return items.size();
+	}
+
+	// Producer side
+
+	size_t GetNumWritable() const
+	{
+		const auto w = write_count.load(std::memory_order_relaxed);
+		const auto r = read_count.load(std::memory_order_acquire);
+		return items.size() - (w - r);
+	}
+
+	// Returns the number of items written, which is less than requested
+	// when the ring is full
+	size_t Write(const T* in, const size_t num_items)
+	{
+		const auto w = write_count.load(std::memory_order_relaxed);
+		const auto r = read_count.load(std::memory_order_acquire);
+
+		const auto n = std::min(num_items, items.size() - (w - r));
+		for (size_t i = 0; i < n; ++i) {
+			items[(w + i) & mask] = in[i];
+		}
+		write_count.store(w + n, std::memory_order_release);
+		return n;
+	}
+
+	// The slot the next item goes into, for filling it in place, or
+	// nullptr when the ring is full. CommitWrite() hands it over.
+	T* BeginWrite()
+	{
+		if (!GetNumWritable()) {
+			return nullptr;
+		}
+		const auto w = write_count.load(std::memory_order_relaxed);
+		return &items[w & mask];
+	}
+
+	void CommitWrite()
+	{
+		assert(GetNumWritable() > 0);
+		const auto w = write_count.load(std::memory_order_relaxed);
+		write_count.store(w + 1, std::memory_order_release);
+	}
+
+	// Consumer side
+
+	size_t GetNumReadable() const
+	{
+		const auto r = read_count.load(std::memory_order_relaxed);
+		const auto w = write_count.load(std::memory_order_acquire);
+		return w - r;
+	}
+
+	// The item at the given offset from the read position; the offset must
+	// be below what GetNumReadable() returned
+	const T& Peek(const size_t offset) const
+	{
+		const auto r = read_count.load(std::memory_order_relaxed);
+		return items[(r + offset) & mask];
+	}
+
+	// Releases the given number of items back to the producer; at most as
+	// many as GetNumReadable() returned
+	void Consume(const size_t num_items)
+	{
+		const auto r = read_count.load(std::memory_order_relaxed);
+		assert(num_items <= GetNumReadable());
+		read_count.store(r + num_items, std::memory_order_release);
+	}
+
+	// Returns the number of items read, which is less than requested when
+	// the ring runs dry
+	size_t Read(T* out, const size_t num_items)
+	{
+		const auto n = std::min(num_items, GetNumReadable());
+		for (size_t i = 0; i < n; ++i) {
+			out[i] = Peek(i);
+		}
+		Consume(n);
+		return n;
+	}
+
+	// Drops everything that was written; only call this while neither side
+	// is running
+	void Clear()
+	{
+		read_count.store(write_count.load());
+	}
+
+private:
+	std::vector<T> items = {};
+	size_t mask          = 0;
+
+	// Keep the counters on their own cache lines so the producer and
+	// consumer don't keep stealing them from each other
+	alignas(64) std::atomic<size_t> write_count = 0;
+	alignas(64) std::atomic<size_t> read_count  = 0;
+};
+
+#endif
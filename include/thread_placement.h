@@ -0,0 +1,54 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_THREAD_PLACEMENT_H
+#define DOSBOX_THREAD_PLACEMENT_H
+
+#include <string>
+
+// What a thread is used for, which decides the CPUs it may run on and its
+// scheduling priority (or QoS class on macOS)
+enum class ThreadRole {
+	// The thread running the emulation, rendering and presenting frames
+	Emulation,
+
+	// Threads rendering audio ahead of the mixer (MT-32, FluidSynth)
+	Audio,
+
+	// The audio backend's callback thread; its priority is managed by
+	// the backend, so only the CPUs are set
+	AudioDevice,
+
+	// Threads encoding captured video
+	Video,
+
+	// The threads of the shared worker pool
+	Worker,
+};
+
+// Sets the policy from the 'thread_affinity' and 'thread_priorities'
+// settings; has to be called before threads apply their roles
+void THREAD_SetPlacementPolicy(const std::string& affinity_pref,
+                               const bool adjust_priorities);
+
+// Applies the policy of the role to the calling thread
+void THREAD_ApplyRole(const ThreadRole role);
+
+#endif // DOSBOX_THREAD_PLACEMENT_H
@@ -119,6 +119,13 @@ static inline int64_t GetTicksUs()
 	        .count();
 }
 
+static inline int64_t GetTicksNs()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+	               std::chrono::steady_clock::now() - system_start_time)
+	        .count();
+}
+
 static inline int64_t GetTicksDiff(const int64_t new_ticks, const int64_t old_ticks)
 {
 	assert(new_ticks >= old_ticks);
@@ -137,6 +144,12 @@ static inline int64_t GetTicksUsSince(const int64_t old_ticks)
 	return GetTicksDiff(now, old_ticks);
 }
 
+static inline int64_t GetTicksNsSince(const int64_t old_ticks)
+{
+	const auto now = GetTicksNs();
+	return GetTicksDiff(now, old_ticks);
+}
+
 static inline void Delay(const int64_t milliseconds)
 {
 	std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
@@ -32,6 +32,7 @@
 #include "control.h"
 #include "fraction.h"
 #include "inout.h"
+#include "mem.h"
 #include "rgb666.h"
 #include "video.h"
 
@@ -266,6 +267,13 @@ struct VgaDraw {
 
 	uint32_t parts_lines    = 0;
 	uint32_t parts_left     = 0;
+
+	// Once a few frames in a row had no CRTC, attribute or DAC writes
+	// during the active display period, frames are drawn in a single
+	// batch at its end. The first mid-frame write falls back to drawing
+	// the rest of the frame in parts.
+	uint8_t quiet_frames   = 0;
+	bool is_batching_frame = false;
 	Bitu byte_panning_shift = 0;
 
 	struct {
@@ -278,6 +286,7 @@ struct VgaDraw {
 		double hdend = 0, htotal = 0;
 		double parts       = 0;
 		double per_line_ms = 0;
+		double first_line  = 0; // relative to framestart
 	} delay = {};
 
 	double host_refresh_hz    = RefreshRateHostDefault;
@@ -986,6 +995,9 @@ struct VgaDac {
 	uint8_t state       = 0;
 	uint8_t write_index = 0;
 	uint8_t read_index  = 0;
+
+	// Bumped whenever an entry of the palette map changes
+	uint32_t palette_generation = 0;
 };
 
 struct VgaSvga {
@@ -1159,12 +1171,36 @@ double VGA_GetPreferredRate();
 void VGA_DACSetEntirePalette(void);
 void VGA_StartRetrace(void);
 void VGA_StartUpdateLFB(void);
+
+// Copy and fill runs of video memory for the video BIOS in one go. They have
+// the same effect as accessing the bytes one by one with the current register
+// settings, but skip the page handler dispatch for each of them. Both return
+// false if the memory isn't mapped by one of the handlers they know, and the
+// caller has to fall back to the regular memory accesses.
+bool VGA_BlockCopy(const PhysPt dest, const PhysPt src, const Bitu num_bytes);
+bool VGA_BlockFill(const PhysPt dest, const uint8_t val, const Bitu num_bytes);
 void VGA_SetBlinking(uint8_t enabled);
 void VGA_SetCGA2Table(uint8_t val0, uint8_t val1);
 void VGA_SetCGA4Table(uint8_t val0, uint8_t val1, uint8_t val2, uint8_t val3);
 PixelFormat VGA_ActivateHardwareCursor();
 void VGA_KillDrawing(void);
 
+// Composites the DOS mouse driver's 16x16 software cursor onto the drawn
+// lines, leaving the video memory untouched. Only the modes drawn through
+// the DAC palette are supported. The position is the cursor's top-left
+// corner in the video mode's pixels, and each mask row has the leftmost
+// pixel in its top bit.
+constexpr int VgaMouseOverlaySize = 16;
+
+bool VGA_CanDrawMouseOverlay();
+void VGA_SetMouseOverlay(const int x, const int y, const int mode_width,
+                         const int mode_height, const uint16_t* screen_mask,
+                         const uint16_t* cursor_mask);
+void VGA_HideMouseOverlay();
+
+// Called before writes to registers that can affect the picture mid-frame
+void VGA_NoteMidFrameChange();
+
 void VGA_SetOverride(const bool vga_override, const double override_refresh_hz = 0);
 void VGA_LogInitialization(const char* adapter_name, const char* ram_type,
                            const size_t num_modes);
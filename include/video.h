@@ -22,6 +22,7 @@
 #ifndef DOSBOX_VIDEO_H
 #define DOSBOX_VIDEO_H
 
+#include <cstdint>
 #include <string>
 
 #include "fraction.h"
@@ -362,6 +363,7 @@ constexpr uint8_t GFX_CAN_32     = 1 << 3;
 constexpr uint8_t GFX_DBL_H      = 1 << 4; // double-width  flag
 constexpr uint8_t GFX_DBL_W      = 1 << 5; // double-height flag
 constexpr uint8_t GFX_CAN_RANDOM = 1 << 6; // interface can also do random acces
+constexpr uint8_t GFX_GPU_DOUBLING = 1 << 7; // interface doubles 8-bit frames
 
 // return code of:
 // - true means event loop can keep running.
@@ -375,6 +377,11 @@ void GFX_DisengageRendering();
 uint8_t GFX_GetBestMode(const uint8_t flags);
 uint32_t GFX_GetRGB(const uint8_t red, const uint8_t green, const uint8_t blue);
 
+// Updates the palette entries from first to last (inclusive) of indexed
+// frames, used when GFX_SetSize() returned GFX_CAN_8. Each entry holds
+// the 8-bit red, green, and blue values and a padding byte.
+void GFX_SetPalette(const uint8_t* entries, const int first, const int last);
+
 struct ShaderInfo;
 
 void GFX_SetShader(const ShaderInfo& shader_info, const std::string& shader_source);
@@ -397,7 +404,17 @@ void GFX_Start(void);
 void GFX_Stop(void);
 void GFX_SwitchFullScreen(void);
 bool GFX_StartUpdate(uint8_t * &pixels, int &pitch);
-void GFX_EndUpdate( const uint16_t *changedLines );
+// Range of render pixel columns of a frame with changed pixels, the end
+// being exclusive. It applies to all lines in the changed lines list.
+struct ChangedColumns {
+	int start = 0;
+	int end   = INT32_MAX;
+};
+
+void GFX_EndUpdate(const uint16_t* changedLines,
+                   const ChangedColumns& changed_columns = {});
+// Host time spent rendering and presenting frames since the last call
+int64_t GFX_TakePresentTimeUs();
 void GFX_LosingFocus();
 void GFX_RegenerateWindow(Section *sec);
 
@@ -0,0 +1,94 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_WORKER_POOL_H
+#define DOSBOX_WORKER_POOL_H
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+WorkerPool Class
+~~~~~~~~~~~~~~~~
+A fixed number of threads running short tasks submitted by the emulated
+devices, so that running many instances on one host doesn't start a set
+of threads per device and instance. The threads are started on demand, up
+to the maximum, and pick the pending task of the highest priority first.
+
+Tasks must not block waiting for each other or for the emulation thread;
+long-running loops (audio renderers fed by a queue, network servers) keep
+their own threads.
+*/
+
+enum class WorkerPriority : uint8_t {
+	Audio,
+	Video,
+	Capture,
+	Background,
+};
+
+class WorkerPool {
+public:
+	using Task = std::function<void()>;
+
+	// 0 threads picks the number of the host's logical CPU cores
+	explicit WorkerPool(const int max_threads = 0);
+
+	// Runs the tasks still pending before joining the threads
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool&)            = delete; // prevent copying
+	WorkerPool& operator=(const WorkerPool&) = delete; // prevent assignment
+
+	// Only affects the threads started afterwards
+	void SetMaxThreads(const int max_threads);
+	int GetMaxThreads() const;
+
+	void Submit(const WorkerPriority priority, Task task);
+
+private:
+	void Run();
+
+	static constexpr auto NumPriorities = static_cast<size_t>(
+	                                              WorkerPriority::Background) +
+	                                      1;
+
+	mutable std::mutex mutex = {};
+	std::condition_variable has_tasks = {};
+
+	std::array<std::deque<Task>, NumPriorities> queues = {};
+	std::vector<std::thread> threads = {};
+
+	int max_threads  = 0;
+	int idle_threads = 0;
+	int num_queued   = 0;
+	bool is_stopping = false;
+};
+
+// The pool shared by the whole process, sized by the 'worker_threads'
+// setting
+WorkerPool& WORKERS_GetPool();
+
+#endif // DOSBOX_WORKER_POOL_H
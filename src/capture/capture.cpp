@@ -27,7 +27,9 @@
 #include <mutex>
 
 #include "capture_audio.h"
+#include "capture_frame_hashes.h"
 #include "capture_midi.h"
+#include "capture_remote.h"
 #include "capture_video.h"
 #include "checks.h"
 #include "control.h"
@@ -37,6 +39,7 @@
 #include "setup.h"
 #include "string_utils.h"
 #include "support.h"
+#include "tracy.h"
 
 #include <SDL.h>
 
@@ -47,9 +50,10 @@ static struct {
 	bool path_initialised = false;
 
 	struct {
-		CaptureState audio = {};
-		CaptureState midi  = {};
-		CaptureState video = {};
+		CaptureState audio        = {};
+		CaptureState midi         = {};
+		CaptureState video        = {};
+		CaptureState frame_hashes = {};
 	} state = {};
 
 	struct {
@@ -60,6 +64,8 @@ static struct {
 		int32_t video              = 1;
 		int32_t image              = 1;
 		int32_t serial_log         = 1;
+		int32_t frame_hashes       = 1;
+		int32_t guest_profile      = 1;
 	} next_index = {};
 } capture = {};
 
@@ -70,6 +76,16 @@ bool CAPTURE_IsCapturingAudio()
 	return capture.state.audio != CaptureState::Off;
 }
 
+bool CAPTURE_IsCapturingFrameHashes()
+{
+	return capture.state.frame_hashes != CaptureState::Off;
+}
+
+bool CAPTURE_IsServingRemoteDisplay()
+{
+	return capture_remote_is_running();
+}
+
 bool CAPTURE_IsCapturingImage()
 {
 	if (image_capturer) {
@@ -105,6 +121,7 @@ static const char* capture_type_to_string(const CaptureType type)
 	case CaptureType::RadOplInstruments: return "RAD capture";
 
 	case CaptureType::Video: return "video output";
+	case CaptureType::VideoPreview: return "video preview";
 
 	case CaptureType::RawImage: return "raw image";
 	case CaptureType::UpscaledImage: return "upscaled image";
@@ -112,6 +129,10 @@ static const char* capture_type_to_string(const CaptureType type)
 
 	case CaptureType::SerialLog: return "serial log";
 
+	case CaptureType::FrameHashes: return "frame hashes";
+
+	case CaptureType::GuestProfile: return "guest profile";
+
 	default: assertm(false, "Unknown CaptureType"); return "";
 	}
 }
@@ -124,7 +145,8 @@ static const char* capture_type_to_basename(const CaptureType type)
 	case CaptureType::RawOplStream: return "rawopl";
 	case CaptureType::RadOplInstruments: return "oplinstr";
 
-	case CaptureType::Video: return "video";
+	case CaptureType::Video:
+	case CaptureType::VideoPreview: return "video";
 
 	case CaptureType::RawImage:
 	case CaptureType::UpscaledImage:
@@ -132,6 +154,10 @@ static const char* capture_type_to_basename(const CaptureType type)
 
 	case CaptureType::SerialLog: return "serial";
 
+	case CaptureType::FrameHashes: return "framehash";
+
+	case CaptureType::GuestProfile: return "profile";
+
 	default: assertm(false, "Unknown CaptureType"); return "";
 	}
 }
@@ -145,6 +171,7 @@ static const char* capture_type_to_extension(const CaptureType type)
 	case CaptureType::RadOplInstruments: return ".rad";
 
 	case CaptureType::Video: return ".avi";
+	case CaptureType::VideoPreview: return ".png";
 
 	case CaptureType::RawImage:
 	case CaptureType::UpscaledImage:
@@ -152,6 +179,10 @@ static const char* capture_type_to_extension(const CaptureType type)
 
 	case CaptureType::SerialLog: return ".serlog";
 
+	case CaptureType::FrameHashes: return ".fhl";
+
+	case CaptureType::GuestProfile: return ".folded";
+
 	default: assertm(false, "Unknown CaptureType"); return "";
 	}
 }
@@ -161,6 +192,7 @@ static const char* capture_type_to_postfix(const CaptureType type)
 	switch (type) {
 	case CaptureType::RawImage: return "-raw";
 	case CaptureType::RenderedImage: return "-rendered";
+	case CaptureType::VideoPreview: return "-preview";
 	default: return "";
 	}
 }
@@ -234,7 +266,8 @@ static void set_next_capture_index(const CaptureType type, int32_t index)
 		capture.next_index.rad_opl_instrument = index;
 		break;
 
-	case CaptureType::Video: capture.next_index.video = index; break;
+	case CaptureType::Video:
+	case CaptureType::VideoPreview: capture.next_index.video = index; break;
 
 	case CaptureType::RawImage:
 	case CaptureType::UpscaledImage:
@@ -246,6 +279,14 @@ static void set_next_capture_index(const CaptureType type, int32_t index)
 		capture.next_index.serial_log = index;
 		break;
 
+	case CaptureType::FrameHashes:
+		capture.next_index.frame_hashes = index;
+		break;
+
+	case CaptureType::GuestProfile:
+		capture.next_index.guest_profile = index;
+		break;
+
 	default: assertm(false, "Unknown CaptureType");
 	}
 }
@@ -270,7 +311,9 @@ static bool maybe_create_capture_dir_and_init_capture_indices()
 	                                             CaptureType::RawImage,
 	                                             CaptureType::UpscaledImage,
 	                                             CaptureType::RenderedImage,
-	                                             CaptureType::SerialLog};
+	                                             CaptureType::SerialLog,
+	                                             CaptureType::FrameHashes,
+	                                             CaptureType::GuestProfile};
 
 	for (auto type : all_capture_types) {
 		const auto index = find_highest_capture_index(type);
@@ -302,7 +345,8 @@ int32_t get_next_capture_index(const CaptureType type)
 	case CaptureType::RadOplInstruments:
 		return capture.next_index.rad_opl_instrument++;
 
-	case CaptureType::Video: return capture.next_index.video++;
+	case CaptureType::Video:
+	case CaptureType::VideoPreview: return capture.next_index.video++;
 
 	case CaptureType::RawImage:
 	case CaptureType::UpscaledImage:
@@ -310,6 +354,11 @@ int32_t get_next_capture_index(const CaptureType type)
 
 	case CaptureType::SerialLog: return capture.next_index.serial_log++;
 
+	case CaptureType::FrameHashes: return capture.next_index.frame_hashes++;
+
+	case CaptureType::GuestProfile:
+		return capture.next_index.guest_profile++;
+
 	default: assertm(false, "Unknown CaptureType"); return 0;
 	}
 }
@@ -341,9 +390,13 @@ FILE* CAPTURE_CreateFile(const CaptureType type,
 
 	FILE* handle = open_file(path_str.c_str(), "wb");
 	if (handle) {
-		LOG_MSG("CAPTURE: Capturing %s to '%s'",
-		        capture_type_to_string(type),
-		        path_str.c_str());
+		// The video previews are logged once when the video capture
+		// starts
+		if (type != CaptureType::VideoPreview) {
+			LOG_MSG("CAPTURE: Capturing %s to '%s'",
+			        capture_type_to_string(type),
+			        path_str.c_str());
+		}
 	} else {
 		LOG_WARNING("CAPTURE: Failed to create file '%s' for capturing %s",
 		            path_str.c_str(),
@@ -389,10 +442,25 @@ void CAPTURE_StopVideoCapture()
 
 void CAPTURE_AddFrame(const RenderedImage& image, const float frames_per_second)
 {
+	ZoneScoped;
+	switch (capture.state.frame_hashes) {
+	case CaptureState::Off: break;
+	case CaptureState::Pending:
+		capture.state.frame_hashes = CaptureState::InProgress;
+		[[fallthrough]];
+	case CaptureState::InProgress:
+		capture_frame_hashes_add_frame(image);
+		break;
+	}
+
 	if (image_capturer) {
 		image_capturer->MaybeCaptureImage(image);
 	}
 
+	if (capture_remote_is_running()) {
+		capture_remote_add_frame(image);
+	}
+
 	switch (capture.state.video) {
 	case CaptureState::Off: break;
 	case CaptureState::Pending:
@@ -400,12 +468,19 @@ void CAPTURE_AddFrame(const RenderedImage& image, const float frames_per_second)
 		[[fallthrough]];
 	case CaptureState::InProgress:
 		capture_video_add_frame(image, frames_per_second);
+
+		if (const auto path = capture_video_get_next_preview_path(
+		            frames_per_second);
+		    path && image_capturer) {
+			image_capturer->CaptureVideoPreview(image, *path);
+		}
 		break;
 	}
 }
 
 void CAPTURE_AddPostRenderImage(const RenderedImage& image)
 {
+	ZoneScoped;
 	if (image_capturer) {
 		image_capturer->CapturePostRenderImage(image);
 	}
@@ -414,6 +489,7 @@ void CAPTURE_AddPostRenderImage(const RenderedImage& image)
 void CAPTURE_AddAudioData(const uint32_t sample_rate, const uint32_t num_sample_frames,
                           const int16_t* sample_frames)
 {
+	ZoneScoped;
 	switch (capture.state.video) {
 	case CaptureState::Off: break;
 	case CaptureState::Pending:
@@ -576,6 +652,11 @@ static void capture_destroy(Section* /*sec*/)
 		capture_video_finalise();
 		capture.state.video = CaptureState::Off;
 	}
+	if (capture.state.frame_hashes == CaptureState::InProgress) {
+		capture_frame_hashes_finalise();
+		capture.state.frame_hashes = CaptureState::Off;
+	}
+	capture_remote_stop();
 
 	capture = {};
 }
@@ -602,7 +683,40 @@ static void capture_init(Section* sec)
 
 	const std::string prefs = secprop->Get_string("default_image_capture_formats");
 
-	image_capturer = std::make_unique<ImageCapturer>(prefs);
+	const std::string image_compression = secprop->Get_string(
+	        "image_capture_compression");
+
+	auto compression = ImageCompression::Auto;
+	if (image_compression == "fast") {
+		compression = ImageCompression::Fast;
+	} else if (image_compression == "small") {
+		compression = ImageCompression::Small;
+	}
+
+	image_capturer = std::make_unique<ImageCapturer>(prefs, compression);
+
+	capture_video_set_stream(secprop->Get_string("video_capture_stream"));
+	capture_video_set_preview(secprop->Get_bool("video_capture_preview"));
+
+	if (secprop->Get_bool("frame_hash_capture")) {
+		capture.state.frame_hashes = CaptureState::Pending;
+		LOG_MSG("CAPTURE: Preparing to capture frame hashes; "
+		        "capturing will start with the first frame");
+	}
+
+	const std::string video_compression = secprop->Get_string(
+	        "video_capture_compression");
+	if (video_compression == "fast") {
+		capture_video_set_compression(VideoCompression::Fast);
+	} else if (video_compression == "small") {
+		capture_video_set_compression(VideoCompression::Small);
+	} else {
+		capture_video_set_compression(VideoCompression::Auto);
+	}
+
+	if (const auto port = secprop->Get_int("remote_display_port"); port > 0) {
+		capture_remote_start(static_cast<uint16_t>(port));
+	}
 
 	constexpr auto changeable_at_runtime = true;
 	sec->AddDestroyFunction(&capture_destroy, changeable_at_runtime);
@@ -689,6 +803,63 @@ static void init_capture_dosbox_settings(Section_prop& secprop)
 	        "Keybindings for taking single screenshots in specific formats are also\n"
 	        "available.");
 	assert(str_prop);
+
+	str_prop = secprop.Add_string("image_capture_compression", when_idle, "auto");
+	str_prop->Set_values({"auto", "fast", "small"});
+	str_prop->Set_help(
+	        "Set how hard screenshots are compressed ('auto' by default):\n"
+	        "  auto:   Make small files, but compress faster while screenshots are\n"
+	        "          requested faster than they can be saved.\n"
+	        "  fast:   Use the least CPU time, at the cost of larger files; useful for\n"
+	        "          taking screenshots in quick succession.\n"
+	        "  small:  Always make the smallest files.");
+	assert(str_prop);
+
+	str_prop = secprop.Add_string("video_capture_compression", when_idle, "auto");
+	str_prop->Set_values({"auto", "fast", "small"});
+	str_prop->Set_help(
+	        "Set how hard video captures are compressed ('auto' by default). All of them\n"
+	        "result in standard ZMBV videos:\n"
+	        "  auto:   Start with small files, but compress faster while the encoder\n"
+	        "          needs more than a small share of one CPU core.\n"
+	        "  fast:   Use the least CPU time, at the cost of larger files.\n"
+	        "  small:  Make the smallest files, at the cost of more CPU time.");
+	assert(str_prop);
+
+	str_prop = secprop.Add_string("video_capture_stream", when_idle, "");
+	str_prop->Set_help(
+	        "Stream the raw video frames and audio to this file or named pipe instead of\n"
+	        "saving the video captures as AVI files, e.g., for live encoding (unset by\n"
+	        "default). Use 'tcp:host:port' to connect to a TCP server instead. The\n"
+	        "stream format is described in 'src/capture/capture_stream.h'.");
+	assert(str_prop);
+
+	auto* bool_prop = secprop.Add_bool("video_capture_preview", when_idle, false);
+	bool_prop->Set_help(
+	        "Save a small preview image of the video captures every second, next to\n"
+	        "the video files, e.g., for generating thumbnails (disabled by default).\n"
+	        "The images fit into 160x120 pixels and are named after the video, e.g.,\n"
+	        "'video0001-preview0001.png'.");
+	assert(bool_prop);
+
+	bool_prop = secprop.Add_bool("frame_hash_capture", when_idle, false);
+	bool_prop->Set_help(
+	        "Log a hash of every emulated frame to a file in the capture directory\n"
+	        "(disabled by default). The hashes are taken from the raw frames before\n"
+	        "scaling, so comparing the logs of two runs finds rendering differences and\n"
+	        "determinism breaks without saving any images. The file format is\n"
+	        "described in 'src/capture/capture_frame_hashes.h'.");
+	assert(bool_prop);
+
+	auto* int_prop = secprop.Add_int("remote_display_port", when_idle, 0);
+	int_prop->SetMinMax(0, 65535);
+	int_prop->Set_help(
+	        "Serve the emulated screen to a VNC viewer on this TCP port, and feed the\n"
+	        "viewer's keyboard and mouse input to the emulated machine (0 by default,\n"
+	        "disabled). Only the changed parts of the screen are sent, at their native\n"
+	        "resolution. Note: There is no authentication, so only make the port\n"
+	        "reachable from trusted networks.");
+	assert(int_prop);
 }
 
 void CAPTURE_AddConfigSection(const config_ptr_t& conf)
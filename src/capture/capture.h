@@ -38,7 +38,10 @@ enum class CaptureType {
 	RawImage,
 	UpscaledImage,
 	RenderedImage,
-	SerialLog
+	SerialLog,
+	FrameHashes,
+	VideoPreview,
+	GuestProfile
 };
 
 enum class CaptureState { Off, Pending, InProgress };
@@ -70,10 +73,12 @@ void CAPTURE_StartVideoCapture();
 void CAPTURE_StopVideoCapture();
 
 bool CAPTURE_IsCapturingAudio();
+bool CAPTURE_IsCapturingFrameHashes();
 bool CAPTURE_IsCapturingImage();
 bool CAPTURE_IsCapturingPostRenderImage();
 bool CAPTURE_IsCapturingMidi();
 bool CAPTURE_IsCapturingVideo();
+bool CAPTURE_IsServingRemoteDisplay();
 
 // Only used internally in the capture module
 int32_t get_next_capture_index(const CaptureType type);
@@ -24,35 +24,17 @@
 #include <cstdio>
 #include <cstdlib>
 
+#include "capture_writer.h"
 #include "mem.h"
 #include "setup.h"
 #include "video.h"
 
-static constexpr auto SampleFrameSize   = 4;
-static constexpr auto NumFramesInBuffer = 16 * 1024;
-static constexpr auto NumChannels       = 2;
+static constexpr auto SampleFrameSize = 4;
 
 static struct {
-	FILE* handle = nullptr;
+	CaptureWriter writer = {};
 
-	uint16_t buf[NumFramesInBuffer][NumChannels] = {};
-
-	uint32_t sample_rate_hz  = 0;
-	uint32_t buf_frames_used = 0;
-	
-	// TODO A 16-bit / 44.1kHz WAV file is limited to a bit less than 4GB
-	// worth of sample data because the chunk sizes are stored as 32-bit
-	// unsigned integers in the RIFF container the WAV format uses.
-	//
-	// So technically we should chunk the recording into separate WAV files at
-	// ~3.4 hour intervals, which is the duration of a recording of a 2GB
-	// WAV file recorded at 16-bit/44.1kHz (some programs use 32-bit signed
-	// integers when handling WAV files, therefore 2GB is the safe limit).
-	//
-	// This will be more of a problem when adding support for 24 and 32-bit
-	// formats, as in case of a 32-bit float WAV file, the safe duration is
-	// reduced to ~1.7 hour.
-	uint32_t data_bytes_written = 0;
+	uint32_t sample_rate_hz = 0;
 } wave = {};
 
 // clang-format off
@@ -75,75 +57,63 @@ static uint8_t wav_header[] = {
 
 static void create_wave_file(const uint32_t sample_rate_hz)
 {
-	wave.handle = CAPTURE_CreateFile(CaptureType::Audio);
-	if (!wave.handle) {
+	const auto handle = CAPTURE_CreateFile(CaptureType::Audio);
+	if (!handle) {
 		return;
 	}
 
-	wave.sample_rate_hz     = sample_rate_hz;
-	wave.buf_frames_used    = 0;
-	wave.data_bytes_written = 0;
+	wave.writer.Open(handle);
+	wave.sample_rate_hz = sample_rate_hz;
 
-	fwrite(wav_header, 1, sizeof(wav_header), wave.handle);
+	wave.writer.Write(wav_header, sizeof(wav_header));
 }
 
 void capture_audio_add_data(const uint32_t sample_rate_hz,
                             const uint32_t num_sample_frames,
                             const int16_t* sample_frames)
 {
-	if (!wave.handle) {
+	if (!wave.writer.IsOpen()) {
 		GFX_NotifyAudioCaptureStatus(true);
 		create_wave_file(sample_rate_hz);
 	}
-	if (!wave.handle) {
+	if (!wave.writer.IsOpen()) {
 		GFX_NotifyAudioCaptureStatus(false);
 		return;
 	}
 
-	const int16_t* data   = sample_frames;
-	auto remaining_frames = num_sample_frames;
-
-	while (remaining_frames > 0) {
-		uint32_t frames_left = NumFramesInBuffer - wave.buf_frames_used;
-		if (!frames_left) {
-			const auto bytes_to_write = NumFramesInBuffer * SampleFrameSize;
-			fwrite(wave.buf, 1, bytes_to_write, wave.handle);
-
-			wave.data_bytes_written += bytes_to_write;
-			wave.buf_frames_used = 0;
-
-			frames_left = NumFramesInBuffer;
-		}
-
-		if (frames_left > remaining_frames) {
-			frames_left = remaining_frames;
-		}
-
-		memcpy(&wave.buf[wave.buf_frames_used],
-		       data,
-		       frames_left * SampleFrameSize);
-
-		wave.buf_frames_used += frames_left;
-		data += frames_left * NumChannels;
-		remaining_frames -= frames_left;
-	}
+	// Called from the mixer thread; the data is only buffered here and
+	// written out on the writer's own thread
+	wave.writer.Write(sample_frames, num_sample_frames * SampleFrameSize);
 }
 
 void capture_audio_finalise()
 {
-	if (!wave.handle) {
+	if (!wave.writer.IsOpen()) {
 		return;
 	}
 
+	// TODO A 16-bit / 44.1kHz WAV file is limited to a bit less than 4GB
+	// worth of sample data because the chunk sizes are stored as 32-bit
+	// unsigned integers in the RIFF container the WAV format uses.
+	//
+	// So technically we should chunk the recording into separate WAV files at
+	// ~3.4 hour intervals, which is the duration of a recording of a 2GB
+	// WAV file recorded at 16-bit/44.1kHz (some programs use 32-bit signed
+	// integers when handling WAV files, therefore 2GB is the safe limit).
+	//
+	// This will be more of a problem when adding support for 24 and 32-bit
+	// formats, as in case of a 32-bit float WAV file, the safe duration is
+	// reduced to ~1.7 hour.
+	const auto data_bytes_written = static_cast<uint32_t>(
+	        wave.writer.GetNumBytesWritten() - sizeof(wav_header));
+
 	// Flush audio buffer
-	const auto bytes_to_write = wave.buf_frames_used * SampleFrameSize;
-	fwrite(wave.buf, 1, bytes_to_write, wave.handle);
-	wave.data_bytes_written += bytes_to_write;
+	const auto handle = wave.writer.Close();
 
 	// Update headers
 	constexpr auto chunk_header_size = 8;
 
-	const auto riff_chunk_size = static_cast<uint32_t>(wave.data_bytes_written +
+	const auto riff_chunk_size = static_cast<uint32_t>(data_bytes_written +
 	                             sizeof(wav_header) - chunk_header_size);
 
 	constexpr auto riff_chunk_size_offset = 0x04;
@@ -157,13 +127,13 @@ void capture_audio_finalise()
 	            wave.sample_rate_hz * SampleFrameSize);
 
 	constexpr auto data_chunk_size_offset = 0x28;
-	host_writed(&wav_header[data_chunk_size_offset], wave.data_bytes_written);
+	host_writed(&wav_header[data_chunk_size_offset], data_bytes_written);
 
-	fseek(wave.handle, 0, 0);
-	fwrite(wav_header, 1, sizeof(wav_header), wave.handle);
-	fclose(wave.handle);
+	fseek(handle, 0, 0);
+	fwrite(wav_header, 1, sizeof(wav_header), handle);
+	fclose(handle);
 
-	wave = {};
+	wave.sample_rate_hz = 0;
 
 	GFX_NotifyAudioCaptureStatus(false);
 }
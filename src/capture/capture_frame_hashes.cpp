@@ -0,0 +1,126 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "capture_frame_hashes.h"
+
+#include <cassert>
+#include <cstring>
+
+#include "capture.h"
+#include "capture_writer.h"
+#include "checks.h"
+#include "mem.h"
+#include "pic.h"
+
+#define XXH_INLINE_ALL 1
+#define XXH_NO_INLINE_HINTS 1
+#define XXH_STATIC_LINKING_ONLY 1
+#include "decoders/xxhash.h"
+
+CHECK_NARROWING();
+
+constexpr uint16_t FormatVersion = 1;
+constexpr uint16_t RecordSize    = 24;
+
+static struct {
+	CaptureWriter writer = {};
+
+	uint32_t num_frames = 0;
+} hashes = {};
+
+static void create_frame_hashes_file()
+{
+	const auto handle = CAPTURE_CreateFile(CaptureType::FrameHashes);
+	if (!handle) {
+		return;
+	}
+	hashes.writer.Open(handle);
+	hashes.num_frames = 0;
+
+	uint8_t header[8] = {'D', 'B', 'F', 'H'};
+	host_writew(&header[4], FormatVersion);
+	host_writew(&header[6], RecordSize);
+	hashes.writer.Write(header, sizeof(header));
+}
+
+static uint64_t hash_frame(const RenderedImage& image)
+{
+	const auto& src = image.params;
+
+	// PixelFormat's underlying value is the colour depth in bits
+	const auto bytes_per_pixel = (static_cast<int>(src.pixel_format) + 7) / 8;
+	const auto row_bytes = static_cast<size_t>(src.width * bytes_per_pixel);
+
+	XXH3_state_t state = {};
+	XXH3_64bits_reset(&state);
+
+	// Only the visible pixels; the padding at the end of the rows can
+	// hold anything
+	auto row = image.image_data;
+	for (auto y = 0; y < src.height; ++y, row += image.pitch) {
+		XXH3_64bits_update(&state, row, row_bytes);
+	}
+
+	if (image.is_paletted() && image.palette_data) {
+		constexpr auto PaletteNumBytes = 256 * 4;
+		XXH3_64bits_update(&state, image.palette_data, PaletteNumBytes);
+	}
+
+	return XXH3_64bits_digest(&state);
+}
+
+void capture_frame_hashes_add_frame(const RenderedImage& image)
+{
+	assert(image.image_data);
+
+	if (!hashes.writer.IsOpen()) {
+		create_frame_hashes_file();
+	}
+	if (!hashes.writer.IsOpen()) {
+		return;
+	}
+
+	const auto emulated_ms = PIC_FullIndex();
+
+	uint64_t emulated_ms_bits = 0;
+	static_assert(sizeof(emulated_ms_bits) == sizeof(emulated_ms));
+	std::memcpy(&emulated_ms_bits, &emulated_ms, sizeof(emulated_ms));
+
+	uint8_t record[RecordSize] = {};
+	host_writed(&record[0], hashes.num_frames++);
+	host_writew(&record[4], image.params.width);
+	host_writew(&record[6], image.params.height);
+	host_writeq(&record[8], emulated_ms_bits);
+	host_writeq(&record[16], hash_frame(image));
+
+	hashes.writer.Write(record, sizeof(record));
+}
+
+void capture_frame_hashes_finalise()
+{
+	if (!hashes.writer.IsOpen()) {
+		return;
+	}
+
+	if (const auto handle = hashes.writer.Close(); handle) {
+		fclose(handle);
+	}
+	LOG_MSG("CAPTURE: Logged the hashes of %u frames", hashes.num_frames);
+}
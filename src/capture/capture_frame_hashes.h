@@ -0,0 +1,55 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_CAPTURE_FRAME_HASHES_H
+#define DOSBOX_CAPTURE_FRAME_HASHES_H
+
+#include "render.h"
+
+// Frame hash log
+// ~~~~~~~~~~~~~~
+// Instead of saving images, the hash of every emulated frame is logged to a
+// compact binary file, so the logs of two runs can be compared to find
+// rendering regressions and determinism breaks. All values are little-endian.
+//
+// The file starts with an 8-byte header:
+//
+//   'DBFH'
+//   uint16 version (1)
+//   uint16 size of the records that follow (24)
+//
+// Then one record per frame:
+//
+//   uint32 frame number, starting from 0 with the first captured frame
+//   uint16 width
+//   uint16 height
+//   double emulated time in milliseconds
+//   uint64 XXH3 64-bit hash of the raw frame before scaling; the visible
+//          pixels row by row in the byte order described by PixelFormat,
+//          followed by the 256 * 4 bytes RGBX palette for paletted frames
+//
+// Note that the 16-bit pixel formats are stored in the host's byte order, so
+// their hashes are only comparable between hosts of the same endianness.
+
+void capture_frame_hashes_add_frame(const RenderedImage& image);
+
+void capture_frame_hashes_finalise();
+
+#endif
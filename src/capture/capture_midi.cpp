@@ -21,24 +21,20 @@
 
 #include "capture.h"
 
-#include <array>
 #include <cerrno>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 
+#include "capture_writer.h"
 #include "midi.h"
 #include "pic.h"
 #include "support.h"
 
 static struct {
-	FILE* handle = nullptr;
+	CaptureWriter writer = {};
 
-	std::array<uint8_t, 4 * 1024> buffer = {};
-
-	uint32_t bytes_used    = 0;
-	uint32_t bytes_written = 0;
-	uint32_t last_tick     = 0;
+	uint32_t last_tick = 0;
 } midi = {};
 
 // clang-format off
@@ -55,13 +51,7 @@ static uint8_t midi_header[] = {
 
 static void raw_midi_add(const uint8_t data)
 {
-	midi.buffer[midi.bytes_used++] = data;
-
-	if (midi.bytes_used >= midi.buffer.size()) {
-		midi.bytes_written += midi.bytes_used;
-		fwrite(midi.buffer.data(), 1, midi.buffer.size(), midi.handle);
-		midi.bytes_used = 0;
-	}
+	midi.writer.Write(&data, sizeof(data));
 }
 
 static void raw_midi_add_number(const uint32_t val)
@@ -80,20 +70,21 @@ static void raw_midi_add_number(const uint32_t val)
 
 static void create_midi_file()
 {
-	midi.handle = CAPTURE_CreateFile(CaptureType::Midi);
-	if (!midi.handle) {
+	const auto handle = CAPTURE_CreateFile(CaptureType::Midi);
+	if (!handle) {
 		return;
 	}
-	fwrite(midi_header, 1, sizeof(midi_header), midi.handle);
+	midi.writer.Open(handle);
+	midi.writer.Write(midi_header, sizeof(midi_header));
 	midi.last_tick = PIC_Ticks;
 }
 
 void capture_midi_add_data(const bool sysex, const size_t len, const uint8_t* data)
 {
-	if (!midi.handle) {
+	if (!midi.writer.IsOpen()) {
 		create_midi_file();
 	}
-	if (!midi.handle) {
+	if (!midi.writer.IsOpen()) {
 		return;
 	}
 
@@ -113,7 +104,7 @@ void capture_midi_add_data(const bool sysex, const size_t len, const uint8_t* da
 
 void capture_midi_finalise()
 {
-	if (!midi.handle) {
+	if (!midi.writer.IsOpen()) {
 		return;
 	}
 	// Delta time
@@ -124,29 +115,29 @@ void capture_midi_finalise()
 	raw_midi_add(0x2f);
 	raw_midi_add(0x00);
 
+	const auto bytes_written = static_cast<uint32_t>(
+	        midi.writer.GetNumBytesWritten() - sizeof(midi_header));
+
 	// Flush buffer
-	fwrite(midi.buffer.data(), 1, midi.bytes_used, midi.handle);
-	midi.bytes_written += midi.bytes_used;
+	const auto handle = midi.writer.Close();
 
 	constexpr auto midi_header_size_offset = 18;
-	if (fseek(midi.handle, midi_header_size_offset, SEEK_SET) != 0) {
+	if (fseek(handle, midi_header_size_offset, SEEK_SET) != 0) {
 		LOG_WARNING("CAPTURE: Failed to seek in captured MIDI file '%s'",
 		            safe_strerror(errno).c_str());
-		fclose(midi.handle);
-		midi = {};
+		fclose(handle);
 		return;
 	}
 
 	uint8_t size[4];
 
-	size[0] = (uint8_t)(midi.bytes_written >> 24);
-	size[1] = (uint8_t)(midi.bytes_written >> 16);
-	size[2] = (uint8_t)(midi.bytes_written >> 8);
-	size[3] = (uint8_t)(midi.bytes_written >> 0);
-	fwrite(&size, 1, 4, midi.handle);
+	size[0] = (uint8_t)(bytes_written >> 24);
+	size[1] = (uint8_t)(bytes_written >> 16);
+	size[2] = (uint8_t)(bytes_written >> 8);
+	size[3] = (uint8_t)(bytes_written >> 0);
+	fwrite(&size, 1, 4, handle);
 
-	fclose(midi.handle);
-	midi = {};
+	fclose(handle);
 	return;
 }
 
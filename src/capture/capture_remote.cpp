@@ -0,0 +1,1066 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "capture_remote.h"
+
+#include "logging.h"
+
+#if C_MODEM
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <zlib.h>
+
+#include "image/image_decoder.h"
+#include "keyboard.h"
+#include "mouse.h"
+#include "support.h"
+#include "thread_placement.h"
+#include "timer.h"
+#include "tracy.h"
+
+#include "../hardware/serialport/misc_util.h"
+
+// The latest frame as 0x00RRGGBB pixels, with the rows changed since the
+// server thread last took them. Written by the emulation thread.
+static struct {
+	std::mutex mutex                 = {};
+	std::condition_variable changed  = {};
+	int width                        = 0;
+	int height                       = 0;
+	std::vector<uint32_t> pixels     = {};
+	std::vector<uint8_t> dirty_rows  = {};
+	bool has_dirty_rows              = false;
+	bool needs_full_frame            = true;
+} shared_frame = {};
+
+struct RemoteInput {
+	bool is_pointer  = false;
+	uint32_t keysym  = 0;
+	bool is_pressed  = false;
+	int x            = 0;
+	int y            = 0;
+	uint8_t buttons  = 0;
+};
+
+// Filled by the server thread, drained on the emulation thread
+static std::mutex input_mutex               = {};
+static std::vector<RemoteInput> input_queue = {};
+
+static std::unique_ptr<TCPServerSocket> server = {};
+static std::thread server_thread               = {};
+static std::atomic_bool is_running             = false;
+static std::atomic_bool is_serving             = false;
+
+static void put_u8(std::vector<uint8_t>& out, const uint8_t val)
+{
+	out.push_back(val);
+}
+
+static void put_u16(std::vector<uint8_t>& out, const uint16_t val)
+{
+	out.push_back(static_cast<uint8_t>(val >> 8));
+	out.push_back(static_cast<uint8_t>(val));
+}
+
+static void put_u32(std::vector<uint8_t>& out, const uint32_t val)
+{
+	put_u16(out, static_cast<uint16_t>(val >> 16));
+	put_u16(out, static_cast<uint16_t>(val));
+}
+
+static uint16_t get_u16(const uint8_t* data)
+{
+	return static_cast<uint16_t>((data[0] << 8) | data[1]);
+}
+
+static uint32_t get_u32(const uint8_t* data)
+{
+	return (static_cast<uint32_t>(get_u16(data)) << 16) | get_u16(data + 2);
+}
+
+// ***************************************************************************
+// Input
+// ***************************************************************************
+
+struct KeysymMapping {
+	uint32_t keysym = 0;
+	KBD_KEYS key    = KBD_NONE;
+};
+
+// X11 keysyms as sent by the viewers. Shifted symbols are mapped to their
+// key on the US layout, as the viewer sends the shift key on its own.
+static constexpr KeysymMapping keysym_mappings[] = {
+        {'1', KBD_1}, {'!', KBD_1}, {'2', KBD_2}, {'@', KBD_2},
+        {'3', KBD_3}, {'#', KBD_3}, {'4', KBD_4}, {'$', KBD_4},
+        {'5', KBD_5}, {'%', KBD_5}, {'6', KBD_6}, {'^', KBD_6},
+        {'7', KBD_7}, {'&', KBD_7}, {'8', KBD_8}, {'*', KBD_8},
+        {'9', KBD_9}, {'(', KBD_9}, {'0', KBD_0}, {')', KBD_0},
+
+        {'q', KBD_q}, {'w', KBD_w}, {'e', KBD_e}, {'r', KBD_r},
+        {'t', KBD_t}, {'y', KBD_y}, {'u', KBD_u}, {'i', KBD_i},
+        {'o', KBD_o}, {'p', KBD_p}, {'a', KBD_a}, {'s', KBD_s},
+        {'d', KBD_d}, {'f', KBD_f}, {'g', KBD_g}, {'h', KBD_h},
+        {'j', KBD_j}, {'k', KBD_k}, {'l', KBD_l}, {'z', KBD_z},
+        {'x', KBD_x}, {'c', KBD_c}, {'v', KBD_v}, {'b', KBD_b},
+        {'n', KBD_n}, {'m', KBD_m},
+
+        {' ', KBD_space}, {'`', KBD_grave}, {'~', KBD_grave},
+        {'-', KBD_minus}, {'_', KBD_minus}, {'=', KBD_equals},
+        {'+', KBD_equals}, {'\\', KBD_backslash}, {'|', KBD_backslash},
+        {'[', KBD_leftbracket}, {'{', KBD_leftbracket},
+        {']', KBD_rightbracket}, {'}', KBD_rightbracket},
+        {';', KBD_semicolon}, {':', KBD_semicolon}, {'\'', KBD_quote},
+        {'"', KBD_quote}, {',', KBD_comma}, {'<', KBD_comma},
+        {'.', KBD_period}, {'>', KBD_period}, {'/', KBD_slash},
+        {'?', KBD_slash},
+
+        {0xff08, KBD_backspace}, {0xff09, KBD_tab}, {0xfe20, KBD_tab},
+        {0xff0d, KBD_enter}, {0xff13, KBD_pause}, {0xff14, KBD_scrolllock},
+        {0xff1b, KBD_esc}, {0xff61, KBD_printscreen}, {0xffff, KBD_delete},
+        {0xff50, KBD_home}, {0xff51, KBD_left}, {0xff52, KBD_up},
+        {0xff53, KBD_right}, {0xff54, KBD_down}, {0xff55, KBD_pageup},
+        {0xff56, KBD_pagedown}, {0xff57, KBD_end}, {0xff63, KBD_insert},
+        {0xff7f, KBD_numlock},
+
+        {0xff8d, KBD_kpenter}, {0xffaa, KBD_kpmultiply},
+        {0xffab, KBD_kpplus}, {0xffad, KBD_kpminus},
+        {0xffae, KBD_kpperiod}, {0xffaf, KBD_kpdivide},
+        {0xffb0, KBD_kp0}, {0xffb1, KBD_kp1}, {0xffb2, KBD_kp2},
+        {0xffb3, KBD_kp3}, {0xffb4, KBD_kp4}, {0xffb5, KBD_kp5},
+        {0xffb6, KBD_kp6}, {0xffb7, KBD_kp7}, {0xffb8, KBD_kp8},
+        {0xffb9, KBD_kp9},
+
+        {0xffbe, KBD_f1}, {0xffbf, KBD_f2}, {0xffc0, KBD_f3},
+        {0xffc1, KBD_f4}, {0xffc2, KBD_f5}, {0xffc3, KBD_f6},
+        {0xffc4, KBD_f7}, {0xffc5, KBD_f8}, {0xffc6, KBD_f9},
+        {0xffc7, KBD_f10}, {0xffc8, KBD_f11}, {0xffc9, KBD_f12},
+
+        {0xffe1, KBD_leftshift}, {0xffe2, KBD_rightshift},
+        {0xffe3, KBD_leftctrl}, {0xffe4, KBD_rightctrl},
+        {0xffe5, KBD_capslock}, {0xffe7, KBD_leftgui},
+        {0xffe8, KBD_rightgui}, {0xffe9, KBD_leftalt},
+        {0xffea, KBD_rightalt}, {0xffeb, KBD_leftgui},
+        {0xffec, KBD_rightgui}, {0xfe03, KBD_rightalt},
+};
+
+static KBD_KEYS to_key(uint32_t keysym)
+{
+	if (keysym < 0x80) {
+		keysym = static_cast<uint32_t>(tolower(static_cast<int>(keysym)));
+	}
+	for (const auto& mapping : keysym_mappings) {
+		if (mapping.keysym == keysym) {
+			return mapping.key;
+		}
+	}
+	return KBD_NONE;
+}
+
+static void move_and_click_mice(const RemoteInput& input)
+{
+	// The position the previous events were at, in pixels of the frame
+	static int last_x          = -1;
+	static int last_y          = -1;
+	static uint8_t last_buttons = 0;
+
+	constexpr MouseButtonId buttons[] = {MouseButtonId::Left,
+	                                     MouseButtonId::Middle,
+	                                     MouseButtonId::Right};
+
+	constexpr uint8_t WheelUpMask   = 1 << 3;
+	constexpr uint8_t WheelDownMask = 1 << 4;
+
+	const auto num_interfaces = static_cast<uint8_t>(MouseInterfaceId::Last) + 1;
+
+	for (uint8_t i = 0; i < num_interfaces; ++i) {
+		const auto interface_id = static_cast<MouseInterfaceId>(i);
+
+		if (last_x >= 0 && (input.x != last_x || input.y != last_y)) {
+			MOUSE_EventMoved(static_cast<float>(input.x - last_x),
+			                 static_cast<float>(input.y - last_y),
+			                 interface_id);
+		}
+		for (uint8_t b = 0; b < std::size(buttons); ++b) {
+			const auto mask = static_cast<uint8_t>(1 << b);
+			if ((input.buttons ^ last_buttons) & mask) {
+				MOUSE_EventButton(buttons[b],
+				                  input.buttons & mask,
+				                  interface_id);
+			}
+		}
+		const auto pressed = input.buttons & ~last_buttons;
+		if (pressed & WheelUpMask) {
+			MOUSE_EventWheel(-1, interface_id);
+		}
+		if (pressed & WheelDownMask) {
+			MOUSE_EventWheel(1, interface_id);
+		}
+	}
+	last_x       = input.x;
+	last_y       = input.y;
+	last_buttons = input.buttons;
+}
+
+static void feed_remote_input()
+{
+	static std::vector<RemoteInput> inputs = {};
+	{
+		std::lock_guard lock(input_mutex);
+		if (input_queue.empty()) {
+			return;
+		}
+		std::swap(inputs, input_queue);
+	}
+	for (const auto& input : inputs) {
+		if (input.is_pointer) {
+			move_and_click_mice(input);
+		} else if (const auto key = to_key(input.keysym); key != KBD_NONE) {
+			KEYBOARD_AddKey(key, input.is_pressed);
+		}
+	}
+	inputs.clear();
+}
+
+// ***************************************************************************
+// Frames
+// ***************************************************************************
+
+bool capture_remote_is_running()
+{
+	return is_running;
+}
+
+void capture_remote_add_frame(const RenderedImage& image)
+{
+	ZoneScoped;
+
+	const auto& src = image.params;
+
+	// Like the raw captures, serve the frames without the doubling that's
+	// baked into some of them
+	const auto row_skip_count   = static_cast<uint8_t>(src.rendered_double_scan ? 1 : 0);
+	const auto pixel_skip_count = static_cast<uint8_t>(src.rendered_pixel_doubling ? 1 : 0);
+
+	const auto width  = src.width / (pixel_skip_count + 1);
+	const auto height = src.height / (row_skip_count + 1);
+
+	std::unique_lock lock(shared_frame.mutex);
+	auto& frame = shared_frame;
+
+	if (frame.width != width || frame.height != height) {
+		frame.width  = width;
+		frame.height = height;
+		frame.pixels.assign(static_cast<size_t>(width) * height, 0);
+		frame.dirty_rows.assign(static_cast<size_t>(height), 0);
+		frame.needs_full_frame = true;
+	}
+
+	// Frames are only converted while a viewer is connected
+	if (!is_serving) {
+		frame.needs_full_frame = true;
+		return;
+	}
+
+	ImageDecoder decoder = {};
+	decoder.Init(image, row_skip_count, pixel_skip_count);
+
+	for (auto y = 0; y < height; ++y) {
+		auto is_changed = frame.needs_full_frame || !image.changed_rows;
+		for (auto i = 0; !is_changed && i <= row_skip_count; ++i) {
+			is_changed = image.changed_rows[y * (row_skip_count + 1) + i];
+		}
+		if (is_changed) {
+			auto pixel = frame.pixels.data() + static_cast<size_t>(y) * width;
+			for (auto x = 0; x < width; ++x) {
+				const auto rgb = decoder.GetNextPixelAsRgb888();
+				*pixel++ = static_cast<uint32_t>(
+				        (rgb.red << 16) | (rgb.green << 8) | rgb.blue);
+			}
+			frame.dirty_rows[static_cast<size_t>(y)] = 1;
+			frame.has_dirty_rows = true;
+		}
+		decoder.AdvanceRow();
+	}
+	frame.needs_full_frame = false;
+
+	const auto has_dirty_rows = frame.has_dirty_rows;
+	lock.unlock();
+
+	if (has_dirty_rows) {
+		frame.changed.notify_one();
+	}
+}
+
+// ***************************************************************************
+// Viewer sessions
+// ***************************************************************************
+
+// Named to not clash with the renderer's PixelFormat
+struct ViewerPixelFormat {
+	uint8_t bits_per_pixel = 32;
+	uint8_t depth          = 24;
+	bool is_big_endian     = false;
+	bool is_true_colour    = true;
+	uint16_t red_max       = 255;
+	uint16_t green_max     = 255;
+	uint16_t blue_max      = 255;
+	uint8_t red_shift      = 16;
+	uint8_t green_shift    = 8;
+	uint8_t blue_shift     = 0;
+
+	void Write(std::vector<uint8_t>& out) const
+	{
+		put_u8(out, bits_per_pixel);
+		put_u8(out, depth);
+		put_u8(out, is_big_endian ? 1 : 0);
+		put_u8(out, is_true_colour ? 1 : 0);
+		put_u16(out, red_max);
+		put_u16(out, green_max);
+		put_u16(out, blue_max);
+		put_u8(out, red_shift);
+		put_u8(out, green_shift);
+		put_u8(out, blue_shift);
+		out.insert(out.end(), 3, 0);
+	}
+
+	void Read(const uint8_t* data)
+	{
+		bits_per_pixel = data[0];
+		depth          = data[1];
+		is_big_endian  = data[2] != 0;
+		is_true_colour = data[3] != 0;
+		red_max        = get_u16(data + 4);
+		green_max      = get_u16(data + 6);
+		blue_max       = get_u16(data + 8);
+		red_shift      = data[10];
+		green_shift    = data[11];
+		blue_shift     = data[12];
+	}
+
+	bool IsSupported() const
+	{
+		return is_true_colour && (bits_per_pixel == 8 || bits_per_pixel == 16 ||
+		                          bits_per_pixel == 32);
+	}
+
+	uint32_t ToPixel(const uint32_t rgb) const
+	{
+		const auto scale = [](const uint32_t val, const uint16_t max) {
+			return (val * max + 127) / 255;
+		};
+		return (scale((rgb >> 16) & 0xff, red_max) << red_shift) |
+		       (scale((rgb >> 8) & 0xff, green_max) << green_shift) |
+		       (scale(rgb & 0xff, blue_max) << blue_shift);
+	}
+
+	uint8_t BytesPerPixel() const
+	{
+		return static_cast<uint8_t>(bits_per_pixel / 8);
+	}
+
+	// ZRLE sends 32-bit pixels that fit into 24 bits as 3 bytes
+	uint8_t BytesPerCompressedPixel() const
+	{
+		const auto max_pixel = ToPixel(0xffffff);
+		if (bits_per_pixel == 32 && depth <= 24 && max_pixel <= 0xffffff) {
+			return 3;
+		}
+		return BytesPerPixel();
+	}
+};
+
+static void put_pixel(std::vector<uint8_t>& out, const uint32_t pixel,
+                      const uint8_t num_bytes, const bool is_big_endian)
+{
+	for (uint8_t i = 0; i < num_bytes; ++i) {
+		const auto shift = is_big_endian ? (num_bytes - 1 - i) * 8 : i * 8;
+		out.push_back(static_cast<uint8_t>(pixel >> shift));
+	}
+}
+
+constexpr auto TileSize = 64;
+
+constexpr int32_t RawEncoding         = 0;
+constexpr int32_t ZrleEncoding        = 16;
+constexpr int32_t DesktopSizeEncoding = -223;
+
+class Viewer {
+public:
+	Viewer(NETClientSocket& _socket) : socket(_socket)
+	{
+		zlib_stream.zalloc = Z_NULL;
+		zlib_stream.zfree  = Z_NULL;
+		zlib_stream.opaque = Z_NULL;
+		is_zlib_ready = deflateInit(&zlib_stream, Z_BEST_SPEED) == Z_OK;
+	}
+
+	~Viewer()
+	{
+		if (is_zlib_ready) {
+			deflateEnd(&zlib_stream);
+		}
+	}
+
+	Viewer(const Viewer&)            = delete;
+	Viewer& operator=(const Viewer&) = delete;
+
+	void Run();
+
+private:
+	bool Receive();
+	size_t ProcessMessage(const uint8_t* data, const size_t num_bytes);
+	size_t ProcessHandshake(const uint8_t* data, const size_t num_bytes);
+	void SendServerInit();
+	void TakeFrameChanges();
+	void SendUpdate();
+	void EncodeTile(const int x, const int y, const int w, const int h,
+	                std::vector<uint8_t>& out);
+	void EncodeZrleTile(const int w, const int h, std::vector<uint8_t>& out);
+	bool Send(const std::vector<uint8_t>& data);
+
+	enum class Phase { Version, Security, ClientInit, Normal };
+
+	NETClientSocket& socket;
+	Phase phase            = Phase::Version;
+	int minor_version      = 8;
+	ViewerPixelFormat format = {};
+
+	bool can_zrle         = false;
+	bool can_desktop_size = false;
+
+	z_stream zlib_stream = {};
+	bool is_zlib_ready   = false;
+
+	std::vector<uint8_t> inbox = {};
+
+	// The frame as last taken from the emulation thread and as last sent
+	// to the viewer
+	int width                     = 0;
+	int height                    = 0;
+	std::vector<uint32_t> current = {};
+	std::vector<uint32_t> sent    = {};
+	std::vector<uint8_t> dirty_rows = {};
+
+	// The size the viewer knows about
+	int viewer_width  = 0;
+	int viewer_height = 0;
+
+	bool is_update_requested = false;
+	bool is_full_update      = false;
+	bool is_resized          = false;
+
+	// Scratch space for the tiles
+	std::vector<uint32_t> tile_pixels = {};
+	std::vector<uint8_t> tile_bytes   = {};
+	std::vector<uint8_t> compressed   = {};
+};
+
+bool Viewer::Send(const std::vector<uint8_t>& data)
+{
+	return data.empty() || socket.SendArray(data.data(), data.size());
+}
+
+bool Viewer::Receive()
+{
+	uint8_t buffer[4096];
+	auto num_bytes = sizeof(buffer);
+	if (!socket.ReceiveArray(buffer, num_bytes)) {
+		return false;
+	}
+	inbox.insert(inbox.end(), buffer, buffer + num_bytes);
+
+	size_t pos = 0;
+	while (pos < inbox.size()) {
+		const auto num_processed = phase == Phase::Normal
+		                                 ? ProcessMessage(inbox.data() + pos,
+		                                                  inbox.size() - pos)
+		                                 : ProcessHandshake(inbox.data() + pos,
+		                                                    inbox.size() - pos);
+		if (num_processed == 0) {
+			break;
+		}
+		pos += num_processed;
+	}
+	inbox.erase(inbox.begin(), inbox.begin() + static_cast<ptrdiff_t>(pos));
+	return socket.isopen;
+}
+
+size_t Viewer::ProcessHandshake(const uint8_t* data, const size_t num_bytes)
+{
+	std::vector<uint8_t> reply = {};
+
+	switch (phase) {
+	case Phase::Version: {
+		constexpr size_t VersionLength = 12;
+		if (num_bytes < VersionLength) {
+			return 0;
+		}
+		// "RFB 003.00x\n"; 3.3 only offers a fixed security type
+		minor_version = std::clamp(data[10] - '0', 3, 8);
+		if (minor_version < 7) {
+			minor_version = 3;
+			put_u32(reply, 1);
+			phase = Phase::ClientInit;
+		} else {
+			put_u8(reply, 1);
+			put_u8(reply, 1);
+			phase = Phase::Security;
+		}
+		Send(reply);
+		return VersionLength;
+	}
+	case Phase::Security:
+		if (data[0] != 1) {
+			socket.isopen = false;
+			return 0;
+		}
+		if (minor_version >= 8) {
+			put_u32(reply, 0);
+			Send(reply);
+		}
+		phase = Phase::ClientInit;
+		return 1;
+
+	case Phase::ClientInit:
+		// Whether to share the desktop; there's only one viewer anyway
+		SendServerInit();
+		phase = Phase::Normal;
+		return 1;
+
+	case Phase::Normal: break;
+	}
+	return 0;
+}
+
+void Viewer::SendServerInit()
+{
+	{
+		std::lock_guard lock(shared_frame.mutex);
+		width  = shared_frame.width;
+		height = shared_frame.height;
+	}
+	// The first frame hasn't been rendered yet
+	if (width == 0 || height == 0) {
+		width  = 640;
+		height = 400;
+	}
+	current.assign(static_cast<size_t>(width) * height, 0);
+	sent.assign(current.size(), 0);
+	dirty_rows.assign(static_cast<size_t>(height), 0);
+
+	viewer_width  = width;
+	viewer_height = height;
+
+	constexpr char Name[] = "DOSBox Staging";
+
+	std::vector<uint8_t> reply = {};
+	put_u16(reply, static_cast<uint16_t>(width));
+	put_u16(reply, static_cast<uint16_t>(height));
+	format.Write(reply);
+	put_u32(reply, sizeof(Name) - 1);
+	reply.insert(reply.end(), Name, Name + sizeof(Name) - 1);
+	Send(reply);
+
+	// Have the next frame converted in full
+	{
+		std::lock_guard lock(shared_frame.mutex);
+		shared_frame.needs_full_frame = true;
+	}
+	is_serving = true;
+}
+
+size_t Viewer::ProcessMessage(const uint8_t* data, const size_t num_bytes)
+{
+	auto queue_input = [](const RemoteInput& input) {
+		std::lock_guard lock(input_mutex);
+		input_queue.push_back(input);
+	};
+
+	switch (data[0]) {
+	case 0: // SetPixelFormat
+		if (num_bytes < 20) {
+			return 0;
+		}
+		format.Read(data + 4);
+		if (!format.IsSupported()) {
+			LOG_WARNING("CAPTURE: Remote display viewer asked for an unsupported "
+			            "pixel format, disconnecting");
+			socket.isopen = false;
+			return 0;
+		}
+		is_full_update = true;
+		return 20;
+
+	case 2: { // SetEncodings
+		if (num_bytes < 4) {
+			return 0;
+		}
+		const auto num_encodings = get_u16(data + 2);
+		const auto size          = 4 + num_encodings * size_t{4};
+		if (num_bytes < size) {
+			return 0;
+		}
+		can_zrle         = false;
+		can_desktop_size = false;
+		for (size_t i = 0; i < num_encodings; ++i) {
+			const auto encoding = static_cast<int32_t>(get_u32(data + 4 + i * 4));
+			if (encoding == ZrleEncoding) {
+				can_zrle = is_zlib_ready;
+			} else if (encoding == DesktopSizeEncoding) {
+				can_desktop_size = true;
+			}
+		}
+		return size;
+	}
+	case 3: // FramebufferUpdateRequest
+		if (num_bytes < 10) {
+			return 0;
+		}
+		// The requested area is ignored, all changes are sent
+		is_update_requested = true;
+		if (data[1] == 0) {
+			is_full_update = true;
+		}
+		return 10;
+
+	case 4: { // KeyEvent
+		if (num_bytes < 8) {
+			return 0;
+		}
+		RemoteInput input = {};
+		input.is_pressed  = data[1] != 0;
+		input.keysym      = get_u32(data + 4);
+		queue_input(input);
+		return 8;
+	}
+	case 5: { // PointerEvent
+		if (num_bytes < 6) {
+			return 0;
+		}
+		RemoteInput input = {};
+		input.is_pointer  = true;
+		input.buttons     = data[1];
+		input.x           = get_u16(data + 2);
+		input.y           = get_u16(data + 4);
+		queue_input(input);
+		return 6;
+	}
+	case 6: { // ClientCutText, ignored
+		if (num_bytes < 8) {
+			return 0;
+		}
+		const auto size = 8 + size_t{get_u32(data + 4)};
+		return num_bytes < size ? 0 : size;
+	}
+	default:
+		LOG_WARNING("CAPTURE: Unknown message %d from the remote display viewer, "
+		            "disconnecting",
+		            data[0]);
+		socket.isopen = false;
+		return 0;
+	}
+}
+
+void Viewer::TakeFrameChanges()
+{
+	std::lock_guard lock(shared_frame.mutex);
+	auto& frame = shared_frame;
+
+	if (frame.width != width || frame.height != height) {
+		if (frame.width == 0 || frame.height == 0) {
+			return;
+		}
+		width  = frame.width;
+		height = frame.height;
+		current.assign(frame.pixels.begin(), frame.pixels.end());
+		sent.assign(current.size(), 0);
+		dirty_rows.assign(static_cast<size_t>(height), 1);
+		is_resized = true;
+	}
+	if (!frame.has_dirty_rows) {
+		return;
+	}
+	for (auto y = 0; y < height; ++y) {
+		auto& is_dirty = frame.dirty_rows[static_cast<size_t>(y)];
+		if (is_dirty) {
+			const auto offset = static_cast<size_t>(y) * width;
+			std::copy_n(frame.pixels.begin() + static_cast<ptrdiff_t>(offset),
+			            width,
+			            current.begin() + static_cast<ptrdiff_t>(offset));
+			dirty_rows[static_cast<size_t>(y)] = 1;
+			is_dirty = 0;
+		}
+	}
+	frame.has_dirty_rows = false;
+}
+
+void Viewer::SendUpdate()
+{
+	ZoneScoped;
+
+	std::vector<uint8_t> rects = {};
+	uint16_t num_rects         = 0;
+
+	if (is_resized) {
+		if (can_desktop_size) {
+			put_u16(rects, 0);
+			put_u16(rects, 0);
+			put_u16(rects, static_cast<uint16_t>(width));
+			put_u16(rects, static_cast<uint16_t>(height));
+			put_u32(rects, static_cast<uint32_t>(DesktopSizeEncoding));
+			++num_rects;
+			viewer_width  = width;
+			viewer_height = height;
+		}
+		is_full_update = true;
+		is_resized     = false;
+	}
+
+	// Only what the viewer knows about can be sent
+	const auto visible_width  = std::min(width, viewer_width);
+	const auto visible_height = std::min(height, viewer_height);
+
+	for (auto y = 0; y < visible_height; y += TileSize) {
+		const auto h = std::min(TileSize, visible_height - y);
+
+		const auto first_row = dirty_rows.begin() + y;
+		if (!is_full_update && std::find(first_row, first_row + h, 1) ==
+		                               first_row + h) {
+			continue;
+		}
+		for (auto x = 0; x < visible_width; x += TileSize) {
+			const auto w = std::min(TileSize, visible_width - x);
+
+			auto is_changed = is_full_update;
+			for (auto row = y; !is_changed && row < y + h; ++row) {
+				const auto offset = static_cast<size_t>(row) * width + x;
+				is_changed = !std::equal(current.begin() + static_cast<ptrdiff_t>(offset),
+				                         current.begin() + static_cast<ptrdiff_t>(offset + w),
+				                         sent.begin() + static_cast<ptrdiff_t>(offset));
+			}
+			if (!is_changed) {
+				continue;
+			}
+			for (auto row = y; row < y + h; ++row) {
+				const auto offset = static_cast<ptrdiff_t>(row) * width + x;
+				std::copy_n(current.begin() + offset, w, sent.begin() + offset);
+			}
+			EncodeTile(x, y, w, h, rects);
+			++num_rects;
+		}
+	}
+	std::fill(dirty_rows.begin(), dirty_rows.end(), 0);
+
+	// Incremental updates are held back until something changes
+	if (num_rects == 0 && !is_full_update) {
+		return;
+	}
+	is_update_requested = false;
+	is_full_update      = false;
+
+	std::vector<uint8_t> message = {};
+	put_u8(message, 0);
+	put_u8(message, 0);
+	put_u16(message, num_rects);
+	message.insert(message.end(), rects.begin(), rects.end());
+	Send(message);
+}
+
+void Viewer::EncodeTile(const int x, const int y, const int w, const int h,
+                        std::vector<uint8_t>& out)
+{
+	put_u16(out, static_cast<uint16_t>(x));
+	put_u16(out, static_cast<uint16_t>(y));
+	put_u16(out, static_cast<uint16_t>(w));
+	put_u16(out, static_cast<uint16_t>(h));
+	put_u32(out, static_cast<uint32_t>(can_zrle ? ZrleEncoding : RawEncoding));
+
+	tile_pixels.clear();
+	for (auto row = y; row < y + h; ++row) {
+		const auto offset = static_cast<size_t>(row) * width + x;
+		for (auto i = 0; i < w; ++i) {
+			tile_pixels.push_back(format.ToPixel(current[offset + i]));
+		}
+	}
+
+	if (!can_zrle) {
+		for (const auto pixel : tile_pixels) {
+			put_pixel(out, pixel, format.BytesPerPixel(), format.is_big_endian);
+		}
+		return;
+	}
+
+	tile_bytes.clear();
+	EncodeZrleTile(w, h, tile_bytes);
+
+	// All rectangles share one zlib stream, flushed after each of them
+	compressed.resize(deflateBound(&zlib_stream, tile_bytes.size()) + 64);
+	zlib_stream.next_in   = tile_bytes.data();
+	zlib_stream.avail_in  = static_cast<uInt>(tile_bytes.size());
+	zlib_stream.next_out  = compressed.data();
+	zlib_stream.avail_out = static_cast<uInt>(compressed.size());
+	deflate(&zlib_stream, Z_SYNC_FLUSH);
+	assert(zlib_stream.avail_in == 0);
+
+	const auto num_compressed = compressed.size() - zlib_stream.avail_out;
+	put_u32(out, static_cast<uint32_t>(num_compressed));
+	out.insert(out.end(),
+	           compressed.begin(),
+	           compressed.begin() + static_cast<ptrdiff_t>(num_compressed));
+}
+
+static void put_run_length(std::vector<uint8_t>& out, size_t length)
+{
+	for (--length; length >= 255; length -= 255) {
+		put_u8(out, 255);
+	}
+	put_u8(out, static_cast<uint8_t>(length));
+}
+
+// Picks the smallest of the ZRLE subencodings by their estimated size
+void Viewer::EncodeZrleTile(const int w, const int h, std::vector<uint8_t>& out)
+{
+	const auto pixel_bytes   = format.BytesPerCompressedPixel();
+	const auto is_big_endian = format.is_big_endian;
+
+	constexpr size_t MaxPaletteSize = 127;
+
+	std::vector<uint32_t> palette = {};
+	size_t num_runs               = 0;
+	for (size_t i = 0; i < tile_pixels.size(); ++i) {
+		const auto pixel = tile_pixels[i];
+		if (i == 0 || pixel != tile_pixels[i - 1]) {
+			++num_runs;
+			if (palette.size() <= MaxPaletteSize &&
+			    std::find(palette.begin(), palette.end(), pixel) ==
+			            palette.end()) {
+				palette.push_back(pixel);
+			}
+		}
+	}
+	const auto num_pixels = tile_pixels.size();
+
+	if (palette.size() == 1) {
+		put_u8(out, 1);
+		put_pixel(out, palette[0], pixel_bytes, is_big_endian);
+		return;
+	}
+
+	const auto has_palette = palette.size() <= MaxPaletteSize;
+
+	const auto bits_per_index = palette.size() <= 2 ? 1
+	                          : palette.size() <= 4 ? 2
+	                                                : 4;
+
+	const auto raw_size   = num_pixels * pixel_bytes;
+	const auto rle_size   = num_runs * (pixel_bytes + 1u);
+	const auto packed_size = palette.size() * pixel_bytes +
+	                         static_cast<size_t>(h) *
+	                                 ((w * bits_per_index + 7) / 8);
+	const auto palette_rle_size = palette.size() * pixel_bytes + num_runs * 2;
+
+	auto index_of = [&](const uint32_t pixel) {
+		return static_cast<uint8_t>(
+		        std::find(palette.begin(), palette.end(), pixel) -
+		        palette.begin());
+	};
+
+	auto for_each_run = [&](auto&& write_run) {
+		size_t start = 0;
+		for (size_t i = 1; i <= num_pixels; ++i) {
+			if (i == num_pixels || tile_pixels[i] != tile_pixels[start]) {
+				write_run(tile_pixels[start], i - start);
+				start = i;
+			}
+		}
+	};
+
+	const auto best_size = std::min(
+	        {raw_size,
+	         rle_size,
+	         palette.size() <= 16 ? packed_size : raw_size,
+	         has_palette ? palette_rle_size : raw_size});
+
+	if (palette.size() <= 16 && packed_size == best_size) {
+		put_u8(out, static_cast<uint8_t>(palette.size()));
+		for (const auto pixel : palette) {
+			put_pixel(out, pixel, pixel_bytes, is_big_endian);
+		}
+		for (auto y = 0; y < h; ++y) {
+			uint8_t byte  = 0;
+			int num_bits  = 0;
+			for (auto x = 0; x < w; ++x) {
+				const auto index = index_of(
+				        tile_pixels[static_cast<size_t>(y * w + x)]);
+				byte = static_cast<uint8_t>((byte << bits_per_index) | index);
+				num_bits += bits_per_index;
+				if (num_bits == 8) {
+					put_u8(out, byte);
+					byte     = 0;
+					num_bits = 0;
+				}
+			}
+			if (num_bits) {
+				put_u8(out, static_cast<uint8_t>(byte << (8 - num_bits)));
+			}
+		}
+	} else if (has_palette && palette_rle_size == best_size) {
+		put_u8(out, static_cast<uint8_t>(128 + palette.size()));
+		for (const auto pixel : palette) {
+			put_pixel(out, pixel, pixel_bytes, is_big_endian);
+		}
+		for_each_run([&](const uint32_t pixel, const size_t length) {
+			const auto index = index_of(pixel);
+			if (length == 1) {
+				put_u8(out, index);
+			} else {
+				put_u8(out, static_cast<uint8_t>(index | 128));
+				put_run_length(out, length);
+			}
+		});
+	} else if (rle_size == best_size) {
+		put_u8(out, 128);
+		for_each_run([&](const uint32_t pixel, const size_t length) {
+			put_pixel(out, pixel, pixel_bytes, is_big_endian);
+			put_run_length(out, length);
+		});
+	} else {
+		put_u8(out, 0);
+		for (const auto pixel : tile_pixels) {
+			put_pixel(out, pixel, pixel_bytes, is_big_endian);
+		}
+	}
+}
+
+void Viewer::Run()
+{
+	std::vector<uint8_t> version = {};
+	constexpr char Version[]     = "RFB 003.008\n";
+	version.insert(version.end(), Version, Version + sizeof(Version) - 1);
+	Send(version);
+
+	while (is_running && socket.isopen) {
+		const auto num_buffered = inbox.size();
+		if (!Receive()) {
+			break;
+		}
+		if (phase == Phase::Normal) {
+			TakeFrameChanges();
+			if (is_update_requested) {
+				SendUpdate();
+			}
+		}
+		// Wait for the next frame unless the viewer is busy talking
+		if (inbox.size() == num_buffered) {
+			constexpr auto PollInterval = std::chrono::milliseconds(2);
+			std::unique_lock lock(shared_frame.mutex);
+			shared_frame.changed.wait_for(lock, PollInterval);
+		}
+	}
+	is_serving = false;
+}
+
+static void serve_viewers()
+{
+	THREAD_ApplyRole(ThreadRole::Video);
+
+	while (is_running) {
+		std::unique_ptr<NETClientSocket> socket(server->Accept());
+		if (!socket) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			continue;
+		}
+		char address[16] = {};
+		socket->GetRemoteAddressString(address);
+		LOG_MSG("CAPTURE: Remote display viewer connected from %s", address);
+
+		Viewer(*socket).Run();
+
+		LOG_MSG("CAPTURE: Remote display viewer disconnected");
+	}
+}
+
+bool capture_remote_start(const uint16_t port)
+{
+	capture_remote_stop();
+
+	server = std::make_unique<TCPServerSocket>(port);
+	if (!server->isopen) {
+		LOG_WARNING("CAPTURE: Can't listen on port %d for remote display viewers",
+		            port);
+		server = {};
+		return false;
+	}
+	TIMER_AddTickHandler(feed_remote_input);
+
+	is_running    = true;
+	server_thread = std::thread(serve_viewers);
+	set_thread_name(server_thread, "dosbox:remote");
+
+	LOG_MSG("CAPTURE: Serving the remote display on port %d", port);
+	return true;
+}
+
+void capture_remote_stop()
+{
+	if (!is_running) {
+		return;
+	}
+	is_running = false;
+	shared_frame.changed.notify_one();
+	if (server_thread.joinable()) {
+		server_thread.join();
+	}
+	server = {};
+	TIMER_DelTickHandler(feed_remote_input);
+
+	std::lock_guard lock(input_mutex);
+	input_queue.clear();
+}
+
+#else
+
+bool capture_remote_start(const uint16_t)
+{
+	LOG_WARNING("CAPTURE: Serving the remote display needs networking support");
+	return false;
+}
+
+void capture_remote_stop() {}
+
+bool capture_remote_is_running()
+{
+	return false;
+}
+
+void capture_remote_add_frame(const RenderedImage&) {}
+
+#endif // C_MODEM
@@ -0,0 +1,54 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_CAPTURE_REMOTE_H
+#define DOSBOX_CAPTURE_REMOTE_H
+
+#include <cstdint>
+
+#include "render.h"
+
+// Remote display
+// ~~~~~~~~~~~~~~
+// A VNC server (RFB protocol versions 3.3 to 3.8) serving the emulated
+// screen to one viewer at a time, e.g., for running headless instances.
+//
+// The raw frames are taken straight from the renderer at their native
+// resolution. Only the rows the renderer found changed are converted, and
+// only the 64x64 pixel tiles that differ from what the viewer has already
+// received are sent. They're sent as ZRLE (zlib compressed solid, palette
+// and run-length encoded tiles) if the viewer supports it, or as raw pixels
+// otherwise. Mode changes are announced with the DesktopSize pseudo-encoding.
+//
+// The viewer's key and pointer events are fed to the emulated keyboard and
+// mice. Keys are mapped by their US layout position.
+//
+// There is no authentication, so the port must only be reachable from
+// trusted networks.
+
+bool capture_remote_start(const uint16_t port);
+void capture_remote_stop();
+
+bool capture_remote_is_running();
+
+// Called from the emulation thread with every rendered frame
+void capture_remote_add_frame(const RenderedImage& image);
+
+#endif
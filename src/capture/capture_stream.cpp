@@ -0,0 +1,178 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "capture_stream.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+#include "logging.h"
+#include "mem.h"
+#include "string_utils.h"
+
+#if C_MODEM
+#include "../hardware/serialport/misc_util.h"
+#endif
+
+static struct {
+	FILE* file = nullptr;
+#if C_MODEM
+	std::unique_ptr<TCPClientSocket> socket = {};
+#endif
+	bool is_broken = false;
+} stream = {};
+
+static constexpr uint16_t FlagHasPalette = 1 << 0;
+
+#if C_MODEM
+static bool open_socket(const std::string& address)
+{
+	const auto colon = address.rfind(':');
+	if (colon == std::string::npos) {
+		return false;
+	}
+	const auto host = address.substr(0, colon);
+	const auto port = parse_int(address.substr(colon + 1));
+	if (host.empty() || !port || *port <= 0 || *port > UINT16_MAX) {
+		return false;
+	}
+	if (!NetWrapper_InitializeSDLNet()) {
+		return false;
+	}
+	stream.socket = std::make_unique<TCPClientSocket>(host.c_str(),
+	                                                  static_cast<uint16_t>(*port));
+	if (!stream.socket->isopen) {
+		stream.socket = {};
+		return false;
+	}
+	return true;
+}
+#endif
+
+bool capture_stream_open(const std::string& destination)
+{
+	capture_stream_close();
+
+	constexpr auto TcpPrefix = "tcp:";
+	if (destination.rfind(TcpPrefix, 0) == 0) {
+#if C_MODEM
+		if (!open_socket(destination.substr(std::strlen(TcpPrefix)))) {
+			LOG_WARNING("CAPTURE: Can't connect to '%s' for streaming video",
+			            destination.c_str());
+			return false;
+		}
+#else
+		LOG_WARNING("CAPTURE: Streaming video over TCP needs networking support");
+		return false;
+#endif
+	} else {
+		stream.file = fopen(destination.c_str(), "wb");
+		if (!stream.file) {
+			LOG_WARNING("CAPTURE: Can't open '%s' for streaming video",
+			            destination.c_str());
+			return false;
+		}
+	}
+	LOG_MSG("CAPTURE: Streaming video to '%s'", destination.c_str());
+	return true;
+}
+
+static void write_data(const void* data, const size_t num_bytes)
+{
+	if (stream.is_broken || num_bytes == 0) {
+		return;
+	}
+	bool ok = false;
+	if (stream.file) {
+		ok = fwrite(data, 1, num_bytes, stream.file) == num_bytes;
+	}
+#if C_MODEM
+	else if (stream.socket) {
+		ok = stream.socket->SendArray(static_cast<const uint8_t*>(data),
+		                              num_bytes);
+	}
+#endif
+	// The consumer went away; stop writing, but keep draining the frames
+	if (!ok) {
+		stream.is_broken = true;
+		LOG_WARNING("CAPTURE: Video stream closed by the receiving end");
+	}
+}
+
+static void write_chunk_header(const char* tag, const size_t num_bytes)
+{
+	uint8_t header[8] = {};
+	std::memcpy(header, tag, 4);
+	host_writed(&header[4], static_cast<uint32_t>(num_bytes));
+	write_data(header, sizeof(header));
+}
+
+void capture_stream_write_frame(const VideoFrameTask& frame)
+{
+	assert(frame.width > 0 && frame.height > 0);
+
+	const auto num_pixels = frame.width * frame.height;
+	const auto bytes_per_pixel = static_cast<uint8_t>(frame.pixels.size() /
+	                                                  num_pixels);
+
+	uint8_t header[12] = {};
+	host_writew(&header[0], frame.width);
+	host_writew(&header[2], frame.height);
+	header[4] = static_cast<uint8_t>(frame.pixel_format);
+	header[5] = bytes_per_pixel;
+	host_writew(&header[6], frame.has_palette ? FlagHasPalette : 0);
+	host_writed(&header[8],
+	            static_cast<uint32_t>(std::lround(frame.frames_per_second * 1000)));
+
+	const auto palette_bytes = frame.has_palette ? frame.palette.size() : 0;
+
+	write_chunk_header("DBVF",
+	                   sizeof(header) + palette_bytes + frame.pixels.size());
+	write_data(header, sizeof(header));
+	if (frame.has_palette) {
+		write_data(frame.palette.data(), frame.palette.size());
+	}
+	write_data(frame.pixels.data(), frame.pixels.size());
+
+	if (!frame.audio.empty()) {
+		uint8_t audio_header[4] = {};
+		host_writed(audio_header, frame.audio_sample_rate);
+
+		const auto audio_bytes = frame.audio.size() * sizeof(int16_t);
+		write_chunk_header("DBAF", sizeof(audio_header) + audio_bytes);
+		write_data(audio_header, sizeof(audio_header));
+		write_data(frame.audio.data(), audio_bytes);
+	}
+}
+
+void capture_stream_close()
+{
+	if (stream.file) {
+		fclose(stream.file);
+		stream.file = nullptr;
+	}
+#if C_MODEM
+	stream.socket = {};
+#endif
+	stream.is_broken = false;
+}
@@ -0,0 +1,60 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_CAPTURE_STREAM_H
+#define DOSBOX_CAPTURE_STREAM_H
+
+#include <string>
+
+#include "capture_video.h"
+
+// Raw video stream
+// ~~~~~~~~~~~~~~~~
+// Instead of ZMBV compressed AVI files, the video capture can write the raw
+// frames and audio to a file, a named pipe or a TCP connection, so external
+// encoders can consume them live.
+//
+// The stream is a series of chunks, each starting with a 4-character tag and
+// the size of the data that follows. All values are little-endian.
+//
+//  'DBVF' A video frame:
+//         uint16 width
+//         uint16 height
+//         uint8  pixel format (the PixelFormat value, which is the bit depth)
+//         uint8  bytes per pixel (24-bit pixels are padded to 4 bytes)
+//         uint16 flags (bit 0: a palette follows)
+//         uint32 frames per second * 1000
+//         [256 * 4 bytes RGBX palette]
+//         the pixels row by row, in the byte order described by PixelFormat
+//
+//  'DBAF' The audio captured since the previous frame:
+//         uint32 sample rate
+//         int16  left and right samples, interleaved
+//
+// The destination is opened as a file or named pipe, or as a TCP connection
+// if it's given as 'tcp:host:port'.
+bool capture_stream_open(const std::string& destination);
+
+// Called from the video encoder thread
+void capture_stream_write_frame(const VideoFrameTask& frame);
+
+void capture_stream_close();
+
+#endif
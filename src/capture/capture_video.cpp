@@ -20,14 +20,28 @@
  */
 
 #include "capture.h"
+#include "capture_stream.h"
+#include "capture_video.h"
+#include "capture_writer.h"
 
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cmath>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
 
+#include "cross.h"
 #include "math_utils.h"
 #include "mem.h"
 #include "render.h"
+#include "rwqueue.h"
+#include "string_utils.h"
 #include "support.h"
+#include "thread_placement.h"
+#include "tracy.h"
 
 #include "zmbv/zmbv.h"
 
@@ -36,10 +50,70 @@ static constexpr auto NumSampleFramesInBuffer = 16 * 1024;
 static constexpr auto SampleFrameSize  = 4;
 static constexpr auto NumAudioChannels = 2;
 
-static constexpr auto AviHeaderSize = 500;
+// The headers at the start of the file, padded with a JUNK chunk; they
+// include the OpenDML super indexes
+static constexpr auto AviHeaderSize = 16 * 1024;
+
+// Each RIFF segment is kept below 1 GB, as legacy players only read the
+// first one, and the OpenDML standard index offsets are 32-bit
+static constexpr uint64_t MaxAviSegmentSize = 1024 * 1024 * 1024;
+
+// Each segment adds one super index entry to each stream, so this allows
+// for 256 GB long videos
+static constexpr auto MaxAviSegments = 256;
+
+static constexpr auto AviSuperIndexSize = 24 + 16 * MaxAviSegments;
+
+// Frames waiting for the encoder; once it's that far behind, recording
+// blocks the emulation until it caught up
+static constexpr auto MaxQueuedFrames = 16;
+
+// Deflate levels; all of them result in standard ZMBV streams
+static constexpr auto FastCompressionLevel  = 1;
+static constexpr auto SmallCompressionLevel = 6;
+
+// Share of one core the encoder may be busy with in the auto compression
+// mode before the level is lowered, and below which it's raised again
+static constexpr auto MaxEncoderLoad = 0.10;
+static constexpr auto MinEncoderLoad = 0.03;
+
+// A chunk of the current RIFF segment for the OpenDML standard index
+struct AviIndexEntry {
+	// Absolute file position of the chunk data
+	uint64_t offset  = 0;
+	uint32_t size    = 0;
+	bool is_keyframe = false;
+};
+
+struct AviSuperIndexEntry {
+	// Absolute file position of the standard index chunk
+	uint64_t offset   = 0;
+	uint32_t size     = 0;
+	uint32_t duration = 0;
+};
+
+struct AviStream {
+	const char* chunk_id = nullptr;
+	const char* index_id = nullptr;
+
+	// The chunks of the current segment
+	std::vector<AviIndexEntry> entries = {};
+	uint32_t segment_duration          = 0;
+
+	std::vector<AviSuperIndexEntry> super_index = {};
+
+	// In frames for the video and sample frames for the audio
+	uint32_t length = 0;
+};
+
+struct AviSegment {
+	uint64_t riff_pos = 0;
+	uint64_t movi_end = 0;
+	uint64_t riff_end = 0;
+};
 
 static struct {
-	FILE* handle = nullptr;
+	CaptureWriter writer = {};
 
 	uint32_t frames          = 0;
 	VideoCodec* codec        = nullptr;
@@ -48,21 +122,61 @@ static struct {
 	PixelFormat pixel_format = {};
 	float frames_per_second  = 0.0f;
 
-	uint32_t written           = 0;
-	uint32_t buf_size          = 0;
-	std::vector<uint8_t> buf   = {};
-	std::vector<uint8_t> index = {};
-	uint32_t index_used        = 0;
+	uint32_t buf_size        = 0;
+	std::vector<uint8_t> buf = {};
+
+	// The file is written as OpenDML (AVI 2.0) RIFF segments with their
+	// standard indexes at the end of each 'movi' list, so the indexes
+	// never have to be written in one go. The first segment also gets a
+	// legacy 'idx1' index for older players.
+	AviStream video_stream = {};
+	AviStream audio_stream = {};
+
+	std::vector<AviSegment> segments = {};
+	std::vector<uint8_t> legacy_index = {};
+	uint32_t legacy_frames            = 0;
+	bool is_full                      = false;
 
 	struct {
 		int16_t buf[NumSampleFramesInBuffer][NumAudioChannels] = {};
 
 		uint32_t sample_rate     = 0;
 		uint32_t buf_frames_used = 0;
-		uint32_t bytes_written   = 0;
 	} audio = {};
+
+	// Raw frames are streamed instead of writing an AVI file
+	bool is_streaming = false;
+
+	// Only touched by the emulation thread
+	struct {
+		std_fs::path video_path = {};
+		int frames_until_next   = 0;
+		int num_saved           = 0;
+	} preview = {};
+
+	// Time the encoder was busy since the last keyframe
+	struct {
+		double busy_s  = 0.0;
+		int num_frames = 0;
+	} encoder_load = {};
 } video = {};
 
+static std::atomic<VideoCompression> compression = VideoCompression::Auto;
+
+static std::string stream_destination = {};
+
+static bool is_preview_enabled = false;
+
+// Compressing and writing the frames happens on the encoder thread, which
+// owns the codec, the output buffer and the AVI file while it's running.
+// The frames are compressed in order as each one is a delta of the previous
+// one, and the deflate stream runs across frames too.
+static RWQueue<VideoFrameTask> frame_fifo{MaxQueuedFrames};
+static std::thread encoder = {};
+
+static std::mutex free_frames_mutex          = {};
+static std::vector<VideoFrameTask> free_frames = {};
+
 static ZMBV_FORMAT to_zmbv_format(const PixelFormat format)
 {
 	switch (format) {
@@ -98,54 +212,405 @@ static uint8_t to_bytes_per_pixel(const ZMBV_FORMAT format)
 	return ZMBV_ToBytesPerPixel(format);
 }
 
-static void add_avi_chunk(const char* tag, const uint32_t size,
-                          const void* data, const uint32_t flags)
+static void append_fourcc(std::vector<uint8_t>& out, const char* fourcc)
+{
+	out.insert(out.end(), fourcc, fourcc + 4);
+}
+
+static void append_word(std::vector<uint8_t>& out, const uint16_t val)
+{
+	const auto pos = out.size();
+	out.resize(pos + sizeof(val));
+	host_writew(out.data() + pos, val);
+}
+
+static void append_dword(std::vector<uint8_t>& out, const uint32_t val)
+{
+	const auto pos = out.size();
+	out.resize(pos + sizeof(val));
+	host_writed(out.data() + pos, val);
+}
+
+static void append_qword(std::vector<uint8_t>& out, const uint64_t val)
+{
+	const auto pos = out.size();
+	out.resize(pos + sizeof(val));
+	host_writeq(out.data() + pos, val);
+}
+
+static uint64_t get_avi_file_pos()
+{
+	return video.writer.GetNumBytesWritten();
+}
+
+// Position of the 'movi' list header of the current segment
+static uint64_t get_movi_list_pos()
+{
+	assert(!video.segments.empty());
+	if (video.segments.size() == 1) {
+		return AviHeaderSize - 12;
+	}
+	return video.segments.back().riff_pos + 12;
+}
+
+// Size of the indexes yet to be written to the current segment
+static uint64_t get_pending_index_size()
+{
+	constexpr auto StandardIndexHeaderSize = 8 + 24;
+
+	uint64_t size = 0;
+	for (const auto stream : {&video.video_stream, &video.audio_stream}) {
+		size += StandardIndexHeaderSize + stream->entries.size() * 8;
+	}
+	if (video.segments.size() == 1) {
+		size += 8 + video.legacy_index.size();
+	}
+	return size;
+}
+
+static void start_avi_segment()
+{
+	video.segments.push_back({get_avi_file_pos(), 0, 0});
+
+	// The first segment starts with the headers, which are written when
+	// the capture is finished
+	if (video.segments.size() == 1) {
+		const std::vector<uint8_t> placeholder(AviHeaderSize, 0);
+		video.writer.Write(placeholder.data(), placeholder.size());
+		return;
+	}
+
+	// The sizes are filled in when the capture is finished
+	std::vector<uint8_t> header = {};
+	append_fourcc(header, "RIFF");
+	append_dword(header, 0);
+	append_fourcc(header, "AVIX");
+	append_fourcc(header, "LIST");
+	append_dword(header, 0);
+	append_fourcc(header, "movi");
+	video.writer.Write(header.data(), header.size());
+}
+
+static void write_standard_index(AviStream& stream)
+{
+	if (stream.entries.empty()) {
+		return;
+	}
+	const auto base_offset = video.segments.back().riff_pos;
+
+	std::vector<uint8_t> index = {};
+	append_fourcc(index, stream.index_id);
+	append_dword(index, check_cast<uint32_t>(24 + stream.entries.size() * 8));
+	append_word(index, 2);  // wLongsPerEntry
+	index.push_back(0);     // bIndexSubType
+	index.push_back(1);     // bIndexType, AVI_INDEX_OF_CHUNKS
+	append_dword(index, check_cast<uint32_t>(stream.entries.size()));
+	append_fourcc(index, stream.chunk_id);
+	append_qword(index, base_offset);
+	append_dword(index, 0); // dwReserved3
+
+	for (const auto& entry : stream.entries) {
+		// Bit 31 marks the delta frames
+		constexpr uint32_t DeltaFrameFlag = 1u << 31;
+		append_dword(index, check_cast<uint32_t>(entry.offset - base_offset));
+		append_dword(index, entry.size | (entry.is_keyframe ? 0 : DeltaFrameFlag));
+	}
+
+	stream.super_index.push_back({get_avi_file_pos(),
+	                              check_cast<uint32_t>(index.size()),
+	                              stream.segment_duration});
+	video.writer.Write(index.data(), index.size());
+
+	stream.entries.clear();
+	stream.segment_duration = 0;
+}
+
+static void finish_avi_segment()
+{
+	auto& segment = video.segments.back();
+
+	write_standard_index(video.video_stream);
+	write_standard_index(video.audio_stream);
+	segment.movi_end = get_avi_file_pos();
+
+	if (video.segments.size() == 1) {
+		std::vector<uint8_t> header = {};
+		append_fourcc(header, "idx1");
+		append_dword(header, check_cast<uint32_t>(video.legacy_index.size()));
+		video.writer.Write(header.data(), header.size());
+		video.writer.Write(video.legacy_index.data(), video.legacy_index.size());
+
+		video.legacy_index = {};
+	}
+	segment.riff_end = get_avi_file_pos();
+}
+
+static void add_avi_chunk(AviStream& stream, const uint32_t size,
+                          const void* data, const bool is_keyframe)
+{
+	const auto padded_size = (size + 1) & ~1u;
+
+	// Start a new RIFF segment before this one gets too large
+	const auto segment_size = get_avi_file_pos() - video.segments.back().riff_pos;
+	if (segment_size + get_pending_index_size() + 8 + padded_size + 16 >
+	    MaxAviSegmentSize) {
+		if (video.segments.size() == MaxAviSegments) {
+			if (!video.is_full) {
+				LOG_WARNING("CAPTURE: Video capture reached the maximum "
+				            "length, dropping the rest of it");
+				video.is_full = true;
+			}
+			return;
+		}
+		finish_avi_segment();
+		start_avi_segment();
+	}
+
+	const auto chunk_pos = get_avi_file_pos();
+
+	std::vector<uint8_t> header = {};
+	append_fourcc(header, stream.chunk_id);
+	append_dword(header, size);
+	video.writer.Write(header.data(), header.size());
+	video.writer.Write(data, size);
+	if (padded_size != size) {
+		constexpr uint8_t Padding = 0;
+		video.writer.Write(&Padding, 1);
+	}
+
+	stream.entries.push_back({chunk_pos + 8, size, is_keyframe});
+
+	const auto duration = (&stream == &video.video_stream)
+	                            ? 1
+	                            : size / SampleFrameSize;
+	stream.segment_duration += duration;
+	stream.length += duration;
+
+	// The legacy index only covers the first segment. Its offsets are
+	// relative to the 'movi' list type.
+	if (video.segments.size() == 1) {
+		constexpr uint32_t KeyframeFlag = 0x10;
+
+		auto& index = video.legacy_index;
+		append_fourcc(index, stream.chunk_id);
+		append_dword(index, is_keyframe ? KeyframeFlag : 0);
+		append_dword(index, check_cast<uint32_t>(chunk_pos - (get_movi_list_pos() + 8)));
+		append_dword(index, size);
+
+		if (&stream == &video.video_stream) {
+			++video.legacy_frames;
+		}
+	}
+}
+
+static VideoFrameTask get_free_frame()
+{
+	std::lock_guard<std::mutex> lock(free_frames_mutex);
+	if (free_frames.empty()) {
+		return {};
+	}
+	auto frame = std::move(free_frames.back());
+	free_frames.pop_back();
+	return frame;
+}
+
+static void recycle_frame(VideoFrameTask&& frame)
+{
+	std::lock_guard<std::mutex> lock(free_frames_mutex);
+	free_frames.emplace_back(std::move(frame));
+}
+
+void capture_video_set_compression(const VideoCompression new_compression)
+{
+	compression = new_compression;
+}
+
+// The compression level can only change with a keyframe
+static void update_compression_level()
+{
+	switch (compression) {
+	case VideoCompression::Fast:
+		video.codec->SetCompressionLevel(FastCompressionLevel);
+		break;
+	case VideoCompression::Small:
+		video.codec->SetCompressionLevel(SmallCompressionLevel);
+		break;
+	case VideoCompression::Auto: {
+		auto& load = video.encoder_load;
+		if (load.num_frames == 0 || video.frames_per_second <= 0.0f) {
+			break;
+		}
+		const auto elapsed_s = load.num_frames / video.frames_per_second;
+		const auto busy_share = load.busy_s / elapsed_s;
+
+		auto level = video.codec->GetCompressionLevel();
+		if (busy_share > MaxEncoderLoad) {
+			level = std::max(level - 2, FastCompressionLevel);
+		} else if (busy_share < MinEncoderLoad) {
+			level = std::min(level + 1, SmallCompressionLevel);
+		}
+		video.codec->SetCompressionLevel(level);
+		break;
+	}
+	}
+	video.encoder_load = {};
+}
+
+static void encode_frame(const VideoFrameTask& frame)
 {
-	uint8_t chunk[8] = {};
+	ZoneScoped;
+	const auto codec_flags = (video.frames % 300 == 0) ? 1 : 0;
+	if (codec_flags & 1) {
+		update_compression_level();
+	}
+
+	if (!video.codec->PrepareCompressFrame(codec_flags,
+	                                       to_zmbv_format(frame.pixel_format),
+	                                       frame.has_palette
+	                                               ? frame.palette.data()
+	                                               : nullptr,
+	                                       video.buf.data(),
+	                                       video.buf_size)) {
+		return;
+	}
 
-	chunk[0] = tag[0];
-	chunk[1] = tag[1];
-	chunk[2] = tag[2];
-	chunk[3] = tag[3];
+	if (!frame.changed_rows.empty()) {
+		video.codec->SetChangedLines(frame.changed_rows.data());
+	}
+
+	const auto row_bytes = frame.pixels.size() / frame.height;
+	for (auto i = 0; i < frame.height; ++i) {
+		const uint8_t* row = frame.pixels.data() + i * row_bytes;
+		video.codec->CompressLines(1, &row);
+	}
 
-	host_writed(&chunk[4], size);
+	const auto written = video.codec->FinishCompressFrame();
+	if (written < 0) {
+		return;
+	}
 
-	// Write the actual data
-	fwrite(chunk, 1, 8, video.handle);
+	add_avi_chunk(video.video_stream,
+	              check_cast<uint32_t>(written),
+	              video.buf.data(),
+	              codec_flags & 1);
+	video.frames++;
+}
+
+static void encode_queued_frames()
+{
+	THREAD_ApplyRole(ThreadRole::Video);
+
+	while (auto frame = frame_fifo.Dequeue()) {
+		if (video.is_streaming) {
+			capture_stream_write_frame(*frame);
+			recycle_frame(std::move(*frame));
+			continue;
+		}
+		const auto start = std::chrono::steady_clock::now();
 
-	auto writesize = (size + 1) & ~1;
-	fwrite(data, 1, writesize, video.handle);
+		encode_frame(*frame);
 
-	auto pos = video.written + 4;
-	video.written += writesize + 8;
+		if (!frame->audio.empty()) {
+			const auto num_bytes = check_cast<uint32_t>(
+			        frame->audio.size() * sizeof(int16_t));
 
-	if (video.index_used + 16 >= video.index.size()) {
-		video.index.resize(video.index.size() + 16 * 4096);
+			add_avi_chunk(video.audio_stream, num_bytes, frame->audio.data(), true);
+		}
+
+		const std::chrono::duration<double> busy =
+		        std::chrono::steady_clock::now() - start;
+		video.encoder_load.busy_s += busy.count();
+		++video.encoder_load.num_frames;
+
+		recycle_frame(std::move(*frame));
 	}
+}
+
+static void start_encoder()
+{
+	frame_fifo.Start();
+	encoder = std::thread(encode_queued_frames);
+	set_thread_name(encoder, "dosbox:vidcap");
+}
 
-	auto index = video.index.data() + video.index_used;
-	video.index_used += 16;
+// Waits until the encoder has written all queued frames
+static void stop_encoder()
+{
+	frame_fifo.Stop();
+	if (encoder.joinable()) {
+		encoder.join();
+	}
+}
+
+void capture_video_set_stream(const std::string& destination)
+{
+	stream_destination = destination;
+}
+
+void capture_video_set_preview(const bool enabled)
+{
+	is_preview_enabled = enabled;
+}
+
+std::optional<std_fs::path> capture_video_get_next_preview_path(const float frames_per_second)
+{
+	if (!is_preview_enabled || !video.writer.IsOpen()) {
+		return {};
+	}
+
+	auto& preview = video.preview;
+	if (preview.frames_until_next > 0) {
+		--preview.frames_until_next;
+		return {};
+	}
+	preview.frames_until_next = std::max(iround(frames_per_second), 1) - 1;
+
+	// E.g., 'video0001-preview0001.png' for 'video0001.avi'
+	auto path = preview.video_path;
+	path.replace_filename(format_str("%s-preview%04d.png",
+	                                 preview.video_path.stem().string().c_str(),
+	                                 ++preview.num_saved));
+	return path;
+}
+
+static void start_streaming()
+{
+	if (!capture_stream_open(stream_destination)) {
+		return;
+	}
+	video.is_streaming          = true;
+	video.audio.buf_frames_used = 0;
 
-	index[0] = tag[0];
-	index[1] = tag[1];
-	index[2] = tag[2];
-	index[3] = tag[3];
+	start_encoder();
+}
 
-	host_writed(index + 4, flags);
-	host_writed(index + 8, pos);
-	host_writed(index + 12, size);
+static bool is_capturing()
+{
+	return video.writer.IsOpen() || video.is_streaming;
 }
 
 void capture_video_finalise()
 {
-	if (!video.handle) {
+	if (video.is_streaming) {
+		stop_encoder();
+		capture_stream_close();
+		video.is_streaming = false;
 		return;
 	}
+	if (!video.writer.IsOpen()) {
+		return;
+	}
+	stop_encoder();
+
 	if (video.codec) {
 		video.codec->FinishVideo();
 	}
 
-	uint8_t avi_header[AviHeaderSize];
+	// Only the indexes of the last segment are left to be written
+	finish_avi_segment();
+	const auto handle = video.writer.Close();
+
+	std::vector<uint8_t> avi_header(AviHeaderSize, 0);
 	uint32_t header_pos = 0;
 
 #define AVIOUT4(_S_) \
@@ -157,10 +622,39 @@ void capture_video_finalise()
 #define AVIOUTd(_S_) \
 	host_writed(&avi_header[header_pos], _S_); \
 	header_pos += 4;
+#define AVIOUTq(_S_) \
+	host_writeq(&avi_header[header_pos], _S_); \
+	header_pos += 8;
+
+	// The OpenDML super index of a stream, pointing to the standard index
+	// of each segment
+	auto write_super_index = [&](const AviStream& stream) {
+		const auto end_pos = header_pos + 8 + AviSuperIndexSize;
+
+		AVIOUT4("indx");
+		AVIOUTd(AviSuperIndexSize);
+		AVIOUTw(4); /* LongsPerEntry */
+		avi_header[header_pos++] = 0; /* IndexSubType */
+		avi_header[header_pos++] = 0; /* IndexType, AVI_INDEX_OF_INDEXES */
+		AVIOUTd(check_cast<uint32_t>(stream.super_index.size())); /* EntriesInUse */
+		AVIOUT4(stream.chunk_id); /* ChunkId */
+		AVIOUTd(0);
+		AVIOUTd(0);
+		AVIOUTd(0);
+		for (const auto& entry : stream.super_index) {
+			AVIOUTq(entry.offset);
+			AVIOUTd(entry.size);
+			AVIOUTd(entry.duration);
+		}
+		// The unused entries stay zeroed
+		header_pos = end_pos;
+	};
+
+	const auto& first_segment = video.segments.front();
 
 	// Try and write an avi header
 	AVIOUT4("RIFF"); // Riff header
-	AVIOUTd(AviHeaderSize + video.written - 8 + video.index_used);
+	AVIOUTd(check_cast<uint32_t>(first_segment.riff_end - 8));
 	AVIOUT4("AVI ");
 	AVIOUT4("LIST");
 
@@ -177,7 +671,7 @@ void capture_video_finalise()
 	AVIOUTd(0);
 	AVIOUTd(0);            /* PaddingGranularity (whatever that might be) */
 	AVIOUTd(0x110);        /* Flags,0x10 has index, 0x100 interleaved */
-	AVIOUTd(video.frames); /* TotalFrames */
+	AVIOUTd(video.legacy_frames); /* TotalFrames in the first segment */
 	AVIOUTd(0);            /* InitialFrames */
 	AVIOUTd(2);            /* Stream count */
 	AVIOUTd(0);            /* SuggestedBufferSize */
@@ -190,7 +684,7 @@ void capture_video_finalise()
 
 	// Video stream list
 	AVIOUT4("LIST");
-	AVIOUTd(4 + 8 + 56 + 8 + 40); /* Size of the list */
+	AVIOUTd(4 + 8 + 56 + 8 + 40 + 8 + AviSuperIndexSize); /* Size of the list */
 	AVIOUT4("strl");
 
 	// Video stream header
@@ -205,8 +699,8 @@ void capture_video_finalise()
 
 	/* Rate: Rate/Scale == samples/second */
 	AVIOUTd((uint32_t)(1000000 * video.frames_per_second));
-	AVIOUTd(0);            /* Start */
-	AVIOUTd(video.frames); /* Length */
+	AVIOUTd(0);                         /* Start */
+	AVIOUTd(video.video_stream.length); /* Length */
 	AVIOUTd(0);            /* SuggestedBufferSize */
 	AVIOUTd(~0);           /* Quality */
 	AVIOUTd(0);            /* SampleSize */
@@ -230,9 +724,11 @@ void capture_video_finalise()
 	AVIOUTd(0); /* ClrUsed: Number of colors used */
 	AVIOUTd(0); /* ClrImportant: Number of colors important */
 
+	write_super_index(video.video_stream);
+
 	// Audio stream list
 	AVIOUT4("LIST");
-	AVIOUTd(4 + 8 + 56 + 8 + 16); /* Length of list in bytes */
+	AVIOUTd(4 + 8 + 56 + 8 + 16 + 8 + AviSuperIndexSize); /* Length of list in bytes */
 	AVIOUT4("strl");
 
 	// The audio stream header
@@ -253,7 +749,7 @@ void capture_video_finalise()
 		video.audio.sample_rate = 1;
 	}
 
-	AVIOUTd(video.audio.bytes_written / SampleFrameSize); /* Length */
+	AVIOUTd(video.audio_stream.length); /* Length */
 	AVIOUTd(0);               /* SuggestedBufferSize */
 	AVIOUTd(~0);              /* Quality */
 	AVIOUTd(SampleFrameSize); /* SampleSize */
@@ -270,6 +766,17 @@ void capture_video_finalise()
 	AVIOUTw(4);                                         /* BlockAlign */
 	AVIOUTw(16);                                        /* BitsPerSample */
 
+	write_super_index(video.audio_stream);
+
+	// The OpenDML extended header with the total number of frames
+	AVIOUT4("LIST");
+	AVIOUTd(4 + 8 + 248);
+	AVIOUT4("odml");
+	AVIOUT4("dmlh");
+	AVIOUTd(248);
+	AVIOUTd(video.video_stream.length); /* TotalFrames */
+	header_pos += 244;
+
 	int nmain = header_pos - main_list - 4;
 
 	// Finish stream list, i.e. put number of bytes in the list to
@@ -285,27 +792,47 @@ void capture_video_finalise()
 	AVIOUT4("LIST");
 
 	// Length of list in bytes
-	AVIOUTd(video.written + 4);
+	AVIOUTd(check_cast<uint32_t>(first_segment.movi_end - (AviHeaderSize - 12) - 8));
 	AVIOUT4("movi");
 
-	// First add the index table to the end
-	memcpy(video.index.data(), "idx1", 4);
-	host_writed(video.index.data() + 4, video.index_used - 8);
-	fwrite(video.index.data(), 1, video.index_used, video.handle);
+#undef AVIOUT4
+#undef AVIOUTw
+#undef AVIOUTd
+#undef AVIOUTq
+
+	if (handle) {
+		fseek(handle, 0, SEEK_SET);
+		fwrite(avi_header.data(), 1, AviHeaderSize, handle);
+
+		// Fill in the sizes of the other segments
+		for (size_t i = 1; i < video.segments.size(); ++i) {
+			const auto& segment = video.segments[i];
 
-	fseek(video.handle, 0, SEEK_SET);
-	fwrite(&avi_header, 1, AviHeaderSize, video.handle);
+			uint8_t size[4] = {};
+			host_writed(size, check_cast<uint32_t>(segment.riff_end - segment.riff_pos - 8));
+			cross_fseeko(handle, static_cast<off_t>(segment.riff_pos + 4), SEEK_SET);
+			fwrite(size, 1, sizeof(size), handle);
 
-	fclose(video.handle);
+			const auto movi_pos = segment.riff_pos + 12;
+			host_writed(size, check_cast<uint32_t>(segment.movi_end - movi_pos - 8));
+			cross_fseeko(handle, static_cast<off_t>(movi_pos + 4), SEEK_SET);
+			fwrite(size, 1, sizeof(size), handle);
+		}
+		fclose(handle);
+	}
 	delete video.codec;
-	video.handle = nullptr;
+	video.codec = nullptr;
+
+	video.segments     = {};
+	video.video_stream = {};
+	video.audio_stream = {};
 }
 
 void capture_video_add_audio_data(const uint32_t sample_rate,
                                   const uint32_t num_sample_frames,
                                   const int16_t* sample_frames)
 {
-	if (!video.handle) {
+	if (!is_capturing()) {
 		return;
 	}
 	auto frames_left = NumSampleFramesInBuffer - video.audio.buf_frames_used;
@@ -325,34 +852,50 @@ static void create_avi_file(const uint16_t width, const uint16_t height,
                             const PixelFormat pixel_format,
                             const float frames_per_second, ZMBV_FORMAT format)
 {
-	video.handle = CAPTURE_CreateFile(CaptureType::Video);
-	if (!video.handle) {
+	const auto path = generate_capture_filename(
+	        CaptureType::Video, get_next_capture_index(CaptureType::Video));
+
+	const auto handle = CAPTURE_CreateFile(CaptureType::Video, path);
+	if (!handle) {
 		return;
 	}
 	video.codec = new VideoCodec();
 	if (!video.codec->SetupCompress(width, height)) {
+		fclose(handle);
+		delete video.codec;
+		video.codec = nullptr;
 		return;
 	}
 
 	video.buf_size = video.codec->NeededSize(width, height, format);
 	video.buf.resize(video.buf_size);
 
-	video.index.resize(16 * 4096);
-	video.index_used = 8;
-
 	video.width             = width;
 	video.height            = height;
 	video.pixel_format      = pixel_format;
 	video.frames_per_second = frames_per_second;
 
-	for (auto i = 0; i < AviHeaderSize; ++i) {
-		fputc(0, video.handle);
-	}
-
 	video.frames                = 0;
-	video.written               = 0;
 	video.audio.buf_frames_used = 0;
-	video.audio.bytes_written   = 0;
+	video.encoder_load          = {};
+
+	video.video_stream = {"00dc", "ix00"};
+	video.audio_stream = {"01wb", "ix01"};
+
+	video.segments      = {};
+	video.legacy_index  = {};
+	video.legacy_frames = 0;
+	video.is_full       = false;
+
+	video.writer.Open(handle);
+	start_avi_segment();
+
+	video.preview = {path, 0, 0};
+	if (is_preview_enabled) {
+		LOG_MSG("CAPTURE: Saving a preview image of the video every second");
+	}
+
+	start_encoder();
 }
 
 // Performs some transforms on the passed down rendered image to make sure
@@ -379,7 +922,7 @@ static void create_avi_file(const uint16_t width, const uint16_t height,
 // artifacts (so 320x200 is rendered as 640x200, and 640x200 as 1280x200).
 // These are written as-is, otherwise we'd be losing information.
 //
-static void compress_raw_frame(const RenderedImage& image)
+static void copy_raw_frame(const RenderedImage& image, VideoFrameTask& frame)
 {
 	const auto& src = image.params;
 	auto src_row    = image.image_data;
@@ -395,47 +938,40 @@ static void compress_raw_frame(const RenderedImage& image)
 
 	const auto pixel_skip_count = (src.rendered_pixel_doubling ? 1 : 0);
 
-	auto compress_row = [&](const uint8_t* row_buffer) {
-		video.codec->CompressLines(1, &row_buffer);
-	};
-
 	const auto src_bpp = to_bytes_per_pixel(src.pixel_format);
 	const auto dest_bpp = to_bytes_per_pixel(to_zmbv_format(src.pixel_format));
 
-	// Maybe compress the source rows straight away without copying. Note
-	// that this is a shortcut scenario; hard-code it to false to exercise
-	// the rote version below.
+	const auto dest_row_bytes = static_cast<size_t>(raw_width * dest_bpp);
+	frame.pixels.resize(dest_row_bytes * raw_height);
+	auto dest_row = frame.pixels.data();
+
+	// Copy the source rows straight away if their layout already matches.
+	// Note that this is a shortcut scenario; hard-code it to false to
+	// exercise the rote version below.
 
-	const auto can_use_src_directly = (src_bpp == dest_bpp &&
-	                                   pixel_skip_count == 0);
-	if (can_use_src_directly) {
+	const auto can_copy_rows = (src_bpp == dest_bpp && pixel_skip_count == 0);
+	if (can_copy_rows) {
 		for (auto i = 0; i < raw_height; ++i, src_row += src_pitch) {
-			compress_row(src_row);
+			std::memcpy(dest_row, src_row, dest_row_bytes);
+			dest_row += dest_row_bytes;
 		}
 		return;
 	}
 
-	// Otherwise we need to arrange the source bytes before compressing
-	assert(!can_use_src_directly);
-
-	// Grow the target row buffer if needed
-	const auto dest_row_bytes = check_cast<uint16_t>(src.width * dest_bpp);
-	static std::vector<uint8_t> dest_row = {};
-	if (dest_row.size() < dest_row_bytes) {
-		dest_row.resize(dest_row_bytes, 0);
-	}
+	// Otherwise we need to arrange the source bytes row by row
+	assert(!can_copy_rows);
 
 	const auto src_advance = src_bpp * (pixel_skip_count + 1);
 
 	for (auto i = 0; i < raw_height; ++i, src_row += src_pitch) {
 		auto src_pixel  = src_row;
-		auto dest_pixel = dest_row.data();
+		auto dest_pixel = dest_row;
 
 		for (auto j = 0; j < raw_width; ++j, src_pixel += src_advance) {
 			std::memcpy(dest_pixel, src_pixel, src_bpp);
 			dest_pixel += dest_bpp;
 		}
-		compress_row(dest_row.data());
+		dest_row += dest_row_bytes;
 	}
 }
 
@@ -454,56 +990,61 @@ void capture_video_add_frame(const RenderedImage& image, const float frames_per_
 	const auto raw_height = check_cast<uint16_t>(
 	        src.height / (src.rendered_double_scan ? 2 : 1));
 
-	// Disable capturing if any of the test fails
-	if (video.handle && (video.width != raw_width || video.height != raw_height ||
+	// Start a new file if any of the test fails; the stream describes
+	// every frame, so it can go on
+	if (video.writer.IsOpen() && (video.width != raw_width || video.height != raw_height ||
 	                     video.pixel_format != src.pixel_format ||
 	                     video.frames_per_second != frames_per_second)) {
 		capture_video_finalise();
 	}
 
-	const auto zmbv_format = to_zmbv_format(src.pixel_format);
-
-	if (!video.handle) {
-		create_avi_file(raw_width,
-		                raw_height,
-		                src.pixel_format,
-		                frames_per_second,
-		                zmbv_format);
+	if (!is_capturing()) {
+		if (stream_destination.empty()) {
+			create_avi_file(raw_width,
+			                raw_height,
+			                src.pixel_format,
+			                frames_per_second,
+			                to_zmbv_format(src.pixel_format));
+		} else {
+			start_streaming();
+		}
 	}
-	if (!video.handle) {
+	if (!is_capturing() || raw_width == 0 || raw_height == 0) {
 		return;
 	}
 
-	const auto codec_flags = (video.frames % 300 == 0) ? 1 : 0;
+	// Everything the encoder needs gets copied, the image is only valid
+	// during this call
+	auto frame = get_free_frame();
 
-	if (!video.codec->PrepareCompressFrame(codec_flags,
-	                                       zmbv_format,
-	                                       image.palette_data,
-	                                       video.buf.data(),
-	                                       video.buf_size)) {
-		return;
-	}
+	frame.pixel_format      = src.pixel_format;
+	frame.width             = raw_width;
+	frame.height            = raw_height;
+	frame.frames_per_second = frames_per_second;
 
-	compress_raw_frame(image);
+	copy_raw_frame(image, frame);
 
-	const auto written = video.codec->FinishCompressFrame();
-	if (written < 0) {
-		return;
+	frame.has_palette = (image.palette_data != nullptr);
+	if (frame.has_palette) {
+		std::memcpy(frame.palette.data(), image.palette_data, frame.palette.size());
 	}
 
-	add_avi_chunk("00dc", written, video.buf.data(), codec_flags & 1 ? 0x10 : 0x0);
-	video.frames++;
+	// Let the codec skip comparing the rows the renderer already found to
+	// be unchanged
+	frame.changed_rows.clear();
+	if (image.changed_rows) {
+		const auto row_step = src.rendered_double_scan ? 2 : 1;
+		frame.changed_rows.resize(raw_height);
+		for (auto i = 0; i < raw_height; ++i) {
+			frame.changed_rows[i] = image.changed_rows[i * row_step];
+		}
+	}
 
-	//		LOG_MSG("CAPTURE: Frame %d video %d audio
-	//%d",video.frames, written, video.audio_buf_frames_used *4 );
-	if (video.audio.buf_frames_used) {
-		add_avi_chunk("01wb",
-		              video.audio.buf_frames_used * SampleFrameSize,
-		              video.audio.buf,
-		              0);
+	// The audio captured since the previous frame goes after it
+	const auto audio_samples = video.audio.buf_frames_used * NumAudioChannels;
+	frame.audio_sample_rate  = video.audio.sample_rate;
+	frame.audio.assign(&video.audio.buf[0][0], &video.audio.buf[0][0] + audio_samples);
+	video.audio.buf_frames_used = 0;
 
-		video.audio.bytes_written = video.audio.buf_frames_used *
-		                            SampleFrameSize;
-		video.audio.buf_frames_used = 0;
-	}
+	frame_fifo.Enqueue(std::move(frame));
 }
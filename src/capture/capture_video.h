@@ -22,7 +22,64 @@
 #ifndef DOSBOX_CAPTURE_VIDEO_H
 #define DOSBOX_CAPTURE_VIDEO_H
 
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
 #include "render.h"
+#include "std_filesystem.h"
+
+// A raw frame waiting to be compressed and written by the video encoder
+// thread, together with the audio that was captured along with it. The
+// frames are recycled to avoid allocating new buffers while recording.
+struct VideoFrameTask {
+	PixelFormat pixel_format = {};
+
+	uint16_t width  = 0;
+	uint16_t height = 0;
+
+	float frames_per_second = 0.0f;
+
+	// Rows of (width * bytes per pixel) in the pixel format the encoder
+	// expects
+	std::vector<uint8_t> pixels = {};
+
+	bool has_palette                     = false;
+	std::array<uint8_t, 256 * 4> palette = {};
+
+	// One entry per row, zero for the rows known to be unchanged since
+	// the previous frame; empty if unknown
+	std::vector<uint8_t> changed_rows = {};
+
+	// Interleaved stereo samples
+	uint32_t audio_sample_rate = 0;
+	std::vector<int16_t> audio = {};
+};
+
+enum class VideoCompression {
+	// Lowers the compression level while the encoder is busy for more
+	// than a small share of the time, and raises it back when it's not
+	Auto,
+	Fast,
+	Small,
+};
+
+void capture_video_set_compression(const VideoCompression compression);
+
+// Stream the raw frames and audio to the given file, named pipe or TCP
+// connection ('tcp:host:port') instead of writing AVI files; empty to stop
+// streaming
+void capture_video_set_stream(const std::string& destination);
+
+// Save a small preview image of the video every second
+void capture_video_set_preview(const bool enabled);
+
+// The path of the next preview image if it's due with the frame that was
+// just added
+std::optional<std_fs::path> capture_video_get_next_preview_path(
+        const float frames_per_second);
 
 void capture_video_add_frame(const RenderedImage& image,
                              const float frames_per_second);
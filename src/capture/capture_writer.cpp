@@ -0,0 +1,135 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "capture_writer.h"
+
+#include <cassert>
+
+#include "checks.h"
+#include "logging.h"
+#include "support.h"
+
+CHECK_NARROWING();
+
+CaptureWriter::~CaptureWriter()
+{
+	if (auto handle = Close(); handle) {
+		fclose(handle);
+	}
+}
+
+void CaptureWriter::Open(FILE* _file)
+{
+	assert(_file);
+
+	if (auto handle = Close(); handle) {
+		fclose(handle);
+	}
+
+	file              = _file;
+	num_bytes_written = 0;
+
+	buffer.clear();
+	buffer.reserve(BufferSize);
+
+	buffer_fifo.Start();
+	writer = std::thread(&CaptureWriter::WriteQueuedBuffers, this);
+	set_thread_name(writer, "dosbox:capwrite");
+}
+
+void CaptureWriter::Write(const void* data, const size_t num_bytes)
+{
+	assert(file);
+
+	const auto bytes = static_cast<const uint8_t*>(data);
+	buffer.insert(buffer.end(), bytes, bytes + num_bytes);
+	num_bytes_written += num_bytes;
+
+	// Only hand the buffer over if that won't block; otherwise it grows
+	// until the writer thread catches up
+	if (buffer.size() >= BufferSize &&
+	    buffer_fifo.Size() < buffer_fifo.MaxCapacity()) {
+		QueueBuffer();
+	}
+}
+
+void CaptureWriter::QueueBuffer()
+{
+	auto full_buffer = std::move(buffer);
+
+	buffer = {};
+	{
+		std::lock_guard lock(free_buffers_mutex);
+		if (!free_buffers.empty()) {
+			buffer = std::move(free_buffers.back());
+			free_buffers.pop_back();
+		}
+	}
+	buffer.clear();
+	buffer.reserve(BufferSize);
+
+	buffer_fifo.Enqueue(std::move(full_buffer));
+}
+
+void CaptureWriter::WriteQueuedBuffers()
+{
+	bool has_failed = false;
+
+	while (auto queued = buffer_fifo.Dequeue()) {
+		if (!has_failed &&
+		    fwrite(queued->data(), 1, queued->size(), file) != queued->size()) {
+			LOG_WARNING("CAPTURE: Failed to write to the capture file, "
+			            "the capture will be incomplete");
+			has_failed = true;
+		}
+
+		std::lock_guard lock(free_buffers_mutex);
+		if (free_buffers.size() < MaxQueuedBuffers) {
+			free_buffers.emplace_back(std::move(*queued));
+		}
+	}
+}
+
+FILE* CaptureWriter::Close()
+{
+	if (!file) {
+		return nullptr;
+	}
+
+	if (!buffer.empty()) {
+		QueueBuffer();
+	}
+
+	// Let the writer thread finish writing the queued buffers
+	buffer_fifo.Stop();
+	if (writer.joinable()) {
+		writer.join();
+	}
+
+	{
+		std::lock_guard lock(free_buffers_mutex);
+		free_buffers.clear();
+	}
+	buffer = {};
+
+	auto handle = file;
+	file        = nullptr;
+	return handle;
+}
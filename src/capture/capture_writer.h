@@ -0,0 +1,91 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_CAPTURE_WRITER_H
+#define DOSBOX_CAPTURE_WRITER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "rwqueue.h"
+
+// Collects the data written to a capture file in large buffers that are
+// written out by a background thread, so the mixer and device threads adding
+// the data never wait for the disk (or a slow network share).
+//
+// Writing never blocks: if the writer thread falls behind and the queue is
+// full, the current buffer keeps growing until there's room again.
+//
+// Each writer is expected to be fed by a single thread.
+//
+class CaptureWriter {
+public:
+	CaptureWriter() = default;
+	~CaptureWriter();
+
+	// Takes ownership of the file and starts the writer thread
+	void Open(FILE* file);
+
+	bool IsOpen() const
+	{
+		return file != nullptr;
+	}
+
+	void Write(const void* data, const size_t num_bytes);
+
+	// Number of bytes passed to Write() since the file was opened
+	uint64_t GetNumBytesWritten() const
+	{
+		return num_bytes_written;
+	}
+
+	// Writes out all buffered data and stops the writer thread. The file is
+	// handed back to the caller to update its headers and close it.
+	FILE* Close();
+
+	// prevent copying
+	CaptureWriter(const CaptureWriter&) = delete;
+	// prevent assignment
+	CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+private:
+	static constexpr size_t BufferSize       = 256 * 1024;
+	static constexpr size_t MaxQueuedBuffers = 16;
+
+	void WriteQueuedBuffers();
+	void QueueBuffer();
+
+	RWQueue<std::vector<uint8_t>> buffer_fifo{MaxQueuedBuffers};
+	std::thread writer = {};
+
+	// Written out buffers ready to be reused
+	std::mutex free_buffers_mutex                  = {};
+	std::vector<std::vector<uint8_t>> free_buffers = {};
+
+	std::vector<uint8_t> buffer = {};
+
+	FILE* file                 = nullptr;
+	uint64_t num_bytes_written = 0;
+};
+
+#endif // DOSBOX_CAPTURE_WRITER_H
@@ -31,12 +31,13 @@
 
 CHECK_NARROWING();
 
-ImageCapturer::ImageCapturer(const std::string& grouped_mode_prefs)
+ImageCapturer::ImageCapturer(const std::string& grouped_mode_prefs,
+                             const ImageCompression compression)
 {
 	ConfigureGroupedMode(grouped_mode_prefs);
 
 	for (auto& image_saver : image_savers) {
-		image_saver.Open();
+		image_saver.Open(compression);
 	}
 
 	LOG_MSG("CAPTURE: Image capturer started");
@@ -175,15 +176,21 @@ void ImageCapturer::MaybeCaptureImage(const RenderedImage& image)
 	if (!index) {
 		return;
 	}
+	// The raw and upscaled captures can share the same snapshot of the
+	// render buffer
+	SharedRenderedImage snapshot = {};
+	if (do_raw || do_upscaled) {
+		snapshot = RENDER_ShareImage(image);
+	}
 	if (do_raw) {
 		GetNextImageSaver().QueueImage(
-		        image.deep_copy(),
+		        snapshot,
 		        CapturedImageType::Raw,
 		        generate_capture_filename(CaptureType::RawImage, index));
 	}
 	if (do_upscaled) {
 		GetNextImageSaver().QueueImage(
-		        image.deep_copy(),
+		        snapshot,
 		        CapturedImageType::Upscaled,
 		        generate_capture_filename(CaptureType::UpscaledImage, index));
 	}
@@ -196,7 +203,9 @@ void ImageCapturer::MaybeCaptureImage(const RenderedImage& image)
 
 void ImageCapturer::CapturePostRenderImage(const RenderedImage& image)
 {
-	GetNextImageSaver().QueueImage(image, CapturedImageType::Rendered, rendered_path);
+	GetNextImageSaver().QueueImage(RENDER_AdoptImage(image),
+	                               CapturedImageType::Rendered,
+	                               rendered_path);
 
 	state.rendered = CaptureState::Off;
 
@@ -205,6 +214,15 @@ void ImageCapturer::CapturePostRenderImage(const RenderedImage& image)
 	state.grouped = CaptureState::Off;
 }
 
+void ImageCapturer::CaptureVideoPreview(const RenderedImage& image,
+                                        const std_fs::path& path)
+{
+	// The downscaling and saving happens on the image saver threads
+	GetNextImageSaver().QueueImage(RENDER_ShareImage(image),
+	                               CapturedImageType::VideoPreview,
+	                               path);
+}
+
 ImageSaver& ImageCapturer::GetNextImageSaver()
 {
 	++current_image_saver_index;
@@ -58,7 +58,8 @@
 class ImageCapturer {
 public:
 	ImageCapturer() = default;
-	ImageCapturer(const std::string& grouped_mode_prefs);
+	ImageCapturer(const std::string& grouped_mode_prefs,
+	              const ImageCompression compression);
 
 	~ImageCapturer();
 
@@ -72,6 +73,7 @@ public:
 
 	void MaybeCaptureImage(const RenderedImage& image);
 	void CapturePostRenderImage(const RenderedImage& image);
+	void CaptureVideoPreview(const RenderedImage& image, const std_fs::path& path);
 
 	// prevent copying
 	ImageCapturer(const ImageCapturer&) = delete;
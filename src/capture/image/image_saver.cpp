@@ -29,6 +29,7 @@
 #include "checks.h"
 #include "png_writer.h"
 #include "support.h"
+#include "worker_pool.h"
 
 CHECK_NARROWING();
 
@@ -37,15 +38,13 @@ ImageSaver::~ImageSaver()
 	Close();
 }
 
-void ImageSaver::Open()
+void ImageSaver::Open(const ImageCompression _compression)
 {
 	if (is_open) {
 		Close();
 	}
 
-	const auto worker_function = std::bind(&ImageSaver::SaveQueuedImages, this);
-	renderer = std::thread(worker_function);
-	set_thread_name(renderer, "dosbox:imgcap");
+	compression = _compression;
 
 	is_open = true;
 }
@@ -59,15 +58,14 @@ void ImageSaver::Close()
 	// Stop queuing new images
 	image_fifo.Stop();
 
-	// Let the renderer finish saving pending images
-	if (renderer.joinable()) {
-		renderer.join();
-	}
+	// Let the pending images be saved
+	WaitUntilSaved();
 
 	is_open = false;
 }
 
-void ImageSaver::QueueImage(const RenderedImage& image, const CapturedImageType type,
+void ImageSaver::QueueImage(const SharedRenderedImage& image,
+                            const CapturedImageType type,
                             const std::optional<std_fs::path>& path)
 {
 	if (!image_fifo.IsRunning()) {
@@ -78,22 +76,52 @@ void ImageSaver::QueueImage(const RenderedImage& image, const CapturedImageType
 
 	SaveImageTask task = {image, type, path};
 	image_fifo.Enqueue(std::move(task));
+
+	{
+		std::lock_guard lock(saving_mutex);
+		if (is_saving) {
+			return;
+		}
+		is_saving = true;
+	}
+	WORKERS_GetPool().Submit(WorkerPriority::Capture,
+	                         [this] { SaveQueuedImages(); });
 }
 
 void ImageSaver::SaveQueuedImages()
 {
-	while (auto task = image_fifo.Dequeue()) {
-		SaveImage(*task);
-		task->image.free();
+	while (true) {
+		// We're the only reader, so this never waits for an image
+		while (!image_fifo.IsEmpty()) {
+			if (const auto task = image_fifo.Dequeue(); task) {
+				SaveImage(*task);
+			}
+		}
+
+		// Images queued after the check above are saved by us, as the
+		// queuing side doesn't submit another task while we're running
+		std::lock_guard lock(saving_mutex);
+		if (image_fifo.IsEmpty()) {
+			is_saving = false;
+			saving_ended.notify_all();
+			return;
+		}
 	}
 }
 
+void ImageSaver::WaitUntilSaved()
+{
+	std::unique_lock lock(saving_mutex);
+	saving_ended.wait(lock, [this] { return !is_saving; });
+}
+
 static CaptureType to_capture_type(const CapturedImageType type)
 {
 	switch (type) {
 	case CapturedImageType::Raw: return CaptureType::RawImage;
 	case CapturedImageType::Upscaled: return CaptureType::UpscaledImage;
 	case CapturedImageType::Rendered: return CaptureType::RenderedImage;
+	case CapturedImageType::VideoPreview: return CaptureType::VideoPreview;
 	default: assertm(false, "Invalid CaptureImageType value"); return {};
 	}
 }
@@ -107,10 +135,25 @@ void ImageSaver::SaveImage(const SaveImageTask& task)
 		return;
 	}
 
+	// Images waiting in the queue mean we can't keep up with the requests
+	switch (compression) {
+	case ImageCompression::Auto:
+		png_compression = image_fifo.IsEmpty() ? PngCompression::Default
+		                                       : PngCompression::Fast;
+		break;
+	case ImageCompression::Fast: png_compression = PngCompression::Fast; break;
+	case ImageCompression::Small:
+		png_compression = PngCompression::Default;
+		break;
+	}
+
 	switch (task.image_type) {
-	case CapturedImageType::Raw: SaveRawImage(task.image); break;
-	case CapturedImageType::Upscaled: SaveUpscaledImage(task.image); break;
-	case CapturedImageType::Rendered: SaveRenderedImage(task.image); break;
+	case CapturedImageType::Raw: SaveRawImage(*task.image); break;
+	case CapturedImageType::Upscaled: SaveUpscaledImage(*task.image); break;
+	case CapturedImageType::Rendered: SaveRenderedImage(*task.image); break;
+	case CapturedImageType::VideoPreview:
+		SaveVideoPreviewImage(*task.image);
+		break;
 	}
 
 	CloseOutFile();
@@ -153,6 +196,7 @@ static void write_upscaled_png(FILE* outfile, PngWriter& png_writer,
 void ImageSaver::SaveRawImage(const RenderedImage& image)
 {
 	PngWriter png_writer = {};
+	png_writer.SetCompression(png_compression);
 
 	const auto& src = image.params;
 
@@ -229,6 +273,7 @@ static constexpr auto square_pixel_aspect_ratio = Fraction{1};
 void ImageSaver::SaveUpscaledImage(const RenderedImage& image)
 {
 	PngWriter png_writer = {};
+	png_writer.SetCompression(png_compression);
 
 	image_scaler.Init(image);
 
@@ -248,6 +293,7 @@ void ImageSaver::SaveUpscaledImage(const RenderedImage& image)
 void ImageSaver::SaveRenderedImage(const RenderedImage& image)
 {
 	PngWriter png_writer = {};
+	png_writer.SetCompression(png_compression);
 
 	const auto& src = image.params;
 
@@ -289,6 +335,28 @@ void ImageSaver::SaveRenderedImage(const RenderedImage& image)
 	}
 }
 
+void ImageSaver::SaveVideoPreviewImage(const RenderedImage& image)
+{
+	constexpr uint16_t MaxPreviewWidth  = 160;
+	constexpr uint16_t MaxPreviewHeight = 120;
+
+	PngWriter png_writer = {};
+	png_writer.SetCompression(png_compression);
+
+	image_scaler.InitThumbnail(image, MaxPreviewWidth, MaxPreviewHeight);
+
+	// The aspect ratio correction is "baked into" the downscaled image
+	// data too
+	write_upscaled_png(outfile,
+	                   png_writer,
+	                   image_scaler,
+	                   image_scaler.GetOutputWidth(),
+	                   image_scaler.GetOutputHeight(),
+	                   square_pixel_aspect_ratio,
+	                   image.params.video_mode,
+	                   image.palette_data);
+}
+
 void ImageSaver::CloseOutFile()
 {
 	if (outfile) {
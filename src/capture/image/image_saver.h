@@ -21,44 +21,44 @@
 #ifndef DOSBOX_IMAGE_SAVER_H
 #define DOSBOX_IMAGE_SAVER_H
 
-#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <optional>
-#include <thread>
 #include <vector>
 
 #include "std_filesystem.h"
 
 #include "image_decoder.h"
 #include "image_scaler.h"
+#include "png_writer.h"
 #include "render.h"
 #include "rwqueue.h"
 
-enum class CapturedImageType { Raw, Upscaled, Rendered };
+enum class CapturedImageType { Raw, Upscaled, Rendered, VideoPreview };
+
+enum class ImageCompression {
+	// Compresses the images with the fast PNG preset while the queue is
+	// backing up, e.g., when taking screenshots in quick succession
+	Auto,
+	Fast,
+	Small,
+};
 
 struct SaveImageTask {
-	RenderedImage image              = {};
+	SharedRenderedImage image        = {};
 	CapturedImageType image_type     = {};
 	std::optional<std_fs::path> path = {};
 };
 
 // Threaded image capturer; capture requests are placed in a FIFO queue then
-// are processed in order.
-//
-// The image capturer _frees_ the passed in RenderedImage after the image was
-// saved. Therefore, you might need to pass in deep-copied RenderedImage
-// instances (with the pixel and palette data deep-copied) to avoid freeing
-// the internal render buffers.
-//
-// We could make the image capturer 100% safe by always making a deep-copy of
-// the passed in RenderedImage before storing it in the work queue. But this
-// would not allow for an important optimisation step: post-render/post-shader
-// images (which can get very large at 4K resolutions; ~24 MB for a fullscreen
-// 4K capture) would always need to be copied as well.
+// are processed in order by a task on the shared worker pool, which runs
+// while the queue has images.
 //
-// For post-render/post-shader images, a copy is actually not needed, and for
-// the rest of the cases the copy is generally cheap because we're only copying
-// the contents of the interal render buffer (64K for 320x200/256, 300K for
-// 640x480/256, and ~1.2MB for 640x480 true-colour).
+// The images are shared with the capturer and released once saved, so the
+// same snapshot of the internal render buffer can be queued as both a raw and
+// an upscaled capture. Post-render/post-shader images (which can get very
+// large at 4K resolutions; ~24 MB for a fullscreen 4K capture) are adopted
+// without being copied.
 //
 // All downstream processing is row-based, meaning the image scaler and the
 // image writer are operating in row-sized chunks. This is crucial to keep the
@@ -68,22 +68,18 @@ struct SaveImageTask {
 // the final RBG888 output buffer). With the row-based approach, the memory
 // requirement is only 13K (!) and we get much better cache utilisation.
 //
-// Also, we're running multiple image capture worker threads in parallel, so
-// that would add a multiplier to the memory usage.
+// Also, we're running multiple image savers in parallel, so that would add
+// a multiplier to the memory usage.
 //
 class ImageSaver {
 public:
 	ImageSaver() = default;
 	~ImageSaver();
 
-	void Open();
+	void Open(const ImageCompression compression);
 	void Close();
 
-	// IMPORTANT: The capturer _frees_ the passed in RenderedImage after the
-	// image was saved. Consider the implications carefully; you might need
-	// to pass in a deep-copied copy of the RenderedImage instance, because
-	// you cannot know when exactly in the future will it be freed.
-	void QueueImage(const RenderedImage& image,
+	void QueueImage(const SharedRenderedImage& image,
 	                const CapturedImageType type,
 	                const std::optional<std_fs::path>& path);
 
@@ -96,17 +92,28 @@ private:
 	static constexpr auto MaxQueuedImages = 10;
 
 	void SaveQueuedImages();
+	void WaitUntilSaved();
 	void SaveImage(const SaveImageTask& task);
 
 	void SaveRawImage(const RenderedImage& image);
 	void SaveUpscaledImage(const RenderedImage& image);
 	void SaveRenderedImage(const RenderedImage& image);
+	void SaveVideoPreviewImage(const RenderedImage& image);
 
 	void CloseOutFile();
 
 	RWQueue<SaveImageTask> image_fifo{MaxQueuedImages};
-	std::thread renderer = {};
-	bool is_open         = false;
+	bool is_open = false;
+
+	// Set while a task saving the queued images is submitted or running
+	std::mutex saving_mutex              = {};
+	std::condition_variable saving_ended = {};
+	bool is_saving                       = false;
+
+	ImageCompression compression = ImageCompression::Auto;
+
+	// The preset used for the image being saved
+	PngCompression png_compression = PngCompression::Default;
 
 	ImageScaler image_scaler = {};
 
@@ -20,6 +20,7 @@
 
 #include "image_scaler.h"
 
+#include <algorithm>
 #include <cmath>
 
 #include "byteorder.h"
@@ -47,6 +48,7 @@ void ImageScaler::Init(const RenderedImage& image)
 
 	input_decoder.Init(image, row_skip_count, pixel_skip_count);
 
+	output.is_thumbnail = false;
 	UpdateOutputParamsUpscale();
 
 	assert(output.width >= image.params.video_mode.width);
@@ -59,6 +61,63 @@ void ImageScaler::Init(const RenderedImage& image)
 	AllocateBuffers();
 }
 
+void ImageScaler::InitThumbnail(const RenderedImage& image,
+                                const uint16_t max_width, const uint16_t max_height)
+{
+	assert(max_width > 0 && max_height > 0);
+
+	input = image;
+
+	const uint8_t row_skip_count   = (image.params.rendered_double_scan ? 1 : 0);
+	const uint8_t pixel_skip_count = 0;
+
+	input_decoder.Init(image, row_skip_count, pixel_skip_count);
+
+	const auto& video_mode = image.params.video_mode;
+
+	const auto input_width  = image.params.width;
+	const auto input_height = static_cast<uint16_t>(image.params.height >>
+	                                                row_skip_count);
+
+	const auto display_aspect_ratio = video_mode.pixel_aspect_ratio.ToFloat() *
+	                                  video_mode.width / video_mode.height;
+
+	auto width  = static_cast<float>(max_width);
+	auto height = static_cast<float>(max_height);
+	if (display_aspect_ratio > width / height) {
+		height = width / display_aspect_ratio;
+	} else {
+		width = height * display_aspect_ratio;
+	}
+
+	output.width = std::clamp(static_cast<uint16_t>(iround(width)),
+	                          uint16_t{1},
+	                          input_width);
+	output.height = std::clamp(static_cast<uint16_t>(iround(height)),
+	                           uint16_t{1},
+	                           input_height);
+
+	output.horiz_scale         = static_cast<float>(output.width) / input_width;
+	output.one_per_horiz_scale = 1.0f / output.horiz_scale;
+	output.vert_scale          = 1;
+
+	output.horiz_scaling_mode = PerAxisScaling::Fractional;
+	output.vert_scaling_mode  = PerAxisScaling::Fractional;
+	output.pixel_format       = OutputPixelFormat::Rgb888;
+	output.is_thumbnail       = true;
+
+	output.curr_row   = 0;
+	output.row_repeat = 0;
+
+	output.row_buf.resize(static_cast<size_t>(output.width) *
+	                      ComponentsPerRgbPixel);
+
+	linear_row_buf.resize((input_width + 1u) * ComponentsPerRgbPixel);
+	srgb_row_buf.resize((input_width + 1u) * ComponentsPerRgbPixel);
+	thumbnail_row_sums.resize(static_cast<size_t>(output.width) *
+	                          ComponentsPerRgbPixel);
+}
+
 static bool is_integer(const float f)
 {
 	return fabsf(f - roundf(f)) < 0.0001f;
@@ -233,6 +292,30 @@ void ImageScaler::AllocateBuffers()
 	// without branching (the interpolator operates on the current and the
 	// next pixel).
 	linear_row_buf.resize((input.params.width + 1u) * ComponentsPerRgbPixel);
+	srgb_row_buf.resize((input.params.width + 1u) * ComponentsPerRgbPixel);
+
+	CalculateColumnWeights();
+}
+
+void ImageScaler::CalculateColumnWeights()
+{
+	column_weights.resize(output.width);
+
+	for (auto x = 0; x < output.width; ++x) {
+		const auto x0 = static_cast<float>(x) * output.one_per_horiz_scale;
+		const auto floor_x0 = static_cast<uint16_t>(x0);
+		assert(floor_x0 < input.params.width);
+
+		// Calculate linear interpolation factor `t` between the current
+		// and the next pixel so that the interpolation "band" is one
+		// pixel wide at most at the edges of the pixel.
+		const auto x1 = x0 + output.one_per_horiz_scale;
+		const auto t  = std::max(x1 - (floor_x0 + 1.0f), 0.0f) *
+		               output.horiz_scale;
+
+		column_weights[x] = {static_cast<uint32_t>(floor_x0 * ComponentsPerRgbPixel),
+		                     t};
+	}
 }
 
 uint16_t ImageScaler::GetOutputWidth() const
@@ -252,17 +335,26 @@ OutputPixelFormat ImageScaler::GetOutputPixelFormat() const
 
 void ImageScaler::DecodeNextRowToLinearRgb()
 {
-	auto out = linear_row_buf.begin();
+	auto srgb = srgb_row_buf.data();
 
 	for (auto x = 0; x < input.params.width; ++x) {
 		const auto pixel = input_decoder.GetNextPixelAsRgb888();
 
-		*out++ = srgb8_to_linear_lut(pixel.red);
-		*out++ = srgb8_to_linear_lut(pixel.green);
-		*out++ = srgb8_to_linear_lut(pixel.blue);
+		*srgb++ = pixel.red;
+		*srgb++ = pixel.green;
+		*srgb++ = pixel.blue;
 	}
 
 	input_decoder.AdvanceRow();
+
+	// Separate pass without the decoder calls so it can be vectorised
+	const auto num_components = input.params.width * ComponentsPerRgbPixel;
+	const auto in  = srgb_row_buf.data();
+	const auto out = linear_row_buf.data();
+
+	for (auto i = 0; i < num_components; ++i) {
+		out[i] = srgb8_to_linear_lut(in[i]);
+	}
 }
 
 void ImageScaler::SetRowRepeat()
@@ -304,44 +396,83 @@ void ImageScaler::GenerateNextIntegerUpscaledOutputRow()
 
 void ImageScaler::GenerateNextSharpUpscaledOutputRow()
 {
-	auto row_start = linear_row_buf.begin();
-	auto out       = output.row_buf.begin();
+	const auto linear_row = linear_row_buf.data();
+	const auto srgb_row   = srgb_row_buf.data();
+
+	auto out = output.row_buf.data();
+
+	for (const auto& weight : column_weights) {
+		// Most output pixels fall entirely within an input pixel; the
+		// sRGB to linear to sRGB round trip is lossless, so we can take
+		// the decoded sRGB values as they are
+		if (weight.t == 0.0f) {
+			const auto pixel = srgb_row + weight.offset;
+
+			*out++ = pixel[0];
+			*out++ = pixel[1];
+			*out++ = pixel[2];
+			continue;
+		}
 
-	for (auto x = 0; x < output.width; ++x) {
-		const auto x0 = static_cast<float>(x) * output.one_per_horiz_scale;
-		const auto floor_x0 = static_cast<uint16_t>(x0);
-		assert(floor_x0 < input.params.width);
+		// Current and next horizontal pixel
+		const auto p0 = linear_row + weight.offset;
+		const auto p1 = p0 + ComponentsPerRgbPixel;
+
+		*out++ = linear_to_srgb8_lut(lerp(p0[0], p1[0], weight.t));
+		*out++ = linear_to_srgb8_lut(lerp(p0[1], p1[1], weight.t));
+		*out++ = linear_to_srgb8_lut(lerp(p0[2], p1[2], weight.t));
+	}
 
-		const auto row_offs = floor_x0 * ComponentsPerRgbPixel;
-		auto pixel_addr     = row_start + row_offs;
+	SetRowRepeat();
+}
 
-		// Current pixel
-		const auto r0 = *pixel_addr++;
-		const auto g0 = *pixel_addr++;
-		const auto b0 = *pixel_addr++;
+// Every thumbnail pixel is the average of the input pixels it covers
+void ImageScaler::GenerateNextThumbnailOutputRow()
+{
+	const auto input_width  = input.params.width;
+	const auto input_height = static_cast<uint16_t>(
+	        input.params.height >> (input.params.rendered_double_scan ? 1 : 0));
+
+	const auto first_row = output.curr_row * input_height / output.height;
+	const auto end_row = (output.curr_row + 1) * input_height / output.height;
+	assert(end_row > first_row);
+
+	std::fill(thumbnail_row_sums.begin(), thumbnail_row_sums.end(), 0.0f);
+
+	for (auto y = first_row; y < end_row; ++y) {
+		DecodeNextRowToLinearRgb();
+
+		auto sum = thumbnail_row_sums.data();
+		for (auto x = 0; x < output.width; ++x) {
+			const auto first_col = x * input_width / output.width;
+			const auto end_col = (x + 1) * input_width / output.width;
+
+			for (auto col = first_col; col < end_col; ++col) {
+				const auto pixel = linear_row_buf.data() +
+				                   col * ComponentsPerRgbPixel;
+				sum[0] += pixel[0];
+				sum[1] += pixel[1];
+				sum[2] += pixel[2];
+			}
+			sum += ComponentsPerRgbPixel;
+		}
+	}
 
-		// Next horizontal pixel
-		const auto r1 = *pixel_addr++;
-		const auto g1 = *pixel_addr++;
-		const auto b1 = *pixel_addr++;
+	auto sum = thumbnail_row_sums.data();
+	auto out = output.row_buf.begin();
 
-		// Calculate linear interpolation factor `t` between the current
-		// and the next pixel so that the interpolation "band" is one
-		// pixel wide at most at the edges of the pixel.
-		const auto x1 = x0 + output.one_per_horiz_scale;
-		const auto t  = std::max(x1 - (floor_x0 + 1.0f), 0.0f) *
-		               output.horiz_scale;
+	for (auto x = 0; x < output.width; ++x) {
+		const auto num_cols = (x + 1) * input_width / output.width -
+		                      x * input_width / output.width;
 
-		const auto out_r = lerp(r0, r1, t);
-		const auto out_g = lerp(g0, g1, t);
-		const auto out_b = lerp(b0, b1, t);
+		const auto one_per_count = 1.0f /
+		                           static_cast<float>(num_cols *
+		                                              (end_row - first_row));
 
-		*out++ = linear_to_srgb8_lut(out_r);
-		*out++ = linear_to_srgb8_lut(out_g);
-		*out++ = linear_to_srgb8_lut(out_b);
+		*out++ = linear_to_srgb8_lut(*sum++ * one_per_count);
+		*out++ = linear_to_srgb8_lut(*sum++ * one_per_count);
+		*out++ = linear_to_srgb8_lut(*sum++ * one_per_count);
 	}
-
-	SetRowRepeat();
 }
 
 std::vector<uint8_t>::const_iterator ImageScaler::GetNextOutputRow()
@@ -350,7 +481,9 @@ std::vector<uint8_t>::const_iterator ImageScaler::GetNextOutputRow()
 		return output.row_buf.end();
 	}
 
-	if (output.row_repeat == 0) {
+	if (output.is_thumbnail) {
+		GenerateNextThumbnailOutputRow();
+	} else if (output.row_repeat == 0) {
 		if (output.horiz_scaling_mode == PerAxisScaling::Integer &&
 		    output.vert_scaling_mode == PerAxisScaling::Integer) {
 			GenerateNextIntegerUpscaledOutputRow();
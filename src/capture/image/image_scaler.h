@@ -83,6 +83,12 @@ public:
 
 	void Init(const RenderedImage& image);
 
+	// Downscales the image to fit into the given size instead, keeping its
+	// aspect ratio; used for the video capture previews. The output is
+	// always RGB888.
+	void InitThumbnail(const RenderedImage& image, const uint16_t max_width,
+	                   const uint16_t max_height);
+
 	std::vector<uint8_t>::const_iterator GetNextOutputRow();
 
 	uint16_t GetOutputWidth() const;
@@ -102,18 +108,34 @@ private:
 	void LogParams();
 	void AllocateBuffers();
 
+	void CalculateColumnWeights();
 	void DecodeNextRowToLinearRgb();
 
 	void SetRowRepeat();
 
 	void GenerateNextIntegerUpscaledOutputRow();
 	void GenerateNextSharpUpscaledOutputRow();
+	void GenerateNextThumbnailOutputRow();
 
 	RenderedImage input        = {};
 	ImageDecoder input_decoder = {};
 
 	std::vector<float> linear_row_buf = {};
 
+	// The decoded input row before the conversion to linear RGB
+	std::vector<uint8_t> srgb_row_buf = {};
+
+	// The input pixel and the interpolation factor between it and the next
+	// pixel for every output column; the same for all rows
+	struct ColumnWeight {
+		uint32_t offset = 0;
+		float t         = 0.0f;
+	};
+	std::vector<ColumnWeight> column_weights = {};
+
+	// Sums of the linear RGB input pixels falling into each thumbnail pixel
+	std::vector<float> thumbnail_row_sums = {};
+
 	struct {
 		uint16_t width  = 0;
 		uint16_t height = 0;
@@ -126,6 +148,8 @@ private:
 
 		OutputPixelFormat pixel_format = {};
 
+		bool is_thumbnail = false;
+
 		uint16_t curr_row  = 0;
 		uint8_t row_repeat = 0;
 
@@ -26,12 +26,19 @@
 #include <optional>
 #include <vector>
 
-#include "image_saver.h"
-
 #include "render.h"
 
 #include <png.h>
 
+enum class PngCompression {
+	// Adaptive filtering and the default zlib level
+	Default,
+
+	// No filtering and the fastest zlib level; several times faster, at
+	// the cost of larger files
+	Fast,
+};
+
 // A row-based PNG writer that also writes the pixel aspect ratio of the image
 // into the standard pHYs PNG chunk.
 class PngWriter {
@@ -47,6 +54,12 @@ public:
 	                  const Fraction& pixel_aspect_ratio,
 	                  const VideoMode& video_mode, const uint8_t* palette_data);
 
+	// Must be called before initialising the writer
+	void SetCompression(const PngCompression _compression)
+	{
+		compression = _compression;
+	}
+
 	void WriteRow(std::vector<uint8_t>::const_iterator row);
 
 	// prevent copying
@@ -65,6 +78,8 @@ private:
 
 	void FinalisePng();
 
+	PngCompression compression = PngCompression::Default;
+
 	png_structp png_ptr    = nullptr;
 	png_infop png_info_ptr = nullptr;
 };
@@ -33,6 +33,7 @@
 */
 
 CallBack_Handler CallBack_Handlers[CB_MAX];
+CallBack_FastHandler CallBack_FastHandlers[CB_MAX] = {};
 std::string CallBack_Description[CB_MAX];
 
 static callback_number_t call_stop    = 0;
@@ -63,7 +64,16 @@ callback_number_t CALLBACK_Allocate()
 
 void CALLBACK_DeAllocate(callback_number_t cb_num)
 {
-	CallBack_Handlers[cb_num] = &illegal_handler;
+	CallBack_Handlers[cb_num]     = &illegal_handler;
+	CallBack_FastHandlers[cb_num] = nullptr;
+}
+
+void CALLBACK_SetFastHandler(callback_number_t cb_num, CallBack_FastHandler handler)
+{
+	if (cb_num >= CB_MAX) {
+		return;
+	}
+	CallBack_FastHandlers[cb_num] = handler;
 }
 
 void CALLBACK_Idle(void) {
@@ -638,6 +648,14 @@ void CALLBACK_HandlerObject::Allocate(CallBack_Handler handler,const char* descr
 		E_Exit("Callback handler object already installed");
 }
 
+void CALLBACK_HandlerObject::SetFastHandler(CallBack_FastHandler handler)
+{
+	if (!installed) {
+		E_Exit("Callback handler object not installed");
+	}
+	CALLBACK_SetFastHandler(m_cb_number, handler);
+}
+
 void CALLBACK_HandlerObject::Set_RealVec(uint8_t vec){
 	if(!vectorhandler.installed) {
 		vectorhandler.installed=true;
@@ -649,6 +667,7 @@ void CALLBACK_HandlerObject::Set_RealVec(uint8_t vec){
 void CALLBACK_Init(Section* /*sec*/) {
 	for (callback_number_t i = 0; i < CB_MAX; ++i) {
 		CallBack_Handlers[i]=&illegal_handler;
+		CallBack_FastHandlers[i] = nullptr;
 	}
 
 	/* Setup the Stop Handler */
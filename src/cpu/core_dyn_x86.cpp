@@ -395,6 +395,13 @@ run_block:
 #endif
 		return CBRET_NONE;
 	case BR_CallBack:
+		if (CALLBACK_RunFast(core_dyn.callback)) {
+			// the handler might have found the guest idle
+			if (CPU_Cycles <= 0) {
+				return CBRET_NONE;
+			}
+			goto restart_core;
+		}
 		return core_dyn.callback;
 	case BR_SMCBlock:
 		// LOG_MSG("selfmodification of running block at %x:%x",
@@ -511,10 +518,20 @@ void CPU_Core_Dyn_X86_Cache_Init(bool enable_cache) {
 	cache_init(enable_cache);
 }
 
+void CPU_Core_Dyn_X86_Cache_Reset()
+{
+	cache_release_all();
+}
+
 void CPU_Core_Dyn_X86_Cache_Close(void) {
 	cache_close();
 }
 
+void CPU_Core_Dyn_X86_SetCacheSize(const size_t size_mb)
+{
+	cache_set_size(size_mb);
+}
+
 void CPU_Core_Dyn_X86_SetFPUMode(bool dh_fpu) {
 #if defined(X86_DYNFPU_DH_ENABLED)
 	dyn_dh_fpu.dh_fpu_enabled=dh_fpu;
@@ -21,14 +21,14 @@
 #if (C_DYNREC)
 
 #include <cassert>
-// simde needs std::isnan
-#include <cmath>
 #include <cstdarg>
 #include <cstddef>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 
+#include <algorithm>
+#include <array>
 #include <type_traits>
 
 #if defined (WIN32)
@@ -49,6 +49,7 @@
 #include "callback.h"
 #include "cpu.h"
 #include "debug.h"
+#include "event_counters.h"
 #include "inout.h"
 #include "lazyflags.h"
 #include "mem.h"
@@ -66,6 +67,8 @@
 #define DYN_HASH_SHIFT	(4)
 #define DYN_PAGE_HASH	(4096>>DYN_HASH_SHIFT)
 #define DYN_LINKS		(16)
+// maximum distance of a forward jump that is followed within a block
+#define DYN_TRACE_SKIP	(64)
 
 
 //#define DYN_LOG 1 //Turn Logging on.
@@ -112,6 +115,7 @@ enum BlockReturn {
 	BR_Normal=0,
 	BR_Cycles,
 	BR_Link1,BR_Link2,
+	BR_Link3, // side exit of an extended block
 	BR_Opcode,
 #if (C_DEBUG)
 	BR_OpcodeFull,
@@ -180,15 +184,111 @@ static_assert(offsetof(core_dynrec_t, readdata) % sizeof(uint32_t) == 0,
 #include "core_dynrec/risc_ppc64le.h"
 #endif
 
-#include "simde/x86/mmx.h"
+#include "mmx_ops.h"
+
+#include "core_dynrec/persistent_cache.h"
 
 #if !defined(WORDS_BIGENDIAN)
 #define gen_add_LE gen_add
 #define gen_mov_LE_word_to_reg gen_mov_word_to_reg
 #endif
 
+static EventCounter blocks_translated("Dynrec blocks translated");
+
 #include "core_dynrec/decoder.h"
 
+/*
+	Tiered execution: code in pages that aren't code pages yet is run by
+	the normal core until the page has been entered often enough. Only
+	then the page is turned into a code page and translated. Code that
+	runs rarely (or rewrites itself before it gets hot) thus stays off the
+	translate/invalidate path.
+*/
+static struct {
+	uint8_t threshold = 0; // zero translates on first sight
+	uint16_t decay_countdown = 0;
+	std::array<uint8_t, 1 << 16> heat = {};
+} tiering = {};
+
+// Number of cycles the normal core runs per visit to a cold page
+constexpr int32_t TieringSliceCycles = 32;
+
+static bool is_cold_code(const PhysPt ip_point)
+{
+	if (const auto handler = get_tlb_readhandler(ip_point);
+	    handler && (handler->flags & PFLAG_HASCODE)) {
+		return false;
+	}
+	// age the counters so pages that were hot long ago cool down again
+	if (++tiering.decay_countdown == 0) {
+		for (auto& heat : tiering.heat) {
+			heat >>= 1;
+		}
+	}
+	const auto lin_page = ip_point >> 12;
+	auto& heat = tiering.heat[(lin_page ^ (lin_page >> 16)) & 0xffff];
+	if (heat >= tiering.threshold) {
+		return false;
+	}
+	++heat;
+	return true;
+}
+
+/*
+	Pages that mix code with frequently written data keep clearing and
+	retranslating their blocks. Once a code page has had too many of its
+	blocks invalidated, it is released and left to the normal core for a
+	while, after which it gets another chance to be translated.
+*/
+static struct {
+	std::array<uint32_t, 1 << 12> expiry = {}; // in PIC ticks, per page
+	uint32_t latest_expiry   = 0;
+	uint16_t decay_countdown = 0;
+} smc_demotion = {};
+
+// Invalidated blocks (with decay) after which a page is demoted
+constexpr uint32_t SmcDemotionThreshold = 32;
+
+// How long a demoted page is run by the normal core
+constexpr uint32_t SmcDemotionPeriodMs = 1000;
+
+static EventCounter pages_demoted("Dynrec pages demoted by self-modifying code");
+
+static size_t smc_demotion_slot(const PhysPt ip_point)
+{
+	const auto lin_page = ip_point >> 12;
+	return (lin_page ^ (lin_page >> 12)) & (smc_demotion.expiry.size() - 1);
+}
+
+static bool is_demoted_code(const PhysPt ip_point)
+{
+	if (PIC_Ticks >= smc_demotion.latest_expiry) {
+		return false;
+	}
+	return PIC_Ticks < smc_demotion.expiry[smc_demotion_slot(ip_point)];
+}
+
+// Releases the code page if it keeps invalidating its blocks
+static bool demote_thrashing_page(CodePageHandler* chandler, const PhysPt ip_point)
+{
+	// age the counters so occasional modifications never add up
+	if (++smc_demotion.decay_countdown == 0) {
+		for (auto page = cache.used_pages; page; page = page->next) {
+			page->smc_invalidations >>= 1;
+		}
+	}
+	if (chandler->smc_invalidations < SmcDemotionThreshold) {
+		return false;
+	}
+	const auto expiry = PIC_Ticks + SmcDemotionPeriodMs;
+	smc_demotion.expiry[smc_demotion_slot(ip_point)] = expiry;
+	smc_demotion.latest_expiry = std::max(smc_demotion.latest_expiry, expiry);
+	pages_demoted.Add();
+
+	chandler->ClearRelease();
+	return true;
+}
+
 CacheBlock *LinkBlocks(BlockReturn ret)
 {
 	// the last instruction was a control flow modifying instruction
@@ -213,11 +313,13 @@ CacheBlock *LinkBlocks(BlockReturn ret)
 	// see if the target is an already translated block
 	const auto cache_block = cp_handler->FindCacheBlock(temp_ip & 4095);
 	if (!cache_block) {
+		++cache_stats.link_misses;
 		return nullptr;
 	}
 
 	// found it, link the current block to
-	cache.block.running->LinkTo(ret == BR_Link2, cache_block);
+	++cache_stats.link_hits;
+	cache.block.running->LinkTo(ret - BR_Link1, cache_block);
 	return cache_block;
 }
 
@@ -233,9 +335,36 @@ CacheBlock *LinkBlocks(BlockReturn ret)
 	execution process, or returning from the core etc.
 */
 
+static void plot_cache_stats()
+{
+	TracyPlot("Dynrec blocks translated",
+	          static_cast<int64_t>(cache_stats.blocks_translated));
+	TracyPlot("Dynrec SMC invalidations",
+	          static_cast<int64_t>(cache_stats.smc_invalidations));
+	TracyPlot("Dynrec link hits", static_cast<int64_t>(cache_stats.link_hits));
+	TracyPlot("Dynrec link misses",
+	          static_cast<int64_t>(cache_stats.link_misses));
+	TracyPlot("Dynrec cache wraps",
+	          static_cast<int64_t>(cache_stats.cache_wraps));
+	TracyPlot("Dynrec flags eliminated",
+	          static_cast<int64_t>(cache_stats.flags_eliminated));
+
+	// The cache is filled round-robin, so it stays full after the first
+	// wrap
+	[[maybe_unused]] const int64_t fill_pos =
+	        cache.block.active ? cache.block.active->cache.start - cache_code
+	                           : 0;
+	[[maybe_unused]] const int64_t occupancy =
+	        cache_stats.cache_wraps
+	                ? 100
+	                : fill_pos * 100 / static_cast<int64_t>(cache_total);
+	TracyPlot("Dynrec cache occupancy (%)", occupancy);
+}
+
 Bits CPU_Core_Dynrec_Run() noexcept
 {
 	ZoneScoped;
+	plot_cache_stats();
 	for (;;) {
 		// Determine the linear address of CS:EIP
 		PhysPt ip_point=SegPhys(cs)+reg_eip;
@@ -244,6 +373,21 @@ Bits CPU_Core_Dynrec_Run() noexcept
 			return debugCallback;
 #endif
 
+		if (is_demoted_code(ip_point) ||
+		    (tiering.threshold && is_cold_code(ip_point))) {
+			// let the normal core run a short slice of the cold code
+			const auto slice = std::min(CPU_Cycles, TieringSliceCycles);
+			const auto remaining = CPU_Cycles - slice;
+			CPU_Cycles = slice;
+			const auto nc_retcode = CPU_Core_Normal_Run();
+			CPU_Cycles += remaining;
+			if (nc_retcode || CPU_Cycles <= 0 ||
+			    cpudecoder != &CPU_Core_Dynrec_Run) {
+				return nc_retcode;
+			}
+			continue;
+		}
+
 		CodePageHandler *chandler = nullptr;
 		// see if the current page is present and contains code
 		if (MakeCodePage(ip_point, chandler)) {
@@ -257,6 +401,13 @@ Bits CPU_Core_Dynrec_Run() noexcept
 			return CPU_Core_Normal_Run();
 		}
 
+		if (demote_thrashing_page(chandler, ip_point)) {
+			continue;
+		}
+
+		// translate the known blocks of a page seen in an earlier session
+		dynrec_cache_translate_pending(chandler, ip_point);
+
 		// find correct Dynamic Block to run
 		CacheBlock *block = chandler->FindCacheBlock(ip_point & 4095);
 		if (!block) {
@@ -325,6 +476,13 @@ run_block:
 		case BR_CallBack:
 			// the callback code is executed in dosbox.conf, return the callback number
 			FillFlags();
+			if (CALLBACK_RunFast(core_dynrec.callback)) {
+				// the handler might have found the guest idle
+				if (CPU_Cycles <= 0) {
+					return CBRET_NONE;
+				}
+				break;
+			}
 			return core_dynrec.callback;
 
 		case BR_SMCBlock:
@@ -350,6 +508,7 @@ run_block:
 
 		case BR_Link1:
 		case BR_Link2:
+		case BR_Link3:
 			block=LinkBlocks(ret);
 			if (block) goto run_block;
 			break;
@@ -387,10 +546,62 @@ void CPU_Core_Dynrec_Init(void) {
 void CPU_Core_Dynrec_Cache_Init(bool enable_cache) {
 	// Initialize code cache and dynamic blocks
 	cache_init(enable_cache);
+
+	if (enable_cache && persistent_cache.enabled && !persistent_cache.loaded) {
+		dynrec_cache_load();
+	}
+}
+
+void CPU_Core_Dynrec_Cache_Reset()
+{
+	cache_release_all();
 }
 
 void CPU_Core_Dynrec_Cache_Close(void) {
+	dynrec_cache_save();
 	cache_close();
 }
 
+void CPU_Core_Dynrec_LogStats()
+{
+	const auto& s = cache_stats;
+
+	auto ratio = [](const uint64_t part, const uint64_t total) {
+		return total ? static_cast<double>(part) / static_cast<double>(total)
+		             : 0.0;
+	};
+
+	LOG_MSG("DYNREC: %" PRIu64 " blocks translated, %.1f instructions and %.1f bytes of host code per block",
+	        s.blocks_translated,
+	        ratio(s.opcodes_translated, s.blocks_translated),
+	        ratio(s.bytes_generated, s.blocks_translated));
+	LOG_MSG("DYNREC: %" PRIu64 " blocks invalidated by self-modifying code, %" PRIu64 " cache wraps",
+	        s.smc_invalidations,
+	        s.cache_wraps);
+	LOG_MSG("DYNREC: %" PRIu64 " block links resolved, %" PRIu64 " missed (%.1f%% hit rate)",
+	        s.link_hits,
+	        s.link_misses,
+	        100.0 * ratio(s.link_hits, s.link_hits + s.link_misses));
+	LOG_MSG("DYNREC: %" PRIu64 " dead flag computations replaced by simpler code",
+	        s.flags_eliminated);
+}
+
+void CPU_Core_Dynrec_SetCacheSize(const size_t size_mb)
+{
+	cache_set_size(size_mb);
+}
+
+void CPU_Core_Dynrec_SetPersistentCache(const bool enabled)
+{
+	persistent_cache.enabled = enabled;
+}
+
+void CPU_Core_Dynrec_SetTieringThreshold(const uint8_t threshold)
+{
+	if (tiering.threshold != threshold) {
+		tiering.heat.fill(0);
+	}
+	tiering.threshold = threshold;
+}
+
 #endif
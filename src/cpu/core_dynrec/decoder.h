@@ -32,6 +32,7 @@
 
 static CacheBlock *CreateCacheBlock(CodePageHandler *codepage, PhysPt start, Bitu max_opcodes)
 {
+	ZoneScoped;
 	// initialize a load of variables
 	decode.code_start=start;
 	decode.code=start;
@@ -41,6 +42,7 @@ static CacheBlock *CreateCacheBlock(CodePageHandler *codepage, PhysPt start, Bit
 	decode.page.invmap=codepage->invalidation_map;
 	decode.page.first=start >> 12;
 	decode.active_block=decode.block=cache_openblock();
+	decode.side_exit=false;
 	decode.block->page.start=(uint16_t)decode.page.index;
 	codepage->AddCacheBlock(decode.block);
 
@@ -52,6 +54,11 @@ static CacheBlock *CreateCacheBlock(CodePageHandler *codepage, PhysPt start, Bit
 
 	InitFlagsOptimization();
 
+#if defined(DRC_TRACK_HOST_REGS)
+	// nothing is known about the host registers when entering a block
+	gen_reset_reg_tracking();
+#endif
+
 	// every codeblock that is run sets cache.block.running to itself
 	// so the block linking knows the last executed block
 	gen_mov_direct_ptr(&cache.block.running,(Bitu)decode.block);
@@ -676,7 +683,13 @@ static CacheBlock *CreateCacheBlock(CodePageHandler *codepage, PhysPt start, Bit
 		// short conditional jumps
 		case 0x70:case 0x71:case 0x72:case 0x73:case 0x74:case 0x75:case 0x76:case 0x77:	
 		case 0x78:case 0x79:case 0x7a:case 0x7b:case 0x7c:case 0x7d:case 0x7e:case 0x7f:	
-			dyn_branched_exit((BranchTypes)(opcode&0xf),(int8_t)decode_fetchb());	
+			{
+				const auto eip_add = (int8_t)decode_fetchb();
+				if (dyn_branched_side_exit((BranchTypes)(opcode & 0xf), eip_add)) {
+					break;
+				}
+				dyn_branched_exit((BranchTypes)(opcode & 0xf), eip_add);
+			}
 			goto finish_block;
 
 		// 'op []/reg8,imm8'
@@ -905,7 +918,14 @@ static CacheBlock *CreateCacheBlock(CodePageHandler *codepage, PhysPt start, Bit
 			goto finish_block;
 		// 'jmp near imm16/32'
 		case 0xe9:
-			dyn_exit_link(decode.big_op ? (int32_t)decode_fetchd() : (int16_t)decode_fetchw());
+			{
+				const Bits eip_change = decode.big_op ? (int32_t)decode_fetchd()
+				                                      : (int16_t)decode_fetchw();
+				if (dyn_follow_jump(eip_change)) {
+					break;
+				}
+				dyn_exit_link(eip_change);
+			}
 			goto finish_block;
 		// 'jmp far'
 		case 0xea:
@@ -913,7 +933,13 @@ static CacheBlock *CreateCacheBlock(CodePageHandler *codepage, PhysPt start, Bit
 			goto finish_block;
 		// 'jmp short imm8'
 		case 0xeb:
-			dyn_exit_link((int8_t)decode_fetchb());
+			{
+				const Bits eip_change = (int8_t)decode_fetchb();
+				if (dyn_follow_jump(eip_change)) {
+					break;
+				}
+				dyn_exit_link(eip_change);
+			}
 			goto finish_block;
 
 
@@ -1005,6 +1031,12 @@ finish_block:
 	const auto cache_flush_bytes = static_cast<size_t>(decode.block->cache.size);
 	dyn_cache_invalidate(cache_addr, cache_flush_bytes);
 	assert(decode.block->cache.size <= cache_bytes);
+
+	++cache_stats.blocks_translated;
+	blocks_translated.Add();
+	cache_stats.opcodes_translated += decode.cycles;
+	cache_stats.bytes_generated += static_cast<uint64_t>(
+	        cache.pos - decode.block->cache.start);
 	//	LOG_MSG("Created block size %d start %d end
 	//%d",decode.block->cache.size,decode.block->page.start,decode.block->page.end);
 	return decode.block;
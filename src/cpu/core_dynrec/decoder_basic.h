@@ -92,6 +92,7 @@ static struct DynDecode {
 	Bitu cycles;			// number cycles used by currently translated code
 	bool seg_prefix_used;	// segment overridden
 	uint8_t seg_prefix;		// segment prefix (if seg_prefix_used==true)
+	bool side_exit;			// the side exit link of the block is in use
 
 	// block that contains the first instruction translated
 	CacheBlock *block;
@@ -191,6 +192,7 @@ static bool MakeCodePage(Bitu lin_addr, CodePageHandler *&cph)
 	MEM_SetPageHandler(phys_page,1,cpagehandler);
 	PAGING_UnlinkPages(lin_page,1);
 	cph=cpagehandler;
+	dynrec_cache_apply_hints(cpagehandler, lin_page);
 	return false;
 }
 
@@ -1169,6 +1171,7 @@ static void InvalidateFlags(void) {
 	for (Bitu ct=0; ct<mf_functions_num; ct++) {
 		gen_fill_function_ptr(mf_functions[ct].pos,mf_functions[ct].fct_ptr,mf_functions[ct].ftype);
 	}
+	cache_stats.flags_eliminated+=mf_functions_num;
 	mf_functions_num=0;
 #endif
 }
@@ -1181,6 +1184,7 @@ static void InvalidateFlags(void* current_simple_function,Bitu flags_type) {
 	for (Bitu ct=0; ct<mf_functions_num; ct++) {
 		gen_fill_function_ptr(mf_functions[ct].pos,mf_functions[ct].fct_ptr,mf_functions[ct].ftype);
 	}
+	cache_stats.flags_eliminated+=mf_functions_num;
 	mf_functions_num=1;
 	mf_functions[0].pos=cache.pos;
 	mf_functions[0].fct_ptr=current_simple_function;
@@ -1193,6 +1197,8 @@ static void InvalidateFlags(void* current_simple_function,Bitu flags_type) {
 // this function can be replaced by a simpler one as well
 static void InvalidateFlagsPartially(void* current_simple_function,Bitu flags_type) {
 #ifdef DRC_FLAGS_INVALIDATION
+	// a full queue only means this one keeps generating its flags
+	if (mf_functions_num>=std::size(mf_functions)) return;
 	mf_functions[mf_functions_num].pos=cache.pos;
 	mf_functions[mf_functions_num].fct_ptr=current_simple_function;
 	mf_functions[mf_functions_num].ftype=flags_type;
@@ -1205,6 +1211,7 @@ static void InvalidateFlagsPartially(void* current_simple_function,Bitu flags_ty
 // this function can be replaced by a simpler one as well
 static void InvalidateFlagsPartially(void* current_simple_function,const uint8_t* cpos,Bitu flags_type) {
 #ifdef DRC_FLAGS_INVALIDATION
+	if (mf_functions_num>=std::size(mf_functions)) return;
 	mf_functions[mf_functions_num].pos=cpos;
 	mf_functions[mf_functions_num].fct_ptr=current_simple_function;
 	mf_functions[mf_functions_num].ftype=flags_type;
@@ -1212,9 +1219,32 @@ static void InvalidateFlagsPartially(void* current_simple_function,const uint8_t
 #endif
 }
 
-// the current function needs the condition flags thus reset the queue
+// the condition flags that are changed by an operation of this type
+static Bitu FlagsWrittenBy(Bitu flags_type) {
+	switch (flags_type) {
+		case t_INCb:
+		case t_INCw:
+		case t_INCd:
+		case t_DECb:
+		case t_DECw:
+		case t_DECd:
+			return FMASK_TEST & ~FLAG_CF;
+		default:
+			return FMASK_TEST;
+	}
+}
+
+// the current function needs the condition flags in flags_mask, so the
+// queued functions that produce any of them have to stay as they are.
+// The others are kept in the queue, mostly INC/DEC followed by ADC/SBB or
+// RCL/RCR which only consume the carry flag that INC/DEC don't touch
 static void AcquireFlags([[maybe_unused]] Bitu flags_mask) {
 #ifdef DRC_FLAGS_INVALIDATION
-	mf_functions_num=0;
+	Bitu kept=0;
+	for (Bitu ct=0; ct<mf_functions_num; ct++) {
+		if (FlagsWrittenBy(mf_functions[ct].ftype) & flags_mask) continue;
+		mf_functions[kept++]=mf_functions[ct];
+	}
+	mf_functions_num=kept;
 #endif
 }
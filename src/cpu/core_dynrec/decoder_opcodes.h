@@ -1106,6 +1106,65 @@ static void dyn_exit_link(Bits eip_change) {
 }
 
 
+/*
+	Trace formation: instead of ending the block at every control transfer,
+	short forward jumps within the page of the block are followed, and the
+	first short forward conditional jump becomes a side exit (using its own
+	link) while the translation continues with the not-taken path.
+*/
+
+// check that a forward jump can be followed within the current block
+static bool dyn_can_follow_forward(Bits eip_change) {
+	if (eip_change <= 0 || eip_change > DYN_TRACE_SKIP) return false;
+	// only within the page the block started in
+	if (decode.active_block != decode.block) return false;
+	if (decode.page.index + eip_change >= 4096) return false;
+	if (!decode.big_op) {
+		// the 16bit instruction pointer must not wrap around
+		if (SegPhys(cs) + reg_eip != decode.code_start) return false;
+		const Bitu eip_target = reg_eip + (decode.code - decode.code_start) + eip_change;
+		if (eip_target > 0xffff) return false;
+	}
+	return true;
+}
+
+// continue the translation at the target of an unconditional jump
+static bool dyn_follow_jump(Bits eip_change) {
+	if (!dyn_can_follow_forward(eip_change)) return false;
+	// skipped bytes aren't code of this block, mask them so writes to
+	// them (inline data is common) don't invalidate the block
+	for (; eip_change > 0; --eip_change) {
+		decode.active_block->cache.AddByteToWriteMaskAt(decode.page.index);
+		++decode.code;
+		++decode.page.index;
+	}
+	return true;
+}
+
+// leave the block if the branch is taken, otherwise continue the translation
+static bool dyn_branched_side_exit(BranchTypes btype,int32_t eip_add) {
+	if (decode.side_exit || !dyn_can_follow_forward(eip_add)) return false;
+	decode.side_exit=true;
+
+	Bitu eip_base=decode.code-decode.code_start;
+	// account the cycles so far on both paths
+	dyn_reduce_cycles();
+	decode.cycles=0;
+
+	dyn_branchflag_to_reg(btype);
+	// the flags are used here, later instructions must not drop them
+	AcquireFlags(FMASK_TEST);
+	const uint8_t* data=gen_create_branch_on_zero(FC_RETOP,true);
+
+	// Branch taken
+	gen_add_direct_word(&reg_eip,eip_base+eip_add,decode.big_op);
+	gen_jmp_ptr(&decode.block->link[2].to, offsetof(CacheBlock, cache.start));
+	gen_fill_branch(data);
+
+	// Branch not taken, translation goes on
+	return true;
+}
+
 static void dyn_branched_exit(BranchTypes btype,int32_t eip_add) {
 	Bitu eip_base=decode.code-decode.code_start;
 	dyn_reduce_cycles();
@@ -66,9 +66,60 @@ static inline void dyn_fpu_top_swapped() {
 	gen_mov_word_to_reg(FC_OP2,(void*)(&TOP),true);
 }
 
+#if defined(DRC_FPU_INLINE_DOUBLE) && !C_FPU_X86
+// Without the 80-bit soft-float emulation the basic arithmetic helpers are
+// a single double precision operation, which the backend can emit in place
+// of the call. The setting is fixed at startup, so it can be checked when
+// translating.
+static inline bool dyn_fpu_inline_arith() {
+	return !fpu.extended_precision;
+}
+#endif
+
+// FADD, FMUL, FSUB, FSUBR, FDIV or FDIVR (numbered like the reg field of
+// ESC 0) of the registers with the indices in FC_OP1 (destination) and FC_OP2
+static void dyn_fpu_arith(const Bitu op) {
+#if defined(DRC_FPU_INLINE_DOUBLE) && !C_FPU_X86
+	if (dyn_fpu_inline_arith()) {
+		gen_fpu_arith_double(op,&fpu.regs[0]);
+		return;
+	}
+#endif
+	switch (op) {
+	case 0x00:
+		gen_call_function_RR((void*)&FPU_FADD,FC_OP1,FC_OP2);
+		break;
+	case 0x01:
+		gen_call_function_RR((void*)&FPU_FMUL,FC_OP1,FC_OP2);
+		break;
+	case 0x04:
+		gen_call_function_RR((void*)&FPU_FSUB,FC_OP1,FC_OP2);
+		break;
+	case 0x05:
+		gen_call_function_RR((void*)&FPU_FSUBR,FC_OP1,FC_OP2);
+		break;
+	case 0x06:
+		gen_call_function_RR((void*)&FPU_FDIV,FC_OP1,FC_OP2);
+		break;
+	case 0x07:
+		gen_call_function_RR((void*)&FPU_FDIVR,FC_OP1,FC_OP2);
+		break;
+	default:
+		break;
+	}
+}
+
 static void dyn_eatree() {
 //	Bitu group = (decode.modrm.val >> 3) & 7;
 	Bitu group = decode.modrm.reg&7; //It is already that, but compilers.
+#if defined(DRC_FPU_INLINE_DOUBLE) && !C_FPU_X86
+	// the memory operand has been loaded into the scratch register 8
+	if (dyn_fpu_inline_arith() && group != 0x02 && group != 0x03) {
+		gen_mov_dword_to_reg_imm(FC_OP2,8);
+		dyn_fpu_arith(group);
+		return;
+	}
+#endif
 	switch (group){
 	case 0x00:		// FADD ST,STi
 		gen_call_function_R((void*)&FPU_FADD_EA,FC_OP1);
@@ -107,10 +158,10 @@ static void dyn_fpu_esc0(){
 		dyn_fpu_top();
 		switch (decode.modrm.reg){
 		case 0x00:		//FADD ST,STi
-			gen_call_function_RR((void*)&FPU_FADD,FC_OP1,FC_OP2);
+			dyn_fpu_arith(0x00);
 			break;
 		case 0x01:		// FMUL  ST,STi
-			gen_call_function_RR((void*)&FPU_FMUL,FC_OP1,FC_OP2);
+			dyn_fpu_arith(0x01);
 			break;
 		case 0x02:		// FCOM  STi
 			gen_call_function_RR((void*)&FPU_FCOM,FC_OP1,FC_OP2);
@@ -120,16 +171,16 @@ static void dyn_fpu_esc0(){
 			gen_call_function_raw((void*)&FPU_FPOP);
 			break;
 		case 0x04:		// FSUB  ST,STi
-			gen_call_function_RR((void*)&FPU_FSUB,FC_OP1,FC_OP2);
+			dyn_fpu_arith(0x04);
 			break;	
 		case 0x05:		// FSUBR ST,STi
-			gen_call_function_RR((void*)&FPU_FSUBR,FC_OP1,FC_OP2);
+			dyn_fpu_arith(0x05);
 			break;
 		case 0x06:		// FDIV  ST,STi
-			gen_call_function_RR((void*)&FPU_FDIV,FC_OP1,FC_OP2);
+			dyn_fpu_arith(0x06);
 			break;
 		case 0x07:		// FDIVR ST,STi
-			gen_call_function_RR((void*)&FPU_FDIVR,FC_OP1,FC_OP2);
+			dyn_fpu_arith(0x07);
 			break;
 		default:
 			break;
@@ -439,11 +490,11 @@ static void dyn_fpu_esc4(){
 		switch(decode.modrm.reg){
 		case 0x00:	/* FADD STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR((void*)&FPU_FADD,FC_OP1,FC_OP2);
+			dyn_fpu_arith(0x00);
 			break;
 		case 0x01:	/* FMUL STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR((void*)&FPU_FMUL,FC_OP1,FC_OP2);
+			dyn_fpu_arith(0x01);
 			break;
 		case 0x02:  /* FCOM*/
 			dyn_fpu_top();
@@ -456,19 +507,19 @@ static void dyn_fpu_esc4(){
 			break;
 		case 0x04:  /* FSUBR STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR((void*)&FPU_FSUBR,FC_OP1,FC_OP2);
+			dyn_fpu_arith(0x05);
 			break;
 		case 0x05:  /* FSUB  STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR((void*)&FPU_FSUB,FC_OP1,FC_OP2);
+			dyn_fpu_arith(0x04);
 			break;
 		case 0x06:  /* FDIVR STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR((void*)&FPU_FDIVR,FC_OP1,FC_OP2);
+			dyn_fpu_arith(0x07);
 			break;
 		case 0x07:  /* FDIV STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR((void*)&FPU_FDIV,FC_OP1,FC_OP2);
+			dyn_fpu_arith(0x06);
 			break;
 		default:
 			break;
@@ -559,11 +610,11 @@ static void dyn_fpu_esc6(){
 		switch(decode.modrm.reg){
 		case 0x00:	/*FADDP STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR((void*)&FPU_FADD,FC_OP1,FC_OP2);
+			dyn_fpu_arith(0x00);
 			break;
 		case 0x01:	/* FMULP STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR((void*)&FPU_FMUL,FC_OP1,FC_OP2);
+			dyn_fpu_arith(0x01);
 			break;
 		case 0x02:  /* FCOMP5*/
 			dyn_fpu_top();
@@ -583,19 +634,19 @@ static void dyn_fpu_esc6(){
 			break;
 		case 0x04:  /* FSUBRP STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR((void*)&FPU_FSUBR,FC_OP1,FC_OP2);
+			dyn_fpu_arith(0x05);
 			break;
 		case 0x05:  /* FSUBP  STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR((void*)&FPU_FSUB,FC_OP1,FC_OP2);
+			dyn_fpu_arith(0x04);
 			break;
 		case 0x06:	/* FDIVRP STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR((void*)&FPU_FDIVR,FC_OP1,FC_OP2);
+			dyn_fpu_arith(0x07);
 			break;
 		case 0x07:  /* FDIVP STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR((void*)&FPU_FDIV,FC_OP1,FC_OP2);
+			dyn_fpu_arith(0x06);
 			break;
 		default:
 			break;
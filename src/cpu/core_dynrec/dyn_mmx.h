@@ -137,10 +137,7 @@ static void mmx_paddb(const Bitu rm, const PhysPt eaa)
 	} else {
 		src.q = LoadMq(eaa);
 	}
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_paddb(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::paddb(*dest, src);
 }
 
 // CASE_0F_MMX(0xFC) // PADDB Pq,Qq
@@ -165,10 +162,7 @@ static void mmx_paddw(const Bitu rm, const PhysPt eaa)
 	} else {
 		src.q = LoadMq(eaa);
 	}
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_paddw(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::paddw(*dest, src);
 }
 
 // CASE_0F_MMX(0xFD) // PADDW Pq,Qq
@@ -193,10 +187,7 @@ static void mmx_paddd(const Bitu rm, const PhysPt eaa)
 	} else {
 		src.q = LoadMq(eaa);
 	}
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_paddd(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::paddd(*dest, src);
 }
 
 // CASE_0F_MMX(0xFE) // PADDD Pq,Qq
@@ -221,10 +212,7 @@ static void mmx_paddsb(const Bitu rm, const PhysPt eaa)
 	} else {
 		src.q = LoadMq(eaa);
 	}
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_paddsb(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::paddsb(*dest, src);
 }
 
 // CASE_0F_MMX(0xEC) // PADDSB Pq,Qq
@@ -249,10 +237,7 @@ static void mmx_paddsw(const Bitu rm, const PhysPt eaa)
 	} else {
 		src.q = LoadMq(eaa);
 	}
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_paddsw(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::paddsw(*dest, src);
 }
 
 // CASE_0F_MMX(0xED) // PADDSW Pq,Qq
@@ -277,10 +262,7 @@ static void mmx_paddusb(const Bitu rm, const PhysPt eaa)
 	} else {
 		src.q = LoadMq(eaa);
 	}
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_paddusb(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::paddusb(*dest, src);
 }
 
 // CASE_0F_MMX(0xDC) // PADDUSB Pq,Qq
@@ -305,10 +287,7 @@ static void mmx_paddusw(const Bitu rm, const PhysPt eaa)
 	} else {
 		src.q = LoadMq(eaa);
 	}
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_paddusw(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::paddusw(*dest, src);
 }
 
 // CASE_0F_MMX(0xDD) // PADDUSW Pq,Qq
@@ -333,10 +312,7 @@ static void mmx_psubb(const Bitu rm, const PhysPt eaa)
 	} else {
 		src.q = LoadMq(eaa);
 	}
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_psubb(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::psubb(*dest, src);
 }
 
 // CASE_0F_MMX(0xF8) // PSUBB Pq,Qq
@@ -361,10 +337,7 @@ static void mmx_psubw(const Bitu rm, const PhysPt eaa)
 	} else {
 		src.q = LoadMq(eaa);
 	}
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_psubw(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::psubw(*dest, src);
 }
 
 // CASE_0F_MMX(0xF9) // PSUBW Pq,Qq
@@ -389,10 +362,7 @@ static void mmx_psubsb(const Bitu rm, const PhysPt eaa)
 	} else {
 		src.q = LoadMq(eaa);
 	}
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_psubsb(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::psubsb(*dest, src);
 }
 
 // CASE_0F_MMX(0xE8) // PSUBSB Pq,Qq
@@ -417,10 +387,7 @@ static void mmx_psubsw(const Bitu rm, const PhysPt eaa)
 	} else {
 		src.q = LoadMq(eaa);
 	}
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_psubsw(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::psubsw(*dest, src);
 }
 
 // CASE_0F_MMX(0xE9) // PSUBSW Pq,Qq
@@ -445,10 +412,7 @@ static void mmx_psubusb(const Bitu rm, const PhysPt eaa)
 	} else {
 		src.q = LoadMq(eaa);
 	}
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_psubusb(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::psubusb(*dest, src);
 }
 
 // CASE_0F_MMX(0xD8) // PSUBUSB Pq,Qq
@@ -473,10 +437,7 @@ static void mmx_psubusw(const Bitu rm, const PhysPt eaa)
 	} else {
 		src.q = LoadMq(eaa);
 	}
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_psubusw(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::psubusw(*dest, src);
 }
 
 // CASE_0F_MMX(0xD9) // PSUBUSW Pq,Qq
@@ -501,10 +462,7 @@ static void mmx_psubd(const Bitu rm, const PhysPt eaa)
 	} else {
 		src.q = LoadMq(eaa);
 	}
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_psubd(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::psubd(*dest, src);
 }
 
 // CASE_0F_MMX(0xFA) // PSUBD Pq,Qq
@@ -529,10 +487,7 @@ static void mmx_pmaddwd(const Bitu rm, const PhysPt eaa)
 	} else {
 		src.q = LoadMq(eaa);
 	}
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_pmaddwd(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::pmaddwd(*dest, src);
 }
 
 // CASE_0F_MMX(0xF5) // PMADDWD Pq,Qq
@@ -557,10 +512,7 @@ static void mmx_pmulhw(const Bitu rm, const PhysPt eaa)
 	} else {
 		src.q = LoadMq(eaa);
 	}
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_pmulhw(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::pmulhw(*dest, src);
 }
 
 // CASE_0F_MMX(0xE5) // PMULHW Pq,Qq
@@ -585,10 +537,7 @@ static void mmx_pmullw(const Bitu rm, const PhysPt eaa)
 	} else {
 		src.q = LoadMq(eaa);
 	}
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_pmullw(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::pmullw(*dest, src);
 }
 
 // CASE_0F_MMX(0xD5) // PMULLW Pq,Qq
@@ -613,10 +562,7 @@ static void mmx_packuswb(const Bitu rm, const PhysPt eaa = 0)
 	} else {
 		src.q = LoadMq(eaa);
 	}
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_packuswb(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::packuswb(*dest, src);
 }
 
 // CASE_0F_MMX(0x67) // PACKUSWB Pq,Qq
@@ -639,21 +585,15 @@ static void mmx_psllw_psrlw_psraw(const Bitu rm, const Bitu shift)
 	switch (op) {
 	case 0x06: // PSLLW
 	{
-		const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-		const auto res = simde_m_psllwi(dest_m, shift);
-		dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+		*dest = mmx::psllwi(*dest, shift);
 	} break;
 	case 0x02: // PSRLW
 	{
-		const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-		const auto res = simde_m_psrlwi(dest_m, shift);
-		dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+		*dest = mmx::psrlwi(*dest, shift);
 	} break;
 	case 0x04: // PSRAW
 	{
-		const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-		const auto res = simde_m_psrawi(dest_m, shift);
-		dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+		*dest = mmx::psrawi(*dest, shift);
 	} break;
 	}
 }
@@ -674,21 +614,15 @@ static void mmx_pslld_psrld_psrad(const Bitu rm, const Bitu shift)
 	switch (op) {
 	case 0x06: // PSLLD
 	{
-		const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-		const auto res = simde_m_pslldi(dest_m, shift);
-		dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+		*dest = mmx::pslldi(*dest, shift);
 	} break;
 	case 0x02: // PSRLD
 	{
-		const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-		const auto res = simde_m_psrldi(dest_m, shift);
-		dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+		*dest = mmx::psrldi(*dest, shift);
 	} break;
 	case 0x04: // PSRAD
 	{
-		const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-		const auto res = simde_m_psradi(dest_m, shift);
-		dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+		*dest = mmx::psradi(*dest, shift);
 	} break;
 	}
 }
@@ -712,10 +646,7 @@ static void mmx_pslld(const Bitu rm, const PhysPt eaa)
 		src.q = LoadMq(eaa);
 	}
 
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_pslld(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::pslld(*dest, src);
 }
 
 // CASE_0F_MMX(0xf2) // PSLLD Pq,Qq
@@ -741,10 +672,7 @@ static void mmx_psllq(const Bitu rm, const PhysPt eaa)
 		src.q = LoadMq(eaa);
 	}
 
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_psllq(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::psllq(*dest, src);
 }
 
 // CASE_0F_MMX(0xf3) // PSLLQ Pq,Qq
@@ -770,10 +698,7 @@ static void mmx_psrld(const Bitu rm, const PhysPt eaa)
 		src.q = LoadMq(eaa);
 	}
 
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_psrld(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::psrld(*dest, src);
 }
 
 // CASE_0F_MMX(0xd2) // PSRLD Pq,Qq
@@ -799,10 +724,7 @@ static void mmx_pcmpeqb(const Bitu rm, const PhysPt eaa)
 		src.q = LoadMq(eaa);
 	}
 
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_pcmpeqb(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::pcmpeqb(*dest, src);
 }
 
 // CASE_0F_MMX(0x74) // PCMPEQB Pq,Qq
@@ -828,10 +750,7 @@ static void mmx_pcmpeqw(const Bitu rm, const PhysPt eaa)
 		src.q = LoadMq(eaa);
 	}
 
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_pcmpeqw(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::pcmpeqw(*dest, src);
 }
 
 // CASE_0F_MMX(0x75) // PCMPEQW Pq,Qq
@@ -857,10 +776,7 @@ static void mmx_pcmpeqd(const Bitu rm, const PhysPt eaa)
 		src.q = LoadMq(eaa);
 	}
 
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_pcmpeqd(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::pcmpeqd(*dest, src);
 }
 
 // CASE_0F_MMX(0x76) // PCMPEQD Pq,Qq
@@ -886,10 +802,7 @@ static void mmx_pcmpgtb(const Bitu rm, const PhysPt eaa)
 		src.q = LoadMq(eaa);
 	}
 
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_pcmpgtb(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::pcmpgtb(*dest, src);
 }
 
 // CASE_0F_MMX(0x64) // PCMPGTB Pq,Qq
@@ -915,10 +828,7 @@ static void mmx_pcmpgtw(const Bitu rm, const PhysPt eaa)
 		src.q = LoadMq(eaa);
 	}
 
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_pcmpgtw(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::pcmpgtw(*dest, src);
 }
 
 // CASE_0F_MMX(0x65) // PCMPGTW Pq,Qq
@@ -944,10 +854,7 @@ static void mmx_pcmpgtd(const Bitu rm, const PhysPt eaa)
 		src.q = LoadMq(eaa);
 	}
 
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_pcmpgtd(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::pcmpgtd(*dest, src);
 }
 
 // CASE_0F_MMX(0x66) // PCMPGTD Pq,Qq
@@ -973,10 +880,7 @@ static void mmx_packsswb(const Bitu rm, const PhysPt eaa)
 		src.q = LoadMq(eaa);
 	}
 
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_packsswb(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::packsswb(*dest, src);
 }
 
 // CASE_0F_MMX(0x63) // PACKSSWB Pq,Qq
@@ -1002,10 +906,7 @@ static void mmx_packssdw(const Bitu rm, const PhysPt eaa)
 		src.q = LoadMq(eaa);
 	}
 
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_packssdw(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::packssdw(*dest, src);
 }
 
 // CASE_0F_MMX(0x6B) // PACKSSDW Pq,Qq
@@ -1031,10 +932,7 @@ static void mmx_punpckhbw(const Bitu rm, const PhysPt eaa)
 		src.q = LoadMq(eaa);
 	}
 
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_punpckhbw(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::punpckhbw(*dest, src);
 }
 
 // CASE_0F_MMX(0x68) // PUNPCKHBW Pq,Qq
@@ -1060,10 +958,7 @@ static void mmx_punpcklbw(const Bitu rm, const PhysPt eaa)
 		src.q = LoadMq(eaa);
 	}
 
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_punpcklbw(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::punpcklbw(*dest, src);
 }
 
 // CASE_0F_MMX(0x60) // PUNPCKLBW Pq,Qq
@@ -1089,10 +984,7 @@ static void mmx_punpckhwd(const Bitu rm, const PhysPt eaa)
 		src.q = LoadMq(eaa);
 	}
 
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_punpckhwd(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::punpckhwd(*dest, src);
 }
 
 // CASE_0F_MMX(0x69) // PUNPCKHWD Pq,Qq
@@ -1118,10 +1010,7 @@ static void mmx_punpcklwd(const Bitu rm, const PhysPt eaa)
 		src.q = LoadMq(eaa);
 	}
 
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_punpcklwd(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::punpcklwd(*dest, src);
 }
 
 // CASE_0F_MMX(0x61) // PUNPCKLWD Pq,Qq
@@ -1147,10 +1036,7 @@ static void mmx_punpckldq(const Bitu rm, const PhysPt eaa)
 		src.q = LoadMq(eaa);
 	}
 
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_punpckldq(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::punpckldq(*dest, src);
 }
 
 // CASE_0F_MMX(0x62) // PUNPCKLDQ Pq,Qq
@@ -1176,10 +1062,7 @@ static void mmx_punpckhdq(const Bitu rm, const PhysPt eaa)
 		src.q = LoadMq(eaa);
 	}
 
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_punpckhdq(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::punpckhdq(*dest, src);
 }
 
 // CASE_0F_MMX(0x6A) // PUNPCKHDQ Pq,Qq
@@ -1205,10 +1088,7 @@ static void mmx_psllw(const Bitu rm, const PhysPt eaa)
 		src.q = LoadMq(eaa);
 	}
 
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_psllw(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::psllw(*dest, src);
 }
 
 // CASE_0F_MMX(0xf1) // PSLLW Pq,Qq
@@ -1234,10 +1114,7 @@ static void mmx_psrlw(const Bitu rm, const PhysPt eaa)
 		src.q = LoadMq(eaa);
 	}
 
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_psrlw(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::psrlw(*dest, src);
 }
 
 // CASE_0F_MMX(0xd1) // PSRLW Pq,Qq
@@ -1263,10 +1140,7 @@ static void mmx_psrlq(const Bitu rm, const PhysPt eaa)
 		src.q = LoadMq(eaa);
 	}
 
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_psrlq(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::psrlq(*dest, src);
 }
 
 // CASE_0F_MMX(0xd3) // PSRLQ Pq,Qq
@@ -1316,10 +1190,7 @@ static void mmx_psraw(const Bitu rm, const PhysPt eaa)
 		src.q = LoadMq(eaa);
 	}
 
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_psraw(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::psraw(*dest, src);
 }
 
 // CASE_0F_MMX(0xe1) // PSRAW Pq,Qq
@@ -1345,10 +1216,7 @@ static void mmx_psrad(const Bitu rm, const PhysPt eaa)
 		src.q = LoadMq(eaa);
 	}
 
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_psrad(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::psrad(*dest, src);
 }
 
 // CASE_0F_MMX(0xe2) // PSRAD Pq,Qq
@@ -1374,10 +1242,7 @@ static void mmx_por(const Bitu rm, const PhysPt eaa = 0)
 		src.q = LoadMq(eaa);
 	}
 
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_por(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::por(*dest, src);
 }
 
 // CASE_0F_MMX(0xeb) // POR Pq,Qq
@@ -1402,10 +1267,7 @@ static void mmx_pxor(const Bitu rm, const PhysPt eaa = 0)
 		src.q = LoadMq(eaa);
 	}
 
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_pxor(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::pxor(*dest, src);
 }
 
 // CASE_0F_MMX(0xef) // PXOR Pq,Qq
@@ -1430,10 +1292,7 @@ static void mmx_pand(const Bitu rm, const PhysPt eaa = 0)
 		src.q = LoadMq(eaa);
 	}
 
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_pand(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::pand(*dest, src);
 }
 
 // CASE_0F_MMX(0xdb) // PAND Pq,Qq
@@ -1458,10 +1317,7 @@ static void mmx_pandn(const Bitu rm, const PhysPt eaa = 0)
 		src.q = LoadMq(eaa);
 	}
 
-	const auto src_m  = simde_m_from_int64(static_cast<int64_t>(src.q));
-	const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	const auto res    = simde_m_pandn(dest_m, src_m);
-	dest->q           = static_cast<uint64_t>(simde_m_to_int64(res));
+	*dest = mmx::pandn(*dest, src);
 }
 
 // CASE_0F_MMX(0xdf) // PANDN Pq,Qq
@@ -1641,6 +1641,61 @@ static void DRC_CALL_CONV dynrec_std(void) {
 }
 
 
+// Do count MOVS elements, runs within plain RAM pages are copied in bulk
+template <typename T, typename Index, typename Add>
+static void dynrec_movs_elements(Bitu count, const Add add_index,
+                                 const PhysPt si_base, const PhysPt di_base,
+                                 Index& si, Index& di)
+{
+	constexpr auto index_mask = std::numeric_limits<Index>::max();
+	while (count > 0) {
+		const auto done = string_bulk_movs<T>(
+		        si_base, si, di_base, di, index_mask, add_index > 0, count);
+		if (done) {
+			si = static_cast<Index>(si + done * add_index);
+			di = static_cast<Index>(di + done * add_index);
+			count -= done;
+			continue;
+		}
+		if constexpr (sizeof(T) == 1) {
+			mem_writeb(di_base + di, mem_readb(si_base + si));
+		} else if constexpr (sizeof(T) == 2) {
+			mem_writew(di_base + di, mem_readw(si_base + si));
+		} else {
+			mem_writed(di_base + di, mem_readd(si_base + si));
+		}
+		si = static_cast<Index>(si + add_index);
+		di = static_cast<Index>(di + add_index);
+		--count;
+	}
+}
+
+// Do count STOS elements, runs within plain RAM pages are filled in bulk
+template <typename T, typename Index, typename Add>
+static void dynrec_stos_elements(Bitu count, const Add add_index,
+                                 const PhysPt di_base, Index& di, const T value)
+{
+	constexpr auto index_mask = std::numeric_limits<Index>::max();
+	while (count > 0) {
+		const auto done = string_bulk_stos<T>(
+		        di_base, di, index_mask, add_index > 0, count, value);
+		if (done) {
+			di = static_cast<Index>(di + done * add_index);
+			count -= done;
+			continue;
+		}
+		if constexpr (sizeof(T) == 1) {
+			mem_writeb(di_base + di, value);
+		} else if constexpr (sizeof(T) == 2) {
+			mem_writew(di_base + di, value);
+		} else {
+			mem_writed(di_base + di, value);
+		}
+		di = static_cast<Index>(di + add_index);
+		--count;
+	}
+}
+
 static uint16_t DRC_CALL_CONV dynrec_movsb_word(uint16_t count,int16_t add_index,PhysPt si_base,PhysPt di_base) DRC_FC;
 static uint16_t DRC_CALL_CONV dynrec_movsb_word(uint16_t count,int16_t add_index,PhysPt si_base,PhysPt di_base) {
 	uint16_t count_left;
@@ -1651,11 +1706,7 @@ static uint16_t DRC_CALL_CONV dynrec_movsb_word(uint16_t count,int16_t add_index
 		count=(uint16_t)CPU_Cycles;
 		CPU_Cycles=0;
 	}
-	for (;count>0;count--) {
-		mem_writeb(di_base+reg_di,mem_readb(si_base+reg_si));
-		reg_si+=add_index;
-		reg_di+=add_index;
-	}
+	dynrec_movs_elements<uint8_t>(count,add_index,si_base,di_base,reg_si,reg_di);
 	return count_left;
 }
 
@@ -1669,11 +1720,7 @@ static uint32_t DRC_CALL_CONV dynrec_movsb_dword(uint32_t count,int32_t add_inde
 		count=CPU_Cycles;
 		CPU_Cycles=0;
 	}
-	for (;count>0;count--) {
-		mem_writeb(di_base+reg_edi,mem_readb(si_base+reg_esi));
-		reg_esi+=add_index;
-		reg_edi+=add_index;
-	}
+	dynrec_movs_elements<uint8_t>(count,add_index,si_base,di_base,reg_esi,reg_edi);
 	return count_left;
 }
 
@@ -1688,11 +1735,7 @@ static uint16_t DRC_CALL_CONV dynrec_movsw_word(uint16_t count,int16_t add_index
 		CPU_Cycles=0;
 	}
 	add_index<<=1;
-	for (;count>0;count--) {
-		mem_writew(di_base+reg_di,mem_readw(si_base+reg_si));
-		reg_si+=add_index;
-		reg_di+=add_index;
-	}
+	dynrec_movs_elements<uint16_t>(count,add_index,si_base,di_base,reg_si,reg_di);
 	return count_left;
 }
 
@@ -1707,11 +1750,7 @@ static uint32_t DRC_CALL_CONV dynrec_movsw_dword(uint32_t count,int32_t add_inde
 		CPU_Cycles=0;
 	}
 	add_index = left_shift_signed(add_index, 1);
-	for (;count>0;count--) {
-		mem_writew(di_base+reg_edi,mem_readw(si_base+reg_esi));
-		reg_esi+=add_index;
-		reg_edi+=add_index;
-	}
+	dynrec_movs_elements<uint16_t>(count,add_index,si_base,di_base,reg_esi,reg_edi);
 	return count_left;
 }
 
@@ -1726,11 +1765,7 @@ static uint16_t DRC_CALL_CONV dynrec_movsd_word(uint16_t count,int16_t add_index
 		CPU_Cycles=0;
 	}
 	add_index = left_shift_signed(add_index, 2);
-	for (;count>0;count--) {
-		mem_writed(di_base+reg_di,mem_readd(si_base+reg_si));
-		reg_si+=add_index;
-		reg_di+=add_index;
-	}
+	dynrec_movs_elements<uint32_t>(count,add_index,si_base,di_base,reg_si,reg_di);
 	return count_left;
 }
 
@@ -1745,11 +1780,7 @@ static uint32_t DRC_CALL_CONV dynrec_movsd_dword(uint32_t count,int32_t add_inde
 		CPU_Cycles=0;
 	}
 	add_index = left_shift_signed(add_index, 2);
-	for (;count>0;count--) {
-		mem_writed(di_base+reg_edi,mem_readd(si_base+reg_esi));
-		reg_esi+=add_index;
-		reg_edi+=add_index;
-	}
+	dynrec_movs_elements<uint32_t>(count,add_index,si_base,di_base,reg_esi,reg_edi);
 	return count_left;
 }
 
@@ -1871,10 +1902,7 @@ static uint16_t DRC_CALL_CONV dynrec_stosb_word(uint16_t count,int16_t add_index
 		count=(uint16_t)CPU_Cycles;
 		CPU_Cycles=0;
 	}
-	for (;count>0;count--) {
-		mem_writeb(di_base+reg_di,reg_al);
-		reg_di+=add_index;
-	}
+	dynrec_stos_elements<uint8_t>(count,add_index,di_base,reg_di,reg_al);
 	return count_left;
 }
 
@@ -1888,10 +1916,7 @@ static uint32_t DRC_CALL_CONV dynrec_stosb_dword(uint32_t count,int32_t add_inde
 		count=CPU_Cycles;
 		CPU_Cycles=0;
 	}
-	for (;count>0;count--) {
-		mem_writeb(di_base+reg_edi,reg_al);
-		reg_edi+=add_index;
-	}
+	dynrec_stos_elements<uint8_t>(count,add_index,di_base,reg_edi,reg_al);
 	return count_left;
 }
 
@@ -1906,10 +1931,7 @@ static uint16_t DRC_CALL_CONV dynrec_stosw_word(uint16_t count,int16_t add_index
 		CPU_Cycles=0;
 	}
 	add_index = left_shift_signed(add_index, 1);
-	for (;count>0;count--) {
-		mem_writew(di_base+reg_di,reg_ax);
-		reg_di+=add_index;
-	}
+	dynrec_stos_elements<uint16_t>(count,add_index,di_base,reg_di,reg_ax);
 	return count_left;
 }
 
@@ -1924,10 +1946,7 @@ static uint32_t DRC_CALL_CONV dynrec_stosw_dword(uint32_t count,int32_t add_inde
 		CPU_Cycles=0;
 	}
 	add_index = left_shift_signed(add_index, 1);
-	for (;count>0;count--) {
-		mem_writew(di_base+reg_edi,reg_ax);
-		reg_edi+=add_index;
-	}
+	dynrec_stos_elements<uint16_t>(count,add_index,di_base,reg_edi,reg_ax);
 	return count_left;
 }
 
@@ -1942,10 +1961,7 @@ static uint16_t DRC_CALL_CONV dynrec_stosd_word(uint16_t count,int16_t add_index
 		CPU_Cycles=0;
 	}
 	add_index = left_shift_signed(add_index, 2);
-	for (;count>0;count--) {
-		mem_writed(di_base+reg_di,reg_eax);
-		reg_di+=add_index;
-	}
+	dynrec_stos_elements<uint32_t>(count,add_index,di_base,reg_di,reg_eax);
 	return count_left;
 }
 
@@ -1960,10 +1976,7 @@ static uint32_t DRC_CALL_CONV dynrec_stosd_dword(uint32_t count,int32_t add_inde
 		CPU_Cycles=0;
 	}
 	add_index = left_shift_signed(add_index, 2);
-	for (;count>0;count--) {
-		mem_writed(di_base+reg_edi,reg_eax);
-		reg_edi+=add_index;
-	}
+	dynrec_stos_elements<uint32_t>(count,add_index,di_base,reg_edi,reg_eax);
 	return count_left;
 }
 
@@ -0,0 +1,268 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/*
+	Persistent translation hints for the dynamic core.
+
+	The generated host code embeds absolute host addresses (register
+	file, helper functions, the cache itself) that change between runs,
+	so it can't be stored as-is. Instead we store, per guest code page,
+	the offsets where translated blocks started and the offsets that
+	were found to be modified too often to be translated. Pages are
+	identified by a hash of their contents (and the code size), so a
+	stored entry is only ever applied to byte-identical code.
+
+	When a page that matches a stored entry becomes a code page, its
+	invalidation map is seeded with the known self-modifying offsets
+	(so we skip the translate/invalidate round trips) and all of the
+	recorded entry points are translated in one batch.
+*/
+
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+
+#include "cross.h"
+
+#define XXH_INLINE_ALL 1
+#define XXH_NO_INLINE_HINTS 1
+#define XXH_STATIC_LINKING_ONLY 1
+#include "decoders/xxhash.h"
+
+constexpr char DynrecCacheMagic[8] = {'D', 'B', 'D', 'Y', 'N', 'C', 'A', '1'};
+constexpr auto DynrecCacheFilename = "dynrec-cache.bin";
+
+// Don't let the file grow without bound on hosts that run many titles
+constexpr size_t DynrecCacheMaxPages = 16384;
+
+// Same threshold as used by the decoder to stop translating a byte
+constexpr uint8_t DynrecCacheSmcThreshold = 4;
+
+struct DynrecPageHints {
+	std::vector<uint16_t> block_starts = {};
+	std::vector<uint16_t> smc_offsets  = {};
+};
+
+static struct {
+	bool enabled = false;
+	bool loaded  = false;
+
+	std::unordered_map<uint64_t, DynrecPageHints> pages = {};
+
+	// the code page that got hints applied and still needs its blocks
+	// translated, this is done from the core loop and not from within
+	// MakeCodePage, which is also called in the middle of decoding
+	struct {
+		CodePageHandler* handler = nullptr;
+		Bitu lin_page            = 0;
+		const DynrecPageHints* hints = nullptr;
+	} pending = {};
+} persistent_cache = {};
+
+static std_fs::path dynrec_cache_path()
+{
+	return GetConfigDir() / DynrecCacheFilename;
+}
+
+static uint64_t dynrec_page_key(const HostPt page_mem, const bool is_code32)
+{
+	return XXH3_64bits_withSeed(page_mem, 4096, is_code32 ? 32 : 16);
+}
+
+static void dynrec_cache_load()
+{
+	persistent_cache.loaded = true;
+
+	std::ifstream file(dynrec_cache_path(), std::ios::binary);
+	if (!file) {
+		return;
+	}
+
+	auto read_value = [&](auto& value) {
+		file.read(reinterpret_cast<char*>(&value), sizeof(value));
+		return file.good();
+	};
+	auto read_offsets = [&](std::vector<uint16_t>& offsets,
+	                        const uint16_t count) {
+		offsets.resize(count);
+		file.read(reinterpret_cast<char*>(offsets.data()),
+		          count * sizeof(uint16_t));
+		return file.good();
+	};
+
+	char magic[sizeof(DynrecCacheMagic)] = {};
+	uint32_t num_pages = 0;
+	if (!read_value(magic) ||
+	    !std::equal(std::begin(magic), std::end(magic), DynrecCacheMagic) ||
+	    !read_value(num_pages)) {
+		LOG_WARNING("DYNREC: Ignoring invalid translation cache '%s'",
+		            dynrec_cache_path().string().c_str());
+		return;
+	}
+
+	for (uint32_t i = 0; i < num_pages; ++i) {
+		uint64_t key          = 0;
+		uint16_t num_blocks   = 0;
+		uint16_t num_smc      = 0;
+		DynrecPageHints hints = {};
+		if (!read_value(key) || !read_value(num_blocks) ||
+		    !read_value(num_smc) ||
+		    !read_offsets(hints.block_starts, num_blocks) ||
+		    !read_offsets(hints.smc_offsets, num_smc)) {
+			LOG_WARNING("DYNREC: Translation cache is truncated, using the first %u pages",
+			            i);
+			break;
+		}
+		persistent_cache.pages[key] = std::move(hints);
+	}
+
+	LOG_MSG("DYNREC: Loaded translation hints for %u code pages",
+	        static_cast<unsigned>(persistent_cache.pages.size()));
+}
+
+// Merge the state of the currently cached code pages into the stored hints
+static void dynrec_cache_collect()
+{
+	for (auto page = cache.used_pages; page; page = page->next) {
+		const auto page_mem = page->GetHostReadPt(page->GetPhysPage());
+		if (!page_mem) {
+			continue;
+		}
+		DynrecPageHints hints = {};
+		page->ForEachCacheBlock([&](const CacheBlock& block) {
+			// blocks spanning two pages depend on the following
+			// page's content, which isn't part of the key
+			if (!block.crossblock) {
+				hints.block_starts.push_back(block.page.start);
+			}
+		});
+		if (page->invalidation_map) {
+			for (uint16_t i = 0; i < 4096; ++i) {
+				if (page->invalidation_map[i] >= DynrecCacheSmcThreshold) {
+					hints.smc_offsets.push_back(i);
+				}
+			}
+		}
+		if (hints.block_starts.empty() && hints.smc_offsets.empty()) {
+			continue;
+		}
+		const auto is_code32 = (page->flags & PFLAG_HASCODE32) != 0;
+		persistent_cache.pages[dynrec_page_key(page_mem, is_code32)] =
+		        std::move(hints);
+	}
+}
+
+static void dynrec_cache_save()
+{
+	if (!persistent_cache.enabled || !cache_initialized) {
+		return;
+	}
+	dynrec_cache_collect();
+
+	std::ofstream file(dynrec_cache_path(), std::ios::binary | std::ios::trunc);
+	if (!file) {
+		LOG_WARNING("DYNREC: Failed to write translation cache '%s'",
+		            dynrec_cache_path().string().c_str());
+		return;
+	}
+
+	auto write_value = [&](const auto& value) {
+		file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+	};
+	auto write_offsets = [&](const std::vector<uint16_t>& offsets) {
+		file.write(reinterpret_cast<const char*>(offsets.data()),
+		           offsets.size() * sizeof(uint16_t));
+	};
+
+	const auto num_pages = static_cast<uint32_t>(
+	        std::min(persistent_cache.pages.size(), DynrecCacheMaxPages));
+
+	write_value(DynrecCacheMagic);
+	write_value(num_pages);
+
+	uint32_t written = 0;
+	for (const auto& [key, hints] : persistent_cache.pages) {
+		if (written++ == num_pages) {
+			break;
+		}
+		write_value(key);
+		write_value(static_cast<uint16_t>(hints.block_starts.size()));
+		write_value(static_cast<uint16_t>(hints.smc_offsets.size()));
+		write_offsets(hints.block_starts);
+		write_offsets(hints.smc_offsets);
+	}
+}
+
+// Called by MakeCodePage when a physical page turns into a code page
+static void dynrec_cache_apply_hints(CodePageHandler* page, const Bitu lin_page)
+{
+	if (!persistent_cache.enabled || persistent_cache.pages.empty()) {
+		return;
+	}
+	const auto page_mem = page->GetHostReadPt(page->GetPhysPage());
+	if (!page_mem) {
+		return;
+	}
+	const auto it = persistent_cache.pages.find(
+	        dynrec_page_key(page_mem, cpu.code.big));
+	if (it == persistent_cache.pages.end()) {
+		return;
+	}
+	const auto& hints = it->second;
+
+	if (!hints.smc_offsets.empty()) {
+		if (!page->invalidation_map) {
+			page->invalidation_map = page->alloc_invalidation_map();
+		}
+		for (const auto offset : hints.smc_offsets) {
+			page->invalidation_map[offset] = DynrecCacheSmcThreshold;
+		}
+	}
+	if (!hints.block_starts.empty()) {
+		persistent_cache.pending = {page, lin_page, &hints};
+	}
+}
+
+static CacheBlock* CreateCacheBlock(CodePageHandler* codepage, PhysPt start,
+                                    Bitu max_opcodes);
+
+// Translate the recorded blocks of a freshly hinted code page
+static void dynrec_cache_translate_pending(CodePageHandler* page, const PhysPt ip_point)
+{
+	auto& pending = persistent_cache.pending;
+	if (pending.handler != page) {
+		return;
+	}
+	const auto hints    = pending.hints;
+	const auto lin_page = pending.lin_page;
+	pending = {};
+
+	// the handler might have been recycled for another page meanwhile
+	if ((ip_point >> 12) != lin_page) {
+		return;
+	}
+	for (const auto start : hints->block_starts) {
+		if (page->FindCacheBlock(start)) {
+			continue;
+		}
+		const auto lin_addr = static_cast<PhysPt>((lin_page << 12) | start);
+		CreateCacheBlock(page, lin_addr, 32);
+	}
+}
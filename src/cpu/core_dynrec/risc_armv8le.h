@@ -38,6 +38,9 @@
 // use FC_SEGS_ADDR to hold the address of "Segs" and to access it using FC_SEGS_ADDR
 #define DRC_USE_SEGS_ADDR
 
+// emit the double precision FPU arithmetic inline, see gen_fpu_arith_double
+#define DRC_FPU_INLINE_DOUBLE
+
 // register mapping
 typedef uint8_t HostReg;
 
@@ -290,6 +293,20 @@ typedef uint8_t HostReg;
 // sturb reg, [addr, #imm]		@	-256 <= imm < 256
 #define STURB_IMM(reg, addr, imm) (0x38000000 + (reg) + ((addr) << 5) + (((imm) << 12) & 0x001ff000) )
 
+// floating point
+// ldr dreg, [addr1, addr2, lsl #3]
+#define LDR64_FP_REG_LSL3(dreg, addr1, addr2) (0xfc607800 + (dreg) + ((addr1) << 5) + ((addr2) << 16) )
+// str dreg, [addr1, addr2, lsl #3]
+#define STR64_FP_REG_LSL3(dreg, addr1, addr2) (0xfc207800 + (dreg) + ((addr1) << 5) + ((addr2) << 16) )
+// fadd ddst, dsrc1, dsrc2
+#define FADD_D(dst, src1, src2) (0x1e602800 + (dst) + ((src1) << 5) + ((src2) << 16) )
+// fsub ddst, dsrc1, dsrc2
+#define FSUB_D(dst, src1, src2) (0x1e603800 + (dst) + ((src1) << 5) + ((src2) << 16) )
+// fmul ddst, dsrc1, dsrc2
+#define FMUL_D(dst, src1, src2) (0x1e600800 + (dst) + ((src1) << 5) + ((src2) << 16) )
+// fdiv ddst, dsrc1, dsrc2
+#define FDIV_D(dst, src1, src2) (0x1e601800 + (dst) + ((src1) << 5) + ((src2) << 16) )
+
 // branch
 // bgt pc+imm		@	0 <= imm < 1M	&	imm mod 4 = 0
 #define BGT_FWD(imm) (0x5400000c + ((imm) << 3) )
@@ -1133,6 +1150,28 @@ static void gen_fill_function_ptr(const uint8_t * pos,void* fct_ptr,Bitu flags_t
 }
 #endif
 
+#ifdef DRC_FPU_INLINE_DOUBLE
+// double precision arithmetic on two FPU registers, regs points to the
+// array of doubles, FC_OP1 holds the index of the destination register and
+// FC_OP2 the index of the other operand; op is numbered like the reg field
+// of ESC 0 (0 fadd, 1 fmul, 4 fsub, 5 fsubr, 6 fdiv, 7 fdivr)
+static void gen_fpu_arith_double(const Bitu op,void* regs) {
+	gen_mov_qword_to_reg_imm(temp1, (uint64_t)regs);
+	cache_addd( LDR64_FP_REG_LSL3(0, temp1, FC_OP1) );      // ldr d0, [temp1, FC_OP1, lsl #3]
+	cache_addd( LDR64_FP_REG_LSL3(1, temp1, FC_OP2) );      // ldr d1, [temp1, FC_OP2, lsl #3]
+	switch (op) {
+		case 0x00: cache_addd( FADD_D(0, 0, 1) ); break;    // fadd d0, d0, d1
+		case 0x01: cache_addd( FMUL_D(0, 0, 1) ); break;    // fmul d0, d0, d1
+		case 0x04: cache_addd( FSUB_D(0, 0, 1) ); break;    // fsub d0, d0, d1
+		case 0x05: cache_addd( FSUB_D(0, 1, 0) ); break;    // fsub d0, d1, d0
+		case 0x06: cache_addd( FDIV_D(0, 0, 1) ); break;    // fdiv d0, d0, d1
+		case 0x07: cache_addd( FDIV_D(0, 1, 0) ); break;    // fdiv d0, d1, d0
+		default: E_Exit("gen_fpu_arith_double: invalid operation %d", (int)op);
+	}
+	cache_addd( STR64_FP_REG_LSL3(0, temp1, FC_OP1) );      // str d0, [temp1, FC_OP1, lsl #3]
+}
+#endif
+
 static void cache_block_closing([[maybe_unused]] const uint8_t *block_start,
                                 [[maybe_unused]] Bitu block_size) { }
 
@@ -29,6 +29,9 @@
 // try to replace _simple functions by code
 #define DRC_FLAGS_INVALIDATION_DCODE
 
+// keep track of memory values held in host registers to avoid reloads
+#define DRC_TRACK_HOST_REGS
+
 // calling convention modifier
 #define DRC_CALL_CONV	/* nothing */
 #define DRC_FC			/* nothing */
@@ -78,11 +81,55 @@ typedef uint8_t HostReg;
 #define TEMP_REG_DRC HOST_ESI
 
 
+// The decoder stores every guest register it modifies back into the
+// register file and loads it again for the next instruction. Remember
+// which memory value each host register currently holds, so loads of a
+// value that's still in a register turn into register moves (or vanish).
+// This only describes straight-line code: the state is dropped at every
+// branch target, function call and block entry.
+struct HostRegContent {
+	const void* addr = nullptr;
+	uint8_t size     = 0; // 4: the full dword is valid, 2: the low word
+};
+static HostRegContent host_reg_contents[8] = {};
+
+static void gen_reset_reg_tracking(void) {
+	for (auto& content : host_reg_contents) content = {};
+}
+
+static void reg_tracking_forget(HostReg reg) {
+	host_reg_contents[reg&7] = {};
+}
+
+static void reg_tracking_remember(HostReg reg,const void* addr,uint8_t size) {
+	host_reg_contents[reg&7] = {addr,size};
+}
+
+// forget all registers that mirror memory overlapping [addr,addr+size)
+static void reg_tracking_mem_written(const void* addr,Bitu size) {
+	const auto start = reinterpret_cast<uintptr_t>(addr);
+	for (auto& content : host_reg_contents) {
+		if (!content.size) continue;
+		const auto held = reinterpret_cast<uintptr_t>(content.addr);
+		if ((held < start+size) && (start < held+content.size)) content = {};
+	}
+}
+
+// returns a host register holding at least size bytes of addr, or -1
+static int reg_tracking_find(const void* addr,uint8_t size) {
+	for (int reg = 0; reg < 8; reg++) {
+		const auto& content = host_reg_contents[reg];
+		if ((content.addr == addr) && (content.size >= size)) return reg;
+	}
+	return -1;
+}
+
 // move a full register from reg_src to reg_dst
 static void gen_mov_regs(HostReg reg_dst,HostReg reg_src) {
 	if (reg_dst==reg_src) return;
 	cache_addb(0x8b);					// mov reg_dst,reg_src
 	cache_addb(0xc0+(reg_dst<<3)+reg_src);
+	host_reg_contents[reg_dst] = host_reg_contents[reg_src];
 }
 
 static void gen_mov_reg_qword(HostReg dest_reg,uint64_t imm);
@@ -170,21 +217,39 @@ static inline void gen_memaddr(Bitu modreg,void* data,Bitu off,Bitu imm,uint8_t
 // move a 32bit (dword==true) or 16bit (dword==false) value from memory into dest_reg
 // 16bit moves may destroy the upper 16bit of the destination register
 static void gen_mov_word_to_reg(HostReg dest_reg,void* data,bool dword,uint8_t prefix=0) {
-	if (!dword) gen_reg_memaddr(dest_reg,data,0xb7,0x0f);	// movzx reg,[data] - zero extend data, fixes LLVM compile where the called function does not extend the parameters
-	else gen_reg_memaddr(dest_reg,data,0x8b,prefix);	// mov reg,[data]
-} 
+	if (prefix) {
+		// loads into r8d/r9d, these registers aren't tracked
+		gen_reg_memaddr(dest_reg,data,0x8b,prefix);	// mov reg,[data]
+		return;
+	}
+	const uint8_t size = dword ? 4 : 2;
+	const int held = reg_tracking_find(data,size);
+	if (held >= 0) {
+		const auto src_reg = static_cast<HostReg>(held);
+		if (dword) {
+			gen_mov_regs(dest_reg,src_reg);
+			return;
+		}
+		cache_addw(0xb70f);		// movzx dest_reg,src_reg (16bit)
+		cache_addb(0xc0+(dest_reg<<3)+src_reg);
+	} else if (!dword) gen_reg_memaddr(dest_reg,data,0xb7,0x0f);	// movzx reg,[data] - zero extend data, fixes LLVM compile where the called function does not extend the parameters
+	else gen_reg_memaddr(dest_reg,data,0x8b);	// mov reg,[data]
+	reg_tracking_remember(dest_reg,data,size);
+}
 
 // move a 16bit constant value into dest_reg
 // the upper 16bit of the destination register may be destroyed
 static void gen_mov_word_to_reg_imm(HostReg dest_reg,uint16_t imm) {
 	cache_addb(0xb8+dest_reg);			// mov reg,imm
 	cache_addd((uint32_t)imm);
+	reg_tracking_forget(dest_reg);
 }
 
 // move a 32bit constant value into dest_reg
 static void gen_mov_dword_to_reg_imm(HostReg dest_reg,uint32_t imm) {
 	cache_addb(0xb8+dest_reg);			// mov reg,imm
 	cache_addd(imm);
+	reg_tracking_forget(dest_reg);
 }
 
 // move a 64bit constant value into a full register
@@ -196,11 +261,20 @@ static void gen_mov_reg_qword(HostReg dest_reg,uint64_t imm) {
 	cache_addb(0x48);
 	cache_addb(0xb8+dest_reg);			// mov dest_reg,imm
 	cache_addq(imm);
+	reg_tracking_forget(dest_reg);
 }
 
 // move 32bit (dword==true) or 16bit (dword==false) of a register into memory
 static void gen_mov_word_from_reg(HostReg src_reg,void* dest,bool dword,uint8_t prefix=0) {
 	gen_reg_memaddr(src_reg,dest,0x89,(dword?prefix:0x66));		// mov [data],reg
+	if (prefix) {
+		// full 64bit store
+		reg_tracking_mem_written(dest,8);
+		return;
+	}
+	const uint8_t size = dword ? 4 : 2;
+	reg_tracking_mem_written(dest,size);
+	reg_tracking_remember(src_reg,dest,size);
 }
 
 // move an 8bit value from memory into dest_reg
@@ -209,6 +283,7 @@ static void gen_mov_word_from_reg(HostReg src_reg,void* dest,bool dword,uint8_t
 // registers might not be directly byte-accessible on some architectures
 static void gen_mov_byte_to_reg_low(HostReg dest_reg,void* data) {
 	gen_reg_memaddr(dest_reg,data,0xb6,0x0f);	// movzx reg,[data]
+	reg_tracking_forget(dest_reg);
 }
 
 // move an 8bit value from memory into dest_reg
@@ -217,6 +292,7 @@ static void gen_mov_byte_to_reg_low(HostReg dest_reg,void* data) {
 // not directly byte-accessible on some architectures
 static void gen_mov_byte_to_reg_low_canuseword(HostReg dest_reg,void* data) {
 	gen_reg_memaddr(dest_reg,data,0xb6,0x0f);	// movzx reg,[data]
+	reg_tracking_forget(dest_reg);
 }
 
 // move an 8bit constant value into dest_reg
@@ -226,6 +302,7 @@ static void gen_mov_byte_to_reg_low_canuseword(HostReg dest_reg,void* data) {
 static void gen_mov_byte_to_reg_low_imm(HostReg dest_reg,uint8_t imm) {
 	cache_addb(0xb8+dest_reg);			// mov reg,imm
 	cache_addd((uint32_t)imm);
+	reg_tracking_forget(dest_reg);
 }
 
 // move an 8bit constant value into dest_reg
@@ -235,11 +312,13 @@ static void gen_mov_byte_to_reg_low_imm(HostReg dest_reg,uint8_t imm) {
 static void gen_mov_byte_to_reg_low_imm_canuseword(HostReg dest_reg,uint8_t imm) {
 	cache_addb(0xb8+dest_reg);			// mov reg,imm
 	cache_addd((uint32_t)imm);
+	reg_tracking_forget(dest_reg);
 }
 
 // move the lowest 8bit of a register into memory
 static void gen_mov_byte_from_reg_low(HostReg src_reg,void* dest) {
 	gen_reg_memaddr(src_reg,dest,0x88);	// mov byte [data],reg
+	reg_tracking_mem_written(dest,1);
 }
 
 
@@ -249,6 +328,7 @@ static void gen_mov_byte_from_reg_low(HostReg src_reg,void* dest) {
 static void gen_extend_byte(bool sign,HostReg reg) {
 	cache_addw(0xb60f+(sign?0x800:0));		// movsx/movzx
 	cache_addb(0xc0+(reg<<3)+reg);
+	reg_tracking_forget(reg);
 }
 
 // convert a 16bit word to a 32bit dword
@@ -256,6 +336,8 @@ static void gen_extend_byte(bool sign,HostReg reg) {
 static void gen_extend_word(bool sign,HostReg reg) {
 	cache_addw(0xb70f+(sign?0x800:0));		// movsx/movzx
 	cache_addb(0xc0+(reg<<3)+reg);
+	// the low word is unchanged
+	if (host_reg_contents[reg].size > 2) host_reg_contents[reg].size = 2;
 }
 
 
@@ -263,6 +345,7 @@ static void gen_extend_word(bool sign,HostReg reg) {
 // add a 32bit value from memory to a full register
 static void gen_add(HostReg reg,void* op) {
 	gen_reg_memaddr(reg,op,0x03);		// add reg,[data]
+	reg_tracking_forget(reg);
 }
 
 // add a 32bit constant value to a full register
@@ -270,12 +353,14 @@ static void gen_add_imm(HostReg reg,uint32_t imm) {
 	if (!imm) return;
 	cache_addw(0xc081+(reg<<8));		// add reg,imm
 	cache_addd(imm);
+	reg_tracking_forget(reg);
 }
 
 // and a 32bit constant value with a full register
 static void gen_and_imm(HostReg reg,uint32_t imm) {
 	cache_addw(0xe081+(reg<<8));		// and reg,imm
 	cache_addd(imm);
+	reg_tracking_forget(reg);
 }
 
 
@@ -283,6 +368,7 @@ static void gen_and_imm(HostReg reg,uint32_t imm) {
 // move a 32bit constant value into memory
 static void gen_mov_direct_dword(void* dest,uint32_t imm) {
 	gen_memaddr(0x4,dest,4,imm,0xc7);	// mov [data],imm
+	reg_tracking_mem_written(dest,4);
 }
 
 
@@ -297,6 +383,7 @@ static void inline gen_mov_direct_ptr(void* dest,Bitu imm) {
 static void gen_add_direct_byte(void* dest,int8_t imm) {
 	if (!imm) return;
 	gen_memaddr(0x4,dest,1,imm,0x83);	// add [data],imm
+	reg_tracking_mem_written(dest,4);
 }
 
 // add a 32bit (dword==true) or 16bit (dword==false) constant value to a memory value
@@ -307,12 +394,14 @@ static void gen_add_direct_word(void* dest,uint32_t imm,bool dword) {
 		return;
 	}
 	gen_memaddr(0x4,dest,(dword?4:2),imm,0x81,(dword?0:0x66));	// add [data],imm
+	reg_tracking_mem_written(dest,(dword?4:2));
 }
 
 // subtract an 8bit constant value from a memory value
 static void gen_sub_direct_byte(void* dest,int8_t imm) {
 	if (!imm) return;
 	gen_memaddr(0x2c,dest,1,imm,0x83);
+	reg_tracking_mem_written(dest,4);
 }
 
 // subtract a 32bit (dword==true) or 16bit (dword==false) constant value from a memory value
@@ -323,6 +412,7 @@ static void gen_sub_direct_word(void* dest,uint32_t imm,bool dword) {
 		return;
 	}
 	gen_memaddr(0x2c,dest,(dword?4:2),imm,0x81,(dword?0:0x66));	// sub [data],imm
+	reg_tracking_mem_written(dest,(dword?4:2));
 }
 
 
@@ -352,6 +442,7 @@ static inline void gen_lea(HostReg dest_reg,HostReg scale_reg,Bitu scale,Bits im
 	case 1:cache_addb(imm);break;
 	case 4:cache_addd(imm);break;
 	}
+	reg_tracking_forget(dest_reg);
 }
 
 // effective address calculation, destination is dest_reg
@@ -366,6 +457,7 @@ static inline void gen_lea(HostReg dest_reg,Bitu scale,Bits imm) {
 	cache_addb(0x05+(dest_reg<<3)+(scale<<6));
 
 	cache_addd(imm);		// always add dword immediate
+	reg_tracking_forget(dest_reg);
 }
 
 
@@ -375,6 +467,8 @@ static void inline gen_call_function_raw(void * func) {
 	cache_addw(0xb848);
 	cache_addq((uint64_t)func);
 	cache_addw(0xd0ff);
+	// the called function can change both registers and memory
+	gen_reset_reg_tracking();
 }
 
 // generate a call to a function with paramcount parameters
@@ -534,6 +628,7 @@ static void gen_jmp_ptr(void * ptr,Bits imm=0) {
 		cache_addb(0xa0);
 		cache_addd(imm);
 	}
+	gen_reset_reg_tracking();
 }
 
 
@@ -568,6 +663,8 @@ static void gen_fill_branch(const uint8_t* data) {
 		LOG_MSG("Big jump %" PRIdPTR, len);
 #endif
 	cache_addb((uint8_t)(cache.pos-data-1),data);
+	// this is a branch target, other paths can lead here
+	gen_reset_reg_tracking();
 }
 
 // conditional jump if register is nonzero
@@ -597,6 +694,8 @@ static const uint8_t* gen_create_branch_long_leqzero(HostReg reg) {
 // calculate long relative offset and fill it into the location pointed to by data
 static void gen_fill_branch_long(const uint8_t* data) {
 	cache_addd((uint32_t)(cache.pos-data-4),data);
+	// this is a branch target, other paths can lead here
+	gen_reset_reg_tracking();
 }
 
 static void gen_run_code(void) {
@@ -612,6 +711,7 @@ static void gen_run_code(void) {
 // return from a function
 static void gen_return_function(void) {
 	cache_addw(0xE5FF); // jmp rbp
+	gen_reset_reg_tracking();
 }
 
 #ifdef DRC_FLAGS_INVALIDATION
@@ -18,9 +18,6 @@
  */
 #include "dosbox.h"
 
-// Needed for std::isnan in simde
-#include <cmath>
-
 #include "callback.h"
 #include "cpu.h"
 #include "fpu.h"
@@ -28,12 +25,11 @@
 #include "lazyflags.h"
 #include "mem.h"
 #include "mmx.h"
+#include "mmx_ops.h"
 #include "paging.h"
 #include "pic.h"
 #include "tracy.h"
 
-#include "simde/x86/mmx.h"
-
 #if C_DEBUG
 #include "debug.h"
 #endif
@@ -109,8 +105,15 @@ static struct {
 	bool rep_zero;
 	Bitu prefixes;
 	GetEAHandler * ea_table;
+	// host memory of the code page being executed, see Fetchb()
+	struct {
+		HostPt base;
+		uint32_t page;
+	} fetch;
 } core;
 
+constexpr uint32_t NoFetchPage = UINT32_MAX;
+
 #define GETIP		(core.cseip-SegBase(cs))
 #define SAVEIP		reg_eip=GETIP;
 #define LOADIP		core.cseip=(SegBase(cs)+reg_eip);
@@ -119,19 +122,42 @@ static struct {
 #define BaseDS		core.base_ds
 #define BaseSS		core.base_ss
 
+// Instruction bytes are read straight from host memory as long as they are
+// within the code page that was looked up at the start of the instruction.
+// Anything else (page crossings, pages without a direct TLB pointer, memory
+// breakpoints) goes through the regular memory access functions. Code that
+// modifies itself writes to the same host memory, and TLB changes take effect
+// with the next instruction as the page is looked up again for each one.
+static inline void FetchLookupPage() {
+#if C_DEBUG && C_HEAVY_DEBUG
+	core.fetch.page=NoFetchPage;
+#else
+	core.fetch.base=get_tlb_read(core.cseip);
+	core.fetch.page=core.fetch.base ? (core.cseip >> 12) : NoFetchPage;
+#endif
+}
+
+static inline bool FetchIsDirect(const PhysPt len) {
+	return ((core.cseip >> 12) == core.fetch.page) &&
+	       ((core.cseip & 0xfff) <= 4096 - len);
+}
+
 static inline uint8_t Fetchb() {
-	uint8_t temp=LoadMb(core.cseip);
+	uint8_t temp=FetchIsDirect(1) ? host_readb(core.fetch.base+core.cseip)
+	                              : LoadMb(core.cseip);
 	core.cseip+=1;
 	return temp;
 }
 
 static inline uint16_t Fetchw() {
-	uint16_t temp=LoadMw(core.cseip);
+	uint16_t temp=FetchIsDirect(2) ? host_readw(core.fetch.base+core.cseip)
+	                               : LoadMw(core.cseip);
 	core.cseip+=2;
 	return temp;
 }
 static inline uint32_t Fetchd() {
-	uint32_t temp=LoadMd(core.cseip);
+	uint32_t temp=FetchIsDirect(4) ? host_readd(core.fetch.base+core.cseip)
+	                               : LoadMd(core.cseip);
 	core.cseip+=4;
 	return temp;
 }
@@ -153,6 +179,7 @@ Bits CPU_Core_Normal_Run() noexcept
 	ZoneScoped;
 	while (CPU_Cycles-->0) {
 		LOADIP;
+		FetchLookupPage();
 		core.opcode_index=cpu.code.big*0x200;
 		core.prefixes=cpu.code.big;
 		core.ea_table=&EATable[cpu.code.big*256];
@@ -177,10 +177,7 @@
 			GetEAa;
 			src.q = LoadMq(eaa);
 		}
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_psllw(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::psllw(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0xd1) // PSRLW Pq,Qq
@@ -197,10 +194,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_psrlw(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::psrlw(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0xe1) // PSRAW Pq,Qq
@@ -217,10 +211,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_psraw(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::psraw(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0x71) // PSLLW/PSRLW/PSRAW Pq,Ib
@@ -235,23 +226,14 @@
 	        switch (op) {
 	        case 0x06: // PSLLW
 	        {
-		        const auto dest_m = simde_m_from_int64(
-		                static_cast<int64_t>(dest->q));
-		        const auto res = simde_m_psllwi(dest_m, shift);
-		        dest->q = static_cast<uint64_t>(simde_m_to_int64(res));
+		        *dest = mmx::psllwi(*dest, shift);
 	        } break;
 	        case 0x02: // PSRLW
 	        {
-		        const auto dest_m = simde_m_from_int64(
-		                static_cast<int64_t>(dest->q));
-		        const auto res = simde_m_psrlwi(dest_m, shift);
-		        dest->q = static_cast<uint64_t>(simde_m_to_int64(res));
+		        *dest = mmx::psrlwi(*dest, shift);
 	        } break;
 	        case 0x04: // PSRAW
-		        const auto dest_m = simde_m_from_int64(
-		                static_cast<int64_t>(dest->q));
-		        const auto res = simde_m_psrawi(dest_m, shift);
-		        dest->q = static_cast<uint64_t>(simde_m_to_int64(res));
+		        *dest = mmx::psrawi(*dest, shift);
 		        break;
 	        }
 	        break;
@@ -270,10 +252,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_pslld(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::pslld(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0xd2) // PSRLD Pq,Qq
@@ -290,10 +269,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_psrld(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::psrld(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0xe2) // PSRAD Pq,Qq
@@ -310,10 +286,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_psrad(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::psrad(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0x72) // PSLLD/PSRLD/PSRAD Pq,Ib
@@ -328,24 +301,15 @@
 	        switch (op) {
 	        case 0x06: // PSLLD
 	        {
-		        const auto dest_m = simde_m_from_int64(
-		                static_cast<int64_t>(dest->q));
-		        const auto res = simde_m_pslldi(dest_m, shift);
-		        dest->q = static_cast<uint64_t>(simde_m_to_int64(res));
+		        *dest = mmx::pslldi(*dest, shift);
 	        } break;
 	        case 0x02: // PSRLD
 	        {
-		        const auto dest_m = simde_m_from_int64(
-		                static_cast<int64_t>(dest->q));
-		        const auto res = simde_m_psrldi(dest_m, shift);
-		        dest->q = static_cast<uint64_t>(simde_m_to_int64(res));
+		        *dest = mmx::psrldi(*dest, shift);
 	        } break;
 	        case 0x04: // PSRAD
 	        {
-		        const auto dest_m = simde_m_from_int64(
-		                static_cast<int64_t>(dest->q));
-		        const auto res = simde_m_psradi(dest_m, shift);
-		        dest->q = static_cast<uint64_t>(simde_m_to_int64(res));
+		        *dest = mmx::psradi(*dest, shift);
 	        } break;
 	        }
 	        break;
@@ -364,10 +328,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_psllq(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::psllq(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0xd3) // PSRLQ Pq,Qq
@@ -384,10 +345,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_psrlq(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::psrlq(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0x73) // PSLLQ/PSRLQ Pq,Ib
@@ -426,10 +384,7 @@
 			GetEAa;
 			src.q = LoadMq(eaa);
 		}
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_paddb(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::paddb(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0xFD) // PADDW Pq,Qq
@@ -446,10 +401,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_paddw(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::paddw(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0xFE) // PADDD Pq,Qq
@@ -466,10 +418,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_paddd(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::paddd(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0xEC) // PADDSB Pq,Qq
@@ -486,10 +435,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_paddsb(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::paddsb(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0xED) // PADDSW Pq,Qq
@@ -506,10 +452,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_paddsw(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::paddsw(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0xDC) // PADDUSB Pq,Qq
@@ -526,10 +469,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_paddusb(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::paddusb(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0xDD) // PADDUSW Pq,Qq
@@ -546,10 +486,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_paddusw(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::paddusw(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0xF8) // PSUBB Pq,Qq
@@ -566,10 +503,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_psubb(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::psubb(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0xF9) // PSUBW Pq,Qq
@@ -586,10 +520,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_psubw(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::psubw(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0xFA) // PSUBD Pq,Qq
@@ -606,10 +537,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_psubd(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::psubd(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0xE8) // PSUBSB Pq,Qq
@@ -626,10 +554,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_psubsb(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::psubsb(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0xE9) // PSUBSW Pq,Qq
@@ -646,10 +571,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_psubsw(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::psubsw(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0xD8) // PSUBUSB Pq,Qq
@@ -666,10 +588,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_psubusb(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::psubusb(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0xD9) // PSUBUSW Pq,Qq
@@ -686,10 +605,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_psubusw(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::psubusw(*dest, src);
 
 	        break;
         }
@@ -707,10 +623,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_pmulhw(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::pmulhw(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0xD5) // PMULLW Pq,Qq
@@ -727,10 +640,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_pmullw(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::pmullw(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0xF5) // PMADDWD Pq,Qq
@@ -747,10 +657,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_pmaddwd(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::pmaddwd(*dest, src);
 	        break;
         }
 
@@ -769,10 +676,7 @@
 			GetEAa;
 			src.q = LoadMq(eaa);
 		}
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_pcmpeqb(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::pcmpeqb(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0x75) // PCMPEQW Pq,Qq
@@ -789,10 +693,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_pcmpeqw(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::pcmpeqw(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0x76) // PCMPEQD Pq,Qq
@@ -809,10 +710,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_pcmpeqd(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::pcmpeqd(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0x64) // PCMPGTB Pq,Qq
@@ -829,10 +727,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_pcmpgtb(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::pcmpgtb(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0x65) // PCMPGTW Pq,Qq
@@ -849,10 +744,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_pcmpgtw(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::pcmpgtw(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0x66) // PCMPGTD Pq,Qq
@@ -869,10 +761,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_pcmpgtd(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::pcmpgtd(*dest, src);
 	        break;
         }
 
@@ -891,10 +780,7 @@
 			GetEAa;
 			src.q = LoadMq(eaa);
 		}
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_packsswb(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::packsswb(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0x6B) // PACKSSDW Pq,Qq
@@ -911,10 +797,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_packssdw(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::packssdw(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0x67) // PACKUSWB Pq,Qq
@@ -931,10 +814,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_packuswb(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::packuswb(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0x68) // PUNPCKHBW Pq,Qq
@@ -951,10 +831,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_punpckhbw(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::punpckhbw(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0x69) // PUNPCKHWD Pq,Qq
@@ -971,10 +848,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_punpckhwd(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::punpckhwd(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0x6A) // PUNPCKHDQ Pq,Qq
@@ -991,10 +865,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_punpckhdq(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::punpckhdq(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0x60) // PUNPCKLBW Pq,Qq
@@ -1011,10 +882,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_punpcklbw(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::punpcklbw(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0x61) // PUNPCKLWD Pq,Qq
@@ -1031,10 +899,7 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_punpcklwd(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::punpcklwd(*dest, src);
 	        break;
         }
         CASE_0F_MMX(0x62) // PUNPCKLDQ Pq,Qq
@@ -1051,9 +916,6 @@
 		        GetEAa;
 		        src.q = LoadMq(eaa);
 	        }
-	        const auto src_m = simde_m_from_int64(static_cast<int64_t>(src.q));
-	        const auto dest_m = simde_m_from_int64(static_cast<int64_t>(dest->q));
-	        const auto res = simde_m_punpckldq(dest_m, src_m);
-	        dest->q        = static_cast<uint64_t>(simde_m_to_int64(res));
+	        *dest = mmx::punpckldq(*dest, src);
 	        break;
         }
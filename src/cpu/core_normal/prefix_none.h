@@ -1107,6 +1107,10 @@
 				{
 					Bitu cb=Fetchw();
 					FillFlags();SAVEIP;
+					if (CALLBACK_RunFast(cb)) {
+						LOADIP;
+						break;
+					}
 					return cb;
 				}
 			default:
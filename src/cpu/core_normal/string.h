@@ -52,86 +52,185 @@ static void DoString(STRING_OP type) {
 	auto add_index = cpu.direction;
 	if (count) switch (type) {
 	case R_OUTSB:
-		for (;count>0;count--) {
+		while (count > 0) {
+			if (const auto done = string_bulk_outs<uint8_t>(
+			            reg_dx, si_base, si_index, add_mask, add_index > 0,
+			            static_cast<Bitu>(count))) {
+				si_index = string_advance(si_index, done, add_index, add_mask);
+				count -= done;
+				continue;
+			}
 			IO_WriteB(reg_dx,LoadMb(si_base+si_index));
 			si_index=(si_index+add_index) & add_mask;
+			count--;
 		}
 		break;
 	case R_OUTSW:
 		add_index *= 2;
-		for (;count>0;count--) {
+		while (count > 0) {
+			if (const auto done = string_bulk_outs<uint16_t>(
+			            reg_dx, si_base, si_index, add_mask, add_index > 0,
+			            static_cast<Bitu>(count))) {
+				si_index = string_advance(si_index, done, add_index, add_mask);
+				count -= done;
+				continue;
+			}
 			IO_WriteW(reg_dx,LoadMw(si_base+si_index));
 			si_index=(si_index+add_index) & add_mask;
+			count--;
 		}
 		break;
 	case R_OUTSD:
 		add_index *= 4;
-		for (;count>0;count--) {
+		while (count > 0) {
+			if (const auto done = string_bulk_outs<uint32_t>(
+			            reg_dx, si_base, si_index, add_mask, add_index > 0,
+			            static_cast<Bitu>(count))) {
+				si_index = string_advance(si_index, done, add_index, add_mask);
+				count -= done;
+				continue;
+			}
 			IO_WriteD(reg_dx,LoadMd(si_base+si_index));
 			si_index=(si_index+add_index) & add_mask;
+			count--;
 		}
 		break;
 	case R_INSB:
-		for (;count>0;count--) {
+		while (count > 0) {
+			if (const auto done = string_bulk_ins<uint8_t>(
+			            reg_dx, di_base, di_index, add_mask, add_index > 0,
+			            static_cast<Bitu>(count))) {
+				di_index = string_advance(di_index, done, add_index, add_mask);
+				count -= done;
+				continue;
+			}
 			SaveMb(di_base+di_index,IO_ReadB(reg_dx));
 			di_index=(di_index+add_index) & add_mask;
+			count--;
 		}
 		break;
 	case R_INSW:
 		add_index *= 2;
-		for (;count>0;count--) {
+		while (count > 0) {
+			if (const auto done = string_bulk_ins<uint16_t>(
+			            reg_dx, di_base, di_index, add_mask, add_index > 0,
+			            static_cast<Bitu>(count))) {
+				di_index = string_advance(di_index, done, add_index, add_mask);
+				count -= done;
+				continue;
+			}
 			SaveMw(di_base+di_index,IO_ReadW(reg_dx));
 			di_index=(di_index+add_index) & add_mask;
+			count--;
 		}
 		break;
 	case R_INSD:
 		add_index *= 4;
-		for (;count>0;count--) {
+		while (count > 0) {
+			if (const auto done = string_bulk_ins<uint32_t>(
+			            reg_dx, di_base, di_index, add_mask, add_index > 0,
+			            static_cast<Bitu>(count))) {
+				di_index = string_advance(di_index, done, add_index, add_mask);
+				count -= done;
+				continue;
+			}
 			SaveMd(di_base+di_index,IO_ReadD(reg_dx));
 			di_index=(di_index+add_index) & add_mask;
+			count--;
 		}
 		break;
 	case R_STOSB:
-		for (;count>0;count--) {
+		while (count > 0) {
+			if (const auto done = string_bulk_stos<uint8_t>(
+			            di_base, di_index, add_mask, add_index > 0,
+			            static_cast<Bitu>(count), reg_al)) {
+				di_index = string_advance(di_index, done, add_index, add_mask);
+				count -= done;
+				continue;
+			}
 			SaveMb(di_base+di_index,reg_al);
 			di_index=(di_index+add_index) & add_mask;
+			count--;
 		}
 		break;
 	case R_STOSW:
 		add_index *= 2;
-		for (;count>0;count--) {
+		while (count > 0) {
+			if (const auto done = string_bulk_stos<uint16_t>(
+			            di_base, di_index, add_mask, add_index > 0,
+			            static_cast<Bitu>(count), reg_ax)) {
+				di_index = string_advance(di_index, done, add_index, add_mask);
+				count -= done;
+				continue;
+			}
 			SaveMw(di_base+di_index,reg_ax);
 			di_index=(di_index+add_index) & add_mask;
+			count--;
 		}
 		break;
 	case R_STOSD:
 		add_index *= 4;
-		for (;count>0;count--) {
+		while (count > 0) {
+			if (const auto done = string_bulk_stos<uint32_t>(
+			            di_base, di_index, add_mask, add_index > 0,
+			            static_cast<Bitu>(count), reg_eax)) {
+				di_index = string_advance(di_index, done, add_index, add_mask);
+				count -= done;
+				continue;
+			}
 			SaveMd(di_base+di_index,reg_eax);
 			di_index=(di_index+add_index) & add_mask;
+			count--;
 		}
 		break;
 	case R_MOVSB:
-		for (;count>0;count--) {
+		while (count > 0) {
+			if (const auto done = string_bulk_movs<uint8_t>(
+			            si_base, si_index, di_base, di_index, add_mask,
+			            add_index > 0, static_cast<Bitu>(count))) {
+				di_index = string_advance(di_index, done, add_index, add_mask);
+				si_index = string_advance(si_index, done, add_index, add_mask);
+				count -= done;
+				continue;
+			}
 			SaveMb(di_base+di_index,LoadMb(si_base+si_index));
 			di_index=(di_index+add_index) & add_mask;
 			si_index=(si_index+add_index) & add_mask;
+			count--;
 		}
 		break;
 	case R_MOVSW:
 		add_index *= 2;
-		for (;count>0;count--) {
+		while (count > 0) {
+			if (const auto done = string_bulk_movs<uint16_t>(
+			            si_base, si_index, di_base, di_index, add_mask,
+			            add_index > 0, static_cast<Bitu>(count))) {
+				di_index = string_advance(di_index, done, add_index, add_mask);
+				si_index = string_advance(si_index, done, add_index, add_mask);
+				count -= done;
+				continue;
+			}
 			SaveMw(di_base+di_index,LoadMw(si_base+si_index));
 			di_index=(di_index+add_index) & add_mask;
 			si_index=(si_index+add_index) & add_mask;
+			count--;
 		}
 		break;
 	case R_MOVSD:
 		add_index *= 4;
-		for (;count>0;count--) {
+		while (count > 0) {
+			if (const auto done = string_bulk_movs<uint32_t>(
+			            si_base, si_index, di_base, di_index, add_mask,
+			            add_index > 0, static_cast<Bitu>(count))) {
+				di_index = string_advance(di_index, done, add_index, add_mask);
+				si_index = string_advance(si_index, done, add_index, add_mask);
+				count -= done;
+				continue;
+			}
 			SaveMd(di_base+di_index,LoadMd(si_base+si_index));
 			di_index=(di_index+add_index) & add_mask;
 			si_index=(si_index+add_index) & add_mask;
+			count--;
 		}
 		break;
 	case R_LODSB:
@@ -18,9 +18,7 @@
  */
 
 #include <cstdio>
-
-// Needed for std::isnan in simde
-#include <cmath>
+#include <cstring>
 
 #include "callback.h"
 #include "cpu.h"
@@ -30,10 +28,10 @@
 #include "lazyflags.h"
 #include "mem.h"
 #include "mmx.h"
+#include "mmx_ops.h"
 #include "paging.h"
 #include "pic.h"
 
-#include "simde/x86/mmx.h"
 
 #if C_DEBUG
 #include "debug.h"
@@ -126,22 +124,57 @@ static uint8_t prefetch_buffer[MAX_PQ_SIZE];
 static bool pq_valid=false;
 static Bitu pq_start;
 
+// Fills the queue from the given index on with the code at the given
+// address. When that's all on one page mapped straight to host memory it's
+// copied in one go, instead of going through the TLB byte by byte.
+static void fill_prefetch_buffer(const Bitu start_idx, const PhysPt address)
+{
+	const auto num_bytes = CPU_PrefetchQueueSize - start_idx;
+#if !(C_DEBUG && C_HEAVY_DEBUG)
+	// Heavy debugging checks the fetches for memory read breakpoints
+	if ((address & 0xfff) + num_bytes <= 0x1000) {
+		if (const auto tlb_addr = get_tlb_read(address); tlb_addr) {
+			memcpy(&prefetch_buffer[start_idx], tlb_addr + address, num_bytes);
+			return;
+		}
+	}
+#endif
+	for (Bitu i = 0; i < num_bytes; i++) {
+		prefetch_buffer[start_idx + i] = LoadMb(address + i);
+	}
+}
+
+static void refill_prefetch_queue()
+{
+	fill_prefetch_buffer(0, core.cseip);
+	pq_start = core.cseip;
+	pq_valid = true;
+}
+
+// Once the given number of bytes has been fetched, the consumed part of the
+// queue is dropped when fewer than 4 bytes would be left, and the queue is
+// topped up again
+static void maybe_advance_prefetch_queue(const Bitu num_fetched)
+{
+	const auto next = core.cseip + num_fetched;
+	if ((next >= pq_start + CPU_PrefetchQueueSize - 4) &&
+	    (next < pq_start + CPU_PrefetchQueueSize)) {
+		const auto remaining_bytes = pq_start + CPU_PrefetchQueueSize - next;
+		memmove(prefetch_buffer, &prefetch_buffer[next - pq_start], remaining_bytes);
+		fill_prefetch_buffer(remaining_bytes,
+		                     static_cast<PhysPt>(next + remaining_bytes));
+		pq_start = next;
+		pq_valid = true;
+	}
+}
+
 static uint8_t Fetchb() {
 	uint8_t temp;
 	if (pq_valid && (core.cseip>=pq_start) && (core.cseip<pq_start+CPU_PrefetchQueueSize)) {
 		temp=prefetch_buffer[core.cseip-pq_start];
-		if ((core.cseip+1>=pq_start+CPU_PrefetchQueueSize-4) &&
-			(core.cseip+1<pq_start+CPU_PrefetchQueueSize)) {
-			Bitu remaining_bytes=pq_start+CPU_PrefetchQueueSize-(core.cseip+1);
-			for (Bitu i=0; i<remaining_bytes; i++) prefetch_buffer[i]=prefetch_buffer[core.cseip+1-pq_start+i];
-			for (Bitu i=remaining_bytes; i<CPU_PrefetchQueueSize; i++) prefetch_buffer[i]=LoadMb(core.cseip+1+i);
-			pq_start=core.cseip+1;
-			pq_valid=true;
-		}
+		maybe_advance_prefetch_queue(1);
 	} else {
-		for (Bitu i=0; i<CPU_PrefetchQueueSize; i++) prefetch_buffer[i]=LoadMb(core.cseip+i);
-		pq_start=core.cseip;
-		pq_valid=true;
+		refill_prefetch_queue();
 		temp=prefetch_buffer[0];
 	}
 /*	if (temp!=LoadMb(core.cseip)) {
@@ -156,18 +189,9 @@ static uint16_t Fetchw() {
 	if (pq_valid && (core.cseip>=pq_start) && (core.cseip+2<pq_start+CPU_PrefetchQueueSize)) {
 		temp=prefetch_buffer[core.cseip-pq_start]|
 			(prefetch_buffer[core.cseip-pq_start+1]<<8);
-		if ((core.cseip+2>=pq_start+CPU_PrefetchQueueSize-4) &&
-			(core.cseip+2<pq_start+CPU_PrefetchQueueSize)) {
-			Bitu remaining_bytes=pq_start+CPU_PrefetchQueueSize-(core.cseip+2);
-			for (Bitu i=0; i<remaining_bytes; i++) prefetch_buffer[i]=prefetch_buffer[core.cseip+2-pq_start+i];
-			for (Bitu i=remaining_bytes; i<CPU_PrefetchQueueSize; i++) prefetch_buffer[i]=LoadMb(core.cseip+2+i);
-			pq_start=core.cseip+2;
-			pq_valid=true;
-		}
+		maybe_advance_prefetch_queue(2);
 	} else {
-		for (Bitu i=0; i<CPU_PrefetchQueueSize; i++) prefetch_buffer[i]=LoadMb(core.cseip+i);
-		pq_start=core.cseip;
-		pq_valid=true;
+		refill_prefetch_queue();
 		temp=prefetch_buffer[0] | (prefetch_buffer[1]<<8);
 	}
 /*	if (temp!=LoadMw(core.cseip)) {
@@ -184,18 +208,9 @@ static uint32_t Fetchd() {
 			(prefetch_buffer[core.cseip-pq_start+1]<<8)|
 			(prefetch_buffer[core.cseip-pq_start+2]<<16)|
 			(prefetch_buffer[core.cseip-pq_start+3]<<24);
-		if ((core.cseip+4>=pq_start+CPU_PrefetchQueueSize-4) &&
-			(core.cseip+4<pq_start+CPU_PrefetchQueueSize)) {
-			Bitu remaining_bytes=pq_start+CPU_PrefetchQueueSize-(core.cseip+4);
-			for (Bitu i=0; i<remaining_bytes; i++) prefetch_buffer[i]=prefetch_buffer[core.cseip+4-pq_start+i];
-			for (Bitu i=remaining_bytes; i<CPU_PrefetchQueueSize; i++) prefetch_buffer[i]=LoadMb(core.cseip+4+i);
-			pq_start=core.cseip+4;
-			pq_valid=true;
-		}
+		maybe_advance_prefetch_queue(4);
 	} else {
-		for (Bitu i=0; i<CPU_PrefetchQueueSize; i++) prefetch_buffer[i]=LoadMb(core.cseip+i);
-		pq_start=core.cseip;
-		pq_valid=true;
+		refill_prefetch_queue();
 		temp=prefetch_buffer[0] | (prefetch_buffer[1]<<8) |
 			(prefetch_buffer[2]<<16) | (prefetch_buffer[3]<<24);
 	}
@@ -18,9 +18,6 @@
  */
 #include "dosbox.h"
 
-// Needed for std::isnan in simde
-#include <cmath>
-
 #include "callback.h"
 #include "cpu.h"
 #include "fpu.h"
@@ -28,12 +25,11 @@
 #include "lazyflags.h"
 #include "mem.h"
 #include "mmx.h"
+#include "mmx_ops.h"
 #include "paging.h"
 #include "pic.h"
 #include "tracy.h"
 
-#include "simde/x86/mmx.h"
-
 #if C_DEBUG
 #include "debug.h"
 #endif
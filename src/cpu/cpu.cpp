@@ -19,17 +19,21 @@
 
 #include "cpu.h"
 
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <cstddef>
 #include <sstream>
 
 #include "debug.h"
+#include "event_counters.h"
 #include "mapper.h"
 #include "setup.h"
 #include "programs.h"
 #include "paging.h"
 #include "pic.h"
 #include "lazyflags.h"
+#include "savestate.h"
 #include "mapper.h"
 #include "memory.h"
 #include "paging.h"
@@ -64,6 +68,8 @@ int32_t CPU_CycleDown = 0;
 int64_t CPU_IODelayRemoved = 0;
 CPU_Decoder * cpudecoder;
 bool CPU_CycleAutoAdjust = false;
+bool CPU_UseCyclesGovernor = false;
+int CPU_CyclesHeadroom = 10;
 Bitu CPU_AutoDetermineMode = 0;
 
 ArchitectureType CPU_ArchitectureType = ArchitectureType::Mixed;
@@ -79,11 +85,17 @@ void CPU_Core_Simple_Init(void);
 void CPU_Core_Dyn_X86_Init(void);
 void CPU_Core_Dyn_X86_Cache_Init(bool enable_cache);
 void CPU_Core_Dyn_X86_Cache_Close(void);
+void CPU_Core_Dyn_X86_Cache_Reset();
 void CPU_Core_Dyn_X86_SetFPUMode(bool dh_fpu);
+void CPU_Core_Dyn_X86_SetCacheSize(const size_t size_mb);
 #elif (C_DYNREC)
 void CPU_Core_Dynrec_Init(void);
 void CPU_Core_Dynrec_Cache_Init(bool enable_cache);
 void CPU_Core_Dynrec_Cache_Close(void);
+void CPU_Core_Dynrec_Cache_Reset();
+void CPU_Core_Dynrec_SetCacheSize(const size_t size_mb);
+void CPU_Core_Dynrec_SetPersistentCache(const bool enabled);
+void CPU_Core_Dynrec_SetTieringThreshold(const uint8_t threshold);
 #endif
 
 /* In debug mode exceptions are tested and dosbox exits when 
@@ -562,8 +574,13 @@ void CPU_DebugException(uint32_t triggers,Bitu oldeip) {
 	CPU_Interrupt(EXCEPTION_DB,CPU_INT_EXCEPTION,oldeip);
 }
 
+static EventCounter page_faults("Page faults");
+
 void CPU_Exception(Bitu which,Bitu error ) {
 //	LOG_MSG("Exception %d error %x",which,error);
+	if (which == EXCEPTION_PF) {
+		page_faults.Add();
+	}
 	cpu.exception.error=error;
 	CPU_Interrupt(which,CPU_INT_EXCEPTION | ((which>=8) ? CPU_INT_HAS_ERROR : 0),reg_eip);
 }
@@ -1633,6 +1650,21 @@ void CPU_SET_CRX(Bitu cr,Bitu value) {
 	case 3:
 		PAGING_SetDirBase(value);
 		break;
+	case 4: {
+		// Only the 4 MB pages of the Pentium are emulated
+		const Bitu supported = CPU_ArchitectureType >= ArchitectureType::Pentium
+		                             ? CR4_PAGESIZEEXTENSIONS
+		                             : 0;
+		if (value & ~supported) {
+			LOG(LOG_CPU, LOG_NORMAL)("Unhandled CR4 bits %X", value & ~supported);
+		}
+		const auto changed = cpu.cr4 ^ (value & supported);
+		cpu.cr4 = value & supported;
+		if (changed & CR4_PAGESIZEEXTENSIONS) {
+			PAGING_FlushTLB();
+		}
+		break;
+	}
 	default:
 		LOG(LOG_CPU,LOG_ERROR)("Unhandled MOV CR%d,%X",cr,value);
 		break;
@@ -1660,6 +1692,8 @@ Bitu CPU_GET_CRX(Bitu cr) {
 		return paging.cr2;
 	case 3:
 		return PAGING_GetDirBase() & 0xfffff000;
+	case 4:
+		return cpu.cr4;
 	default:
 		LOG(LOG_CPU,LOG_ERROR)("Unhandled MOV XXX, CR%d",cr);
 		break;
@@ -1922,6 +1956,69 @@ void CPU_VERW(Bitu selector) {
 	SETFLAGBIT(ZF,true);
 }
 
+// Protected mode segment load cache
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// 16-bit protected mode code reloads the data and stack segment registers
+// all the time, mostly with the same few selectors. The outcome of the
+// type, privilege and presence checks only depends on the selector, the
+// CPL and the descriptor itself, so successful loads are remembered by
+// selector. A hit still reads the descriptor from the table and compares
+// it with the remembered one, which keeps the cache coherent with guest
+// writes to the tables, LGDT, LLDT and task switches without having to
+// watch for them.
+
+struct SegLoadCacheEntry {
+	uint32_t raw[2] = {};
+	uint16_t value  = 0;
+	uint8_t cpl     = 0;
+	bool is_stack   = false;
+	bool valid      = false;
+};
+
+static std::array<SegLoadCacheEntry, 64> seg_load_cache = {};
+
+static EventCounter seg_load_cache_hits("Segment load cache hits");
+
+static SegLoadCacheEntry& get_seg_load_cache_entry(const Bitu value)
+{
+	return seg_load_cache[(value >> 2) & (seg_load_cache.size() - 1)];
+}
+
+static bool is_seg_load_cached(const Bitu value, const Descriptor& desc,
+                               const bool is_stack)
+{
+	const auto& entry = get_seg_load_cache_entry(value);
+	return entry.valid && entry.value == value && entry.cpl == cpu.cpl &&
+	       entry.is_stack == is_stack && entry.raw[0] == desc.saved.fill[0] &&
+	       entry.raw[1] == desc.saved.fill[1];
+}
+
+static void cache_seg_load(const Bitu value, const Descriptor& desc,
+                           const bool is_stack)
+{
+	auto& entry = get_seg_load_cache_entry(value);
+
+	entry.raw[0]   = desc.saved.fill[0];
+	entry.raw[1]   = desc.saved.fill[1];
+	entry.value    = static_cast<uint16_t>(value);
+	entry.cpl      = static_cast<uint8_t>(cpu.cpl);
+	entry.is_stack = is_stack;
+	entry.valid    = true;
+}
+
+static void set_stack_size(const bool big)
+{
+	if (big) {
+		cpu.stack.big=true;
+		cpu.stack.mask=0xffffffff;
+		cpu.stack.notmask=0;
+	} else {
+		cpu.stack.big=false;
+		cpu.stack.mask=0xffff;
+		cpu.stack.notmask=0xffff0000;
+	}
+}
+
 bool CPU_SetSegGeneral(SegNames seg,Bitu value) {
 	value &= 0xffff;
 	if (!cpu.pmode || (reg_flags & FLAG_VM)) {
@@ -1945,6 +2042,14 @@ bool CPU_SetSegGeneral(SegNames seg,Bitu value) {
 //				E_Exit("CPU_SetSegGeneral: Stack segment beyond limits");
 				return CPU_PrepareException(EXCEPTION_GP,value & 0xfffc);
 			}
+			constexpr bool is_stack = true;
+			if (is_seg_load_cached(value, desc, is_stack)) {
+				seg_load_cache_hits.Add();
+				Segs.val[seg]=value;
+				Segs.phys[seg]=desc.GetBase();
+				set_stack_size(desc.Big());
+				return false;
+			}
 			if (((value & 3)!=cpu.cpl) || (desc.DPL()!=cpu.cpl)) {
 //				E_Exit("CPU_SetSegGeneral: Stack segment with invalid privileges");
 				return CPU_PrepareException(EXCEPTION_GP,value & 0xfffc);
@@ -1966,15 +2071,8 @@ bool CPU_SetSegGeneral(SegNames seg,Bitu value) {
 
 			Segs.val[seg]=value;
 			Segs.phys[seg]=desc.GetBase();
-			if (desc.Big()) {
-				cpu.stack.big=true;
-				cpu.stack.mask=0xffffffff;
-				cpu.stack.notmask=0;
-			} else {
-				cpu.stack.big=false;
-				cpu.stack.mask=0xffff;
-				cpu.stack.notmask=0xffff0000;
-			}
+			set_stack_size(desc.Big());
+			cache_seg_load(value, desc, is_stack);
 		} else {
 			if ((value & 0xfffc)==0) {
 				Segs.val[seg]=value;
@@ -1985,6 +2083,13 @@ bool CPU_SetSegGeneral(SegNames seg,Bitu value) {
 			if (!cpu.gdt.GetDescriptor(value,desc)) {
 				return CPU_PrepareException(EXCEPTION_GP,value & 0xfffc);
 			}
+			constexpr bool is_stack = false;
+			if (is_seg_load_cached(value, desc, is_stack)) {
+				seg_load_cache_hits.Add();
+				Segs.val[seg]=value;
+				Segs.phys[seg]=desc.GetBase();
+				return false;
+			}
 			switch (desc.Type()) {
 			case DESC_DATA_EU_RO_NA:		case DESC_DATA_EU_RO_A:
 			case DESC_DATA_EU_RW_NA:		case DESC_DATA_EU_RW_A:
@@ -2010,6 +2115,7 @@ bool CPU_SetSegGeneral(SegNames seg,Bitu value) {
 
 			Segs.val[seg]=value;
 			Segs.phys[seg]=desc.GetBase();
+			cache_seg_load(value, desc, is_stack);
 		}
 
 		return false;
@@ -2050,13 +2156,13 @@ bool CPU_CPUID(void) {
 		} else if (CPU_ArchitectureType == ArchitectureType::Pentium) {
 #if (C_FPU)
 			reg_eax = 0x517; // Intel Pentium P5 60/66 MHz D1-step
-			reg_edx = 0x11;  // FPU + Time Stamp Counter (RDTSC)
+			reg_edx = 0x19;  // FPU + 4 MB pages (PSE) + Time Stamp Counter (RDTSC)
 #else
 			// All Pentiums had FPU built-in, so when FPU is
 			// disabled, we pretend to have early Pentium model with
 			// FDIV bug present.
 			reg_eax = 0x513; // Intel Pentium P5 60/66 MHz B1-step
-			reg_edx = 0x10;  // Time Stamp Counter (RDTSC)
+			reg_edx = 0x18;  // 4 MB pages (PSE) + Time Stamp Counter (RDTSC)
 #endif
 			reg_ebx = 0;     // Not supported
 			reg_ecx = 0;     // No features
@@ -2064,7 +2170,7 @@ bool CPU_CPUID(void) {
 			reg_eax = 0x543;      // Intel Pentium MMX
 			reg_ebx = 0;          // Not supported
 			reg_ecx = 0;          // No features
-			reg_edx = 0x00800011; // FPU + Time Stamp Counter (RDTSC) + MMX
+			reg_edx = 0x00800019; // FPU + PSE + Time Stamp Counter (RDTSC) + MMX
 		} else {
 			return false;
 		}
@@ -2080,21 +2186,95 @@ bool CPU_CPUID(void) {
 	return true;
 }
 
+// Idle detection
+// ~~~~~~~~~~~~~~
+// All the ways the guest signals it's waiting end up here. The cycles left
+// until the next PIC event are dropped, so emulated time gets there at once
+// and the main loop sleeps when it's ahead of the host. Dropped cycles are
+// accounted like the IO delay ones, so the auto cycles don't climb on an
+// idle guest.
+
+// Empty polls within one tick after which the guest is considered to be
+// spinning; a program polling once per frame never gets there
+constexpr int IdlePollsPerTick = 16;
+
+static struct {
+	double idle_ms[enum_val(IdleSource::NumSources)] = {};
+	double start_ms = 0.0;
+
+	uint32_t poll_tick = 0;
+	int num_polls      = 0;
+} idle = {};
+
+static void drop_cycles_as_idle(const IdleSource source)
+{
+	if (CPU_Cycles > 0 && CPU_CycleMax > 0) {
+		idle.idle_ms[enum_val(source)] += static_cast<double>(CPU_Cycles) /
+		                                  CPU_CycleMax;
+	}
+	CPU_IODelayRemoved += CPU_Cycles;
+	CPU_Cycles = 0;
+}
+
+void CPU_Idle(const IdleSource source)
+{
+	drop_cycles_as_idle(source);
+}
+
+void CPU_IdlePoll(const IdleSource source, const bool found_something)
+{
+	if (found_something) {
+		idle.num_polls = 0;
+		return;
+	}
+	if (idle.poll_tick != PIC_Ticks) {
+		idle.poll_tick = PIC_Ticks;
+		idle.num_polls = 0;
+	}
+	if (++idle.num_polls >= IdlePollsPerTick) {
+		drop_cycles_as_idle(source);
+	}
+}
+
+double CPU_GetIdlePercent(const IdleSource source)
+{
+	const auto elapsed_ms = PIC_FullIndex() - idle.start_ms;
+	if (elapsed_ms <= 0.0) {
+		return 0.0;
+	}
+	return std::min(idle.idle_ms[enum_val(source)] * 100.0 / elapsed_ms, 100.0);
+}
+
+double CPU_GetIdlePercent()
+{
+	double percent = 0.0;
+	for (uint8_t i = 0; i < enum_val(IdleSource::NumSources); ++i) {
+		percent += CPU_GetIdlePercent(static_cast<IdleSource>(i));
+	}
+	return std::min(percent, 100.0);
+}
+
+void CPU_ResetIdleStats()
+{
+	for (auto& ms : idle.idle_ms) {
+		ms = 0.0;
+	}
+	idle.start_ms = PIC_FullIndex();
+}
+
 static Bits HLT_Decode(void) {
 	/* Once an interrupt occurs, it should change cpu core */
 	if (reg_eip!=cpu.hlt.eip || SegValue(cs) != cpu.hlt.cs) {
 		cpudecoder=cpu.hlt.old_decoder;
 	} else {
-		CPU_IODelayRemoved += CPU_Cycles;
-		CPU_Cycles=0;
+		drop_cycles_as_idle(IdleSource::Halt);
 	}
 	return 0;
 }
 
 void CPU_HLT(Bitu oldeip) {
 	reg_eip=oldeip;
-	CPU_IODelayRemoved += CPU_Cycles;
-	CPU_Cycles=0;
+	drop_cycles_as_idle(IdleSource::Halt);
 	cpu.hlt.cs=SegValue(cs);
 	cpu.hlt.eip=reg_eip;
 	cpu.hlt.old_decoder=cpudecoder;
@@ -2280,6 +2460,7 @@ public:
 		CPU_SetFlags(FLAG_IF,FMASK_ALL);		//Enable interrupts
 		cpu.cr0=0xffffffff;
 		CPU_SET_CRX(0,0);						//Initialize
+		cpu.cr4=0;
 		cpu.code.big=false;
 		cpu.stack.mask=0xffff;
 		cpu.stack.notmask=0xffff0000;
@@ -2398,6 +2579,9 @@ public:
 
 		CPU_CycleUp=section->Get_int("cycleup");
 		CPU_CycleDown=section->Get_int("cycledown");
+		CPU_UseCyclesGovernor = (section->Get_string("cycles_governor") == "pid");
+		CPU_CyclesHeadroom = section->Get_int("cycles_headroom");
+		PAGING_SetTaggedTLB(section->Get_bool("tagged_tlb"));
 		std::string core(section->Get_string("core"));
 		cpudecoder=&CPU_Core_Normal_Run;
 		if (core == "normal") {
@@ -2427,9 +2611,18 @@ public:
 #endif
 		}
 
+#if (C_DYNAMIC_X86) || (C_DYNREC)
+		const auto cache_size_mb = static_cast<size_t>(
+		        section->Get_int("dynamic_core_memsize"));
+#endif
 #if (C_DYNAMIC_X86)
+		CPU_Core_Dyn_X86_SetCacheSize(cache_size_mb);
 		CPU_Core_Dyn_X86_Cache_Init((core == "dynamic") || (core == "dynamic_nodhfpu"));
 #elif (C_DYNREC)
+		CPU_Core_Dynrec_SetCacheSize(cache_size_mb);
+		CPU_Core_Dynrec_SetPersistentCache(section->Get_bool("dynamic_core_cache"));
+		CPU_Core_Dynrec_SetTieringThreshold(check_cast<uint8_t>(
+		        section->Get_int("dynamic_core_threshold")));
 		CPU_Core_Dynrec_Cache_Init( core == "dynamic" );
 #endif
 
@@ -2492,6 +2685,37 @@ public:
 
 static CPU * test;
 
+// Saved between two ticks, when none of the cores is running
+static void save_cpu_state(SaveStateWriter& writer)
+{
+	writer.Write(cpu_regs);
+	writer.Write(Segs);
+	writer.Write(cpu);
+	writer.Write(lflags);
+	writer.Write(cpudecoder);
+	writer.Write(CPU_Cycles);
+	writer.Write(CPU_CycleLeft);
+	writer.Write(CPU_IODelayRemoved);
+}
+
+static void load_cpu_state(SaveStateReader& reader)
+{
+	// The translated code is of the guest's memory from before
+#if (C_DYNAMIC_X86)
+	CPU_Core_Dyn_X86_Cache_Reset();
+#elif (C_DYNREC)
+	CPU_Core_Dynrec_Cache_Reset();
+#endif
+	reader.Read(cpu_regs);
+	reader.Read(Segs);
+	reader.Read(cpu);
+	reader.Read(lflags);
+	reader.Read(cpudecoder);
+	reader.Read(CPU_Cycles);
+	reader.Read(CPU_CycleLeft);
+	reader.Read(CPU_IODelayRemoved);
+}
+
 void CPU_ShutDown([[maybe_unused]] Section* sec) {
 #if (C_DYNAMIC_X86)
 	CPU_Core_Dyn_X86_Cache_Close();
@@ -2506,6 +2730,7 @@ void CPU_Init(Section* sec)
 	assert(sec);
 
 	test = new (std::nothrow) CPU(sec);
+	SAVESTATE_AddComponent("CPU", save_cpu_state, load_cpu_state);
 
 	constexpr auto changeable_at_runtime = true;
 	sec->AddDestroyFunction(&CPU_ShutDown, changeable_at_runtime);
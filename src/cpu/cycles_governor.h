@@ -0,0 +1,136 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_CYCLES_GOVERNOR_H
+#define DOSBOX_CYCLES_GOVERNOR_H
+
+/*
+	PID-style governor for the auto cycles mode.
+
+	The host time needed to emulate one millisecond is roughly
+	proportional to the cycles, so the controller works on the log of
+	the ratio between the load we aim for and the measured one. It's
+	written in velocity form: the integral term moves the cycles
+	towards the target, the proportional term reacts to changes of the
+	error and the derivative term damps them. There's no integrator
+	state to wind up when the cycles run into their limits.
+
+	The load we aim for leaves the configured headroom free, minus the
+	host time spent presenting frames and an extra margin when the
+	audio buffer ran low or underran since the last update.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+class CyclesGovernor {
+public:
+	// Measurements taken over one update period
+	struct Sample {
+		// Host time spent emulating and rendering or presenting frames,
+		// per millisecond of emulated time
+		double emulation_load = 0.0;
+		double present_load   = 0.0;
+
+		// Share of the cycles that were skipped by the IO delay code
+		double io_delay_removed = 0.0;
+
+		// Lowest audio buffer fill level seen by the audio device,
+		// 1.0 being the configured prebuffer
+		double audio_min_fill = 1.0;
+		int audio_underruns   = 0;
+	};
+
+	void SetHeadroom(const int percent)
+	{
+		headroom = std::clamp(percent, 0, 90) / 100.0;
+	}
+
+	void Reset()
+	{
+		prev_error  = 0.0;
+		prev_error2 = 0.0;
+	}
+
+	// Returns the new cycles, within the given limits
+	int32_t Update(const int32_t cycles, const int usage_percent,
+	               const Sample& sample, const int32_t min_cycles,
+	               const int32_t max_cycles)
+	{
+		// Cycles skipped by the IO delay code didn't cost any host
+		// time, account for them as if they had run
+		const auto ran = std::max(1.0 - sample.io_delay_removed, 0.1);
+		const auto measured = std::max(sample.emulation_load / ran, 0.001);
+
+		// Emulating took 10 times longer than real time; most likely a
+		// stall of the host rather than the cycles being off
+		if (measured > 10.0) {
+			return cycles;
+		}
+
+		const auto audio_deficit = std::clamp(1.0 - sample.audio_min_fill,
+		                                      0.0,
+		                                      1.0);
+		const auto audio_margin = AudioFillWeight * audio_deficit +
+		                          (sample.audio_underruns ? UnderrunMargin : 0.0);
+
+		const auto target = std::max(usage_percent / 100.0 * (1.0 - headroom) -
+		                                     sample.present_load - audio_margin,
+		                             MinTargetLoad);
+
+		auto error = std::clamp(std::log(target / measured), -MaxError, MaxError);
+		if (std::fabs(error) < Deadband) {
+			error = 0.0;
+		}
+
+		const auto step = Ki * error + Kp * (error - prev_error) +
+		                  Kd * (error - 2 * prev_error + prev_error2);
+		prev_error2 = prev_error;
+		prev_error  = error;
+
+		const auto scale = std::exp(std::clamp(step, MinStep, MaxStep));
+		const auto new_cycles = std::llround(cycles * scale);
+		return static_cast<int32_t>(
+		        std::clamp<long long>(new_cycles, min_cycles, max_cycles));
+	}
+
+private:
+	static constexpr double Ki = 0.5;
+	static constexpr double Kp = 0.25;
+	static constexpr double Kd = 0.05;
+
+	static constexpr double MaxError = 1.5;
+	static constexpr double Deadband = 0.02;
+
+	// At most halve or double the cycles per update
+	static constexpr double MinStep = -0.693;
+	static constexpr double MaxStep = 0.693;
+
+	static constexpr double MinTargetLoad   = 0.05;
+	static constexpr double AudioFillWeight = 0.2;
+	static constexpr double UnderrunMargin  = 0.1;
+
+	double headroom    = 0.1;
+	double prev_error  = 0.0;
+	double prev_error2 = 0.0;
+};
+
+#endif
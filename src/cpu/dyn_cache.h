@@ -21,9 +21,12 @@
 
 #include <cassert>
 #include <cerrno>
+#include <cstddef>
+#include <memory>
 #include <new>
 #include <type_traits>
 
+#include "host_memory.h"
 #include "mem_unaligned.h"
 #include "paging.h"
 #include "types.h"
@@ -32,6 +35,15 @@
 #include <sys/mman.h>
 #endif
 
+// The x86, x86-64 and ARMv8 code generators write to the cache only through
+// the cache_add*() helpers, so they can generate into a second, writable
+// view of the cache memory
+#if defined(HAVE_MEMFD_CREATE) && defined(C_PER_PAGE_W_OR_X) && \
+        (defined(__x86_64__) || defined(__i386__) || defined(__aarch64__))
+#define DYN_CACHE_DUAL_MAPPING
+#include <unistd.h>
+#endif
+
 #if defined(HAVE_PTHREAD_WRITE_PROTECT_NP)
 #include <pthread.h>
 #endif
@@ -47,6 +59,10 @@
 
 class CodePageHandler;
 
+// number of links per cache block: the two paths of the final (conditional)
+// jump, plus the side exit of an extended block (dynrec only)
+constexpr int CacheBlockLinks = 3;
+
 // basic cache block representation
 class CacheBlock {
 public:
@@ -62,7 +78,8 @@ public:
 	void Clear();
 
 	// link this cache block to another block, index specifies the code
-	// path (always zero for unconditional links, 0/1 for conditional ones
+	// path (always zero for unconditional links, 0/1 for conditional ones,
+	// 2 for the side exit)
 	void LinkTo(Bitu index, CacheBlock *toblock)
 	{
 		assert(toblock);
@@ -113,7 +130,7 @@ public:
 		CacheBlock* next = {};
 		CacheBlock* from = {}; // the from-block can transfer control
 		                       // to this block
-	} link[2] = {};                // maximum two links (conditional jumps)
+	} link[CacheBlockLinks] = {}; // conditional jumps and side exit
 
 	CacheBlock* crossblock = {};
 };
@@ -151,8 +168,36 @@ static uint8_t* cache_code_start_ptr   = {};
 static uint8_t* cache_code             = {};
 static uint8_t* cache_code_link_blocks = {};
 
-static std::vector<CacheBlock> cache_blocks(CACHE_BLOCKS);
-static CacheBlock link_blocks[2] = {}; // default linking (specially marked)
+// When the cache is mapped twice, code is generated through a writable view
+// of the same memory that sits at this offset from the executable one, so
+// no page permissions have to be flipped around block writes
+static bool cache_dual_mapped    = false;
+static ptrdiff_t cache_rw_offset  = 0;
+
+// size of the code cache and number of cache blocks, CACHE_TOTAL and
+// CACHE_BLOCKS are the defaults, cache_set_size() can change them before
+// the cache gets initialized
+static size_t cache_total      = CACHE_TOTAL;
+static size_t cache_num_blocks = CACHE_BLOCKS;
+
+// runtime statistics, these are cheap enough to always be counted
+static struct {
+	uint64_t blocks_translated  = 0;
+	uint64_t opcodes_translated = 0;
+	uint64_t bytes_generated    = 0;
+	uint64_t cache_wraps        = 0; // restarts at the start of the cache
+	uint64_t smc_invalidations  = 0; // blocks cleared by code modification
+	uint64_t link_hits          = 0; // links resolved to a translated block
+	uint64_t link_misses        = 0; // links that needed a translation
+	uint64_t flags_eliminated   = 0; // flag computations found to be dead
+} cache_stats = {};
+
+// The cache blocks are allocated in chunks as translations need them, up
+// to cache_num_blocks in total, as most programs only ever use a fraction
+constexpr size_t CacheBlocksPerChunk = 4096;
+static std::vector<std::unique_ptr<CacheBlock[]>> cache_block_chunks = {};
+static size_t cache_num_allocated_blocks = 0;
+static CacheBlock link_blocks[CacheBlockLinks] = {}; // default linking (specially marked)
 
 // the CodePageHandler class provides access to the contained
 // cache blocks and intercepts writes to the code for special treatment
@@ -181,6 +226,7 @@ public:
 		// code present)
 		memset(&hash_map,0,sizeof(hash_map));
 		memset(&write_map,0,sizeof(write_map));
+		smc_invalidations = 0;
 		if (invalidation_map) {
 			delete [] invalidation_map;
 			invalidation_map = nullptr;
@@ -212,6 +258,8 @@ public:
 				// test if this block is in the range
 				if (start<=block->page.end && end>=block->page.start) {
 					if (ip_point<=block->page.end && ip_point>=block->page.start) is_current_block=true;
+					++cache_stats.smc_invalidations;
+					++smc_invalidations;
 					block->Clear(); // clear the block,
 					                // decrements the
 					                // write_map accordingly
@@ -530,6 +578,23 @@ public:
 		return nullptr; // none found
 	}
 
+	// call the given function for every block that starts in this page
+	template <typename Func>
+	void ForEachCacheBlock(Func&& func) const
+	{
+		for (Bitu index = 1; index <= DYN_PAGE_HASH; ++index) {
+			for (auto block = hash_map[index]; block;
+			     block = block->hash.next) {
+				func(*block);
+			}
+		}
+	}
+
+	Bitu GetPhysPage() const
+	{
+		return phys_page;
+	}
+
 	HostPt GetHostReadPt(Bitu phys_page) override
 	{
 		hostmem = old_pagehandler->GetHostReadPt(phys_page);
@@ -547,6 +612,10 @@ public:
 	uint8_t write_map[4096] = {};
 	uint8_t *invalidation_map = nullptr;
 
+	// blocks of this page cleared by code modification, the core decays
+	// this to tell pages that keep rewriting their code
+	uint32_t smc_invalidations = 0;
+
 	CodePageHandler *prev = nullptr;
 	CodePageHandler *next = nullptr;
 
@@ -570,12 +639,39 @@ static inline void cache_add_unused_block(CacheBlock *block)
 	cache.block.free = block;
 }
 
+// Adds a chunk of blocks to the freelist, returns false once all blocks
+// have been allocated
+static bool cache_allocate_block_chunk()
+{
+	const auto num_blocks = std::min(CacheBlocksPerChunk,
+	                                 cache_num_blocks - cache_num_allocated_blocks);
+	if (num_blocks == 0) {
+		return false;
+	}
+	auto chunk = std::make_unique<CacheBlock[]>(num_blocks);
+	for (size_t i = 0; i < num_blocks; i++) {
+		for (auto& link : chunk[i].link) {
+			link.to = (CacheBlock *)1;
+		}
+		chunk[i].cache.next = (i + 1 < num_blocks) ? &chunk[i + 1]
+		                                           : cache.block.free;
+	}
+	cache.block.free = &chunk[0];
+	cache_block_chunks.emplace_back(std::move(chunk));
+
+	cache_num_allocated_blocks += num_blocks;
+	HOSTMEM_AddUsage("Dynamic core blocks",
+	                 static_cast<ptrdiff_t>(num_blocks * sizeof(CacheBlock)));
+	return true;
+}
+
 static CacheBlock *cache_getblock()
 {
 	// get a free cache block and advance the free pointer
-	CacheBlock *ret = cache.block.free;
-	if (!ret)
+	if (!cache.block.free && !cache_allocate_block_chunk()) {
 		E_Exit("Ran out of CacheBlocks");
+	}
+	CacheBlock *ret = cache.block.free;
 	cache.block.free=ret->cache.next;
 	ret->cache.next=nullptr;
 	return ret;
@@ -662,7 +758,7 @@ void CacheBlock::Clear()
 {
 	Bitu ind;
 	// check if this is not a cross page block
-	if (hash.index) for (ind=0;ind<2;ind++) {
+	if (hash.index) for (ind=0;ind<CacheBlockLinks;ind++) {
 		CacheBlock * fromlink=link[ind].from;
 		link[ind].from=nullptr;
 		while (fromlink) {
@@ -737,12 +833,11 @@ static void cache_closeblock()
 {
 	CacheBlock *block = cache.block.active;
 	// links point to the default linking code
-	block->link[0].to=&link_blocks[0];
-	block->link[1].to=&link_blocks[1];
-	block->link[0].from=nullptr;
-	block->link[1].from=nullptr;
-	block->link[0].next=nullptr;
-	block->link[1].next=nullptr;
+	for (int i = 0; i < CacheBlockLinks; ++i) {
+		block->link[i].to   = &link_blocks[i];
+		block->link[i].from = nullptr;
+		block->link[i].next = nullptr;
+	}
 	// close the block with correct alignment
 	Bitu written = (Bitu)(cache.pos - block->cache.start);
 	if (written>block->cache.size) {
@@ -773,12 +868,13 @@ static void cache_closeblock()
 #if (C_DYNAMIC_X86)
 	const bool cache_is_full = !block->cache.next;
 #elif (C_DYNREC)
-	const uint8_t *limit = (cache_code_start_ptr + CACHE_TOTAL - CACHE_MAXSIZE);
+	const uint8_t *limit = (cache_code_start_ptr + cache_total - CACHE_MAXSIZE);
 	const bool cache_is_full = (!block->cache.next ||
 	                            (block->cache.next->cache.start > limit));
 #endif
 	if (cache_is_full) {
 		// LOG_DEBUG("Cache full; restarting");
+		++cache_stats.cache_wraps;
 		cache.block.active=cache.block.first;
 	} else {
 		cache.block.active=block->cache.next;
@@ -799,7 +895,7 @@ static void cache_closeblock()
 
 static inline void cache_addb(uint8_t val, const uint8_t *pos)
 {
-	*const_cast<uint8_t *>(pos) = val;
+	*const_cast<uint8_t *>(pos + cache_rw_offset) = val;
 }
 
 static inline void cache_addb(uint8_t val)
@@ -812,7 +908,7 @@ static inline void cache_addb(uint8_t val)
 
 static inline void cache_addw(uint16_t val, const uint8_t *pos)
 {
-	write_unaligned_uint16(const_cast<uint8_t *>(pos), val);
+	write_unaligned_uint16(const_cast<uint8_t *>(pos + cache_rw_offset), val);
 }
 
 static inline void cache_addw(uint16_t val)
@@ -825,7 +921,7 @@ static inline void cache_addw(uint16_t val)
 
 static inline void cache_addd(uint32_t val, const uint8_t *pos)
 {
-	write_unaligned_uint32(const_cast<uint8_t *>(pos), val);
+	write_unaligned_uint32(const_cast<uint8_t *>(pos + cache_rw_offset), val);
 }
 
 static inline void cache_addd(uint32_t val)
@@ -838,7 +934,7 @@ static inline void cache_addd(uint32_t val)
 
 static inline void cache_addq(uint64_t val, const uint8_t *pos)
 {
-	write_unaligned_uint64(const_cast<uint8_t *>(pos), val);
+	write_unaligned_uint64(const_cast<uint8_t *>(pos + cache_rw_offset), val);
 }
 
 static inline void cache_addq(uint64_t val)
@@ -857,7 +953,10 @@ static void cache_block_before_close();
 static void cache_block_closing(const uint8_t *block_start, Bitu block_size);
 #endif
 
-static constexpr size_t cache_code_size = CACHE_TOTAL + CACHE_MAXSIZE + host_pagesize - 1 + host_pagesize;
+static size_t cache_code_size()
+{
+	return cache_total + CACHE_MAXSIZE + host_pagesize - 1 + host_pagesize;
+}
 constexpr bool is_64bit_platform = sizeof(void *) == 8;
 
 static inline void dyn_mem_adjust(void *&ptr, size_t &size)
@@ -923,6 +1022,8 @@ static inline void dyn_mem_set_access([[maybe_unused]] void *ptr,
 static inline void dyn_mem_execute(void *ptr, size_t size)
 {
 #if defined(C_PER_PAGE_W_OR_X)
+	if (cache_dual_mapped)
+		return; // the executable view is never writable
 	dyn_mem_set_access(ptr, size, true);
 #else
 	// Skip per-page execute-flagging
@@ -932,6 +1033,8 @@ static inline void dyn_mem_execute(void *ptr, size_t size)
 static inline void dyn_mem_write(void *ptr, size_t size)
 {
 #if defined(C_PER_PAGE_W_OR_X)
+	if (cache_dual_mapped)
+		return; // writes go through the writable view
 	dyn_mem_set_access(ptr, size, false);
 #else
 	// Skip per-page write-flagging
@@ -965,8 +1068,60 @@ static inline void dyn_cache_invalidate([[maybe_unused]] void *ptr,
 #endif
 }
 
+// Maps an anonymous shared memory object twice: read+execute for running the
+// code and read+write for generating it. Returns the executable view, or
+// nullptr if the host doesn't allow it, in which case the caller falls back
+// to flipping page permissions.
+static uint8_t* cache_map_dual([[maybe_unused]] const size_t size)
+{
+#if defined(DYN_CACHE_DUAL_MAPPING)
+	const int fd = memfd_create("dosbox-dyncache", MFD_CLOEXEC);
+	if (fd < 0) {
+		return nullptr;
+	}
+	if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+		close(fd);
+		return nullptr;
+	}
+	void* rx = mmap(nullptr, size, PROT_READ | PROT_EXEC, MAP_SHARED, fd, 0);
+	void* rw = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd); // the mappings keep the memory alive
+
+	if (rx == MAP_FAILED || rw == MAP_FAILED) {
+		if (rx != MAP_FAILED) {
+			munmap(rx, size);
+		}
+		if (rw != MAP_FAILED) {
+			munmap(rw, size);
+		}
+		return nullptr;
+	}
+
+	cache_dual_mapped = true;
+	cache_rw_offset   = static_cast<uint8_t*>(rw) - static_cast<uint8_t*>(rx);
+	LOG_MSG("DYNCACHE: Using dual-mapped code cache");
+	return static_cast<uint8_t*>(rx);
+#else
+	return nullptr;
+#endif
+}
+
 static bool cache_initialized = false;
 
+// Set the size of the code cache in MiB, the number of cache blocks scales
+// along. Only has an effect before the cache is allocated.
+static void cache_set_size(const size_t size_mb)
+{
+	if (cache_code_start_ptr) {
+		return;
+	}
+	constexpr size_t bytes_per_mb = 1024 * 1024;
+	constexpr size_t default_mb   = CACHE_TOTAL / bytes_per_mb;
+
+	cache_total      = size_mb * bytes_per_mb;
+	cache_num_blocks = (CACHE_BLOCKS / default_mb) * size_mb;
+}
+
 static void cache_init(bool enable) {
 	if (enable) {
 		// see if cache is already initialized
@@ -974,40 +1129,36 @@ static void cache_init(bool enable) {
 			return;
 		}
 		cache_initialized = true;
-		cache.block.free = &cache_blocks[0];
-		// initialize the cache blocks
-		for (int i=0;i<CACHE_BLOCKS-1;i++) {
-			cache_blocks[i].link[0].to = (CacheBlock *)1;
-			cache_blocks[i].link[1].to = (CacheBlock *)1;
-			cache_blocks[i].cache.next = &cache_blocks[i + 1];
-		}
 		if (cache_code_start_ptr == nullptr) {
 			// allocate the code cache memory
 #if defined (WIN32)
 			LPVOID lp_vmem = nullptr;
 			if (CPU_UseRwxMemProtect) {
-				lp_vmem = VirtualAlloc(nullptr, cache_code_size,
+				lp_vmem = VirtualAlloc(nullptr, cache_code_size(),
 				                       MEM_COMMIT,
 				                       PAGE_EXECUTE_READWRITE); // all operations allowed
 			} else {
-				lp_vmem = VirtualAlloc(nullptr, cache_code_size,
+				lp_vmem = VirtualAlloc(nullptr, cache_code_size(),
 				                       MEM_COMMIT | MEM_RESERVE,
 				                       PAGE_READWRITE); // needs on-going management
 			}
 			assert(lp_vmem);
 			cache_code_start_ptr = static_cast<uint8_t *>(lp_vmem);
 #elif defined(HAVE_MMAP)
-			int map_flags = MAP_PRIVATE | MAP_ANON;
-			int prot_flags = PROT_READ | PROT_WRITE | PROT_EXEC;
+			cache_code_start_ptr = cache_map_dual(cache_code_size());
+			if (!cache_code_start_ptr) {
+				int map_flags = MAP_PRIVATE | MAP_ANON;
+				int prot_flags = PROT_READ | PROT_WRITE | PROT_EXEC;
 #if defined(HAVE_MAP_JIT)
-			map_flags |= MAP_JIT;
+				map_flags |= MAP_JIT;
 #endif
-			cache_code_start_ptr=static_cast<uint8_t *>(mmap(nullptr, cache_code_size, prot_flags, map_flags, -1, 0));
-			if (cache_code_start_ptr == MAP_FAILED) {
-				E_Exit("DYNCACHE: Failed memory-mapping cache memory because: %s", strerror(errno));
+				cache_code_start_ptr=static_cast<uint8_t *>(mmap(nullptr, cache_code_size(), prot_flags, map_flags, -1, 0));
+				if (cache_code_start_ptr == MAP_FAILED) {
+					E_Exit("DYNCACHE: Failed memory-mapping cache memory because: %s", strerror(errno));
+				}
 			}
 #else
-			cache_code_start_ptr=static_cast<uint8_t *>(malloc(cache_code_size));
+			cache_code_start_ptr=static_cast<uint8_t *>(malloc(cache_code_size()));
 			if (!cache_code_start_ptr) {
 				E_Exit("DYNCACHE: Failed allocating cache memory because: %s", strerror(errno));
 			}
@@ -1019,11 +1170,12 @@ static void cache_init(bool enable) {
 
 			cache_code_link_blocks=cache_code;
 			cache_code=cache_code+host_pagesize;
+			HOSTMEM_SetUsage("Dynamic core code cache", cache_code_size());
 			CacheBlock *block = cache_getblock();
 			cache.block.first=block;
 			cache.block.active=block;
 			block->cache.start=&cache_code[0];
-			block->cache.size=CACHE_TOTAL;
+			block->cache.size=cache_total;
 			block->cache.next = nullptr; // last block in the list
 		}
 
@@ -1039,7 +1191,12 @@ static void cache_init(bool enable) {
 			link_blocks[block_num].cache.start = cache.pos;
 			// link code that returns with a special return code
 			// must be less than 32 bytes
-			dyn_return(block_num == 0 ? BR_Link1 : BR_Link2, false);
+			constexpr BlockReturn link_returns[] = {BR_Link1, BR_Link2,
+#if C_DYNREC
+			                                        BR_Link3
+#endif
+			};
+			dyn_return(link_returns[block_num], false);
 #if C_DYNREC
 			cache_block_before_close();
 			cache_block_closing(link_blocks[block_num].cache.start,
@@ -1056,12 +1213,13 @@ static void cache_init(bool enable) {
 		cache.pos = &cache_code_link_blocks[0];
 		using generate_run_code_f = decltype(&generate_run_code);
 		core_dynrec.runcode = (generate_run_code_f)cache.pos;
-		dyn_run_code(); // writes up to host_pagesize - 64 bytes
+		dyn_run_code(); // writes up to host_pagesize - 96 bytes
 
 		cache_block_before_close();
 		cache_block_closing(cache_code_link_blocks,
 		                    cache.pos - cache_code_link_blocks);
 
+		close_link_block_num_at_code_pos(2, host_pagesize - 96);
 		close_link_block_num_at_code_pos(0, host_pagesize - 64);
 		close_link_block_num_at_code_pos(1, host_pagesize - 32);
 #endif
@@ -1084,6 +1242,15 @@ static void cache_init(bool enable) {
 	}
 }
 
+// Drops all translated code, for when the guest's memory was replaced
+// without passing the code pages' write handlers
+static void cache_release_all()
+{
+	while (cache.used_pages) {
+		cache.used_pages->ClearRelease();
+	}
+}
+
 static void cache_close(void) {
 /*	for (;;) {
 		if (cache.used_pages) {
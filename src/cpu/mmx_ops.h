@@ -0,0 +1,145 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_MMX_OPS_H
+#define DOSBOX_MMX_OPS_H
+
+// Packed MMX operations on the MMX_reg union, shared by the CPU cores.
+// Each one is a single SIMDe intrinsic, which compiles to one SSE2 or
+// MMX instruction on x86 hosts and to NEON on ARM hosts.
+
+// simde needs std::isnan
+#include <cmath>
+#include <cstdint>
+
+#include "mmx.h"
+
+#include "simde/x86/mmx.h"
+
+namespace mmx {
+
+inline simde__m64 to_simde(const MMX_reg reg)
+{
+	return simde_m_from_int64(static_cast<int64_t>(reg.q));
+}
+
+inline MMX_reg from_simde(const simde__m64 val)
+{
+	MMX_reg reg = {};
+	reg.q       = static_cast<uint64_t>(simde_m_to_int64(val));
+	return reg;
+}
+
+// dest = dest <op> src
+#define MMX_OP(name) \
+	inline MMX_reg name(const MMX_reg dest, const MMX_reg src) \
+	{ \
+		return from_simde(simde_m_##name(to_simde(dest), to_simde(src))); \
+	}
+
+MMX_OP(paddb)
+MMX_OP(paddw)
+MMX_OP(paddd)
+MMX_OP(paddsb)
+MMX_OP(paddsw)
+MMX_OP(paddusb)
+MMX_OP(paddusw)
+MMX_OP(psubb)
+MMX_OP(psubw)
+MMX_OP(psubd)
+MMX_OP(psubsb)
+MMX_OP(psubsw)
+MMX_OP(psubusb)
+MMX_OP(psubusw)
+
+MMX_OP(pmulhw)
+MMX_OP(pmullw)
+MMX_OP(pmaddwd)
+
+MMX_OP(pcmpeqb)
+MMX_OP(pcmpeqw)
+MMX_OP(pcmpeqd)
+MMX_OP(pcmpgtb)
+MMX_OP(pcmpgtw)
+MMX_OP(pcmpgtd)
+
+MMX_OP(packsswb)
+MMX_OP(packssdw)
+MMX_OP(packuswb)
+MMX_OP(punpckhbw)
+MMX_OP(punpckhwd)
+MMX_OP(punpckhdq)
+MMX_OP(punpcklbw)
+MMX_OP(punpcklwd)
+MMX_OP(punpckldq)
+
+MMX_OP(pand)
+MMX_OP(pandn)
+MMX_OP(por)
+MMX_OP(pxor)
+
+// SIMDe leaves shifts by counts past the lane width up to the host
+// (NEON even shifts the other way for some), but MMX zero-fills the
+// lanes for logical shifts and sign-fills them for arithmetic ones
+inline uint8_t shift_count(const MMX_reg src)
+{
+	return src.q > UINT8_MAX ? UINT8_MAX : static_cast<uint8_t>(src.q);
+}
+
+#define MMX_SHIFT_LOGICAL(name, lane_bits) \
+	inline MMX_reg name##i(const MMX_reg dest, const uint8_t count) \
+	{ \
+		if (count >= lane_bits) { \
+			return {}; \
+		} \
+		return from_simde(simde_m_##name##i(to_simde(dest), count)); \
+	} \
+	inline MMX_reg name(const MMX_reg dest, const MMX_reg src) \
+	{ \
+		return name##i(dest, shift_count(src)); \
+	}
+
+#define MMX_SHIFT_ARITHMETIC(name, lane_bits) \
+	inline MMX_reg name##i(const MMX_reg dest, const uint8_t count) \
+	{ \
+		const auto clamped = count < lane_bits ? count : lane_bits - 1; \
+		return from_simde(simde_m_##name##i(to_simde(dest), clamped)); \
+	} \
+	inline MMX_reg name(const MMX_reg dest, const MMX_reg src) \
+	{ \
+		return name##i(dest, shift_count(src)); \
+	}
+
+MMX_SHIFT_LOGICAL(psllw, 16)
+MMX_SHIFT_LOGICAL(pslld, 32)
+MMX_SHIFT_LOGICAL(psllq, 64)
+MMX_SHIFT_LOGICAL(psrlw, 16)
+MMX_SHIFT_LOGICAL(psrld, 32)
+MMX_SHIFT_LOGICAL(psrlq, 64)
+MMX_SHIFT_ARITHMETIC(psraw, 16)
+MMX_SHIFT_ARITHMETIC(psrad, 32)
+
+#undef MMX_OP
+#undef MMX_SHIFT_LOGICAL
+#undef MMX_SHIFT_ARITHMETIC
+
+} // namespace mmx
+
+#endif
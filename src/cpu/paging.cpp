@@ -19,17 +19,23 @@
 
 #include "paging.h"
 
+#include <array>
 #include <cassert>
+#include <cinttypes>
 #include <cstdlib>
 #include <cstring>
 #include <memory>
+#include <vector>
 
 #include "mem.h"
 #include "regs.h"
 #include "lazyflags.h"
 #include "cpu.h"
 #include "debug.h"
+#include "event_counters.h"
+#include "savestate.h"
 #include "setup.h"
+#include "timer.h"
 
 #define LINK_TOTAL		(64*1024)
 
@@ -88,6 +94,12 @@ void PageHandler::writeq(PhysPt addr, uint64_t val) {
     }
 }
 
+bool PageHandler::write_block(PhysPt /*addr*/, const uint8_t* /*data*/,
+                              Bitu /*num_bytes*/, Bitu /*num_writes*/)
+{
+	return false;
+}
+
 HostPt PageHandler::GetHostReadPt(Bitu /*phys_page*/) {
 	return nullptr;
 }
@@ -195,6 +207,93 @@ void PAGING_PageFault(PhysPt lin_addr,uint32_t page_addr,uint32_t faultcode) {
 //	LOG_MSG("SS:%04x SP:%08X",SegValue(ss),reg_esp);
 }
 
+static struct {
+	uint64_t refills        = 0;
+	uint64_t dir_switches   = 0;
+	uint64_t links_restored = 0;
+	int64_t since_ms        = 0;
+} tlb_stats = {};
+
+static EventCounter tlb_refills("TLB refills");
+
+// 4 MB Pages
+// ~~~~~~~~~~
+// With CR4.PSE set, a page directory entry with its page size bit set maps a
+// 4 MB page directly, without a page table. Its entry then also holds the
+// accessed and dirty bits. The walkers below describe such a page with a
+// page entry synthesised from the directory entry, so the privilege checks
+// are the same for both page sizes.
+
+static inline bool is_large_page(const X86PageEntry& table)
+{
+	// The page size bit is in the position of the PAT bit of page entries
+	return (cpu.cr4 & CR4_PAGESIZEEXTENSIONS) && table.pat;
+}
+
+static inline PhysPt table_entry_addr(const uint32_t lin_page)
+{
+	return (paging.base.page << 12) + (lin_page >> 10) * 4;
+}
+
+// The address of the entry mapping the page; for 4 MB pages that's the
+// directory entry
+static inline PhysPt page_entry_addr(const X86PageEntry& table,
+                                     const uint32_t lin_page)
+{
+	return is_large_page(table) ? table_entry_addr(lin_page)
+	                            : (table.base << 12) + (lin_page & 0x3ff) * 4;
+}
+
+static inline X86PageEntry large_page_entry(const X86PageEntry& table,
+                                            const uint32_t lin_page)
+{
+	auto entry = table;
+	entry.base = (table.base & ~0x3ffu) | (lin_page & 0x3ff);
+	entry.pat  = 0;
+	return entry;
+}
+
+// Writes back the accessed and dirty bits of the page entry
+static inline void write_page_entry(const X86PageEntry& table,
+                                    const X86PageEntry& entry,
+                                    const uint32_t lin_page)
+{
+	if (is_large_page(table)) {
+		auto dir_entry = table;
+		dir_entry.a    = entry.a;
+		dir_entry.d    = entry.d;
+		phys_writed(table_entry_addr(lin_page), dir_entry.get());
+	} else {
+		phys_writed(page_entry_addr(table, lin_page), entry.get());
+	}
+}
+
+static inline void write_table_entry(const X86PageEntry& table,
+                                     const uint32_t lin_page)
+{
+	phys_writed(table_entry_addr(lin_page), table.get());
+}
+
+// The pages around a fully linked one share its directory entry, and so
+// its privileges and dirty bit, so they're linked along with it instead of
+// each taking an init fault of its own
+constexpr uint32_t LargePageLinkAhead = 16;
+
+static void link_large_page_block(const X86PageEntry& table, const uint32_t lin_page)
+{
+	if (paging.links.used + LargePageLinkAhead >= PAGING_LINKS) {
+		return;
+	}
+	const auto first = lin_page & ~(LargePageLinkAhead - 1);
+	for (auto page = first; page < first + LargePageLinkAhead; ++page) {
+		const auto is_unlinked = get_tlb_readhandler(page << 12)->flags &
+		                         PFLAG_INIT;
+		if (page != lin_page && is_unlinked) {
+			PAGING_LinkPage(page, large_page_entry(table, page).base);
+		}
+	}
+}
+
 static inline void InitPageUpdateLink(uint32_t relink,PhysPt addr) {
 	if (relink==0) return;
 	if (paging.links.used) {
@@ -221,6 +320,10 @@ static inline void InitPageCheckPresence(PhysPt lin_addr,bool writing,X86PageEnt
 			E_Exit("Pagefault didn't correct table");
 		}
 	}
+	if (is_large_page(table)) {
+		entry = large_page_entry(table, lin_page);
+		return;
+	}
 	const auto entry_addr = (table.base << 12) + t_index * 4;
 	entry.set(phys_readd(entry_addr));
 	if (!entry.p) {
@@ -246,6 +349,10 @@ static inline bool InitPageCheckPresence_CheckOnly(PhysPt lin_addr,bool writing,
 		cpu.exception.error=(writing?0x02:0x00) | (((cpu.cpl&cpu.mpl)==0)?0x00:0x04);
 		return false;
 	}
+	if (is_large_page(table)) {
+		entry = large_page_entry(table, lin_page);
+		return true;
+	}
 	const auto entry_addr = (table.base << 12) + t_index * 4;
 	entry.set(phys_readd(entry_addr));
 	if (!entry.p) {
@@ -393,6 +500,8 @@ public:
 	}
 	uint32_t InitPage(uint32_t lin_addr, bool writing)
 	{
+		++tlb_stats.refills;
+		tlb_refills.Add();
 		const auto lin_page = lin_addr >> 12;
 		uint32_t phys_page;
 		if (paging.enabled) {
@@ -454,17 +563,14 @@ public:
 				 entry.wr,
 				 table.wr);
 				PAGING_PageFault(lin_addr,
-				                 (table.base << 12) +
-				                         (lin_page & 0x3ff) * 4,
+				                 page_entry_addr(table, lin_page),
 				                 0x05 | (writing ? 0x02 : 0x00));
 				priv_check = 0;
 			}
 
 			if (!table.a) {
 				table.a = 1; // set page table accessed
-				phys_writed((paging.base.page << 12) +
-				                    (lin_page >> 10) * 4,
-				            table.get());
+				write_table_entry(table, lin_page);
 			}
 			if (!entry.a || !entry.d) {
 				entry.a = 1; // set page accessed
@@ -475,9 +581,7 @@ public:
 					entry.d = 1; // mark page as dirty
 				}
 
-				phys_writed((table.base << 12) +
-				                    (lin_page & 0x3ff) * 4,
-				            entry.get());
+				write_page_entry(table, entry, lin_page);
 			}
 
 			phys_page = entry.base;
@@ -487,6 +591,9 @@ public:
 			if (priv_check==0) {
 				// if reading we could link the page as read-only to later cacth writes,
 				// will slow down pretty much but allows catching all dirty events
+				if (is_large_page(table)) {
+					link_large_page_block(table, lin_page);
+				}
 				PAGING_LinkPage(lin_page,phys_page);
 			} else {
 				if (priv_check==1) {
@@ -552,15 +659,11 @@ public:
 
 			if (!table.a) {
 				table.a = 1; // Set access
-				phys_writed((paging.base.page << 12) +
-				                    (lin_page >> 10) * 4,
-				            table.get());
+				write_table_entry(table, lin_page);
 			}
 			if (!entry.a) {
 				entry.a = 1; // Set access
-				phys_writed((table.base << 12) +
-				                    (lin_page & 0x3ff) * 4,
-				            entry.get());
+				write_page_entry(table, entry, lin_page);
 			}
 			phys_page = entry.base;
 			// maybe use read-only page here if possible
@@ -629,6 +732,8 @@ public:
 		return true;
 	}
 	void InitPage(uint32_t lin_addr, [[maybe_unused]] uint32_t val) {
+		++tlb_stats.refills;
+		tlb_refills.Add();
 		const auto lin_page=lin_addr >> 12;
 		uint32_t phys_page;
 		if (paging.enabled) {
@@ -645,22 +750,16 @@ public:
 			 table.us,
 			 entry.wr,
 			 table.wr);
-			PAGING_PageFault(lin_addr,
-			                 (table.base << 12) + (lin_page & 0x3ff) * 4,
-			                 0x07);
+			PAGING_PageFault(lin_addr, page_entry_addr(table, lin_page), 0x07);
 
 			if (!table.a) {
 				table.a = 1; // Set access
-				phys_writed((paging.base.page << 12) +
-				                    (lin_page >> 10) * 4,
-				            table.get());
+				write_table_entry(table, lin_page);
 			}
 			if ((!entry.a) || (!entry.d)) {
 				entry.a = 1; // Set access
 				entry.d = 1; // Set dirty
-				phys_writed((table.base << 12) +
-				                    (lin_page & 0x3ff) * 4,
-				            entry.get());
+				write_page_entry(table, entry, lin_page);
 			}
 			phys_page = entry.base;
 			PAGING_LinkPage(lin_page,phys_page);
@@ -712,15 +811,11 @@ public:
 
 			if (!table.a) {
 				table.a = 1; // Set access
-				phys_writed((paging.base.page << 12) +
-				                    (lin_page >> 10) * 4,
-				            table.get());
+				write_table_entry(table, lin_page);
 			}
 			if (!entry.a) {
 				entry.a = 1; // Set access
-				phys_writed((table.base << 12) +
-				                    (lin_page & 0x3ff) * 4,
-				            entry.get());
+				write_page_entry(table, entry, lin_page);
 			}
 			phys_page = entry.base;
 		} else {
@@ -742,6 +837,10 @@ bool PAGING_MakePhysPage(Bitu & page) {
 		if (!table.p) {
 			return false;
 		}
+		if (is_large_page(table)) {
+			page = large_page_entry(table, static_cast<uint32_t>(page)).base;
+			return true;
+		}
 		X86PageEntry entry;
 		entry.set(phys_readd((table.base << 12) + t_index * 4));
 		if (!entry.p) {
@@ -814,6 +913,14 @@ void PAGING_UnlinkPages(Bitu lin_page,Bitu pages) {
 void PAGING_MapPage(Bitu lin_page,Bitu phys_page) {
 	if (lin_page<LINK_START) {
 		paging.firstmb[lin_page]=phys_page;
+		// Without paging the first megabyte maps straight through, so
+		// link the page right away instead of taking the detour through
+		// the init handler on the next access
+		if (!paging.enabled) {
+			PAGING_LinkPage(static_cast<uint32_t>(lin_page),
+			                static_cast<uint32_t>(phys_page));
+			return;
+		}
 		paging.tlb.read[lin_page]=nullptr;
 		paging.tlb.write[lin_page]=nullptr;
 		paging.tlb.readhandler[lin_page]=&init_page_handler;
@@ -919,6 +1026,11 @@ void PAGING_UnlinkPages(Bitu lin_page,Bitu pages) {
 void PAGING_MapPage(Bitu lin_page,Bitu phys_page) {
 	if (lin_page<LINK_START) {
 		paging.firstmb[lin_page]=phys_page;
+		if (!paging.enabled) {
+			PAGING_LinkPage(static_cast<uint32_t>(lin_page),
+			                static_cast<uint32_t>(phys_page));
+			return;
+		}
 		paging.tlbh[lin_page].read=0;
 		paging.tlbh[lin_page].write=0;
 		paging.tlbh[lin_page].readhandler=&init_page_handler;
@@ -977,16 +1089,190 @@ void PAGING_LinkPage_ReadOnly(uint32_t lin_page, uint32_t phys_page)
 
 #endif
 
+// Tagged TLB
+// ~~~~~~~~~~
+// A CR3 load throws away all translations, so guests that keep switching
+// between a few address spaces (like the Windows 3.x/9x schedulers) rebuild
+// the same links through the InitPage handlers over and over. In tagged mode
+// the links of the most recently left page directories are put aside. When a
+// directory becomes current again, its links are restored for the pages whose
+// page directory and page table entries are still the same in guest memory,
+// so only the changed mappings are dropped.
+//
+// Only links that don't depend on the privilege level at the time they were
+// made are kept: read-only links (which re-check every write) and full links
+// of user-writable pages.
+
+constexpr size_t TaggedTlbDirs     = 8;
+constexpr size_t TaggedTlbMaxLinks = 2048;
+
+struct TaggedTlbLink {
+	uint32_t lin_page = 0;
+	uint32_t table    = 0;
+	uint32_t entry    = 0;
+	bool read_only    = false;
+};
+
+struct TaggedTlbDir {
+	uint32_t dir_page                = 0;
+	uint64_t last_used               = 0;
+	std::vector<TaggedTlbLink> links = {};
+};
+
+static struct {
+	bool enabled              = false;
+	uint64_t use_counter      = 0;
+	std::array<TaggedTlbDir, TaggedTlbDirs> dirs = {};
+} tagged_tlb = {};
+
+static void TaggedTlbReset()
+{
+	for (auto& dir : tagged_tlb.dirs) {
+		dir.last_used = 0;
+		dir.links.clear();
+	}
+}
+
+static bool TaggedTlbRead(const uint32_t dir_page, const uint32_t lin_page,
+                          X86PageEntry& table, X86PageEntry& entry)
+{
+	table.set(phys_readd((dir_page << 12) + (lin_page >> 10) * 4));
+	if (!table.p || !table.a) {
+		return false;
+	}
+	if (is_large_page(table)) {
+		entry = large_page_entry(table, lin_page);
+		return true;
+	}
+	entry.set(phys_readd((table.base << 12) + (lin_page & 0x3ff) * 4));
+	return entry.p && entry.a && entry.base < TLB_SIZE;
+}
+
+static void TaggedTlbSave(const uint32_t dir_page)
+{
+	// Reuse the slot of this directory, or else the least recently used one
+	auto slot = &tagged_tlb.dirs[0];
+	for (auto& dir : tagged_tlb.dirs) {
+		if (dir.last_used && dir.dir_page == dir_page) {
+			slot = &dir;
+			break;
+		}
+		if (dir.last_used < slot->last_used) {
+			slot = &dir;
+		}
+	}
+	slot->dir_page  = dir_page;
+	slot->last_used = ++tagged_tlb.use_counter;
+	slot->links.clear();
+
+	// The most recently made links are at the end of the list
+	const auto num_links = paging.links.used;
+	const auto first = num_links > TaggedTlbMaxLinks ? num_links - TaggedTlbMaxLinks
+	                                                 : 0;
+	for (auto i = first; i < num_links; ++i) {
+		const auto lin_page = paging.links.entries[i];
+		const auto lin_addr = lin_page << 12;
+		if (get_tlb_readhandler(lin_addr) == &init_page_handler) {
+			continue; // unlinked since
+		}
+		X86PageEntry table;
+		X86PageEntry entry;
+		if (!TaggedTlbRead(dir_page, lin_page, table, entry)) {
+			continue;
+		}
+		const auto read_only = get_tlb_writehandler(lin_addr) ==
+		                       &init_page_handler_userro;
+		const auto user_writable = table.us && entry.us && table.wr &&
+		                           entry.wr && entry.d;
+		if (read_only || user_writable) {
+			slot->links.push_back({lin_page, table.get(), entry.get(), read_only});
+		}
+	}
+}
+
+static void TaggedTlbRestore(const uint32_t dir_page)
+{
+	for (auto& dir : tagged_tlb.dirs) {
+		if (!dir.last_used || dir.dir_page != dir_page) {
+			continue;
+		}
+		for (const auto& link : dir.links) {
+			if (get_tlb_readhandler(link.lin_page << 12) != &init_page_handler) {
+				continue; // already restored
+			}
+			X86PageEntry table;
+			X86PageEntry entry;
+			if (!TaggedTlbRead(dir_page, link.lin_page, table, entry) ||
+			    table.get() != link.table || entry.get() != link.entry) {
+				continue;
+			}
+			if (link.read_only) {
+				PAGING_LinkPage_ReadOnly(link.lin_page, entry.base);
+			} else {
+				PAGING_LinkPage(link.lin_page, entry.base);
+			}
+			++tlb_stats.links_restored;
+		}
+		// the links are live again and get saved anew on the next switch
+		dir.last_used = 0;
+		dir.links.clear();
+		return;
+	}
+}
+
+void PAGING_FlushTLB()
+{
+	TaggedTlbReset();
+	PAGING_ClearTLB();
+}
+
+void PAGING_SetTaggedTLB(const bool enabled)
+{
+	tagged_tlb.enabled = enabled;
+	TaggedTlbReset();
+}
+
+void PAGING_LogStats()
+{
+	const auto now_ms     = GetTicks();
+	const auto elapsed_ms = std::max(now_ms - tlb_stats.since_ms,
+	                                 static_cast<int64_t>(1));
+	const auto per_second = [&](const uint64_t count) {
+		return static_cast<double>(count) * 1000.0 /
+		       static_cast<double>(elapsed_ms);
+	};
+
+	LOG_MSG("PAGING: %" PRIu64 " TLB refills in %.1f seconds (%.0f per second)",
+	        tlb_stats.refills,
+	        static_cast<double>(elapsed_ms) / 1000.0,
+	        per_second(tlb_stats.refills));
+	LOG_MSG("PAGING: %" PRIu64 " page directory switches (%.0f per second), %" PRIu64 " links restored by the tagged TLB%s",
+	        tlb_stats.dir_switches,
+	        per_second(tlb_stats.dir_switches),
+	        tlb_stats.links_restored,
+	        tagged_tlb.enabled ? "" : " (disabled)");
+
+	tlb_stats = {};
+	tlb_stats.since_ms = now_ms;
+}
 
 void PAGING_SetDirBase(Bitu cr3) {
 	assert(cr3 <= UINT32_MAX);
+	const auto old_dir_page = paging.base.page;
 	paging.cr3=static_cast<uint32_t>(cr3);
 	
 	paging.base.page=static_cast<uint32_t>(cr3 >> 12);
 	paging.base.addr=static_cast<PhysPt>(cr3 & ~4095);
 //	LOG(LOG_PAGING,LOG_NORMAL)("CR3:%X Base %X",cr3,paging.base.page);
 	if (paging.enabled) {
+		++tlb_stats.dir_switches;
+		if (tagged_tlb.enabled) {
+			TaggedTlbSave(old_dir_page);
+		}
 		PAGING_ClearTLB();
+		if (tagged_tlb.enabled) {
+			TaggedTlbRestore(paging.base.page);
+		}
 	}
 }
 
@@ -994,6 +1280,7 @@ void PAGING_Enable(bool enabled) {
 	/* If paging is disabled, we work from a default paging table */
 	if (paging.enabled==enabled) return;
 	paging.enabled=enabled;
+	TaggedTlbReset();
 	if (enabled) {
 		if (cpudecoder == CPU_Core_Simple_Run) {
 			// LOG_MSG("CPU core simple won't
@@ -1019,6 +1306,9 @@ public:
 		/* Setup default Page Directory, force it to update */
 		paging.enabled=false;
 		PAGING_InitTLB();
+		TaggedTlbReset();
+		tlb_stats          = {};
+		tlb_stats.since_ms = GetTicks();
 		for (auto i=0;i<LINK_START;i++) {
 			paging.firstmb[i]=i;
 		}
@@ -1028,7 +1318,29 @@ public:
 
 static std::unique_ptr<PAGING> paging_instance = nullptr;
 
+static void save_paging_state(SaveStateWriter& writer)
+{
+	writer.Write(paging.cr3);
+	writer.Write(paging.enabled);
+}
+
+// The page tables in guest memory changed, so nothing cached from them
+// can be kept
+static void load_paging_state(SaveStateReader& reader)
+{
+	uint32_t cr3 = 0;
+	bool enabled = false;
+	reader.Read(cr3);
+	reader.Read(enabled);
+
+	TaggedTlbReset();
+	paging.enabled = enabled;
+	PAGING_SetDirBase(cr3);
+	PAGING_ClearTLB();
+}
+
 void PAGING_Init(Section *sec)
 {
 	paging_instance = std::make_unique<PAGING>(sec);
+	SAVESTATE_AddComponent("Paging", save_paging_state, load_paging_state);
 }
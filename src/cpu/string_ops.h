@@ -20,6 +20,13 @@
 #ifndef DOSBOX_STRING_OPS_H
 #define DOSBOX_STRING_OPS_H
 
+#include <algorithm>
+#include <cstring>
+
+#include "inout.h"
+#include "mem.h"
+#include "paging.h"
+
 // string instructions
 enum STRING_OP {
 	R_OUTSB = 0,
@@ -45,4 +52,226 @@ enum STRING_OP {
 	R_CMPSD,
 };
 
+/*
+	Bulk paths for REP MOVS and REP STOS.
+
+	The cores normally do string instructions one element at a time through
+	the memory handlers. When a run of elements stays within a single page
+	that is plain host memory (the TLB has a direct pointer for it), the
+	whole run can be done with memcpy/memset on the host pointers instead.
+	Runs into pages without a direct pointer are handed to the page
+	handler's write_block in one go, which the planar VGA handlers
+	implement. Page crossings, MMIO, code pages watched by the dynamic
+	core and everything else keep using the regular per-element path.
+
+	The functions below return how many elements were done, which can be
+	zero; the caller then has to do at least one element the regular way
+	before trying again.
+*/
+
+// Number of elements of elem_size bytes that can be done in one run from
+// base+index on, without leaving the page or wrapping the offset at
+// index_mask (0xffff for 16-bit addressing)
+static inline Bitu string_max_run(const PhysPt base, const uint32_t index,
+                                  const uint32_t index_mask, const bool forward,
+                                  const Bitu elem_size)
+{
+	const auto page_offset = static_cast<Bitu>((base + index) & 0xfff);
+	if (page_offset + elem_size > 4096 || index > index_mask - (elem_size - 1)) {
+		return 0;
+	}
+	if (forward) {
+		const auto to_page_end = (4096 - page_offset) / elem_size;
+		const auto to_wrap = (static_cast<uint64_t>(index_mask) - index + 1) /
+		                     elem_size;
+		return static_cast<Bitu>(std::min<uint64_t>(to_page_end, to_wrap));
+	}
+	return std::min<Bitu>(page_offset, index) / elem_size + 1;
+}
+
+// Moves an index on by num elements of add_index bytes each
+static inline uint32_t string_advance(const uint32_t index, const Bitu num,
+                                      const int32_t add_index,
+                                      const uint32_t index_mask)
+{
+	return static_cast<uint32_t>(index + num * static_cast<Bitu>(add_index)) &
+	       index_mask;
+}
+
+// Lowest linear address touched by a run of num elements
+static inline PhysPt string_run_start(const PhysPt address, const Bitu num,
+                                      const Bitu elem_size, const bool forward)
+{
+	return forward ? address
+	               : static_cast<PhysPt>(address - (num - 1) * elem_size);
+}
+
+template <typename T>
+static inline Bitu string_bulk_movs([[maybe_unused]] const PhysPt si_base,
+                                    [[maybe_unused]] const uint32_t si_index,
+                                    [[maybe_unused]] const PhysPt di_base,
+                                    [[maybe_unused]] const uint32_t di_index,
+                                    [[maybe_unused]] const uint32_t index_mask,
+                                    [[maybe_unused]] const bool forward,
+                                    [[maybe_unused]] const Bitu count)
+{
+#if C_DEBUG && C_HEAVY_DEBUG
+	// memory breakpoints need to see every access
+	return 0;
+#else
+	const auto num = std::min({count,
+	                           string_max_run(si_base, si_index, index_mask, forward, sizeof(T)),
+	                           string_max_run(di_base, di_index, index_mask, forward, sizeof(T))});
+	if (num < 2) {
+		return 0;
+	}
+	const auto src = string_run_start(si_base + si_index, num, sizeof(T), forward);
+	const auto dest = string_run_start(di_base + di_index, num, sizeof(T), forward);
+
+	const auto read_base  = get_tlb_read(src);
+	const auto write_base = get_tlb_write(dest);
+	if (!read_base) {
+		return 0;
+	}
+	const auto src_ptr = read_base + src;
+	const auto bytes   = num * sizeof(T);
+
+	if (!write_base) {
+		const auto handler = get_tlb_writehandler(dest);
+		return (handler->flags & PFLAG_BLOCKWRITE) &&
+		                       handler->write_block(dest, src_ptr, bytes, num)
+		             ? num
+		             : 0;
+	}
+	const auto dest_ptr = write_base + dest;
+
+	// overlapping copies replicate data when done element by element, so
+	// these have to go the regular way
+	if (src_ptr < dest_ptr + bytes && dest_ptr < src_ptr + bytes) {
+		return 0;
+	}
+	std::memcpy(dest_ptr, src_ptr, bytes);
+	return num;
+#endif
+}
+
+template <typename T>
+static inline Bitu string_bulk_stos([[maybe_unused]] const PhysPt di_base,
+                                    [[maybe_unused]] const uint32_t di_index,
+                                    [[maybe_unused]] const uint32_t index_mask,
+                                    [[maybe_unused]] const bool forward,
+                                    [[maybe_unused]] const Bitu count,
+                                    [[maybe_unused]] const T value)
+{
+#if C_DEBUG && C_HEAVY_DEBUG
+	return 0;
+#else
+	const auto num = std::min(count,
+	                          string_max_run(di_base, di_index, index_mask, forward, sizeof(T)));
+	if (num < 2) {
+		return 0;
+	}
+	const auto dest = string_run_start(di_base + di_index, num, sizeof(T), forward);
+
+	const auto write_base = get_tlb_write(dest);
+	if (!write_base) {
+		const auto handler = get_tlb_writehandler(dest);
+		if (!(handler->flags & PFLAG_BLOCKWRITE)) {
+			return 0;
+		}
+		// all elements get the same value, so the order doesn't matter
+		uint8_t data[4096];
+		for (Bitu i = 0; i < num; ++i) {
+			if constexpr (sizeof(T) == 1) {
+				data[i] = value;
+			} else if constexpr (sizeof(T) == 2) {
+				host_writew(data + i * sizeof(T), value);
+			} else {
+				host_writed(data + i * sizeof(T), value);
+			}
+		}
+		return handler->write_block(dest, data, num * sizeof(T), num) ? num : 0;
+	}
+	auto dest_ptr = write_base + dest;
+	if constexpr (sizeof(T) == 1) {
+		std::memset(dest_ptr, value, num);
+	} else {
+		// all elements get the same value, so the order doesn't matter
+		for (Bitu i = 0; i < num; ++i, dest_ptr += sizeof(T)) {
+			if constexpr (sizeof(T) == 2) {
+				host_writew(dest_ptr, value);
+			} else {
+				host_writed(dest_ptr, value);
+			}
+		}
+	}
+	return num;
+#endif
+}
+
+/*
+	Bulk paths for REP INS and REP OUTS on ports whose device can stream a
+	run of elements at once (see IO_RegisterBlockHandlers), like the IDE
+	data port. Only ascending runs within plain RAM pages are done, as the
+	device hands out its buffer in order.
+*/
+
+template <typename T>
+static inline Bitu string_bulk_ins([[maybe_unused]] const io_port_t port,
+                                   [[maybe_unused]] const PhysPt di_base,
+                                   [[maybe_unused]] const uint32_t di_index,
+                                   [[maybe_unused]] const uint32_t index_mask,
+                                   [[maybe_unused]] const bool forward,
+                                   [[maybe_unused]] const Bitu count)
+{
+#if C_DEBUG && C_HEAVY_DEBUG
+	return 0;
+#else
+	if (!forward) {
+		return 0;
+	}
+	const auto num = std::min(count,
+	                          string_max_run(di_base, di_index, index_mask, forward, sizeof(T)));
+	if (num < 2) {
+		return 0;
+	}
+	const auto dest       = di_base + di_index;
+	const auto write_base = get_tlb_write(dest);
+	if (!write_base) {
+		return 0;
+	}
+	constexpr auto width = static_cast<io_width_t>(sizeof(T));
+	return IO_ReadBlock(port, width, write_base + dest, num);
+#endif
+}
+
+template <typename T>
+static inline Bitu string_bulk_outs([[maybe_unused]] const io_port_t port,
+                                    [[maybe_unused]] const PhysPt si_base,
+                                    [[maybe_unused]] const uint32_t si_index,
+                                    [[maybe_unused]] const uint32_t index_mask,
+                                    [[maybe_unused]] const bool forward,
+                                    [[maybe_unused]] const Bitu count)
+{
+#if C_DEBUG && C_HEAVY_DEBUG
+	return 0;
+#else
+	if (!forward) {
+		return 0;
+	}
+	const auto num = std::min(count,
+	                          string_max_run(si_base, si_index, index_mask, forward, sizeof(T)));
+	if (num < 2) {
+		return 0;
+	}
+	const auto src       = si_base + si_index;
+	const auto read_base = get_tlb_read(src);
+	if (!read_base) {
+		return 0;
+	}
+	constexpr auto width = static_cast<io_width_t>(sizeof(T));
+	return IO_WriteBlock(port, width, read_base + src, num);
+#endif
+}
+
 #endif
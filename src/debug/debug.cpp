@@ -28,6 +28,7 @@
 #include <list>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "debug.h"
@@ -51,6 +52,7 @@
 #include "keyboard.h"
 #include "setup.h"
 #include "std_filesystem.h"
+#include "voodoo.h"
 
 SDL_Window *GFX_GetSDLWindow(void);
 
@@ -289,6 +291,9 @@ static std::vector<CDebugVar *> varList = {};
 
 bool skipFirstInstruction = false;
 
+// Set when breakpoints are added, removed or change their type
+static bool breakpoint_index_dirty = true;
+
 enum EBreakpoint {
 	BKPNT_UNKNOWN,
 	BKPNT_PHYSICAL,
@@ -310,7 +315,7 @@ public:
 	void					SetAddress		(PhysPt adr)				{ location = adr; type = BKPNT_PHYSICAL; }
 	void					SetInt			(uint8_t _intNr, uint16_t ah, uint16_t al)	{ intNr = _intNr, ahValue = ah; alValue = al; type = BKPNT_INTERRUPT; }
 	void					SetOnce			(bool _once)				{ once = _once; }
-	void					SetType			(EBreakpoint _type)			{ type = _type; }
+	void					SetType			(EBreakpoint _type)			{ type = _type; breakpoint_index_dirty = true; }
 	void					SetValue		(uint8_t value)				{ ahValue = value; }
 	void					SetOther		(uint8_t other)				{ alValue = other; }
 
@@ -359,6 +364,7 @@ public:
 	static bool				DeleteByIndex		(uint16_t index);
 	static void				DeleteAll			(void);
 	static void				ShowList			(void);
+	static void				UpdateIndex			(void);
 
 
 private:
@@ -431,6 +437,56 @@ void CBreakpoint::Activate(bool _active)
 // Statics
 static std::list<CBreakpoint *> BPoints = {};
 
+// The list keeps the order shown to the user; these index it so the checks
+// done for every instruction and memory read don't have to walk it
+static std::unordered_multimap<PhysPt, CBreakpoint*> physical_breakpoints = {};
+
+#if C_HEAVY_DEBUG
+constexpr auto BreakpointPageShift = 12;
+
+static std::unordered_multimap<PhysPt, CBreakpoint*> read_breakpoints = {};
+static std::vector<bool> read_breakpoint_pages = {};
+
+// Memory breakpoints checked on every instruction, in list order
+static std::vector<CBreakpoint*> memory_breakpoints = {};
+#endif
+
+void CBreakpoint::UpdateIndex()
+{
+	if (!breakpoint_index_dirty) {
+		return;
+	}
+	breakpoint_index_dirty = false;
+
+	physical_breakpoints.clear();
+#if C_HEAVY_DEBUG
+	read_breakpoints.clear();
+	read_breakpoint_pages.assign(1 << (32 - BreakpointPageShift), false);
+	memory_breakpoints.clear();
+#endif
+	for (CBreakpoint* bp : BPoints) {
+		switch (bp->GetType()) {
+		case BKPNT_PHYSICAL:
+			physical_breakpoints.emplace(bp->GetLocation(), bp);
+			break;
+#if C_HEAVY_DEBUG
+		case BKPNT_MEMORY_READ:
+			read_breakpoints.emplace(bp->GetLocation(), bp);
+			read_breakpoint_pages[bp->GetLocation() >>
+			                      BreakpointPageShift] = true;
+			memory_breakpoints.push_back(bp);
+			break;
+		case BKPNT_MEMORY:
+		case BKPNT_MEMORY_PROT:
+		case BKPNT_MEMORY_LINEAR:
+			memory_breakpoints.push_back(bp);
+			break;
+#endif
+		default: break;
+		}
+	}
+}
+
 #if C_HEAVY_DEBUG
 template <typename T>
 void DEBUG_UpdateMemoryReadBreakpoints(const PhysPt addr)
@@ -438,18 +494,29 @@ void DEBUG_UpdateMemoryReadBreakpoints(const PhysPt addr)
 	static_assert(std::is_unsigned_v<T>);
 	static_assert(std::is_integral_v<T>);
 
-	for (CBreakpoint* bp : BPoints) {
-		if (bp->GetType() == BKPNT_MEMORY_READ) {
-			const PhysPt location_begin = bp->GetLocation();
-			const PhysPt location_end = location_begin + sizeof(T);
-			if ((addr >= location_begin) && (addr < location_end)) {
-				DEBUG_ShowMsg("bpmr hit: %04X:%04X, cs:ip = %04X:%04X",
-				              bp->GetSegment(),
-				              bp->GetOffset(),
-				              SegValue(cs),
-				              reg_eip);
-				bp->FlagMemoryAsRead();
-			}
+	CBreakpoint::UpdateIndex();
+	if (read_breakpoints.empty()) {
+		return;
+	}
+
+	// A read of addr hits the breakpoints located up to sizeof(T) - 1
+	// bytes before it, which can be on the previous page
+	const PhysPt first = addr - (sizeof(T) - 1);
+	if (!read_breakpoint_pages[first >> BreakpointPageShift] &&
+	    !read_breakpoint_pages[addr >> BreakpointPageShift]) {
+		return;
+	}
+
+	for (PhysPt location = first; location != addr + 1; ++location) {
+		const auto [begin, end] = read_breakpoints.equal_range(location);
+		for (auto it = begin; it != end; ++it) {
+			CBreakpoint* bp = it->second;
+			DEBUG_ShowMsg("bpmr hit: %04X:%04X, cs:ip = %04X:%04X",
+			              bp->GetSegment(),
+			              bp->GetOffset(),
+			              SegValue(cs),
+			              reg_eip);
+			bp->FlagMemoryAsRead();
 		}
 	}
 }
@@ -466,6 +533,7 @@ CBreakpoint* CBreakpoint::AddBreakpoint(uint16_t seg, uint32_t off, bool once)
 	bp->SetAddress		(seg,off);
 	bp->SetOnce			(once);
 	BPoints.push_front	(bp);
+	breakpoint_index_dirty = true;
 	return bp;
 }
 
@@ -475,6 +543,7 @@ CBreakpoint* CBreakpoint::AddIntBreakpoint(uint8_t intNum, uint16_t ah, uint16_t
 	bp->SetInt			(intNum,ah,al);
 	bp->SetOnce			(once);
 	BPoints.push_front	(bp);
+	breakpoint_index_dirty = true;
 	return bp;
 }
 
@@ -485,6 +554,7 @@ CBreakpoint* CBreakpoint::AddMemBreakpoint(uint16_t seg, uint32_t off)
 	bp->SetOnce			(false);
 	bp->SetType			(BKPNT_MEMORY);
 	BPoints.push_front	(bp);
+	breakpoint_index_dirty = true;
 	return bp;
 }
 
@@ -521,67 +591,74 @@ bool CBreakpoint::CheckBreakpoint(Bitu seg, Bitu off)
 	// Quick exit if there are no breakpoints
 	if (BPoints.empty()) return false;
 
-	// Search matching breakpoint
-	for (auto i = BPoints.begin(); i != BPoints.end(); ++i) {
-		auto bp = (*i);
+	UpdateIndex();
 
-		if ((bp->GetType() == BKPNT_PHYSICAL) && bp->IsActive() &&
-		    (bp->GetLocation() == GetAddress(seg, off))) {
-			// Found
-			if (bp->GetOnce()) {
-				// delete it, if it should only be used once
-				BPoints.erase(i);
+	// Search matching breakpoint
+	const auto [begin, end] = physical_breakpoints.equal_range(
+	        GetAddress(seg, off));
+	for (auto it = begin; it != end; ++it) {
+		auto bp = it->second;
+		if (!bp->IsActive()) {
+			continue;
+		}
+		// Found
+		if (bp->GetOnce()) {
+			// delete it, if it should only be used once
+			BPoints.remove(bp);
+			bp->Activate(false);
+			delete bp;
+		} else {
+			// Also look for once-only breakpoints at this address
+			bp = FindPhysBreakpoint(seg, off, true);
+			if (bp) {
+				BPoints.remove(bp);
 				bp->Activate(false);
 				delete bp;
-			} else {
-				// Also look for once-only breakpoints at this address
-				bp = FindPhysBreakpoint(seg, off, true);
-				if (bp) {
-					BPoints.remove(bp);
-					bp->Activate(false);
-					delete bp;
-				}
 			}
-			return true;
 		}
+		breakpoint_index_dirty = true;
+		return true;
+	}
 #if C_HEAVY_DEBUG
-		// Memory breakpoint support
-		else if (bp->IsActive()) {
-			if ((bp->GetType()==BKPNT_MEMORY) || (bp->GetType()==BKPNT_MEMORY_PROT) || (bp->GetType()==BKPNT_MEMORY_LINEAR)) {
-				// Watch Protected Mode Memoryonly in pmode
-				if (bp->GetType()==BKPNT_MEMORY_PROT) {
-					// Check if pmode is active
-					if (!cpu.pmode) return false;
-					// Check if descriptor is valid
-					Descriptor desc;
-					if (!cpu.gdt.GetDescriptor(bp->GetSegment(),desc)) return false;
-					if (desc.GetLimit()==0) return false;
-				}
+	// Memory breakpoint support
+	for (auto bp : memory_breakpoints) {
+		if (!bp->IsActive()) {
+			continue;
+		}
+		if ((bp->GetType()==BKPNT_MEMORY) || (bp->GetType()==BKPNT_MEMORY_PROT) || (bp->GetType()==BKPNT_MEMORY_LINEAR)) {
+			// Watch Protected Mode Memoryonly in pmode
+			if (bp->GetType()==BKPNT_MEMORY_PROT) {
+				// Check if pmode is active
+				if (!cpu.pmode) return false;
+				// Check if descriptor is valid
+				Descriptor desc;
+				if (!cpu.gdt.GetDescriptor(bp->GetSegment(),desc)) return false;
+				if (desc.GetLimit()==0) return false;
+			}
 
-				Bitu address; 
-				if (bp->GetType()==BKPNT_MEMORY_LINEAR) address = bp->GetOffset();
-				else address = GetAddress(bp->GetSegment(),bp->GetOffset());
-				uint8_t value=0;
-				if (mem_readb_checked(address,&value)) return false;
-				if (bp->GetValue() != value) {
-					// Yup, memory value changed
-					DEBUG_ShowMsg("DEBUG: Memory breakpoint %s: %04X:%04X - %02X -> %02X\n",(bp->GetType()==BKPNT_MEMORY_PROT)?"(Prot)":"",bp->GetSegment(),bp->GetOffset(),bp->GetValue(),value);
-					bp->SetValue(value);
-					return true;
-				}
-			} else if (bp->GetType() == BKPNT_MEMORY_READ) {
-				if (bp->WasMemoryRead()) {
-					// Yup, memory value was read
-					DEBUG_ShowMsg("DEBUG: Memory read breakpoint: %04X:%04X\n",
-					              bp->GetSegment(),
-					              bp->GetOffset());
-					bp->FlagMemoryAsUnread();
-					return true;
-				}
+			Bitu address; 
+			if (bp->GetType()==BKPNT_MEMORY_LINEAR) address = bp->GetOffset();
+			else address = GetAddress(bp->GetSegment(),bp->GetOffset());
+			uint8_t value=0;
+			if (mem_readb_checked(address,&value)) return false;
+			if (bp->GetValue() != value) {
+				// Yup, memory value changed
+				DEBUG_ShowMsg("DEBUG: Memory breakpoint %s: %04X:%04X - %02X -> %02X\n",(bp->GetType()==BKPNT_MEMORY_PROT)?"(Prot)":"",bp->GetSegment(),bp->GetOffset(),bp->GetValue(),value);
+				bp->SetValue(value);
+				return true;
+			}
+		} else if (bp->GetType() == BKPNT_MEMORY_READ) {
+			if (bp->WasMemoryRead()) {
+				// Yup, memory value was read
+				DEBUG_ShowMsg("DEBUG: Memory read breakpoint: %04X:%04X\n",
+				              bp->GetSegment(),
+				              bp->GetOffset());
+				bp->FlagMemoryAsUnread();
+				return true;
 			}
 		}
-#endif
 	}
+#endif
 	return false;
 }
 
@@ -606,6 +683,7 @@ bool CBreakpoint::CheckIntBreakpoint([[maybe_unused]] PhysPt adr, uint8_t intNr,
 					BPoints.erase(i);
 					bp->Activate(false);
 					delete bp;
+					breakpoint_index_dirty = true;
 				}
 				return true;
 			}
@@ -621,6 +699,7 @@ void CBreakpoint::DeleteAll()
 		delete bp;
 	}
 	BPoints.clear();
+	breakpoint_index_dirty = true;
 }
 
 bool CBreakpoint::DeleteByIndex(uint16_t index)
@@ -636,6 +715,7 @@ bool CBreakpoint::DeleteByIndex(uint16_t index)
 	BPoints.erase(it);
 	bp->Activate(false);
 	delete bp;
+	breakpoint_index_dirty = true;
 	return true;
 }
 
@@ -682,6 +762,7 @@ bool CBreakpoint::DeleteBreakpoint(uint16_t seg, uint32_t off)
 	if (bp) {
 		BPoints.remove(bp);
 		delete bp;
+		breakpoint_index_dirty = true;
 		return true;
 	}
 
@@ -1375,6 +1456,23 @@ bool ParseCommand(char* str) {
 
 	if (command == "CPU") {LogCPUInfo(); return true;}
 
+	if (command == "TLB") {
+		PAGING_LogStats();
+		return true;
+	}
+
+#if C_DYNREC
+	if (command == "DYNREC") {
+		CPU_Core_Dynrec_LogStats();
+		return true;
+	}
+#endif
+
+	if (command == "VOODOO") {
+		VOODOO_LogStats();
+		return true;
+	}
+
 	if (command == "INTVEC") {
 		if (found[0] != 0) {
 			OutputVecTable(found);
@@ -1460,6 +1558,11 @@ bool ParseCommand(char* str) {
 		DEBUG_ShowMsg("INTHAND [intNum]          - Set code view to interrupt handler.\n");
 
 		DEBUG_ShowMsg("CPU                       - Display CPU status information.\n");
+		DEBUG_ShowMsg("TLB                       - Display TLB refill statistics.\n");
+#if C_DYNREC
+		DEBUG_ShowMsg("DYNREC                    - Display dynamic core statistics.\n");
+#endif
+		DEBUG_ShowMsg("VOODOO                    - Display 3dfx Voodoo rasterizer statistics.\n");
 		DEBUG_ShowMsg("GDT                       - Lists descriptors of the GDT.\n");
 		DEBUG_ShowMsg("LDT                       - Lists descriptors of the LDT.\n");
 		DEBUG_ShowMsg("IDT                       - Lists descriptors of the IDT.\n");
@@ -0,0 +1,198 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "guest_profiler.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "capture/capture.h"
+#include "cpu.h"
+#include "dosbox.h"
+#include "pic.h"
+#include "regs.h"
+#include "string_utils.h"
+
+// Every program DOS loaded, the later ones taking precedence where they
+// reuse the memory of earlier ones. Their numbers are part of the sample
+// keys, so they're never removed.
+struct LoadedProgram {
+	std::string name        = {};
+	uint16_t load_seg       = 0;
+	uint32_t num_paragraphs = 0;
+};
+
+// The numbers of the programs have 15 bits in the sample keys
+constexpr size_t MaxPrograms = 0x7fff;
+
+static std::vector<LoadedProgram> programs = {};
+
+// Sample keys: the offset in the low 32 bits, then the code segment or
+// selector, then the number of the program plus one (or zero outside of
+// the programs), and the protected mode in the top bit
+constexpr uint64_t ProtectedModeKey = uint64_t{1} << 63;
+constexpr int ProgramShift          = 48;
+constexpr int SegmentShift          = 32;
+
+static struct {
+	bool is_running     = false;
+	int interval_cycles = DefaultProfilerInterval;
+	int64_t num_samples = 0;
+
+	std::unordered_map<uint64_t, uint32_t> histogram = {};
+} profiler = {};
+
+void PROFILER_AddProgram(const char* name, const uint16_t load_seg,
+                         const uint32_t size)
+{
+	if (programs.size() >= MaxPrograms) {
+		return;
+	}
+	std::string base_name = name;
+	const auto pos = base_name.find_last_of(":\\");
+	if (pos != std::string::npos) {
+		base_name.erase(0, pos + 1);
+	}
+	programs.push_back({base_name, load_seg, (size + 15) / 16});
+}
+
+static int find_program(const uint16_t seg)
+{
+	for (auto i = programs.size(); i-- > 0;) {
+		const auto& p = programs[i];
+		const auto para = static_cast<uint32_t>(seg - p.load_seg);
+		if (seg >= p.load_seg && para < p.num_paragraphs) {
+			return static_cast<int>(i);
+		}
+	}
+	return -1;
+}
+
+static double interval_ms()
+{
+	return static_cast<double>(profiler.interval_cycles) /
+	       std::max(CPU_CycleMax, 1);
+}
+
+static void take_sample(uint32_t /*val*/)
+{
+	const auto seg = SegValue(cs);
+
+	auto key = (uint64_t{seg} << SegmentShift) | reg_eip;
+	if (cpu.pmode && !GETFLAG(VM)) {
+		key |= ProtectedModeKey;
+	} else if (const auto program = find_program(seg); program >= 0) {
+		key |= uint64_t(program + 1) << ProgramShift;
+	}
+	++profiler.histogram[key];
+	++profiler.num_samples;
+
+	PIC_AddEvent(take_sample, interval_ms());
+}
+
+void PROFILER_Start(const int interval_cycles)
+{
+	if (profiler.is_running) {
+		PIC_RemoveEvents(take_sample);
+	}
+	profiler.is_running      = true;
+	profiler.interval_cycles = std::max(interval_cycles, 1);
+	profiler.num_samples     = 0;
+	profiler.histogram.clear();
+
+	PIC_AddEvent(take_sample, interval_ms());
+}
+
+static std::string format_frames(const uint64_t key)
+{
+	const auto seg    = static_cast<uint16_t>(key >> SegmentShift);
+	const auto offset = static_cast<uint32_t>(key);
+
+	if (key & ProtectedModeKey) {
+		return format_str("protected mode;%04X;%04X:%08X",
+		                  seg, seg, offset);
+	}
+
+	const auto program = static_cast<int>((key >> ProgramShift) &
+	                                      MaxPrograms) - 1;
+	if (program >= 0) {
+		const auto& p = programs[static_cast<size_t>(program)];
+		const auto rel_seg = static_cast<uint16_t>(seg - p.load_seg);
+		return format_str("%s;%04X;%04X:%04X",
+		                  p.name.c_str(), rel_seg, rel_seg, offset);
+	}
+
+	const char* area = seg >= 0xf000 ? "BIOS"
+	                 : seg >= 0xc000 ? "ROM"
+	                                 : "real mode";
+	return format_str("%s;%04X;%04X:%04X", area, seg, seg, offset);
+}
+
+void PROFILER_Stop()
+{
+	if (!profiler.is_running) {
+		return;
+	}
+	PIC_RemoveEvents(take_sample);
+	profiler.is_running = false;
+
+	using Sample = std::pair<uint64_t, uint32_t>;
+
+	std::vector<Sample> samples(profiler.histogram.begin(),
+	                            profiler.histogram.end());
+	profiler.histogram.clear();
+
+	std::sort(samples.begin(),
+	          samples.end(),
+	          [](const Sample& a, const Sample& b) {
+		          return a.second > b.second;
+	          });
+
+	FILE* file = CAPTURE_CreateFile(CaptureType::GuestProfile);
+	if (!file) {
+		return;
+	}
+	for (const auto& [key, count] : samples) {
+		fprintf(file,
+		        "%s %" PRIu32 "\n",
+		        format_frames(key).c_str(),
+		        count);
+	}
+	fclose(file);
+}
+
+bool PROFILER_IsRunning()
+{
+	return profiler.is_running;
+}
+
+int PROFILER_GetInterval()
+{
+	return profiler.interval_cycles;
+}
+
+int64_t PROFILER_GetNumSamples()
+{
+	return profiler.num_samples;
+}
@@ -22,11 +22,15 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
+
 #include "callback.h"
 #include "channel_names.h"
+#include "checks.h"
 #include "dosbox.h"
 #include "pic.h"
 #include "string_utils.h"
+#include "tracy.h"
 
 // ******************************************************
 // Fake CDROM
@@ -182,6 +186,7 @@ void CDROM_Interface_Physical::InitAudio()
 
 void CDROM_Interface_Physical::CdAudioCallback(const uint16_t requested_frames)
 {
+	ZoneScoped;
 	assert(requested_frames > 0);
 
 	const size_t queue_size = queue.Size();
@@ -292,8 +297,291 @@ bool CDROM_Interface_Physical::GetAudioStatus(bool& playing, bool& pause)
 	return true;
 }
 
+// Sectors per chunk, 32 KB of cooked sectors
+constexpr uint32_t PhysicalChunkSectors = 16;
+
+// Enough for a few streams read at the same time
+constexpr size_t MaxPhysicalChunks = 8;
+
+// Polls within this time of the previous one don't query the drive again
+constexpr auto MinStatusQueryInterval = std::chrono::milliseconds(50);
+
+void CDROM_Interface_Physical::StartIo()
+{
+	if (io_thread.joinable()) {
+		return;
+	}
+	// The first answers are waited for; the drive is being mounted anyway
+	QueryStatus(true, true);
+
+	should_stop_io = false;
+	io_thread = std::thread(&CDROM_Interface_Physical::IoLoop, this);
+	set_thread_name(io_thread, "dosbox:cdio");
+}
+
+void CDROM_Interface_Physical::StopIo()
+{
+	{
+		std::lock_guard<std::mutex> lock(io_mutex);
+		should_stop_io = true;
+	}
+	io_waiter.notify_all();
+	if (io_thread.joinable()) {
+		io_thread.join();
+	}
+}
+
+void CDROM_Interface_Physical::QueryStatus(const bool should_query_tray,
+                                           const bool should_query_sub)
+{
+	bool media_present = false;
+	bool media_changed = false;
+	bool tray_open     = false;
+	if (should_query_tray) {
+		QueryMediaTrayStatus(media_present, media_changed, tray_open);
+	}
+
+	unsigned char attr  = 0;
+	unsigned char track = 0;
+	unsigned char index = 0;
+	TMSF rel_pos        = {};
+	TMSF abs_pos        = {};
+	const auto has_sub  = should_query_sub &&
+	                     QueryAudioSub(attr, track, index, rel_pos, abs_pos);
+
+	std::lock_guard<std::mutex> lock(io_mutex);
+	if (should_query_tray) {
+		status.media_present = media_present;
+		status.tray_open     = tray_open;
+
+		// Kept until it's reported, as the drive only reports it once
+		if (media_changed) {
+			status.media_changed = true;
+			chunks.clear();
+			last_read_sector = {};
+		}
+	}
+	if (should_query_sub) {
+		status.has_sub = has_sub;
+		status.attr    = attr;
+		status.track   = track;
+		status.index   = index;
+		status.rel_pos = rel_pos;
+		status.abs_pos = abs_pos;
+	}
+}
+
+// The io_mutex has to be held for this
+void CDROM_Interface_Physical::RequestStatus(
+        bool& is_requested, std::chrono::steady_clock::time_point& last_request)
+{
+	const auto now = std::chrono::steady_clock::now();
+	if (!io_thread.joinable() || now - last_request < MinStatusQueryInterval) {
+		return;
+	}
+	last_request = now;
+	is_requested = true;
+	io_waiter.notify_all();
+}
+
+bool CDROM_Interface_Physical::GetAudioSub(unsigned char& attr,
+                                           unsigned char& track,
+                                           unsigned char& index,
+                                           TMSF& relPos, TMSF& absPos)
+{
+	std::lock_guard<std::mutex> lock(io_mutex);
+	RequestStatus(is_sub_requested, last_sub_request);
+
+	attr   = status.attr;
+	track  = status.track;
+	index  = status.index;
+	relPos = status.rel_pos;
+	absPos = status.abs_pos;
+	return status.has_sub;
+}
+
+bool CDROM_Interface_Physical::GetMediaTrayStatus(bool& mediaPresent,
+                                                  bool& mediaChanged,
+                                                  bool& trayOpen)
+{
+	std::lock_guard<std::mutex> lock(io_mutex);
+	RequestStatus(is_tray_requested, last_tray_request);
+
+	mediaPresent = status.media_present;
+	mediaChanged = status.media_changed;
+	trayOpen     = status.tray_open;
+
+	status.media_changed = false;
+	return true;
+}
+
+void CDROM_Interface_Physical::InitNewMedia()
+{
+	std::unique_lock<std::mutex> lock(io_mutex);
+	next_chunk.reset();
+	io_waiter.wait(lock, [this] { return !reading_chunk.has_value(); });
+	chunks.clear();
+	last_read_sector = {};
+}
+
+bool CDROM_Interface_Physical::ReadChunk(const uint32_t first_sector,
+                                         std::vector<uint8_t>& data)
+{
+	data.resize(PhysicalChunkSectors * BYTES_PER_COOKED_REDBOOK_FRAME);
+	return ReadDrive(data.data(), false, first_sector, PhysicalChunkSectors);
+}
+
+// The io_mutex has to be held for these
+std::vector<uint8_t>* CDROM_Interface_Physical::FindChunk(const uint32_t first_sector)
+{
+	for (auto& chunk : chunks) {
+		if (chunk.first_sector == first_sector) {
+			chunk.last_used = ++chunk_use_count;
+			return &chunk.data;
+		}
+	}
+	return nullptr;
+}
+
+std::vector<uint8_t>& CDROM_Interface_Physical::InsertChunk(const uint32_t first_sector,
+                                                            std::vector<uint8_t>&& data)
+{
+	SectorChunk chunk = {std::move(data), ++chunk_use_count, first_sector};
+
+	auto is_older = [](const SectorChunk& a, const SectorChunk& b) {
+		return a.last_used < b.last_used;
+	};
+	if (chunks.size() < MaxPhysicalChunks) {
+		return chunks.emplace_back(std::move(chunk)).data;
+	}
+	auto& oldest = *std::min_element(chunks.begin(), chunks.end(), is_older);
+	oldest = std::move(chunk);
+	return oldest.data;
+}
+
+// Copies the cooked sector out of its chunk, reading the chunk if it isn't
+// cached yet. Returns false if the chunk can't be read, e.g., at the end of
+// the disc.
+bool CDROM_Interface_Physical::ReadCachedSector(const uint32_t sector,
+                                                uint8_t* buffer)
+{
+	const auto first_sector = sector / PhysicalChunkSectors * PhysicalChunkSectors;
+
+	std::unique_lock<std::mutex> lock(io_mutex);
+
+	const auto is_sequential = last_read_sector &&
+	                           sector == *last_read_sector + 1;
+	last_read_sector = sector;
+
+	// The I/O thread might be reading this chunk already
+	io_waiter.wait(lock, [&] { return reading_chunk != first_sector; });
+
+	auto chunk = FindChunk(first_sector);
+	if (!chunk) {
+		lock.unlock();
+		std::vector<uint8_t> data = {};
+		if (!ReadChunk(first_sector, data)) {
+			return false;
+		}
+		lock.lock();
+		chunk = &InsertChunk(first_sector, std::move(data));
+	}
+	memcpy(buffer,
+	       chunk->data() + (sector - first_sector) * BYTES_PER_COOKED_REDBOOK_FRAME,
+	       BYTES_PER_COOKED_REDBOOK_FRAME);
+
+	const auto next_sector = first_sector + PhysicalChunkSectors;
+	if (!is_sequential || !io_thread.joinable() ||
+	    reading_chunk == next_sector || FindChunk(next_sector)) {
+		return true;
+	}
+	next_chunk = next_sector;
+	io_waiter.notify_all();
+	return true;
+}
+
+bool CDROM_Interface_Physical::ReadSectorsHost(void* buffer, bool raw,
+                                               unsigned long sector,
+                                               unsigned long num)
+{
+	const auto dest = static_cast<uint8_t*>(buffer);
+
+	// Raw sectors are rarely read, e.g., by copy protection checks
+	if (raw) {
+		return ReadDrive(dest, raw, check_cast<uint32_t>(sector), check_cast<uint32_t>(num));
+	}
+	for (unsigned long i = 0; i < num; ++i) {
+		const auto sector_dest = dest + i * BYTES_PER_COOKED_REDBOOK_FRAME;
+		if (!ReadCachedSector(check_cast<uint32_t>(sector + i), sector_dest)) {
+			// Read the rest directly from the drive
+			return ReadDrive(sector_dest,
+			                 raw,
+			                 check_cast<uint32_t>(sector + i),
+			                 check_cast<uint32_t>(num - i));
+		}
+	}
+	return true;
+}
+
+bool CDROM_Interface_Physical::ReadSectors(PhysPt buffer, const bool raw,
+                                           const uint32_t sector, const uint16_t num)
+{
+	const auto sector_size = raw ? BYTES_PER_RAW_REDBOOK_FRAME
+	                             : BYTES_PER_COOKED_REDBOOK_FRAME;
+	std::vector<uint8_t> buf(num * sector_size, 0);
+
+	const auto is_read = ReadSectorsHost(buf.data(), raw, sector, num);
+	MEM_BlockWrite(buffer, buf.data(), buf.size());
+	return is_read;
+}
+
+void CDROM_Interface_Physical::IoLoop()
+{
+	std::unique_lock<std::mutex> lock(io_mutex);
+	while (true) {
+		io_waiter.wait(lock, [this] {
+			return should_stop_io || next_chunk || is_tray_requested ||
+			       is_sub_requested;
+		});
+		if (should_stop_io) {
+			return;
+		}
+
+		// Reading ahead comes first as the data is about to be used
+		if (next_chunk) {
+			const auto first_sector = *next_chunk;
+			next_chunk.reset();
+			reading_chunk = first_sector;
+			lock.unlock();
+
+			std::vector<uint8_t> data = {};
+			const auto is_read = ReadChunk(first_sector, data);
+
+			lock.lock();
+			if (is_read) {
+				InsertChunk(first_sector, std::move(data));
+			}
+			reading_chunk.reset();
+			io_waiter.notify_all();
+			continue;
+		}
+
+		const auto should_query_tray = is_tray_requested;
+		const auto should_query_sub  = is_sub_requested;
+		is_tray_requested = false;
+		is_sub_requested  = false;
+		lock.unlock();
+
+		QueryStatus(should_query_tray, should_query_sub);
+
+		lock.lock();
+	}
+}
+
 CDROM_Interface_Physical::~CDROM_Interface_Physical()
 {
+	StopIo();
+
 	if (mixer_channel) {
 		MIXER_DeregisterChannel(mixer_channel);
 	}
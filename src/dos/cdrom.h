@@ -24,15 +24,22 @@
 
 #include "dosbox.h"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstring>
 #include <fstream>
 #include <iostream>
 #include <limits>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "compressed_image.h"
 #include "support.h"
 #include "mem.h"
 #include "mixer.h"
@@ -238,6 +245,9 @@ private:
 
 	private:
 		std::ifstream* file;
+
+		// Reads the track when the file holds it compressed
+		std::unique_ptr<CompressedImage> compressed = {};
 	};
 
 	class AudioFile final : public TrackFile {
@@ -311,6 +321,16 @@ public:
 	static CDROM_Interface_Image* images[26];
 
 private:
+	struct DecodeJob {
+		std::shared_ptr<TrackFile> file = nullptr;
+		uint32_t byteOffset  = 0;
+		uint32_t trackFrames = 0;
+		uint32_t rate        = 0;
+		uint8_t channels     = 0;
+	};
+
+	enum class DecodeState { Decoding, Finished, Failed };
+
 	static struct imagePlayer {
 		// Objects, pointers, and then scalars; in descending size-order.
 		std::weak_ptr<TrackFile> trackFile = {};
@@ -321,18 +341,97 @@ private:
 		uint32_t                 totalTrackFrames   = 0;
 		uint32_t                 startSector        = 0;
 		uint32_t                 totalRedbookFrames = 0;
-		int16_t buffer[MixerBufferLength * REDBOOK_CHANNELS] = {0};
+		uint8_t                  trackChannels      = 0;
 		bool                     isPlaying          = false;
 		bool                     isPaused           = false;
+
+		// The decode-ahead thread seeks and decodes the playing track
+		// into the queue, so slow codecs never hold up the mixer
+		std::thread decoder = {};
+		std::mutex mutex = {};
+		std::condition_variable waiter = {};
+		std::optional<DecodeJob> nextJob = {};
+		std::atomic<DecodeState> decodeState = DecodeState::Finished;
+		bool shouldExit = false;
+
+		// Serialises access to the track files between the decoder
+		// and the sector reads
+		std::mutex fileMutex = {};
+
+		RWQueue<int16_t> decoded{1};
+		std::vector<int16_t> samples = {};
+
+		void StopDecoder()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				shouldExit = true;
+				decoded.Stop();
+			}
+			waiter.notify_all();
+			if (decoder.joinable()) {
+				decoder.join();
+			}
+		}
+
+		~imagePlayer()
+		{
+			StopDecoder();
+		}
 	} player;
 
+	// Data sectors are read from the track files a chunk at a time. Once
+	// they're read one after the other, the reader thread reads the next
+	// chunk while the current one is being used.
+	struct SectorChunk {
+		std::vector<uint8_t> data = {};
+		uint64_t last_used        = 0;
+		uint32_t first_sector     = 0;
+		uint32_t num_sectors      = 0;
+		uint16_t sector_size      = 0;
+	};
+
+	struct ChunkJob {
+		std::shared_ptr<TrackFile> file = nullptr;
+		uint32_t byte_offset  = 0;
+		uint32_t first_sector = 0;
+		uint32_t num_sectors  = 0;
+		uint16_t sector_size  = 0;
+	};
+
+	std::vector<SectorChunk> chunks          = {};
+	uint64_t chunk_use_count                 = 0;
+	std::optional<uint32_t> last_read_sector = {};
+	std::thread chunk_reader                 = {};
+	std::mutex chunk_mutex                   = {};
+	std::condition_variable chunk_waiter     = {};
+	std::optional<ChunkJob> next_chunk_job   = {};
+	std::optional<uint32_t> reading_chunk    = {};
+	bool should_stop_reading                 = false;
+
+	// Sequential reads stay in the same track, so it's looked at first
+	size_t last_track_index = 0;
+
 	// Private utility functions
 	bool  LoadIsoFile(const char *filename);
 	bool  CanReadPVD(TrackFile *file,
 	                 const uint16_t sectorSize,
 	                 const bool mode2);
 	std::vector<Track>::iterator GetTrack(const uint32_t sector);
+	bool ReadCachedSector(const Track& track, const uint32_t sector,
+	                      const uint32_t frame_offset,
+	                      const uint16_t length, uint8_t* buffer);
+	std::optional<ChunkJob> GetChunkJob(const Track& track,
+	                                    const uint32_t first_sector);
+	bool ReadChunk(const ChunkJob& job, SectorChunk& chunk);
+	SectorChunk* FindChunk(const uint32_t first_sector);
+	SectorChunk& InsertChunk(SectorChunk&& chunk);
+	void ReadChunksAhead();
+	void StopChunkReader();
+	void ClearChunks();
 	void CDAudioCallBack(uint16_t desired_frames);
+	static void DecodeAhead();
+	static void DecodeTrack(const DecodeJob& job);
 
 	// Private functions for cue sheet processing
 	bool  LoadCueSheet(const char *cuefile);
@@ -356,20 +455,54 @@ class CDROM_Interface_Physical : public CDROM_Interface {
 public:
 	~CDROM_Interface_Physical() override;
 
+	bool GetAudioSub(unsigned char& attr, unsigned char& track,
+	                 unsigned char& index, TMSF& relPos, TMSF& absPos) override;
 	bool GetAudioStatus(bool& playing, bool& pause) override;
+	bool GetMediaTrayStatus(bool& mediaPresent, bool& mediaChanged,
+	                        bool& trayOpen) override;
 	bool PlayAudioSector(const uint32_t start, uint32_t len) override;
 	bool PauseAudio(bool resume) override;
 	bool StopAudio() override;
 	void ChannelControl(TCtrl ctrl) override;
+	bool ReadSectors(PhysPt buffer, const bool raw, const uint32_t sector,
+	                 const uint16_t num) override;
+	bool ReadSectorsHost(void* buffer, bool raw, unsigned long sector,
+	                     unsigned long num) override;
+	void InitNewMedia() override;
 
 protected:
 	void InitAudio();
 
+	// Starts the I/O thread once the drive is open; it has to be stopped
+	// before the drive is closed
+	void StartIo();
+	void StopIo();
+
 private:
+	// Slow calls to the drive, which can take a second or more while it
+	// spins up; only made from the I/O thread, or on cache misses
 	virtual std::vector<int16_t> ReadAudio(const uint32_t sector, const uint32_t frames_requested) = 0;
+	virtual bool ReadDrive(uint8_t* buffer, const bool raw,
+	                       const uint32_t sector, const uint32_t num) = 0;
+	virtual bool QueryAudioSub(unsigned char& attr, unsigned char& track,
+	                           unsigned char& index, TMSF& relPos,
+	                           TMSF& absPos) = 0;
+	virtual void QueryMediaTrayStatus(bool& mediaPresent,
+	                                  bool& mediaChanged, bool& trayOpen) = 0;
+
 	void CdAudioCallback(const uint16_t requested_frames);
 	void CdReaderLoop();
 
+	bool ReadCachedSector(const uint32_t sector, uint8_t* buffer);
+	bool ReadChunk(const uint32_t first_sector, std::vector<uint8_t>& data);
+	std::vector<uint8_t>* FindChunk(const uint32_t first_sector);
+	std::vector<uint8_t>& InsertChunk(const uint32_t first_sector,
+	                                  std::vector<uint8_t>&& data);
+	void RequestStatus(bool& is_requested,
+	                   std::chrono::steady_clock::time_point& last_request);
+	void QueryStatus(const bool should_query_tray, const bool should_query_sub);
+	void IoLoop();
+
 	mixer_channel_t mixer_channel  = {};
 	std::thread thread             = {};
 	std::mutex mutex               = {};
@@ -379,6 +512,45 @@ private:
 	uint32_t sectors_remaining     = 0;
 	bool should_exit               = false;
 	bool is_paused                 = false;
+
+	// Cooked data sectors are read a chunk at a time. Once they're read
+	// one after the other, the I/O thread reads the next chunk while the
+	// current one is being used.
+	struct SectorChunk {
+		std::vector<uint8_t> data = {};
+		uint64_t last_used        = 0;
+		uint32_t first_sector     = 0;
+	};
+	std::vector<SectorChunk> chunks          = {};
+	uint64_t chunk_use_count                 = 0;
+	std::optional<uint32_t> last_read_sector = {};
+	std::optional<uint32_t> next_chunk       = {};
+	std::optional<uint32_t> reading_chunk    = {};
+
+	// The drive status is polled often, e.g., by MSCDEX and ATAPI drivers
+	// and by games waiting for CD audio to end. The polls are answered
+	// with the results of the last queries, while the I/O thread queries
+	// the drive again in the background.
+	struct {
+		bool media_present   = false;
+		bool media_changed   = false;
+		bool tray_open       = false;
+		bool has_sub         = false;
+		unsigned char attr   = 0;
+		unsigned char track  = 0;
+		unsigned char index  = 0;
+		TMSF rel_pos         = {};
+		TMSF abs_pos         = {};
+	} status = {};
+	bool is_tray_requested = false;
+	bool is_sub_requested  = false;
+	std::chrono::steady_clock::time_point last_tray_request = {};
+	std::chrono::steady_clock::time_point last_sub_request  = {};
+
+	std::thread io_thread                = {};
+	std::mutex io_mutex                  = {};
+	std::condition_variable io_waiter    = {};
+	bool should_stop_io                  = false;
 };
 
 #if defined (LINUX)
@@ -390,14 +562,6 @@ public:
 	bool GetUPC(unsigned char& attr, std::string& upc) override;
 	bool GetAudioTracks(uint8_t& stTrack, uint8_t& end, TMSF& leadOut) override;
 	bool GetAudioTrackInfo(uint8_t track, TMSF& start, unsigned char& attr) override;
-	bool GetAudioSub(unsigned char& attr, unsigned char& track,
-	                 unsigned char& index, TMSF& relPos, TMSF& absPos) override;
-	bool GetMediaTrayStatus(bool& mediaPresent, bool& mediaChanged,
-	                        bool& trayOpen) override;
-	bool ReadSectors(PhysPt buffer, const bool raw, const uint32_t sector,
-	                 const uint16_t num) override;
-	bool ReadSectorsHost(void* buffer, bool raw, unsigned long sector,
-	                     unsigned long num) override;
 	bool LoadUnloadMedia(bool unload) override;
 	bool HasFullMscdexSupport() override
 	{
@@ -408,6 +572,12 @@ private:
 	bool IsOpen() const;
 	bool Open(const char* device_name);
 	std::vector<int16_t> ReadAudio(const uint32_t sector, const uint32_t frames_requested) override;
+	bool ReadDrive(uint8_t* buffer, const bool raw, const uint32_t sector,
+	               const uint32_t num) override;
+	bool QueryAudioSub(unsigned char& attr, unsigned char& track,
+	                   unsigned char& index, TMSF& relPos, TMSF& absPos) override;
+	void QueryMediaTrayStatus(bool& mediaPresent, bool& mediaChanged,
+	                          bool& trayOpen) override;
 
 	int cdrom_fd = -1;
 };
@@ -424,14 +594,6 @@ public:
 	bool GetUPC(unsigned char& attr, std::string& upc) override;
 	bool GetAudioTracks(uint8_t& stTrack, uint8_t& end, TMSF& leadOut) override;
 	bool GetAudioTrackInfo(uint8_t track, TMSF& start, unsigned char& attr) override;
-	bool GetAudioSub(unsigned char& attr, unsigned char& track,
-	                 unsigned char& index, TMSF& relPos, TMSF& absPos) override;
-	bool GetMediaTrayStatus(bool& mediaPresent, bool& mediaChanged,
-	                        bool& trayOpen) override;
-	bool ReadSectors(PhysPt buffer, const bool raw, const uint32_t sector,
-	                 const uint16_t num) override;
-	bool ReadSectorsHost(void* buffer, bool raw, unsigned long sector,
-	                     unsigned long num) override;
 	bool LoadUnloadMedia(bool unload) override;
 	bool HasFullMscdexSupport() override
 	{
@@ -440,6 +602,12 @@ public:
 
 private:
 	std::vector<int16_t> ReadAudio(const uint32_t sector, const uint32_t frames_requested) override;
+	bool ReadDrive(uint8_t* buffer, const bool raw, const uint32_t sector,
+	               const uint32_t num) override;
+	bool QueryAudioSub(unsigned char& attr, unsigned char& track,
+	                   unsigned char& index, TMSF& relPos, TMSF& absPos) override;
+	void QueryMediaTrayStatus(bool& mediaPresent, bool& mediaChanged,
+	                          bool& trayOpen) override;
 	bool IsOpen() const;
 	bool Open(const char drive_letter);
 
@@ -47,6 +47,7 @@
 #include "math_utils.h"
 #include "setup.h"
 #include "string_utils.h"
+#include "support.h"
 
 // String maximums, local to this file
 #define MAX_LINE_LENGTH 512
@@ -104,6 +105,11 @@ CDROM_Interface_Image::BinaryFile::BinaryFile(const char *filename, bool &error)
 	file = new std::ifstream(filename, std::ios::in | std::ios::binary);
 	// If new fails, an exception is generated and scope leaves this constructor
 	error = file->fail();
+
+	if (!error && CompressedImage::IsCompressed(filename)) {
+		compressed = CompressedImage::Open(filename);
+		error      = !compressed;
+	}
 }
 
 CDROM_Interface_Image::BinaryFile::~BinaryFile()
@@ -129,6 +135,12 @@ bool CDROM_Interface_Image::BinaryFile::read(uint8_t *buffer,
 	if (adjusted_bytes == 0) // no work to do!
 		return true;
 
+	if (compressed) {
+		return offsetInsideTrack(offset) &&
+		       compressed->Read(offset, adjusted_bytes, buffer) ==
+		               adjusted_bytes;
+	}
+
 	// Reposition if needed
 	if (!seek(offset))
 		return false;
@@ -140,7 +152,11 @@ bool CDROM_Interface_Image::BinaryFile::read(uint8_t *buffer,
 int CDROM_Interface_Image::BinaryFile::getLength()
 {
 	// Return our cached result if we've already been asked before
-	if (length_redbook_bytes < 0 && file) {
+	if (length_redbook_bytes < 0 && compressed) {
+		length_redbook_bytes = static_cast<int>(
+		        std::min(compressed->GetSize(),
+		                 static_cast<uint64_t>(MAX_REDBOOK_BYTES)));
+	} else if (length_redbook_bytes < 0 && file) {
 		file->seekg(0, std::ios::end);
 		/**
 		 *  All read(..) operations involve an absolute position and
@@ -175,6 +191,10 @@ bool CDROM_Interface_Image::BinaryFile::seek(const uint32_t offset)
 	if (!offsetInsideTrack(offset))
 		return false;
 
+	// Compressed tracks are read from the offset given each time
+	if (compressed)
+		return true;
+
 	if (static_cast<uint32_t>(file->tellg()) == offset)
 		return true;
 
@@ -199,18 +219,29 @@ uint32_t CDROM_Interface_Image::BinaryFile::decode(int16_t *buffer,
 	assertm(audio_pos < MAX_REDBOOK_BYTES,
 	        "Tried to decode audio before the playback position was set");
 
-	// Reposition against our last audio position if needed
-	if (static_cast<uint32_t>(file->tellg()) != audio_pos)
-		if (!seek(audio_pos))
-			return 0;
+	uint32_t bytes_read = 0;
+	if (compressed) {
+		const auto num_read = compressed->Read(
+		        audio_pos,
+		        desired_track_frames * BYTES_PER_REDBOOK_PCM_FRAME,
+		        reinterpret_cast<uint8_t*>(buffer));
+		bytes_read = static_cast<uint32_t>(num_read.value_or(0));
+	} else {
+		// Reposition against our last audio position if needed
+		if (static_cast<uint32_t>(file->tellg()) != audio_pos)
+			if (!seek(audio_pos))
+				return 0;
 
-	file->read((char*)buffer, desired_track_frames * BYTES_PER_REDBOOK_PCM_FRAME);
-	/**
-	 *  Note: gcount returns a signed type, but according to specification:
-	 *  "Except in the constructors of std::strstreambuf, negative values of
-	 *  std::streamsize are never used."; so we store it as unsigned.
-	 */
-	const uint32_t bytes_read = static_cast<uint32_t>(file->gcount());
+		file->read((char*)buffer,
+		           desired_track_frames * BYTES_PER_REDBOOK_PCM_FRAME);
+		/**
+		 *  Note: gcount returns a signed type, but according to
+		 *  specification: "Except in the constructors of
+		 *  std::strstreambuf, negative values of std::streamsize are
+		 *  never used."; so we store it as unsigned.
+		 */
+		bytes_read = static_cast<uint32_t>(file->gcount());
+	}
 
 	// decoding is an audio-task, so update our audio position
 	audio_pos += bytes_read;
@@ -501,6 +532,11 @@ CDROM_Interface_Image::CDROM_Interface_Image(uint8_t sub_unit)
 
 			player.channel->Enable(false); // only enabled during playback periods
 		}
+		if (!player.decoder.joinable()) {
+			player.shouldExit = false;
+			player.decoder = std::thread(&CDROM_Interface_Image::DecodeAhead);
+			set_thread_name(player.decoder, "dosbox:cdda");
+		}
 #ifdef DEBUG
 		LOG_MSG("CDROM: Initialised the %s audio channel", ChannelName::CdAudio);
 #endif
@@ -510,6 +546,7 @@ CDROM_Interface_Image::CDROM_Interface_Image(uint8_t sub_unit)
 
 CDROM_Interface_Image::~CDROM_Interface_Image()
 {
+	StopChunkReader();
 	refCount--;
 
 	// Stop playback before wiping out the CD Player
@@ -521,14 +558,20 @@ CDROM_Interface_Image::~CDROM_Interface_Image()
 		}
 		MIXER_DeregisterChannel(player.channel);
 		player.channel.reset();
+		player.StopDecoder();
 	}
 	if (player.cd == this) {
+		// Let go of our track files
+		StopAudio();
 		player.cd = nullptr;
 	}
 }
 
 bool CDROM_Interface_Image::SetDevice(const char* path)
 {
+	ClearChunks();
+	last_track_index = 0;
+
 	const bool result = LoadCueSheet(path) || LoadIsoFile(path);
 	if (!result) {
 		// print error message on dosbox console
@@ -726,21 +769,11 @@ bool CDROM_Interface_Image::PlayAudioSector(uint32_t start, uint32_t len)
 		start = track->start;
 	}
 
-	// Calculate the requested byte offset from the sector offset
+	// Calculate the requested byte offset from the sector offset. Seeking
+	// compressed tracks can take a while, so the decoder does it.
 	const auto sector_offset = start - track->start;
 	const auto byte_offset = track->skip + sector_offset * track->sectorSize;
 
-	// Guard: Bail if our track could not be seeked
-	if (!track_file->seek(byte_offset)) {
-		LOG_MSG("CDROM: Track %d failed to seek to byte %u, so cancelling playback",
-		        track->number, byte_offset);
-		StopAudio();
-		return false;
-	}
-
-	// We're performing an audio-task, so update the audio position
-	track_file->setAudioPosition(byte_offset);
-
 	// Get properties about the current track
 	const uint8_t track_channels = track_file->getChannels();
 	const uint32_t track_rate = track_file->getRate();
@@ -750,6 +783,7 @@ bool CDROM_Interface_Image::PlayAudioSector(uint32_t start, uint32_t len)
 	player.trackFile = track_file;
 	player.startSector = start;
 	player.totalRedbookFrames = len;
+	player.trackChannels = track_channels;
 	player.isPlaying = true;
 	player.isPaused = false;
 
@@ -772,6 +806,20 @@ bool CDROM_Interface_Image::PlayAudioSector(uint32_t start, uint32_t len)
 	player.totalTrackFrames = player.totalRedbookFrames *
 	                          (track_rate / REDBOOK_FRAMES_PER_SECOND);
 
+	// Hand the track over to the decoder, dropping anything it had
+	// decoded ahead for the previous request
+	{
+		std::lock_guard<std::mutex> lock(player.mutex);
+		player.decoded.Stop();
+		player.decodeState = DecodeState::Decoding;
+		player.nextJob     = DecodeJob{track_file,
+		                               byte_offset,
+		                               player.totalTrackFrames,
+		                               track_rate,
+		                               track_channels};
+	}
+	player.waiter.notify_all();
+
 #ifdef DEBUG
 	if (start < track->start) {
 		LOG_MSG("CDROM: Play sector %u to %u in the pregap of track %d [pregap %d,"
@@ -820,6 +868,11 @@ bool CDROM_Interface_Image::StopAudio(void)
 {
 	player.isPlaying = false;
 	player.isPaused = false;
+	{
+		std::lock_guard<std::mutex> lock(player.mutex);
+		player.nextJob.reset();
+		player.decoded.Stop();
+	}
 	if (player.channel) {
 		player.channel->Enable(false);
 	}
@@ -918,11 +971,31 @@ track_iter CDROM_Interface_Image::GetTrack(const uint32_t sector)
 	 *  track's range, which starts at the end of the prior track and goes to
 	 *  the current track's (start + length).
 	 */
+	auto is_in_track = [&](const size_t index) {
+		const auto& curr = tracks[index];
+		const uint32_t lower_bound = (index == 0)
+		                                   ? curr.start
+		                                   : tracks[index - 1].start +
+		                                             tracks[index - 1].length;
+		return lower_bound <= sector && sector < curr.start + curr.length;
+	};
+
+	// Reads mostly stay in the last track, or move on to the next one
+	for (auto index = last_track_index;
+	     index < tracks.size() && index <= last_track_index + 1;
+	     ++index) {
+		if (is_in_track(index)) {
+			last_track_index = index;
+			return tracks.begin() + static_cast<std::ptrdiff_t>(index);
+		}
+	}
+
 	track_iter track = tracks.begin();
 	uint32_t lower_bound = track->start;
 	while (track != tracks.end()) {
 		const uint32_t upper_bound = track->start + track->length;
 		if (lower_bound <= sector && sector < upper_bound) {
+			last_track_index = static_cast<size_t>(track - tracks.begin());
 			break;
 		}
 		++track;
@@ -963,15 +1036,22 @@ bool CDROM_Interface_Image::ReadSector(uint8_t *buffer, const bool raw, const ui
 #endif
 		return false;
 	}
-	uint32_t offset = track->skip + (sector - track->start) * track->sectorSize;
 	const uint16_t length = (raw ? BYTES_PER_RAW_REDBOOK_FRAME : BYTES_PER_COOKED_REDBOOK_FRAME);
 	if (track->sectorSize != BYTES_PER_RAW_REDBOOK_FRAME && raw) {
 		return false;
 	}
+	uint32_t frame_offset = 0;
 	if (track->sectorSize == BYTES_PER_RAW_REDBOOK_FRAME && !track->mode2 && !raw)
-		offset += 16;
+		frame_offset += 16;
 	if (track->mode2 && !raw)
-		offset += 24;
+		frame_offset += 24;
+
+	if (ReadCachedSector(*track, sector, frame_offset, length, buffer)) {
+		return true;
+	}
+	const uint32_t offset = track->skip +
+	                        (sector - track->start) * track->sectorSize +
+	                        frame_offset;
 
 #if 0 // Excessively verbose.. only enable if needed
 #ifdef DEBUG
@@ -982,9 +1062,223 @@ bool CDROM_Interface_Image::ReadSector(uint8_t *buffer, const bool raw, const ui
 	        length);
 #endif
 #endif
+	std::lock_guard<std::mutex> lock(player.fileMutex);
 	return track->file->read(buffer, offset, length);
 }
 
+// Sectors per chunk, about 74 KB with raw sectors
+constexpr uint32_t ChunkSectors = 32;
+
+// Enough for a few streams read at the same time, such as the video and
+// the sound of a movie kept in separate files
+constexpr size_t MaxChunks = 8;
+
+// Copies the sector out of its chunk, reading the chunk if it isn't cached
+// yet. Returns false for sectors that have to be read directly.
+bool CDROM_Interface_Image::ReadCachedSector(const Track& track,
+                                             const uint32_t sector,
+                                             const uint32_t frame_offset,
+                                             const uint16_t length,
+                                             uint8_t* buffer)
+{
+	// Audio sectors are read by the CD player, and the ones in pregaps
+	// aren't in the track file
+	if (track.attr != 0x40 || sector < track.start ||
+	    frame_offset + length > track.sectorSize) {
+		return false;
+	}
+	const auto first_sector = track.start +
+	                          (sector - track.start) / ChunkSectors * ChunkSectors;
+
+	const auto is_sequential = last_read_sector &&
+	                           sector == *last_read_sector + 1;
+	last_read_sector = sector;
+
+	std::unique_lock<std::mutex> lock(chunk_mutex);
+
+	// The reader thread might be reading this chunk already
+	chunk_waiter.wait(lock, [&] { return reading_chunk != first_sector; });
+
+	auto chunk = FindChunk(first_sector);
+	if (!chunk) {
+		const auto job = GetChunkJob(track, first_sector);
+		if (!job) {
+			return false;
+		}
+		lock.unlock();
+		SectorChunk read_chunk = {};
+		if (!ReadChunk(*job, read_chunk)) {
+			return false;
+		}
+		lock.lock();
+		chunk = &InsertChunk(std::move(read_chunk));
+	}
+	const auto index = sector - first_sector;
+	if (index >= chunk->num_sectors) {
+		return false;
+	}
+	memcpy(buffer,
+	       chunk->data.data() + index * chunk->sector_size + frame_offset,
+	       length);
+
+	if (!is_sequential) {
+		return true;
+	}
+	const auto next_sector = first_sector + ChunkSectors;
+	const auto is_queued   = (reading_chunk == next_sector) ||
+	                       (next_chunk_job &&
+	                        next_chunk_job->first_sector == next_sector);
+	if (is_queued || FindChunk(next_sector)) {
+		return true;
+	}
+	auto job = GetChunkJob(track, next_sector);
+	if (!job) {
+		return true;
+	}
+	next_chunk_job = std::move(job);
+	if (!chunk_reader.joinable()) {
+		should_stop_reading = false;
+		chunk_reader = std::thread(&CDROM_Interface_Image::ReadChunksAhead,
+		                           this);
+		set_thread_name(chunk_reader, "dosbox:cdread");
+	}
+	lock.unlock();
+	chunk_waiter.notify_all();
+	return true;
+}
+
+// The chunk's sectors, up to the end of the track or its file
+std::optional<CDROM_Interface_Image::ChunkJob> CDROM_Interface_Image::GetChunkJob(
+        const Track& track, const uint32_t first_sector)
+{
+	const auto track_end = track.start + track.length;
+	if (!track.file || track.sectorSize == 0 || first_sector >= track_end) {
+		return {};
+	}
+	ChunkJob job     = {};
+	job.file         = track.file;
+	job.byte_offset  = track.skip +
+	                  (first_sector - track.start) * track.sectorSize;
+	job.first_sector = first_sector;
+	job.sector_size  = track.sectorSize;
+
+	int file_length = 0;
+	{
+		std::lock_guard<std::mutex> lock(player.fileMutex);
+		file_length = track.file->getLength();
+	}
+	if (file_length < 0 || job.byte_offset >= static_cast<uint32_t>(file_length)) {
+		return {};
+	}
+	const auto sectors_in_file = (static_cast<uint32_t>(file_length) -
+	                              job.byte_offset) /
+	                             track.sectorSize;
+	job.num_sectors = std::min(
+	        {ChunkSectors, track_end - first_sector, sectors_in_file});
+	if (job.num_sectors == 0) {
+		return {};
+	}
+	return job;
+}
+
+bool CDROM_Interface_Image::ReadChunk(const ChunkJob& job, SectorChunk& chunk)
+{
+	chunk.data.resize(job.num_sectors * job.sector_size);
+	chunk.first_sector = job.first_sector;
+	chunk.num_sectors  = job.num_sectors;
+	chunk.sector_size  = job.sector_size;
+
+	std::lock_guard<std::mutex> lock(player.fileMutex);
+	return job.file->read(chunk.data.data(),
+	                      job.byte_offset,
+	                      static_cast<uint32_t>(chunk.data.size()));
+}
+
+// The chunk_mutex has to be held for these
+CDROM_Interface_Image::SectorChunk* CDROM_Interface_Image::FindChunk(
+        const uint32_t first_sector)
+{
+	for (auto& chunk : chunks) {
+		if (chunk.first_sector == first_sector) {
+			chunk.last_used = ++chunk_use_count;
+			return &chunk;
+		}
+	}
+	return nullptr;
+}
+
+CDROM_Interface_Image::SectorChunk& CDROM_Interface_Image::InsertChunk(
+        SectorChunk&& chunk)
+{
+	chunk.last_used = ++chunk_use_count;
+
+	auto is_older = [](const SectorChunk& a, const SectorChunk& b) {
+		return a.last_used < b.last_used;
+	};
+	auto same = std::find_if(chunks.begin(), chunks.end(), [&](const auto& c) {
+		return c.first_sector == chunk.first_sector;
+	});
+	if (same != chunks.end()) {
+		*same = std::move(chunk);
+		return *same;
+	}
+	if (chunks.size() < MaxChunks) {
+		return chunks.emplace_back(std::move(chunk));
+	}
+	auto& oldest = *std::min_element(chunks.begin(), chunks.end(), is_older);
+	oldest = std::move(chunk);
+	return oldest;
+}
+
+void CDROM_Interface_Image::ReadChunksAhead()
+{
+	std::unique_lock<std::mutex> lock(chunk_mutex);
+	while (true) {
+		chunk_waiter.wait(lock, [this] {
+			return should_stop_reading || next_chunk_job.has_value();
+		});
+		if (should_stop_reading) {
+			return;
+		}
+		const auto job = std::move(*next_chunk_job);
+		next_chunk_job.reset();
+		reading_chunk = job.first_sector;
+		lock.unlock();
+
+		SectorChunk chunk = {};
+		const auto is_read = ReadChunk(job, chunk);
+
+		lock.lock();
+		if (is_read) {
+			InsertChunk(std::move(chunk));
+		}
+		reading_chunk.reset();
+		chunk_waiter.notify_all();
+	}
+}
+
+void CDROM_Interface_Image::StopChunkReader()
+{
+	{
+		std::lock_guard<std::mutex> lock(chunk_mutex);
+		should_stop_reading = true;
+	}
+	chunk_waiter.notify_all();
+	if (chunk_reader.joinable()) {
+		chunk_reader.join();
+	}
+}
+
+// Drops the chunks along with the one being read ahead, if any
+void CDROM_Interface_Image::ClearChunks()
+{
+	std::unique_lock<std::mutex> lock(chunk_mutex);
+	next_chunk_job.reset();
+	chunk_waiter.wait(lock, [this] { return !reading_chunk.has_value(); });
+	chunks.clear();
+	last_read_sector = {};
+}
+
 bool CDROM_Interface_Image::ReadSectorsHost(void *buffer, bool raw, unsigned long sector, unsigned long num)
 {
 	unsigned int sectorSize = raw ? BYTES_PER_RAW_REDBOOK_FRAME : BYTES_PER_COOKED_REDBOOK_FRAME;
@@ -1021,37 +1315,52 @@ void CDROM_Interface_Image::CDAudioCallBack(uint16_t desired_track_frames)
 		return;
 	}
 
-	const auto decoded_track_frames = check_cast<uint16_t>(
-	        track_file->decode(player.buffer, desired_track_frames));
+	const auto channels = std::max(player.trackChannels, uint8_t{1});
+
+	const auto decoded_track_frames = std::min(
+	        static_cast<size_t>(desired_track_frames),
+	        player.decoded.Size() / channels);
 
-	if (!decoded_track_frames) {
-		// This particular CDDA track has come to an end, but the
-		// program has requested we continue playing for a longer
-		// period. So keep going!
-		const auto fraction_played = static_cast<double>(
-		                                     player.playedTrackFrames) /
-		                             player.totalTrackFrames;
+	if (decoded_track_frames == 0) {
+		const auto state = player.decodeState.load();
+		if (state == DecodeState::Failed) {
+			player.cd->StopAudio();
 
-		const auto played_redbook_frames = static_cast<uint32_t>(
-		        ceil(fraction_played * player.totalRedbookFrames));
+		} else if (state == DecodeState::Finished &&
+		           player.playedTrackFrames < player.totalTrackFrames) {
+			// This particular CDDA track has come to an end, but the
+			// program has requested we continue playing for a longer
+			// period. So keep going!
+			const auto fraction_played = static_cast<double>(
+			                                     player.playedTrackFrames) /
+			                             player.totalTrackFrames;
 
-		const auto new_redbook_start_frame = player.startSector +
-		                                     played_redbook_frames;
+			const auto played_redbook_frames = static_cast<uint32_t>(
+			        ceil(fraction_played * player.totalRedbookFrames));
 
-		const auto remaining_redbook_frames = player.totalRedbookFrames -
-		                                      played_redbook_frames;
+			const auto new_redbook_start_frame = player.startSector +
+			                                     played_redbook_frames;
 
-		player.cd->PlayAudioSector(new_redbook_start_frame,
-		                           remaining_redbook_frames);
+			const auto remaining_redbook_frames = player.totalRedbookFrames -
+			                                      played_redbook_frames;
 
+			player.cd->PlayAudioSector(new_redbook_start_frame,
+			                           remaining_redbook_frames);
+		}
+		// Otherwise the decoder is still seeking or has fallen behind,
+		// so play silence until it catches up
+		player.channel->AddSilence();
 		return;
 	}
 
+	player.decoded.BulkDequeue(player.samples, decoded_track_frames * channels);
+
 	// Use the stereo or mono and native or nonnative AddSamples call
 	// assigned during construction
-	(player.channel.get()->*player.addFrames)(decoded_track_frames, player.buffer);
+	(player.channel.get()->*player.addFrames)(
+	        check_cast<uint16_t>(decoded_track_frames), player.samples.data());
 
-	player.playedTrackFrames += decoded_track_frames;
+	player.playedTrackFrames += check_cast<uint32_t>(decoded_track_frames);
 	if (player.playedTrackFrames >= player.totalTrackFrames) {
 #ifdef DEBUG
 		LOG_MSG("CDROM: CDAudioCallBack stopping because "
@@ -1062,6 +1371,88 @@ void CDROM_Interface_Image::CDAudioCallBack(uint16_t desired_track_frames)
 	}
 }
 
+// Runs the decode-ahead thread, which waits for PlayAudioSector to hand it a
+// track and then keeps the queue topped up until the request is played out,
+// stopped, or replaced by the next one
+void CDROM_Interface_Image::DecodeAhead()
+{
+	std::unique_lock<std::mutex> lock(player.mutex);
+	while (true) {
+		player.waiter.wait(lock, [] {
+			return player.nextJob.has_value() || player.shouldExit;
+		});
+		if (player.shouldExit) {
+			return;
+		}
+
+		const auto job = std::move(*player.nextJob);
+		player.nextJob.reset();
+
+		// Keep around half a second decoded ahead. Restarting the queue
+		// under the lock means a stop that races with us can't be lost.
+		constexpr uint32_t decode_ahead_ms = 500;
+		player.decoded.Resize(std::max(job.rate * job.channels *
+		                                       decode_ahead_ms / 1000,
+		                               1u));
+		player.decoded.Clear();
+		player.decoded.Start();
+		lock.unlock();
+
+		DecodeTrack(job);
+
+		lock.lock();
+	}
+}
+
+void CDROM_Interface_Image::DecodeTrack(const DecodeJob& job)
+{
+	auto set_state = [](const DecodeState state) {
+		std::lock_guard<std::mutex> lock(player.mutex);
+		// Only report on our own request, not a newer one
+		if (!player.nextJob && player.decoded.IsRunning()) {
+			player.decodeState = state;
+		}
+	};
+
+	{
+		std::lock_guard<std::mutex> lock(player.fileMutex);
+		if (!job.file->seek(job.byteOffset)) {
+			LOG_MSG("CDROM: Track failed to seek to byte %u, so cancelling playback",
+			        job.byteOffset);
+			set_state(DecodeState::Failed);
+			return;
+		}
+		// We're performing an audio-task, so update the audio position
+		job.file->setAudioPosition(job.byteOffset);
+	}
+
+	constexpr uint32_t chunk_frames = 1024;
+	std::vector<int16_t> chunk = {};
+
+	uint32_t decoded_frames = 0;
+	while (decoded_frames < job.trackFrames && player.decoded.IsRunning()) {
+		const auto num_frames = std::min(chunk_frames,
+		                                 job.trackFrames - decoded_frames);
+		chunk.resize(num_frames * job.channels);
+
+		std::unique_lock<std::mutex> lock(player.fileMutex);
+		const auto frames = job.file->decode(chunk.data(), num_frames);
+		lock.unlock();
+
+		if (frames == 0) {
+			break;
+		}
+		decoded_frames += frames;
+
+		// Blocks while the queue is full and returns false once we're
+		// stopped
+		if (!player.decoded.BulkEnqueue(chunk, frames * job.channels)) {
+			return;
+		}
+	}
+	set_state(DecodeState::Finished);
+}
+
 bool CDROM_Interface_Image::LoadIsoFile(const char* filename)
 {
 	tracks.clear();
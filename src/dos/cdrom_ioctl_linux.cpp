@@ -35,6 +35,7 @@
 
 CDROM_Interface_Ioctl::~CDROM_Interface_Ioctl()
 {
+	StopIo();
 	if (IsOpen()) {
 		close(cdrom_fd);
 	}
@@ -147,9 +148,9 @@ bool CDROM_Interface_Ioctl::GetAudioTrackInfo(uint8_t track, TMSF& start,
 	return true;
 }
 
-bool CDROM_Interface_Ioctl::GetAudioSub(unsigned char& attr, unsigned char& track,
-                                        unsigned char& index, TMSF& relPos,
-                                        TMSF& absPos)
+bool CDROM_Interface_Ioctl::QueryAudioSub(unsigned char& attr, unsigned char& track,
+                                          unsigned char& index, TMSF& relPos,
+                                          TMSF& absPos)
 {
 	if (!IsOpen()) {
 #ifdef DEBUG_IOCTL
@@ -194,11 +195,8 @@ bool CDROM_Interface_Ioctl::GetAudioSub(unsigned char& attr, unsigned char& trac
 	return true;
 }
 
-// Called from CMscdex::GetDeviceStatus - dos_mscdex.cpp line 821
-// Function doesn't check return value or initialize variables so just set some
-// defaults and never fail.
-bool CDROM_Interface_Ioctl::GetMediaTrayStatus(bool& mediaPresent,
-                                               bool& mediaChanged, bool& trayOpen)
+void CDROM_Interface_Ioctl::QueryMediaTrayStatus(bool& mediaPresent,
+                                                 bool& mediaChanged, bool& trayOpen)
 {
 	mediaPresent = false;
 	mediaChanged = false;
@@ -208,7 +206,7 @@ bool CDROM_Interface_Ioctl::GetMediaTrayStatus(bool& mediaPresent,
 #ifdef DEBUG_IOCTL
 		LOG_WARNING("CDROM_IOCTL: GetMediaTrayStatus: cdrom_fd not open");
 #endif
-		return true;
+		return;
 	}
 
 	switch (ioctl(cdrom_fd, CDROM_DRIVE_STATUS, CDSL_CURRENT)) {
@@ -225,12 +223,10 @@ bool CDROM_Interface_Ioctl::GetMediaTrayStatus(bool& mediaPresent,
 	         mediaChanged ? "was changed" : "hasn't been changed",
 	         trayOpen ? "open" : "closed");
 #endif
-
-	return true;
 }
 
-bool CDROM_Interface_Ioctl::ReadSectors(PhysPt buffer, const bool raw,
-                                        const uint32_t sector, const uint16_t num)
+bool CDROM_Interface_Ioctl::ReadDrive(uint8_t* buffer, const bool raw,
+                                      const uint32_t sector, const uint32_t num)
 {
 	if (!IsOpen()) {
 		return false;
@@ -239,13 +235,12 @@ bool CDROM_Interface_Ioctl::ReadSectors(PhysPt buffer, const bool raw,
 	const auto buflen = raw ? num * (unsigned int)CD_FRAMESIZE_RAW
 	                        : num * (unsigned int)CD_FRAMESIZE;
 	assert(buflen);
-	std::vector<uint8_t> buf(buflen, 0);
 	int ret = 0;
 
 	if (raw) {
 		struct cdrom_read cdrom_read;
 		cdrom_read.cdread_lba = (int)sector;
-		cdrom_read.cdread_bufaddr = reinterpret_cast<char *>(buf.data());
+		cdrom_read.cdread_bufaddr = reinterpret_cast<char *>(buffer);
 		cdrom_read.cdread_buflen = (int)buflen;
 
 		ret = ioctl(cdrom_fd, CDROMREADRAW, &cdrom_read);
@@ -253,13 +248,11 @@ bool CDROM_Interface_Ioctl::ReadSectors(PhysPt buffer, const bool raw,
 		ret = lseek(cdrom_fd, (off_t)(sector * (unsigned long)CD_FRAMESIZE),
 		            SEEK_SET);
 		if (ret >= 0)
-			ret = read(cdrom_fd, buf.data(), buflen);
+			ret = read(cdrom_fd, buffer, buflen);
 		if ((Bitu)ret != buflen)
 			ret = -1;
 	}
 
-	MEM_BlockWrite(buffer, buf.data(), buflen);
-
 	return (ret > 0);
 }
 
@@ -303,6 +296,7 @@ bool CDROM_Interface_Ioctl::SetDevice(const char* path)
 		if (entry->mnt_fsname[0] == '/' && entry->mnt_dir == cannonical_path) {
 			if (Open(entry->mnt_fsname)) {
 				InitAudio();
+				StartIo();
 				endmntent(mounts);
 				return true;
 			}
@@ -313,14 +307,6 @@ bool CDROM_Interface_Ioctl::SetDevice(const char* path)
 	return false;
 }
 
-bool CDROM_Interface_Ioctl::ReadSectorsHost([[maybe_unused]] void *buffer,
-                                            [[maybe_unused]] bool raw,
-                                            [[maybe_unused]] unsigned long sector,
-                                            [[maybe_unused]] unsigned long num)
-{
-	return false; /*TODO*/
-}
-
 bool CDROM_Interface_Ioctl::LoadUnloadMedia(bool unload)
 {
 	if (!IsOpen()) {
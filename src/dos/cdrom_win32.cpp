@@ -35,6 +35,7 @@ bool CDROM_Interface_Win32::IsOpen() const
 
 CDROM_Interface_Win32::~CDROM_Interface_Win32()
 {
+	StopIo();
 	if (IsOpen()) {
 		CloseHandle(cdrom_handle);
 	}
@@ -108,6 +109,7 @@ bool CDROM_Interface_Win32::SetDevice(const char* path)
 		return false;
 	}
 	InitAudio();
+	StartIo();
 	return true;
 }
 
@@ -223,9 +225,9 @@ bool CDROM_Interface_Win32::GetAudioTrackInfo(uint8_t track, TMSF& start,
 	return true;
 }
 
-bool CDROM_Interface_Win32::GetAudioSub(unsigned char& attr, unsigned char& track,
-                                        unsigned char& index, TMSF& relPos,
-                                        TMSF& absPos)
+bool CDROM_Interface_Win32::QueryAudioSub(unsigned char& attr, unsigned char& track,
+                                          unsigned char& index, TMSF& relPos,
+                                          TMSF& absPos)
 {
 	if (!IsOpen()) {
 		return false;
@@ -266,13 +268,12 @@ bool CDROM_Interface_Win32::GetAudioSub(unsigned char& attr, unsigned char& trac
 	return true;
 }
 
-bool CDROM_Interface_Win32::GetMediaTrayStatus(bool& mediaPresent,
-                                               bool& mediaChanged, bool& trayOpen)
+void CDROM_Interface_Win32::QueryMediaTrayStatus(bool& mediaPresent,
+                                                 bool& mediaChanged, bool& trayOpen)
 {
 	mediaPresent = true;
 	mediaChanged = false;
 	trayOpen     = false;
-	return true;
 }
 
 // TODO: Find a test case and implement these.
@@ -280,14 +281,8 @@ bool CDROM_Interface_Win32::GetMediaTrayStatus(bool& mediaPresent,
 // LaserLock currently does not work with CDROM_Interface_Image or
 // CDROM_Interface_Ioctl either which does implement these. I could not find any
 // other game that uses this.
-bool CDROM_Interface_Win32::ReadSectors(PhysPt buffer, const bool raw,
-                                        const uint32_t sector, const uint16_t num)
-{
-	return false;
-}
-
-bool CDROM_Interface_Win32::ReadSectorsHost(void* buffer, bool raw,
-                                            unsigned long sector, unsigned long num)
+bool CDROM_Interface_Win32::ReadDrive(uint8_t* buffer, const bool raw,
+                                      const uint32_t sector, const uint32_t num)
 {
 	return false;
 }
@@ -0,0 +1,439 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "compressed_image.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+#include <zlib.h>
+
+#include "byteorder.h"
+#include "cross.h"
+#include "logging.h"
+#include "mem_unaligned.h"
+#include "support.h"
+
+// The gzip header up to the length of the extra field, which holds the
+// compressed size of the block
+constexpr uint32_t HeaderSize   = 12;
+constexpr uint32_t TrailerSize  = 8;
+constexpr uint32_t MaxBlockSize = 64 * 1024;
+
+// Enough for the blocks of a few files read at the same time, such as the
+// image of a game and the data it streams from it
+constexpr size_t MaxInflatedBlocks = 16;
+constexpr size_t ReadAheadBlocks   = 4;
+
+static bool seek_to(FILE* file, const uint64_t offset)
+{
+	const auto file_offset = static_cast<cross_off_t>(offset);
+	return cross_fseeko(file, file_offset, SEEK_SET) == 0;
+}
+
+// Returns the size of the block starting at the offset, including its
+// header and trailer, or nothing if there's no BGZF block
+static std::optional<uint32_t> read_block_size(FILE* file,
+                                               const uint64_t offset)
+{
+	uint8_t header[HeaderSize];
+	if (!seek_to(file, offset) ||
+	    fread(header, 1, HeaderSize, file) != HeaderSize) {
+		return {};
+	}
+	constexpr uint8_t ExtraFieldFlag = 0x04;
+	if (header[0] != 0x1f || header[1] != 0x8b || header[2] != 8 ||
+	    !(header[3] & ExtraFieldFlag)) {
+		return {};
+	}
+	const auto extra_size = le16_to_host(
+	        read_unaligned_uint16(header + 10));
+	std::vector<uint8_t> extra(extra_size);
+	if (fread(extra.data(), 1, extra.size(), file) != extra.size()) {
+		return {};
+	}
+
+	// The subfield with the size is tagged 'BC'
+	for (size_t pos = 0; pos + 4 <= extra.size();) {
+		const auto field_size = le16_to_host(
+		        read_unaligned_uint16(extra.data() + pos + 2));
+		if (extra[pos] == 'B' && extra[pos + 1] == 'C' &&
+		    field_size == 2 && pos + 6 <= extra.size()) {
+			const auto block_size = le16_to_host(
+			        read_unaligned_uint16(extra.data() + pos + 4));
+			return static_cast<uint32_t>(block_size) + 1;
+		}
+		pos += 4 + field_size;
+	}
+	return {};
+}
+
+bool CompressedImage::IsCompressed(FILE* file)
+{
+	const auto pos = cross_ftello(file);
+	if (pos < 0) {
+		return false;
+	}
+	const auto is_compressed = read_block_size(file, 0).has_value();
+	cross_fseeko(file, pos, SEEK_SET);
+	return is_compressed;
+}
+
+bool CompressedImage::IsCompressed(const std_fs::path& path)
+{
+	FILE* file = fopen(path.string().c_str(), "rb");
+	if (!file) {
+		return false;
+	}
+	const auto is_compressed = read_block_size(file, 0).has_value();
+	fclose(file);
+	return is_compressed;
+}
+
+std::optional<uint64_t> CompressedImage::ReadImageSize(FILE* file)
+{
+	const auto pos = cross_ftello(file);
+	if (pos < 0) {
+		return {};
+	}
+	std::vector<Block> blocks = {};
+	const auto is_read        = ReadIndex(file, blocks);
+	cross_fseeko(file, pos, SEEK_SET);
+	if (!is_read) {
+		return {};
+	}
+	if (blocks.empty()) {
+		return 0;
+	}
+	return blocks.back().image_offset + blocks.back().size;
+}
+
+// Walks the headers of the blocks, skipping the empty ones such as the one
+// marking the end of the file
+bool CompressedImage::ReadIndex(FILE* file, std::vector<Block>& blocks)
+{
+	const auto file_size = stdio_size_bytes(file);
+	if (file_size <= 0) {
+		return false;
+	}
+	uint64_t file_offset  = 0;
+	uint64_t image_offset = 0;
+	const auto file_end   = static_cast<uint64_t>(file_size);
+	while (file_offset < file_end) {
+		const auto block_size = read_block_size(file, file_offset);
+		if (!block_size || *block_size < HeaderSize + TrailerSize ||
+		    file_offset + *block_size > file_end) {
+			return false;
+		}
+		uint8_t inflated_size[4];
+		if (!seek_to(file, file_offset + *block_size - 4) ||
+		    fread(inflated_size, 1, 4, file) != 4) {
+			return false;
+		}
+		const auto size = le32_to_host(
+		        read_unaligned_uint32(inflated_size));
+		if (size > MaxBlockSize) {
+			return false;
+		}
+		if (size > 0) {
+			blocks.push_back(
+			        {file_offset, image_offset, *block_size, size});
+		}
+		file_offset += *block_size;
+		image_offset += size;
+	}
+	return true;
+}
+
+std::unique_ptr<CompressedImage> CompressedImage::Open(const std_fs::path& path)
+{
+	const auto name = path.string();
+
+	FILE* file = fopen(name.c_str(), "rb");
+	if (!file) {
+		LOG_ERR("IMAGE: Could not open '%s': %s",
+		        name.c_str(),
+		        strerror(errno));
+		return {};
+	}
+	std::vector<Block> blocks = {};
+	if (!IsCompressed(file) || !ReadIndex(file, blocks)) {
+		LOG_ERR("IMAGE: '%s' is not a BGZF image or is damaged",
+		        name.c_str());
+		fclose(file);
+		return {};
+	}
+	return std::unique_ptr<CompressedImage>(
+	        new CompressedImage(path, file, std::move(blocks)));
+}
+
+CompressedImage::CompressedImage(const std_fs::path& _path, FILE* _file,
+                                 std::vector<Block>&& _blocks)
+        : path(_path),
+          file(_file),
+          blocks(std::move(_blocks))
+{
+	assert(file);
+	if (!blocks.empty()) {
+		size = blocks.back().image_offset + blocks.back().size;
+	}
+}
+
+CompressedImage::~CompressedImage()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		should_stop = true;
+	}
+	waiter.notify_all();
+	if (worker.joinable()) {
+		worker.join();
+	}
+	fclose(file);
+}
+
+// The index of the block holding the byte, which has to be in the image
+size_t CompressedImage::FindBlock(const uint64_t offset) const
+{
+	assert(offset < size);
+	auto is_before = [](const uint64_t offset, const Block& block) {
+		return offset < block.image_offset;
+	};
+	const auto it = std::upper_bound(blocks.begin(),
+	                                 blocks.end(),
+	                                 offset,
+	                                 is_before);
+	return static_cast<size_t>(it - blocks.begin()) - 1;
+}
+
+bool CompressedImage::InflateBlock(const size_t index,
+                                   std::vector<uint8_t>& data)
+{
+	const auto& block = blocks[index];
+
+	std::vector<uint8_t> compressed(block.compressed_size);
+	{
+		std::lock_guard<std::mutex> lock(file_mutex);
+		if (!seek_to(file, block.file_offset) ||
+		    fread(compressed.data(), 1, compressed.size(), file) !=
+		            compressed.size()) {
+			return false;
+		}
+	}
+	const auto extra_size = le16_to_host(
+	        read_unaligned_uint16(compressed.data() + 10));
+	const auto data_start = HeaderSize + extra_size;
+	if (data_start + TrailerSize > compressed.size()) {
+		return false;
+	}
+	data.resize(block.size);
+
+	z_stream stream  = {};
+	stream.next_in   = compressed.data() + data_start;
+	stream.avail_in  = static_cast<uInt>(compressed.size() - data_start -
+	                                     TrailerSize);
+	stream.next_out  = data.data();
+	stream.avail_out = static_cast<uInt>(data.size());
+
+	// Raw deflate data, the gzip header and trailer are handled here
+	if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+		return false;
+	}
+	const auto result = inflate(&stream, Z_FINISH);
+	inflateEnd(&stream);
+	if (result != Z_STREAM_END || stream.avail_out != 0) {
+		return false;
+	}
+	const auto expected_crc = le32_to_host(read_unaligned_uint32(
+	        compressed.data() + compressed.size() - TrailerSize));
+	const auto crc = crc32(0, data.data(), static_cast<uInt>(data.size()));
+	return crc == expected_crc;
+}
+
+std::optional<size_t> CompressedImage::Read(const uint64_t offset,
+                                            const size_t num_bytes,
+                                            uint8_t* data)
+{
+	if (offset >= size) {
+		return 0;
+	}
+	const auto end = std::min(offset + num_bytes, size);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	for (auto pos = offset; pos < end;) {
+		const auto index = FindBlock(pos);
+
+		const auto is_sequential = last_read_block &&
+		                           (index == *last_read_block ||
+		                            index == *last_read_block + 1);
+		last_read_block = index;
+
+		const auto block = GetBlock(lock, index);
+		if (!block) {
+			LOG_ERR("IMAGE: Could not read block %zu of '%s'",
+			        index,
+			        path.string().c_str());
+			return {};
+		}
+		const auto block_offset = pos - blocks[index].image_offset;
+		const auto bytes = std::min(end - pos,
+		                            blocks[index].size - block_offset);
+		memcpy(data + (pos - offset),
+		       block->data.data() + block_offset,
+		       bytes);
+		pos += bytes;
+
+		if (is_sequential) {
+			for (size_t i = 1; i <= ReadAheadBlocks; ++i) {
+				QueueReadAhead(index + i);
+			}
+		}
+	}
+	return static_cast<size_t>(end - offset);
+}
+
+// Returns the inflated block, inflating it first if needed. The mutex has
+// to be held, and the block stays valid only as long as it is.
+const CompressedImage::InflatedBlock* CompressedImage::GetBlock(
+        std::unique_lock<std::mutex>& lock, const size_t index)
+{
+	// The worker might be inflating this block already
+	waiter.wait(lock, [&] { return inflating_block != index; });
+
+	if (const auto block = FindInflated(index); block) {
+		return block;
+	}
+	lock.unlock();
+	InflatedBlock block = {};
+	block.index         = index;
+	const auto is_inflated = InflateBlock(index, block.data);
+	lock.lock();
+	if (!is_inflated) {
+		return nullptr;
+	}
+	return &InsertInflated(std::move(block));
+}
+
+// The mutex has to be held for these
+CompressedImage::InflatedBlock* CompressedImage::FindInflated(
+        const size_t index)
+{
+	for (auto& block : inflated) {
+		if (block.index == index) {
+			block.last_used = ++use_count;
+			return &block;
+		}
+	}
+	return nullptr;
+}
+
+CompressedImage::InflatedBlock& CompressedImage::InsertInflated(
+        InflatedBlock&& block)
+{
+	block.last_used = ++use_count;
+
+	auto is_same = [&](const InflatedBlock& b) {
+		return b.index == block.index;
+	};
+	auto same = std::find_if(inflated.begin(), inflated.end(), is_same);
+	if (same != inflated.end()) {
+		*same = std::move(block);
+		return *same;
+	}
+	if (inflated.size() < MaxInflatedBlocks) {
+		return inflated.emplace_back(std::move(block));
+	}
+	auto is_older = [](const InflatedBlock& a, const InflatedBlock& b) {
+		return a.last_used < b.last_used;
+	};
+	auto& oldest = *std::min_element(inflated.begin(),
+	                                 inflated.end(),
+	                                 is_older);
+	oldest = std::move(block);
+	return oldest;
+}
+
+void CompressedImage::QueueReadAhead(const size_t index)
+{
+	if (index >= blocks.size() || inflating_block == index ||
+	    std::find(queued_blocks.begin(), queued_blocks.end(), index) !=
+	            queued_blocks.end()) {
+		return;
+	}
+	auto is_same = [&](const InflatedBlock& block) {
+		return block.index == index;
+	};
+	if (std::any_of(inflated.begin(), inflated.end(), is_same)) {
+		return;
+	}
+	queued_blocks.push_back(index);
+	if (queued_blocks.size() > ReadAheadBlocks) {
+		queued_blocks.pop_front();
+	}
+	if (!worker.joinable()) {
+		worker = std::thread(&CompressedImage::InflateAhead, this);
+		set_thread_name(worker, "dosbox:inflate");
+	}
+	waiter.notify_all();
+}
+
+void CompressedImage::InflateAhead()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		waiter.wait(lock, [this] {
+			return should_stop || !queued_blocks.empty();
+		});
+		if (should_stop) {
+			return;
+		}
+		InflatedBlock block = {};
+		block.index         = queued_blocks.front();
+		queued_blocks.pop_front();
+		inflating_block = block.index;
+		lock.unlock();
+
+		const auto is_inflated = InflateBlock(block.index, block.data);
+
+		lock.lock();
+		if (is_inflated) {
+			InsertInflated(std::move(block));
+		}
+		inflating_block.reset();
+		waiter.notify_all();
+	}
+}
+
+int64_t image_file_size_bytes(FILE* file)
+{
+	if (CompressedImage::IsCompressed(file)) {
+		const auto size = CompressedImage::ReadImageSize(file);
+		return size ? static_cast<int64_t>(*size) : -1;
+	}
+	return stdio_size_bytes(file);
+}
+
+int64_t image_file_size_kb(FILE* file)
+{
+	const auto size = image_file_size_bytes(file);
+	return size < 0 ? size : size / 1024;
+}
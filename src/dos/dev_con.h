@@ -50,6 +50,7 @@ public:
 private:
 	void ClearAnsi();
 	void Output(uint8_t chr);
+	uint16_t OutputRun(const uint8_t* chars, uint16_t num_chars);
 
 	uint8_t readcache = 0;
 	struct ansi {
@@ -165,6 +166,18 @@ bool device_CON::Write(uint8_t * data,uint16_t * size) {
 				count++;
 				continue;
 			} else {
+				// Runs of printable characters go out in one go
+				uint16_t num_plain = 0;
+				while (count + num_plain < *size &&
+				       data[count + num_plain] >= ' ') {
+					++num_plain;
+				}
+				const auto num_written = OutputRun(&data[count],
+				                                   num_plain);
+				if (num_written) {
+					count += num_written;
+					continue;
+				}
 				Output(data[count]);
 				count++;
 				continue;
@@ -436,6 +449,21 @@ uint16_t device_CON::GetInformation(void) {
 	return 0x80D3; /* No Key Available */
 }
 
+// The teletype output in one go of what Output() would write character by
+// character, if the video BIOS can take it
+uint16_t device_CON::OutputRun(const uint8_t* chars, const uint16_t num_chars)
+{
+	if (dos.internal_output || ansi.enabled) {
+		constexpr auto use_attribute = true;
+		return INT10_TeletypeOutputRun(chars,
+		                               num_chars,
+		                               ansi.attr,
+		                               use_attribute);
+	}
+	constexpr auto use_attribute = false;
+	return INT10_TeletypeOutputRun(chars, num_chars, 7, use_attribute);
+}
+
 void device_CON::Output(uint8_t chr) {
 	if (dos.internal_output || ansi.enabled) {
 		if (CurMode->type==M_TEXT) {
@@ -29,6 +29,7 @@
 #include "callback.h"
 #include "dos_locale.h"
 #include "drives.h"
+#include "event_counters.h"
 #include "mem.h"
 #include "program_mount_common.h"
 #include "regs.h"
@@ -156,8 +157,11 @@ static inline void overhead() {
 }
 #endif
 
+static EventCounter dos_calls("DOS calls", 256, "AH=%02zXh");
+
 #define DOSNAMEBUF 256
 static Bitu DOS_21Handler(void) {
+	dos_calls.Add(reg_ah);
 	if (((reg_ah != 0x50) && (reg_ah != 0x51) && (reg_ah != 0x62) && (reg_ah != 0x64)) && (reg_ah<0x6c)) {
 		DOS_PSP psp(dos.psp());
 		psp.SetStack(RealMake(SegValue(ss),reg_sp-18));
@@ -754,8 +758,7 @@ static Bitu DOS_21Handler(void) {
 		{ 
 			uint16_t toread=DOS_GetAmount();
 			dos.echo=true;
-			if (DOS_ReadFile(reg_bx,dos_copybuf,&toread)) {
-				MEM_BlockWrite(SegPhys(ds)+reg_dx,dos_copybuf,toread);
+			if (DOS_ReadFileToGuest(reg_bx, SegPhys(ds) + reg_dx, &toread)) {
 				reg_ax=toread;
 				CALLBACK_SCF(false);
 			} else {
@@ -1312,6 +1315,12 @@ static Bitu DOS_27Handler(void) {
 	return CBRET_NONE;
 }
 
+static Bitu DOS_28Handler(void) {
+	// DOS idle interrupt, called in a loop while waiting for something
+	CPU_IdlePoll(IdleSource::DosIdle, false);
+	return CBRET_NONE;
+}
+
 static uint16_t DOS_SectorAccess(const bool read)
 {
 	const auto drive = dynamic_cast<fatDrive*>(Drives.at(reg_al));
@@ -1481,7 +1490,7 @@ public:
 		callback[4].Install(DOS_27Handler,CB_IRET,"DOS Int 27");
 		callback[4].Set_RealVec(0x27);
 
-		callback[5].Install(nullptr,CB_IRET,"DOS Int 28");
+		callback[5].Install(DOS_28Handler,CB_IRET,"DOS Int 28");
 		callback[5].Set_RealVec(0x28);
 
 		callback[6].Install(nullptr,CB_INT29,"CON Output Int 29");
@@ -1509,6 +1518,9 @@ public:
 		dos.internal_output=false;
 
 		const Section_prop* section = static_cast<Section_prop*>(configuration);
+		DOS_SetFileWriteBuffer(
+		        static_cast<size_t>(section->Get_int("file_write_buffer")) * 1024);
+
 		std::string args = section->Get_string("ver");
 		std::string word = strip_word(args);
 		const auto new_version = DOS_ParseVersion(word.c_str(), args.c_str());
@@ -1526,6 +1538,8 @@ public:
 		// without throwing an inevitable `DOS: Too many devices added`
 		// exception
 		DOS_ShutDownDevices();
+
+		DOS_ShutDownFiles();
 	}
 };
 
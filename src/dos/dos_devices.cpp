@@ -378,6 +378,15 @@ DOS_File &DOS_File::operator=(const DOS_File &orig)
 	return *this;
 }
 
+bool DOS_File::ReadToGuest(const PhysPt dest, uint16_t* size)
+{
+	if (!Read(dos_copybuf, size)) {
+		return false;
+	}
+	MEM_BlockWrite(dest, dos_copybuf, *size);
+	return true;
+}
+
 uint8_t DOS_FindDevice(const char* name)
 {
 	/* should only check for the names before the dot and spacepadded */
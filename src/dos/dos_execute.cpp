@@ -19,13 +19,17 @@
 
 #include "dosbox.h"
 
+#include <algorithm>
 #include <cctype>
 #include <cstring>
+#include <list>
+#include <vector>
 
 #include "callback.h"
 #include "cpu.h"
 #include "debug.h"
 #include "dos_inc.h"
+#include "guest_profiler.h"
 #include "mem.h"
 #include "paging.h"
 #include "program_setver.h"
@@ -119,6 +123,99 @@ void DOS_ClearLaunchedProgramNames()
 	psp_to_canonical_map.clear();
 }
 
+// ***************************************************************************
+// Executable load cache
+// ***************************************************************************
+
+// Batch files and menu systems keep launching the same programs, so the
+// headers and relocation tables of the last few EXEs are kept. Entries are
+// matched on the canonical path together with the file's size and
+// timestamp, so a rebuilt or replaced program is read afresh.
+
+struct ExeCacheEntry {
+	std::string path  = {};
+	uint32_t size     = 0;
+	uint16_t time     = 0;
+	uint16_t date     = 0;
+	EXE_Header header = {}; // as stored in the file (little endian)
+	std::vector<RealPt> relocations = {};
+};
+
+static std::list<ExeCacheEntry> exe_cache = {};
+constexpr size_t ExeCacheMaxEntries = 16;
+
+// Moves the entry up front, so the oldest one is dropped first
+static const ExeCacheEntry* find_cached_exe(const ExeCacheEntry& key)
+{
+	for (auto it = exe_cache.begin(); it != exe_cache.end(); ++it) {
+		if (it->path == key.path && it->size == key.size &&
+		    it->time == key.time && it->date == key.date) {
+			exe_cache.splice(exe_cache.begin(), exe_cache, it);
+			return &exe_cache.front();
+		}
+	}
+	return nullptr;
+}
+
+static void add_cached_exe(ExeCacheEntry&& entry)
+{
+	exe_cache.push_front(std::move(entry));
+	if (exe_cache.size() > ExeCacheMaxEntries) {
+		exe_cache.pop_back();
+	}
+}
+
+// The key of the opened file, an empty path if it can't be cached
+static ExeCacheEntry get_exe_cache_key(const char* name, const uint16_t fhandle)
+{
+	ExeCacheEntry key = {};
+
+	uint32_t pos = 0;
+	if (!DOS_SeekFile(fhandle, &pos, DOS_SEEK_END)) {
+		return key;
+	}
+	key.size = pos;
+	pos      = 0;
+	if (!DOS_SeekFile(fhandle, &pos, DOS_SEEK_SET) ||
+	    !DOS_GetFileDate(fhandle, &key.time, &key.date)) {
+		return key;
+	}
+	key.path = DOS_Canonicalize(name);
+	return key;
+}
+
+// Reads the whole relocation table with as few reads as possible
+static bool read_relocations(const uint16_t fhandle,
+                             const uint16_t num_relocations,
+                             std::vector<RealPt>& relocations)
+{
+	constexpr size_t EntriesPerRead = 0x3fff;
+
+	relocations.resize(num_relocations);
+	auto data       = reinterpret_cast<uint8_t*>(relocations.data());
+	size_t num_read = 0;
+	while (num_read < num_relocations) {
+		const auto entries = std::min(num_relocations - num_read,
+		                              EntriesPerRead);
+		const auto wanted = static_cast<uint16_t>(entries * sizeof(RealPt));
+		auto readsize     = wanted;
+		if (!DOS_ReadFile(fhandle, data, &readsize)) {
+			readsize = 0;
+		}
+		num_read += readsize / sizeof(RealPt);
+		if (readsize < wanted) {
+			break;
+		}
+		data += readsize;
+	}
+	relocations.resize(num_read);
+	for (auto& relocpt : relocations) {
+		// Endianize
+		relocpt = host_readd(reinterpret_cast<HostPt>(&relocpt));
+	}
+	return num_read == num_relocations;
+}
+
 // ***************************************************************************
 // Program execute/terminate support
 // ***************************************************************************
@@ -285,7 +382,7 @@ bool DOS_Execute(char * name,PhysPt block_pt,uint8_t flags) {
 	EXE_Header head;Bitu i;
 	uint16_t fhandle;uint16_t len;uint32_t pos;
 	uint16_t pspseg,envseg,loadseg,memsize,readsize;
-	PhysPt loadaddress;RealPt relocpt;
+	PhysPt loadaddress;
 	Bitu headersize=0,imagesize=0;
 	DOS_ParamBlock block(block_pt);
 
@@ -304,11 +401,18 @@ bool DOS_Execute(char * name,PhysPt block_pt,uint8_t flags) {
 		DOS_SetError(DOSERR_FILE_NOT_FOUND);
 		return false;
 	}
+	auto exe_key = get_exe_cache_key(name, fhandle);
+	const ExeCacheEntry* cached_exe = exe_key.path.empty()
+	                                        ? nullptr
+	                                        : find_cached_exe(exe_key);
 	len=sizeof(EXE_Header);
-	if (!DOS_ReadFile(fhandle,(uint8_t *)&head,&len)) {
+	if (cached_exe) {
+		head = cached_exe->header;
+	} else if (!DOS_ReadFile(fhandle,(uint8_t *)&head,&len)) {
 		DOS_CloseFile(fhandle);
 		return false;
 	}
+	exe_key.header = head;
 	if (len<sizeof(EXE_Header)) {
 		if (len==0) {
 			/* Prevent executing zero byte files */
@@ -396,32 +500,48 @@ bool DOS_Execute(char * name,PhysPt block_pt,uint8_t flags) {
 	/* Load the executable */
 	loadaddress=PhysicalMake(loadseg,0);
 
+	// COM programs are linked to run from their PSP's segment
+	if (iscom) {
+		const auto seg = flags == OVERLAY ? loadseg : pspseg;
+		PROFILER_AddProgram(name, seg, 0x10000);
+	} else {
+		PROFILER_AddProgram(name,
+		                    loadseg,
+		                    static_cast<uint32_t>(imagesize));
+	}
+
 	if (iscom) {	/* COM Load 64k - 256 bytes max */
 		pos=0;DOS_SeekFile(fhandle,&pos,DOS_SEEK_SET);	
 		readsize=0xffff-256;
-		DOS_ReadFile(fhandle,loadbuf,&readsize);
-		MEM_BlockWrite(loadaddress,loadbuf,readsize);
+		DOS_ReadFileToGuest(fhandle, loadaddress, &readsize);
 	} else {	/* EXE Load in 32kb blocks and then relocate */
 		pos=headersize;DOS_SeekFile(fhandle,&pos,DOS_SEEK_SET);	
 		while (imagesize>0x7FFF) {
-			readsize=0x8000;DOS_ReadFile(fhandle,loadbuf,&readsize);
-			MEM_BlockWrite(loadaddress,loadbuf,readsize);
+			readsize=0x8000;DOS_ReadFileToGuest(fhandle, loadaddress, &readsize);
 //			if (readsize!=0x8000) LOG(LOG_EXEC,LOG_NORMAL)("Illegal header");
 			loadaddress+=0x8000;imagesize-=0x8000;
 		}
 		if (imagesize>0) {
-			readsize=(uint16_t)imagesize;DOS_ReadFile(fhandle,loadbuf,&readsize);
-			MEM_BlockWrite(loadaddress,loadbuf,readsize);
+			readsize=(uint16_t)imagesize;DOS_ReadFileToGuest(fhandle, loadaddress, &readsize);
 //			if (readsize!=imagesize) LOG(LOG_EXEC,LOG_NORMAL)("Illegal header");
 		}
 		/* Relocate the exe image */
 		uint16_t relocate;
 		if (flags==OVERLAY) relocate=block.overlay.relocation;
 		else relocate=loadseg;
-		pos=head.reloctable;DOS_SeekFile(fhandle,&pos,0);
-		for (i=0;i<head.relocations;i++) {
-			readsize=4;DOS_ReadFile(fhandle,(uint8_t *)&relocpt,&readsize);
-			relocpt=host_readd((HostPt)&relocpt);		//Endianize
+		if (!cached_exe) {
+			pos=head.reloctable;DOS_SeekFile(fhandle,&pos,0);
+			if (!read_relocations(fhandle, head.relocations,
+			                      exe_key.relocations)) {
+				LOG(LOG_EXEC,LOG_NORMAL)("Short relocation table");
+			} else if (!exe_key.path.empty()) {
+				add_cached_exe(std::move(exe_key));
+				cached_exe = &exe_cache.front();
+			}
+		}
+		const auto& relocations = cached_exe ? cached_exe->relocations
+		                                     : exe_key.relocations;
+		for (const auto relocpt : relocations) {
 			PhysPt address=PhysicalMake(RealSegment(relocpt)+loadseg,RealOffset(relocpt));
 			mem_writew(address,mem_readw(address)+relocate);
 		}
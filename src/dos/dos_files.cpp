@@ -34,6 +34,8 @@
 #include "cross.h"
 #include "string_utils.h"
 #include "support.h"
+#include "timer.h"
+#include "tracy.h"
 
 #define DOS_FILESTART 4
 
@@ -278,8 +280,22 @@ bool DOS_ChangeDir(const char* const dir)
 	return exists_and_set;
 }
 
+static uint32_t file_system_changes = 0;
+
+void DOS_NoteFileSystemChange()
+{
+	++file_system_changes;
+}
+
+uint32_t DOS_GetFileSystemChanges()
+{
+	return file_system_changes;
+}
+
 bool DOS_MakeDir(const char* const dir)
 {
+	DOS_NoteFileSystemChange();
+
 	uint8_t drive;char fulldir[DOS_PATHLENGTH];
 	size_t len = strlen(dir);
 	if(!len || dir[len-1] == '\\') {
@@ -301,6 +317,7 @@ bool DOS_MakeDir(const char* const dir)
 
 bool DOS_RemoveDir(const char* const dir)
 {
+	DOS_NoteFileSystemChange();
 	/* We need to do the test before the removal as can not rely on
 	 * the host to forbid removal of the current directory.
 	 * We never change directory. Everything happens in the drives.
@@ -349,6 +366,7 @@ static bool PathExists(const char* const name)
 
 bool DOS_Rename(const char* const oldname, const char* const newname)
 {
+	DOS_NoteFileSystemChange();
 	uint8_t driveold;char fullold[DOS_PATHLENGTH];
 	uint8_t drivenew;char fullnew[DOS_PATHLENGTH];
 	if (!DOS_MakeName(oldname,fullold,&driveold)) return false;
@@ -452,6 +470,7 @@ bool DOS_FindNext(void) {
 
 
 bool DOS_ReadFile(uint16_t entry,uint8_t * data,uint16_t * amount,bool fcb) {
+	ZoneScoped;
 	uint32_t handle = fcb?entry:RealHandle(entry);
 	if (handle>=DOS_FILES) {
 		DOS_SetError(DOSERR_INVALID_HANDLE);
@@ -473,6 +492,25 @@ bool DOS_ReadFile(uint16_t entry,uint8_t * data,uint16_t * amount,bool fcb) {
 	return ret;
 }
 
+// Reads straight into guest memory, which lets host drives skip copying the
+// bytes through dos_copybuf
+bool DOS_ReadFileToGuest(const uint16_t entry, const PhysPt dest, uint16_t* amount)
+{
+	const auto handle = RealHandle(entry);
+	if (handle >= DOS_FILES) {
+		DOS_SetError(DOSERR_INVALID_HANDLE);
+		return false;
+	}
+	if (!Files[handle] || !Files[handle]->IsOpen()) {
+		DOS_SetError(DOSERR_INVALID_HANDLE);
+		return false;
+	}
+	uint16_t toread = *amount;
+	const auto ret  = Files[handle]->ReadToGuest(dest, &toread);
+	*amount         = toread;
+	return ret;
+}
+
 bool DOS_WriteFile(uint16_t entry,uint8_t * data,uint16_t * amount,bool fcb) {
 	uint32_t handle = fcb?entry:RealHandle(entry);
 	if (handle>=DOS_FILES) {
@@ -545,13 +583,14 @@ bool DOS_FlushFile(uint16_t entry) {
 		DOS_SetError(DOSERR_INVALID_HANDLE);
 		return false;
 	};
-	LOG(LOG_DOSMISC,LOG_NORMAL)("FFlush used.");
+	Files[handle]->Flush();
 	return true;
 }
 
 bool DOS_CreateFile(const char* name, FatAttributeFlags attributes,
                     uint16_t* entry, bool fcb)
 {
+	DOS_NoteFileSystemChange();
 	// Creation of a device is the same as opening it
 	// Tc201 installer
 	if (DOS_FindDevice(name) != DOS_DEVICES)
@@ -734,6 +773,7 @@ bool DOS_OpenFileExtended(const char* name, uint16_t flags,
 
 bool DOS_UnlinkFile(const char* const name)
 {
+	DOS_NoteFileSystemChange();
 	char fullname[DOS_PATHLENGTH];
 	uint8_t drive;
 
@@ -1568,6 +1608,24 @@ bool DOS_SetFileDate(uint16_t entry, uint16_t ntime, uint16_t ndate)
 	return true;
 }
 
+// Programs that keep a file open and write to it a few bytes at a time get
+// their writes buffered, so they're handed to the host once a second
+static void flush_files_timer()
+{
+	constexpr int FlushIntervalMs = 1000;
+
+	static int ticks = 0;
+	if (++ticks < FlushIntervalMs) {
+		return;
+	}
+	ticks = 0;
+	for (auto* file : Files) {
+		if (file && file->IsOpen()) {
+			file->Flush();
+		}
+	}
+}
+
 void DOS_SetupFiles()
 {
 	/* Setup the File Handles */
@@ -1581,4 +1639,11 @@ void DOS_SetupFiles()
 
 	Drives.at(z_drive_index) = DriveManager::RegisterFilesystemImage(
 	        z_drive_index, std::make_unique<Virtual_Drive>());
+
+	TIMER_AddTickHandler(flush_files_timer);
+}
+
+void DOS_ShutDownFiles()
+{
+	TIMER_DelTickHandler(flush_files_timer);
 }
@@ -22,6 +22,7 @@
 #include <list>
 
 #include "callback.h"
+#include "cpu.h"
 #include "mem.h"
 #include "regs.h"
 
@@ -205,8 +206,10 @@ static bool DOS_MultiplexFunctions(void) {
 		else if (reg_bx == 0x18) return true;	// idle callout
 		else return false;
 	case 0x1680:	/*  RELEASE CURRENT VIRTUAL MACHINE TIME-SLICE */
-		//TODO Maybe do some idling but could screw up other systems :)
-		return true; //So no warning in the debugger anymore
+		// AL=00h tells the caller the call is supported
+		reg_al = 0;
+		CPU_Idle(IdleSource::ReleaseTimeSlice);
+		return true;
 	case 0x1689:	/*  Kernel IDLE CALL */
 	case 0x168f:	/*  Close awareness crap */
 	   /* Removing warning */
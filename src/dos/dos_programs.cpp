@@ -39,10 +39,13 @@
 #include "program_mount.h"
 #include "program_mousectl.h"
 #include "program_move.h"
+#include "program_netstat.h"
 #include "program_placeholder.h"
+#include "program_profile.h"
 #include "program_rescan.h"
 #include "program_serial.h"
 #include "program_setver.h"
+#include "program_stats.h"
 #include "program_subst.h"
 #include "program_tree.h"
 
@@ -94,9 +97,12 @@ void Add_VFiles(const bool add_autoexec)
 	PROGRAMS_MakeFile("MOUNT.COM", ProgramCreate<MOUNT>);
 	PROGRAMS_MakeFile("MOUSECTL.COM", ProgramCreate<MOUSECTL>);
 	PROGRAMS_MakeFile("MOVE.EXE", ProgramCreate<MOVE>);
+	PROGRAMS_MakeFile("NETSTAT.COM", ProgramCreate<NETSTAT>);
+	PROGRAMS_MakeFile("PROFILE.COM", ProgramCreate<PROFILE>);
 	PROGRAMS_MakeFile("RESCAN.COM", ProgramCreate<RESCAN>);
 	PROGRAMS_MakeFile("SERIAL.COM", ProgramCreate<SERIAL>);
 	PROGRAMS_MakeFile("SETVER.EXE", ProgramCreate<SETVER>);
+	PROGRAMS_MakeFile("STATS.COM", ProgramCreate<STATS>);
 	PROGRAMS_MakeFile("SUBST.EXE", ProgramCreate<SUBST>);
 	PROGRAMS_MakeFile("TREE.COM", ProgramCreate<TREE>);
 
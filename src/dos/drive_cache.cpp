@@ -26,8 +26,10 @@
 #include "cross.h"
 #include "dos_inc.h"
 #include "drives.h"
+#include "host_dir_prefetcher.h"
 #include "string_utils.h"
 #include "support.h"
+#include "timer.h"
 
 int fileInfoCounter = 0;
 
@@ -59,6 +61,37 @@ bool SortByDirNameRev(DOS_Drive_Cache::CFileInfo* const a,
 	return strcmp(a->shortname,b->shortname)>0;
 }
 
+// Finds where an entry goes to keep a list sorted by short name, after any
+// entries with the same name
+static std::vector<DOS_Drive_Cache::CFileInfo*>::iterator find_sorted_position(
+        std::vector<DOS_Drive_Cache::CFileInfo*>& list,
+        DOS_Drive_Cache::CFileInfo* const info)
+{
+	return std::upper_bound(list.begin(), list.end(), info, SortByName);
+}
+
+// Host file systems tell the entries apart by their exact names
+static Bits find_host_entry(const DOS_Drive_Cache::CFileInfo* dir,
+                            const std::string& name)
+{
+	const auto& list = dir->fileList;
+	for (size_t i = 0; i < list.size(); ++i) {
+		if (name == list[i]->orgname) {
+			return static_cast<Bits>(i);
+		}
+	}
+	return -1;
+}
+
+static std::string long_name_key(const char* name)
+{
+	std::string key = name;
+#if defined(WIN32)
+	upcase(key);
+#endif
+	return key;
+}
+
 DOS_Drive_Cache::DOS_Drive_Cache(void)
 	: dirBase(new CFileInfo),
 	  dirPath{0},
@@ -111,14 +144,178 @@ void DOS_Drive_Cache::Clear(void) {
 }
 
 void DOS_Drive_Cache::EmptyCache(void) {
+	DOS_NoteFileSystemChange();
 	// Empty Cache and reinit
 	Clear();
 	dirBase		= new CFileInfo;
 	save_dir	= nullptr;
 	srchNr		= 0;
+	if (prefetcher) {
+		prefetcher->DropListings();
+	}
 	if (basePath[0] != 0) SetBaseDir(basePath);
 }
 
+void DOS_Drive_Cache::StartPrefetching()
+{
+	if (is_empty(basePath) || prefetcher) {
+		return;
+	}
+	prefetcher = HostDirPrefetcher::Start(basePath);
+}
+
+// Brings the cached directories in line with the changes made on the host
+void DOS_Drive_Cache::ApplyHostChanges()
+{
+	if (!prefetcher || !prefetcher->HasChanges() || is_applying_host_changes) {
+		return;
+	}
+	// Caching in a directory below looks up its path again
+	is_applying_host_changes = true;
+
+	DOS_NoteFileSystemChange();
+
+	using ChangeType = HostDirPrefetcher::ChangeType;
+	for (const auto& change : prefetcher->TakeChanges()) {
+		if (change.type == ChangeType::Rescan) {
+			EmptyCache();
+			continue;
+		}
+		// Directories that aren't cached in yet are read when needed
+		CFileInfo* dir = FindCachedHostDir(change.dir);
+		if (!dir) {
+			continue;
+		}
+		const auto index = find_host_entry(dir, change.name);
+		if (change.type == ChangeType::Added && index < 0) {
+			AddHostEntry(dir, change.name, change.is_directory);
+		} else if (change.type == ChangeType::Removed && index >= 0) {
+			RemoveHostEntry(dir, static_cast<size_t>(index));
+		}
+	}
+	save_dir = nullptr;
+
+	is_applying_host_changes = false;
+}
+
+// Long enough to cover a directory listing or a program scanning for its
+// files, short enough for the changes made on the host to show up soon
+constexpr int64_t MetadataLifetimeMs = 2000;
+
+constexpr size_t MaxCachedMetadata = 16384;
+
+std::optional<DOS_Drive_Cache::FileMetadata> DOS_Drive_Cache::GetMetadata(
+        const std::string& host_path)
+{
+	if (metadata_fs_changes != DOS_GetFileSystemChanges()) {
+		metadata_cache.clear();
+		metadata_fs_changes = DOS_GetFileSystemChanges();
+		return {};
+	}
+	const auto it = metadata_cache.find(host_path);
+	if (it == metadata_cache.end()) {
+		return {};
+	}
+	if (GetTicksSince(it->second.looked_up_ms) > MetadataLifetimeMs) {
+		metadata_cache.erase(it);
+		return {};
+	}
+	return it->second.metadata;
+}
+
+void DOS_Drive_Cache::SetMetadata(const std::string& host_path,
+                                  const FileMetadata& metadata)
+{
+	if (metadata_fs_changes != DOS_GetFileSystemChanges()) {
+		metadata_cache.clear();
+		metadata_fs_changes = DOS_GetFileSystemChanges();
+	}
+	if (metadata_cache.size() >= MaxCachedMetadata) {
+		metadata_cache.clear();
+	}
+	metadata_cache[host_path] = {metadata, GetTicks()};
+}
+
+DOS_Drive_Cache::CFileInfo* DOS_Drive_Cache::FindCachedHostDir(const std::string& host_dir)
+{
+	const std::string_view base = basePath;
+	if (host_dir.compare(0, base.size(), base) != 0) {
+		return nullptr;
+	}
+
+	CFileInfo* dir = dirBase;
+	auto start     = base.size();
+	while (start < host_dir.size()) {
+		auto end = host_dir.find(CROSS_FILESPLIT, start);
+		if (end == std::string::npos) {
+			end = host_dir.size();
+		}
+		const auto index = find_host_entry(dir,
+		                                   host_dir.substr(start, end - start));
+		if (index < 0 || !dir->fileList[index]->isDir) {
+			return nullptr;
+		}
+		dir   = dir->fileList[index];
+		start = end + 1;
+	}
+	return IsCachedIn(dir) ? dir : nullptr;
+}
+
+void DOS_Drive_Cache::AddHostEntry(CFileInfo* dir, const std::string& name,
+                                   const bool is_directory)
+{
+	CreateEntry(dir, name.c_str(), is_directory);
+
+	// Same as AddEntry() for the searches going through the directory
+	const auto index = find_host_entry(dir, name);
+	for (const auto search : dirSearch) {
+		if (search == dir && index >= 0 &&
+		    static_cast<Bitu>(index) <= search->nextEntry) {
+			search->nextEntry++;
+		}
+	}
+}
+
+void DOS_Drive_Cache::RemoveHostEntry(CFileInfo* dir, const size_t index)
+{
+	CFileInfo* info = dir->fileList[index];
+
+	auto& long_names = dir->longNameList;
+	if (const auto it = std::find(long_names.begin(), long_names.end(), info);
+	    it != long_names.end()) {
+		long_names.erase(it);
+	}
+	if (const auto it = dir->longNameIndex.find(long_name_key(info->orgname));
+	    it != dir->longNameIndex.end() && it->second == info) {
+		dir->longNameIndex.erase(it);
+	}
+	auto& list = dir->fileList;
+	list.erase(list.begin() + static_cast<std::ptrdiff_t>(index));
+
+	for (const auto search : dirSearch) {
+		if (search == dir && index < search->nextEntry) {
+			search->nextEntry--;
+		}
+	}
+	DeleteFileInfo(info);
+}
+
+// Takes the listing of the directory at dirPath if it was prefetched
+bool DOS_Drive_Cache::CacheInPrefetched(CFileInfo* dir)
+{
+	if (!prefetcher) {
+		return false;
+	}
+	const auto listing = prefetcher->TakeListing(dirPath);
+	if (!listing) {
+		return false;
+	}
+	for (const auto& entry : *listing) {
+		CreateEntry(dir, entry.name.c_str(), entry.is_directory);
+	}
+	return true;
+}
+
 void DOS_Drive_Cache::SetLabel(const char* vname,bool cdrom,bool allowupdate) {
 /* allowupdate defaults to true. if mount sets a label then allowupdate is 
  * false and will this function return at once after the first call.
@@ -213,6 +410,7 @@ char* DOS_Drive_Cache::GetExpandNameAndNormaliseCase(const char* path)
 }
 
 void DOS_Drive_Cache::AddEntry(const char* path, bool checkExists) {
+	DOS_NoteFileSystemChange();
 	// Get Last part...
 	char file	[CROSS_LEN];
 	char expand	[CROSS_LEN];
@@ -249,6 +447,7 @@ void DOS_Drive_Cache::AddEntry(const char* path, bool checkExists) {
 	}
 }
 void DOS_Drive_Cache::AddEntryDirOverlay(const char* path, bool checkExists) {
+	DOS_NoteFileSystemChange();
 	// Get Last part...
 	char file	[CROSS_LEN];
 	char expand	[CROSS_LEN];
@@ -335,6 +534,7 @@ void DOS_Drive_Cache::DeleteEntry(const char* path, bool ignoreLastDir) {
 }
 
 void DOS_Drive_Cache::CacheOut(const char* path, bool ignoreLastDir) {
+	DOS_NoteFileSystemChange();
 	char expand[CROSS_LEN] = { 0 };
 	CFileInfo* dir;
 	
@@ -366,6 +566,7 @@ void DOS_Drive_Cache::CacheOut(const char* path, bool ignoreLastDir) {
 	// clear lists
 	dir->fileList.clear();
 	dir->longNameList.clear();
+	dir->longNameIndex.clear();
 	save_dir = nullptr;
 }
 
@@ -385,23 +586,14 @@ bool DOS_Drive_Cache::GetShortName(const char* fullname, char* shortname) {
 	else
 		return false;
 
-	std::vector<CFileInfo*>::size_type filelist_size = curDir->longNameList.size();
-	if (filelist_size <= 0) {
+	// The orgname part of the list is not sorted (shortname is), so it's
+	// looked up through the index
+	const auto it = curDir->longNameIndex.find(long_name_key(pos));
+	if (it == curDir->longNameIndex.end()) {
 		return false;
 	}
-
-	// The orgname part of the list is not sorted (shortname is)! So we can only walk through it.
-	for(Bitu i = 0; i < filelist_size; i++) {
-#if defined (WIN32)
-		if (strcasecmp(pos,curDir->longNameList[i]->orgname) == 0) {
-#else
-		if (strcmp(pos,curDir->longNameList[i]->orgname) == 0) {
-#endif
-			safe_strncpy(shortname, curDir->longNameList[i]->shortname, DOS_NAMELENGTH_ASCII);
-			return true;
-		}
-	}
-	return false;
+	safe_strncpy(shortname, it->second->shortname, DOS_NAMELENGTH_ASCII);
+	return true;
 }
 
 int DOS_Drive_Cache::CompareShortname(const char* compareName, const char* shortName) {
@@ -688,28 +880,11 @@ void DOS_Drive_Cache::CreateShortName(CFileInfo* curDir, CFileInfo* info) {
 		}
 
 		// keep list sorted for CreateShortNameID to work correctly
-		if (curDir->longNameList.size()>0) {
-			if (!(strcmp(info->shortname,curDir->longNameList.back()->shortname)<0)) {
-				// append at end of list
-				curDir->longNameList.push_back(info);
-			} else {
-				// look for position where to insert this element
-				bool found=false;
-				std::vector<CFileInfo*>::iterator it;
-				for (it=curDir->longNameList.begin(); it!=curDir->longNameList.end(); ++it) {
-					if (strcmp(info->shortname,(*it)->shortname)<0) {
-						found = true;
-						break;
-					}
-				}
-				// Put it in longname list...
-				if (found) curDir->longNameList.insert(it,info);
-				else curDir->longNameList.push_back(info);
-			}
-		} else {
-			// empty file list, append
-			curDir->longNameList.push_back(info);
-		}
+		auto& list = curDir->longNameList;
+		list.insert(find_sorted_position(list, info), info);
+
+		// Keep the first entry added for a host name
+		curDir->longNameIndex.emplace(long_name_key(info->orgname), info);
 	} else {
 		safe_strcpy(info->shortname, tmpName);
 	}
@@ -724,6 +899,9 @@ DOS_Drive_Cache::CFileInfo* DOS_Drive_Cache::FindDirInfo(const char* path, char*
 	char		work [CROSS_LEN];
 	const char*	start = path;
 	const char*		pos;
+
+	ApplyHostChanges();
+
 	CFileInfo*	curDir = dirBase;
 	uint16_t		id;
 
@@ -853,30 +1031,8 @@ void DOS_Drive_Cache::CreateEntry(CFileInfo* dir, const char* name, bool is_dire
 	// Check for long filenames...
 	CreateShortName(dir, info);		
 
-	bool found = false;
-
 	// keep list sorted (so GetLongName works correctly, used by CreateShortName in this routine)
-	if (dir->fileList.size()>0) {
-		if (!(strcmp(info->shortname,dir->fileList.back()->shortname)<0)) {
-			// append at end of list
-			dir->fileList.push_back(info);
-		} else {
-			// look for position where to insert this element
-			std::vector<CFileInfo*>::iterator it;
-			for (it=dir->fileList.begin(); it!=dir->fileList.end(); ++it) {
-				if (strcmp(info->shortname,(*it)->shortname)<0) {
-					found = true;
-					break;
-				}
-			}
-			// Put file in lists
-			if (found) dir->fileList.insert(it,info);
-			else dir->fileList.push_back(info);
-		}
-	} else {
-		// empty file list, append
-		dir->fileList.push_back(info);
-	}
+	dir->fileList.insert(find_sorted_position(dir->fileList, info), info);
 }
 
 void DOS_Drive_Cache::CopyEntry(CFileInfo* dir, CFileInfo* from) {
@@ -895,7 +1051,7 @@ bool DOS_Drive_Cache::ReadDir(uint16_t id, char* &result) {
 	if (id >= MAX_OPENDIRS)
 		return false;
 
-	if (!IsCachedIn(dirSearch[id])) {
+	if (!IsCachedIn(dirSearch[id]) && !CacheInPrefetched(dirSearch[id])) {
 		// Try to open directory
 		dir_information* dirp = open_directory(dirPath);
 		if (!dirp) {
@@ -25,6 +25,7 @@
 
 #include "bios.h"
 #include "bios_disk.h"
+#include "compressed_image.h"
 #include "dos_inc.h"
 #include "string_utils.h"
 #include "support.h"
@@ -57,6 +58,7 @@ public:
 	uint32_t currentSector              = 0;
 	uint32_t curSectOff                 = 0;
 	uint8_t sectorBuffer[BytePerSector] = {0};
+	FatClusterChain chain               = {};
 	/* Record of where in the directory structure this file is located */
 	uint32_t dirCluster = 0;
 	uint32_t dirIndex   = 0;
@@ -111,7 +113,7 @@ bool fatFile::Read(uint8_t * data, uint16_t *size) {
 	}
 
 	if (!loadedSector) {
-		currentSector = myDrive->getAbsoluteSectFromBytePos(firstCluster, seekpos);
+		currentSector = myDrive->getAbsoluteSectFromBytePos(firstCluster, seekpos, &chain);
 		if(currentSector == 0) {
 			/* EOC reached before EOF */
 			*size = 0;
@@ -133,7 +135,7 @@ bool fatFile::Read(uint8_t * data, uint16_t *size) {
 		data[sizecount++] = sectorBuffer[curSectOff++];
 		seekpos++;
 		if(curSectOff >= myDrive->getSectorSize()) {
-			currentSector = myDrive->getAbsoluteSectFromBytePos(firstCluster, seekpos);
+			currentSector = myDrive->getAbsoluteSectFromBytePos(firstCluster, seekpos, &chain);
 			if(currentSector == 0) {
 				/* EOC reached before EOF */
 				//LOG_MSG("EOC reached before EOF, seekpos %d, filelen %d", seekpos, filelength);
@@ -201,17 +203,17 @@ bool fatFile::Write(uint8_t * data, uint16_t *size) {
 				firstCluster = myDrive->getFirstFreeClust();
 				if(firstCluster == 0) goto finalizeWrite; // out of space
 				myDrive->allocateCluster(firstCluster, 0);
-				currentSector = myDrive->getAbsoluteSectFromBytePos(firstCluster, seekpos);
+				currentSector = myDrive->getAbsoluteSectFromBytePos(firstCluster, seekpos, &chain);
 				myDrive->readSector(currentSector, sectorBuffer);
 				loadedSector = true;
 			}
 			if (!loadedSector) {
-				currentSector = myDrive->getAbsoluteSectFromBytePos(firstCluster, seekpos);
+				currentSector = myDrive->getAbsoluteSectFromBytePos(firstCluster, seekpos, &chain);
 				if(currentSector == 0) {
 					/* EOC reached before EOF - try to increase file allocation */
 					myDrive->appendCluster(firstCluster);
 					/* Try getting sector again */
-					currentSector = myDrive->getAbsoluteSectFromBytePos(firstCluster, seekpos);
+					currentSector = myDrive->getAbsoluteSectFromBytePos(firstCluster, seekpos, &chain);
 					if(currentSector == 0) {
 						/* No can do. lets give up and go home.  We must be out of room */
 						goto finalizeWrite;
@@ -228,7 +230,7 @@ bool fatFile::Write(uint8_t * data, uint16_t *size) {
 		if(curSectOff >= myDrive->getSectorSize()) {
 			if(loadedSector) myDrive->writeSector(currentSector, sectorBuffer);
 
-			currentSector = myDrive->getAbsoluteSectFromBytePos(firstCluster, seekpos);
+			currentSector = myDrive->getAbsoluteSectFromBytePos(firstCluster, seekpos, &chain);
 			if(currentSector == 0) loadedSector = false;
 			else {
 				curSectOff = 0;
@@ -271,7 +273,7 @@ bool fatFile::Seek(uint32_t *pos, uint32_t type) {
 
 	if(seekto<0) seekto = 0;
 	seekpos = (uint32_t)seekto;
-	currentSector = myDrive->getAbsoluteSectFromBytePos(firstCluster, seekpos);
+	currentSector = myDrive->getAbsoluteSectFromBytePos(firstCluster, seekpos, &chain);
 	if (currentSector == 0) {
 		/* not within file size, thus no sector is available */
 		loadedSector = false;
@@ -325,7 +327,45 @@ uint32_t fatDrive::getClustFirstSect(uint32_t clustNum) {
 	return ((clustNum - 2) * bootbuffer.sectorspercluster) + firstDataSector;
 }
 
+bool fatDrive::isEndOfChain(const uint32_t clustValue) const
+{
+	switch (fattype) {
+	case FAT12: return clustValue >= 0xff8;
+	case FAT16: return clustValue >= 0xfff8;
+	case FAT32: return clustValue >= 0xfffffff8;
+	}
+	return false;
+}
+
+// Decodes the whole first FAT at once; volumes with a huge number of
+// clusters keep reading it sector by sector
+void fatDrive::loadFatTable()
+{
+	tried_loading_fat_table = true;
+
+	constexpr uint32_t MaxTableClusters = 4 * 1024 * 1024;
+	const auto num_entries = static_cast<uint64_t>(CountOfClusters) + 2;
+	if (!loadedDisk || num_entries > MaxTableClusters) {
+		return;
+	}
+	std::vector<uint32_t> table(num_entries);
+	for (uint32_t i = 0; i < num_entries; ++i) {
+		table[i] = readClusterValue(i);
+	}
+	fat_table = std::move(table);
+}
+
 uint32_t fatDrive::getClusterValue(uint32_t clustNum) {
+	if (!tried_loading_fat_table) {
+		loadFatTable();
+	}
+	if (clustNum < fat_table.size()) {
+		return fat_table[clustNum];
+	}
+	return readClusterValue(clustNum);
+}
+
+uint32_t fatDrive::readClusterValue(uint32_t clustNum) {
 	uint32_t fatoffset=0;
 	uint32_t fatsectnum;
 	uint32_t fatentoff;
@@ -378,6 +418,18 @@ void fatDrive::setClusterValue(uint32_t clustNum, uint32_t clustValue) {
 	uint32_t fatsectnum;
 	uint32_t fatentoff;
 
+	// Appending to a chain only replaces its end or a free cluster, so
+	// the chains cached so far stay valid unless an actual link changes
+	const auto old_value = getClusterValue(clustNum);
+	if (old_value != 0 && !isEndOfChain(old_value) && old_value != clustValue) {
+		++fat_generation;
+	}
+	if (clustNum < fat_table.size()) {
+		fat_table[clustNum] = (fattype == FAT12)   ? (clustValue & 0xfff)
+		                      : (fattype == FAT16) ? (clustValue & 0xffff)
+		                                           : clustValue;
+	}
+
 	switch(fattype) {
 		case FAT12:
 			fatoffset = clustNum + (clustNum / 2);
@@ -425,6 +477,7 @@ void fatDrive::setClusterValue(uint32_t clustNum, uint32_t clustValue) {
 			var_write((uint32_t *)&fatSectBuffer[fatentoff], clustValue);
 			break;
 	}
+	is_writing_fat = true;
 	for(int fc=0;fc<bootbuffer.fatcopies;fc++) {
 		writeSector(fatsectnum + (fc * bootbuffer.sectorsperfat), &fatSectBuffer[0]);
 		if (fattype==FAT12) {
@@ -434,6 +487,7 @@ void fatDrive::setClusterValue(uint32_t clustNum, uint32_t clustValue) {
 				            &fatSectBuffer[BytePerSector]);
 		}
 	}
+	is_writing_fat = false;
 }
 
 bool fatDrive::getEntryName(char *fullname, char *entname) {
@@ -580,12 +634,29 @@ uint8_t fatDrive::readSector(uint32_t sectnum, void * data) {
 	return loadedDisk->Read_Sector(head, cylinder, sector, data);
 }
 
+void fatDrive::DiscardDecodedFat()
+{
+	fat_table.clear();
+	tried_loading_fat_table = false;
+	curFatSect = 0xffffffff;
+	++fat_generation;
+}
+
 uint8_t fatDrive::writeSector(uint32_t sectnum, void * data) {
 	// Guard
 	if (!loadedDisk) {
 		return 0;
 	}
 
+	// Something other than setClusterValue() writing to the FAT, such as
+	// an absolute disk write, leaves nothing decoded from it valid
+	const auto first_fat_sect = bootbuffer.reservedsectors + partSectOff;
+	const auto num_fat_sects = bootbuffer.fatcopies * bootbuffer.sectorsperfat;
+	if (!is_writing_fat && sectnum >= first_fat_sect &&
+	    sectnum < first_fat_sect + num_fat_sects) {
+		DiscardDecodedFat();
+	}
+
 	if (absolute) {
 		return loadedDisk->Write_AbsoluteSector(sectnum, data);
 	}
@@ -614,14 +685,70 @@ uint32_t fatDrive::getClusterSize(void) {
 	return bootbuffer.sectorspercluster * bootbuffer.bytespersector;
 }
 
-uint32_t fatDrive::getAbsoluteSectFromBytePos(uint32_t startClustNum, uint32_t bytePos) {
-	return  getAbsoluteSectFromChain(startClustNum, bytePos / bootbuffer.bytespersector);
+uint32_t fatDrive::getAbsoluteSectFromBytePos(uint32_t startClustNum, uint32_t bytePos,
+                                              FatClusterChain* chain) {
+	return  getAbsoluteSectFromChain(startClustNum, bytePos / bootbuffer.bytespersector, chain);
+}
+
+// Finds the cluster at the index of the chain, following the links it
+// doesn't know yet
+bool fatDrive::findChainCluster(FatClusterChain& chain, const uint32_t index,
+                                uint32_t& cluster)
+{
+	auto& runs = chain.runs;
+	const auto num_known = runs.back().first_index + runs.back().num_clusters;
+	if (index < num_known) {
+		const auto run = std::prev(std::upper_bound(
+		        runs.begin(),
+		        runs.end(),
+		        index,
+		        [](const uint32_t i, const FatClusterChain::Run& r) {
+			        return i < r.first_index;
+		        }));
+		cluster = run->first_cluster + (index - run->first_index);
+		return true;
+	}
+
+	auto current = runs.back().first_cluster + runs.back().num_clusters - 1;
+	for (auto i = num_known; i <= index; ++i) {
+		const auto next = getClusterValue(current);
+		if (isEndOfChain(next)) {
+			if (i == index && fattype == FAT12) {
+				LOG(LOG_DOSMISC, LOG_ERROR)("End of cluster chain reached, but maybe good after all ?");
+			}
+			return false;
+		}
+		auto& tail = runs.back();
+		if (next == tail.first_cluster + tail.num_clusters) {
+			++tail.num_clusters;
+		} else {
+			runs.push_back({i, next, 1});
+		}
+		current = next;
+	}
+	cluster = current;
+	return true;
 }
 
-uint32_t fatDrive::getAbsoluteSectFromChain(uint32_t startClustNum, uint32_t logicalSector) {
+uint32_t fatDrive::getAbsoluteSectFromChain(uint32_t startClustNum, uint32_t logicalSector,
+                                            FatClusterChain* chain) {
 	int32_t skipClust = logicalSector / bootbuffer.sectorspercluster;
 	uint32_t sectClust = logicalSector % bootbuffer.sectorspercluster;
 
+	if (chain) {
+		if (chain->start_cluster != startClustNum ||
+		    chain->fat_generation != fat_generation || chain->runs.empty()) {
+			chain->start_cluster  = startClustNum;
+			chain->fat_generation = fat_generation;
+			chain->runs.assign(1, {0, startClustNum, 1});
+		}
+		uint32_t cluster = 0;
+		if (!findChainCluster(*chain, static_cast<uint32_t>(skipClust), cluster)) {
+			return 0;
+		}
+		return getClustFirstSect(cluster) + sectClust;
+	}
+
 	uint32_t currentClust = startClustNum;
 	uint32_t testvalue;
 
@@ -778,7 +905,8 @@ fatDrive::fatDrive(const char *sysFilename,
                    uint32_t cylsector,
                    uint32_t headscyl,
                    uint32_t cylinders,
-                   bool roflag)
+                   bool roflag,
+                   const std::string& delta_filename)
 	: loadedDisk(nullptr),
 	  created_successfully(true),
 	  partSectOff(0),
@@ -804,13 +932,19 @@ fatDrive::fatDrive(const char *sysFilename,
 		imgDTA    = new DOS_DTA(imgDTAPtr);
 	}
 	assert(sysFilename);
-	diskfile = fopen_wrap_ro_fallback(sysFilename, readonly);
+	// The writes go to the delta, so the image itself is only read
+	bool is_image_readonly = readonly || !delta_filename.empty();
+	diskfile = fopen_wrap_ro_fallback(sysFilename, is_image_readonly);
+	if (delta_filename.empty()) {
+		readonly = is_image_readonly;
+	}
 	created_successfully = (diskfile != nullptr);
 	if (!created_successfully)
 		return;
-	const auto sz = stdio_size_kb(diskfile);
+	const auto sz = image_file_size_kb(diskfile);
 	if (sz < 0) {
 		fclose(diskfile);
+		created_successfully = false;
 		return;
 	}
 	filesize = check_cast<uint32_t>(sz);
@@ -819,6 +953,15 @@ fatDrive::fatDrive(const char *sysFilename,
 	/* Load disk image */
 	loadedDisk.reset(new imageDisk(diskfile, sysFilename, filesize, is_hdd));
 
+	if (loadedDisk->IsCompressed() && delta_filename.empty()) {
+		readonly = true;
+	}
+
+	if (!delta_filename.empty() && !loadedDisk->AttachDeltas(delta_filename)) {
+		created_successfully = false;
+		return;
+	}
+
 	if(is_hdd) {
 		/* Set user specified harddrive parameters */
 		loadedDisk->Set_Geometry(headscyl, cylinders,cylsector, bytesector);
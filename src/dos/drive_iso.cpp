@@ -18,6 +18,7 @@
 
 #include "drives.h"
 
+#include <algorithm>
 #include <cctype>
 #include <cstring>
 
@@ -154,7 +155,6 @@ isoDrive::isoDrive(char driveLetter, const char *fileName, uint8_t mediaid, int
 {
 	this->fileName[0]  = '\0';
 	this->discLabel[0] = '\0';
-	memset(dirIterators, 0, sizeof(dirIterators));
 	memset(sectorHashEntries, 0, sizeof(sectorHashEntries));
 	memset(&rootEntry, 0, sizeof(isoDirEntry));
 
@@ -206,6 +206,7 @@ int isoDrive::UpdateMscdex(char drive_letter, const char *path, uint8_t &sub_uni
 
 void isoDrive::Activate(void) {
 	UpdateMscdex(driveLetter, fileName, subUnit);
+	dirRecordsCache.clear();
 }
 
 bool isoDrive::FileOpen(DOS_File **file, char *name, uint32_t flags) {
@@ -420,14 +421,8 @@ Bits isoDrive::UnMount()
 int isoDrive::GetDirIterator(const isoDirEntry* de) {
 	int dirIterator = nextFreeDirIterator;
 
-	// get start and end sector of the directory entry (pad end sector if necessary)
-	dirIterators[dirIterator].currentSector = EXTENT_LOCATION(*de);
-	dirIterators[dirIterator].endSector =
-		EXTENT_LOCATION(*de) + DATA_LENGTH(*de) / ISO_FRAMESIZE - 1;
-	if (DATA_LENGTH(*de) % ISO_FRAMESIZE != 0)
-		dirIterators[dirIterator].endSector++;
-
 	// reset position and mark as valid
+	dirIterators[dirIterator].records = GetDirRecords(de);
 	dirIterators[dirIterator].pos = 0;
 	dirIterators[dirIterator].valid = true;
 
@@ -438,41 +433,20 @@ int isoDrive::GetDirIterator(const isoDirEntry* de) {
 }
 
 bool isoDrive::GetNextDirEntry(const int dirIteratorHandle, isoDirEntry* de) {
-	bool result = false;
-	uint8_t* buffer = nullptr;
 	DirIterator& dirIterator = dirIterators[dirIteratorHandle];
 
 	// check if the directory entry is valid
-	if (dirIterator.valid && ReadCachedSector(&buffer, dirIterator.currentSector)) {
-		// check if the next sector has to be read
-		if ((dirIterator.pos >= ISO_FRAMESIZE)
-		 || (buffer[dirIterator.pos] == 0)
-		 || (dirIterator.pos + buffer[dirIterator.pos] > ISO_FRAMESIZE)) {
-
-			// check if there is another sector available
-		 	if (dirIterator.currentSector < dirIterator.endSector) {
-			 	dirIterator.pos = 0;
-			 	dirIterator.currentSector++;
-			 	if (!ReadCachedSector(&buffer, dirIterator.currentSector)) {
-			 		return false;
-			 	}
-		 	} else {
-		 		return false;
-		 	}
-		 }
-		 // read sector and advance sector pointer
-		 const int length = readDirEntry(de, &buffer[dirIterator.pos]);
-		 result = length >= 0;
-		 if (length >= 0)
-			 dirIterator.pos += static_cast<unsigned>(length);
-		 else // read failed, so step back to our prior iterator
-			 dirIterator.pos--;
+	if (!dirIterator.valid || !dirIterator.records ||
+	    dirIterator.pos >= dirIterator.records->entries.size()) {
+		return false;
 	}
-	return result;
+	*de = dirIterator.records->entries[dirIterator.pos++];
+	return true;
 }
 
 void isoDrive::FreeDirIterator(const int dirIterator) {
 	dirIterators[dirIterator].valid = false;
+	dirIterators[dirIterator].records.reset();
 
 	// if this was the last aquired iterator decrement nextFreeIterator
 	if ((dirIterator + 1) % MAX_OPENDIRS == nextFreeDirIterator) {
@@ -502,6 +476,69 @@ bool isoDrive::ReadCachedSector(uint8_t** buffer, const uint32_t sector) {
 	return true;
 }
 
+isoDrive::dir_records_t isoDrive::GetDirRecords(const isoDirEntry* de)
+{
+	const auto extent = EXTENT_LOCATION(*de);
+	if (const auto it = dirRecordsCache.find(extent);
+	    it != dirRecordsCache.end()) {
+		return it->second;
+	}
+
+	// get the end sector of the directory entry (pad if necessary)
+	auto endSector = extent + DATA_LENGTH(*de) / ISO_FRAMESIZE - 1;
+	if (DATA_LENGTH(*de) % ISO_FRAMESIZE != 0)
+		endSector++;
+
+	auto records = std::make_shared<DirRecords>();
+	bool complete = true;
+
+	// parse the records up to the first one that isn't supported, and
+	// skip the padding at the end of each sector
+	uint8_t buffer[ISO_FRAMESIZE];
+	for (auto sector = extent; complete && sector <= endSector; ++sector) {
+		if (!readSector(buffer, sector)) {
+			complete = false;
+			break;
+		}
+		uint32_t pos = 0;
+		while (pos < ISO_FRAMESIZE && buffer[pos] != 0 &&
+		       pos + buffer[pos] <= ISO_FRAMESIZE) {
+			isoDirEntry entry;
+			const int length = readDirEntry(&entry, &buffer[pos]);
+			if (length < 0) {
+				endSector = sector;
+				break;
+			}
+			records->entries.push_back(entry);
+			pos += static_cast<unsigned>(length);
+		}
+	}
+
+	for (uint32_t i = 0; i < records->entries.size(); ++i) {
+		const auto& entry = records->entries[i];
+		std::string name(reinterpret_cast<const char*>(entry.ident));
+		upcase(name);
+		records->names.push_back(name);
+
+		const auto fileFlags = iso ? entry.fileFlags : entry.timeZone;
+		if (!IS_ASSOC(fileFlags)) {
+			records->byName.push_back(i);
+		}
+	}
+	// the stable sort keeps the first of equally named records first
+	std::stable_sort(records->byName.begin(),
+	                 records->byName.end(),
+	                 [&](const uint32_t a, const uint32_t b) {
+		                 return records->names[a] < records->names[b];
+	                 });
+
+	// a failed read might work the next time
+	if (complete) {
+		dirRecordsCache[extent] = records;
+	}
+	return records;
+}
+
 inline bool isoDrive :: readSector(uint8_t *buffer, uint32_t sector) {
 	return CDROM_Interface_Image::images[subUnit]->ReadSector(buffer, false, sector);
 }
@@ -589,13 +626,21 @@ bool isoDrive :: lookup(isoDirEntry *de, const char *path) {
 			}
 
 			// look for the current path element
-			int dirIterator = GetDirIterator(de);
-			while (!found && GetNextDirEntry(dirIterator, de)) {
-				if (!IS_ASSOC(FLAGS2) && (0 == strncasecmp((char*) de->ident, name, ISO_MAX_FILENAME_LENGTH))) {
-					found = true;
-				}
+			std::string key = name;
+			upcase(key);
+			const auto records = GetDirRecords(de);
+			const auto it = std::lower_bound(
+			        records->byName.begin(),
+			        records->byName.end(),
+			        key,
+			        [&](const uint32_t i, const std::string& k) {
+				        return records->names[i] < k;
+			        });
+			if (it != records->byName.end() &&
+			    records->names[*it] == key) {
+				*de   = records->entries[*it];
+				found = true;
 			}
-			FreeDirIterator(dirIterator);
 		}
 		if (!found) return false;
 	}
@@ -33,6 +33,10 @@
 #include <limits>
 #include <sys/types.h>
 
+#if defined(HAVE_MMAP)
+#include <sys/mman.h>
+#endif
+
 #ifdef _MSC_VER
 #include <sys/utime.h>
 #else
@@ -46,6 +50,21 @@
 #include "cross.h"
 #include "inout.h"
 
+static size_t file_write_buffer_size = 0;
+
+void DOS_SetFileWriteBuffer(const size_t num_bytes)
+{
+	file_write_buffer_size = num_bytes;
+}
+
+// Has to be called before anything else is done with the stream
+static void set_write_buffer(FILE* file)
+{
+	if (file && file_write_buffer_size > 0) {
+		setvbuf(file, nullptr, _IOFBF, file_write_buffer_size);
+	}
+}
+
 bool localDrive::FileCreate(DOS_File** file, char* name, FatAttributeFlags attributes)
 {
 	// Don't allow overwriting read-only files.
@@ -77,6 +96,8 @@ bool localDrive::FileCreate(DOS_File** file, char* name, FatAttributeFlags attri
 		return false;
 	}
 
+	set_write_buffer(file_pointer);
+
 	if (!file_exists) {
 		dirCache.AddEntry(newname, true);
 	}
@@ -229,6 +250,10 @@ bool localDrive::FileOpen(DOS_File **file, char *name, uint32_t flags)
 		return false;
 	}
 
+	if ((flags & 0xf) == OPEN_WRITE || (flags & 0xf) == OPEN_READWRITE) {
+		set_write_buffer(fhandle);
+	}
+
 	*file = new localFile(name, newname, fhandle, basedir);
 	(*file)->flags = flags;  // for the inheritance flag and maybe check for others.
 
@@ -369,10 +394,34 @@ bool localDrive::FindFirst(char* _dir, DOS_DTA& dta, bool fcb_findfirst)
 	return FindNext(dta);
 }
 
+// Looks up what FindNext reports about the file at the host path
+static std::optional<DOS_Drive_Cache::FileMetadata> read_metadata(const char* host_path)
+{
+	struct stat stat_block;
+	if (stat(host_path, &stat_block) != 0) {
+		return {}; // No symlinks and such
+	}
+
+	DOS_Drive_Cache::FileMetadata metadata = {};
+	if (DOSERR_NONE != local_drive_get_attributes(host_path, metadata.attributes)) {
+		return {};
+	}
+
+	metadata.size = (uint32_t)stat_block.st_size;
+	struct tm datetime;
+	if (cross::localtime_r(&stat_block.st_mtime, &datetime)) {
+		metadata.date = DOS_PackDate(datetime);
+		metadata.time = DOS_PackTime(datetime);
+	} else {
+		metadata.time = 6;
+		metadata.date = 4;
+	}
+	return metadata;
+}
+
 bool localDrive::FindNext(DOS_DTA& dta)
 {
 	char* dir_ent;
-	struct stat stat_block;
 	char full_name[CROSS_LEN];
 	char dir_entcopy[CROSS_LEN];
 
@@ -400,18 +449,22 @@ bool localDrive::FindNext(DOS_DTA& dta)
 		safe_strcpy(dir_entcopy, dir_ent);
 		const char* temp_name = dirCache.GetExpandNameAndNormaliseCase(
 		        full_name);
-		if (stat(temp_name, &stat_block) != 0) {
-			continue; // No symlinks and such
-		}
 
 		if (is_hidden_by_host(temp_name)) {
 			continue; // No host-only hidden files
 		}
 
-		FatAttributeFlags find_attr = {};
-		if (DOSERR_NONE != local_drive_get_attributes(temp_name, find_attr)) {
-			continue;
+		// Listing a directory or scanning it for files tends to come
+		// back to the same files soon
+		auto metadata = dirCache.GetMetadata(temp_name);
+		if (!metadata) {
+			metadata = read_metadata(temp_name);
+			if (!metadata) {
+				continue;
+			}
+			dirCache.SetMetadata(temp_name, *metadata);
 		}
+		const auto& find_attr = metadata->attributes;
 
 		if ((find_attr.directory && !search_attr.directory) ||
 		    (find_attr.hidden && !search_attr.hidden) ||
@@ -421,28 +474,16 @@ bool localDrive::FindNext(DOS_DTA& dta)
 
 		/*file is okay, setup everything to be copied in DTA Block */
 		char find_name[DOS_NAMELENGTH_ASCII] = "";
-		uint16_t find_date;
-		uint16_t find_time;
-		uint32_t find_size;
 
 		if (safe_strlen(dir_entcopy) < DOS_NAMELENGTH_ASCII) {
 			safe_strcpy(find_name, dir_entcopy);
 			upcase(find_name);
 		}
 
-		find_size = (uint32_t)stat_block.st_size;
-		struct tm datetime;
-		if (cross::localtime_r(&stat_block.st_mtime, &datetime)) {
-			find_date = DOS_PackDate(datetime);
-			find_time = DOS_PackTime(datetime);
-		} else {
-			find_time = 6;
-			find_date = 4;
-		}
 		dta.SetResult(find_name,
-		              find_size,
-		              find_date,
-		              find_time,
+		              metadata->size,
+		              metadata->date,
+		              metadata->time,
 		              find_attr._data);
 		return true;
 	}
@@ -668,6 +709,65 @@ void localFile::fseek_and_check(int whence)
 	static_cast<void>(fseek_to_and_check(stream_pos, whence));
 }
 
+// Maps the whole file if it's a regular file that was opened read-only, so
+// reads become copies out of the mapping rather than stdio calls
+void localFile::map_for_reading()
+{
+	tried_mapping = true;
+
+#if defined(HAVE_MMAP)
+	if ((flags & 0xf) != OPEN_READ) {
+		return;
+	}
+	const auto file = cross_fileno(fhandle);
+	if (file == -1) {
+		return;
+	}
+	struct stat file_stat;
+	if (fstat(file, &file_stat) != 0 || !S_ISREG(file_stat.st_mode) ||
+	    file_stat.st_size <= 0 ||
+	    file_stat.st_size > std::numeric_limits<int32_t>::max()) {
+		return;
+	}
+	// Take over the position from the stream
+	if (!ftell_and_check()) {
+		return;
+	}
+
+	const auto num_bytes = static_cast<size_t>(file_stat.st_size);
+	void* mem = mmap(nullptr, num_bytes, PROT_READ, MAP_SHARED, file, 0);
+	if (mem == MAP_FAILED) {
+		LOG_DEBUG("FS: Failed mapping file '%s', reading it instead",
+		          name.c_str());
+		return;
+	}
+	mapped_data = static_cast<const uint8_t*>(mem);
+	mapped_size = num_bytes;
+#endif
+}
+
+// Touching a mapping past the end of a file that shrank faults, so the
+// mapping is only used while the file keeps its size
+bool localFile::mapping_matches_file() const
+{
+	struct stat file_stat;
+	const auto file = cross_fileno(fhandle);
+	return file != -1 && fstat(file, &file_stat) == 0 &&
+	       static_cast<size_t>(file_stat.st_size) == mapped_size;
+}
+
+void localFile::unmap()
+{
+#if defined(HAVE_MMAP)
+	if (!mapped_data) {
+		return;
+	}
+	munmap(const_cast<uint8_t*>(mapped_data), mapped_size);
+	mapped_data = nullptr;
+	mapped_size = 0;
+#endif
+}
+
 //TODO Maybe use fflush, but that seemed to fuck up in visual c
 bool localFile::Read(uint8_t *data, uint16_t *size)
 {
@@ -677,37 +777,95 @@ bool localFile::Read(uint8_t *data, uint16_t *size)
 		return false;
 	}
 
-	// Seek if we last wrote
-	if (last_action == LastAction::Write)
-		if (ftell_and_check())
-			fseek_and_check(SEEK_SET);
-
-	last_action = LastAction::Read;
-	const auto requested = *size;
-	const auto actual = static_cast<uint16_t>(fread(data, 1, requested, fhandle));
-	*size = actual; // always save the actual
-
-	if (actual != requested) {
-		// LOG_DEBUG("FS: Only read %u of %u requested bytes from file '%s'",
-		//           actual,
-		//           requested,
-		//           name.c_str());
+	if (!tried_mapping) {
+		map_for_reading();
+	}
+	if (mapped_data && !mapping_matches_file()) {
+		// Hand the position back to the stream for good
+		unmap();
+		fseek_and_check(SEEK_SET);
+	}
 
-		// Check for host read error
-		if (ferror(fhandle)) {
-			clearerr(fhandle);
-			DOS_SetError(DOSERR_ACCESS_DENIED);
-			return false;
+	if (mapped_data) {
+		const auto pos = static_cast<size_t>(stream_pos);
+		const auto available = pos < mapped_size ? mapped_size - pos : 0;
+		const auto actual = static_cast<uint16_t>(
+		        std::min(static_cast<size_t>(*size), available));
+		if (actual) {
+			memcpy(data, mapped_data + pos, actual);
+		}
+		stream_pos += actual;
+		*size = actual;
+	} else {
+		// Seek if we last wrote
+		if (last_action == LastAction::Write)
+			if (ftell_and_check())
+				fseek_and_check(SEEK_SET);
+
+		last_action = LastAction::Read;
+		const auto requested = *size;
+		const auto actual = static_cast<uint16_t>(fread(data, 1, requested, fhandle));
+		*size = actual; // always save the actual
+
+		if (actual != requested) {
+			// LOG_DEBUG("FS: Only read %u of %u requested bytes from file '%s'",
+			//           actual,
+			//           requested,
+			//           name.c_str());
+
+			// Check for host read error
+			if (ferror(fhandle)) {
+				clearerr(fhandle);
+				DOS_SetError(DOSERR_ACCESS_DENIED);
+				return false;
+			}
 		}
 	}
 
 	/* Fake harddrive motion. Inspector Gadget with Sound Blaster compatible */
 	/* Same for Igor */
 	/* hardrive motion => unmask irq 2. Only do it when it's masked as
-	 * unmasking is realitively heavy to emulate */
-	uint8_t mask = IO_Read(0x21);
-	if (mask & 0x4)
-		IO_Write(0x21, mask & 0xfb);
+	 * unmasking is realitively heavy to emulate. Once per open is enough,
+	 * which keeps the port accesses out of games' many small reads. */
+	if (!has_faked_motion) {
+		uint8_t mask = IO_Read(0x21);
+		if (mask & 0x4)
+			IO_Write(0x21, mask & 0xfb);
+		has_faked_motion = true;
+	}
+	return true;
+}
+
+// Reads the file's bytes straight into the guest's RAM where it has a host
+// pointer, and only stages the pages that have to go through their handlers
+bool localFile::ReadToGuest(const PhysPt dest, uint16_t* size)
+{
+	PhysPt pt      = dest;
+	auto remaining = *size;
+	uint16_t total = 0;
+
+	while (remaining) {
+		const auto span = MEM_GetWritableSpan(pt, remaining);
+		auto num_bytes  = static_cast<uint16_t>(span.num_bytes);
+
+		const auto target = span.data ? span.data : dos_copybuf;
+		if (!Read(target, &num_bytes)) {
+			return false;
+		}
+		if (!span.data) {
+			MEM_BlockWrite(pt, dos_copybuf, num_bytes);
+		}
+
+		total += num_bytes;
+		pt += num_bytes;
+		remaining -= num_bytes;
+
+		// Reached the end of the file
+		if (num_bytes < span.num_bytes) {
+			break;
+		}
+	}
+	*size = total;
 	return true;
 }
 
@@ -727,6 +885,9 @@ bool localFile::Write(uint8_t *data, uint16_t *size)
 	last_action = LastAction::Write;
 	set_archive_on_close = true;
 
+	// The size and date looked up by directory searches are stale now
+	DOS_NoteFileSystemChange();
+
 	// Truncate the file
 	if (*size == 0) {
 		const auto file = cross_fileno(fhandle);
@@ -782,19 +943,41 @@ bool localFile::Seek(uint32_t *pos_addr, uint32_t type)
 	// uint32_t* pointer (pos_addr), so reinterpret the underlying memory as
 	// such to prevent rollover into the unsigned range.
 	const auto pos = *reinterpret_cast<int32_t *>(pos_addr);
-	if (!fseek_to_and_check(pos, seektype)) {
-		// Failed to seek, but try again this time seeking to
-		// the end of file, which satisfies Black Thorne.
-		stream_pos = 0;
-		fseek_and_check(SEEK_END);
+
+	if (mapped_data && !mapping_matches_file()) {
+		unmap();
+		fseek_and_check(SEEK_SET);
 	}
+
+	// Asking for the position doesn't move the stream, so the write
+	// buffer isn't handed to the host and the last action stands
+	const auto is_query = seektype == SEEK_CUR && pos == 0;
+
+	if (mapped_data) {
+		const auto file_size = static_cast<long>(mapped_size);
+		const auto origin = seektype == SEEK_CUR ? stream_pos
+		                  : seektype == SEEK_END ? file_size
+		                                         : 0L;
+		// Seeking before the start lands on the end, like below
+		const auto new_pos = origin + pos;
+		stream_pos = new_pos < 0 ? file_size : new_pos;
+	} else if (is_query && ftell_and_check()) {
+		// stream_pos holds the position
+	} else {
+		if (!fseek_to_and_check(pos, seektype)) {
+			// Failed to seek, but try again this time seeking to
+			// the end of file, which satisfies Black Thorne.
+			stream_pos = 0;
+			fseek_and_check(SEEK_END);
+		}
 #if 0
-	fpos_t temppos;
-	fgetpos(fhandle,&temppos);
-	uint32_t * fake_pos=(uint32_t*)&temppos;
-	*pos_addr = *fake_pos;
+		fpos_t temppos;
+		fgetpos(fhandle,&temppos);
+		uint32_t * fake_pos=(uint32_t*)&temppos;
+		*pos_addr = *fake_pos;
 #endif
-	static_cast<void>(ftell_and_check());
+		static_cast<void>(ftell_and_check());
+	}
 
 	// The inbound position is actually an int32_t being passed through a
 	// uint32_t* pointer (pos_addr), so before we save the seeked position
@@ -805,7 +988,9 @@ bool localFile::Seek(uint32_t *pos_addr, uint32_t type)
 	       stream_pos <= std::numeric_limits<int32_t>::max());
 	*reinterpret_cast<int32_t *>(pos_addr) = static_cast<int32_t>(stream_pos);
 
-	last_action = LastAction::None;
+	if (!is_query || mapped_data) {
+		last_action = LastAction::None;
+	}
 	return true;
 }
 
@@ -813,6 +998,10 @@ bool localFile::Close()
 {
 	bool result = true;
 
+	if (set_archive_on_close || newtime) {
+		DOS_NoteFileSystemChange();
+	}
+
 	// only close if one reference left
 	if (refCtr == 1) {
 		if (set_archive_on_close) {
@@ -830,6 +1019,7 @@ bool localFile::Close()
 			set_archive_on_close = false;
 		}
 
+		unmap();
 		if (fhandle) {
 			fclose(fhandle);
 		}
@@ -887,11 +1077,19 @@ localFile::localFile(const char* _name, const std_fs::path& path, FILE* handle,
 	SetName(_name);
 }
 
+localFile::~localFile()
+{
+	unmap();
+}
+
 bool localFile::UpdateDateTimeFromHost()
 {
 	if (!open)
 		return false;
 
+	// The host only updates the time once it has the buffered writes
+	Flush();
+
 	// Legal defaults if we're unable to populate them
 	time = 1;
 	date = 1;
@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <cerrno>
+#include <chrono>
 #include <cinttypes>
 #include <cstdio>
 #include <cstdlib>
@@ -405,6 +406,7 @@ Overlay_Drive::Overlay_Drive(const char *startdir,
 	//add_deleted_path(dirname); //update_cache will add the overlap_folder
 	overlap_folder = dirname;
 
+	load_overlay_index();
 	update_cache(true);
 }
 
@@ -618,6 +620,137 @@ bool Overlay_Drive::Sync_leading_dirs(const char* dos_filename){
 
 	return true;
 }
+constexpr char OverlayIndexHeader[] = "DOSBox Staging overlay index 1";
+constexpr char OverlayIndexSuffix[] = "_IDX_DIRS";
+
+std::string Overlay_Drive::get_overlay_index_path() const
+{
+	return std::string(overlaydir) + special_prefix + OverlayIndexSuffix;
+}
+
+// Index format, one line each:
+//   header
+//   D <mtime ticks> <directory relative to the overlay, empty for the root>
+//   d|f <entry name>
+void Overlay_Drive::load_overlay_index()
+{
+	overlay_index.clear();
+
+	const auto path = get_overlay_index_path();
+	FILE* f = fopen(path.c_str(), "rb");
+	if (!f) {
+		// Created up front, so writing it later doesn't change the
+		// modification time of the overlay's root
+		f = fopen(path.c_str(), "wb");
+		if (f) fclose(f);
+		return;
+	}
+
+	OverlayListing* listing = nullptr;
+	bool is_valid = false;
+	char line[CROSS_LEN + 32];
+	while (fgets(line, sizeof(line), f)) {
+		const auto len = safe_strlen(line);
+		if (len == 0 || line[len - 1] != '\n') {
+			is_valid = false;
+			break;
+		}
+		line[len - 1] = 0;
+
+		if (!is_valid) {
+			if (strcmp(line, OverlayIndexHeader) != 0) break;
+			is_valid = true;
+			continue;
+		}
+		if (line[0] == 'D' && line[1] == ' ') {
+			char* dir = nullptr;
+			const auto ticks = strtoll(line + 2, &dir, 10);
+			if (*dir != ' ') {
+				is_valid = false;
+				break;
+			}
+			listing = &overlay_index[dir + 1];
+			listing->mtime = std_fs::file_time_type(
+			        std_fs::file_time_type::duration(ticks));
+		} else if ((line[0] == 'd' || line[0] == 'f') && line[1] == ' ' &&
+		           listing) {
+			listing->entries.push_back({line + 2, line[0] == 'd'});
+		} else {
+			is_valid = false;
+			break;
+		}
+	}
+	fclose(f);
+
+	if (!is_valid) {
+		overlay_index.clear();
+	}
+}
+
+void Overlay_Drive::save_overlay_index() const
+{
+	// Rewritten in place, see load_overlay_index()
+	FILE* f = fopen(get_overlay_index_path().c_str(), "wb");
+	if (!f) return;
+
+	fprintf(f, "%s\n", OverlayIndexHeader);
+	for (const auto& [dir, listing] : overlay_index) {
+		fprintf(f, "D %lld %s\n",
+		        static_cast<long long>(listing.mtime.time_since_epoch().count()),
+		        dir.c_str());
+		for (const auto& entry : listing.entries) {
+			fprintf(f, "%c %s\n", entry.is_directory ? 'd' : 'f',
+			        entry.name.c_str());
+		}
+	}
+	fclose(f);
+}
+
+// Lists a directory of the overlay into the new index, taking the listing
+// from the old index if the directory wasn't modified since
+bool Overlay_Drive::read_overlay_dir(const std::string& dir, OverlayIndex& new_index)
+{
+	const auto path = std::string(overlaydir) + dir;
+
+	std::error_code ec = {};
+	auto mtime = std_fs::last_write_time(path, ec);
+	if (!ec) {
+		const auto it = overlay_index.find(dir);
+		if (it != overlay_index.end() && it->second.mtime == mtime) {
+			new_index[dir] = std::move(it->second);
+			return true;
+		}
+	}
+
+	dir_information* dirp = open_directory(path.c_str());
+	if (dirp == nullptr) return false;
+
+	OverlayListing listing = {};
+	char dir_name[CROSS_LEN];
+	bool is_directory;
+	bool can_be_indexed = !ec;
+	if (read_directory_first(dirp, dir_name, is_directory)) {
+		do {
+			if (strchr(dir_name, '\n')) can_be_indexed = false;
+			listing.entries.push_back({dir_name, is_directory});
+		} while (read_directory_next(dirp, dir_name, is_directory));
+	}
+	close_directory(dirp);
+
+	// A directory modified within the timestamp granularity of the time
+	// it was read could change again without the time changing, so it's
+	// always read again next time
+	constexpr auto MaxGranularity = std::chrono::seconds(2);
+	if (mtime > std_fs::file_time_type::clock::now() - MaxGranularity) {
+		can_be_indexed = false;
+	}
+	listing.mtime = can_be_indexed ? mtime : std_fs::file_time_type::min();
+
+	new_index[dir] = std::move(listing);
+	overlay_index_changed = true;
+	return true;
+}
+
 void Overlay_Drive::update_cache(bool read_directory_contents) {
 	const auto a = logoverlay ? GetTicks() : 0;
 	std::vector<std::string> specials;
@@ -655,29 +788,33 @@ void Overlay_Drive::update_cache(bool read_directory_contents) {
 	std::vector<std::string>::iterator i;
 	std::string::size_type const prefix_lengh = special_prefix.length();
 	if (read_directory_contents) {
-		dir_information* dirp = open_directory(overlaydir);
-		if (dirp == nullptr) return;
-		// Read complete directory
-		char dir_name[CROSS_LEN];
-		bool is_directory;
-		if (read_directory_first(dirp, dir_name, is_directory)) {
-			if ((safe_strlen(dir_name) > prefix_lengh+5) && strncmp(dir_name,special_prefix.c_str(),prefix_lengh) == 0) specials.push_back(dir_name);
-			else if (is_directory) dirnames.push_back(dir_name);
-			else filenames.push_back(dir_name);
-			while (read_directory_next(dirp, dir_name, is_directory)) {
-				if ((safe_strlen(dir_name) > prefix_lengh+5) && strncmp(dir_name,special_prefix.c_str(),prefix_lengh) == 0) specials.push_back(dir_name);
-				else if (is_directory) dirnames.push_back(dir_name);
-				else filenames.push_back(dir_name);
+		OverlayIndex new_index = {};
+		if (!read_overlay_dir("", new_index)) return;
+
+		const auto index_name = special_prefix + OverlayIndexSuffix;
+
+		auto add_entries = [&](const std::string& dirpush) {
+			for (const auto& entry : new_index[dirpush].entries) {
+				const auto& dir_name = entry.name;
+				if (dirpush.empty() && dir_name == index_name) continue;
+				if ((dir_name.length() > prefix_lengh + 5) &&
+				    dir_name.compare(0, prefix_lengh, special_prefix) == 0) {
+					specials.emplace_back(dirpush + dir_name);
+				} else if (entry.is_directory) {
+					dirnames.emplace_back(dirpush + dir_name);
+				} else {
+					filenames.emplace_back(dirpush + dir_name);
+				}
 			}
-		}
-		close_directory(dirp);
-		dirp = nullptr;
+		};
+		add_entries("");
 
 		// parse directories to add them.
-		for (i = dirnames.begin(); i != dirnames.end(); ++i) {
-			if ((*i) == ".") continue;
-			if ((*i) == "..") continue;
-			std::string testi(*i);
+		for (size_t n = 0; n < dirnames.size(); ++n) {
+			// Copied, as reading the directory adds to dirnames
+			const std::string testi = dirnames[n];
+			if (testi == ".") continue;
+			if (testi == "..") continue;
 			std::string::size_type ll = testi.length();
 			//TODO: Use the dirname\. and dirname\.. for creating fake directories in the driveCache.
 			if( ll >2 && testi[ll-1] == '.' && testi[ll-2] == CROSS_FILESPLIT) continue; 
@@ -685,62 +822,27 @@ void Overlay_Drive::update_cache(bool read_directory_contents) {
 
 #if OVERLAY_DIR
 			char tdir[CROSS_LEN];
-			safe_strcpy(tdir, (*i).c_str());
+			safe_strcpy(tdir, testi.c_str());
 			CROSS_DOSFILENAME(tdir);
 			bool dir_exists_in_base = localDrive::TestDir(tdir);
 #endif
 
-			char dir[CROSS_LEN];
-			safe_strcpy(dir, overlaydir);
-			safe_strcat(dir, (*i).c_str());
-			char dirpush[CROSS_LEN];
-			safe_strcpy(dirpush, (*i).c_str());
-			static char end[2] = {CROSS_FILESPLIT,0};
-			safe_strcat(dirpush, end); // Linux ?
-
-			assert(dirp == nullptr);
-			dirp = open_directory(dir);
-			if (dirp == nullptr) continue;
+			const std::string dirpush = testi + CROSS_FILESPLIT;
+			if (!read_overlay_dir(dirpush, new_index)) continue;
 
 #if OVERLAY_DIR
 			//Good directory, add to DOSdirs_cache if not existing in localDrive. tested earlier to prevent problems with opendir
 			if (!dir_exists_in_base) add_DOSdir_to_cache(tdir);
 #endif
+			add_entries(dirpush);
+		}
 
-			std::string backupi(*i);
-
-			auto maybe_add_path = [&]() {
-				if ((safe_strlen(dir_name) > prefix_lengh + 5) &&
-				    strncmp(dir_name,
-				            special_prefix.c_str(),
-				            prefix_lengh) == 0) {
-					specials.emplace_back(
-					        std::string(dirpush) + dir_name);
-				} else if (is_directory) {
-					dirnames.emplace_back(
-					        std::string(dirpush) + dir_name);
-				} else {
-					filenames.emplace_back(
-					        std::string(dirpush) + dir_name);
-				}
-			};
-			// Read complete directory
-			if (read_directory_first(dirp, dir_name, is_directory)) {
-				maybe_add_path();
-				while (read_directory_next(dirp, dir_name, is_directory)) {
-					maybe_add_path();
-				}
-			}
-			close_directory(dirp);
-			dirp = nullptr;
-
-			// find current directory again, for the next round. But
-			// if it's not there, then bail out before the next
-			// round to avoid incrementing beyond the end.
-			i = std::find(dirnames.begin(), dirnames.end(), backupi);
-			if (i == dirnames.end())
-				break;
+		// Directories gone since the last time count as a change too
+		if (overlay_index_changed || new_index.size() != overlay_index.size()) {
+			overlay_index = std::move(new_index);
+			save_overlay_index();
 		}
+		overlay_index_changed = false;
 	}
 
 
@@ -1078,10 +1180,8 @@ bool Overlay_Drive::SetFileAttr(const char* name, FatAttributeFlags attr)
 
 void Overlay_Drive::add_deleted_file(const char* name,bool create_on_disk) {
 	if (logoverlay) LOG_MSG("add del file %s",name);
-	if (!is_deleted_file(name)) {
-		deleted_files_in_base.push_back(name);
+	if (deleted_files_in_base.insert(name).second) {
 		if (create_on_disk) add_special_file_to_disk(name, "DEL");
-
 	}
 }
 
@@ -1132,11 +1232,7 @@ bool Overlay_Drive::is_dir_only_in_overlay(const char* name) {
 
 bool Overlay_Drive::is_deleted_file(const char* name) {
 	if (!name || !*name) return false;
-	if (deleted_files_in_base.empty()) return false;
-	for(std::vector<std::string>::iterator it = deleted_files_in_base.begin(); it != deleted_files_in_base.end(); ++it) {
-		if (*it == name) return true;
-	}
-	return false;
+	return deleted_files_in_base.count(name) > 0;
 }
 
 void Overlay_Drive::add_DOSdir_to_cache(const char* name) {
@@ -1157,12 +1253,8 @@ void Overlay_Drive::remove_DOSdir_from_cache(const char* name) {
 }
 
 void Overlay_Drive::remove_deleted_file(const char* name,bool create_on_disk) {
-	for(std::vector<std::string>::iterator it = deleted_files_in_base.begin(); it != deleted_files_in_base.end(); ++it) {
-		if (*it == name) {
-			deleted_files_in_base.erase(it);
-			if (create_on_disk) remove_special_file_from_disk(name, "DEL");
-			return;
-		}
+	if (deleted_files_in_base.erase(name) > 0) {
+		if (create_on_disk) remove_special_file_from_disk(name, "DEL");
 	}
 }
 void Overlay_Drive::add_deleted_path(const char* name, bool create_on_disk) {
@@ -0,0 +1,918 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "drives.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <list>
+#include <map>
+#include <optional>
+
+#include <zlib.h>
+
+#include "byteorder.h"
+#include "cross.h"
+#include "logging.h"
+#include "mem_unaligned.h"
+#include "string_utils.h"
+#include "support.h"
+
+constexpr uint32_t LocalHeaderSignature       = 0x04034b50;
+constexpr uint32_t CentralHeaderSignature     = 0x02014b50;
+constexpr uint32_t EndOfDirectorySignature    = 0x06054b50;
+constexpr uint32_t Zip64EndOfDirSignature     = 0x06064b50;
+constexpr uint32_t Zip64EndLocatorSignature   = 0x07064b50;
+constexpr uint16_t Zip64ExtraFieldId          = 0x0001;
+
+constexpr size_t LocalHeaderSize      = 30;
+constexpr size_t CentralHeaderSize    = 46;
+constexpr size_t EndOfDirectorySize   = 22;
+constexpr size_t Zip64EndOfDirSize    = 56;
+constexpr size_t Zip64EndLocatorSize  = 20;
+constexpr size_t MaxArchiveCommentSize = UINT16_MAX;
+
+constexpr uint16_t MethodStored   = 0;
+constexpr uint16_t MethodDeflated = 8;
+constexpr uint16_t FlagEncrypted  = 1 << 0;
+
+// Inflated files are kept until they add up to this many bytes; larger ones
+// are only held while they're open
+constexpr size_t MaxCachedBytes = 32 * 1024 * 1024;
+
+static uint16_t get_le16(const uint8_t* data)
+{
+	return le16_to_host(read_unaligned_uint16(data));
+}
+
+static uint32_t get_le32(const uint8_t* data)
+{
+	return le32_to_host(read_unaligned_uint32(data));
+}
+
+static uint64_t get_le64(const uint8_t* data)
+{
+	return le64_to_host(read_unaligned_uint64(data));
+}
+
+static bool read_at(FILE* file, const uint64_t offset, const size_t num_bytes,
+                    uint8_t* data)
+{
+	if (cross_fseeko(file, static_cast<off_t>(offset), SEEK_SET) != 0) {
+		return false;
+	}
+	return fread(data, 1, num_bytes, file) == num_bytes;
+}
+
+struct ZipEntry {
+	// The 8.3 name within its directory, and the path from the root
+	std::string name = {};
+	std::string path = {};
+
+	uint32_t parent = 0;
+	bool is_dir     = false;
+	uint16_t method = MethodStored;
+	uint16_t date   = 0;
+	uint16_t time   = 0;
+	uint32_t crc    = 0;
+	uint32_t size   = 0;
+
+	uint64_t compressed_size = 0;
+	uint64_t header_offset   = 0;
+
+	// Found from the local header when the file is first opened
+	uint64_t data_offset = 0;
+
+	std::vector<uint32_t> children = {};
+};
+
+using inflated_data_t = std::shared_ptr<const std::vector<uint8_t>>;
+
+/*
+ZipArchive Class
+~~~~~~~~~~~~~~~~
+The index of a ZIP archive. The central directory is read once and turned
+into a tree of DOS names, with long or otherwise invalid names shortened
+to unique 8.3 ones the way the directory cache does it, so lookups don't
+touch the archive at all.
+
+Stored files are read straight from the archive into the caller's buffer.
+Deflated files are inflated whole when first read, and the most recently
+used ones are kept so reopening them doesn't inflate them again.
+*/
+
+class ZipArchive {
+public:
+	static std::shared_ptr<ZipArchive> Open(const char* path);
+
+	ZipArchive(const ZipArchive&)            = delete; // prevent copying
+	ZipArchive& operator=(const ZipArchive&) = delete; // prevent assignment
+
+	~ZipArchive();
+
+	std::optional<uint32_t> Lookup(const char* dos_path) const;
+
+	const ZipEntry& GetEntry(const uint32_t index) const
+	{
+		return entries.at(index);
+	}
+
+	uint64_t GetTotalSize() const
+	{
+		return total_size;
+	}
+
+	// Finds where the file's data starts; it has to be called before
+	// reading the file
+	bool Prepare(uint32_t index);
+
+	bool ReadStored(uint32_t index, uint32_t pos, uint32_t num_bytes,
+	                uint8_t* data);
+	inflated_data_t Inflate(uint32_t index);
+
+private:
+	ZipArchive(FILE* file, uint64_t file_size);
+
+	bool ReadCentralDirectory();
+	bool ReadDirectoryEntries(const std::vector<uint8_t>& directory,
+	                          uint64_t num_entries);
+	void AddEntry(const std::string& long_path, const ZipEntry& entry);
+	std::optional<uint32_t> AddChild(uint32_t parent,
+	                                 const std::string& long_name,
+	                                 const ZipEntry& entry);
+	std::string MakeShortName(uint32_t parent,
+	                          const std::string& long_name) const;
+	std::string ChildPath(uint32_t parent, const std::string& name) const;
+
+	FILE* file         = nullptr;
+	uint64_t file_size = 0;
+
+	std::vector<ZipEntry> entries = {};
+	std::unordered_map<std::string, uint32_t> by_path = {};
+	std::map<std::pair<uint32_t, std::string>, uint32_t> by_long_name = {};
+	uint64_t total_size = 0;
+
+	struct CachedFile {
+		inflated_data_t data = {};
+		std::list<uint32_t>::iterator lru_pos = {};
+	};
+	std::unordered_map<uint32_t, CachedFile> cache = {};
+	std::list<uint32_t> lru  = {};
+	size_t cached_bytes      = 0;
+};
+
+std::shared_ptr<ZipArchive> ZipArchive::Open(const char* path)
+{
+	FILE* file = fopen(path, "rb");
+	if (!file) {
+		LOG_ERR("ZIP: Failed to open '%s': %s", path, strerror(errno));
+		return {};
+	}
+	if (cross_fseeko(file, 0, SEEK_END) != 0) {
+		fclose(file);
+		return {};
+	}
+	const auto file_size = cross_ftello(file);
+	if (file_size < 0) {
+		fclose(file);
+		return {};
+	}
+
+	std::shared_ptr<ZipArchive> archive(
+	        new ZipArchive(file, static_cast<uint64_t>(file_size)));
+	if (!archive->ReadCentralDirectory()) {
+		LOG_ERR("ZIP: '%s' isn't a valid ZIP archive", path);
+		return {};
+	}
+	LOG_MSG("ZIP: Indexed %d entries of '%s'",
+	        static_cast<int>(archive->entries.size() - 1),
+	        path);
+	return archive;
+}
+
+ZipArchive::ZipArchive(FILE* archive_file, const uint64_t archive_size)
+        : file(archive_file),
+          file_size(archive_size)
+{
+	// The root directory
+	entries.emplace_back().is_dir = true;
+	by_path[""]                   = 0;
+}
+
+ZipArchive::~ZipArchive()
+{
+	fclose(file);
+}
+
+bool ZipArchive::ReadCentralDirectory()
+{
+	// The end of central directory record is followed by a comment of up
+	// to 64 KB, so search backwards for its signature
+	constexpr uint64_t MaxTailSize = EndOfDirectorySize +
+	                                 MaxArchiveCommentSize;
+
+	const auto tail_size = std::min(file_size, MaxTailSize);
+	if (tail_size < EndOfDirectorySize) {
+		return false;
+	}
+	const auto tail_offset = file_size - tail_size;
+	std::vector<uint8_t> tail(tail_size);
+	if (!read_at(file, tail_offset, tail.size(), tail.data())) {
+		return false;
+	}
+	std::optional<size_t> end_pos = {};
+	for (auto pos = tail.size() - EndOfDirectorySize + 1; pos-- > 0;) {
+		if (get_le32(tail.data() + pos) == EndOfDirectorySignature) {
+			end_pos = pos;
+			break;
+		}
+	}
+	if (!end_pos) {
+		return false;
+	}
+
+	const auto record   = tail.data() + *end_pos;
+	uint64_t num_entries = get_le16(record + 10);
+	uint64_t dir_size    = get_le32(record + 12);
+	uint64_t dir_offset  = get_le32(record + 16);
+
+	// ZIP64 archives keep their real values in another record, found
+	// through the locator right before this one
+	if (num_entries == UINT16_MAX || dir_size == UINT32_MAX ||
+	    dir_offset == UINT32_MAX) {
+		const auto end_offset = tail_offset + *end_pos;
+		if (end_offset < Zip64EndLocatorSize) {
+			return false;
+		}
+		uint8_t locator[Zip64EndLocatorSize];
+		if (!read_at(file,
+		             end_offset - Zip64EndLocatorSize,
+		             sizeof(locator),
+		             locator) ||
+		    get_le32(locator) != Zip64EndLocatorSignature) {
+			return false;
+		}
+		uint8_t zip64_record[Zip64EndOfDirSize];
+		if (!read_at(file,
+		             get_le64(locator + 8),
+		             sizeof(zip64_record),
+		             zip64_record) ||
+		    get_le32(zip64_record) != Zip64EndOfDirSignature) {
+			return false;
+		}
+		num_entries = get_le64(zip64_record + 32);
+		dir_size    = get_le64(zip64_record + 40);
+		dir_offset  = get_le64(zip64_record + 48);
+	}
+	if (dir_offset > file_size || dir_size > file_size - dir_offset) {
+		return false;
+	}
+
+	std::vector<uint8_t> directory(dir_size);
+	if (!read_at(file, dir_offset, directory.size(), directory.data())) {
+		return false;
+	}
+	return ReadDirectoryEntries(directory, num_entries);
+}
+
+bool ZipArchive::ReadDirectoryEntries(const std::vector<uint8_t>& directory,
+                                      const uint64_t num_entries)
+{
+	int num_unsupported = 0;
+
+	size_t pos = 0;
+	for (uint64_t i = 0; i < num_entries; ++i) {
+		if (directory.size() - pos < CentralHeaderSize) {
+			return false;
+		}
+		const auto header = directory.data() + pos;
+		if (get_le32(header) != CentralHeaderSignature) {
+			return false;
+		}
+		const auto flags       = get_le16(header + 8);
+		const auto name_size   = get_le16(header + 28);
+		const auto extra_size  = get_le16(header + 30);
+		const auto comment_size = get_le16(header + 32);
+
+		const auto entry_size = CentralHeaderSize + name_size +
+		                        extra_size + comment_size;
+		if (directory.size() - pos < entry_size) {
+			return false;
+		}
+		pos += entry_size;
+
+		ZipEntry entry     = {};
+		entry.method       = get_le16(header + 10);
+		entry.time         = get_le16(header + 12);
+		entry.date         = get_le16(header + 14);
+		entry.crc          = get_le32(header + 16);
+		uint64_t size      = get_le32(header + 24);
+		entry.compressed_size = get_le32(header + 20);
+		entry.header_offset   = get_le32(header + 42);
+
+		// Values that don't fit are in the ZIP64 extra field, in this
+		// order, and only if they didn't fit
+		auto extra           = header + CentralHeaderSize + name_size;
+		const auto extra_end = extra + extra_size;
+		while (extra_end - extra >= 4) {
+			const auto id         = get_le16(extra);
+			const auto field_size = get_le16(extra + 2);
+			auto field            = extra + 4;
+			extra += 4 + field_size;
+			if (extra > extra_end || id != Zip64ExtraFieldId) {
+				continue;
+			}
+			auto read_field = [&](uint64_t& value) {
+				if (value == UINT32_MAX && extra - field >= 8) {
+					value = get_le64(field);
+					field += 8;
+				}
+			};
+			read_field(size);
+			read_field(entry.compressed_size);
+			read_field(entry.header_offset);
+		}
+
+		const std::string long_path(reinterpret_cast<const char*>(
+		                                    header + CentralHeaderSize),
+		                            name_size);
+		entry.is_dir = !long_path.empty() && (long_path.back() == '/' ||
+		                                      long_path.back() == '\\');
+
+		// DOS can't see files of 4 GB or more, and those can only be
+		// read if they're stored or deflated without encryption
+		const auto is_readable = !(flags & FlagEncrypted) &&
+		                         (entry.method == MethodStored ||
+		                          entry.method == MethodDeflated);
+		if (!entry.is_dir && (!is_readable || size > UINT32_MAX)) {
+			++num_unsupported;
+			continue;
+		}
+		entry.size = static_cast<uint32_t>(size);
+		AddEntry(long_path, entry);
+	}
+	if (num_unsupported) {
+		LOG_WARNING("ZIP: Skipped %d encrypted, too large, or "
+		            "unsupported compressed files",
+		            num_unsupported);
+	}
+	return true;
+}
+
+void ZipArchive::AddEntry(const std::string& long_path, const ZipEntry& entry)
+{
+	std::vector<std::string> names = {};
+	std::string name               = {};
+	for (const auto c : long_path + '/') {
+		if (c != '/' && c != '\\') {
+			name += c;
+			continue;
+		}
+		if (name == "..") {
+			// Nothing outside the archive's root can be reached
+			return;
+		}
+		if (!name.empty() && name != ".") {
+			names.push_back(name);
+		}
+		name.clear();
+	}
+	if (names.empty()) {
+		return;
+	}
+
+	// Directories leading to the entry don't need entries of their own
+	ZipEntry dir_entry = {};
+	dir_entry.is_dir   = true;
+	dir_entry.date     = entry.date;
+	dir_entry.time     = entry.time;
+
+	uint32_t parent = 0;
+	for (size_t i = 0; i + 1 < names.size(); ++i) {
+		const auto dir = AddChild(parent, names[i], dir_entry);
+		if (!dir) {
+			return;
+		}
+		parent = *dir;
+	}
+	AddChild(parent, names.back(), entry);
+}
+
+std::optional<uint32_t> ZipArchive::AddChild(const uint32_t parent,
+                                             const std::string& long_name,
+                                             const ZipEntry& entry)
+{
+	auto key = std::make_pair(parent, long_name);
+	upcase(key.second);
+
+	// Directories may be listed on their own after being implied by the
+	// files in them, anything else listed twice is ignored
+	if (const auto it = by_long_name.find(key); it != by_long_name.end()) {
+		const auto& existing = entries[it->second];
+		if (entry.is_dir && existing.is_dir) {
+			return it->second;
+		}
+		return {};
+	}
+
+	const auto name = MakeShortName(parent, long_name);
+	if (name.empty()) {
+		return {};
+	}
+	const auto index = static_cast<uint32_t>(entries.size());
+
+	auto& child  = entries.emplace_back(entry);
+	child.name   = name;
+	child.path   = ChildPath(parent, name);
+	child.parent = parent;
+
+	by_path[child.path] = index;
+	by_long_name[key]   = index;
+	entries[parent].children.push_back(index);
+
+	total_size += child.size;
+	return index;
+}
+
+std::string ZipArchive::MakeShortName(const uint32_t parent,
+                                      const std::string& long_name) const
+{
+	if (!filename_not_8x3(long_name.c_str())) {
+		auto name = long_name;
+		upcase(name);
+		if (!by_path.count(ChildPath(parent, name))) {
+			return name;
+		}
+	}
+	for (unsigned int num = 1;; ++num) {
+		const auto name = generate_8x3(long_name.c_str(), num, true);
+		if (name.empty() || !by_path.count(ChildPath(parent, name))) {
+			return name;
+		}
+	}
+}
+
+std::string ZipArchive::ChildPath(const uint32_t parent,
+                                  const std::string& name) const
+{
+	return parent ? entries[parent].path + '\\' + name : name;
+}
+
+std::optional<uint32_t> ZipArchive::Lookup(const char* dos_path) const
+{
+	assert(dos_path);
+	std::string path = dos_path;
+	upcase(path);
+	if (const auto it = by_path.find(path); it != by_path.end()) {
+		return it->second;
+	}
+	return {};
+}
+
+bool ZipArchive::Prepare(const uint32_t index)
+{
+	auto& entry = entries.at(index);
+	if (entry.data_offset) {
+		return true;
+	}
+	uint8_t header[LocalHeaderSize];
+	if (!read_at(file, entry.header_offset, sizeof(header), header) ||
+	    get_le32(header) != LocalHeaderSignature) {
+		LOG_WARNING("ZIP: The local header of '%s' is missing",
+		            entry.path.c_str());
+		return false;
+	}
+	// The local header's extra field can differ from the central one
+	const auto data_offset = entry.header_offset + LocalHeaderSize +
+	                         get_le16(header + 26) + get_le16(header + 28);
+	if (data_offset > file_size ||
+	    entry.compressed_size > file_size - data_offset) {
+		LOG_WARNING("ZIP: The data of '%s' is truncated",
+		            entry.path.c_str());
+		return false;
+	}
+	entry.data_offset = data_offset;
+	return true;
+}
+
+bool ZipArchive::ReadStored(const uint32_t index, const uint32_t pos,
+                            const uint32_t num_bytes, uint8_t* data)
+{
+	const auto& entry = entries.at(index);
+	assert(entry.method == MethodStored && entry.data_offset);
+	assert(static_cast<uint64_t>(pos) + num_bytes <= entry.size);
+	return read_at(file, entry.data_offset + pos, num_bytes, data);
+}
+
+inflated_data_t ZipArchive::Inflate(const uint32_t index)
+{
+	if (const auto it = cache.find(index); it != cache.end()) {
+		lru.splice(lru.begin(), lru, it->second.lru_pos);
+		return it->second.data;
+	}
+
+	const auto& entry = entries.at(index);
+	assert(entry.method == MethodDeflated && entry.data_offset);
+
+	auto data = std::make_shared<std::vector<uint8_t>>(entry.size);
+	if (entry.size) {
+		std::vector<uint8_t> compressed(entry.compressed_size);
+		if (!read_at(file,
+		             entry.data_offset,
+		             compressed.size(),
+		             compressed.data())) {
+			return {};
+		}
+
+		z_stream stream = {};
+		if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+			return {};
+		}
+		stream.next_in   = compressed.data();
+		stream.avail_in  = static_cast<uInt>(compressed.size());
+		stream.next_out  = data->data();
+		stream.avail_out = static_cast<uInt>(data->size());
+
+		const auto result     = inflate(&stream, Z_FINISH);
+		const auto num_output = stream.total_out;
+		inflateEnd(&stream);
+
+		const auto crc = crc32(0,
+		                       data->data(),
+		                       static_cast<uInt>(data->size()));
+		if (result != Z_STREAM_END || num_output != entry.size ||
+		    crc != entry.crc) {
+			LOG_WARNING("ZIP: Failed to inflate '%s'",
+			            entry.path.c_str());
+			return {};
+		}
+	}
+
+	if (entry.size <= MaxCachedBytes) {
+		while (cached_bytes + entry.size > MaxCachedBytes) {
+			const auto evicted = cache.find(lru.back());
+			cached_bytes -= evicted->second.data->size();
+			cache.erase(evicted);
+			lru.pop_back();
+		}
+		lru.push_front(index);
+		cache[index] = {data, lru.begin()};
+		cached_bytes += entry.size;
+	}
+	return data;
+}
+
+class zipFile final : public DOS_File {
+public:
+	zipFile(const std::shared_ptr<ZipArchive>& zip_archive, uint32_t index,
+	        const char* name);
+
+	zipFile(const zipFile&)            = delete; // prevent copying
+	zipFile& operator=(const zipFile&) = delete; // prevent assignment
+
+	bool Read(uint8_t* data, uint16_t* size) override;
+	bool Write(uint8_t* data, uint16_t* size) override;
+	bool Seek(uint32_t* pos, uint32_t type) override;
+	bool Close() override;
+	uint16_t GetInformation() override;
+
+private:
+	std::shared_ptr<ZipArchive> archive = {};
+	uint32_t index         = 0;
+	uint32_t file_pos      = 0;
+	uint32_t file_size     = 0;
+	inflated_data_t inflated = {};
+};
+
+zipFile::zipFile(const std::shared_ptr<ZipArchive>& zip_archive,
+                 const uint32_t entry_index, const char* name)
+        : archive(zip_archive),
+          index(entry_index)
+{
+	const auto& entry = archive->GetEntry(index);
+
+	SetName(name);
+	file_size = entry.size;
+	date      = entry.date;
+	time      = entry.time;
+	attr      = FatAttributeFlags::ReadOnly;
+	open      = true;
+}
+
+bool zipFile::Read(uint8_t* data, uint16_t* size)
+{
+	const auto remaining = file_size - std::min(file_pos, file_size);
+	const auto num_bytes = std::min<uint32_t>(*size, remaining);
+	if (!num_bytes) {
+		*size = 0;
+		return true;
+	}
+
+	if (archive->GetEntry(index).method == MethodStored) {
+		if (!archive->ReadStored(index, file_pos, num_bytes, data)) {
+			*size = 0;
+			DOS_SetError(DOSERR_ACCESS_DENIED);
+			return false;
+		}
+	} else {
+		if (!inflated) {
+			inflated = archive->Inflate(index);
+		}
+		if (!inflated) {
+			*size = 0;
+			DOS_SetError(DOSERR_ACCESS_DENIED);
+			return false;
+		}
+		memcpy(data, inflated->data() + file_pos, num_bytes);
+	}
+	file_pos += num_bytes;
+	*size = static_cast<uint16_t>(num_bytes);
+	return true;
+}
+
+bool zipFile::Write(uint8_t* /*data*/, uint16_t* /*size*/)
+{
+	DOS_SetError(DOSERR_ACCESS_DENIED);
+	return false;
+}
+
+bool zipFile::Seek(uint32_t* pos, uint32_t type)
+{
+	// Offsets are signed, positions before the start end up at the end
+	// like on the other read-only drives
+	int64_t new_pos = static_cast<int32_t>(*pos);
+	switch (type) {
+	case DOS_SEEK_SET: new_pos = *pos; break;
+	case DOS_SEEK_CUR: new_pos += file_pos; break;
+	case DOS_SEEK_END: new_pos += file_size; break;
+	default: return false;
+	}
+	if (new_pos < 0 || new_pos > file_size) {
+		new_pos = file_size;
+	}
+	file_pos = static_cast<uint32_t>(new_pos);
+	*pos     = file_pos;
+	return true;
+}
+
+bool zipFile::Close()
+{
+	if (refCtr == 1) {
+		open = false;
+		inflated.reset();
+	}
+	return true;
+}
+
+uint16_t zipFile::GetInformation()
+{
+	return 0x40; // read-only drive
+}
+
+zipDrive::zipDrive(const char* archive_path, const uint8_t media_id, int& error)
+        : archive(ZipArchive::Open(archive_path)),
+          searches(MAX_OPENDIRS),
+          mediaid(media_id)
+{
+	type = DosDriveType::Zip;
+	safe_strcpy(info, archive_path);
+	error = archive ? 0 : 1;
+}
+
+bool zipDrive::FileOpen(DOS_File** file, char* name, uint32_t flags)
+{
+	if ((flags & 0x0f) == OPEN_WRITE) {
+		DOS_SetError(DOSERR_ACCESS_DENIED);
+		return false;
+	}
+	const auto index = archive->Lookup(name);
+	if (!index || archive->GetEntry(*index).is_dir) {
+		DOS_SetError(DOSERR_FILE_NOT_FOUND);
+		return false;
+	}
+	if (!archive->Prepare(*index)) {
+		DOS_SetError(DOSERR_ACCESS_DENIED);
+		return false;
+	}
+	*file          = new zipFile(archive, *index, name);
+	(*file)->flags = flags;
+	return true;
+}
+
+bool zipDrive::FileCreate(DOS_File** /*file*/, char* /*name*/,
+                          FatAttributeFlags /*attributes*/)
+{
+	DOS_SetError(DOSERR_ACCESS_DENIED);
+	return false;
+}
+
+bool zipDrive::FileUnlink(char* /*name*/)
+{
+	DOS_SetError(DOSERR_ACCESS_DENIED);
+	return false;
+}
+
+bool zipDrive::RemoveDir(char* /*dir*/)
+{
+	DOS_SetError(DOSERR_ACCESS_DENIED);
+	return false;
+}
+
+bool zipDrive::MakeDir(char* /*dir*/)
+{
+	DOS_SetError(DOSERR_ACCESS_DENIED);
+	return false;
+}
+
+bool zipDrive::TestDir(char* dir)
+{
+	const auto index = archive->Lookup(dir);
+	return index && archive->GetEntry(*index).is_dir;
+}
+
+// The root has no "." and ".." entries
+constexpr uint32_t NumDotEntries = 2;
+
+bool zipDrive::FindFirst(char* dir, DOS_DTA& dta, bool fcb_findfirst)
+{
+	const auto index = archive->Lookup(dir);
+	if (!index || !archive->GetEntry(*index).is_dir) {
+		DOS_SetError(DOSERR_PATH_NOT_FOUND);
+		return false;
+	}
+	const auto is_root = (*index == 0);
+
+	// The searches are reused round-robin like the ISO drive's iterators
+	const auto search_id = next_search;
+	next_search          = (next_search + 1) % MAX_OPENDIRS;
+	searches[search_id]  = {*index, is_root ? NumDotEntries : 0};
+	dta.SetDirID(search_id);
+
+	FatAttributeFlags attr = {};
+	char pattern[DOS_NAMELENGTH_ASCII];
+	dta.GetSearchParams(attr, pattern);
+
+	if (attr == FatAttributeFlags::Volume) {
+		dta.SetResult(GetLabel(), 0, 0, 0, FatAttributeFlags::Volume);
+		return true;
+	} else if (attr.volume && is_root && !fcb_findfirst) {
+		if (WildFileCmp(GetLabel(), pattern)) {
+			dta.SetResult(GetLabel(),
+			              0,
+			              0,
+			              0,
+			              FatAttributeFlags::Volume);
+			return true;
+		}
+	}
+	return FindNext(dta);
+}
+
+bool zipDrive::FindNext(DOS_DTA& dta)
+{
+	FatAttributeFlags attr = {};
+	char pattern[DOS_NAMELENGTH_ASCII];
+	dta.GetSearchParams(attr, pattern);
+
+	auto& search    = searches.at(dta.GetDirID());
+	const auto& dir = archive->GetEntry(search.dir);
+
+	while (search.pos < NumDotEntries + dir.children.size()) {
+		const auto pos = search.pos++;
+		if (pos < NumDotEntries) {
+			const auto name = (pos == 0) ? "." : "..";
+			if (attr.directory && WildFileCmp(name, pattern)) {
+				dta.SetResult(name,
+				              0,
+				              dir.date,
+				              dir.time,
+				              FatAttributeFlags::Directory);
+				return true;
+			}
+			continue;
+		}
+		const auto child  = dir.children[pos - NumDotEntries];
+		const auto& entry = archive->GetEntry(child);
+		if ((entry.is_dir && !attr.directory) ||
+		    !WildFileCmp(entry.name.c_str(), pattern)) {
+			continue;
+		}
+		FatAttributeFlags found_attr = {FatAttributeFlags::ReadOnly};
+		found_attr.directory         = entry.is_dir;
+		dta.SetResult(entry.name.c_str(),
+		              entry.size,
+		              entry.date,
+		              entry.time,
+		              found_attr);
+		return true;
+	}
+	DOS_SetError(DOSERR_NO_MORE_FILES);
+	return false;
+}
+
+bool zipDrive::GetFileAttr(char* name, FatAttributeFlags* attr)
+{
+	*attr            = {};
+	const auto index = archive->Lookup(name);
+	if (!index) {
+		return false;
+	}
+	attr->read_only = true;
+	attr->directory = archive->GetEntry(*index).is_dir;
+	return true;
+}
+
+bool zipDrive::SetFileAttr(const char* name,
+                           [[maybe_unused]] const FatAttributeFlags attr)
+{
+	DOS_SetError(archive->Lookup(name) ? DOSERR_ACCESS_DENIED
+	                                   : DOSERR_FILE_NOT_FOUND);
+	return false;
+}
+
+bool zipDrive::Rename(char* /*oldname*/, char* /*newname*/)
+{
+	DOS_SetError(DOSERR_ACCESS_DENIED);
+	return false;
+}
+
+bool zipDrive::AllocationInfo(uint16_t* bytes_sector, uint8_t* sectors_cluster,
+                              uint16_t* total_clusters, uint16_t* free_clusters)
+{
+	constexpr uint16_t BytesPerSector   = 512;
+	constexpr uint8_t SectorsPerCluster = 32;
+	constexpr uint32_t ClusterSize = BytesPerSector * SectorsPerCluster;
+
+	// Report the unpacked size, with nothing free
+	const auto num_clusters = archive->GetTotalSize() / ClusterSize + 1;
+
+	*bytes_sector    = BytesPerSector;
+	*sectors_cluster = SectorsPerCluster;
+	*total_clusters  = static_cast<uint16_t>(
+                std::min(num_clusters, static_cast<uint64_t>(UINT16_MAX - 1)));
+	*free_clusters   = 0;
+	return true;
+}
+
+bool zipDrive::FileExists(const char* name)
+{
+	const auto index = archive->Lookup(name);
+	return index && !archive->GetEntry(*index).is_dir;
+}
+
+bool zipDrive::FileStat(const char* name, FileStat_Block* const stat_block)
+{
+	const auto index = archive->Lookup(name);
+	if (!index) {
+		return false;
+	}
+	const auto& entry = archive->GetEntry(*index);
+
+	FatAttributeFlags attr = {FatAttributeFlags::ReadOnly};
+	attr.directory         = entry.is_dir;
+
+	stat_block->size = entry.size;
+	stat_block->date = entry.date;
+	stat_block->time = entry.time;
+	stat_block->attr = attr._data;
+	return true;
+}
+
+uint8_t zipDrive::GetMediaByte()
+{
+	return mediaid;
+}
+
+bool zipDrive::isRemote()
+{
+	return false;
+}
+
+bool zipDrive::isRemovable()
+{
+	return false;
+}
+
+Bits zipDrive::UnMount()
+{
+	return 0;
+}
@@ -0,0 +1,305 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "host_dir_prefetcher.h"
+
+#include <deque>
+#include <utility>
+
+#include "cross.h"
+#include "logging.h"
+#include "support.h"
+
+#if defined(LINUX)
+#include <cerrno>
+#include <dirent.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+std::unique_ptr<HostDirPrefetcher> HostDirPrefetcher::Start(const std::string& base_dir)
+{
+#if defined(LINUX)
+	const int watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (watch_fd < 0) {
+		LOG_WARNING("DOS: Can't follow the changes to '%s', not prefetching it",
+		            base_dir.c_str());
+		return {};
+	}
+	auto dir = base_dir;
+	if (dir.empty() || dir.back() != CROSS_FILESPLIT) {
+		dir += CROSS_FILESPLIT;
+	}
+
+	// The constructor is private, so this can't use make_unique
+	std::unique_ptr<HostDirPrefetcher> prefetcher(
+	        new HostDirPrefetcher(dir, watch_fd));
+
+	prefetcher->thread = std::thread(&HostDirPrefetcher::Run, prefetcher.get());
+	set_thread_name(prefetcher->thread, "dosbox:dirfetch");
+	return prefetcher;
+#else
+	(void)base_dir;
+	return {};
+#endif
+}
+
+HostDirPrefetcher::HostDirPrefetcher(const std::string& _base_dir, const int _watch_fd)
+        : base_dir(_base_dir),
+          watch_fd(_watch_fd)
+{}
+
+HostDirPrefetcher::~HostDirPrefetcher()
+{
+	should_stop = true;
+	if (thread.joinable()) {
+		thread.join();
+	}
+#if defined(LINUX)
+	close(watch_fd);
+#endif
+}
+
+std::optional<HostDirPrefetcher::Listing> HostDirPrefetcher::TakeListing(const std::string& dir)
+{
+	const std::lock_guard lock(mutex);
+
+	const auto it = listings.find(dir);
+	if (it == listings.end()) {
+		return {};
+	}
+	auto listing = std::move(it->second);
+	listings.erase(it);
+	return listing;
+}
+
+std::vector<HostDirPrefetcher::Change> HostDirPrefetcher::TakeChanges()
+{
+	const std::lock_guard lock(mutex);
+
+	has_changes = false;
+	return std::exchange(changes, {});
+}
+
+void HostDirPrefetcher::DropListings()
+{
+	const std::lock_guard lock(mutex);
+	listings.clear();
+}
+
+void HostDirPrefetcher::QueueChange(Change&& change)
+{
+	const std::lock_guard lock(mutex);
+
+	listings.erase(change.dir);
+	changes.emplace_back(std::move(change));
+	has_changes = true;
+}
+
+#if defined(LINUX)
+
+constexpr uint32_t WatchedEvents = IN_CREATE | IN_DELETE | IN_MOVED_FROM |
+                                   IN_MOVED_TO | IN_ONLYDIR;
+
+// How often the thread checks if it should stop once the tree has been read
+constexpr int PollIntervalMs = 200;
+
+void HostDirPrefetcher::Run()
+{
+	// Breadth-first, so the directories closest to the root, which DOS
+	// programs look into first, are ready soonest
+	std::deque<std::string> pending = {base_dir};
+	std::vector<std::string> subdirs = {};
+
+	while (!pending.empty() && !should_stop) {
+		const auto dir = std::move(pending.front());
+		pending.pop_front();
+
+		subdirs.clear();
+		const auto keep_going = WatchAndList(dir, subdirs);
+		for (auto& subdir : subdirs) {
+			pending.emplace_back(std::move(subdir));
+		}
+		if (!keep_going) {
+			break;
+		}
+
+		// Keep up with the changes made while the tree is being read
+		ReadEvents(0);
+	}
+
+	while (!should_stop) {
+		ReadEvents(PollIntervalMs);
+	}
+}
+
+bool HostDirPrefetcher::WatchAndList(const std::string& dir,
+                                     std::vector<std::string>& subdirs)
+{
+	// Watching first means nothing that changes while the directory is
+	// read goes unnoticed
+	const int wd = inotify_add_watch(watch_fd, dir.c_str(), WatchedEvents);
+	if (wd < 0) {
+		if (errno == ENOSPC) {
+			LOG_WARNING("DOS: Ran out of inotify watches, stopped prefetching '%s'",
+			            base_dir.c_str());
+			return false;
+		}
+		// DOS reports what's wrong with the directory when it gets there
+		return true;
+	}
+	watched_dirs[wd] = dir;
+
+	const auto dirp = opendir(dir.c_str());
+	if (!dirp) {
+		return true;
+	}
+
+	Listing listing = {};
+	while (const auto dentry = readdir(dirp)) {
+		Entry entry = {dentry->d_name, dentry->d_type == DT_DIR};
+
+		// Links are followed like read_directory_next() does, but only
+		// real directories are walked into so links can't make loops
+		auto is_real_dir = entry.is_directory;
+		if (dentry->d_type != DT_DIR && dentry->d_type != DT_REG) {
+			const auto path = dir + entry.name;
+			struct stat status;
+			entry.is_directory = stat(path.c_str(), &status) == 0 &&
+			                     S_ISDIR(status.st_mode);
+			is_real_dir = dentry->d_type == DT_UNKNOWN &&
+			              entry.is_directory &&
+			              lstat(path.c_str(), &status) == 0 &&
+			              S_ISDIR(status.st_mode);
+		}
+		if (is_real_dir && entry.name != "." && entry.name != "..") {
+			subdirs.emplace_back(dir + entry.name + CROSS_FILESPLIT);
+		}
+		listing.emplace_back(std::move(entry));
+	}
+	closedir(dirp);
+
+	num_entries += listing.size();
+	{
+		const std::lock_guard lock(mutex);
+		listings[dir] = std::move(listing);
+	}
+
+	if (num_entries >= MaxEntries) {
+		LOG_MSG("DOS: Prefetched %zu entries of '%s', reading the rest on demand",
+		        num_entries,
+		        base_dir.c_str());
+		return false;
+	}
+	return true;
+}
+
+void HostDirPrefetcher::ReadEvents(const int timeout_ms)
+{
+	pollfd poll_fd = {watch_fd, POLLIN, 0};
+	if (poll(&poll_fd, 1, timeout_ms) <= 0) {
+		return;
+	}
+
+	alignas(inotify_event) char buffer[16 * 1024];
+	ssize_t num_bytes = 0;
+	while ((num_bytes = read(watch_fd, buffer, sizeof(buffer))) > 0) {
+		for (auto pos = buffer; pos < buffer + num_bytes;) {
+			const auto event = reinterpret_cast<const inotify_event*>(pos);
+			HandleEvent(*event);
+			pos += sizeof(inotify_event) + event->len;
+		}
+	}
+}
+
+void HostDirPrefetcher::HandleEvent(const inotify_event& event)
+{
+	if (event.mask & IN_Q_OVERFLOW) {
+		LOG_MSG("DOS: Missed changes to '%s', reading it again",
+		        base_dir.c_str());
+		DropListings();
+		QueueChange({ChangeType::Rescan});
+		return;
+	}
+
+	const auto it = watched_dirs.find(event.wd);
+	if (it == watched_dirs.end()) {
+		return;
+	}
+	if (event.mask & IN_IGNORED) {
+		watched_dirs.erase(it);
+		return;
+	}
+	if (event.len == 0) {
+		return;
+	}
+
+	Change change = {};
+	change.dir          = it->second;
+	change.name         = event.name;
+	change.is_directory = event.mask & IN_ISDIR;
+
+	const auto path = change.dir + change.name + CROSS_FILESPLIT;
+	if (event.mask & (IN_CREATE | IN_MOVED_TO)) {
+		change.type = ChangeType::Added;
+
+		// New directories are read when DOS gets there, but what
+		// happens inside them is followed from now on
+		if (change.is_directory) {
+			Watch(path);
+		}
+	} else {
+		change.type = ChangeType::Removed;
+		if (change.is_directory) {
+			ForgetWatches(path);
+		}
+	}
+	QueueChange(std::move(change));
+}
+
+void HostDirPrefetcher::Watch(const std::string& dir)
+{
+	const int wd = inotify_add_watch(watch_fd, dir.c_str(), WatchedEvents);
+	if (wd >= 0) {
+		watched_dirs[wd] = dir;
+	}
+}
+
+// Stops watching a directory that's gone and everything below it, as the
+// watches would otherwise report the changes under the old paths
+void HostDirPrefetcher::ForgetWatches(const std::string& dir)
+{
+	for (auto it = watched_dirs.begin(); it != watched_dirs.end();) {
+		if (it->second.compare(0, dir.size(), dir) != 0) {
+			++it;
+			continue;
+		}
+		inotify_rm_watch(watch_fd, it->first);
+		{
+			const std::lock_guard lock(mutex);
+			listings.erase(it->second);
+		}
+		it = watched_dirs.erase(it);
+	}
+}
+
+#endif
@@ -0,0 +1,122 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_HOST_DIR_PREFETCHER_H
+#define DOSBOX_HOST_DIR_PREFETCHER_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/*
+HostDirPrefetcher Class
+~~~~~~~~~~~~~~~~~~~~~~~
+Reads the directory tree of a mounted host directory on its own thread, so
+the drive cache can take the listings instead of reading each directory when
+a DOS program first looks into it. Every directory is watched before it's
+listed, and the changes made on the host afterwards are queued up for the
+drive cache to apply; a listing that changed is dropped rather than patched.
+
+Only directories that can be watched are listed, as a listing that can't be
+kept up to date would be staler than reading the directory later. This needs
+inotify, so on other hosts Start() returns nothing.
+
+Usage:
+ 1. Start() with the host path of the mount, ending in a separator.
+ 2. TakeListing() before reading a directory from the host.
+ 3. Poll HasChanges() and apply what TakeChanges() returns.
+*/
+
+class HostDirPrefetcher {
+public:
+	struct Entry {
+		std::string name  = {};
+		bool is_directory = false;
+	};
+	using Listing = std::vector<Entry>;
+
+	enum class ChangeType {
+		Added,
+		Removed,
+		// Events were lost, everything has to be read again
+		Rescan,
+	};
+
+	struct Change {
+		ChangeType type   = ChangeType::Added;
+		std::string dir   = {};
+		std::string name  = {};
+		bool is_directory = false;
+	};
+
+	static std::unique_ptr<HostDirPrefetcher> Start(const std::string& base_dir);
+
+	HostDirPrefetcher(const HostDirPrefetcher&)            = delete;
+	HostDirPrefetcher& operator=(const HostDirPrefetcher&) = delete;
+	~HostDirPrefetcher();
+
+	// Hands over the listing of the directory (as a host path ending in a
+	// separator) if it was read and hasn't changed since
+	std::optional<Listing> TakeListing(const std::string& dir);
+
+	bool HasChanges() const
+	{
+		return has_changes;
+	}
+
+	std::vector<Change> TakeChanges();
+
+	void DropListings();
+
+private:
+	HostDirPrefetcher(const std::string& base_dir, int watch_fd);
+
+	void Run();
+	bool WatchAndList(const std::string& dir, std::vector<std::string>& subdirs);
+	void ReadEvents(int timeout_ms);
+	void HandleEvent(const struct inotify_event& event);
+	void Watch(const std::string& dir);
+	void ForgetWatches(const std::string& dir);
+	void QueueChange(Change&& change);
+
+	// Keeps the memory bounded on huge trees
+	static constexpr size_t MaxEntries = 500'000;
+
+	const std::string base_dir;
+	const int watch_fd;
+	std::thread thread = {};
+	std::atomic<bool> should_stop = false;
+	std::atomic<bool> has_changes = false;
+
+	std::mutex mutex = {};
+	std::unordered_map<std::string, Listing> listings = {};
+	std::vector<Change> changes = {};
+
+	// Only used by the thread
+	std::unordered_map<int, std::string> watched_dirs = {};
+	size_t num_entries = 0;
+};
+
+#endif
@@ -28,6 +28,7 @@
 #include "../ints/int10.h"
 #include "bios_disk.h"
 #include "cdrom.h"
+#include "compressed_image.h"
 #include "control.h"
 #include "cross.h"
 #include "drives.h"
@@ -39,6 +40,74 @@
 #include "shell.h"
 #include "string_utils.h"
 
+// The image behind a drive number, or behind a drive letter with a FAT image
+// mounted, which is also returned
+static imageDisk* get_image_disk(const char drive_id, fatDrive** fat_drive)
+{
+	*fat_drive = nullptr;
+	if (drive_id >= '0' && drive_id < '0' + MAX_DISK_IMAGES) {
+		return imageDiskList.at(drive_id - '0');
+	}
+	if (drive_id < 'A' || drive_id > 'Z') {
+		return nullptr;
+	}
+	*fat_drive = dynamic_cast<fatDrive*>(Drives.at(drive_index(drive_id)));
+	return *fat_drive ? (*fat_drive)->loadedDisk.get() : nullptr;
+}
+
+void IMGMOUNT::TakeSnapshot(const char drive_id)
+{
+	fatDrive* fat_drive = nullptr;
+	const auto disk     = get_image_disk(drive_id, &fat_drive);
+	if (!disk || !disk->HasDeltas()) {
+		WriteOut(MSG_Get("PROGRAM_IMGMOUNT_NO_DELTA"), drive_id);
+		return;
+	}
+	if (!disk->TakeSnapshot()) {
+		WriteOut(MSG_Get("PROGRAM_IMGMOUNT_DELTA_FAILED"), drive_id);
+		return;
+	}
+	WriteOut(MSG_Get("PROGRAM_IMGMOUNT_SNAPSHOT_TAKEN"),
+	         static_cast<int>(disk->GetNumSnapshots()),
+	         drive_id);
+}
+
+void IMGMOUNT::RollBack(const char drive_id)
+{
+	fatDrive* fat_drive = nullptr;
+	const auto disk     = get_image_disk(drive_id, &fat_drive);
+	if (!disk || !disk->HasDeltas()) {
+		WriteOut(MSG_Get("PROGRAM_IMGMOUNT_NO_DELTA"), drive_id);
+		return;
+	}
+	// Open files would point to clusters of the files as they are now
+	if (fat_drive) {
+		const auto drive_num = drive_index(drive_id);
+		for (const auto file : Files) {
+			if (file && file->IsOpen() && file->GetDrive() == drive_num) {
+				WriteOut(MSG_Get("PROGRAM_IMGMOUNT_FILES_OPEN"),
+				         drive_id);
+				return;
+			}
+		}
+	}
+	const auto is_rolled_back = disk->RollBack();
+	if (fat_drive) {
+		fat_drive->DiscardDecodedFat();
+	}
+	if (!is_rolled_back) {
+		WriteOut(MSG_Get("PROGRAM_IMGMOUNT_DELTA_FAILED"), drive_id);
+		return;
+	}
+	if (disk->GetNumSnapshots() == 0) {
+		WriteOut(MSG_Get("PROGRAM_IMGMOUNT_ROLLED_BACK_TO_IMAGE"), drive_id);
+	} else {
+		WriteOut(MSG_Get("PROGRAM_IMGMOUNT_ROLLED_BACK"),
+		         drive_id,
+		         static_cast<int>(disk->GetNumSnapshots()));
+	}
+}
+
 void IMGMOUNT::ListImgMounts(void)
 {
 	const std::string header_drive = MSG_Get("PROGRAM_MOUNT_STATUS_DRIVE");
@@ -169,6 +238,15 @@ void IMGMOUNT::Run(void)
 		WriteOut(UnmountHelper(umount[0]), toupper(umount[0]));
 		return;
 	}
+	std::string snapshot_drive = {};
+	if (cmd->FindString("-snapshot", snapshot_drive, false)) {
+		TakeSnapshot(int_to_char(toupper(snapshot_drive[0])));
+		return;
+	}
+	if (cmd->FindString("-rollback", snapshot_drive, false)) {
+		RollBack(int_to_char(toupper(snapshot_drive[0])));
+		return;
+	}
 
 	std::string type   = "hdd";
 	std::string fstype = "fat";
@@ -180,6 +258,11 @@ void IMGMOUNT::Run(void)
 		roflag = true;
 	}
 
+	std::string delta_filename = {};
+	if (cmd->FindString("-delta", delta_filename, true)) {
+		delta_filename = resolve_home(delta_filename).string();
+	}
+
 	// Types 'cdrom' and 'iso' are synonyms. Name 'cdrom' is easier
 	// to remember and makes more sense, while name 'iso' is
 	// required for backwards compatibility and for users conflating
@@ -368,6 +451,11 @@ void IMGMOUNT::Run(void)
 		temp_line = paths[0];
 	}
 
+	if (!delta_filename.empty() && (paths.size() > 1 || fstype == "iso")) {
+		WriteOut(MSG_Get("PROGRAM_IMGMOUNT_DELTA_UNSUPPORTED"));
+		return;
+	}
+
 	auto write_out_mount_status = [this](const char* image_type,
 	                                     const std::vector<std::string>& images,
 	                                     const char drive_letter) {
@@ -392,21 +480,30 @@ void IMGMOUNT::Run(void)
 				WriteOut(MSG_Get("PROGRAM_IMGMOUNT_INVALID_IMAGE"));
 				return;
 			}
-			const auto sz = stdio_num_sectors(diskfile);
+			const auto sz = image_file_size_bytes(diskfile);
 			if (sz < 0) {
 				fclose(diskfile);
 				WriteOut(MSG_Get("PROGRAM_IMGMOUNT_INVALID_IMAGE"));
 				return;
 			}
-			uint32_t fcsize = check_cast<uint32_t>(sz);
+			uint32_t fcsize = check_cast<uint32_t>(sz / 512);
 			uint8_t buf[512];
-			if (cross_fseeko(diskfile, 0L, SEEK_SET) != 0 || 
-				fread(buf, sizeof(uint8_t), 512, diskfile) < 512) {
-				fclose(diskfile);
+			bool is_read = false;
+			if (CompressedImage::IsCompressed(diskfile)) {
+				const auto image = CompressedImage::Open(
+				        temp_line);
+				is_read = image &&
+				          image->Read(0, sizeof(buf), buf) == sizeof(buf);
+			} else {
+				is_read = !cross_fseeko(diskfile, 0L, SEEK_SET) &&
+				          fread(buf, 1, sizeof(buf), diskfile) ==
+				                  sizeof(buf);
+			}
+			fclose(diskfile);
+			if (!is_read) {
 				WriteOut(MSG_Get("PROGRAM_IMGMOUNT_INVALID_IMAGE"));
 				return;
 			}
-			fclose(diskfile);
 			if ((buf[510] != 0x55) || (buf[511] != 0xaa)) {
 				WriteOut(MSG_Get("PROGRAM_IMGMOUNT_INVALID_GEOMETRY"));
 				return;
@@ -441,7 +538,8 @@ void IMGMOUNT::Run(void)
 			                                            sizes[1],
 			                                            sizes[2],
 			                                            sizes[3],
-			                                            roflag);
+			                                            roflag,
+			                                            delta_filename);
 			if (fat_image->created_successfully) {
 				fat_images.emplace_back(std::move(fat_image));
 			} else {
@@ -564,12 +662,16 @@ void IMGMOUNT::Run(void)
 		write_out_mount_status(MSG_Get("MOUNT_TYPE_ISO"), paths, drive);
 
 	} else if (fstype == "none") {
+		// The writes go to the delta, so the image itself is only read
+		if (!delta_filename.empty()) {
+			roflag = true;
+		}
 		FILE* new_disk = fopen_wrap_ro_fallback(temp_line, roflag);
 		if (!new_disk) {
 			WriteOut(MSG_Get("PROGRAM_IMGMOUNT_INVALID_IMAGE"));
 			return;
 		}
-		const auto sz = stdio_size_kb(new_disk);
+		const auto sz = image_file_size_kb(new_disk);
 		if (sz < 0) {
 			fclose(new_disk);
 			WriteOut(MSG_Get("PROGRAM_IMGMOUNT_INVALID_IMAGE"));
@@ -595,6 +697,14 @@ void IMGMOUNT::Run(void)
 			        ->Set_Geometry(sizes[2], sizes[3], sizes[1], sizes[0]);
 		}
 
+		if (!delta_filename.empty() &&
+		    !imageDiskList.at(drive_index)->AttachDeltas(delta_filename)) {
+			DriveManager::CloseNumberedImage(imageDiskList.at(drive_index));
+			imageDiskList.at(drive_index) = nullptr;
+			WriteOut(MSG_Get("PROGRAM_IMGMOUNT_CANT_CREATE"));
+			return;
+		}
+
 		if ((drive == '2' || drive == '3') && is_hdd) {
 			updateDPT();
 		}
@@ -621,6 +731,7 @@ void IMGMOUNT::AddMessages()
 	        "  [color=light-green]imgmount[reset] [color=white]DRIVE[reset] [color=light-cyan]IMAGEFILE[reset] [IMAGEFILE2 [..]] [-fs fat] -t hdd|floppy -ro\n"
 	        "  [color=light-green]imgmount[reset] [color=white]DRIVE[reset] [color=light-cyan]BOOTIMAGE[reset] [-fs fat|none] -t hdd -size GEOMETRY -ro\n"
 	        "  [color=light-green]imgmount[reset] -u [color=white]DRIVE[reset]  (unmounts the [color=white]DRIVE[reset]'s image)\n"
+	        "  [color=light-green]imgmount[reset] -snapshot|-rollback [color=white]DRIVE[reset]  (for images mounted with -delta)\n"
 	        "\n"
 	        "Parameters:\n"
 	        "  [color=white]DRIVE[reset]      drive letter where the image will be mounted: A, C, D, ...\n"
@@ -634,6 +745,11 @@ void IMGMOUNT::AddMessages()
 			"      [color=light-green]imgmount[reset] [color=white]A[reset] [color=light-cyan]floppy*.img[reset] -t floppy\n"
 	        "  - [color=yellow]%s+F4[reset] swaps & mounts the next [color=light-cyan]CDROM-SET[reset] or [color=light-cyan]BOOTIMAGE[reset], if provided.\n"
 	        "  - The -ro flag mounts the disk image in read-only (write-protected) mode.\n"
+	        "  - The -delta FILE option leaves the image untouched and keeps the changes in\n"
+	        "    FILE instead. -snapshot saves the changes so far, -rollback discards the\n"
+	        "    changes since the last snapshot (or all of them, without snapshots).\n"
+	        "  - Images compressed with bgzip (BGZF) are read directly. They're read-only\n"
+	        "    unless the changes go to a -delta FILE.\n"
 	        "  - The -ide flag emulates an IDE controller with attached IDE CD drive, useful\n"
 	        "    for CD-based games that need a real DOS environment via bootable HDD image.\n"
 	        "\n"
@@ -696,6 +812,27 @@ void IMGMOUNT::AddMessages()
 	MSG_Add("PROGRAM_IMGMOUNT_CANT_CREATE", "Can't create drive from file.\n");
 	MSG_Add("PROGRAM_IMGMOUNT_MOUNT_NUMBER", "Drive number %d mounted as %s.\n");
 
+	MSG_Add("PROGRAM_IMGMOUNT_DELTA_UNSUPPORTED",
+	        "A delta file can only be used with a single hard drive or floppy image.\n");
+
+	MSG_Add("PROGRAM_IMGMOUNT_NO_DELTA",
+	        "Drive %c has no image mounted with a delta file.\n");
+
+	MSG_Add("PROGRAM_IMGMOUNT_DELTA_FAILED",
+	        "Could not update the delta files of drive %c.\n");
+
+	MSG_Add("PROGRAM_IMGMOUNT_FILES_OPEN",
+	        "Close the open files on drive %c before rolling it back.\n");
+
+	MSG_Add("PROGRAM_IMGMOUNT_SNAPSHOT_TAKEN",
+	        "Took snapshot %d of drive %c.\n");
+
+	MSG_Add("PROGRAM_IMGMOUNT_ROLLED_BACK",
+	        "Rolled drive %c back to snapshot %d.\n");
+
+	MSG_Add("PROGRAM_IMGMOUNT_ROLLED_BACK_TO_IMAGE",
+	        "Rolled drive %c back to its image.\n");
+
 	MSG_Add("PROGRAM_IMGMOUNT_NON_LOCAL_DRIVE",
 	        "The image must be on a host or local drive.\n");
 }
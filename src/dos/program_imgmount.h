@@ -39,6 +39,8 @@ public:
 
     private:
         static void AddMessages();
+	void TakeSnapshot(char drive_id);
+	void RollBack(char drive_id);
 };
 
 #endif // DOSBOX_PROGRAM_IMGMOUNT_H
@@ -20,6 +20,7 @@
 
 #include "program_mixer.h"
 
+#include <algorithm>
 #include <cctype>
 #include <optional>
 
@@ -744,6 +745,10 @@ void MIXER::Run()
 		MIDI_ListAll(this);
 		return;
 	}
+	if (cmd->FindExist("/STATS")) {
+		ShowMixerStats();
+		return;
+	}
 
 	constexpr auto remove = true;
 	auto show_status      = !cmd->FindExist("/NOSHOW", remove);
@@ -800,6 +805,7 @@ void MIXER::AddMessages()
 	        "Usage:\n"
 	        "  [color=light-green]mixer[reset] [color=light-cyan][CHANNEL][reset] [color=white]COMMANDS[reset] [/noshow]\n"
 	        "  [color=light-green]mixer[reset] [/listmidi]\n"
+	        "  [color=light-green]mixer[reset] [/stats]\n"
 	        "\n"
 	        "Parameters:\n"
 	        "  [color=light-cyan]CHANNEL[reset]   mixer channel to change the settings of\n"
@@ -815,6 +821,8 @@ void MIXER::AddMessages()
 	        "Notes:\n"
 	        "  - Run [color=light-green]mixer[reset] without arguments to view the current settings.\n"
 	        "  - Run [color=light-green]mixer[reset] /listmidi to list all available MIDI devices.\n"
+	        "  - Run [color=light-green]mixer[reset] /stats to view the host time each channel took and the\n"
+	        "    frames it delivered since the previous /stats run.\n"
 	        "  - You may change the settings of more than one channel in a single command.\n"
 	        "  - If no channel is specified, you can set crossfeed, reverb, or chorus\n"
 	        "    of all channels globally.\n"
@@ -830,6 +838,22 @@ void MIXER::AddMessages()
 	MSG_Add("SHELL_CMD_MIXER_HEADER_LABELS",
 	        "[color=white]Channel      Volume    Volume (dB)   Mode     Xfeed  Reverb  Chorus[reset]");
 
+	MSG_Add("SHELL_CMD_MIXER_STATS_TITLE",
+	        "Mixer stats over the last %.1f seconds (host times in milliseconds):");
+
+	MSG_Add("SHELL_CMD_MIXER_STATS_LAYOUT",
+	        "%-22s %8.2f %8.2f %8.2f %6.2f %10lld %10lld");
+
+	MSG_Add("SHELL_CMD_MIXER_STATS_LABELS",
+	        "[color=white]Channel       Device Resample   Filter   CPU%  Requested  Delivered[reset]");
+
+	MSG_Add("SHELL_CMD_MIXER_STATS_RENDER_AHEAD",
+	        "%s renders %.1f ms ahead, underruns: %lld");
+
+	MSG_Add("SHELL_CMD_MIXER_STATS_MASTER",
+	        "Master effects: %.2f ms, audio callback: %.2f ms\n"
+	        "Frames mixed: %lld, played: %lld, underruns: %d, overruns: %d");
+
 	MSG_Add("SHELL_CMD_MIXER_CHANNEL_OFF", "off");
 	MSG_Add("SHELL_CMD_MIXER_CHANNEL_STEREO", "Stereo");
 	MSG_Add("SHELL_CMD_MIXER_CHANNEL_REVERSE", "Reverse");
@@ -987,3 +1011,71 @@ void MIXER::ShowMixerStatus()
 
 	MIXER_UnlockAudioDevice();
 }
+
+void MIXER::ShowMixerStats()
+{
+	std::string column_layout = MSG_Get("SHELL_CMD_MIXER_STATS_LAYOUT");
+	column_layout.append({'\n'});
+
+	constexpr auto ns_per_ms = 1'000'000.0;
+
+	MIXER_LockAudioDevice();
+
+	const auto mixer_stats = MIXER_TakeStats();
+	const auto elapsed_ns  = std::max(mixer_stats.elapsed_ns, int64_t{1});
+
+	WriteOut(MSG_Get("SHELL_CMD_MIXER_STATS_TITLE"),
+	         static_cast<double>(elapsed_ns) / (ns_per_ms * 1000.0));
+	WriteOut("\n\n");
+
+	WriteOut("%s\n", MSG_Get("SHELL_CMD_MIXER_STATS_LABELS"));
+
+	std::vector<std::string> render_ahead_lines = {};
+
+	for (auto& [name, chan] : MIXER_GetChannels()) {
+		const auto stats = chan->TakeStats();
+
+		const auto total_ns = stats.device_ns + stats.resample_ns +
+		                      stats.filter_ns;
+
+		const auto cpu_percent = static_cast<double>(total_ns) * 100.0 /
+		                         static_cast<double>(elapsed_ns);
+
+		auto channel_name = std::string("[color=light-cyan]") + name +
+		                    std::string("[reset]");
+
+		WriteOut(column_layout.c_str(),
+		         convert_ansi_markup(channel_name).c_str(),
+		         static_cast<double>(stats.device_ns) / ns_per_ms,
+		         static_cast<double>(stats.resample_ns) / ns_per_ms,
+		         static_cast<double>(stats.filter_ns) / ns_per_ms,
+		         cpu_percent,
+		         static_cast<long long>(stats.frames_requested),
+		         static_cast<long long>(stats.frames_delivered));
+
+		if (stats.render_ahead_frames > 0) {
+			const auto ahead_ms = stats.render_ahead_frames * 1000.0 /
+			                      std::max(chan->GetSampleRate(), uint16_t{1});
+			render_ahead_lines.emplace_back(format_str(
+			        MSG_Get("SHELL_CMD_MIXER_STATS_RENDER_AHEAD"),
+			        convert_ansi_markup(channel_name).c_str(),
+			        ahead_ms,
+			        static_cast<long long>(stats.render_underruns)));
+		}
+	}
+
+	MIXER_UnlockAudioDevice();
+
+	WriteOut("\n");
+	for (const auto& line : render_ahead_lines) {
+		WriteOut("%s\n", line.c_str());
+	}
+	WriteOut(MSG_Get("SHELL_CMD_MIXER_STATS_MASTER"),
+	         static_cast<double>(mixer_stats.effects_ns) / ns_per_ms,
+	         static_cast<double>(mixer_stats.callback_ns) / ns_per_ms,
+	         static_cast<long long>(mixer_stats.frames_mixed),
+	         static_cast<long long>(mixer_stats.frames_played),
+	         mixer_stats.underruns,
+	         mixer_stats.overruns);
+	WriteOut("\n");
+}
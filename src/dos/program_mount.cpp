@@ -34,6 +34,10 @@
 #include "shell.h"
 #include "string_utils.h"
 
+static bool is_zip_archive(const std::string& path)
+{
+	return iequals(std_fs::path(path).extension().string(), ".zip");
+}
 
 void MOUNT::ListMounts()
 {
@@ -268,15 +272,27 @@ void MOUNT::Run(void) {
 			return;
 		}
 		/* Not a switch so a normal directory/file */
-		if (!S_ISDIR(test.st_mode)) {
+		const auto is_zip = !S_ISDIR(test.st_mode) && type == "dir" &&
+		                    is_zip_archive(temp_line);
+		if (!S_ISDIR(test.st_mode) && !is_zip) {
 			WriteOut(MSG_Get("PROGRAM_MOUNT_ERROR_2"),temp_line.c_str());
 			return;
 		}
 
-		if (temp_line[temp_line.size() - 1] != CROSS_FILESPLIT) temp_line += CROSS_FILESPLIT;
+		if (!is_zip && temp_line[temp_line.size() - 1] != CROSS_FILESPLIT) temp_line += CROSS_FILESPLIT;
 		uint8_t int8_tize = (uint8_t)sizes[1];
 
-		if (type == "cdrom") {
+		if (is_zip) {
+			int error = 0;
+			newdrive  = std::make_unique<zipDrive>(temp_line.c_str(),
+			                                       mediaid,
+			                                       error);
+			if (error) {
+				WriteOut(MSG_Get("PROGRAM_MOUNT_ZIP_ERROR"),
+				         temp_line.c_str());
+				return;
+			}
+		} else if (type == "cdrom") {
 			// Following options were relevant only for physical CD-ROM support:
 			for (auto opt : {"-noioctl", "-ioctl", "-ioctl_dx", "-ioctl_mci", "-ioctl_dio"}) {
 				if (cmd->FindExist(opt, false))
@@ -358,6 +374,9 @@ void MOUNT::Run(void) {
 				        mediaid,
 				        section->Get_bool(
 				                "allow_write_protected_files"));
+				if (section->Get_bool("prefetch_mounted_dirs")) {
+					newdrive->dirCache.StartPrefetching();
+				}
 			}
 		}
 	} else {
@@ -422,6 +441,7 @@ void MOUNT::AddMessages() {
 	        "\n"
 	        "Notes:\n"
 	        "  - '-t overlay' redirects writes for mounted drive to another directory.\n"
+	        "  - DIRECTORY can also be a ZIP archive, which is mounted read-only.\n"
 	        "  - Additional options are described in the manual (README file, chapter 4).\n"
 	        "\n"
 	        "Examples:\n");
@@ -441,6 +461,7 @@ void MOUNT::AddMessages() {
 	MSG_Add("PROGRAM_MOUNT_CDROMS_FOUND","CD-ROMs found: %d\n");
 	MSG_Add("PROGRAM_MOUNT_ERROR_1","Directory %s doesn't exist.\n");
 	MSG_Add("PROGRAM_MOUNT_ERROR_2","%s isn't a directory.\n");
+	MSG_Add("PROGRAM_MOUNT_ZIP_ERROR", "%s isn't a valid ZIP archive.\n");
 	MSG_Add("PROGRAM_MOUNT_ILL_TYPE","Illegal type %s\n");
 	MSG_Add("PROGRAM_MOUNT_ALREADY_MOUNTED","Drive %c already mounted with %s\n");
 	MSG_Add("PROGRAM_MOUNT_UMOUNT_NOT_MOUNTED","Drive %c isn't mounted.\n");
@@ -0,0 +1,98 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "program_netstat.h"
+
+#include <cinttypes>
+
+#include "network_stats.h"
+#include "program_more_output.h"
+
+static int64_t average(const int64_t total, const uint64_t count)
+{
+	return count ? total / static_cast<int64_t>(count) : 0;
+}
+
+void NETSTAT::Run()
+{
+	if (HelpRequested()) {
+		MoreOutputStrings output(*this);
+		output.AddString(MSG_Get("PROGRAM_NETSTAT_HELP_LONG"));
+		output.Display();
+		return;
+	}
+
+	const auto all_stats = NETSTATS_GetAll();
+	if (all_stats.empty()) {
+		WriteOut(MSG_Get("PROGRAM_NETSTAT_NONE_ACTIVE"));
+		return;
+	}
+
+	for (const auto stats : all_stats) {
+		const auto rates = stats->GetRates();
+
+		WriteOut("[color=white]%s[reset]\n", stats->GetName().c_str());
+		WriteOut(MSG_Get("PROGRAM_NETSTAT_RX"),
+		         rates.rx_packets, rates.rx_bytes,
+		         stats->rx_packets.load(), stats->rx_bytes.load());
+		WriteOut(MSG_Get("PROGRAM_NETSTAT_TX"),
+		         rates.tx_packets, rates.tx_bytes,
+		         stats->tx_packets.load(), stats->tx_bytes.load());
+		WriteOut(MSG_Get("PROGRAM_NETSTAT_QUEUE"),
+		         stats->queued, stats->max_queued, stats->drops.load());
+		if (stats->num_latencies) {
+			WriteOut(MSG_Get("PROGRAM_NETSTAT_LATENCY"),
+			         average(stats->total_latency_us, stats->num_latencies),
+			         stats->max_latency_us);
+		}
+		WriteOut(MSG_Get("PROGRAM_NETSTAT_POLL"),
+		         average(stats->total_poll_us, stats->num_polls),
+		         stats->max_poll_us);
+	}
+}
+
+void NETSTAT::AddMessages()
+{
+	MSG_Add("PROGRAM_NETSTAT_HELP_LONG",
+	        "Display the traffic of the active network connections.\n"
+	        "\n"
+	        "Usage:\n"
+	        "  [color=light-green]netstat[reset]\n"
+	        "\n"
+	        "Notes:\n"
+	        "  Lists the NE2000 Ethernet backend, the IPX tunnel and the serial port\n"
+	        "  modems while they're connected. The rates are taken over the last second,\n"
+	        "  the latency is the time from the host receiving a packet to the guest\n"
+	        "  getting it, and the poll time is spent by the emulation per tick.\n");
+	MSG_Add("PROGRAM_NETSTAT_NONE_ACTIVE", "No network connections are active.\n");
+	MSG_Add("PROGRAM_NETSTAT_RX",
+	        "  RX:      %" PRIu64 " packets/s, %" PRIu64 " bytes/s "
+	        "(%" PRIu64 " packets, %" PRIu64 " bytes)\n");
+	MSG_Add("PROGRAM_NETSTAT_TX",
+	        "  TX:      %" PRIu64 " packets/s, %" PRIu64 " bytes/s "
+	        "(%" PRIu64 " packets, %" PRIu64 " bytes)\n");
+	MSG_Add("PROGRAM_NETSTAT_QUEUE",
+	        "  Queue:   %" PRIu64 " waiting (at most %" PRIu64 "), "
+	        "%" PRIu64 " dropped\n");
+	MSG_Add("PROGRAM_NETSTAT_LATENCY",
+	        "  Latency: %" PRId64 " us on average, %" PRId64 " us at most\n");
+	MSG_Add("PROGRAM_NETSTAT_POLL",
+	        "  Poll:    %" PRId64 " us on average, %" PRId64 " us at most\n");
+}
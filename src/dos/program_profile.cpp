@@ -0,0 +1,133 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "program_profile.h"
+
+#include <cinttypes>
+
+#include "guest_profiler.h"
+#include "program_more_output.h"
+#include "string_utils.h"
+
+void PROFILE::Run()
+{
+	if (HelpRequested()) {
+		MoreOutputStrings output(*this);
+		output.AddString(MSG_Get("PROGRAM_PROFILE_HELP_LONG"));
+		output.Display();
+		return;
+	}
+
+	constexpr bool remove_if_found = true;
+	const bool has_arg_start = cmd->FindExist("/start", remove_if_found);
+	const bool has_arg_stop  = cmd->FindExist("/stop", remove_if_found);
+
+	std::string tmp_str;
+	if (cmd->FindStringBegin("/", tmp_str)) {
+		tmp_str = std::string("/") + tmp_str;
+		WriteOut(MSG_Get("SHELL_ILLEGAL_SWITCH"), tmp_str.c_str());
+		return;
+	}
+
+	const auto params = cmd->GetArguments();
+
+	if (has_arg_start == has_arg_stop) {
+		if (has_arg_start || !params.empty()) {
+			WriteOut(MSG_Get("SHELL_SYNTAX_ERROR"));
+			return;
+		}
+		if (PROFILER_IsRunning()) {
+			WriteOut(MSG_Get("PROGRAM_PROFILE_RUNNING"),
+			         PROFILER_GetInterval(),
+			         PROFILER_GetNumSamples());
+		} else {
+			WriteOut(MSG_Get("PROGRAM_PROFILE_NOT_RUNNING"));
+		}
+		return;
+	}
+
+	if (has_arg_stop) {
+		if (!params.empty()) {
+			WriteOut(MSG_Get("SHELL_TOO_MANY_PARAMETERS"));
+			return;
+		}
+		if (!PROFILER_IsRunning()) {
+			WriteOut(MSG_Get("PROGRAM_PROFILE_NOT_RUNNING"));
+			return;
+		}
+		const auto num_samples = PROFILER_GetNumSamples();
+		PROFILER_Stop();
+		WriteOut(MSG_Get("PROGRAM_PROFILE_STOPPED"), num_samples);
+		return;
+	}
+
+	if (params.size() > 1) {
+		WriteOut(MSG_Get("SHELL_TOO_MANY_PARAMETERS"));
+		return;
+	}
+	auto interval = DefaultProfilerInterval;
+	if (!params.empty()) {
+		const auto value = parse_int(params[0]);
+		if (!value || *value <= 0) {
+			WriteOut(MSG_Get("PROGRAM_PROFILE_INVALID_INTERVAL"),
+			         params[0].c_str());
+			return;
+		}
+		interval = *value;
+	}
+	PROFILER_Start(interval);
+	WriteOut(MSG_Get("PROGRAM_PROFILE_STARTED"), interval);
+}
+
+void PROFILE::AddMessages()
+{
+	MSG_Add("PROGRAM_PROFILE_HELP_LONG",
+	        "Sample where the guest code spends its time.\n"
+	        "\n"
+	        "Usage:\n"
+	        "  [color=light-green]profile[reset] [color=white]/start[reset] [[color=light-cyan]CYCLES[reset]]\n"
+	        "  [color=light-green]profile[reset] [color=white]/stop[reset]\n"
+	        "  [color=light-green]profile[reset]\n"
+	        "\n"
+	        "Where:\n"
+	        "  [color=light-cyan]CYCLES[reset] is the number of emulated cycles between two samples (5000 by\n"
+	        "         default).\n"
+	        "\n"
+	        "Notes:\n"
+	        "  Running without an argument shows whether the profiler is running.\n"
+	        "  Stopping writes the samples to the capture directory, in the folded stack\n"
+	        "  format read by flame graph tools. Addresses in programs started from DOS\n"
+	        "  are given by program name and their segment relative to the load segment,\n"
+	        "  as in the linker's map files.\n"
+	        "\n"
+	        "Examples:\n"
+	        "  [color=light-green]profile[reset] [color=white]/start[reset]\n"
+	        "  [color=light-green]profile[reset] [color=white]/start[reset] [color=light-cyan]1000[reset]\n"
+	        "  [color=light-green]profile[reset] [color=white]/stop[reset]\n");
+	MSG_Add("PROGRAM_PROFILE_STARTED",
+	        "Profiling the guest code every %d cycles.\n");
+	MSG_Add("PROGRAM_PROFILE_STOPPED",
+	        "Stopped profiling after %" PRId64 " samples.\n");
+	MSG_Add("PROGRAM_PROFILE_RUNNING",
+	        "Profiling the guest code every %d cycles, %" PRId64 " samples taken.\n");
+	MSG_Add("PROGRAM_PROFILE_NOT_RUNNING", "The profiler isn't running.\n");
+	MSG_Add("PROGRAM_PROFILE_INVALID_INTERVAL",
+	        "Invalid number of cycles: %s\n");
+}
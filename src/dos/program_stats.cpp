@@ -0,0 +1,171 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "program_stats.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <utility>
+#include <vector>
+
+#include "cpu.h"
+#include "event_counters.h"
+#include "program_more_output.h"
+#include "string_utils.h"
+
+// Slots listed per counter unless all of them are asked for
+constexpr size_t MaxListedSlots = 8;
+
+static void add_counter(MoreOutputStrings& output, const EventCounter& counter,
+                        const bool list_all_slots)
+{
+	const auto total = counter.GetTotal();
+	if (total == 0) {
+		return;
+	}
+	output.AddString("  %-30s %20" PRIu64 "\n", counter.GetName(), total);
+
+	if (counter.GetNumSlots() == 1) {
+		return;
+	}
+	std::vector<std::pair<uint64_t, size_t>> slots = {};
+	for (size_t slot = 0; slot < counter.GetNumSlots(); ++slot) {
+		if (const auto count = counter.Get(slot); count) {
+			slots.emplace_back(count, slot);
+		}
+	}
+	// Busiest first, and in slot order among equal counts
+	std::sort(slots.begin(), slots.end(), [](const auto& a, const auto& b) {
+		return a.first != b.first ? a.first > b.first : a.second < b.second;
+	});
+	if (!list_all_slots && slots.size() > MaxListedSlots) {
+		slots.resize(MaxListedSlots);
+	}
+	for (const auto& [count, slot] : slots) {
+		char label[32];
+		safe_sprintf(label, counter.GetSlotFormat(), slot);
+		output.AddString("    %-28s %20" PRIu64 "\n", label, count);
+	}
+}
+
+static void add_idle_time(MoreOutputStrings& output)
+{
+	output.AddString("  %-30s %19.1f%%\n", "Idle time", CPU_GetIdlePercent());
+
+	constexpr std::pair<IdleSource, const char*> sources[] = {
+	        {IdleSource::Halt, "HLT instruction"},
+	        {IdleSource::KeyboardPoll, "INT 16h keyboard polls"},
+	        {IdleSource::DosIdle, "INT 28h DOS idle"},
+	        {IdleSource::ReleaseTimeSlice, "INT 2Fh time slice releases"},
+	};
+	for (const auto& [source, name] : sources) {
+		if (const auto percent = CPU_GetIdlePercent(source); percent >= 0.05) {
+			output.AddString("    %-28s %19.1f%%\n", name, percent);
+		}
+	}
+}
+
+void STATS::Run()
+{
+	if (HelpRequested()) {
+		MoreOutputStrings output(*this);
+		output.AddString(MSG_Get("PROGRAM_STATS_HELP_LONG"));
+		output.Display();
+		return;
+	}
+
+	constexpr bool remove_if_found = true;
+	const bool has_arg_all   = cmd->FindExist("/all", remove_if_found);
+	const bool has_arg_reset = cmd->FindExist("/reset", remove_if_found);
+
+	std::string tmp_str;
+	if (cmd->FindStringBegin("/", tmp_str)) {
+		tmp_str = std::string("/") + tmp_str;
+		WriteOut(MSG_Get("SHELL_ILLEGAL_SWITCH"), tmp_str.c_str());
+		return;
+	}
+	if (!cmd->GetArguments().empty()) {
+		WriteOut(MSG_Get("SHELL_TOO_MANY_PARAMETERS"));
+		return;
+	}
+	if (has_arg_all && has_arg_reset) {
+		WriteOut(MSG_Get("SHELL_SYNTAX_ERROR"));
+		return;
+	}
+
+	if (has_arg_reset) {
+		COUNTERS_ResetAll();
+		CPU_ResetIdleStats();
+		WriteOut(MSG_Get("PROGRAM_STATS_RESET"));
+		return;
+	}
+
+	const auto counters = COUNTERS_GetAll();
+	const bool any_counted = std::any_of(counters.begin(),
+	                                     counters.end(),
+	                                     [](const EventCounter* counter) {
+		                                     return counter->GetTotal() > 0;
+	                                     });
+
+	MoreOutputStrings output(*this);
+	add_idle_time(output);
+	if (!any_counted) {
+		output.AddString(MSG_Get("PROGRAM_STATS_NONE_COUNTED"));
+		output.Display();
+		return;
+	}
+
+	output.AddString(MSG_Get("PROGRAM_STATS_HEADER"));
+	for (const auto counter : counters) {
+		add_counter(output, *counter, has_arg_all);
+	}
+	output.Display();
+}
+
+void STATS::AddMessages()
+{
+	MSG_Add("PROGRAM_STATS_HELP_LONG",
+	        "Display how often events on the emulator's hot paths happened.\n"
+	        "\n"
+	        "Usage:\n"
+	        "  [color=light-green]stats[reset] [[color=white]/all[reset]]\n"
+	        "  [color=light-green]stats[reset] [color=white]/reset[reset]\n"
+	        "\n"
+	        "Where:\n"
+	        "  [color=white]/all[reset]   lists every port or function counted, not only the busiest ones.\n"
+	        "  [color=white]/reset[reset] sets all the counters back to zero.\n"
+	        "\n"
+	        "Notes:\n"
+	        "  The counters cover I/O port accesses, page faults, TLB refills, translated\n"
+	        "  dynrec blocks, PIC events, DOS calls and mixer under- and overruns, counted\n"
+	        "  since the start or the last reset. Counters that are still zero aren't\n"
+	        "  listed. The idle time is the share of the emulated time the guest spent\n"
+	        "  waiting in HLT, keyboard polls, the DOS idle interrupt or time slice\n"
+	        "  releases, which is skipped instead of emulated.\n"
+	        "\n"
+	        "Examples:\n"
+	        "  [color=light-green]stats[reset]\n"
+	        "  [color=light-green]stats[reset] [color=white]/reset[reset]\n");
+	MSG_Add("PROGRAM_STATS_HEADER",
+	        "[color=white]  Event                                         Count[reset]\n");
+	MSG_Add("PROGRAM_STATS_NONE_COUNTED", "No events have been counted.\n");
+	MSG_Add("PROGRAM_STATS_RESET",
+	        "The event counters and the idle time have been reset.\n");
+}
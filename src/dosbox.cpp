@@ -21,7 +21,9 @@
 
 #include "dosbox.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <cstdarg>
 #include <cstdio>
 #include <cstdlib>
@@ -30,10 +32,12 @@
 #include <thread>
 #include <unistd.h>
 
+#include "benchmark.h"
 #include "callback.h"
 #include "capture/capture.h"
 #include "control.h"
 #include "cpu.h"
+#include "cpu/cycles_governor.h"
 #include "cross.h"
 #include "debug.h"
 #include "dos/dos_locale.h"
@@ -47,17 +51,21 @@
 #include "mixer.h"
 #include "mouse.h"
 #include "ne2000.h"
+#include "pacer.h"
 #include "pci_bus.h"
 #include "pic.h"
 #include "programs.h"
 #include "reelmagic.h"
 #include "render.h"
+#include "savestate.h"
 #include "setup.h"
 #include "shell.h"
 #include "support.h"
+#include "thread_placement.h"
 #include "timer.h"
 #include "tracy.h"
 #include "video.h"
+#include "worker_pool.h"
 
 bool shutdown_requested = false;
 MachineType machine;
@@ -133,12 +141,42 @@ int64_t ticksScheduled;
 bool ticksLocked;
 void increaseticks();
 
+// The main loop syncs with the host once per quantum. The emulated time base
+// stays at 1 ms ticks (PIC_Ticks, event delays and CPU_CycleMax are all in
+// milliseconds); shorter quanta release each tick in slices and longer ones
+// run several ticks back-to-back. ticksRemain and ticksLast are counted in
+// quanta and microseconds while the cycle guessing accounting (ticksDone,
+// ticksScheduled and ticksAdded) stays in milliseconds.
+static struct {
+	int64_t quantum_us       = 1000;
+	int ticks_per_quantum    = 1;
+	int ticks_left_in_batch  = 0;
+	int64_t done_remainder   = 0;
+	int64_t added_remainder  = 0;
+} tick_quantum = {};
+
+static int64_t quanta_to_ms(const int64_t quanta, int64_t& remainder_us)
+{
+	remainder_us += quanta * tick_quantum.quantum_us;
+	const auto ms = remainder_us / 1000;
+	remainder_us %= 1000;
+	return ms;
+}
+
+static int64_t ms_to_quanta(const int64_t ms)
+{
+	return std::max(static_cast<int64_t>(1), ms * 1000 / tick_quantum.quantum_us);
+}
+
 bool mono_cga=false;
 
 void Null_Init([[maybe_unused]] Section *sec) {
 	// do nothing
 }
 
+// How many emulation loops are running inside each other
+static int run_depth = 0;
+
 static Bitu Normal_Loop() {
 	Bits ret;
 	while (1) {
@@ -160,22 +198,73 @@ static Bitu Normal_Loop() {
 			if (DEBUG_ExitLoop()) return 0;
 #endif
 		} else {
+			// The remaining ticks of a batched quantum run without
+			// syncing with the host in between
+			if (tick_quantum.ticks_left_in_batch > 0) {
+				--tick_quantum.ticks_left_in_batch;
+				TIMER_AddTick();
+				continue;
+			}
 			if (!GFX_Events())
 				return 0;
+			SAVESTATE_RunPending(run_depth);
 			if (ticksRemain > 0) {
-				TIMER_AddTick();
+				if (PIC_NextTickSlice()) {
+					MIXER_MixPartialTick();
+				} else {
+					tick_quantum.ticks_left_in_batch =
+					        tick_quantum.ticks_per_quantum - 1;
+					TIMER_AddTick();
+				}
 				ticksRemain--;
 			} else {increaseticks();return 0;}
 		}
 	}
 }
 
+static CyclesGovernor cycles_governor = {};
+
+// Both loads are in host time per emulated time; ticksDone already has
+// the time spent sleeping and presenting frames taken out
+static void update_cycles_governor()
+{
+	const auto scheduled_ms = static_cast<double>(std::max(ticksScheduled,
+	                                                       int64_t(1)));
+	const auto cproc = static_cast<double>(CPU_CycleMax) *
+	                   static_cast<double>(ticksScheduled);
+	const auto audio = MIXER_TakeBufferStats();
+
+	CyclesGovernor::Sample sample = {};
+	sample.emulation_load = static_cast<double>(ticksDone) / scheduled_ms;
+	sample.present_load = static_cast<double>(GFX_TakePresentTimeUs()) /
+	                      (scheduled_ms * 1000.0);
+	sample.io_delay_removed = cproc > 0
+	                                ? static_cast<double>(CPU_IODelayRemoved) / cproc
+	                                : 0.0;
+	sample.audio_min_fill  = audio.min_fill;
+	sample.audio_underruns = audio.underruns;
+
+	const auto max_cycles = CPU_CycleLimit > 0 ? CPU_CycleLimit : 2000000;
+
+	cycles_governor.SetHeadroom(CPU_CyclesHeadroom);
+	CPU_CycleMax = cycles_governor.Update(CPU_CycleMax,
+	                                      CPU_CyclePercUsed,
+	                                      sample,
+	                                      CPU_CYCLES_LOWER_LIMIT,
+	                                      max_cycles);
+
+	CPU_IODelayRemoved = 0;
+	ticksDone          = 0;
+	ticksScheduled     = 0;
+}
+
 void increaseticks() { //Make it return ticksRemain and set it in the function above to remove the global variable.
 	ZoneScoped;
+	TracyPlot("CPU cycles/ms", static_cast<int64_t>(CPU_CycleMax));
 	if (ticksLocked) { // For Fast Forward Mode
-		ticksRemain=5;
+		ticksRemain = ms_to_quanta(5);
 		/* Reset any auto cycle guessing for this frame */
-		ticksLast = GetTicks();
+		ticksLast = GetTicksUs();
 		ticksAdded = 0;
 		ticksDone = 0;
 		ticksScheduled = 0;
@@ -183,16 +272,17 @@ void increaseticks() { //Make it return ticksRemain and set it in the function a
 	}
 
 	const auto ticksNewUs = GetTicksUs();
-	const auto ticksNew = ticksNewUs / 1000;
+	const auto ticksNew = ticksNewUs / tick_quantum.quantum_us;
 
 	ticksScheduled += ticksAdded;
-	if (ticksNew <= ticksLast) { //lower should not be possible, only equal.
+	if (ticksNew <= ticksLast / tick_quantum.quantum_us) { //lower should not be possible, only equal.
 		ticksAdded = 0;
 
 		static int64_t cumulativeTimeSlept = 0;
 
-		constexpr auto sleepDuration = std::chrono::microseconds(1000);
-		std::this_thread::sleep_for(sleepDuration);
+		// Wake up right at the start of the next tick instead of
+		// sleeping a whole tick plus however late the host wakes us
+		PACER_WaitUntilUs((ticksNew + 1) * tick_quantum.quantum_us);
 
 		const auto timeslept = GetTicksUsSince(ticksNewUs);
 
@@ -219,20 +309,26 @@ void increaseticks() { //Make it return ticksRemain and set it in the function a
 	}
 
 	//TicksNew > ticksLast
-	ticksRemain = GetTicksDiff(ticksNew, ticksLast);
-	ticksLast = ticksNew;
-	ticksDone += ticksRemain;
-	if ( ticksRemain > 20 ) {
+	ticksRemain = GetTicksDiff(ticksNew, ticksLast / tick_quantum.quantum_us);
+	ticksLast = ticksNew * tick_quantum.quantum_us;
+	ticksDone += quanta_to_ms(ticksRemain, tick_quantum.done_remainder);
+	if ( ticksRemain > ms_to_quanta(20) ) {
 //		LOG(LOG_MISC,LOG_ERROR)("large remain %d",ticksRemain);
-		ticksRemain = 20;
+		ticksRemain = ms_to_quanta(20);
 	}
-	ticksAdded = ticksRemain;
+	ticksAdded = quanta_to_ms(ticksRemain, tick_quantum.added_remainder);
 
 	// Is the system in auto cycle mode guessing ? If not just exit. (It can be temporary disabled)
 	if (!CPU_CycleAutoAdjust) return;
 
 	if (ticksScheduled >= 100 || ticksDone >= 100 || (ticksAdded > 15 && ticksScheduled >= 5) ) {
 		if(ticksDone < 1) ticksDone = 1; // Protect against div by zero
+
+		if (CPU_UseCyclesGovernor) {
+			update_cycles_governor();
+			return;
+		}
+
 		// Ratio we are aiming for is 100% usage
 		int32_t ratio = static_cast<int32_t>(
 		        (ticksScheduled * (CPU_CyclePercUsed * 1024 / 100)) /
@@ -337,8 +433,10 @@ void DOSBOX_SetNormalLoop() {
 
 void DOSBOX_RunMachine()
 {
+	++run_depth;
 	while ((*loop)() == 0 && !shutdown_requested)
 		;
+	--run_depth;
 }
 
 static void DOSBOX_UnlockSpeed( bool pressed ) {
@@ -411,12 +509,30 @@ static void DOSBOX_RealInit(Section* sec)
 {
 	Section_prop* section = static_cast<Section_prop*>(sec);
 	/* Initialize some dosbox internals */
+	const auto quantum_ms = std::stod(section->Get_string("tick_quantum"));
+	tick_quantum.quantum_us = std::lround(quantum_ms * 1000);
+	tick_quantum.ticks_per_quantum = std::max(
+	        1, static_cast<int>(tick_quantum.quantum_us / 1000));
+	tick_quantum.ticks_left_in_batch = 0;
+	PIC_SetTickSlices(std::max(1, static_cast<int>(1000 / tick_quantum.quantum_us)));
+
+	WORKERS_GetPool().SetMaxThreads(section->Get_int("worker_threads"));
+
+	THREAD_SetPlacementPolicy(section->Get_string("thread_affinity"),
+	                          section->Get_bool("thread_priorities"));
+	THREAD_ApplyRole(ThreadRole::Emulation);
+
 	ticksRemain = 0;
-	ticksLast   = GetTicks();
+	ticksLast   = GetTicksUs();
 	ticksLocked = false;
 	DOSBOX_SetLoop(&Normal_Loop);
 
 	MAPPER_AddHandler(DOSBOX_UnlockSpeed, SDL_SCANCODE_F12, MMOD2, "speedlock", "Speedlock");
+	SAVESTATE_AddMapperHandlers();
+
+	if (const auto seconds = control->arguments.benchmark; seconds) {
+		BENCHMARK_Start(*seconds, control->arguments.benchmark_report);
+	}
 
 	DOSBOX_SetMachineTypeFromConfig(section);
 
@@ -541,6 +657,16 @@ void DOSBOX_Init()
 	        "though a few games might require a higher value.\n"
 	        "There is generally no speed advantage when raising this value.");
 
+	pstring = secprop->Add_string("memory_pages", only_at_start, "normal");
+	pstring->Set_values({"normal", "huge"});
+	pstring->Set_help(
+	        "Host page size used for the emulated machine's memory ('normal' by default).\n"
+	        "  normal:  Allocate the memory like any other host memory (default).\n"
+	        "  huge:    Map the memory using 2 MB huge pages and fault it in up-front. Uses\n"
+	        "           explicit huge pages if the host has reserved any, otherwise asks\n"
+	        "           for transparent huge pages. Can speed up memory access with large\n"
+	        "           'memsize' values. Falls back to 'normal' if not supported.");
+
 	pstring = secprop->Add_string("mcb_fault_strategy", only_at_start, "repair");
 	pstring->Set_help(
 	        "How software-corrupted memory chain blocks should be handled:\n"
@@ -585,6 +711,44 @@ void DOSBOX_Init()
 	        "Note: We recommend the 'default' rate, otherwise test and set on a per-game\n"
 	        "      basis.");
 
+	pstring = secprop->Add_string("tick_quantum", only_at_start, "1");
+	pstring->Set_values({"0.25", "0.5", "1", "2", "4"});
+	pstring->Set_help(
+	        "How often the emulator syncs with the host, in milliseconds ('1' by default).\n"
+	        "  0.25, 0.5:  Run each emulated millisecond in slices and mix audio after each\n"
+	        "              slice. This helps when using very small audio buffers.\n"
+	        "  1:          Sync once per emulated millisecond (default).\n"
+	        "  2, 4:       Run several milliseconds back-to-back, which lowers the per-tick\n"
+	        "              overhead at the cost of coarser input and audio timing.");
+
+	pint = secprop->Add_int("worker_threads", only_at_start, 0);
+	pint->SetMinMax(0, 256);
+	pint->Set_help(
+	        "Maximum number of threads shared by the emulated devices for their background\n"
+	        "work, such as rasterizing 3dfx Voodoo triangles and saving image captures\n"
+	        "(0 by default). 0 uses as many threads as the host has logical CPU cores.\n"
+	        "Lower it when running many instances at once on the same host.");
+
+	pstring = secprop->Add_string("thread_affinity", only_at_start, "auto");
+	pstring->Set_help(
+	        "Set the host CPUs the emulator's threads may run on ('auto' by default).\n"
+	        "  auto:     Keep the emulation and audio threads on the performance cores of\n"
+	        "            hybrid CPUs (e.g., Intel Alder Lake or Arm big.LITTLE); all other\n"
+	        "            threads can run on any core (default).\n"
+	        "  off:      Let the host operating system place all threads.\n"
+	        "  <list>:   Space-separated 'role:cpus' entries, where the role is 'emulation',\n"
+	        "            'audio', 'video' (video capture), or 'workers', and the CPUs are a\n"
+	        "            list like '0-3,6'; e.g., 'emulation:2 audio:3 workers:4-7'.\n"
+	        "            Roles not listed can run on any core.\n"
+	        "Note: Not supported on macOS, which doesn't allow placing threads on CPUs.");
+
+	pbool = secprop->Add_bool("thread_priorities", only_at_start, true);
+	pbool->Set_help(
+	        "Raise the scheduling priority of the emulation and audio threads and lower it\n"
+	        "for video capture (enabled by default). Uses thread priorities and opts out of\n"
+	        "power throttling on Windows, and QoS classes on macOS. Linux only lowers the\n"
+	        "video capture thread's priority, as raising it requires elevated rights.");
+
 	pstring = secprop->Add_string("vesa_modes", only_at_start, "compatible");
 	pstring->Set_values({"compatible", "all", "halfline"});
 	pstring->Set_help(
@@ -659,6 +823,20 @@ void DOSBOX_Init()
 	        "you're using a copy-on-write or network-based filesystem, this setting avoids\n"
 	        "triggering write operations for these write-protected files.");
 
+	pbool = secprop->Add_bool("map_disk_images", only_at_start, false);
+	pbool->Set_help(
+	        "Map disk images attached with IMGMOUNT and BOOT into memory instead of reading\n"
+	        "them sector by sector (disabled by default). Large hard disk images on fast\n"
+	        "drives are then read and written by the host's page cache. Images opened\n"
+	        "read-only are mapped read-only. Not available on Windows.");
+
+	pbool = secprop->Add_bool("prefetch_mounted_dirs", only_at_start, false);
+	pbool->Set_help(
+	        "Read the folders of mounted directories in the background and follow the\n"
+	        "changes made to them on the host while DOS programs run (disabled by default).\n"
+	        "Games with many files in deep folder trees start up faster when their folders\n"
+	        "are already read. Only available on Linux.");
+
 	pbool = secprop->Add_bool("shell_config_shortcuts", when_idle, true);
 	pbool->Set_help(
 	        "Allow shortcuts for simpler configuration management (enabled by default).\n"
@@ -723,7 +901,64 @@ void DOSBOX_Init()
 	pint->Set_help("Number of cycles subtracted with the decrease cycles hotkey (20 by default).\n"
 	               "Setting it lower than 100 will be a percentage.");
 
+	pstring = secprop->Add_string("cycles_governor", always, "classic");
+	pstring->Set_values({"classic", "pid"});
+	pstring->Set_help(
+	        "How 'auto' and 'max' cycles follow the host's load ('classic' by default).\n"
+	        "  classic:  Scale the cycles by the share of time spent emulating.\n"
+	        "  pid:      Use a smoother PID-style controller that also backs off when the\n"
+	        "            audio buffer runs low or presenting frames takes longer. Keeps\n"
+	        "            'cycles_headroom' percent of the host's time free.");
+
+	pint = secprop->Add_int("cycles_headroom", always, 10);
+	pint->SetMinMax(0, 50);
+	pint->Set_help(
+	        "Percentage of host time the 'pid' cycles governor keeps free (10 by default).\n"
+	        "Increase it if you hear audio crackles while using 'auto' or 'max' cycles.");
+
+	pbool = secprop->Add_bool("tagged_tlb", always, false);
+	pbool->Set_help(
+	        "Keep the page translations of recently used address spaces when the guest\n"
+	        "switches between them (disabled by default). Translations are only reused\n"
+	        "while the guest's page tables still match, so this is safe to enable.\n"
+	        "Speeds up protected-mode multitasking guests such as Windows 3.x and 9x.");
+
+#if (C_DYNAMIC_X86) || (C_DYNREC)
+	pint = secprop->Add_int("dynamic_core_memsize", only_at_start, 8);
+	pint->SetMinMax(8, 512);
+	pint->Set_help(
+	        "Size of the dynamic core's code cache in MB (8 by default). When the cache is\n"
+	        "full, the oldest translations are overwritten and have to be retranslated once\n"
+	        "they run again. Large protected mode programs (e.g., Windows 3.x or DOS4GW\n"
+	        "games) can benefit from a larger cache at the cost of more host memory.");
+#endif
+
+#if C_DYNREC
+	pbool = secprop->Add_bool("dynamic_core_cache", only_at_start, false);
+	pbool->Set_help(
+	        "Remember translated code across sessions (disabled by default).\n"
+	        "The dynamic core stores where it translated blocks and which code was\n"
+	        "modified at runtime in 'dynrec-cache.bin' in the config directory.\n"
+	        "Code pages that are found unchanged on the next start are translated up-front,\n"
+	        "which reduces stuttering when launching the same titles repeatedly.");
+
+	pint = secprop->Add_int("dynamic_core_threshold", always, 0);
+	pint->SetMinMax(0, 255);
+	pint->Set_help(
+	        "Number of times code in a memory page must be entered before the dynamic core\n"
+	        "translates it (0 by default). Until then the code is run by the normal core.\n"
+	        "Higher values keep rarely run and self-modifying code from being translated\n"
+	        "over and over again. 0 translates all code on first sight.");
+#endif
+
 #if C_FPU
+	pbool = secprop->Add_bool("fpu_extended_precision", only_at_start, false);
+	pbool->Set_help(
+	        "Compute x87 additions, subtractions, multiplications, divisions and square\n"
+	        "roots with full 80-bit precision (disabled by default). Only has an effect on\n"
+	        "hosts without the native x86 FPU path, where the FPU is otherwise emulated\n"
+	        "with 64-bit doubles. Slower, but 80-bit values survive loads and stores intact.");
+
 	secprop->AddInitFunction(&FPU_Init);
 #endif
 	secprop->AddInitFunction(&DMA_Init);
@@ -748,6 +983,13 @@ void DOSBOX_Init()
 	pbool = secprop->Add_bool("voodoo_multithreading", only_at_start, true);
 	pbool->Set_help("Use threads to improve 3dfx Voodoo performance (enabled by default).");
 
+	pint = secprop->Add_int("voodoo_threads", only_at_start, 0);
+	pint->SetMinMax(0, 31);
+	pint->Set_help(
+	        "Number of threads rasterizing 3dfx Voodoo triangles along with the emulation\n"
+	        "thread when 'voodoo_multithreading' is enabled (0 by default). 0 uses one\n"
+	        "thread less than the host's logical CPU cores. Limited by 'worker_threads'.");
+
 	pbool = secprop->Add_bool("voodoo_bilinear_filtering", only_at_start, false);
 	pbool->Set_help(
 	        "Use bilinear filtering to emulate the 3dfx Voodoo's texture smoothing effect\n"
@@ -1072,6 +1314,14 @@ void DOSBOX_Init()
 	                  "A single number is treated as the major version.\n"
 	                  "Common settings are 3.3, 5.0, 6.22, and 7.1.");
 
+	pint = secprop->Add_int("file_write_buffer", when_idle, 64);
+	pint->SetMinMax(0, 1024);
+	pint->Set_help(
+	        "Size of the write buffer for each file opened for writing on a directory\n"
+	        "mount, in KB (64 by default). Buffered writes reach the host when the file\n"
+	        "is closed, seeked, or committed, and at least once a second. 0 leaves the\n"
+	        "buffering to the host's C library.");
+
 	// DOS locale settings
 
 	secprop->AddInitFunction(&DOS_Locale_Init, changeable_at_runtime);
@@ -1149,6 +1399,33 @@ void DOSBOX_Init()
 	pbool->SetEnabledOptions({"ipx"});
 #endif
 
+	pstring = secprop->Add_string("transport", when_idle, "udp");
+	pstring->Set_values({"udp", "enet"});
+	pstring->SetOptionHelp(
+	        "How IPXNET tunnels the packets to and from the server ('udp' by default):\n"
+	        "  udp:   Plain UDP datagrams, compatible with other DOSBox forks.\n"
+	        "  enet:  ENet sessions, which gather the packets into fewer datagrams,\n"
+	        "         drop late ones instead of resending them, and adapt to the\n"
+	        "         link's congestion. Better suited to playing over the internet.\n"
+	        "         The server and all clients have to use it.");
+
+	pint = secprop->Add_int("enet_bandwidth", when_idle, 0);
+	pint->SetMinMax(0, 100000);
+	pint->SetOptionHelp(
+	        "Limit what an ENet client sends and is sent to this many KB/s\n"
+	        "(0 by default, no limit).");
+
+	pstring = secprop->Add_path("capture_file", when_idle, "");
+	pstring->SetOptionHelp(
+	        "Log every IPX packet received and sent while connected to a server, with\n"
+	        "emulated timestamps, to this file (unset by default).");
+
+	pstring = secprop->Add_path("replay_file", when_idle, "");
+	pstring->SetOptionHelp(
+	        "Play back the packets received in this packet log instead of connecting\n"
+	        "to a server (unset by default). The guest gets the IPX address of the\n"
+	        "captured session, and the packets it sends are discarded.");
+
 #if C_SLIRP
 	secprop = control->AddSection_prop("ethernet", &NE2K_Init, changeable_at_runtime);
 #else
@@ -1172,6 +1449,44 @@ void DOSBOX_Init()
 	pbool->SetEnabledOptions({"SLIRP"});
 #endif
 
+	pstring = secprop->Add_string("backend", when_idle, "slirp");
+	pstring->Set_values({"slirp", "tap", "replay"});
+	pstring->SetOptionHelp("SLIRP",
+	                       "How the NE2000 card reaches the network ('slirp' by default):\n"
+	                       "  slirp:  Software-based network, see 'ne2000' above.\n"
+	                       "  tap:    Exchange raw frames with the host's TAP interface set by\n"
+	                       "          'tap_interface', which can be bridged to a real LAN for\n"
+	                       "          IPX and NetBIOS games. Not available on Windows.\n"
+	                       "  replay: Play back the frames received in the 'replay_file' packet\n"
+	                       "          log without any network.");
+#if C_SLIRP
+	pstring->SetEnabledOptions({"SLIRP"});
+#endif
+
+	pstring = secprop->Add_string("tap_interface", when_idle, "tap0");
+	pstring->SetOptionHelp("SLIRP",
+	                       "Name of the host's TAP interface used by the 'tap' backend ('tap0' by\n"
+	                       "default). The interface has to exist and be up.");
+#if C_SLIRP
+	pstring->SetEnabledOptions({"SLIRP"});
+#endif
+
+	pstring = secprop->Add_path("capture_file", when_idle, "");
+	pstring->SetOptionHelp("SLIRP",
+	                       "Log every frame the NE2000 card receives and sends, with emulated\n"
+	                       "timestamps, to this file (unset by default). Logs can be played back\n"
+	                       "with the 'replay' backend.");
+#if C_SLIRP
+	pstring->SetEnabledOptions({"SLIRP"});
+#endif
+
+	pstring = secprop->Add_path("replay_file", when_idle, "");
+	pstring->SetOptionHelp("SLIRP",
+	                       "The packet log played back by the 'replay' backend (unset by default).");
+#if C_SLIRP
+	pstring->SetEnabledOptions({"SLIRP"});
+#endif
+
 	phex = secprop->Add_hex("nicbase", when_idle, 0x300);
 	phex->Set_values(
 	        {"200", "220", "240", "260", "280", "2c0", "300", "320", "340", "360"});
@@ -1200,6 +1515,16 @@ void DOSBOX_Init()
 	pstring->SetEnabledOptions({"SLIRP"});
 #endif
 
+	pint = secprop->Add_int("nic_irq_coalescing", when_idle, 0);
+	pint->SetMinMax(0, 10000);
+	pint->SetOptionHelp("SLIRP",
+	                    "Minimum time between two receive interrupts of the NE2000 card, in\n"
+	                    "microseconds (0 by default). Frames arriving in between are delivered\n"
+	                    "in one go, which lowers the interrupt load of busy packet drivers.");
+#if C_SLIRP
+	pint->SetEnabledOptions({"SLIRP"});
+#endif
+
 	pstring = secprop->Add_string("tcp_port_forwards", when_idle, "");
 	pstring->SetOptionHelp("SLIRP",
 	        "Forward one or more TCP ports from the host into the DOS guest\n"
@@ -24,6 +24,9 @@
 #include "cross.h"
 #include "fpu.h"
 #include "mem.h"
+#include "savestate.h"
+#include "setup.h"
+#include <cassert>
 #include <cmath>
 
 FPU_rec fpu = {};
@@ -655,11 +658,26 @@ void FPU_ESC7_Normal(Bitu rm) {
 }
 
 
-void FPU_Init(Section*) {
+void FPU_Init(Section* sec) {
 #if !C_FPU_X86
-	LOG_WARNING("FPU: Using reduced-precision floating-point emulation");
+	assert(sec);
+	const auto section = static_cast<Section_prop*>(sec);
+
+	fpu.extended_precision = section->Get_bool("fpu_extended_precision");
+	if (fpu.extended_precision) {
+		LOG_MSG("FPU: Using soft-float 80-bit emulation for basic arithmetic");
+	} else {
+		LOG_WARNING("FPU: Using reduced-precision floating-point emulation");
+	}
+#else
+	(void)sec;
 #endif
 	FPU_FINIT();
+
+	SAVESTATE_AddComponent(
+	        "FPU",
+	        [](SaveStateWriter& writer) { writer.Write(fpu); },
+	        [](SaveStateReader& reader) { reader.Read(fpu); });
 }
 
 #endif
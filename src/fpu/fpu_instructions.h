@@ -181,7 +181,58 @@ static Real64 FPU_FLD80(PhysPt addr) {
 	//mant64= test.mant80/2***64    * 2 **53 
 }
 
+// Extended precision fast path: the registers keep their double value
+// for everything else, the exact result is kept in a shadow register
+static Float80 FPU_GetReg80(const Bitu reg)
+{
+	if (fpu.regs_80_ll[reg] == fpu.regs[reg].ll) {
+		return fpu.regs_80[reg];
+	}
+	return f80_from_double(fpu.regs[reg].d);
+}
+
+static void FPU_SetReg80(const Bitu reg, const Float80 val)
+{
+	fpu.regs[reg].d          = f80_to_double(val);
+	fpu.regs_80[reg]         = val;
+	fpu.regs_80_ll[reg]      = fpu.regs[reg].ll;
+	fpu.use_regs_memcpy[reg] = false;
+}
+
+static int FPU_GetPrecision80()
+{
+	switch (fpu.cw & PrecisionModeMask) {
+	case SinglePrecisionMode: return 24;
+	case DoublePrecisionMode: return 53;
+	default: return 64;
+	}
+}
+
+static F80Rounding FPU_GetRounding80()
+{
+	return static_cast<F80Rounding>(fpu.round);
+}
+
+static Float80 FPU_FLD80_Exact(PhysPt addr)
+{
+	Float80 val  = {};
+	val.mant     = mem_readq(addr);
+	val.sign_exp = mem_readw(addr + 8);
+	return val;
+}
+
+static void FPU_ST80_Exact(PhysPt addr, Bitu reg)
+{
+	const auto val = FPU_GetReg80(reg);
+	mem_writeq(addr, val.mant);
+	mem_writew(addr + 8, val.sign_exp);
+}
+
 static void FPU_ST80(PhysPt addr,Bitu reg) {
+	if (fpu.extended_precision) {
+		FPU_ST80_Exact(addr, reg);
+		return;
+	}
 	struct {
 		int16_t begin = 0;
 		FPU_Reg eind  = {};
@@ -219,6 +270,10 @@ static void FPU_FLD_F64(PhysPt addr,Bitu store_to) {
 }
 
 static void FPU_FLD_F80(PhysPt addr) {
+	if (fpu.extended_precision) {
+		FPU_SetReg80(TOP, FPU_FLD80_Exact(addr));
+		return;
+	}
 	fpu.regs[TOP].d = FPU_FLD80(addr);
 }
 
@@ -368,6 +423,11 @@ static void FPU_FBST(PhysPt addr) {
 }
 
 static void FPU_FADD(Bitu op1, Bitu op2){
+	if (fpu.extended_precision) {
+		FPU_SetReg80(op1, f80_add(FPU_GetReg80(op1), FPU_GetReg80(op2),
+		                          FPU_GetPrecision80(), FPU_GetRounding80()));
+		return;
+	}
 	fpu.regs[op1].d+=fpu.regs[op2].d;
 	//flags and such :)
 	return;
@@ -397,6 +457,11 @@ static void FPU_FCOS(void){
 }
 
 static void FPU_FSQRT(void){
+	if (fpu.extended_precision) {
+		FPU_SetReg80(TOP, f80_sqrt(FPU_GetReg80(TOP), FPU_GetPrecision80(),
+		                           FPU_GetRounding80()));
+		return;
+	}
 	fpu.regs[TOP].d = sqrt(fpu.regs[TOP].d);
 	//flags and such :)
 	return;
@@ -415,30 +480,55 @@ static void FPU_FPTAN(void){
 	return;
 }
 static void FPU_FDIV(Bitu st, Bitu other){
+	if (fpu.extended_precision) {
+		FPU_SetReg80(st, f80_div(FPU_GetReg80(st), FPU_GetReg80(other),
+		                        FPU_GetPrecision80(), FPU_GetRounding80()));
+		return;
+	}
 	fpu.regs[st].d= fpu.regs[st].d/fpu.regs[other].d;
 	//flags and such :)
 	return;
 }
 
 static void FPU_FDIVR(Bitu st, Bitu other){
+	if (fpu.extended_precision) {
+		FPU_SetReg80(st, f80_div(FPU_GetReg80(other), FPU_GetReg80(st),
+		                        FPU_GetPrecision80(), FPU_GetRounding80()));
+		return;
+	}
 	fpu.regs[st].d= fpu.regs[other].d/fpu.regs[st].d;
 	// flags and such :)
 	return;
 }
 
 static void FPU_FMUL(Bitu st, Bitu other){
+	if (fpu.extended_precision) {
+		FPU_SetReg80(st, f80_mul(FPU_GetReg80(st), FPU_GetReg80(other),
+		                        FPU_GetPrecision80(), FPU_GetRounding80()));
+		return;
+	}
 	fpu.regs[st].d*=fpu.regs[other].d;
 	//flags and such :)
 	return;
 }
 
 static void FPU_FSUB(Bitu st, Bitu other){
+	if (fpu.extended_precision) {
+		FPU_SetReg80(st, f80_sub(FPU_GetReg80(st), FPU_GetReg80(other),
+		                        FPU_GetPrecision80(), FPU_GetRounding80()));
+		return;
+	}
 	fpu.regs[st].d = fpu.regs[st].d - fpu.regs[other].d;
 	//flags and such :)
 	return;
 }
 
 static void FPU_FSUBR(Bitu st, Bitu other){
+	if (fpu.extended_precision) {
+		FPU_SetReg80(st, f80_sub(FPU_GetReg80(other), FPU_GetReg80(st),
+		                        FPU_GetPrecision80(), FPU_GetRounding80()));
+		return;
+	}
 	fpu.regs[st].d= fpu.regs[other].d - fpu.regs[st].d;
 	//flags and such :)
 	return;
@@ -449,14 +539,20 @@ static void FPU_FXCH(Bitu st, Bitu other){
 	const auto use_reg_memcpy  = fpu.use_regs_memcpy[other];
 	const auto reg             = fpu.regs[other];
 	const auto reg_memcpy      = fpu.regs_memcpy[other];
+	const auto reg_80          = fpu.regs_80[other];
+	const auto reg_80_ll       = fpu.regs_80_ll[other];
 	fpu.tags[other]            = fpu.tags[st];
 	fpu.use_regs_memcpy[other] = fpu.use_regs_memcpy[st];
 	fpu.regs[other]            = fpu.regs[st];
 	fpu.regs_memcpy[other]     = fpu.regs_memcpy[st];
+	fpu.regs_80[other]         = fpu.regs_80[st];
+	fpu.regs_80_ll[other]      = fpu.regs_80_ll[st];
 	fpu.tags[st]               = tag;
 	fpu.use_regs_memcpy[st]    = use_reg_memcpy;
 	fpu.regs[st]               = reg;
 	fpu.regs_memcpy[st]        = reg_memcpy;
+	fpu.regs_80[st]            = reg_80;
+	fpu.regs_80_ll[st]         = reg_80_ll;
 }
 
 static void FPU_FST(Bitu st, Bitu other){
@@ -464,6 +560,8 @@ static void FPU_FST(Bitu st, Bitu other){
 	fpu.use_regs_memcpy[other] = fpu.use_regs_memcpy[st];
 	fpu.regs[other]            = fpu.regs[st];
 	fpu.regs_memcpy[other]     = fpu.regs_memcpy[st];
+	fpu.regs_80[other]         = fpu.regs_80[st];
+	fpu.regs_80_ll[other]      = fpu.regs_80_ll[st];
 }
 
 static void FPU_FCOM(Bitu st, Bitu other){
@@ -619,7 +717,11 @@ static void FPU_FRSTOR(PhysPt addr){
 	FPU_FLDENV(addr);
 	Bitu start = (cpu.code.big?28:14);
 	for(Bitu i = 0;i < 8;i++){
-		fpu.regs[STV(i)].d = FPU_FLD80(addr+start);
+		if (fpu.extended_precision) {
+			FPU_SetReg80(STV(i), FPU_FLD80_Exact(addr + start));
+		} else {
+			fpu.regs[STV(i)].d = FPU_FLD80(addr + start);
+		}
 		start += 10;
 	}
 }
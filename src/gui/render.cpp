@@ -22,8 +22,10 @@
 #include <cassert>
 #include <cmath>
 #include <cstdlib>
+#include <cstring>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 #include "../capture/capture.h"
 #include "control.h"
@@ -36,6 +38,7 @@
 #include "shell.h"
 #include "string_utils.h"
 #include "support.h"
+#include "tracy.h"
 #include "vga.h"
 #include "video.h"
 
@@ -79,7 +82,12 @@ static void check_palette(void)
 	}
 	Bitu i;
 	switch (render.scale.outMode) {
-	case scalerMode8: break;
+	case scalerMode8:
+		// The palette lookup is done when presenting
+		GFX_SetPalette(reinterpret_cast<const uint8_t*>(render.pal.rgb),
+		               render.pal.first,
+		               render.pal.last);
+		break;
 	case scalerMode15:
 	case scalerMode16:
 		for (i = render.pal.first; i <= render.pal.last; i++) {
@@ -137,29 +145,24 @@ static void empty_line_handler(const void*) {}
 static void start_line_handler(const void* s)
 {
 	if (s) {
-		auto src = static_cast<const uintptr_t*>(s);
-		auto cache = reinterpret_cast<uintptr_t*>(render.scale.cacheRead);
-		for (Bits x = render.src_start; x > 0;) {
-			const auto src_ptr = reinterpret_cast<const uint8_t*>(src);
-			const auto src_val = read_unaligned_size_t(src_ptr);
-			if (src_val != cache[0]) {
-				if (!GFX_StartUpdate(render.scale.outWrite,
-				                     render.scale.outPitch)) {
-					RENDER_DrawLine = empty_line_handler;
-					return;
-				}
-				render.scale.outWrite += render.scale.outPitch *
-				                         Scaler_ChangedLines[0];
-				RENDER_DrawLine = render.scale.lineHandler;
-				RENDER_DrawLine(s);
+		const auto num_bytes = render.src_start * sizeof(uintptr_t);
+		if (std::memcmp(s, render.scale.cacheRead, num_bytes) != 0) {
+			if (!GFX_StartUpdate(render.scale.outWrite,
+			                     render.scale.outPitch)) {
+				RENDER_DrawLine = empty_line_handler;
 				return;
 			}
-			x--;
-			src++;
-			cache++;
+			render.scale.outWrite += render.scale.outPitch *
+			                         Scaler_ChangedLines[0];
+			RENDER_DrawLine = render.scale.lineHandler;
+			RENDER_DrawLine(s);
+			return;
 		}
 	}
 	render.scale.cacheRead += render.scale.cachePitch;
+	if (Scaler_NumRows < SCALER_MAXHEIGHT) {
+		Scaler_ChangedRows[Scaler_NumRows++] = 0;
+	}
 	Scaler_ChangedLines[0] += Scaler_Aspect[render.scale.inLine];
 	render.scale.inLine++;
 	render.scale.outLine++;
@@ -209,6 +212,10 @@ bool RENDER_StartUpdate(void)
 	render.scale.outPitch   = 0;
 	Scaler_ChangedLines[0]  = 0;
 	Scaler_ChangedLineIndex = 0;
+	Scaler_NumRows          = 0;
+
+	Scaler_ChangedColumnsStart = INT32_MAX;
+	Scaler_ChangedColumnsEnd   = 0;
 
 	// Clearing the cache will first process the line to make sure it's
 	// never the same
@@ -257,15 +264,25 @@ static void halt_render(void)
 
 extern uint32_t PIC_Ticks;
 
+static int64_t frame_count = 0;
+
+int64_t RENDER_GetFrameCount()
+{
+	return frame_count;
+}
+
 void RENDER_EndUpdate(bool abort)
 {
+	ZoneScoped;
 	if (!render.updating) {
 		return;
 	}
+	++frame_count;
 
 	RENDER_DrawLine = empty_line_handler;
 
-	if (CAPTURE_IsCapturingImage() || CAPTURE_IsCapturingVideo()) {
+	if (CAPTURE_IsCapturingImage() || CAPTURE_IsCapturingVideo() ||
+	    CAPTURE_IsCapturingFrameHashes() || CAPTURE_IsServingRemoteDisplay()) {
 		bool double_width  = false;
 		bool double_height = false;
 		if (render.src.double_width != render.src.double_height) {
@@ -286,13 +303,19 @@ void RENDER_EndUpdate(bool abort)
 		image.image_data           = (uint8_t*)&scalerSourceCache;
 		image.palette_data         = (uint8_t*)&render.pal.rgb;
 
+		// Only if every row went through the source cache comparison
+		if (!abort && Scaler_NumRows == render.src.height) {
+			image.changed_rows = Scaler_ChangedRows;
+		}
+
 		const auto frames_per_second = static_cast<float>(render.fps);
 
 		CAPTURE_AddFrame(image, frames_per_second);
 	}
 
 	if (render.scale.outWrite) {
-		GFX_EndUpdate(abort ? nullptr : Scaler_ChangedLines);
+		GFX_EndUpdate(abort ? nullptr : Scaler_ChangedLines,
+		              {Scaler_ChangedColumnsStart, Scaler_ChangedColumnsEnd});
 	} else {
 		// If we made it here, then there's nothing new to render.
 		GFX_EndUpdate(nullptr);
@@ -300,6 +323,78 @@ void RENDER_EndUpdate(bool abort)
 	render.updating = false;
 }
 
+// Buffers of the images shared with the capturers; a few are enough as the
+// screenshots are saved as fast as they're taken
+constexpr auto MaxPooledImageBuffers = 4;
+
+static std::mutex image_pool_mutex                   = {};
+static std::vector<std::vector<uint8_t>> image_pool = {};
+
+struct PooledImage {
+	RenderedImage image         = {};
+	std::vector<uint8_t> buffer = {};
+};
+
+// Called by the last owner of the image, possibly on another thread
+static void release_pooled_image(PooledImage* pooled)
+{
+	{
+		std::lock_guard lock(image_pool_mutex);
+		if (image_pool.size() < MaxPooledImageBuffers) {
+			image_pool.emplace_back(std::move(pooled->buffer));
+		}
+	}
+	delete pooled;
+}
+
+SharedRenderedImage RENDER_ShareImage(const RenderedImage& image)
+{
+	assert(image.image_data);
+
+	constexpr auto PaletteNumBytes = 256 * 4;
+
+	const auto image_num_bytes = static_cast<size_t>(image.params.height) *
+	                             image.pitch;
+	const auto num_bytes = image_num_bytes +
+	                       (image.palette_data ? PaletteNumBytes : 0);
+
+	auto pooled = new PooledImage();
+	{
+		std::lock_guard lock(image_pool_mutex);
+		if (!image_pool.empty()) {
+			pooled->buffer = std::move(image_pool.back());
+			image_pool.pop_back();
+		}
+	}
+	pooled->buffer.resize(num_bytes);
+
+	auto& copy = pooled->image;
+
+	copy              = image;
+	copy.changed_rows = nullptr;
+	copy.image_data   = pooled->buffer.data();
+	std::memcpy(copy.image_data, image.image_data, image_num_bytes);
+
+	if (image.palette_data) {
+		copy.palette_data = copy.image_data + image_num_bytes;
+		std::memcpy(copy.palette_data, image.palette_data, PaletteNumBytes);
+	}
+
+	const std::shared_ptr<const PooledImage> owner(pooled, release_pooled_image);
+	return SharedRenderedImage(owner, &owner->image);
+}
+
+SharedRenderedImage RENDER_AdoptImage(const RenderedImage& image)
+{
+	auto adopted          = new RenderedImage(image);
+	adopted->changed_rows = nullptr;
+
+	return SharedRenderedImage(adopted, [](RenderedImage* adopted) {
+		adopted->free();
+		delete adopted;
+	});
+}
+
 static Bitu make_aspect_table(Bitu height, double scaley, Bitu miny)
 {
 	Bitu i;
@@ -386,6 +481,13 @@ static void render_reset(void)
 
 	switch (render.src.pixel_format) {
 	case PixelFormat::Indexed8:
+		render.src_start = (render.src.width * 2) / src_pixel_bytes;
+		// Palettized frames can be doubled by the GPU while their
+		// colours are looked up, so ask for it
+		if (simpleBlock != &ScaleNormal1x) {
+			gfx_flags |= GFX_GPU_DOUBLING;
+		}
+		break;
 	case PixelFormat::RGB555_Packed16:
 	case PixelFormat::RGB565_Packed16:
 		render.src_start = (render.src.width * 2) / src_pixel_bytes;
@@ -435,6 +537,13 @@ static void render_reset(void)
 	                        render.src.video_mode,
 	                        &render_callback);
 
+	// The frames are then rendered at the source size and the doubled
+	// size above only describes the output
+	if (gfx_flags & GFX_GPU_DOUBLING) {
+		simpleBlock = &ScaleNormal1x;
+		make_aspect_table(render.src.height, 1, 1);
+	}
+
 	if (gfx_flags & GFX_CAN_8) {
 		render.scale.outMode = scalerMode8;
 	} else if (gfx_flags & GFX_CAN_15) {
@@ -24,6 +24,8 @@
 
 #include "dosbox.h"
 #include "render.h"
+
+#include <algorithm>
 #include <cstring>
 
 uint8_t Scaler_Aspect[SCALER_MAXHEIGHT]        = {};
@@ -31,6 +33,12 @@ uint16_t Scaler_ChangedLines[SCALER_MAXHEIGHT] = {};
 
 Bitu Scaler_ChangedLineIndex = 0;
 
+int Scaler_ChangedColumnsStart = 0;
+int Scaler_ChangedColumnsEnd   = 0;
+
+uint8_t Scaler_ChangedRows[SCALER_MAXHEIGHT] = {};
+int Scaler_NumRows = 0;
+
 static union {
 	 //The +1 is a at least for the normal scalers not needed. (-1 is enough)
 	 uint32_t b32[SCALER_MAX_MUL_HEIGHT + 1][SCALER_MAXWIDTH];
@@ -66,6 +74,9 @@ static inline void BituMove( void *_dst, const void * _src, Bitu size) {
 }
 
 static inline void ScalerAddLines( Bitu changed, Bitu count ) {
+	if (Scaler_NumRows < SCALER_MAXHEIGHT) {
+		Scaler_ChangedRows[Scaler_NumRows++] = static_cast<uint8_t>(changed);
+	}
 	if ((Scaler_ChangedLineIndex & 1) == changed ) {
 		Scaler_ChangedLines[Scaler_ChangedLineIndex] += count;
 	} else {
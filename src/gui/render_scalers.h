@@ -50,6 +50,16 @@ extern uint8_t diff_table[];
 extern Bitu Scaler_ChangedLineIndex;
 extern uint16_t Scaler_ChangedLines[];
 
+// Output pixel columns the scalers have written to in the current frame,
+// the end being exclusive
+extern int Scaler_ChangedColumnsStart;
+extern int Scaler_ChangedColumnsEnd;
+
+// Whether each source row drawn so far in the current frame differed from
+// the source cache, i.e. from the same row of the previous frame
+extern uint8_t Scaler_ChangedRows[];
+extern int Scaler_NumRows;
+
 union scalerSourceCache_t {
 	uint32_t b32	[SCALER_MAXHEIGHT] [SCALER_MAXWIDTH];
 	uint16_t b16	[SCALER_MAXHEIGHT] [SCALER_MAXWIDTH];
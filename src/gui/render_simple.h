@@ -43,6 +43,24 @@ static void conc4d(SCALERNAME,SBPP,DBPP,R)(const void *s) {
 		return;
 	}
 #endif
+	// Most lines of a frame are usually unchanged, and comparing them
+	// in one go is a lot faster than going through them in blocks. With
+	// a palette change, unchanged lines can still have changed colours.
+#if (SBPP == 9)
+	const bool may_be_unchanged = !render.pal.changed;
+#else
+	constexpr bool may_be_unchanged = true;
+#endif
+	if (may_be_unchanged &&
+	    std::memcmp(s, render.scale.cacheRead, render.scale.cachePitch) == 0) {
+		render.scale.cacheRead += render.scale.cachePitch;
+#if defined(SCALERLINEAR)
+		ScalerAddLines(0, SCALERHEIGHT);
+#else
+		ScalerAddLines(0, Scaler_Aspect[render.scale.outLine++]);
+#endif
+		return;
+	}
 	/* Clear the complete line marker */
 	Bitu hadChange = 0;
 	auto src   = static_cast<const SRCTYPE*>(s);
@@ -85,6 +103,9 @@ static void conc4d(SCALERNAME,SBPP,DBPP,R)(const void *s) {
 #endif
 #endif //defined(SCALERLINEAR)
 			hadChange = 1;
+			const auto first_column = static_cast<int>(render.src.width - x);
+			Scaler_ChangedColumnsStart = std::min(Scaler_ChangedColumnsStart,
+			                                      first_column * SCALERWIDTH);
 			for (Bitu i = x > 32 ? 32 : x;i>0;i--,x--) {
 				const SRCTYPE S = *src;
 				*cache = S;
@@ -96,6 +117,9 @@ static void conc4d(SCALERNAME,SBPP,DBPP,R)(const void *s) {
 				line1 += SCALERWIDTH;
 #endif
 			}
+			const auto end_column = static_cast<int>(render.src.width - x);
+			Scaler_ChangedColumnsEnd = std::max(Scaler_ChangedColumnsEnd,
+			                                    end_column * SCALERWIDTH);
 #if defined(SCALERLINEAR)
 #if (SCALERHEIGHT > 1)
 			Bitu copyLen = (Bitu)((uint8_t*)line1 - (uint8_t*)WC[0]);
@@ -32,6 +32,7 @@
 #include <atomic>
 #include <list>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include <SDL.h>
@@ -100,7 +101,7 @@ class CBindGroup;
 
 static void SetActiveEvent(CEvent * event);
 static void SetActiveBind(CBind * _bind);
-extern uint8_t int10_font_14[256 * 14];
+extern const uint8_t int10_font_14[256 * 14];
 
 static std::vector<std::unique_ptr<CEvent>> events;
 static std::vector<std::unique_ptr<CButton>> buttons;
@@ -921,6 +922,12 @@ private:
 			return "[missing joystick]";
 	}
 
+public:
+	int GetStickId() const
+	{
+		return stick_id;
+	}
+
 protected:
 	CBindList *pos_axis_lists = nullptr;
 	CBindList *neg_axis_lists = nullptr;
@@ -951,6 +958,10 @@ protected:
 
 std::list<CStickBindGroup *> stickbindgroups;
 
+// The bind groups of the active joysticks, indexed by the instance ID that
+// SDL reports in their events
+static std::unordered_map<int, std::vector<CBindGroup *>> stick_groups_by_id = {};
+
 class C4AxisBindGroup final : public  CStickBindGroup {
 public:
 	C4AxisBindGroup(uint8_t _stick, uint8_t _emustick) : CStickBindGroup(_stick, _emustick)
@@ -2773,13 +2784,44 @@ static bool load_binds_from_file(const std::string_view mapperfile_path,
 	return was_loaded;
 }
 
-void MAPPER_CheckEvent(SDL_Event *event)
+static void check_stick_event(const int stick_id, SDL_Event *event)
 {
-	for (auto &group : bindgroups)
+	const auto groups = stick_groups_by_id.find(stick_id);
+	if (groups == stick_groups_by_id.end()) {
+		return;
+	}
+	for (auto &group : groups->second)
 		if (group->CheckEvent(event))
 			return;
 }
 
+void MAPPER_CheckEvent(SDL_Event *event)
+{
+	// Hand the event straight to the groups of its device instead of
+	// offering it to every group in turn
+	switch (event->type) {
+	case SDL_KEYDOWN:
+	case SDL_KEYUP:
+		for (auto &group : keybindgroups)
+			if (group->CheckEvent(event))
+				return;
+		break;
+	case SDL_JOYAXISMOTION:
+		check_stick_event(event->jaxis.which, event);
+		break;
+	case SDL_JOYBUTTONDOWN:
+	case SDL_JOYBUTTONUP:
+		check_stick_event(event->jbutton.which, event);
+		break;
+	case SDL_JOYHATMOTION:
+		check_stick_event(event->jhat.which, event);
+		break;
+	default:
+		// None of the bind groups handle other events
+		break;
+	}
+}
+
 void BIND_MappingEvents() {
 	SDL_Event event;
 	static bool isButtonPressed = false;
@@ -3034,6 +3076,17 @@ static void CreateBindGroups() {
 	}
 }
 
+static void IndexStickBindGroups()
+{
+	stick_groups_by_id.clear();
+	for (Bitu i = 0; i < mapper.sticks.num_groups; ++i) {
+		const auto group = mapper.sticks.stick[i];
+		if (group && group->GetStickId() >= 0) {
+			stick_groups_by_id[group->GetStickId()].push_back(group);
+		}
+	}
+}
+
 bool MAPPER_IsUsingJoysticks() {
 	return (mapper.sticks.num > 0);
 }
@@ -3132,9 +3185,10 @@ void MAPPER_DisplayUI() {
 		            SDL_GetError());
 	}
 
-	// Create font atlas surface
+	// Create font atlas surface; SDL only reads the pixels of surfaces
+	// created from existing data
 	SDL_Surface* atlas_surface = SDL_CreateRGBSurfaceFrom(
-	        int10_font_14, 8, 256 * 14, 1, 1, 0, 0, 0, 0);
+	        const_cast<uint8_t*>(int10_font_14), 8, 256 * 14, 1, 1, 0, 0, 0, 0);
 	if (atlas_surface == nullptr) {
 		E_Exit("MAPPER: Failed to create atlas surface: %s", SDL_GetError());
 	}
@@ -3231,6 +3285,8 @@ static void MAPPER_Destroy(Section *sec) {
 		delete ptr;
 	stickbindgroups.clear();
 
+	stick_groups_by_id.clear();
+
 	// Free any allocated sticks
 	for (int i = 0; i < MAXSTICKS; ++i) {
 		delete mapper.sticks.stick[i];
@@ -3286,8 +3342,10 @@ void MAPPER_BindKeys(Section* sec)
 	if (buttons.empty())
 		CreateLayout();
 
-	if (bindgroups.empty())
+	if (bindgroups.empty()) {
 		CreateBindGroups();
+		IndexStickBindGroups();
+	}
 
 	// Create binds from file or fallback to internals
 	if (!load_binds_from_file(mapper.filename, mapperfile_value))
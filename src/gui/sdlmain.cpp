@@ -24,14 +24,18 @@
 #include <array>
 #include <cassert>
 #include <cerrno>
+#include <cinttypes>
 #include <cmath>
 #include <cstdarg>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <fstream>
 #include <sys/types.h>
 #include <tuple>
+#include <unordered_map>
 #include <unistd.h>
+#include <utility>
 
 #if C_DEBUG
 #include <queue>
@@ -56,6 +60,7 @@
 #include "cross.h"
 #include "debug.h"
 #include "fs_utils.h"
+#include "host_memory.h"
 #include "gui_msgs.h"
 #include "joystick.h"
 #include "keyboard.h"
@@ -65,6 +70,7 @@
 #include "mouse.h"
 #include "pacer.h"
 #include "pic.h"
+#include "present_clock.h"
 #include "rect.h"
 #include "render.h"
 #include "sdlmain.h"
@@ -112,6 +118,30 @@ typedef void (APIENTRYP PFNGLUNIFORM1IPROC) (GLint location, GLint v0);
 typedef void (APIENTRYP PFNGLUSEPROGRAMPROC) (GLuint program);
 typedef void (APIENTRYP PFNGLVERTEXATTRIBPOINTERPROC) (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const GLvoid *pointer);
 
+// Pixel buffer objects and fences, for the persistently mapped upload path
+typedef void (APIENTRYP PFNGLGENBUFFERSPROC) (GLsizei n, GLuint *buffers);
+typedef void (APIENTRYP PFNGLDELETEBUFFERSPROC) (GLsizei n, const GLuint *buffers);
+typedef void (APIENTRYP PFNGLBINDBUFFERPROC) (GLenum target, GLuint buffer);
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC) (GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+typedef void *(APIENTRYP PFNGLMAPBUFFERRANGEPROC) (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+typedef GLboolean (APIENTRYP PFNGLUNMAPBUFFERPROC) (GLenum target);
+typedef GLsync (APIENTRYP PFNGLFENCESYNCPROC) (GLenum condition, GLbitfield flags);
+typedef GLenum (APIENTRYP PFNGLCLIENTWAITSYNCPROC) (GLsync sync, GLbitfield flags, GLuint64 timeout);
+typedef void (APIENTRYP PFNGLDELETESYNCPROC) (GLsync sync);
+
+// Program binaries, for the shader cache
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC) (GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC) (GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC) (GLuint program, GLenum pname, GLint value);
+
+// Framebuffer objects and multitexturing, for the palette lookup pass
+typedef void (APIENTRYP PFNGLGENFRAMEBUFFERSPROC) (GLsizei n, GLuint *framebuffers);
+typedef void (APIENTRYP PFNGLDELETEFRAMEBUFFERSPROC) (GLsizei n, const GLuint *framebuffers);
+typedef void (APIENTRYP PFNGLBINDFRAMEBUFFERPROC) (GLenum target, GLuint framebuffer);
+typedef void (APIENTRYP PFNGLFRAMEBUFFERTEXTURE2DPROC) (GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level);
+typedef GLenum (APIENTRYP PFNGLCHECKFRAMEBUFFERSTATUSPROC) (GLenum target);
+typedef void (APIENTRYP PFNGLACTIVETEXTUREPROC) (GLenum texture);
+
 /* Apple defines these functions in their GL header (as core functions)
  * so we can't use their names as function pointers. We can't link
  * directly as some platforms may not have them. So they get their own
@@ -137,6 +167,27 @@ PFNGLUNIFORM2FPROC glUniform2f = nullptr;
 PFNGLUNIFORM1IPROC glUniform1i = nullptr;
 PFNGLUSEPROGRAMPROC glUseProgram = nullptr;
 PFNGLVERTEXATTRIBPOINTERPROC glVertexAttribPointer = nullptr;
+
+PFNGLGENBUFFERSPROC glGenBuffers = nullptr;
+PFNGLDELETEBUFFERSPROC glDeleteBuffers = nullptr;
+PFNGLBINDBUFFERPROC glBindBuffer = nullptr;
+PFNGLBUFFERSTORAGEPROC glBufferStorage = nullptr;
+PFNGLMAPBUFFERRANGEPROC glMapBufferRange = nullptr;
+PFNGLUNMAPBUFFERPROC glUnmapBuffer = nullptr;
+PFNGLFENCESYNCPROC glFenceSync = nullptr;
+PFNGLCLIENTWAITSYNCPROC glClientWaitSync = nullptr;
+PFNGLDELETESYNCPROC glDeleteSync = nullptr;
+
+PFNGLGETPROGRAMBINARYPROC glGetProgramBinary = nullptr;
+PFNGLPROGRAMBINARYPROC glProgramBinary = nullptr;
+PFNGLPROGRAMPARAMETERIPROC glProgramParameteri = nullptr;
+
+PFNGLGENFRAMEBUFFERSPROC glGenFramebuffers = nullptr;
+PFNGLDELETEFRAMEBUFFERSPROC glDeleteFramebuffers = nullptr;
+PFNGLBINDFRAMEBUFFERPROC glBindFramebuffer = nullptr;
+PFNGLFRAMEBUFFERTEXTURE2DPROC glFramebufferTexture2D = nullptr;
+PFNGLCHECKFRAMEBUFFERSTATUSPROC glCheckFramebufferStatus = nullptr;
+PFNGLACTIVETEXTUREPROC glActiveTexture = nullptr;
 }
 
 /* "using" is meant to hide identical names declared in outer scope
@@ -161,6 +212,24 @@ PFNGLVERTEXATTRIBPOINTERPROC glVertexAttribPointer = nullptr;
 #define glUniform1i               gl2::glUniform1i
 #define glUseProgram              gl2::glUseProgram
 #define glVertexAttribPointer     gl2::glVertexAttribPointer
+#define glGenBuffers              gl2::glGenBuffers
+#define glDeleteBuffers           gl2::glDeleteBuffers
+#define glBindBuffer              gl2::glBindBuffer
+#define glBufferStorage           gl2::glBufferStorage
+#define glMapBufferRange          gl2::glMapBufferRange
+#define glUnmapBuffer             gl2::glUnmapBuffer
+#define glFenceSync               gl2::glFenceSync
+#define glClientWaitSync          gl2::glClientWaitSync
+#define glDeleteSync              gl2::glDeleteSync
+#define glGetProgramBinary        gl2::glGetProgramBinary
+#define glProgramBinary           gl2::glProgramBinary
+#define glProgramParameteri       gl2::glProgramParameteri
+#define glGenFramebuffers         gl2::glGenFramebuffers
+#define glDeleteFramebuffers      gl2::glDeleteFramebuffers
+#define glBindFramebuffer         gl2::glBindFramebuffer
+#define glFramebufferTexture2D    gl2::glFramebufferTexture2D
+#define glCheckFramebufferStatus  gl2::glCheckFramebufferStatus
+#define glActiveTexture           gl2::glActiveTexture
 
 #endif // C_OPENGL
 
@@ -208,13 +277,16 @@ static SDL_Rect to_sdl_rect(const DosBox::Rect& r)
 static void clean_up_sdl_resources();
 static void handle_video_resize(int width, int height);
 
-static void update_frame_texture([[maybe_unused]] const uint16_t* changedLines);
+static void update_frame_texture(const uint16_t* changedLines,
+                                 const ChangedColumns& changed_columns);
 static bool present_frame_texture();
 #if C_OPENGL
-static void update_frame_gl(const uint16_t *changedLines);
+static void update_frame_gl(const uint16_t* changedLines,
+                            const ChangedColumns& changed_columns);
 static bool present_frame_gl();
 static const char* safe_gl_get_string(const GLenum requested_name,
                                       const char* default_result);
+static void forget_gl_context_objects();
 #endif
 
 static const char* vsync_state_as_string(const VsyncState state)
@@ -580,7 +652,16 @@ static bool is_command_pressed(const SDL_Event event)
 
 uint8_t GFX_GetBestMode(const uint8_t flags)
 {
-	return (flags & GFX_CAN_32) & ~(GFX_CAN_8 | GFX_CAN_15 | GFX_CAN_16);
+	uint8_t best_mode = flags & GFX_CAN_32;
+#if C_OPENGL
+	// Indexed frames can be kept for the palette lookup pass, which
+	// only runs ahead of a shader
+	if (sdl.want_rendering_backend == RenderingBackend::OpenGl &&
+	    sdl.opengl.use_shader && sdl.opengl.indexed_supported) {
+		best_mode |= flags & (GFX_CAN_8 | GFX_GPU_DOUBLING);
+	}
+#endif
+	return best_mode;
 }
 
 // Let the presentation layer safely call no-op functions.
@@ -819,6 +900,18 @@ static void save_rate_to_frame_period(const double rate_hz)
 
 static std::unique_ptr<Pacer> render_pacer = {};
 
+static PresentClock present_clock = {};
+
+// Presents the frame and feeds the vblank prediction if it was presented
+static bool present_frame()
+{
+	const auto presented = sdl.frame.present();
+	if (presented) {
+		present_clock.AddPresent(GetTicksUs());
+	}
+	return presented;
+}
+
 static int benchmark_presentation_rate()
 {
 	// If the presentation function is empty, then we can't benchmark
@@ -837,13 +930,13 @@ static int benchmark_presentation_rate()
 
 	// Warmup round
 	for (auto i = 0; i < warmup_frames; ++i) {
-		sdl.frame.update(nullptr);
+		sdl.frame.update(nullptr, {});
 		sdl.frame.present();
 	}
 	// Measured round
 	const auto start_us = GetTicksUs();
 	for (auto frame = 0; frame < bench_frames; ++frame) {
-		sdl.frame.update(nullptr);
+		sdl.frame.update(nullptr, {});
 		sdl.frame.present();
 	}
 	const auto elapsed_us = std::max(static_cast<int64_t>(1L), GetTicksUsSince(start_us));
@@ -986,7 +1079,7 @@ static void maybe_present_throttled(const bool frame_is_new)
 		last_present_time = now - (9 * wait_overage / 10);
 
 		if (frame_is_new || was_new_and_throttled) {
-			sdl.frame.present();
+			present_frame();
 		}
 	}
 	// Otherwise we've had to throttle the frame, however if the frame was
@@ -1012,9 +1105,15 @@ static void maybe_present_synced(const bool present_if_last_skipped)
 	const auto should_present = on_time || (present_if_last_skipped &&
 	                                        !last_frame_presented);
 
-	last_frame_presented = should_present ? sdl.frame.present() : false;
+	last_frame_presented = should_present ? present_frame() : false;
 
-	last_sync_time = should_present ? GetTicksUs() : now;
+	// Measure the arrivals from the vblank the presentation waited for
+	// rather than from when we got to run again after it, which
+	// includes the host scheduler's jitter
+	const auto after_present = should_present ? GetTicksUs() : now;
+	last_sync_time = (last_frame_presented && present_clock.IsLocked())
+	                       ? present_clock.PredictLastVblank(after_present)
+	                       : after_present;
 }
 
 static void setup_presentation_mode(FrameMode &previous_mode)
@@ -1024,6 +1123,7 @@ static void setup_presentation_mode(FrameMode &previous_mode)
 	// next mode change.
 	const auto host_rate = get_host_refresh_rate();
 	VGA_SetHostRate(host_rate);
+	present_clock.SetNominalPeriod(iround(1'000'000 / host_rate));
 	const auto dos_rate = VGA_GetPreferredRate();
 
 	// Calculate the maximum number of duplicate frames before presenting
@@ -1311,6 +1411,7 @@ static SDL_Window* SetWindowMode(const RenderingBackend rendering_backend,
 			if (sdl.opengl.context) {
 				SDL_GL_DeleteContext(sdl.opengl.context);
 				sdl.opengl.context = nullptr;
+				forget_gl_context_objects();
 			}
 
 			assert(sdl.opengl.context == nullptr);
@@ -1505,6 +1606,73 @@ static const char *safe_gl_get_string(const GLenum requested_name,
 	return result ? reinterpret_cast<const char *>(result) : default_result;
 }
 
+// The frame buffer the renderer writes to is either a persistently mapped
+// pixel buffer object, so the texture updates are done by the GPU straight
+// from it, or regular memory the driver copies from.
+static void free_gl_framebuffer()
+{
+	if (sdl.opengl.pixel_buffer_fence) {
+		glDeleteSync(sdl.opengl.pixel_buffer_fence);
+		sdl.opengl.pixel_buffer_fence = nullptr;
+	}
+	if (sdl.opengl.pixel_buffer) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, sdl.opengl.pixel_buffer);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		glDeleteBuffers(1, &sdl.opengl.pixel_buffer);
+		sdl.opengl.pixel_buffer = 0;
+	} else {
+		free(sdl.opengl.framebuf);
+	}
+	sdl.opengl.framebuf = nullptr;
+}
+
+static void allocate_gl_framebuffer(const size_t num_bytes)
+{
+	assert(!sdl.opengl.framebuf && !sdl.opengl.pixel_buffer);
+
+	if (sdl.opengl.pixel_buffer_supported) {
+		constexpr GLbitfield flags = GL_MAP_WRITE_BIT |
+		                             GL_MAP_PERSISTENT_BIT |
+		                             GL_MAP_COHERENT_BIT;
+		const auto size = static_cast<GLsizeiptr>(num_bytes);
+
+		glGenBuffers(1, &sdl.opengl.pixel_buffer);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, sdl.opengl.pixel_buffer);
+		glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, nullptr, flags);
+		sdl.opengl.framebuf = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER,
+		                                       0,
+		                                       size,
+		                                       flags);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		if (sdl.opengl.framebuf) {
+			return;
+		}
+		LOG_WARNING("OPENGL: Failed to map the pixel buffer, "
+		            "uploading frames from system memory");
+		glDeleteBuffers(1, &sdl.opengl.pixel_buffer);
+		sdl.opengl.pixel_buffer           = 0;
+		sdl.opengl.pixel_buffer_supported = false;
+	}
+	sdl.opengl.framebuf = malloc(num_bytes);
+}
+
+// Waits until the GPU has finished the texture updates from the pixel
+// buffer, which usually happened long before the next frame is rendered
+static void wait_for_gl_pixel_buffer()
+{
+	if (!sdl.opengl.pixel_buffer_fence) {
+		return;
+	}
+	constexpr GLuint64 timeout_ns = 1'000'000'000;
+	glClientWaitSync(sdl.opengl.pixel_buffer_fence,
+	                 GL_SYNC_FLUSH_COMMANDS_BIT,
+	                 timeout_ns);
+	glDeleteSync(sdl.opengl.pixel_buffer_fence);
+	sdl.opengl.pixel_buffer_fence = nullptr;
+}
+
 /* Create a GLSL shader object, load the shader source, and compile the shader. */
 static GLuint BuildShader(GLenum type, const std::string& source)
 {
@@ -1574,6 +1742,7 @@ static GLuint BuildShader(GLenum type, const std::string& source)
 static bool LoadGLShaders(const std::string& source, GLuint *vertex,
                           GLuint *fragment)
 {
+	ZoneScoped;
 	if (source.empty())
 		return false;
 
@@ -1592,6 +1761,302 @@ static bool LoadGLShaders(const std::string& source, GLuint *vertex,
 	}
 	return false;
 }
+
+// Linked shader programs are cached as driver-specific binaries, so they
+// don't have to be compiled again on the next start or shader switch. The
+// cache files are named by a hash of the shader source and the driver;
+// they start with the binary format followed by the binary itself.
+static std_fs::path get_program_binary_path(const std::string& source)
+{
+	// 64-bit FNV-1a, which is stable across builds and hosts
+	uint64_t hash = 0xcbf2'9ce4'8422'2325;
+	auto add_to_hash = [&hash](const std::string_view str) {
+		for (const auto c : str) {
+			hash ^= static_cast<uint8_t>(c);
+			hash *= 0x0000'0100'0000'01b3;
+		}
+	};
+	add_to_hash(source);
+	add_to_hash(safe_gl_get_string(GL_VENDOR));
+	add_to_hash(safe_gl_get_string(GL_RENDERER));
+	add_to_hash(safe_gl_get_string(GL_VERSION));
+
+	char name[32] = {};
+	safe_sprintf(name, "%016" PRIx64 ".bin", hash);
+	return GetConfigDir() / "shader-cache" / name;
+}
+
+static GLuint load_cached_program(const std::string& source)
+{
+	if (!sdl.opengl.program_binary_supported) {
+		return 0;
+	}
+	std::ifstream file(get_program_binary_path(source), std::ios::binary);
+	if (!file) {
+		return 0;
+	}
+	uint32_t format = 0;
+	file.read(reinterpret_cast<char*>(&format), sizeof(format));
+	const std::vector<char> binary((std::istreambuf_iterator<char>(file)),
+	                               std::istreambuf_iterator<char>());
+	if (!file.eof() || binary.empty()) {
+		return 0;
+	}
+
+	const auto program = glCreateProgram();
+	if (!program) {
+		return 0;
+	}
+	glProgramBinary(program,
+	                static_cast<GLenum>(format),
+	                binary.data(),
+	                static_cast<GLsizei>(binary.size()));
+
+	// Driver updates can reject binaries of older versions
+	GLint is_program_linked = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &is_program_linked);
+	if (!is_program_linked) {
+		glDeleteProgram(program);
+		return 0;
+	}
+	return program;
+}
+
+// Programs linked in this session stay alive after switching to another
+// shader, so switching back (e.g., when an application flips between text
+// and graphics modes with shader auto-switching) needs no rebuild at all
+static std::unordered_map<std::string, GLuint> linked_programs = {};
+
+static GLuint find_linked_program(const std::string& source)
+{
+	const auto it = linked_programs.find(source);
+	return it != linked_programs.end() ? it->second : 0;
+}
+
+static void save_program_to_cache(const GLuint program, const std::string& source)
+{
+	if (!sdl.opengl.program_binary_supported) {
+		return;
+	}
+	GLint binary_len = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binary_len);
+	if (binary_len <= 0) {
+		return;
+	}
+	std::vector<char> binary(static_cast<size_t>(binary_len));
+	GLenum format = 0;
+	glGetProgramBinary(program, binary_len, nullptr, &format, binary.data());
+
+	const auto path = get_program_binary_path(source);
+	std::error_code ec = {};
+	std_fs::create_directories(path.parent_path(), ec);
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	const auto format_u32 = static_cast<uint32_t>(format);
+	file.write(reinterpret_cast<const char*>(&format_u32), sizeof(format_u32));
+	file.write(binary.data(), static_cast<std::streamsize>(binary.size()));
+	if (!file) {
+		LOG_WARNING("OPENGL: Failed to write shader cache file '%s'",
+		            path.string().c_str());
+	}
+}
+
+// Frames of the 8-bit palettized modes are uploaded as they are, a
+// quarter of the size of 32-bit ones, and a pass before the shader looks
+// up their colours in a palette texture. Palette changes then only update
+// that texture instead of redrawing the affected pixels on the CPU.
+static const char* palette_lookup_shader_source = R"GLSL(#version 130
+
+#if defined(VERTEX)
+in vec2 a_position;
+
+void main()
+{
+	gl_Position = vec4(a_position, 0.0, 1.0);
+}
+
+#elif defined(FRAGMENT)
+uniform sampler2D indexTexture;
+uniform sampler2D paletteTexture;
+uniform ivec2 indexScale;
+
+void main()
+{
+	ivec2 coord = ivec2(gl_FragCoord.xy) / indexScale;
+	float index = texelFetch(indexTexture, coord, 0).r;
+	ivec2 entry = ivec2(int(index * 255.0 + 0.5), 0);
+	gl_FragColor = vec4(texelFetch(paletteTexture, entry, 0).rgb, 1.0);
+}
+#endif
+)GLSL";
+
+static void free_gl_palette_lookup()
+{
+	if (sdl.opengl.palette_framebuffer) {
+		glDeleteFramebuffers(1, &sdl.opengl.palette_framebuffer);
+		sdl.opengl.palette_framebuffer = 0;
+	}
+	if (sdl.opengl.index_texture) {
+		glDeleteTextures(1, &sdl.opengl.index_texture);
+		sdl.opengl.index_texture = 0;
+	}
+	if (sdl.opengl.palette_texture) {
+		glDeleteTextures(1, &sdl.opengl.palette_texture);
+		sdl.opengl.palette_texture = 0;
+	}
+	if (sdl.opengl.palette_program) {
+		glDeleteProgram(sdl.opengl.palette_program);
+		sdl.opengl.palette_program = 0;
+	}
+	sdl.opengl.use_indexed          = false;
+	sdl.opengl.needs_palette_lookup = false;
+	sdl.opengl.index_width_px       = 0;
+	sdl.opengl.index_height_px      = 0;
+}
+
+// Sets up the pass rendering into the frame texture, which is bound. The
+// index texture is a scale_x by scale_y fraction of the frame texture's
+// size, and each of its pixels is repeated to fill the frame; this
+// replaces the scalers' doubling when the renderer has left it to us.
+static bool setup_gl_palette_lookup(const int width_px, const int height_px,
+                                    const int scale_x, const int scale_y)
+{
+	free_gl_palette_lookup();
+
+	GLuint vertex_shader = 0, fragment_shader = 0;
+	if (!LoadGLShaders(palette_lookup_shader_source,
+	                   &vertex_shader,
+	                   &fragment_shader)) {
+		return false;
+	}
+	const auto program = glCreateProgram();
+	sdl.opengl.palette_program = program;
+	if (program) {
+		glAttachShader(program, vertex_shader);
+		glAttachShader(program, fragment_shader);
+		glLinkProgram(program);
+	}
+	glDeleteShader(vertex_shader);
+	glDeleteShader(fragment_shader);
+
+	GLint is_program_linked = 0;
+	if (program) {
+		glGetProgramiv(program, GL_LINK_STATUS, &is_program_linked);
+	}
+	if (!is_program_linked) {
+		free_gl_palette_lookup();
+		return false;
+	}
+
+	auto create_texture = [](const GLint format, const int width,
+	                         const int height, const GLenum pixel_format) {
+		GLuint texture = 0;
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0,
+		             pixel_format, GL_UNSIGNED_BYTE, nullptr);
+		return texture;
+	};
+	const auto index_width_px  = width_px / scale_x;
+	const auto index_height_px = height_px / scale_y;
+
+	sdl.opengl.index_texture = create_texture(GL_R8,
+	                                          index_width_px,
+	                                          index_height_px,
+	                                          GL_RED);
+	sdl.opengl.palette_texture = create_texture(GL_RGBA8, 256, 1, GL_RGBA);
+
+	// The shaders only sample the first texture unit, so the palette
+	// can stay bound to the second one
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, sdl.opengl.palette_texture);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, sdl.opengl.texture);
+
+	glGenFramebuffers(1, &sdl.opengl.palette_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, sdl.opengl.palette_framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER,
+	                       GL_COLOR_ATTACHMENT0,
+	                       GL_TEXTURE_2D,
+	                       sdl.opengl.texture,
+	                       0);
+	const auto is_complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) ==
+	                         GL_FRAMEBUFFER_COMPLETE;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (!is_complete) {
+		LOG_WARNING("OPENGL: Can't render into the frame texture, "
+		            "uploading indexed frames as 32-bit");
+		free_gl_palette_lookup();
+		return false;
+	}
+
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "indexTexture"), 0);
+	glUniform1i(glGetUniformLocation(program, "paletteTexture"), 1);
+	glUniform2i(glGetUniformLocation(program, "indexScale"), scale_x, scale_y);
+
+	// Both programs draw the same triangle
+	const auto position = glGetAttribLocation(program, "a_position");
+	glVertexAttribPointer(position, 2, GL_FLOAT, GL_FALSE, 0, sdl.opengl.vertex_data);
+	glEnableVertexAttribArray(position);
+	glUseProgram(sdl.opengl.program_object);
+
+	sdl.opengl.use_indexed     = true;
+	sdl.opengl.index_width_px  = index_width_px;
+	sdl.opengl.index_height_px = index_height_px;
+	return true;
+}
+
+static void run_gl_palette_lookup()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, sdl.opengl.palette_framebuffer);
+	glViewport(0, 0, sdl.draw.render_width_px, sdl.draw.render_height_px);
+
+	// The frame texture holds the colours as they were uploaded before,
+	// so they must not be encoded again
+	if (sdl.opengl.framebuffer_is_srgb_encoded) {
+		glDisable(GL_FRAMEBUFFER_SRGB);
+	}
+
+	glUseProgram(sdl.opengl.palette_program);
+	glBindTexture(GL_TEXTURE_2D, sdl.opengl.index_texture);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+
+	glBindTexture(GL_TEXTURE_2D, sdl.opengl.texture);
+	glUseProgram(sdl.opengl.program_object);
+
+	if (sdl.opengl.framebuffer_is_srgb_encoded) {
+		glEnable(GL_FRAMEBUFFER_SRGB);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(sdl.draw_rect_px.x,
+	           sdl.draw_rect_px.y,
+	           sdl.draw_rect_px.w,
+	           sdl.draw_rect_px.h);
+
+	sdl.opengl.needs_palette_lookup = false;
+}
+
+// The objects went away along with the context they were created in, and
+// their names may be handed out again by the new one
+static void forget_gl_context_objects()
+{
+	linked_programs.clear();
+
+	sdl.opengl.index_texture        = 0;
+	sdl.opengl.palette_texture      = 0;
+	sdl.opengl.palette_framebuffer  = 0;
+	sdl.opengl.palette_program      = 0;
+	sdl.opengl.use_indexed          = false;
+	sdl.opengl.needs_palette_lookup = false;
+	sdl.opengl.index_width_px       = 0;
+	sdl.opengl.index_height_px      = 0;
+}
 #endif
 
 static bool is_using_kmsdrm_driver()
@@ -1695,6 +2160,9 @@ uint8_t GFX_SetSize(const int render_width_px, const int render_height_px,
 	switch (sdl.want_rendering_backend ) {
 	case RenderingBackend::Texture: {
 	fallback_texture: // FIXME: Must be replaced with a proper fallback system.
+#if C_OPENGL
+		sdl.opengl.use_indexed = false;
+#endif
 
 		if (!SetupWindowScaled(RenderingBackend::Texture)) {
 			LOG_ERR("DISPLAY: Can't initialise 'texture' window");
@@ -1796,8 +2264,7 @@ uint8_t GFX_SetSize(const int render_width_px, const int render_height_px,
 	}
 	case RenderingBackend::OpenGl: {
 #if C_OPENGL
-		free(sdl.opengl.framebuf);
-		sdl.opengl.framebuf = nullptr;
+		free_gl_framebuffer();
 		if (!(flags & GFX_CAN_32)) {
 			goto fallback_texture;
 		}
@@ -1860,6 +2327,8 @@ uint8_t GFX_SetSize(const int render_width_px, const int render_height_px,
 					glUseProgram(sdl.opengl.program_object);
 					if (glGetError() != GL_NO_ERROR) {
 						// program is not usable (probably new context), purge it
+						// along with the others linked in the old context
+						linked_programs.clear();
 						glDeleteProgram(sdl.opengl.program_object);
 						sdl.opengl.program_object = 0;
 					}
@@ -1867,69 +2336,88 @@ uint8_t GFX_SetSize(const int render_width_px, const int render_height_px,
 
 				// does program need to be rebuilt?
 				if (sdl.opengl.program_object == 0) {
-					GLuint vertexShader, fragmentShader;
-
-					if (!LoadGLShaders(sdl.opengl.shader_source,
-					                   &vertexShader,
-					                   &fragmentShader)) {
-						LOG_ERR("OPENGL: Failed to compile shader");
-						goto fallback_texture;
+					sdl.opengl.program_object = find_linked_program(
+					        sdl.opengl.shader_source);
+					if (sdl.opengl.program_object == 0) {
+						sdl.opengl.program_object = load_cached_program(
+						        sdl.opengl.shader_source);
 					}
+					if (sdl.opengl.program_object == 0) {
+						GLuint vertexShader, fragmentShader;
+
+						if (!LoadGLShaders(sdl.opengl.shader_source,
+						                   &vertexShader,
+						                   &fragmentShader)) {
+							LOG_ERR("OPENGL: Failed to compile shader");
+							goto fallback_texture;
+						}
+
+						sdl.opengl.program_object = glCreateProgram();
+						if (!sdl.opengl.program_object) {
+							glDeleteShader(vertexShader);
+							glDeleteShader(fragmentShader);
+
+							LOG_WARNING("OPENGL: Can't create program object, "
+							            "falling back to texture");
+							goto fallback_texture;
+						}
+						glAttachShader(sdl.opengl.program_object, vertexShader);
+						glAttachShader(sdl.opengl.program_object, fragmentShader);
+
+						if (sdl.opengl.program_binary_supported) {
+							glProgramParameteri(sdl.opengl.program_object,
+							                    GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+							                    GL_TRUE);
+						}
 
-					sdl.opengl.program_object = glCreateProgram();
-					if (!sdl.opengl.program_object) {
+						// Link the program
+						glLinkProgram(sdl.opengl.program_object);
+
+						// Even if we *are* successful, we may delete the shader objects
 						glDeleteShader(vertexShader);
 						glDeleteShader(fragmentShader);
 
-						LOG_WARNING("OPENGL: Can't create program object, "
-						            "falling back to texture");
-						goto fallback_texture;
-					}
-					glAttachShader(sdl.opengl.program_object, vertexShader);
-					glAttachShader(sdl.opengl.program_object, fragmentShader);
-
-					// Link the program
-					glLinkProgram(sdl.opengl.program_object);
-
-					// Even if we *are* successful, we may delete the shader objects
-					glDeleteShader(vertexShader);
-					glDeleteShader(fragmentShader);
-
-					// Check the link status
-					GLint is_program_linked = 0;
-					glGetProgramiv(sdl.opengl.program_object, GL_LINK_STATUS, &is_program_linked);
-
-					// The info log might contain warnings and info messages
-					// even if the linking was successful, so we'll always log
-					// it if it's non-empty.
-					GLint info_len = 0;
-
-					glGetProgramiv(sdl.opengl.program_object,
-					               GL_INFO_LOG_LENGTH,
-					               &info_len);
-
-					if (info_len > 1) {
-						std::vector<GLchar> info_log(info_len);
-
-						glGetProgramInfoLog(sdl.opengl.program_object,
-						                    info_len,
-						                    nullptr,
-						                    info_log.data());
-
-						if (is_program_linked) {
-							LOG_WARNING("OPENGL: Program info log:\n %s",
-							            info_log.data());
-						} else {
-							LOG_ERR("OPENGL: Error linking program:\n %s",
-							        info_log.data());
+						// Check the link status
+						GLint is_program_linked = 0;
+						glGetProgramiv(sdl.opengl.program_object, GL_LINK_STATUS, &is_program_linked);
+
+						// The info log might contain warnings and info messages
+						// even if the linking was successful, so we'll always log
+						// it if it's non-empty.
+						GLint info_len = 0;
+
+						glGetProgramiv(sdl.opengl.program_object,
+						               GL_INFO_LOG_LENGTH,
+						               &info_len);
+
+						if (info_len > 1) {
+							std::vector<GLchar> info_log(info_len);
+
+							glGetProgramInfoLog(sdl.opengl.program_object,
+							                    info_len,
+							                    nullptr,
+							                    info_log.data());
+
+							if (is_program_linked) {
+								LOG_WARNING("OPENGL: Program info log:\n %s",
+								            info_log.data());
+							} else {
+								LOG_ERR("OPENGL: Error linking program:\n %s",
+								        info_log.data());
+							}
 						}
-					}
 
-					if (!is_program_linked) {
-						glDeleteProgram(sdl.opengl.program_object);
-						sdl.opengl.program_object = 0;
-						goto fallback_texture;
+						if (!is_program_linked) {
+							glDeleteProgram(sdl.opengl.program_object);
+							sdl.opengl.program_object = 0;
+							goto fallback_texture;
+						}
+
+						save_program_to_cache(sdl.opengl.program_object,
+						                      sdl.opengl.shader_source);
 					}
+					linked_programs[sdl.opengl.shader_source] =
+					        sdl.opengl.program_object;
 
 					glUseProgram(sdl.opengl.program_object);
 
@@ -1961,8 +2449,7 @@ uint8_t GFX_SetSize(const int render_width_px, const int render_height_px,
 		/* Create the texture and display list */
 		const auto framebuffer_bytes = static_cast<size_t>(render_width_px) *
 		                               render_height_px * MAX_BYTES_PER_PIXEL;
-		sdl.opengl.framebuf = malloc(framebuffer_bytes); // 32 bit colour
-		sdl.opengl.pitch = render_width_px * 4;
+		allocate_gl_framebuffer(framebuffer_bytes); // 32 bit colour
 
 		// One-time initialize the window size
 		if (!sdl.desktop.window.adjusted_initial_size) {
@@ -2069,6 +2556,25 @@ uint8_t GFX_SetSize(const int render_width_px, const int render_height_px,
 		             emptytex);
 		delete[] emptytex;
 
+		// The renderer only leaves the doubling to us if the palette
+		// lookup pass was available when it asked
+		const bool wants_gpu_doubling = (flags & GFX_GPU_DOUBLING);
+		const int index_scale_x = wants_gpu_doubling && (flags & GFX_DBL_W) ? 2 : 1;
+		const int index_scale_y = wants_gpu_doubling && (flags & GFX_DBL_H) ? 2 : 1;
+
+		if ((flags & GFX_CAN_8) && sdl.opengl.program_object &&
+		    sdl.opengl.indexed_supported) {
+			setup_gl_palette_lookup(render_width_px,
+			                        render_height_px,
+			                        index_scale_x,
+			                        index_scale_y);
+		} else if (sdl.opengl.indexed_supported) {
+			free_gl_palette_lookup();
+		}
+		sdl.opengl.pitch = sdl.opengl.use_indexed
+		                         ? sdl.opengl.index_width_px
+		                         : render_width_px * 4;
+
 		if (sdl.opengl.framebuffer_is_srgb_encoded) {
 			glEnable(GL_FRAMEBUFFER_SRGB);
 #if 0
@@ -2132,7 +2638,15 @@ uint8_t GFX_SetSize(const int render_width_px, const int render_height_px,
 
 		OPENGL_ERROR("End of setsize");
 
-		retFlags          = GFX_CAN_32 | GFX_CAN_RANDOM;
+		// The frame buffer mapped from the pixel buffer is write-only,
+		// only the linear scalers never read it back
+		retFlags = sdl.opengl.use_indexed ? GFX_CAN_8 : GFX_CAN_32;
+		if (sdl.opengl.use_indexed && wants_gpu_doubling) {
+			retFlags |= GFX_GPU_DOUBLING;
+		}
+		if (!sdl.opengl.pixel_buffer) {
+			retFlags |= GFX_CAN_RANDOM;
+		}
 		sdl.frame.update  = update_frame_gl;
 		sdl.frame.present = present_frame_gl;
 #else
@@ -2185,10 +2699,9 @@ void GFX_SetShader([[maybe_unused]] const ShaderInfo& shader_info,
 	if (!sdl.opengl.use_shader) {
 		return;
 	}
-	if (sdl.opengl.program_object) {
-		glDeleteProgram(sdl.opengl.program_object);
-		sdl.opengl.program_object = 0;
-	}
+	// The program is kept in the linked programs for when this shader
+	// is used again
+	sdl.opengl.program_object = 0;
 #endif
 }
 
@@ -2342,6 +2855,7 @@ bool GFX_StartUpdate(uint8_t * &pixels, int &pitch)
 		return true;
 	case RenderingBackend::OpenGl:
 #if C_OPENGL
+		wait_for_gl_pixel_buffer();
 		pixels = static_cast<uint8_t*>(sdl.opengl.framebuf);
 		OPENGL_ERROR("end of start update");
 		if (pixels == nullptr) {
@@ -2362,12 +2876,21 @@ bool GFX_StartUpdate(uint8_t * &pixels, int &pitch)
 
 extern int64_t ticksDone;
 
-void GFX_EndUpdate(const uint16_t* changedLines)
+static int64_t present_time_us = 0;
+
+int64_t GFX_TakePresentTimeUs()
+{
+	return std::exchange(present_time_us, 0);
+}
+
+void GFX_EndUpdate(const uint16_t* changedLines,
+                   const ChangedColumns& changed_columns)
 {
+	ZoneScoped;
 	static int64_t cumulative_time_rendered = 0;
 	const auto start                        = GetTicksUs();
 
-	sdl.frame.update(changedLines);
+	sdl.frame.update(changedLines, changed_columns);
 
 	if (CAPTURE_IsCapturingPostRenderImage()) {
 		// Always present the frame if we want to capture the next rendered
@@ -2375,7 +2898,7 @@ void GFX_EndUpdate(const uint16_t* changedLines)
 		// keep the contents of rendered and raw/upscaled screenshots in sync
 		// (so they capture the exact same frame) in multi-output image
 		// capture modes.
-		sdl.frame.present();
+		present_frame();
 	} else {
 		// Helper lambda indicating whether the frame should be presented.
 		// Returns true if the frame has been updated or if the limit of
@@ -2395,7 +2918,7 @@ void GFX_EndUpdate(const uint16_t* changedLines)
 			break;
 		case FrameMode::Vfr:
 			if (vfr_should_present()) {
-				sdl.frame.present();
+				present_frame();
 			}
 			break;
 		case FrameMode::ThrottledVfr:
@@ -2407,6 +2930,7 @@ void GFX_EndUpdate(const uint16_t* changedLines)
 	}
 
 	const auto elapsed = GetTicksUsSince(start);
+	present_time_us += elapsed;
 	cumulative_time_rendered += elapsed;
 	// Update ticksDone with the rendering time
 	if (cumulative_time_rendered >= 1000) {
@@ -2421,14 +2945,61 @@ void GFX_EndUpdate(const uint16_t* changedLines)
 
 // Texture update and presentation
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-static void update_frame_texture([[maybe_unused]] const uint16_t *changedLines)
+static void upload_entire_texture()
 {
+	if (!sdl.texture.texture || !sdl.texture.input_surface) {
+		return;
+	}
 	SDL_UpdateTexture(sdl.texture.texture,
 	                  nullptr, // update entire texture
 	                  sdl.texture.input_surface->pixels,
 	                  sdl.texture.input_surface->pitch);
 }
 
+// Clamps the changed columns to the render width, returns false if
+// there's nothing to upload
+static bool clamp_changed_columns(const ChangedColumns& changed_columns,
+                                  int& start, int& width)
+{
+	start = std::max(changed_columns.start, 0);
+	width = std::min(changed_columns.end, sdl.draw.render_width_px) - start;
+	return width > 0;
+}
+
+// Only upload the runs of lines the renderer has changed, like the OpenGL
+// path does, limited to the changed columns. The changed lines list
+// alternates between the number of unchanged and changed lines; there's
+// nothing to upload without it, which is the common case of static
+// screens.
+static void update_frame_texture(const uint16_t* changedLines,
+                                 const ChangedColumns& changed_columns)
+{
+	int x     = 0;
+	int width = 0;
+	if (!changedLines || !clamp_changed_columns(changed_columns, x, width)) {
+		return;
+	}
+	const auto pixels = static_cast<const uint8_t*>(
+	        sdl.texture.input_surface->pixels);
+	const auto pitch = sdl.texture.input_surface->pitch;
+	const auto pixel_bytes = sdl.texture.input_surface->format->BytesPerPixel;
+
+	int y        = 0;
+	size_t index = 0;
+	while (y < sdl.draw.render_height_px) {
+		const int num_lines = changedLines[index];
+		if (index & 1) {
+			const SDL_Rect rect = {x, y, width, num_lines};
+			SDL_UpdateTexture(sdl.texture.texture,
+			                  &rect,
+			                  pixels + y * pitch + x * pixel_bytes,
+			                  pitch);
+		}
+		y += num_lines;
+		index++;
+	}
+}
+
 static std::optional<RenderedImage> get_rendered_output_from_backbuffer()
 {
 	// This should be impossible, but maybe the user is hitting the screen
@@ -2551,6 +3122,7 @@ static std::optional<RenderedImage> get_rendered_output_from_backbuffer()
 
 static bool present_frame_texture()
 {
+	ZoneScoped;
 	const auto is_presenting = render_pacer->CanRun();
 	if (is_presenting) {
 		SDL_RenderClear(sdl.renderer);
@@ -2576,26 +3148,75 @@ static bool present_frame_texture()
 // OpenGL frame-based update and presentation
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 #if C_OPENGL
-static void update_frame_gl(const uint16_t* changedLines)
+static void update_frame_gl(const uint16_t* changedLines,
+                            const ChangedColumns& changed_columns)
 {
 	if (changedLines) {
-		const auto framebuf = static_cast<uint8_t *>(sdl.opengl.framebuf);
+		int x     = 0;
+		int width = 0;
+		if (!clamp_changed_columns(changed_columns, x, width)) {
+			return;
+		}
 		const auto pitch = sdl.opengl.pitch;
+		const int pixel_bytes = sdl.opengl.use_indexed ? 1 : 4;
+		const GLenum format   = sdl.opengl.use_indexed ? GL_RED
+		                                               : GL_BGRA_EXT;
+		const GLenum type = sdl.opengl.use_indexed ? GL_UNSIGNED_BYTE
+		                                           : GL_UNSIGNED_INT_8_8_8_8_REV;
+		if (sdl.opengl.use_indexed) {
+			glBindTexture(GL_TEXTURE_2D, sdl.opengl.index_texture);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		}
+
+		// With a pixel buffer bound, the texture is updated from offsets
+		// into it by the GPU and the frame buffer isn't copied
+		const auto base_addr = sdl.opengl.pixel_buffer
+		                             ? uintptr_t(0)
+		                             : reinterpret_cast<uintptr_t>(
+		                                       sdl.opengl.framebuf);
+		if (sdl.opengl.pixel_buffer) {
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, sdl.opengl.pixel_buffer);
+		}
+
+		// Rows of the sub-rectangles are a full framebuffer pitch apart
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, pitch / pixel_bytes);
+
+		const auto height_limit_px = sdl.opengl.use_indexed
+		                                   ? sdl.opengl.index_height_px
+		                                   : sdl.draw.render_height_px;
 		int y = 0;
 		size_t index = 0;
-		while (y < sdl.draw.render_height_px) {
+		while (y < height_limit_px) {
 			if (!(index & 1)) {
 				y += changedLines[index];
 			} else {
-				const uint8_t *pixels = framebuf + y * pitch;
+				const auto offset = static_cast<uintptr_t>(
+				        y * pitch + x * pixel_bytes);
+				const auto pixels = reinterpret_cast<const uint8_t*>(
+				        base_addr + offset);
 				const int height_px = changedLines[index];
-				glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y,
-				                sdl.draw.render_width_px, height_px, GL_BGRA_EXT,
-				                GL_UNSIGNED_INT_8_8_8_8_REV, pixels);
+				glTexSubImage2D(GL_TEXTURE_2D, 0, x, y,
+				                width, height_px, format, type, pixels);
 				y += height_px;
 			}
 			index++;
 		}
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+		if (sdl.opengl.use_indexed) {
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+			glBindTexture(GL_TEXTURE_2D, sdl.opengl.texture);
+			sdl.opengl.needs_palette_lookup = true;
+		}
+
+		if (sdl.opengl.pixel_buffer) {
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			// The renderer must not write to the buffer until the
+			// texture updates from it are done
+			wait_for_gl_pixel_buffer();
+			sdl.opengl.pixel_buffer_fence =
+			        glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		}
 	} else {
 		sdl.opengl.actual_frame_count++;
 	}
@@ -2603,8 +3224,12 @@ static void update_frame_gl(const uint16_t* changedLines)
 
 static bool present_frame_gl()
 {
+	ZoneScoped;
 	const auto is_presenting = render_pacer->CanRun();
 	if (is_presenting) {
+		if (sdl.opengl.needs_palette_lookup) {
+			run_gl_palette_lookup();
+		}
 		glClear(GL_COLOR_BUFFER_BIT);
 		if (sdl.opengl.program_object) {
 			glUniform1i(sdl.opengl.ruby.frame_count,
@@ -2644,6 +3269,22 @@ uint32_t GFX_GetRGB(const uint8_t red, const uint8_t green, const uint8_t blue)
 	return 0;
 }
 
+void GFX_SetPalette([[maybe_unused]] const uint8_t* entries,
+                    [[maybe_unused]] const int first, [[maybe_unused]] const int last)
+{
+#if C_OPENGL
+	if (!sdl.opengl.use_indexed || first > last) {
+		return;
+	}
+	constexpr int entry_bytes = 4;
+	glBindTexture(GL_TEXTURE_2D, sdl.opengl.palette_texture);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, first, 0, last - first + 1, 1,
+	                GL_RGBA, GL_UNSIGNED_BYTE, entries + first * entry_bytes);
+	glBindTexture(GL_TEXTURE_2D, sdl.opengl.texture);
+	sdl.opengl.needs_palette_lookup = true;
+#endif
+}
+
 void GFX_Stop() {
 	if (sdl.updating)
 		GFX_EndUpdate(nullptr);
@@ -2694,9 +3335,27 @@ static void clean_up_sdl_resources()
 	}
 }
 
+static void log_frame_time_histogram()
+{
+	const auto num_intervals = present_clock.GetNumIntervals();
+	if (!num_intervals) {
+		return;
+	}
+	LOG_MSG("SDL: Presented %u frames, %d%% within %d ms, %d%% within "
+	        "%d ms, and %d%% within %d ms of the previous one",
+	        num_intervals + 1,
+	        50,
+	        present_clock.GetPercentileMs(50),
+	        95,
+	        present_clock.GetPercentileMs(95),
+	        99,
+	        present_clock.GetPercentileMs(99));
+}
+
 static void GUI_ShutDown(Section *)
 {
 	GFX_Stop();
+	log_frame_time_histogram();
 
 	if (sdl.draw.callback)
 		(sdl.draw.callback)( GFX_CallBackStop );
@@ -3266,6 +3925,44 @@ static void set_output(Section* sec, const bool wants_aspect_ratio_correction)
 			         glUniform2f && glUniform1i && glUseProgram &&
 			         glVertexAttribPointer);
 
+			glGenBuffers = (PFNGLGENBUFFERSPROC)SDL_GL_GetProcAddress(
+			        "glGenBuffers");
+			glDeleteBuffers = (PFNGLDELETEBUFFERSPROC)SDL_GL_GetProcAddress(
+			        "glDeleteBuffers");
+			glBindBuffer = (PFNGLBINDBUFFERPROC)SDL_GL_GetProcAddress(
+			        "glBindBuffer");
+			glBufferStorage = (PFNGLBUFFERSTORAGEPROC)SDL_GL_GetProcAddress(
+			        "glBufferStorage");
+			glMapBufferRange = (PFNGLMAPBUFFERRANGEPROC)SDL_GL_GetProcAddress(
+			        "glMapBufferRange");
+			glUnmapBuffer = (PFNGLUNMAPBUFFERPROC)SDL_GL_GetProcAddress(
+			        "glUnmapBuffer");
+			glFenceSync = (PFNGLFENCESYNCPROC)SDL_GL_GetProcAddress(
+			        "glFenceSync");
+			glClientWaitSync = (PFNGLCLIENTWAITSYNCPROC)SDL_GL_GetProcAddress(
+			        "glClientWaitSync");
+			glDeleteSync = (PFNGLDELETESYNCPROC)SDL_GL_GetProcAddress(
+			        "glDeleteSync");
+
+			glGetProgramBinary = (PFNGLGETPROGRAMBINARYPROC)SDL_GL_GetProcAddress(
+			        "glGetProgramBinary");
+			glProgramBinary = (PFNGLPROGRAMBINARYPROC)SDL_GL_GetProcAddress(
+			        "glProgramBinary");
+			glProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC)SDL_GL_GetProcAddress(
+			        "glProgramParameteri");
+			glGenFramebuffers = (PFNGLGENFRAMEBUFFERSPROC)SDL_GL_GetProcAddress(
+			        "glGenFramebuffers");
+			glDeleteFramebuffers = (PFNGLDELETEFRAMEBUFFERSPROC)SDL_GL_GetProcAddress(
+			        "glDeleteFramebuffers");
+			glBindFramebuffer = (PFNGLBINDFRAMEBUFFERPROC)SDL_GL_GetProcAddress(
+			        "glBindFramebuffer");
+			glFramebufferTexture2D = (PFNGLFRAMEBUFFERTEXTURE2DPROC)SDL_GL_GetProcAddress(
+			        "glFramebufferTexture2D");
+			glCheckFramebufferStatus = (PFNGLCHECKFRAMEBUFFERSTATUSPROC)SDL_GL_GetProcAddress(
+			        "glCheckFramebufferStatus");
+			glActiveTexture = (PFNGLACTIVETEXTUREPROC)SDL_GL_GetProcAddress(
+			        "glActiveTexture");
+
 			sdl.opengl.framebuf = nullptr;
 			sdl.opengl.texture = 0;
 			sdl.opengl.displaylist = 0;
@@ -3280,6 +3977,37 @@ static void set_output(Section* sec, const bool wants_aspect_ratio_correction)
 			        SDL_GL_ExtensionSupported(
 			                "GL_ARB_texture_non_power_of_two");
 
+			// Program binaries need OpenGL 4.1 or the
+			// ARB_get_program_binary extension
+			sdl.opengl.program_binary_supported =
+			        (glGetProgramBinary && glProgramBinary &&
+			         glProgramParameteri) &&
+			        (gl_version_major >= 5 ||
+			         SDL_GL_ExtensionSupported("GL_ARB_get_program_binary") ||
+			         (gl_version_major == 4 && gl_version_string[1] == '.' &&
+			          gl_version_string[2] >= '1'));
+
+			// Persistent mappings need OpenGL 4.4 or the
+			// ARB_buffer_storage extension, fences come with 3.2
+			sdl.opengl.pixel_buffer_supported =
+			        (glGenBuffers && glDeleteBuffers && glBindBuffer &&
+			         glBufferStorage && glMapBufferRange && glUnmapBuffer &&
+			         glFenceSync && glClientWaitSync && glDeleteSync) &&
+			        (gl_version_major >= 3 ||
+			         SDL_GL_ExtensionSupported("GL_ARB_sync")) &&
+			        (gl_version_major >= 5 ||
+			         SDL_GL_ExtensionSupported("GL_ARB_buffer_storage") ||
+			         (gl_version_major == 4 && gl_version_string[1] == '.' &&
+			          gl_version_string[2] >= '4'));
+
+			// The palette lookup pass needs framebuffer objects,
+			// red textures and texelFetch() from OpenGL 3.0
+			sdl.opengl.indexed_supported =
+			        (glGenFramebuffers && glDeleteFramebuffers &&
+			         glBindFramebuffer && glFramebufferTexture2D &&
+			         glCheckFramebufferStatus && glActiveTexture) &&
+			        gl_version_major >= 3;
+
 			std::string npot_support_msg = sdl.opengl.npot_textures_supported
 			                                     ? "supported"
 			                                     : "not supported";
@@ -3295,6 +4023,14 @@ static void set_output(Section* sec, const bool wants_aspect_ratio_correction)
 
 			LOG_INFO("OPENGL: NPOT textures %s",
 			         npot_support_msg.c_str());
+
+			LOG_INFO("OPENGL: Persistently mapped pixel buffer %s",
+			         sdl.opengl.pixel_buffer_supported ? "supported"
+			                                           : "not supported");
+
+			LOG_INFO("OPENGL: Palette lookup of indexed frames %s",
+			         sdl.opengl.indexed_supported ? "supported"
+			                                      : "not supported");
 		}
 	} /* OPENGL is requested end */
 #endif    // OPENGL
@@ -3531,6 +4267,31 @@ static void handle_mouse_motion(SDL_MouseMotionEvent* motion)
 	                 check_cast<int32_t>(motion->y));
 }
 
+// Folds the mouse motion events queued right behind the given one into it,
+// so a high polling rate mouse costs one notification per batch instead of
+// one per host report. Only directly adjacent events from the same window
+// and mouse are merged, so the ordering against buttons and keys is kept.
+static void coalesce_mouse_motion(SDL_MouseMotionEvent& motion)
+{
+	SDL_Event next = {};
+	while (SDL_PeepEvents(&next, 1, SDL_PEEKEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT) == 1) {
+		if (next.type != SDL_MOUSEMOTION ||
+		    next.motion.windowID != motion.windowID ||
+		    next.motion.which != motion.which) {
+			break;
+		}
+		SDL_PeepEvents(&next, 1, SDL_GETEVENT, SDL_MOUSEMOTION, SDL_MOUSEMOTION);
+
+		motion.xrel += next.motion.xrel;
+		motion.yrel += next.motion.yrel;
+		motion.x     = next.motion.x;
+		motion.y     = next.motion.y;
+		motion.state = next.motion.state;
+
+		motion.timestamp = next.motion.timestamp;
+	}
+}
+
 static void handle_mouse_wheel(SDL_MouseWheelEvent* wheel)
 {
     const auto tmp = (wheel->direction == SDL_MOUSEWHEEL_NORMAL) ? -wheel->y : wheel->y;
@@ -3737,7 +4498,20 @@ bool GFX_Events()
 		MAPPER_UpdateJoysticks();
 	}
 #endif
-	while (SDL_PollEvent(&event)) {
+	// SDL_PollEvent() pumps the host's event loop on every call, which
+	// gets expensive during event storms; pump once and then drain what's
+	// queued.
+	SDL_PumpEvents();
+	while (SDL_PeepEvents(&event, 1, SDL_GETEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT) == 1) {
+#if SDL_VERSION_ATLEAST(2, 24, 0)
+		// Internal marker SDL_PollEvent() would have filtered out
+		if (event.type == SDL_POLLSENTINEL) {
+			continue;
+		}
+#endif
+		if (event.type == SDL_MOUSEMOTION) {
+			coalesce_mouse_motion(event.motion);
+		}
 #if C_DEBUG
 		if (is_debugger_event(event)) {
 			pdc_event_queue.push(event);
@@ -4039,6 +4813,15 @@ bool GFX_Events()
 		case SDL_MOUSEBUTTONDOWN:
 		case SDL_MOUSEBUTTONUP: handle_mouse_button(&event.button); break;
 
+		case SDL_RENDER_TARGETS_RESET:
+		case SDL_RENDER_DEVICE_RESET:
+			// The texture contents might have been lost and we only
+			// upload the changed lines
+			if (sdl.rendering_backend == RenderingBackend::Texture) {
+				upload_entire_texture();
+			}
+			break;
+
 		case SDL_QUIT: GFX_RequestExit(true); break;
 #ifdef WIN32
 		case SDL_KEYDOWN:
@@ -4194,6 +4977,12 @@ static void messages_add_command_line()
 	        "\n"
 	        "  --socket <num>           Run nullmodem on the specified socket number.\n"
 	        "\n"
+	        "  --benchmark <secs>       Run without a window and sound for the given number of\n"
+	        "                           emulated seconds, then print the throughput and exit.\n"
+	        "\n"
+	        "  --benchmark-report <file>\n"
+	        "                           Also write the benchmark results to the file as JSON.\n"
+	        "\n"
 	        "  -h, -?, --help           Print help message and exit.\n"
 	        "\n"
 	        "  -V, --version            Print version information and exit.\n");
@@ -4355,7 +5144,10 @@ static void config_add_sdl()
 
 	pstring = sdl_sec->Add_string("texture_renderer", always, "auto");
 	pstring->Set_help("Render driver to use in 'texture' output mode ('auto' by default).\n"
-	                  "Use 'texture_renderer = auto' for an automatic choice.");
+	                  "Use 'texture_renderer = auto' for an automatic choice.\n"
+	                  "Drivers not based on OpenGL (e.g., 'direct3d11', 'metal', or\n"
+	                  "'software') avoid the per-frame overhead of some OpenGL drivers and\n"
+	                  "don't need the OpenGL window workaround.");
 	pstring->Set_values(get_sdl_texture_renderers());
 
 	pmulti = sdl_sec->AddMultiVal("capture_mouse", deprecated, ",");
@@ -4812,6 +5604,17 @@ int sdl_main(int argc, char* argv[])
 			return err;
 		}
 
+		// The benchmark mode runs headless; the software renderer
+		// works with SDL's dummy video driver
+		if (arguments->benchmark) {
+			SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+			SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+
+			arguments->set.emplace_back("sdl output=texture");
+			arguments->set.emplace_back("sdl texture_renderer=software");
+			arguments->set.emplace_back("mixer nosound=true");
+		}
+
 		// Timer is needed for title bar animations
 		if (SDL_Init(SDL_INIT_AUDIO | SDL_INIT_VIDEO | SDL_INIT_TIMER) < 0) {
 			E_Exit("SDL: Can't init SDL %s", SDL_GetError());
@@ -4926,6 +5729,9 @@ int sdl_main(int argc, char* argv[])
 			MAPPER_DisplayUI();
 		}
 
+		// What the configured machine takes, before running it
+		HOSTMEM_LogUsage();
+
 		// Run the machine until shutdown
 		control->StartUp();
 
@@ -101,6 +101,28 @@ AudioFrame SurroundProcessor::Process(const AudioFrame frame)
 	return {data.outputs[0], data.outputs[1]};
 }
 
+bool SurroundProcessor::IsSilentForBlock(const uint32_t frames)
+{
+	// With both the input and feedback gains at zero only silence is
+	// written into the delay line, so after one full pass through it the
+	// outputs stay at zero whatever the tap gains are. Most programs
+	// never enable the surround module, which keeps it in this state.
+	const auto input_muted = chip.gains_[YM7128B_Reg_VM] == 0.0f &&
+	                         chip.gains_[YM7128B_Reg_VC] == 0.0f;
+	if (!input_muted) {
+		muted_input_frames = 0;
+		return false;
+	}
+
+	const auto settle_frames = static_cast<uint32_t>(chip.length_) + 1;
+	if (muted_input_frames >= settle_frames) {
+		return true;
+	}
+
+	muted_input_frames += frames;
+	return false;
+}
+
 // Philips Semiconductors TDA8425 hi-fi stereo audio processor emulation
 // ---------------------------------------------------------------------
 
@@ -351,17 +373,21 @@ void AdlibGold::Process(const int16_t* in, const uint32_t frames, float* out)
 {
 	auto frames_remaining = frames;
 
+	const auto surround_silent = surround_processor->IsSilentForBlock(frames);
+
 	while (frames_remaining--) {
 		AudioFrame frame = {static_cast<float>(in[0]),
 		                    static_cast<float>(in[1])};
 
-		const auto wet = surround_processor->Process(frame);
+		if (!surround_silent) {
+			const auto wet = surround_processor->Process(frame);
 
-		// Additional wet signal level boost to make the emulated
-		// sound more closely resemble real hardware recordings.
-		constexpr auto wet_boost = 1.8f;
-		frame.left += wet.left * wet_boost;
-		frame.right += wet.right * wet_boost;
+			// Additional wet signal level boost to make the emulated
+			// sound more closely resemble real hardware recordings.
+			constexpr auto wet_boost = 1.8f;
+			frame.left += wet.left * wet_boost;
+			frame.right += wet.right * wet_boost;
+		}
 
 		frame = stereo_processor->Process(frame);
 
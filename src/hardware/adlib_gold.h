@@ -36,6 +36,10 @@ public:
 	void ControlWrite(const uint8_t val);
 	AudioFrame Process(const AudioFrame frame);
 
+	// Returns true if the next block of frames can skip Process()
+	// because the chip would only output silence
+	bool IsSilentForBlock(const uint32_t frames);
+
 	// prevent copying
 	SurroundProcessor(const SurroundProcessor&) = delete;
 	// prevent assignment
@@ -50,6 +54,10 @@ private:
 		uint8_t addr = 0;
 		uint8_t data = 0;
 	} control_state = {};
+
+	// Number of frames processed while no signal could enter the delay
+	// line; once it covers the whole line the chip is silent
+	uint32_t muted_input_frames = 0;
 };
 
 enum class StereoProcessorControlReg {
@@ -0,0 +1,299 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_CHIP_RENDERER_H
+#define DOSBOX_CHIP_RENDERER_H
+
+/*
+ChipRenderer Class
+~~~~~~~~~~~~~~~~~~
+Renders a sound chip on its own thread. The emulation thread stamps each
+write to the chip with the chip steps that were due since the previous
+one and queues it; the worker renders those steps, applies the write, and
+renders ahead of the mixer while there are no writes to apply. Both the
+writes and the rendered frames go through lock-free rings.
+
+The render and write functions only ever run on the worker, so the chip
+state they touch needs no locking, as long as the emulation thread keeps
+its hands off it once the renderer is started.
+
+Usage:
+ 1. Construct with the time per chip step and per output frame, and the
+    functions to render steps and to apply a write.
+ 2. Start() it with the number of frames to render ahead.
+ 3. On port writes, call AddWrite() with the current time.
+ 4. In the mixer callback, DequeueFrames() the requested frames and call
+    SetRenderedUpTo() with the current time; do the same when the channel
+    wakes up.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "audio_frame.h"
+#include "spsc_ring.h"
+
+template <typename Write, typename Frame = AudioFrame>
+class ChipRenderer {
+public:
+	// Renders the given number of chip steps and appends the frames they
+	// produced, which can be fewer when the chip output gets resampled
+	using RenderFunction = std::function<void(const int num_steps,
+	                                          std::vector<Frame>& out)>;
+	using WriteFunction  = std::function<void(const Write& write)>;
+
+	ChipRenderer(const double _ms_per_step, const double ms_per_frame,
+	             RenderFunction _render, WriteFunction _apply_write)
+	        : ms_per_step(_ms_per_step),
+	          idle_steps(std::max(static_cast<int>(std::ceil(
+	                                      IdleFrames * ms_per_frame /
+	                                      _ms_per_step)),
+	                              1)),
+	          render(std::move(_render)),
+	          apply_write(std::move(_apply_write))
+	{
+		assert(ms_per_step > 0.0);
+		assert(render);
+		assert(apply_write);
+	}
+
+	~ChipRenderer()
+	{
+		Stop();
+	}
+
+	ChipRenderer(const ChipRenderer&)            = delete;
+	ChipRenderer& operator=(const ChipRenderer&) = delete;
+
+	void Start(const int _render_ahead_frames, const int max_queued_writes)
+	{
+		Stop();
+
+		render_ahead_frames = std::max(_render_ahead_frames, IdleFrames);
+
+		// The slack above the render-ahead takes the steps that were
+		// due before a write while the mixer isn't pulling frames
+		frames = std::make_unique<SpscRing<Frame>>(
+		        static_cast<size_t>(render_ahead_frames) * 2);
+		writes = std::make_unique<SpscRing<StampedWrite>>(
+		        static_cast<size_t>(std::max(max_queued_writes, 1)));
+
+		is_running = true;
+		worker     = std::thread(&ChipRenderer::Run, this);
+	}
+
+	void Stop()
+	{
+		if (!worker.joinable()) {
+			return;
+		}
+		is_running = false;
+		Notify(worker_progress);
+		Notify(emulation_progress);
+
+		worker.join();
+	}
+
+	bool IsRunning() const
+	{
+		return is_running;
+	}
+
+	std::thread& GetThread()
+	{
+		return worker;
+	}
+
+	// Emulation thread side
+
+	void AddWrite(const double now_ms, const Write& write)
+	{
+		assert(writes);
+
+		StampedWrite stamped = {0, write};
+		if (last_rendered_ms < now_ms) {
+			stamped.num_pending_steps = static_cast<int>(
+			        std::ceil((now_ms - last_rendered_ms) / ms_per_step));
+			last_rendered_ms += stamped.num_pending_steps * ms_per_step;
+		}
+
+		WaitFor(worker_progress,
+		        [&] { return !is_running || writes->GetNumWritable() > 0; });
+
+		if (writes->Write(&stamped, 1)) {
+			Notify(emulation_progress);
+		}
+	}
+
+	void SetRenderedUpTo(const double now_ms)
+	{
+		last_rendered_ms = now_ms;
+	}
+
+	// Blocks until the requested frames are rendered; returns false if
+	// the renderer stopped before that, with the frames it did get
+	bool DequeueFrames(const int num_frames, std::vector<Frame>& out)
+	{
+		assert(frames);
+
+		out.resize(static_cast<size_t>(num_frames));
+
+		size_t num_read = 0;
+		while (num_read < out.size()) {
+			WaitFor(worker_progress, [&] {
+				return !is_running || frames->GetNumReadable() > 0;
+			});
+
+			const auto n = frames->Read(out.data() + num_read,
+			                            out.size() - num_read);
+			if (n == 0) {
+				assert(!is_running);
+				out.resize(num_read);
+				return false;
+			}
+			num_read += n;
+			Notify(emulation_progress);
+		}
+		return true;
+	}
+
+private:
+	struct StampedWrite {
+		int num_pending_steps = 0;
+		Write write           = {};
+	};
+
+	// Worker side
+
+	void Run()
+	{
+		while (is_running) {
+			if (writes->GetNumReadable() > 0) {
+				const auto stamped = writes->Peek(0);
+				RenderSteps(stamped.num_pending_steps);
+				apply_write(stamped.write);
+
+				writes->Consume(1);
+				Notify(worker_progress);
+				continue;
+			}
+			if (GetNumBuffered() + IdleFrames <= render_ahead_frames) {
+				RenderSteps(idle_steps);
+				continue;
+			}
+			WaitFor(emulation_progress, [&] {
+				return !is_running || writes->GetNumReadable() > 0 ||
+				       GetNumBuffered() + IdleFrames <= render_ahead_frames;
+			});
+		}
+	}
+
+	int GetNumBuffered() const
+	{
+		return static_cast<int>(frames->MaxCapacity() -
+		                        frames->GetNumWritable());
+	}
+
+	void RenderSteps(const int num_steps)
+	{
+		if (num_steps <= 0) {
+			return;
+		}
+		staging.clear();
+		render(num_steps, staging);
+
+		size_t num_written = 0;
+		while (num_written < staging.size()) {
+			num_written += frames->Write(staging.data() + num_written,
+			                             staging.size() - num_written);
+			Notify(worker_progress);
+
+			if (num_written == staging.size()) {
+				break;
+			}
+
+			// Wait for the mixer to make room, unless the emulation
+			// thread is waiting for us to take its writes; then the
+			// remaining frames have to go. The chip still rendered
+			// them, so it stays in step.
+			WaitFor(emulation_progress, [&] {
+				return !is_running || frames->GetNumWritable() > 0 ||
+				       writes->GetNumWritable() == 0;
+			});
+			if (!is_running || frames->GetNumWritable() == 0) {
+				break;
+			}
+		}
+	}
+
+	template <typename Predicate>
+	static void WaitFor(std::atomic<uint32_t>& progress, Predicate is_ready)
+	{
+		while (true) {
+			const auto seen = progress.load();
+			if (is_ready()) {
+				return;
+			}
+			progress.wait(seen);
+		}
+	}
+
+	static void Notify(std::atomic<uint32_t>& progress)
+	{
+		++progress;
+		progress.notify_all();
+	}
+
+	// Frames rendered at a time while there are no writes to apply; small
+	// enough to not hold up the writes that come in meanwhile
+	static constexpr int IdleFrames = 16;
+
+	const double ms_per_step = 0.0;
+	const int idle_steps     = 0;
+
+	RenderFunction render     = {};
+	WriteFunction apply_write = {};
+
+	std::unique_ptr<SpscRing<Frame>> frames        = {};
+	std::unique_ptr<SpscRing<StampedWrite>> writes = {};
+
+	int render_ahead_frames    = 0;
+	std::vector<Frame> staging = {};
+
+	// Only used by the emulation thread
+	double last_rendered_ms = 0.0;
+
+	// Bumped whenever either side made progress the other could be
+	// waiting for
+	std::atomic<uint32_t> worker_progress    = 0;
+	std::atomic<uint32_t> emulation_progress = 0;
+
+	std::atomic<bool> is_running = false;
+	std::thread worker           = {};
+};
+
+#endif
@@ -45,16 +45,12 @@ void Covox::ConfigureFilters(const FilterState state)
 	channel->SetLowPassFilter(state);
 }
 
-AudioFrame Covox::Render()
-{
-	const float sample = lut_u8to16[data_reg];
-	return {sample, sample};
-}
-
 void Covox::WriteData(const io_port_t, const io_val_t data, const io_width_t)
 {
-	RenderUpToNow();
 	data_reg = check_cast<uint8_t>(data);
+
+	const float sample = lut_u8to16[data_reg];
+	QueueLevel({sample, sample});
 }
 
 uint8_t Covox::ReadStatus(const io_port_t, const io_width_t)
@@ -86,6 +86,15 @@ AudioFrame Disney::Render()
 	return {sample, sample};
 }
 
+// The FIFO's fill level is visible through the status port, so unlike the
+// other DACs, it's rendered ahead in step with the control port writes.
+void Disney::RenderFrames(const int num_frames)
+{
+	for (auto i = 0; i < num_frames; ++i) {
+		render_buffer.push_back(Render());
+	}
+}
+
 bool Disney::IsFifoFull() const
 {
 	return fifo.size() >= max_fifo_size;
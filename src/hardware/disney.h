@@ -36,9 +36,10 @@ public:
 	void ConfigureFilters(const FilterState state) final;
 
 protected:
-	AudioFrame Render() final;
+	void RenderFrames(const int num_frames) final;
 
 private:
+	AudioFrame Render();
 	bool IsFifoFull() const;
 	void WriteData(const io_port_t, const io_val_t value, const io_width_t);
 	uint8_t ReadStatus(const io_port_t, const io_width_t);
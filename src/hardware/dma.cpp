@@ -53,6 +53,39 @@ static void UpdateEMSMapping()
 	}
 }
 
+// A run of bytes within a single page, at its physical address
+struct DmaChunk {
+	PhysPt start      = 0;
+	uint16_t num_bytes = 0;
+};
+
+// Finds where the bytes at the DMA address end up in physical memory, up to
+// the end of the page that holds them
+static DmaChunk find_dma_chunk(const PhysPt spage, const PhysPt mem_address,
+                               const size_t remaining_bytes)
+{
+	const auto highpart_addr_page = spage >> 12;
+
+	// Find the right EMS page that contains the current address
+	auto page = highpart_addr_page + (mem_address >> 12);
+	if (page < EMM_PAGEFRAME4K) {
+		page = paging.firstmb[page];
+	} else if (page < EMM_PAGEFRAME4K + 0x10) {
+		page = ems_board_mapping[page];
+	} else if (page < LINK_START) {
+		page = paging.firstmb[page];
+	}
+
+	// Calculate the offset within the page
+	const auto pos_in_page       = mem_address & (dos_pagesize - 1);
+	const auto bytes_to_page_end = dos_pagesize - pos_in_page;
+
+	// Determine how many bytes to transfer within this page
+	return {check_cast<PhysPt>(page * dos_pagesize + pos_in_page),
+	        check_cast<uint16_t>(
+	                std::min(remaining_bytes, size_t{bytes_to_page_end}))};
+}
+
 // Generic function to read or write a block of data to or from memory.
 // Don't use this directly; call two helpers: DMA_BlockRead or DMA_BlockWrite
 static void perform_dma_io(const DMA_DIRECTION direction, const PhysPt spage,
@@ -61,8 +94,6 @@ static void perform_dma_io(const DMA_DIRECTION direction, const PhysPt spage,
 {
 	assert(is_dma16 == 0 || is_dma16 == 1);
 
-	const auto highpart_addr_page = spage >> 12;
-
 	// Maybe move the mem_address into the 16-bit range
 	mem_address <<= is_dma16;
 
@@ -72,38 +103,20 @@ static void perform_dma_io(const DMA_DIRECTION direction, const PhysPt spage,
 	// Convert from DMA 'words' to actual bytes, no greater than 64 KB
 	auto remaining_bytes = check_cast<uint16_t>(num_words << is_dma16);
 	do {
-		// Find the right EMS page that contains the current address
-		auto page = highpart_addr_page + (mem_address >> 12);
-		if (page < EMM_PAGEFRAME4K) {
-			page = paging.firstmb[page];
-		} else if (page < EMM_PAGEFRAME4K + 0x10) {
-			page = ems_board_mapping[page];
-		} else if (page < LINK_START) {
-			page = paging.firstmb[page];
-		}
-
-		// Calculate the offset within the page
-		const auto pos_in_page       = mem_address & (dos_pagesize - 1);
-		const auto bytes_to_page_end = check_cast<uint16_t>(
-		        dos_pagesize - pos_in_page);
-		const auto chunk_start = check_cast<PhysPt>(page * dos_pagesize +
-		                                            pos_in_page);
+		const auto [chunk_start, chunk_bytes] = find_dma_chunk(
+		        spage, mem_address, remaining_bytes);
 
-		// Determine how many bytes to transfer within this page
-		const auto chunk_bytes = std::min(remaining_bytes, bytes_to_page_end);
+		// Physical pages are backed by a flat block of host memory,
+		// so each chunk is copied in a single go.
 
 		// Copy the data from the page address into the data pointer
 		if (direction == DMA_DIRECTION::READ) {
-			for (auto i = 0; i < chunk_bytes; ++i) {
-				data_pt[i] = phys_readb(chunk_start + i);
-			}
+			std::memcpy(data_pt, MemBase + chunk_start, chunk_bytes);
 		}
 
 		// Copy the data from the data pointer into the page address
 		else if (direction == DMA_DIRECTION::WRITE) {
-			for (auto i = 0; i < chunk_bytes; ++i) {
-				phys_writeb(chunk_start + i, data_pt[i]);
-			}
+			std::memcpy(MemBase + chunk_start, data_pt, chunk_bytes);
 		}
 
 		mem_address += chunk_bytes;
@@ -431,6 +444,48 @@ size_t DmaChannel::Write(const size_t words, uint8_t* const src_buffer)
 	return ReadOrWrite(DMA_DIRECTION::WRITE, words, src_buffer);
 }
 
+std::optional<DmaSpans> DmaChannel::GetSpans(const size_t words) const
+{
+	// Stop at the terminal count, like Read() and Write() do
+	const auto num_words = std::min(words, size_t{curr_count} + 1);
+
+	auto mem_address     = (curr_addr & dma_wrapping) << is_16bit;
+	auto remaining_bytes = num_words << is_16bit;
+
+	const auto mem_end = static_cast<size_t>(MEM_TotalPages()) * dos_pagesize;
+
+	DmaSpans spans   = {};
+	size_t num_spans = 0;
+
+	while (remaining_bytes) {
+		const auto [chunk_start, chunk_bytes] = find_dma_chunk(
+		        page_base, mem_address, remaining_bytes);
+
+		if (size_t{chunk_start} + chunk_bytes > mem_end) {
+			return {};
+		}
+		auto* const chunk = MemBase + chunk_start;
+		auto* const last  = num_spans ? &spans[num_spans - 1] : nullptr;
+
+		// Pages that follow each other in host memory extend the span
+		if (last && last->data + last->num_bytes == chunk) {
+			last->num_bytes += chunk_bytes;
+		} else if (num_spans < spans.size()) {
+			spans[num_spans++] = {chunk, chunk_bytes};
+		} else {
+			return {};
+		}
+		mem_address += chunk_bytes;
+		remaining_bytes -= chunk_bytes;
+	}
+	return spans;
+}
+
+size_t DmaChannel::Advance(const size_t words)
+{
+	return ReadOrWrite(DMA_DIRECTION::READ, words, nullptr);
+}
+
 size_t DmaChannel::ReadOrWrite(const DMA_DIRECTION direction,
                                const size_t words, uint8_t* const buffer)
 {
@@ -438,18 +493,22 @@ size_t DmaChannel::ReadOrWrite(const DMA_DIRECTION direction,
 	uint16_t done = 0;
 	curr_addr &= dma_wrapping;
 
-	// incremented per transfer
+	// incremented per transfer, or nothing is copied when advancing
 	auto curr_buffer = buffer;
 again:
 	Bitu left = (curr_count + 1);
 	if (want < left) {
-		perform_dma_io(direction, page_base, curr_addr, curr_buffer, want, is_16bit);
+		if (curr_buffer) {
+			perform_dma_io(direction, page_base, curr_addr, curr_buffer, want, is_16bit);
+		}
 		done += want;
 		curr_addr += want;
 		curr_count -= want;
 	} else {
-		perform_dma_io(direction, page_base, curr_addr, curr_buffer, left, is_16bit);
-		curr_buffer += left << is_16bit;
+		if (curr_buffer) {
+			perform_dma_io(direction, page_base, curr_addr, curr_buffer, left, is_16bit);
+			curr_buffer += left << is_16bit;
+		}
 		want -= left;
 		done += left;
 		ReachedTerminalCount();
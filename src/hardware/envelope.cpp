@@ -32,6 +32,7 @@ void Envelope::Reactivate()
 	frames_done = 0;
 
 	process = &Envelope::Apply;
+	is_done = false;
 }
 
 void Envelope::Update(const int sample_rate_hz, const int peak_amplitude,
@@ -104,6 +105,7 @@ void Envelope::Apply(const bool is_stereo, AudioFrame& frame)
 	// Should we deactivate the envelope?
 	if (++frames_done > expire_after_frames || edge >= edge_limit) {
 		process = &Envelope::Skip;
+		is_done = true;
 		(void)channel_name; // [[maybe_unused]] in release builds
 		LOG_DEBUG("ENVELOPE: %s done after %u frames, peak sample was %.4f",
 		          channel_name.c_str(),
@@ -24,6 +24,8 @@
 #include "channel_names.h"
 #include "pic.h"
 #include "setup.h"
+#include "support.h"
+#include "tracy.h"
 
 // The Game Blaster is nothing else than a rebranding of Creative's first PC
 // sound card, the Creative Music System (C/MS).
@@ -131,6 +133,20 @@ void GameBlaster::Open(const int port_choice, const std::string &card_choice,
 		                                              max_rate_hz));
 	}
 
+	// Start rendering, ahead of the mixer by its prebuffer
+	const auto render = std::bind(&GameBlaster::RenderFrames, this, _1, _2);
+	const auto write  = std::bind(&GameBlaster::ApplyWrite, this, _1);
+
+	renderer = std::make_unique<ChipRenderer<DeviceWrite>>(
+	        ms_per_render, millis_in_second / sample_rate_hz, render, write);
+
+	const auto render_ahead_frames = iround(MIXER_GetPreBufferMs() *
+	                                        sample_rate_hz / millis_in_second);
+
+	constexpr auto MaxQueuedWrites = 1024;
+	renderer->Start(render_ahead_frames, MaxQueuedWrites);
+	set_thread_name(renderer->GetThread(), "dosbox:cms");
+
 	LOG_MSG("CMS: Running on port %xh with two %0.3f MHz Phillips SAA-1099 chips",
 	        base_port,
 	        chip_clock / 1e6);
@@ -160,9 +176,6 @@ bool GameBlaster::MaybeRenderFrame(AudioFrame &frame)
 	left_accum += buf[0];
 	right_accum += buf[1];
 
-	// Increment our time datum up to which the device has rendered
-	last_rendered_ms += ms_per_render;
-
 	// Resample the limited frame
 	const auto l_ready = resamplers[0]->input(left_accum);
 	const auto r_ready = resamplers[1]->input(right_accum);
@@ -177,71 +190,75 @@ bool GameBlaster::MaybeRenderFrame(AudioFrame &frame)
 	return frame_is_ready;
 }
 
-void GameBlaster::RenderUpToNow()
+// Runs on the render thread
+void GameBlaster::RenderFrames(const int num_renders,
+                               std::vector<AudioFrame>& out)
+{
+	for (auto i = 0; i < num_renders; ++i) {
+		if (AudioFrame f = {}; MaybeRenderFrame(f)) {
+			out.emplace_back(f);
+		}
+	}
+}
+
+// Runs on the render thread
+void GameBlaster::ApplyWrite(const DeviceWrite& write)
 {
-	const auto now = PIC_FullIndex();
+	auto& device = devices[write.device_index];
+	if (write.is_control) {
+		device->control_w(0, 0, write.value);
+	} else {
+		device->data_w(0, 0, write.value);
+	}
+}
 
-	// Wake up the channel and update the last rendered time datum.
+void GameBlaster::RenderUpToNow()
+{
+	// Wake up the channel and update the last rendered time datum; the
+	// render thread catches up when it applies the next write
 	assert(channel);
 	if (channel->WakeUp()) {
-		last_rendered_ms = now;
-		return;
-	}
-	// Keep rendering until we're current
-	while (last_rendered_ms < now) {
-		last_rendered_ms += ms_per_render;
-		if (AudioFrame f = {}; MaybeRenderFrame(f))
-			fifo.emplace(f);
+		renderer->SetRenderedUpTo(PIC_FullIndex());
 	}
 }
 
-void GameBlaster::WriteDataToLeftDevice(io_port_t, io_val_t value, io_width_t)
+void GameBlaster::QueueWrite(const DeviceWrite& write)
 {
 	RenderUpToNow();
-	devices[0]->data_w(0, 0, check_cast<uint8_t>(value));
+	renderer->AddWrite(PIC_FullIndex(), write);
+}
+
+void GameBlaster::WriteDataToLeftDevice(io_port_t, io_val_t value, io_width_t)
+{
+	QueueWrite({0, false, check_cast<uint8_t>(value)});
 }
 
 void GameBlaster::WriteControlToLeftDevice(io_port_t, io_val_t value, io_width_t)
 {
-	RenderUpToNow();
-	devices[0]->control_w(0, 0, check_cast<uint8_t>(value));
+	QueueWrite({0, true, check_cast<uint8_t>(value)});
 }
 
 void GameBlaster::WriteDataToRightDevice(io_port_t, io_val_t value, io_width_t)
 {
-	RenderUpToNow();
-	devices[1]->data_w(0, 0, check_cast<uint8_t>(value));
+	QueueWrite({1, false, check_cast<uint8_t>(value)});
 }
 
 void GameBlaster::WriteControlToRightDevice(io_port_t, io_val_t value, io_width_t)
 {
-	RenderUpToNow();
-	devices[1]->control_w(0, 0, check_cast<uint8_t>(value));
+	QueueWrite({1, true, check_cast<uint8_t>(value)});
 }
 
 void GameBlaster::AudioCallback(const uint16_t requested_frames)
 {
+	ZoneScoped;
 	assert(channel);
 
-	//if (fifo.size())
-	//	LOG_MSG("CMS: Queued %2lu cycle-accurate frames", fifo.size());
-
-	auto frames_remaining = requested_frames;
-
-	// First, add any frames we've queued since the last callback
-	while (frames_remaining && fifo.size()) {
-		channel->AddSamples_sfloat(1, &fifo.front()[0]);
-		fifo.pop();
-		--frames_remaining;
+	if (renderer->DequeueFrames(requested_frames, callback_buffer)) {
+		channel->AddSamples_sfloat(requested_frames, &callback_buffer[0][0]);
+	} else {
+		channel->AddSilence();
 	}
-	// If the queue's run dry, render the remainder and sync-up our time datum
-	while (frames_remaining) {
-		if (AudioFrame f = {}; MaybeRenderFrame(f)) {
-			channel->AddSamples_sfloat(1, &f[0]);
-		}
-		--frames_remaining;
-	}
-	last_rendered_ms = PIC_FullIndex();
+	renderer->SetRenderedUpTo(PIC_FullIndex());
 }
 
 void GameBlaster::WriteToDetectionPort(io_port_t port, io_val_t value, io_width_t)
@@ -280,6 +297,9 @@ void GameBlaster::Close()
 	write_handler_for_detection.Uninstall();
 	read_handler_for_detection.Uninstall();
 
+	// Wait for the render thread to finish
+	renderer.reset();
+
 	// Stop playback
 	if (channel)
 		channel->Enable(false);
@@ -25,10 +25,10 @@
 
 #include <array>
 #include <memory>
-#include <queue>
 #include <string>
 #include <vector>
 
+#include "chip_renderer.h"
 #include "inout.h"
 #include "math_utils.h"
 #include "mixer.h"
@@ -48,11 +48,20 @@ public:
 	~GameBlaster() { Close(); }
 
 private:
+	// A data or control write to one of the SAA-1099 devices
+	struct DeviceWrite {
+		uint8_t device_index = 0;
+		bool is_control      = false;
+		uint8_t value        = 0;
+	};
+
 	// Audio rendering
 	bool MaybeRenderFrame(AudioFrame &frame);
-	std::vector<int16_t> GetFrame();
+	void RenderFrames(const int num_renders, std::vector<AudioFrame>& out);
+	void ApplyWrite(const DeviceWrite& write);
 	void AudioCallback(const uint16_t requested_frames);
 	void RenderUpToNow();
+	void QueueWrite(const DeviceWrite& write);
 
 	// IO callbacks to the left SAA1099 device
 	void WriteDataToLeftDevice(io_port_t port, io_val_t value, io_width_t width);
@@ -78,7 +87,9 @@ private:
 	std::unique_ptr<saa1099_device> devices[2]                   = {};
 	std::unique_ptr<reSIDfp::TwoPassSincResampler> resamplers[2] = {};
 
-	std::queue<AudioFrame> fifo = {};
+	// Renders both devices on their own thread
+	std::unique_ptr<ChipRenderer<DeviceWrite>> renderer = {};
+	std::vector<AudioFrame> callback_buffer             = {};
 
 	// Static rate-related configuration
 	static constexpr auto chip_clock     = 14318180 / 2;
@@ -88,7 +99,6 @@ private:
 	static constexpr auto ms_per_render  = millis_in_second / render_rate_hz;
 
 	// Runtime states
-	double last_rendered_ms        = 0;
 	io_port_t base_port            = 0;
 	bool is_standalone_gameblaster = false;
 	bool is_open                   = false;
@@ -34,12 +34,14 @@
 #include "control.h"
 #include "dma.h"
 #include "hardware.h"
+#include "host_memory.h"
 #include "math_utils.h"
 #include "mixer.h"
 #include "pic.h"
 #include "setup.h"
 #include "shell.h"
 #include "string_utils.h"
+#include "tracy.h"
 
 #define LOG_GUS 0 // set to 1 for detailed logging
 
@@ -165,6 +167,12 @@ private:
 	bool Is16Bit() const noexcept;
 	float GetVolScalar(const vol_scalars_array_t &vol_scalars);
 	float GetSample(const ram_array_t &ram) noexcept;
+	float ReadSample(const ram_array_t& ram, int32_t pos) const noexcept;
+	int FramesUntilBoundary(const VoiceCtrl& ctrl, int max_frames) const noexcept;
+	void RenderSpan(const ram_array_t& ram,
+	                const vol_scalars_array_t& vol_scalars,
+	                const AudioFrame& pan_scalar, AudioFrame* frames,
+	                int num_frames);
 	int32_t PopWavePos() noexcept;
 	float PopVolScalar(const vol_scalars_array_t &vol_scalars);
 	float Read8BitSample(const ram_array_t &ram, int32_t addr) const noexcept;
@@ -424,7 +432,13 @@ bool Voice::Is16Bit() const noexcept
 
 float Voice::GetSample(const ram_array_t &ram) noexcept
 {
-	const int32_t pos = PopWavePos();
+	return ReadSample(ram, PopWavePos());
+}
+
+// Reads the sample at the given wave position, interpolated with the next one
+// when the voice is playing slower than the sample rate
+float Voice::ReadSample(const ram_array_t& ram, const int32_t pos) const noexcept
+{
 	const auto addr = pos / WAVE_WIDTH;
 	const auto fraction = pos & (WAVE_WIDTH - 1);
 	const bool should_interpolate = wave_ctrl.inc < WAVE_WIDTH && fraction;
@@ -454,8 +468,22 @@ void Voice::RenderFrames(const ram_array_t& ram,
 
 	const auto pan_scalar = pan_scalars.at(pan_position);
 
-	// Sum the voice's samples into the exising frames, angled in L-R space
-	for (auto& frame : frames) {
+	// Sum the voice's samples into the exising frames, angled in L-R space.
+	// Frames that stay clear of the wave and volume boundaries are rendered
+	// in spans without the per-frame control checks; only the frame that
+	// reaches a boundary goes through the looping and IRQ logic.
+	const auto num_frames = check_cast<int>(frames.size());
+	auto i = 0;
+	while (i < num_frames) {
+		const auto remaining = num_frames - i;
+		const auto span = FramesUntilBoundary(
+		        vol_ctrl, FramesUntilBoundary(wave_ctrl, remaining));
+		if (span > 0) {
+			RenderSpan(ram, vol_scalars, pan_scalar, &frames[i], span);
+			i += span;
+			continue;
+		}
+		auto& frame = frames[i++];
 		float sample = GetSample(ram);
 		sample *= PopVolScalar(vol_scalars);
 		frame.left += sample * pan_scalar.left;
@@ -465,6 +493,67 @@ void Voice::RenderFrames(const ram_array_t& ram,
 	Is16Bit() ? generated_16bit_ms++ : generated_8bit_ms++;
 }
 
+// Returns how many frames, up to the given maximum, the control can step
+// through before its position reaches a boundary
+int Voice::FramesUntilBoundary(const VoiceCtrl& ctrl, const int max_frames) const noexcept
+{
+	// Stopped controls don't move
+	if (ctrl.state & CTRL::DISABLED) {
+		return max_frames;
+	}
+	const int64_t distance = (ctrl.state & CTRL::DECREASING)
+	                               ? int64_t{ctrl.pos} - ctrl.start
+	                               : int64_t{ctrl.end} - ctrl.pos;
+	if (distance <= 0) {
+		return 0;
+	}
+	if (ctrl.inc <= 0) {
+		return max_frames;
+	}
+	return static_cast<int>(std::min((distance - 1) / ctrl.inc,
+	                                 static_cast<int64_t>(max_frames)));
+}
+
+// Renders frames during which neither control reaches a boundary, so both
+// positions advance linearly. The wave reads are gathered into a block first,
+// which leaves the volume and panning as a loop the compiler can vectorize.
+void Voice::RenderSpan(const ram_array_t& ram,
+                       const vol_scalars_array_t& vol_scalars,
+                       const AudioFrame& pan_scalar, AudioFrame* frames,
+                       const int num_frames)
+{
+	auto step_of = [](const VoiceCtrl& ctrl) {
+		if (ctrl.state & CTRL::DISABLED) {
+			return 0;
+		}
+		return (ctrl.state & CTRL::DECREASING) ? -ctrl.inc : ctrl.inc;
+	};
+	const auto wave_step = step_of(wave_ctrl);
+	const auto vol_step  = step_of(vol_ctrl);
+
+	constexpr auto BlockSize = 64;
+	std::array<float, BlockSize> samples;
+
+	for (auto start = 0; start < num_frames; start += BlockSize) {
+		const auto block_size = std::min(BlockSize, num_frames - start);
+
+		for (auto i = 0; i < block_size; ++i) {
+			const auto vol_index = ceil_sdivide(vol_ctrl.pos,
+			                                    VOLUME_INC_SCALAR);
+			samples[i] = ReadSample(ram, wave_ctrl.pos) *
+			             vol_scalars[static_cast<size_t>(vol_index)];
+			wave_ctrl.pos += wave_step;
+			vol_ctrl.pos += vol_step;
+		}
+
+		auto* frame = frames + start;
+		for (auto i = 0; i < block_size; ++i) {
+			frame[i].left += samples[i] * pan_scalar.left;
+			frame[i].right += samples[i] * pan_scalar.right;
+		}
+	}
+}
+
 // Returns the current wave position and increments the position
 // to the next wave position.
 int32_t Voice::PopWavePos() noexcept
@@ -605,6 +694,8 @@ Gus::Gus(const io_port_t port_pref, const uint8_t dma_pref, const uint8_t irq_pr
 	constexpr io_port_t port_datum = 0x200;
 	port_base = port_pref - port_datum;
 
+	HOSTMEM_SetUsage("Gravis UltraSound", RAM_SIZE);
+
 	// Create the internal voice channels
 	for (uint8_t i = 0; i < MAX_VOICES; ++i) {
 		voices.emplace_back(i, voice_irq);
@@ -732,6 +823,7 @@ void Gus::RenderUpToNow()
 
 void Gus::AudioCallback(const uint16_t num_requested_frames)
 {
+	ZoneScoped;
 	assert(audio_channel);
 
 #if 0
@@ -1610,6 +1702,7 @@ Gus::~Gus()
 {
 	LOG_MSG("GUS: Shutting down");
 	StopPlayback();
+	HOSTMEM_SetUsage("Gravis UltraSound", 0);
 
 	// Prevent discovery of the GUS via the environment
 	ClearEnvironment();
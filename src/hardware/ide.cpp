@@ -12,6 +12,7 @@
 #include <algorithm>
 #include <cmath>
 #include <cassert>
+#include <cstring>
 
 #include "bios_disk.h"
 #include "callback.h"
@@ -35,6 +36,10 @@ static void ide_altio_w(io_port_t port, io_val_t val, io_width_t width);
 static uint32_t ide_altio_r(io_port_t port, io_width_t width);
 static void ide_baseio_w(io_port_t port, io_val_t val, io_width_t width);
 static uint32_t ide_baseio_r(io_port_t port, io_width_t width);
+static size_t ide_data_read_block(io_port_t port, io_width_t width,
+                                  uint8_t* data, size_t num);
+static size_t ide_data_write_block(io_port_t port, io_width_t width,
+                                   const uint8_t* data, size_t num);
 bool GetMSCDEXDrive(uint8_t drive_letter, CDROM_Interface **_cdrom);
 
 enum IDEDeviceType { IDE_TYPE_NONE, IDE_TYPE_HDD = 1, IDE_TYPE_CDROM };
@@ -150,6 +155,10 @@ public:
 	virtual void writecommand(uint8_t cmd);
 	virtual uint32_t data_read(io_width_t width);          /* read from 1F0h data port from IDE device */
 	virtual void data_write(uint32_t v, io_width_t width); /* write to 1F0h data port to IDE device */
+	/* REP INSx/OUTSx on the data port; return the elements done, 0 to
+	 * have the caller fall back to data_read/data_write */
+	virtual size_t data_read_block(io_width_t width, uint8_t* data, size_t num);
+	virtual size_t data_write_block(io_width_t width, const uint8_t* data, size_t num);
 	virtual bool command_interruption_ok(uint8_t cmd);
 	virtual void abort_silent();
 };
@@ -176,6 +185,9 @@ public:
 	uint32_t data_read(io_width_t width) override;
 	/* write to 1F0h data port to IDE device */
 	void data_write(uint32_t v, io_width_t width) override;
+	size_t data_read_block(io_width_t width, uint8_t* data, size_t num) override;
+	size_t data_write_block(io_width_t width, const uint8_t* data,
+	                        size_t num) override;
 	virtual void generate_identify_device();
 	virtual void prepare_read(uint32_t offset, uint32_t size);
 	virtual void prepare_write(uint32_t offset, uint32_t size);
@@ -234,6 +246,9 @@ public:
 	uint32_t data_read(io_width_t width) override;
 	/* write to 1F0h data port to IDE device */
 	void data_write(uint32_t v, io_width_t width) override;
+	size_t data_read_block(io_width_t width, uint8_t* data, size_t num) override;
+	size_t data_write_block(io_width_t width, const uint8_t* data,
+	                        size_t num) override;
 	virtual void generate_identify_device();
 	virtual void generate_mmc_inquiry();
 	virtual void prepare_read(uint32_t offset, uint32_t size);
@@ -1897,6 +1912,90 @@ void IDEATADevice::data_write(uint32_t v, io_width_t width)
 		io_completion();
 }
 
+size_t IDEATAPICDROMDevice::data_read_block(io_width_t width, uint8_t* data,
+                                            size_t num)
+{
+	if (state != IDE_DEV_DATA_READ || !(status & IDE_STATUS_DRQ) ||
+	    sector_i >= sector_total) {
+		return 0;
+	}
+	const auto bytes = static_cast<size_t>(width);
+	const auto n     = std::min(num, (sector_total - sector_i) / bytes);
+	if (n == 0) {
+		return 0;
+	}
+	memcpy(data, sector + sector_i, n * bytes);
+	sector_i += check_cast<uint32_t>(n * bytes);
+
+	if (sector_i >= sector_total)
+		io_completion();
+
+	return n;
+}
+
+size_t IDEATAPICDROMDevice::data_write_block(io_width_t width,
+                                             const uint8_t* data, size_t num)
+{
+	/* PACKET commands are a few bytes, leave them to data_write */
+	if (state != IDE_DEV_DATA_WRITE || !(status & IDE_STATUS_DRQ) ||
+	    sector_i >= sector_total) {
+		return 0;
+	}
+	const auto bytes = static_cast<size_t>(width);
+	const auto n     = std::min(num, (sector_total - sector_i) / bytes);
+	if (n == 0) {
+		return 0;
+	}
+	memcpy(sector + sector_i, data, n * bytes);
+	sector_i += check_cast<uint32_t>(n * bytes);
+
+	if (sector_i >= sector_total)
+		io_completion();
+
+	return n;
+}
+
+size_t IDEATADevice::data_read_block(io_width_t width, uint8_t* data, size_t num)
+{
+	if (state != IDE_DEV_DATA_READ || !(status & IDE_STATUS_DRQ) ||
+	    sector_i >= sector_total) {
+		return 0;
+	}
+	const auto bytes = static_cast<size_t>(width);
+	const auto n     = std::min(num, (sector_total - sector_i) / bytes);
+	if (n == 0) {
+		return 0;
+	}
+	memcpy(data, sector + sector_i, n * bytes);
+	sector_i += check_cast<uint32_t>(n * bytes);
+
+	if (sector_i >= sector_total)
+		io_completion();
+
+	return n;
+}
+
+size_t IDEATADevice::data_write_block(io_width_t width, const uint8_t* data,
+                                      size_t num)
+{
+	if (state != IDE_DEV_DATA_WRITE || !(status & IDE_STATUS_DRQ) ||
+	    sector_i >= sector_total) {
+		return 0;
+	}
+	const auto bytes = static_cast<size_t>(width);
+	const auto n     = std::min(num, (sector_total - sector_i) / bytes);
+	if (n == 0) {
+		return 0;
+	}
+	memcpy(sector + sector_i, data, n * bytes);
+	sector_i += check_cast<uint32_t>(n * bytes);
+
+	if (sector_i >= sector_total)
+		io_completion();
+
+	return n;
+}
+
 void IDEATAPICDROMDevice::prepare_read(uint32_t offset, uint32_t size)
 {
 	/* I/O must be WORD ALIGNED */
@@ -3406,6 +3505,16 @@ uint32_t IDEDevice::data_read(io_width_t)
 void IDEDevice::data_write(io_val_t, io_width_t)
 {}
 
+size_t IDEDevice::data_read_block(io_width_t, uint8_t*, size_t)
+{
+	return 0;
+}
+
+size_t IDEDevice::data_write_block(io_width_t, const uint8_t*, size_t)
+{
+	return 0;
+}
+
 /* IDE controller -> upon writing bit 2 of alt (0x3F6) */
 void IDEDevice::host_reset_complete()
 {
@@ -3835,6 +3944,9 @@ void IDEController::install_io_ports()
 			WriteHandler[i].Install(base_io + i, ide_baseio_w, io_width_t::dword);
 			ReadHandler[i].Install(base_io + i, ide_baseio_r, io_width_t::dword);
 		}
+		IO_RegisterBlockHandlers(base_io,
+		                         ide_data_read_block,
+		                         ide_data_write_block);
 	}
 
 	if (alt_io != 0) {
@@ -3854,6 +3966,7 @@ void IDEController::uninstall_io_ports()
 		h.Uninstall();
 	for (auto & h : ReadHandler)
 		h.Uninstall();
+	IO_FreeBlockHandlers(base_io);
 
 	// Uninstall the two sets of alternate I/O ports
 	assert(alt_io != 0);
@@ -3991,6 +4104,32 @@ static uint32_t ide_baseio_r(io_port_t port, io_width_t width)
 	return ret;
 }
 
+static IDEDevice* match_ide_data_device(io_port_t port, io_width_t width)
+{
+	IDEController* ide = match_ide_controller(port);
+	if (ide == nullptr || (ide->ignore_pio32 && width == io_width_t::dword))
+		return nullptr;
+
+	return ide->device[ide->select];
+}
+
+static size_t ide_data_read_block(io_port_t port, io_width_t width,
+                                  uint8_t* data, size_t num)
+{
+	IDEDevice* dev = match_ide_data_device(port, width);
+	return (dev != nullptr) ? dev->data_read_block(width, data, num) : 0;
+}
+
+static size_t ide_data_write_block(io_port_t port, io_width_t width,
+                                   const uint8_t* data, size_t num)
+{
+	IDEDevice* dev = match_ide_data_device(port, width);
+	if (dev == nullptr || (dev->status & IDE_STATUS_BUSY))
+		return 0;
+
+	return dev->data_write_block(width, data, num);
+}
+
 static void ide_baseio_w(io_port_t port, io_val_t val, io_width_t width)
 {
 	IDEController *ide = match_ide_controller(port);
@@ -55,7 +55,9 @@
 
 #include "dosbox.h"
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <cmath>
 #include <cstring>
@@ -65,6 +67,7 @@
 #include <string>
 #include <thread>
 #include <utility>
+#include <vector>
 
 #include "channel_names.h"
 #include "control.h"
@@ -76,6 +79,7 @@
 #include "regs.h"
 #include "setup.h"
 #include "shell.h"
+#include "tracy.h"
 
 #include "SDL_thread.h"
 
@@ -1617,24 +1621,32 @@ public:
 	virtual void valueChanged(DataType oldValue, DataType newValue) = 0;
 };
 
+// Holds the value itself, so reading a signal is a plain load rather than
+// a virtual call; only the change notifications go through the consumers.
 template <typename DataType>
 class DataProvider {
 private:
-	std::deque<DataChangedConsumer<DataType>*> m_consumers = {};
+	std::vector<DataChangedConsumer<DataType>*> m_consumers = {};
 
 protected:
+	std::atomic<DataType> m_value = {};
+
+	explicit DataProvider(DataType initialValue) : m_value(initialValue) {}
+
 	void notifyConsumers(DataType oldValue, DataType newValue)
 	{
-		for (auto& consumer : m_consumers) {
+		for (auto consumer : m_consumers) {
 			consumer->valueChanged(oldValue, newValue);
 		}
 	}
 
 public:
-	DataProvider()              = default;
-	virtual ~DataProvider()     = default;
+	virtual ~DataProvider() = default;
 
-	virtual DataType getValue() const = 0;
+	DataType getValue() const
+	{
+		return m_value.load(std::memory_order_acquire);
+	}
 	void notifyOnChange(DataChangedConsumer<DataType>* dataConsumer)
 	{
 		m_consumers.push_back(dataConsumer);
@@ -1644,28 +1656,23 @@ public:
 template <typename DataType>
 class DataContainer : public DataProvider<DataType> {
 private:
-	bool m_debug                  = false;
-	const std::string m_name      = {};
-	std::atomic<DataType> m_value = {};
+	bool m_debug             = false;
+	const std::string m_name = {};
 
 public:
 	DataContainer(const std::string& name, DataType inititalValue)
-	        : m_name(name),
-	          m_value(inititalValue)
+	        : DataProvider<DataType>(inititalValue),
+	          m_name(name)
 	{}
 	std::string getName() const
 	{
 		return m_name;
 	}
-	DataType getValue() const override
-	{
-		return m_value.load();
-	}
 	void setValue(DataType newValue)
 	{
-		DataType oldValue = m_value;
+		const DataType oldValue = this->getValue();
 		if (oldValue != newValue) {
-			m_value = newValue;
+			this->m_value.store(newValue, std::memory_order_release);
 			if (m_debug) {
 				IMF_LOG("%s changed from %X to %X",
 				        this->getName().c_str(),
@@ -2160,11 +2167,20 @@ private:
 	CounterData m_counter1{"timer.counter1"};
 	CounterData m_counter2{"timer.counter2"};
 
-	static void registerNextEvent()
+	// the counter0 has a resolution of 2 microseconds
+	static constexpr double TickMs = 0.002;
+
+	// Rather than counting down tick by tick, wait for the tick where the
+	// output of counter0 changes next: it goes LOW once the running
+	// counter reaches 1 and HIGH again one tick later.
+	void registerNextEvent()
 	{
-		// PIC_AddEvent takes milliseconds as argument
-		// the counter0 has a resolution of 2 microseconds
-		PIC_AddEvent(Intel8253_TimerEvent, 0.002, 0); // FIXME
+		PIC_RemoveEvents(Intel8253_TimerEvent);
+		if (m_counter0.m_counter == 0U) {
+			return;
+		}
+		const auto ticks = std::max(m_counter0.m_runningCounter, 1U);
+		PIC_AddEvent(Intel8253_TimerEvent, ticks * TickMs, 0);
 	}
 
 public:
@@ -2173,10 +2189,7 @@ public:
 		PIC_RemoveEvents(Intel8253_TimerEvent);
 	}
 
-	explicit Intel8253(const std::string& name) : m_name(name)
-	{
-		Intel8253::registerNextEvent(); // FIXME
-	}
+	explicit Intel8253(const std::string& name) : m_name(name) {}
 	DataProvider<bool>* getTimerA() const
 	{
 		return m_timerA.getDataProvider();
@@ -2202,6 +2215,7 @@ public:
 	{
 		IMF_LOG("writePortCNTR0 / value=0x%X", val);
 		m_counter0.writeCounterByte(val);
+		registerNextEvent();
 	}
 
 	uint8_t readPortCNTR1()
@@ -2287,20 +2301,16 @@ public:
 	void timerEvent(uint32_t /*val*/)
 	{
 		if (m_counter0.m_counter != 0U) {
-			// counter was initialized with a value
-			if (m_counter0.m_runningCounter > 1) {
-				// normal case -> decrease the counter
-				m_counter0.m_runningCounter--;
-				// IMF_LOG("m_counter0.m_runningCounter -> %i",
-				// m_counter0.m_runningCounter);
-			} else if (m_counter0.m_runningCounter == 1) {
+			// counter was initialized with a value and has counted
+			// down to the next change of the output
+			if (m_counter0.m_runningCounter > 0) {
 				// if the counter is 1, then the timer out goes LOW
 				if (m_debug) {
 					IMF_LOG("%s - m_runningCounter == 1 -> m_timerA = LOW",
 					        m_name.c_str());
 				}
 				m_timerA.setValue(false);
-				m_counter0.m_runningCounter--;
+				m_counter0.m_runningCounter = 0;
 				// IMF_LOG("m_counter0.m_runningCounter -> %i",
 				// m_counter0.m_runningCounter);
 				// IMF_LOG("m_timerA.OUT is going LOW");
@@ -2319,7 +2329,7 @@ public:
 			}
 		}
 		// TODO: the other timers
-		Intel8253::registerNextEvent(); // FIXME
+		registerNextEvent();
 	}
 };
 
@@ -13226,7 +13236,9 @@ public:
 	void onTimerEvent(const uint32_t val)
 	{
 		// IMF_LOG("->Intel8253_TimerEvent");
+		SDL_LockMutex(m_hardwareMutex);
 		m_timer.timerEvent(val);
+		SDL_UnlockMutex(m_hardwareMutex);
 	}
 
 	~MusicFeatureCard()
@@ -13354,6 +13366,7 @@ static void Intel8253_TimerEvent(const uint32_t val)
 
 static void IMFC_Mixer_Callback(const uint16_t requested_frames)
 {
+	ZoneScoped;
 	imfc->mixerCallback(requested_frames);
 }
 
@@ -26,6 +26,7 @@
 #include <memory>
 #include <queue>
 #include <string>
+#include <vector>
 
 #include "mixer.h"
 #include "inout.h"
@@ -37,6 +38,7 @@ public:
 	void Open(const std::string_view model_choice,
 	          const std::string_view clock_choice, int filter_strength_6581,
 	          int filter_strength_8580, int port_choice,
+	          const std::string_view sampling_choice,
 	          const std::string& channel_filter_choice);
 
 	void Close();
@@ -46,7 +48,7 @@ public:
 	}
 
 private:
-	bool MaybeRenderFrame(float &frame);
+	int RenderClocks(const int num_clocks);
 	void AudioCallback(const uint16_t requested_frames);
 	uint8_t ReadFromPort(io_port_t port, io_width_t width);
 	void RenderUpToNow();
@@ -60,6 +62,10 @@ private:
 	std::unique_ptr<reSIDfp::SID> service = {};
 	std::queue<float> fifo                = {};
 
+	// Scratch buffers for clocking the SID in batches
+	std::vector<int16_t> sample_buffer = {};
+	std::vector<float> frame_buffer    = {};
+
 	// Initial configuration
 	double chip_clock            = 0.0;
 	double ms_per_clock          = 0.0;
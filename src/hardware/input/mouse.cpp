@@ -33,6 +33,7 @@
 #include "cpu.h"
 #include "math_utils.h"
 #include "pic.h"
+#include "timer.h"
 #include "video.h"
 
 CHECK_NARROWING();
@@ -543,6 +544,77 @@ void MOUSE_NotifyBooting()
 	}
 }
 
+// ***************************************************************************
+// Coalescing of host pointer movements
+// ***************************************************************************
+
+// Host mice can report movements at 1000 Hz and more, while none of the
+// emulated interfaces samples faster than 200 Hz. The first movement after
+// a quiet period is passed on immediately; the following ones are summed up
+// (sub-pixel parts included) and passed on once per sample interval of the
+// fastest interface using the host pointer.
+
+static struct {
+	float x_rel = 0.0f;
+	float y_rel = 0.0f;
+
+	bool has_data = false;
+
+	// Milliseconds to wait before the next movement can be passed on
+	uint8_t wait_ms = 0;
+} pending_move;
+
+static uint8_t get_move_interval_ms()
+{
+	uint8_t interval_ms = UINT8_MAX;
+	for (const auto& interface : mouse_interfaces) {
+		if (interface->IsUsingHostPointer() && interface->GetRate()) {
+			interval_ms = std::min(interval_ms,
+			                       MOUSE_GetDelayFromRateHz(
+			                               interface->GetRate()));
+		}
+	}
+	return (interval_ms == UINT8_MAX) ? 0 : interval_ms;
+}
+
+static void flush_pending_move()
+{
+	if (!pending_move.has_data) {
+		return;
+	}
+
+	const auto x_rel = pending_move.x_rel;
+	const auto y_rel = pending_move.y_rel;
+
+	pending_move.x_rel    = 0.0f;
+	pending_move.y_rel    = 0.0f;
+	pending_move.has_data = false;
+	pending_move.wait_ms  = get_move_interval_ms();
+
+	// The mouse might have been released or the GUI might have taken over
+	// since the movement was queued
+	if (should_drop_move()) {
+		return;
+	}
+
+	for (auto& interface : mouse_interfaces) {
+		if (interface->IsUsingHostPointer()) {
+			interface->NotifyMoved(x_rel,
+			                       y_rel,
+			                       state.cursor_x_abs,
+			                       state.cursor_y_abs);
+		}
+	}
+}
+
+static void pending_move_tick()
+{
+	if (pending_move.wait_ms && --pending_move.wait_ms) {
+		return;
+	}
+	flush_pending_move();
+}
+
 void MOUSE_EventMoved(const float x_rel, const float y_rel,
                       const int32_t x_abs, const int32_t y_abs)
 {
@@ -573,16 +645,15 @@ void MOUSE_EventMoved(const float x_rel, const float y_rel,
 	// act both ways (seamless and non-seamless mouse pointer),
 	// so it needs data in both formats.
 
-	// Notify mouse interfaces
-	const float x_scaled = x_rel * mouse_config.sensitivity_coeff_x;
-	const float y_scaled = y_rel * mouse_config.sensitivity_coeff_y;
-	for (auto& interface : mouse_interfaces) {
-		if (interface->IsUsingHostPointer()) {
-			interface->NotifyMoved(x_scaled,
-			                       y_scaled,
-			                       state.cursor_x_abs,
-			                       state.cursor_y_abs);
-		}
+	// Queue the movement for the mouse interfaces
+	pending_move.x_rel = MOUSE_ClampRelativeMovement(
+	        pending_move.x_rel + x_rel * mouse_config.sensitivity_coeff_x);
+	pending_move.y_rel = MOUSE_ClampRelativeMovement(
+	        pending_move.y_rel + y_rel * mouse_config.sensitivity_coeff_y);
+	pending_move.has_data = true;
+
+	if (!pending_move.wait_ms) {
+		flush_pending_move();
 	}
 }
 
@@ -609,6 +680,10 @@ void MOUSE_EventButton(const MouseButtonId button_id, const bool pressed)
 {
 	// Event from GFX
 
+	// Deliver the queued movement first, so the button state changes
+	// at the right position
+	flush_pending_move();
+
 	// Never ignore any button releases - always pass them
 	// to concrete interfaces, they will decide whether to
 	// ignore them or not.
@@ -671,6 +746,8 @@ void MOUSE_EventWheel(const int16_t w_rel)
 {
 	// Event from GFX
 
+	flush_pending_move();
+
 	// Drop unneeded events
 	if (should_drop_press_or_wheel()) {
 		return;
@@ -1103,6 +1180,7 @@ void MOUSE_StartupIfReady()
 	RealSetVec(0x74, CALLBACK_RealPointer(call_int74));
 
 	MouseInterface::InitAllInstances();
+	TIMER_AddTickHandler(&pending_move_tick);
 	mouse_shared.started = true;
 
 	MOUSE_UpdateGFX();
@@ -269,6 +269,8 @@ static void config_read(Section *section)
 	mouse_config.raw_input      = conf->Get_bool("mouse_raw_input");
 	mouse_config.dos_immediate  = conf->Get_bool("dos_mouse_immediate");
 
+	mouse_config.dos_cursor_overlay = conf->Get_bool("dos_mouse_cursor_overlay");
+
 	// Settings below should be read only once
 
 	if (mouse_shared.ready_config) {
@@ -399,6 +401,17 @@ static void config_init(Section_prop &secprop)
 	        "Please report it if you find another incompatible game so we can update this\n"
 	        "list.");
 
+	prop_bool = secprop.Add_bool("dos_mouse_cursor_overlay", always, false);
+	assert(prop_bool);
+	prop_bool->Set_help(
+	        "Draw the built-in DOS mouse driver's cursor on top of the emulated screen\n"
+	        "instead of into the video memory (disabled by default). Saves the work of\n"
+	        "saving, drawing, and restoring the pixels under the cursor on every move.\n"
+	        "Only affects the graphics modes with up to 256 colours on VGA and SVGA\n"
+	        "machines; text modes always use the regular cursor.\n"
+	        "Note: Programs reading back the screen see it without the cursor, which\n"
+	        "is what they expect when they hide it before drawing.");
+
 	// Physical mice configuration
 
 	// TODO: PS/2 mouse might be hot-pluggable
@@ -85,8 +85,9 @@ struct MouseConfig {
 	bool raw_input           = false; // true = relative input is raw data
 	bool multi_display_aware = false;
 
-	bool dos_driver    = false; // whether DOS virtual mouse driver should be enabled
-	bool dos_immediate = false;
+	bool dos_driver         = false; // whether DOS virtual mouse driver should be enabled
+	bool dos_immediate      = false;
+	bool dos_cursor_overlay = false; // whether the renderer draws the cursor
 
 	MouseModelPS2 model_ps2 = MouseModelPS2::Standard;
 
@@ -34,6 +34,7 @@
 #include "math_utils.h"
 #include "pic.h"
 #include "regs.h"
+#include "vga.h"
 
 #include "../../ints/int10.h"
 
@@ -511,6 +512,8 @@ static void clip_cursor_area(int16_t &x1, int16_t &x2, int16_t &y1, int16_t &y2,
 
 static void restore_cursor_background()
 {
+	VGA_HideMouseOverlay();
+
 	if (state.hidden || state.inhibit_draw || !state.background.enabled) {
 		return;
 	}
@@ -590,6 +593,23 @@ static void draw_cursor()
 
 	restore_cursor_background();
 
+	const auto screen_mask = state.user_screen_mask ? state.user_def_screen_mask
+	                                                : default_screen_mask;
+	const auto cursor_mask = state.user_cursor_mask ? state.user_def_cursor_mask
+	                                                : default_cursor_mask;
+
+	// Let the renderer composite the cursor, so the guest's video memory
+	// doesn't have to be saved, drawn to, and restored on every move
+	if (mouse_config.dos_cursor_overlay && VGA_CanDrawMouseOverlay()) {
+		VGA_SetMouseOverlay(get_pos_x() / xratio - state.hot_x,
+		                    get_pos_y() - state.hot_y,
+		                    CurMode->swidth,
+		                    CurMode->sheight,
+		                    screen_mask,
+		                    cursor_mask);
+		return;
+	}
+
 	save_vga_registers();
 
 	// Save Background
@@ -619,11 +639,7 @@ static void draw_cursor()
 	state.background.pos_y = static_cast<uint16_t>(get_pos_y() - state.hot_y);
 
 	// Draw Mousecursor
-	data_pos               = static_cast<uint16_t>(addy * cursor_size_x);
-	const auto screen_mask = state.user_screen_mask ? state.user_def_screen_mask
-	                                                : default_screen_mask;
-	const auto cursor_mask = state.user_cursor_mask ? state.user_def_cursor_mask
-	                                                : default_cursor_mask;
+	data_pos = static_cast<uint16_t>(addy * cursor_size_x);
 	for (int16_t y = y1; y <= y2; y++) {
 		uint16_t sc_mask = screen_mask[addy + y - y1];
 		uint16_t cu_mask = cursor_mask[addy + y - y1];
@@ -1618,6 +1634,7 @@ static Bitu int33_handler()
 		state.enabled   = false;
 		state.oldhidden = state.hidden;
 		state.hidden    = 1;
+		VGA_HideMouseOverlay();
 		// According to Ralf Brown Interrupt List it returns 0x20 if
 		// success,  but CuteMouse source code claims the code for
 		// success if 0x1f. Both agree that 0xffff means failure.
@@ -21,6 +21,7 @@
 
 #include "inout.h"
 
+#include <algorithm>
 #include <cassert>
 #include <limits>
 #include <cstring>
@@ -30,12 +31,13 @@
 #include "cpu.h"
 #include "../src/cpu/lazyflags.h"
 #include "callback.h"
+#include "event_counters.h"
+#include "pic.h"
 
 //#define ENABLE_PORTLOG
 
 // type-sized IO handler containers
-extern std::unordered_map<io_port_t, io_read_f> io_read_handlers[io_widths];
-extern std::unordered_map<io_port_t, io_write_f> io_write_handlers[io_widths];
+void IO_FreeAllHandlers();
 
 // type-sized IO handler API
 uint8_t read_byte_from_port(const io_port_t port);
@@ -51,6 +53,10 @@ struct IOF_Entry {
 	Bitu eip;
 };
 
+static EventCounter port_accesses("I/O port accesses",
+                                  std::numeric_limits<io_port_t>::max() + 1,
+                                  "port %03zXh");
+
 #define IOF_QUEUESIZE 16
 static struct {
 	Bitu used;
@@ -103,6 +109,71 @@ inline void IO_USEC_write_delay() {
 	CPU_IODelayRemoved += delaycyc;
 }
 
+/* Busy-wait detection. A lot of DOS code spins on a status port (VGA
+ * retrace, DSP status, PIT latch, ...) until an event scheduled with
+ * PIC_AddEvent changes its value. When the same instruction keeps reading the
+ * same value from the same port, with all registers unchanged and no other
+ * port access in between, the loop can't get anywhere before the next event
+ * fires. The cycles up to that point are then skipped, as is done for HLT.
+ */
+constexpr int BusyWaitMinRepeats = 16;
+
+// upper limit for the instructions of a polling loop, excluding the read delay
+constexpr int32_t BusyWaitMaxLoopCycles = 32;
+
+static struct {
+	GenReg32 regs[8]     = {};
+	uint32_t cs          = 0;
+	Bitu eip             = 0;
+	io_val_t value       = 0;
+	int64_t cycle_stamp  = 0;
+	io_port_t port       = 0;
+	int repeats          = 0;
+	bool fast_forwarded  = false;
+} busy_wait = {};
+
+static void detect_busy_wait(const io_port_t port, const io_val_t value)
+{
+	auto& bw = busy_wait;
+
+	const auto now = static_cast<int64_t>(PIC_Ticks) * CPU_CycleMax +
+	                 PIC_TickIndexND();
+	const auto max_distance = BusyWaitMaxLoopCycles +
+	                          CPU_CycleMax / IODELAY_READ_MICROSk;
+
+	// after skipping ahead, the next read is far away but still part of
+	// the same loop
+	const auto is_same_loop = port == bw.port && value == bw.value &&
+	                          SegValue(cs) == bw.cs && reg_eip == bw.eip &&
+	                          (bw.fast_forwarded ||
+	                           now - bw.cycle_stamp <= max_distance) &&
+	                          memcmp(cpu_regs.regs, bw.regs, sizeof(bw.regs)) == 0;
+	bw.cycle_stamp    = now;
+	bw.fast_forwarded = false;
+
+	if (!is_same_loop) {
+		memcpy(bw.regs, cpu_regs.regs, sizeof(bw.regs));
+		bw.cs      = SegValue(cs);
+		bw.eip     = reg_eip;
+		bw.value   = value;
+		bw.port    = port;
+		bw.repeats = 0;
+		return;
+	}
+	if (++bw.repeats < BusyWaitMinRepeats || CPU_Cycles <= 0) {
+		return;
+	}
+	CPU_IODelayRemoved += CPU_Cycles;
+	CPU_Cycles = 0;
+	bw.fast_forwarded = true;
+}
+
+// anything written to a port could be what the loop is waiting for
+static inline void reset_busy_wait()
+{
+	busy_wait.repeats = 0;
+}
+
 #ifdef ENABLE_PORTLOG
 static uint8_t crtc_index = 0;
 
@@ -167,6 +238,7 @@ void log_io(io_width_t width, bool write, io_port_t port, io_val_t val)
 
 void IO_WriteB(io_port_t port, uint8_t val)
 {
+	port_accesses.Add(port);
 	log_io(io_width_t::byte, true, port, val);
 	if (GETFLAG(VM) && (CPU_IO_Exception(port, 1))) {
 		const auto old_lflags = lflags;
@@ -196,11 +268,13 @@ void IO_WriteB(io_port_t port, uint8_t val)
 	} else {
 		IO_USEC_write_delay();
 		write_byte_to_port(port, val);
+		reset_busy_wait();
 	}
 }
 
 void IO_WriteW(io_port_t port, uint16_t val)
 {
+	port_accesses.Add(port);
 	log_io(io_width_t::word, true, port, val);
 	if (GETFLAG(VM) && (CPU_IO_Exception(port, 2))) {
 		const auto old_lflags = lflags;
@@ -230,11 +304,13 @@ void IO_WriteW(io_port_t port, uint16_t val)
 	} else {
 		IO_USEC_write_delay();
 		write_word_to_port(port, val);
+		reset_busy_wait();
 	}
 }
 
 void IO_WriteD(io_port_t port, uint32_t val)
 {
+	port_accesses.Add(port);
 	log_io(io_width_t::dword, true, port, val);
 	if (GETFLAG(VM) && (CPU_IO_Exception(port, 4))) {
 		const auto old_lflags = lflags;
@@ -263,11 +339,13 @@ void IO_WriteD(io_port_t port, uint32_t val)
 		cpudecoder=old_cpudecoder;
 	} else {
 		write_dword_to_port(port, val);
+		reset_busy_wait();
 	}
 }
 
 uint8_t IO_ReadB(io_port_t port)
 {
+	port_accesses.Add(port);
 	uint8_t retval;
 	if (GETFLAG(VM) && (CPU_IO_Exception(port, 1))) {
 		const auto old_lflags = lflags;
@@ -298,6 +376,7 @@ uint8_t IO_ReadB(io_port_t port)
 	} else {
 		IO_USEC_read_delay();
 		retval = read_byte_from_port(port);
+		detect_busy_wait(port, retval);
 	}
 	log_io(io_width_t::byte, false, port, retval);
 	return retval;
@@ -305,6 +384,7 @@ uint8_t IO_ReadB(io_port_t port)
 
 uint16_t IO_ReadW(io_port_t port)
 {
+	port_accesses.Add(port);
 	uint16_t retval;
 	if (GETFLAG(VM) && (CPU_IO_Exception(port, 2))) {
 		const auto old_lflags = lflags;
@@ -334,6 +414,7 @@ uint16_t IO_ReadW(io_port_t port)
 	} else {
 		IO_USEC_read_delay();
 		retval = read_word_from_port(port);
+		detect_busy_wait(port, retval);
 	}
 	log_io(io_width_t::word, false, port, retval);
 	return retval;
@@ -341,6 +422,7 @@ uint16_t IO_ReadW(io_port_t port)
 
 uint32_t IO_ReadD(io_port_t port)
 {
+	port_accesses.Add(port);
 	uint32_t retval;
 	if (GETFLAG(VM) && (CPU_IO_Exception(port, 4))) {
 		const auto old_lflags = lflags;
@@ -369,6 +451,7 @@ uint32_t IO_ReadD(io_port_t port)
 		cpudecoder=old_cpudecoder;
 	} else {
 		retval = read_dword_from_port(port);
+		detect_busy_wait(port, retval);
 	}
 
 	log_io(io_width_t::dword, false, port, retval);
@@ -376,6 +459,80 @@ uint32_t IO_ReadD(io_port_t port)
 }
 
 
+struct IO_BlockHandlers {
+	io_block_read_f read   = {};
+	io_block_write_f write = {};
+};
+
+static std::unordered_map<io_port_t, IO_BlockHandlers> block_handlers = {};
+
+void IO_RegisterBlockHandlers(const io_port_t port,
+                              io_block_read_f read_handler,
+                              io_block_write_f write_handler)
+{
+	block_handlers[port] = {std::move(read_handler),
+	                        std::move(write_handler)};
+}
+
+void IO_FreeBlockHandlers(const io_port_t port)
+{
+	block_handlers.erase(port);
+}
+
+// The per-access delays add up as if the elements were done one by one;
+// dword accesses don't have any
+static void block_delay(const io_width_t width, const size_t num,
+                        const int32_t micros_k)
+{
+	if (width == io_width_t::dword) {
+		return;
+	}
+	auto delaycyc = static_cast<int64_t>(CPU_CycleMax / micros_k) *
+	                static_cast<int64_t>(num);
+	if (delaycyc > CPU_Cycles) {
+		delaycyc = CPU_Cycles;
+	}
+	CPU_Cycles -= static_cast<int32_t>(delaycyc);
+	CPU_IODelayRemoved += delaycyc;
+}
+
+size_t IO_ReadBlock(const io_port_t port, const io_width_t width,
+                    uint8_t* data, const size_t num)
+{
+	const auto it = block_handlers.find(port);
+	if (it == block_handlers.end() || !it->second.read) {
+		return 0;
+	}
+	// virtualised port accesses have to go through the fault path
+	if (GETFLAG(VM) && CPU_IO_Exception(port, static_cast<Bitu>(width))) {
+		return 0;
+	}
+	const auto done = it->second.read(port, width, data, num);
+	if (done) {
+		block_delay(width, done, IODELAY_READ_MICROSk);
+		reset_busy_wait();
+	}
+	return done;
+}
+
+size_t IO_WriteBlock(const io_port_t port, const io_width_t width,
+                     const uint8_t* data, const size_t num)
+{
+	const auto it = block_handlers.find(port);
+	if (it == block_handlers.end() || !it->second.write) {
+		return 0;
+	}
+	if (GETFLAG(VM) && CPU_IO_Exception(port, static_cast<Bitu>(width))) {
+		return 0;
+	}
+	const auto done = it->second.write(port, width, data, num);
+	if (done) {
+		block_delay(width, done, IODELAY_WRITE_MICROSk);
+		reset_busy_wait();
+	}
+	return done;
+}
+
 class IO final : public Module_base {
 public:
 	IO(Section* configuration):Module_base(configuration){
@@ -383,22 +540,8 @@ public:
 	}
 	~IO()
 	{
-		[[maybe_unused]] size_t total_bytes = 0u;
-		for (uint8_t i = 0; i < io_widths; ++i) {
-			const auto readers = io_read_handlers[i].size();
-			const auto writers = io_write_handlers[i].size();
-			LOG_DEBUG("IOBUS: Releasing %d read and %d write %d-bit port handlers",
-			          static_cast<int>(readers),
-			          static_cast<int>(writers),
-			          8 << i);
-
-			total_bytes += readers * sizeof(io_read_f) + sizeof(io_read_handlers[i]);
-			total_bytes += writers * sizeof(io_write_f) + sizeof(io_write_handlers[i]);
-			io_read_handlers[i].clear();
-			io_write_handlers[i].clear();
-		}
-		LOG_DEBUG("IOBUS: Handlers consumed %d total bytes",
-		          static_cast<int>(total_bytes));
+		IO_FreeAllHandlers();
+		block_handlers.clear();
 	}
 };
 
@@ -21,11 +21,13 @@
 
 #include "dosbox.h"
 
+#include <array>
 #include <cassert>
 #include <cstring>
+#include <deque>
 #include <functional>
 #include <limits>
-#include <unordered_map>
+#include <vector>
 
 #include "inout.h"
 #include "support.h"
@@ -54,13 +56,111 @@ IO_WriteHandleObject::~IO_WriteHandleObject(){
 	// static_cast<uint32_t>(m_port));
 }
 
+// Direct-mapped dispatch table for one access width. Every port holds the
+// index of a slot in a list of handlers, slot 0 meaning that nothing is
+// installed, so looking up a handler is two indexed loads. A slot is shared by
+// all ports of a range installed in one go and is recycled once the last of
+// them is freed. Slots live in a deque, so installing handlers from within a
+// handler doesn't move the one that's running.
+template <typename Handler>
+class IoHandlerTable {
+public:
+	IoHandlerTable() : slots(1) {}
+
+	const Handler* Find(const io_port_t port) const
+	{
+		const auto slot = ports[port];
+		return slot ? &slots[slot].handler : nullptr;
+	}
+
+	void Install(io_port_t port, const Handler& handler, io_port_t range)
+	{
+		const auto slot = AllocateSlot(handler);
+		while (range--) {
+			Release(port);
+			ports[port] = slot;
+			++slots[slot].num_ports;
+			++num_installed;
+			++port;
+		}
+		// an empty range leaves the slot unused
+		if (!slots[slot].num_ports) {
+			free_slots.push_back(slot);
+		}
+	}
+
+	void Uninstall(io_port_t port, io_port_t range)
+	{
+		while (range--) {
+			Release(port);
+			++port;
+		}
+	}
+
+	size_t NumInstalled() const
+	{
+		return num_installed;
+	}
+
+	size_t NumSlots() const
+	{
+		return slots.size();
+	}
+
+	void Clear()
+	{
+		ports.fill(0);
+		slots.resize(1);
+		free_slots.clear();
+		num_installed = 0;
+	}
+
+private:
+	uint32_t AllocateSlot(const Handler& handler)
+	{
+		if (free_slots.empty()) {
+			slots.push_back({handler, 0});
+			return static_cast<uint32_t>(slots.size() - 1);
+		}
+		const auto slot = free_slots.back();
+		free_slots.pop_back();
+		slots[slot].handler = handler;
+		return slot;
+	}
+
+	void Release(const io_port_t port)
+	{
+		const auto slot = ports[port];
+		if (!slot) {
+			return;
+		}
+		ports[port] = 0;
+		--num_installed;
+		// the handler itself is only replaced when the slot gets reused,
+		// as it might be the one that is uninstalling itself right now
+		if (--slots[slot].num_ports == 0) {
+			free_slots.push_back(slot);
+		}
+	}
+
+	struct Slot {
+		Handler handler   = {};
+		uint32_t num_ports = 0;
+	};
+
+	std::array<uint32_t, std::numeric_limits<io_port_t>::max() + 1> ports = {};
+	std::deque<Slot> slots;
+	std::vector<uint32_t> free_slots = {};
+	size_t num_installed = 0;
+};
+
 // type-sized IO handlers
-std::unordered_map<io_port_t, io_read_f> io_read_handlers[io_widths] = {};
+static IoHandlerTable<io_read_f> io_read_handlers[io_widths] = {};
 constexpr auto &io_read_byte_handler = io_read_handlers[0];
 constexpr auto &io_read_word_handler = io_read_handlers[1];
 constexpr auto &io_read_dword_handler = io_read_handlers[2];
 
-std::unordered_map<io_port_t, io_write_f> io_write_handlers[io_widths] = {};
+static IoHandlerTable<io_write_f> io_write_handlers[io_widths] = {};
 constexpr auto &io_write_byte_handler = io_write_handlers[0];
 constexpr auto &io_write_word_handler = io_write_handlers[1];
 constexpr auto &io_write_dword_handler = io_write_handlers[2];
@@ -73,31 +173,32 @@ constexpr io_val_t blocked_read(const io_port_t, const io_width_t)
 // type-sized IO handler API
 uint8_t read_byte_from_port(const io_port_t port)
 {
-	const auto [it, was_blocked] = io_read_byte_handler.emplace(port, blocked_read);
-	if (was_blocked)
+	auto reader = io_read_byte_handler.Find(port);
+	if (!reader) {
 		LOG(LOG_IO, LOG_WARN)("Unhandled read from port %04Xh; blocking", port);
-	return it->second(port, io_width_t::byte) & 0xff;
+		io_read_byte_handler.Install(port, blocked_read, 1);
+		reader = io_read_byte_handler.Find(port);
+	}
+	return (*reader)(port, io_width_t::byte) & 0xff;
 }
 
 uint16_t read_word_from_port(const io_port_t port)
 {
-	const auto reader = io_read_word_handler.find(port);
-	const auto value = reader != io_read_word_handler.end()
-	                           ? (reader->second(port, io_width_t::word) & 0xffff)
-	                           : static_cast<io_val_t>(
-	                                     read_byte_from_port(port) |
-	                                     (read_byte_from_port(port + 1) << 8));
+	const auto reader = io_read_word_handler.Find(port);
+	const auto value = reader ? ((*reader)(port, io_width_t::word) & 0xffff)
+	                          : static_cast<io_val_t>(
+	                                    read_byte_from_port(port) |
+	                                    (read_byte_from_port(port + 1) << 8));
 	return check_cast<uint16_t>(value);
 }
 
 uint32_t read_dword_from_port(const io_port_t port)
 {
-	const auto reader = io_read_dword_handler.find(port);
-	const auto value = reader != io_read_dword_handler.end()
-	                           ? reader->second(port, io_width_t::dword)
-	                           : static_cast<io_val_t>(
-	                                     read_word_from_port(port) |
-	                                     (read_word_from_port(port + 2) << 16));
+	const auto reader = io_read_dword_handler.Find(port);
+	const auto value = reader ? (*reader)(port, io_width_t::dword)
+	                          : static_cast<io_val_t>(
+	                                    read_word_from_port(port) |
+	                                    (read_word_from_port(port + 2) << 16));
 	assert(value <= UINT32_MAX);
 	return static_cast<uint32_t>(value);
 }
@@ -109,19 +210,22 @@ constexpr void blocked_write(const io_port_t, const io_val_t, const io_width_t)
 
 void write_byte_to_port(const io_port_t port, const uint8_t val)
 {
-	const auto [it, was_blocked] = io_write_byte_handler.emplace(port, blocked_write);
-	if (was_blocked)
+	auto writer = io_write_byte_handler.Find(port);
+	if (!writer) {
 		LOG(LOG_IO, LOG_WARN)("Unhandled write of value 0x%02x"
 		                      " (%u) to port %04Xh; blocking",
 		                      val, val, port);
-	it->second(port, val, io_width_t::byte);
+		io_write_byte_handler.Install(port, blocked_write, 1);
+		writer = io_write_byte_handler.Find(port);
+	}
+	(*writer)(port, val, io_width_t::byte);
 }
 
 void write_word_to_port(const io_port_t port, const uint16_t val)
 {
-	const auto writer = io_write_word_handler.find(port);
-	if (writer != io_write_word_handler.end()) {
-		writer->second(port, val, io_width_t::word);
+	const auto writer = io_write_word_handler.Find(port);
+	if (writer) {
+		(*writer)(port, val, io_width_t::word);
 	} else {
 		write_byte_to_port(port, static_cast<uint8_t>(val & 0xff));
 		write_byte_to_port(port + 1, static_cast<uint8_t>(val >> 8));
@@ -130,9 +234,9 @@ void write_word_to_port(const io_port_t port, const uint16_t val)
 
 void write_dword_to_port(const io_port_t port, const uint32_t val)
 {
-	const auto writer = io_write_dword_handler.find(port);
-	if (writer != io_write_dword_handler.end()) {
-		writer->second(port, val, io_width_t::dword);
+	const auto writer = io_write_dword_handler.Find(port);
+	if (writer) {
+		(*writer)(port, val, io_width_t::dword);
 	} else {
 		write_word_to_port(port, static_cast<uint16_t>(val & 0xffff));
 		write_word_to_port(port + 2, static_cast<uint16_t>(val >> 16));
@@ -144,14 +248,11 @@ void IO_RegisterReadHandler(io_port_t port,
                             const io_width_t max_width,
                             io_port_t range)
 {
-	while (range--) {
-		io_read_byte_handler[port] = handler;
-		if (max_width == io_width_t::word || max_width == io_width_t::dword)
-			io_read_word_handler[port] = handler;
-		if (max_width == io_width_t::dword)
-			io_read_dword_handler[port] = handler;
-		++port;
-	}
+	io_read_byte_handler.Install(port, handler, range);
+	if (max_width == io_width_t::word || max_width == io_width_t::dword)
+		io_read_word_handler.Install(port, handler, range);
+	if (max_width == io_width_t::dword)
+		io_read_dword_handler.Install(port, handler, range);
 }
 
 void IO_RegisterWriteHandler(io_port_t port,
@@ -159,42 +260,53 @@ void IO_RegisterWriteHandler(io_port_t port,
                              const io_width_t max_width,
                              io_port_t range)
 {
-	while (range--) {
-		io_write_byte_handler[port] = handler;
-		if (max_width == io_width_t::word || max_width == io_width_t::dword)
-			io_write_word_handler[port] = handler;
-		if (max_width == io_width_t::dword)
-			io_write_dword_handler[port] = handler;
-		++port;
-	}
+	io_write_byte_handler.Install(port, handler, range);
+	if (max_width == io_width_t::word || max_width == io_width_t::dword)
+		io_write_word_handler.Install(port, handler, range);
+	if (max_width == io_width_t::dword)
+		io_write_dword_handler.Install(port, handler, range);
 }
 
 void IO_FreeReadHandler(io_port_t port,
                         const io_width_t max_width,
                         io_port_t range)
 {
-	while (range--) {
-		io_read_byte_handler.erase(port);
-		if (max_width == io_width_t::word || max_width == io_width_t::dword)
-			io_read_word_handler.erase(port);
-		if (max_width == io_width_t::dword)
-			io_read_dword_handler.erase(port);
-		++port;
-	}
+	io_read_byte_handler.Uninstall(port, range);
+	if (max_width == io_width_t::word || max_width == io_width_t::dword)
+		io_read_word_handler.Uninstall(port, range);
+	if (max_width == io_width_t::dword)
+		io_read_dword_handler.Uninstall(port, range);
 }
 
 void IO_FreeWriteHandler(io_port_t port,
                          const io_width_t width,
                          io_port_t range)
 {
-	while (range--) {
-		io_write_byte_handler.erase(port);
-		if (width == io_width_t::word || width == io_width_t::dword)
-			io_write_word_handler.erase(port);
-		if (width == io_width_t::dword)
-			io_write_dword_handler.erase(port);
-		++port;
+	io_write_byte_handler.Uninstall(port, range);
+	if (width == io_width_t::word || width == io_width_t::dword)
+		io_write_word_handler.Uninstall(port, range);
+	if (width == io_width_t::dword)
+		io_write_dword_handler.Uninstall(port, range);
+}
+
+void IO_FreeAllHandlers()
+{
+	[[maybe_unused]] size_t total_bytes = 0u;
+	for (uint8_t i = 0; i < io_widths; ++i) {
+		auto& readers = io_read_handlers[i];
+		auto& writers = io_write_handlers[i];
+		LOG_DEBUG("IOBUS: Releasing %d read and %d write %d-bit port handlers",
+		          static_cast<int>(readers.NumInstalled()),
+		          static_cast<int>(writers.NumInstalled()),
+		          8 << i);
+
+		total_bytes += readers.NumSlots() * sizeof(io_read_f) + sizeof(readers);
+		total_bytes += writers.NumSlots() * sizeof(io_write_f) + sizeof(writers);
+		readers.Clear();
+		writers.Clear();
 	}
+	LOG_DEBUG("IOBUS: Handlers consumed %d total bytes",
+	          static_cast<int>(total_bytes));
 }
 
 void IO_ReadHandleObject::Install(const io_port_t port,
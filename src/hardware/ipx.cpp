@@ -23,11 +23,20 @@
 
 #include <SDL_net.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cinttypes>
 #include <cstdio>
 #include <cstring>
 #include <ctime>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <unordered_map>
 
+#include "control.h"
 #include "cross.h"
 #include "string_utils.h"
 #include "cpu.h"
@@ -40,9 +49,13 @@
 #include "mem.h"
 #include "ipx.h"
 #include "ipxserver.h"
+#include "network_log.h"
+#include "network_stats.h"
 #include "timer.h"
 #include "programs.h"
 #include "pic.h"
+#include "spsc_ring.h"
+#include "support.h"
 
 #define SOCKTABLESIZE	150 // DOS IPX driver was limited to 150 open sockets
 
@@ -85,6 +98,31 @@ void PackIP(IPaddress ipAddr, PackedIP *ipPack) {
 ECBClass *ECBList;  // Linked list of ECB's
 ECBClass* ESRList;	// ECBs waiting to be ESR notified
 
+// Listening ECBs per socket number, in the order they were posted, so
+// incoming packets don't have to walk all the ECBs
+static std::unordered_map<uint16_t, std::deque<ECBClass*>> listening_ecbs;
+
+// Packets are received on their own thread, which waits for the socket
+// to become readable; the tick handler only hands over what arrived
+struct ReceivedPacket {
+	int len = 0;
+	std::array<uint8_t, IPXBUFFERSIZE> data = {};
+	int64_t received_us = 0;
+};
+
+static SpscRing<ReceivedPacket> received_packets(64);
+static std::thread receive_thread;
+static std::atomic_bool is_receiving = false;
+
+// Only exists while connected to a server
+static std::unique_ptr<NetworkStats> ipx_stats = {};
+
+// Packet logs of the session. While replaying, the client counts as
+// connected but has no socket: the log stands in for the server.
+static std::unique_ptr<NetworkLogWriter> ipx_capture = {};
+static std::unique_ptr<NetworkLogReader> ipx_replay  = {};
+static NetworkLogRecord replay_record                = {};
+
 #ifdef IPX_DEBUGMSG
 Bitu ECBSerialNumber = 0;
 Bitu ECBAmount = 0;
@@ -93,6 +131,7 @@ Bitu ECBAmount = 0;
 ECBClass::ECBClass(uint16_t segment, uint16_t offset)
         : ECBAddr(RealMake(segment, offset)),
           isInESRList(false),
+          isListening(false),
           prevECB(nullptr),
           nextECB(nullptr),
           iuflag(0),
@@ -172,10 +211,26 @@ uint8_t ECBClass::getInUseFlag(void) {
 }
 
 void ECBClass::setInUseFlag(uint8_t flagval) {
+	if (flagval == USEFLAG_LISTENING && !isListening) {
+		listening_ecbs[mysocket].push_back(this);
+		isListening = true;
+	} else if (flagval != USEFLAG_LISTENING) {
+		stopListening();
+	}
 	iuflag = flagval;
 	real_writeb(RealSegment(ECBAddr), RealOffset(ECBAddr) + 0x8, flagval);
 }
 
+void ECBClass::stopListening()
+{
+	if (!isListening) {
+		return;
+	}
+	auto& ecbs = listening_ecbs[mysocket];
+	ecbs.erase(std::find(ecbs.begin(), ecbs.end(), this));
+	isListening = false;
+}
+
 void ECBClass::setCompletionFlag(uint8_t flagval) {
 	real_writeb(RealSegment(ECBAddr), RealOffset(ECBAddr) + 0x9, flagval);
 }
@@ -250,6 +305,7 @@ ECBClass::~ECBClass() {
 	ECBAmount--;
 	LOG_IPX("ECB: SN%7d destroyed. Remaining ECBs: %3d", SerialNumber,ECBAmount);
 #endif
+	stopListening();
 
 	if(isInESRList) {
 		// in ESR list, always the first element is deleted.
@@ -514,9 +570,31 @@ Bitu IPX_IntHandler(void) {
 	return CBRET_NONE;
 }
 
+bool NetWrapper_InitializeENET(); // from misc_util.cpp
+
+// Set while connected over the ENet transport instead of plain UDP
+static ENetHost* enet_client = nullptr;
+static ENetPeer* enet_server = nullptr;
+
+static bool sendToServer(uint8_t* data, const int len)
+{
+	if (enet_client) {
+		return IPX_EnetSend(enet_server, data, len);
+	}
+	UDPpacket outPacket;
+	outPacket.channel = UDPChannel;
+	outPacket.data    = data;
+	outPacket.len     = len;
+	outPacket.maxlen  = len;
+	// Since we're using a channel, we won't send the IP address again
+	return SDLNet_UDP_Send(ipxClientSocket, UDPChannel, &outPacket) != 0;
+}
+
 static void pingAck(IPaddress retAddr) {
+	if (ipx_replay) {
+		return;
+	}
 	IPXHeader regHeader;
-	UDPpacket regPacket;
 
 	SDLNet_Write16(0xffff, regHeader.checkSum);
 	SDLNet_Write16(sizeof(regHeader), regHeader.length);
@@ -531,21 +609,13 @@ static void pingAck(IPaddress retAddr) {
 	regHeader.transControl = 0;
 	regHeader.pType = 0x0;
 
-	regPacket.data = (Uint8 *)&regHeader;
-	regPacket.len = sizeof(regHeader);
-	regPacket.maxlen = sizeof(regHeader);
-	regPacket.channel = UDPChannel;
-
-	const int result = SDLNet_UDP_Send(ipxClientSocket, regPacket.channel,
-	                                   &regPacket);
-	if (!result) {
+	if (!sendToServer((uint8_t*)&regHeader, sizeof(regHeader))) {
 		LOG_DEBUG("IPX: Failed to acknowledge send: %s", SDLNet_GetError());
 	}
 }
 
 static void pingSend(void) {
 	IPXHeader regHeader;
-	UDPpacket regPacket;
 
 	SDLNet_Write16(0xffff, regHeader.checkSum);
 	SDLNet_Write16(sizeof(regHeader), regHeader.length);
@@ -561,20 +631,11 @@ static void pingSend(void) {
 	regHeader.transControl = 0;
 	regHeader.pType = 0x0;
 
-	regPacket.data = (Uint8 *)&regHeader;
-	regPacket.len = sizeof(regHeader);
-	regPacket.maxlen = sizeof(regHeader);
-	regPacket.channel = UDPChannel;
-
-	const int result = SDLNet_UDP_Send(ipxClientSocket, regPacket.channel,
-	                                   &regPacket);
-	if (!result)
+	if (!sendToServer((uint8_t*)&regHeader, sizeof(regHeader)))
 		LOG_MSG("IPX: Failed to send a ping packet: %s", SDLNet_GetError());
 }
 
 static void receivePacket(uint8_t *buffer, int16_t bufSize) {
-	ECBClass *useECB;
-	ECBClass *nextECB;
 	uint16_t *bufword = (uint16_t *)buffer;
 	uint16_t useSocket = swapByte(bufword[8]);
 	IPXHeader * tmpHeader;
@@ -593,30 +654,175 @@ static void receivePacket(uint8_t *buffer, int16_t bufSize) {
 		}
 	}
 
-	useECB = ECBList;
-	while(useECB != nullptr)
-	{
-		nextECB = useECB->nextECB;
-		if(useECB->iuflag == USEFLAG_LISTENING && useECB->mysocket == useSocket) {
-			useECB->writeDataBuffer(buffer, bufSize);
-			useECB->NotifyESR();
-			return;
-		}
-		useECB = nextECB;
+	const auto it = listening_ecbs.find(useSocket);
+	if (it != listening_ecbs.end() && !it->second.empty()) {
+		ECBClass* useECB = it->second.front();
+		useECB->stopListening();
+		useECB->writeDataBuffer(buffer, bufSize);
+		useECB->NotifyESR();
+		return;
 	}
 	LOG_IPX("IPX: RX Packet loss!");
+	ipx_stats->AddDropped();
 }
 
 static void IPX_ClientLoop(void) {
-	int numrecv;
-	UDPpacket inPacket;
-	inPacket.data = (Uint8 *)recvBuffer;
-	inPacket.maxlen = IPXBUFFERSIZE;
-	inPacket.channel = UDPChannel;
-
 	// Its amazing how much simpler UDP is than TCP
-	numrecv = SDLNet_UDP_Recv(ipxClientSocket, &inPacket);
-	if(numrecv) receivePacket(inPacket.data, inPacket.len);
+	const auto start_us    = GetTicksUs();
+	const auto num_packets = received_packets.GetNumReadable();
+	ipx_stats->SetQueued(num_packets);
+	for (size_t i = 0; i < num_packets; ++i) {
+		auto& packet = received_packets.Peek(i);
+		memcpy(recvBuffer, packet.data.data(), packet.len);
+		ipx_stats->AddLatency(GetTicksUs() - packet.received_us);
+		if (ipx_capture) {
+			ipx_capture->Write(NetworkLogDirection::ToGuest,
+			                   recvBuffer,
+			                   packet.len);
+		}
+		receivePacket(recvBuffer, static_cast<int16_t>(packet.len));
+	}
+	received_packets.Consume(num_packets);
+	ipx_stats->Tick(GetTicksUsSince(start_us));
+}
+
+static void ReceiveLoop()
+{
+	while (is_receiving) {
+		const int num_ready = SDLNet_CheckSockets(clientSocketSet, 100);
+		if (num_ready <= 0) {
+			continue;
+		}
+		// Take in everything that's waiting, as far as there's room
+		auto packet = received_packets.BeginWrite();
+		while (packet) {
+			UDPpacket inPacket;
+			inPacket.data = packet->data.data();
+			inPacket.maxlen = IPXBUFFERSIZE;
+			inPacket.channel = UDPChannel;
+
+			if (SDLNet_UDP_Recv(ipxClientSocket, &inPacket) <= 0) {
+				break;
+			}
+			packet->len         = inPacket.len;
+			packet->received_us = GetTicksUs();
+			received_packets.CommitWrite();
+			ipx_stats->AddReceived(static_cast<uint64_t>(inPacket.len));
+			packet = received_packets.BeginWrite();
+		}
+		if (!packet) {
+			// The emulation is behind; give it a moment to catch up
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+}
+
+static void IPX_ReplayLoop()
+{
+	const auto start_us = GetTicksUs();
+	while (ipx_replay->NextDue(replay_record)) {
+		if (replay_record.direction != NetworkLogDirection::ToGuest ||
+		    replay_record.data.size() > IPXBUFFERSIZE) {
+			continue;
+		}
+		const auto len = replay_record.data.size();
+		memcpy(recvBuffer, replay_record.data.data(), len);
+		ipx_stats->AddReceived(len);
+		receivePacket(recvBuffer, static_cast<int16_t>(len));
+	}
+	ipx_stats->Tick(GetTicksUsSince(start_us));
+}
+
+static bool StartReplay(const std::string& path)
+{
+	ipx_replay = NetworkLogReader::Open(path, NetworkLogSource::Ipx);
+	if (!ipx_replay) {
+		return false;
+	}
+	const auto& node = ipx_replay->GetAddress();
+	memcpy(localIpxAddr.netnode, node.data(), sizeof(localIpxAddr.netnode));
+	LOG_MSG("IPX: Replaying a session, IPX address is %d:%d:%d:%d:%d:%d",
+	        CONVIPX(localIpxAddr.netnode));
+
+	incomingPacket.connected = true;
+	ipx_stats = std::make_unique<NetworkStats>("IPX (replay)");
+	TIMER_AddTickHandler(&IPX_ReplayLoop);
+	return true;
+}
+
+static void StartCapture()
+{
+	const auto section = static_cast<Section_prop*>(control->GetSection("ipx"));
+	const auto path = section ? section->Get_path("capture_file") : nullptr;
+	if (!path || path->realpath.empty()) {
+		return;
+	}
+	NetworkLogAddress node = {};
+	memcpy(node.data(), localIpxAddr.netnode, node.size());
+	ipx_capture = NetworkLogWriter::Create(path->realpath.string(),
+	                                       NetworkLogSource::Ipx,
+	                                       node);
+}
+
+void DisconnectFromServer(bool unexpected);
+
+// Over ENet, the host is serviced on the emulation thread instead
+static void IPX_EnetClientLoop()
+{
+	const auto start_us = GetTicksUs();
+	bool is_lost        = false;
+
+	ENetEvent event;
+	while (enet_host_service(enet_client, &event, 0) > 0) {
+		if (event.type == ENET_EVENT_TYPE_RECEIVE) {
+			const auto len = std::min(event.packet->dataLength,
+			                          sizeof(recvBuffer));
+			memcpy(recvBuffer, event.packet->data, len);
+			enet_packet_destroy(event.packet);
+
+			ipx_stats->AddReceived(len);
+			if (ipx_capture) {
+				ipx_capture->Write(NetworkLogDirection::ToGuest,
+				                   recvBuffer,
+				                   static_cast<int>(len));
+			}
+			receivePacket(recvBuffer, static_cast<int16_t>(len));
+		} else if (event.type == ENET_EVENT_TYPE_DISCONNECT ||
+		           event.type == ENET_EVENT_TYPE_DISCONNECT_TIMEOUT) {
+			is_lost = true;
+			break;
+		}
+	}
+	if (is_lost) {
+		DisconnectFromServer(true);
+		return;
+	}
+	// Everything the guest sent during the tick goes out together
+	enet_host_flush(enet_client);
+	ipx_stats->Tick(GetTicksUsSince(start_us));
+}
+
+static void StartReceiving()
+{
+	if (enet_client) {
+		TIMER_AddTickHandler(&IPX_EnetClientLoop);
+		return;
+	}
+	received_packets.Clear();
+	is_receiving   = true;
+	receive_thread = std::thread(ReceiveLoop);
+	set_thread_name(receive_thread, "dosbox:ipx");
+	TIMER_AddTickHandler(&IPX_ClientLoop);
+}
+
+static void StopReceiving()
+{
+	TIMER_DelTickHandler(&IPX_EnetClientLoop);
+	TIMER_DelTickHandler(&IPX_ClientLoop);
+	is_receiving = false;
+	if (receive_thread.joinable()) {
+		receive_thread.join();
+	}
 }
 
 
@@ -624,7 +830,25 @@ void DisconnectFromServer(bool unexpected) {
 	if(unexpected) LOG_MSG("IPX: Server disconnected unexpectedly");
 	if(incomingPacket.connected) {
 		incomingPacket.connected = false;
-		TIMER_DelTickHandler(&IPX_ClientLoop);
+		ipx_capture.reset();
+		if (ipx_replay) {
+			TIMER_DelTickHandler(&IPX_ReplayLoop);
+			ipx_replay.reset();
+			ipx_stats.reset();
+			return;
+		}
+		StopReceiving();
+		ipx_stats.reset();
+		if (enet_client) {
+			enet_peer_disconnect_now(enet_server, 0);
+			enet_host_destroy(enet_client);
+			enet_client = nullptr;
+			enet_server = nullptr;
+			return;
+		}
+		SDLNet_UDP_DelSocket(clientSocketSet, ipxClientSocket);
+		SDLNet_FreeSocketSet(clientSocketSet);
+		clientSocketSet = nullptr;
 		SDLNet_UDP_Close(ipxClientSocket);
 	}
 }
@@ -635,7 +859,6 @@ static void sendPacket(ECBClass* sendecb) {
 	uint16_t i, fragCount,t;
 	int16_t packetsize;
 	uint16_t *wordptr;
-	UDPpacket outPacket;
 
 	sendecb->setInUseFlag(USEFLAG_AVAILABLE);
 	packetsize = 0;
@@ -709,21 +932,22 @@ static void sendPacket(ECBClass* sendecb) {
 		if(immedAddr[m]!=0xff) islocalbroadcast=false;
 	}
 	LOG_IPX("SEND crc:%2x",packetCRC(&outbuffer[0], packetsize));
-	if(!isloopback) {
-		outPacket.channel = UDPChannel;
-		outPacket.data = (Uint8 *)&outbuffer[0];
-		outPacket.len = packetsize;
-		outPacket.maxlen = packetsize;
-		// Since we're using a channel, we won't send the IP address again
-		const int result = SDLNet_UDP_Send(ipxClientSocket, UDPChannel,
-		                                   &outPacket);
-		if (result == 0) {
+	if (ipx_capture && !isloopback) {
+		ipx_capture->Write(NetworkLogDirection::FromGuest, outbuffer, packetsize);
+	}
+	if (ipx_replay && !isloopback) {
+		// Nobody's listening, the replayed peers already answered
+		ipx_stats->AddSent(static_cast<uint64_t>(packetsize));
+		sendecb->setCompletionFlag(COMP_SUCCESS);
+	} else if(!isloopback) {
+		if (!sendToServer(outbuffer, packetsize)) {
 			LOG_MSG("IPX: Could not send packet: %s", SDLNet_GetError());
 			sendecb->setCompletionFlag(COMP_HARDWAREERROR);
 			sendecb->NotifyESR();
 			DisconnectFromServer(true);
 			return;
 		} else {
+			ipx_stats->AddSent(static_cast<uint64_t>(packetsize));
 			sendecb->setCompletionFlag(COMP_SUCCESS);
 			LOG_IPX("Packet sent: size: %d",packetsize);
 		}
@@ -739,6 +963,24 @@ static void sendPacket(ECBClass* sendecb) {
 }
 
 static bool pingCheck(IPXHeader * outHeader) {
+	if (enet_client) {
+		ENetEvent event;
+		while (enet_host_service(enet_client, &event, 0) > 0) {
+			if (event.type != ENET_EVENT_TYPE_RECEIVE) {
+				continue;
+			}
+			const auto is_complete = event.packet->dataLength >=
+			                         sizeof(IPXHeader);
+			if (is_complete) {
+				memcpy(outHeader, event.packet->data, sizeof(IPXHeader));
+			}
+			enet_packet_destroy(event.packet);
+			if (is_complete) {
+				return true;
+			}
+		}
+		return false;
+	}
 	char buffer[1024];
 	UDPpacket regPacket;
 	IPXHeader *regHeader;
@@ -755,8 +997,125 @@ static bool pingCheck(IPXHeader * outHeader) {
 	return false;
 }
 
+// Echo packet with zeroed dest and src is a server registration packet
+static void makeRegistrationHeader(IPXHeader& regHeader)
+{
+	SDLNet_Write16(0xffff, regHeader.checkSum);
+	SDLNet_Write16(sizeof(regHeader), regHeader.length);
+
+	SDLNet_Write32(0, regHeader.dest.network);
+	regHeader.dest.addr.byIP.host = 0x0;
+	regHeader.dest.addr.byIP.port = 0x0;
+	SDLNet_Write16(0x2, regHeader.dest.socket);
+
+	SDLNet_Write32(0, regHeader.src.network);
+	regHeader.src.addr.byIP.host = 0x0;
+	regHeader.src.addr.byIP.port = 0x0;
+	SDLNet_Write16(0x2, regHeader.src.socket);
+	regHeader.transControl = 0;
+}
+
+static bool useEnetTransport()
+{
+	const auto section = static_cast<Section_prop*>(control->GetSection("ipx"));
+	return section && section->Get_string("transport") == "enet";
+}
+
+static void closeEnetClient()
+{
+	enet_peer_reset(enet_server);
+	enet_host_destroy(enet_client);
+	enet_client = nullptr;
+	enet_server = nullptr;
+}
+
+static bool ConnectToEnetServer(const char* strAddr)
+{
+	if (!NetWrapper_InitializeENET()) {
+		return false;
+	}
+	// Lets the server throttle what it sends us to the given rate; our
+	// own sends are held to it as well
+	const auto section = static_cast<Section_prop*>(control->GetSection("ipx"));
+	const auto bandwidth = static_cast<enet_uint32>(
+	        section->Get_int("enet_bandwidth") * 1024);
+
+	enet_client = enet_host_create(nullptr, 1, IPX_EnetNumChannels, bandwidth, bandwidth);
+	if (!enet_client) {
+		LOG_MSG("IPX: Unable to open socket");
+		return false;
+	}
+	ENetAddress address = {};
+	if (enet_address_set_host(&address, strAddr) != 0) {
+		LOG_MSG("IPX: Unable resolve connection to server");
+		enet_host_destroy(enet_client);
+		enet_client = nullptr;
+		return false;
+	}
+	address.port = static_cast<enet_uint16>(udpPort);
+	enet_server  = enet_host_connect(enet_client, &address, IPX_EnetNumChannels, 0);
+	if (!enet_server) {
+		LOG_MSG("IPX: Unable to connect to server");
+		enet_host_destroy(enet_client);
+		enet_client = nullptr;
+		return false;
+	}
+
+	// Register once connected; the reply holds our IPX address
+	IPXHeader regHeader;
+	makeRegistrationHeader(regHeader);
+
+	const auto ticks = GetTicks();
+	bool is_registered = false;
+	while (!is_registered) {
+		if (GetTicksSince(ticks) > 5000) {
+			LOG_MSG("Timeout connecting to server at %s", strAddr);
+			closeEnetClient();
+			return false;
+		}
+		CALLBACK_Idle();
+
+		ENetEvent event;
+		while (!is_registered && enet_host_service(enet_client, &event, 0) > 0) {
+			if (event.type == ENET_EVENT_TYPE_CONNECT) {
+				IPX_EnetSend(enet_server, (uint8_t*)&regHeader, sizeof(regHeader));
+				enet_host_flush(enet_client);
+			} else if (event.type == ENET_EVENT_TYPE_RECEIVE) {
+				if (event.packet->dataLength >= sizeof(IPXHeader)) {
+					IPXHeader reply;
+					memcpy(&reply, event.packet->data, sizeof(reply));
+					memcpy(localIpxAddr.netnode, reply.dest.addr.byNode.node, sizeof(localIpxAddr.netnode));
+					memcpy(localIpxAddr.netnum, reply.dest.network, sizeof(localIpxAddr.netnum));
+					is_registered = true;
+				}
+				enet_packet_destroy(event.packet);
+			} else if (event.type == ENET_EVENT_TYPE_DISCONNECT ||
+			           event.type == ENET_EVENT_TYPE_DISCONNECT_TIMEOUT) {
+				LOG_MSG("IPX: Unable to connect to server: connection refused");
+				closeEnetClient();
+				return false;
+			}
+		}
+	}
+	// Only for the status, IPv6 servers show up as all zeroes
+	if (SDLNet_ResolveHost(&ipxServConnIp, strAddr, (uint16_t)udpPort) != 0) {
+		ipxServConnIp = {};
+	}
+
+	LOG_MSG("IPX: Connected to server over ENet.  IPX address is %d:%d:%d:%d:%d:%d", CONVIPX(localIpxAddr.netnode));
+
+	incomingPacket.connected = true;
+	ipx_stats = std::make_unique<NetworkStats>("IPX (ENet)");
+	StartCapture();
+	StartReceiving();
+	return true;
+}
+
 bool ConnectToServer(const char* strAddr)
 {
+	if (useEnetTransport()) {
+		return ConnectToEnetServer(strAddr);
+	}
 	int numsent;
 	UDPpacket regPacket;
 	IPXHeader regHeader;
@@ -773,20 +1132,7 @@ bool ConnectToServer(const char* strAddr)
 			// Bind UDP port to address to channel
 			UDPChannel = SDLNet_UDP_Bind(ipxClientSocket,-1,&ipxServConnIp);
 			//ipxClientSocket = SDLNet_TCP_Open(&ipxServConnIp);
-			SDLNet_Write16(0xffff, regHeader.checkSum);
-			SDLNet_Write16(sizeof(regHeader), regHeader.length);
-
-			// Echo packet with zeroed dest and src is a server registration packet
-			SDLNet_Write32(0, regHeader.dest.network);
-			regHeader.dest.addr.byIP.host = 0x0;
-			regHeader.dest.addr.byIP.port = 0x0;
-			SDLNet_Write16(0x2, regHeader.dest.socket);
-
-			SDLNet_Write32(0, regHeader.src.network);
-			regHeader.src.addr.byIP.host = 0x0;
-			regHeader.src.addr.byIP.port = 0x0;
-			SDLNet_Write16(0x2, regHeader.src.socket);
-			regHeader.transControl = 0;
+			makeRegistrationHeader(regHeader);
 
 			regPacket.data = (Uint8 *)&regHeader;
 			regPacket.len = sizeof(regHeader);
@@ -825,8 +1171,20 @@ bool ConnectToServer(const char* strAddr)
 
 				LOG_MSG("IPX: Connected to server.  IPX address is %d:%d:%d:%d:%d:%d", CONVIPX(localIpxAddr.netnode));
 
+				clientSocketSet = SDLNet_AllocSocketSet(1);
+				if (!clientSocketSet ||
+				    SDLNet_UDP_AddSocket(clientSocketSet, ipxClientSocket) == -1) {
+					LOG_MSG("IPX: %s", SDLNet_GetError());
+					SDLNet_FreeSocketSet(clientSocketSet);
+					clientSocketSet = nullptr;
+					SDLNet_UDP_Close(ipxClientSocket);
+					return false;
+				}
+
 				incomingPacket.connected = true;
-				TIMER_AddTickHandler(&IPX_ClientLoop);
+				ipx_stats = std::make_unique<NetworkStats>("IPX");
+				StartCapture();
+				StartReceiving();
 				return true;
 			}
 		} else {
@@ -951,7 +1309,8 @@ public:
 					} else {
 						udpPort = strtol(temp_line.c_str(), nullptr, 10);
 					}
-					startsuccess = IPX_StartServer((uint16_t)udpPort);
+					startsuccess = IPX_StartServer((uint16_t)udpPort,
+					                               useEnetTransport());
 					if(startsuccess) {
 						WriteOut("IPX Tunneling Server started\n");
 						isIpxServer = true;
@@ -1019,7 +1378,9 @@ public:
 				WriteOut("Server status: %s\n",
 				         (isIpxServer ? "ACTIVE" : "INACTIVE"));
 				WriteOut("Client status: ");
-				if(incomingPacket.connected) {
+				if (ipx_replay) {
+					WriteOut("REPLAYING a packet log\n");
+				} else if(incomingPacket.connected) {
 					WriteOut("CONNECTED -- Server at %d.%d.%d.%d port %d\n", CONVIP(ipxServConnIp.host), udpPort);
 				} else {
 					WriteOut("DISCONNECTED\n");
@@ -1030,7 +1391,11 @@ public:
 					IPaddress *ptrAddr;
 					for(i=0;i<SOCKETTABLESIZE;i++) {
 						if(IPX_isConnectedToServer(i,&ptrAddr)) {
+							const auto& stats = IPX_GetServerClientStats(i);
 							WriteOut("     %d.%d.%d.%d from port %d\n", CONVIP(ptrAddr->host), SDLNet_Read16(&ptrAddr->port));
+							WriteOut("       in: %" PRIu64 " packets, %" PRIu64 " bytes; out: %" PRIu64 " packets, %" PRIu64 " bytes\n",
+							         stats.packets_in.load(), stats.bytes_in.load(),
+							         stats.packets_out.load(), stats.bytes_out.load());
 						}
 					}
 					WriteOut("\n");
@@ -1045,7 +1410,11 @@ public:
 					WriteOut("IPX Tunneling Client not connected.\n");
 					return;
 				}
-				TIMER_DelTickHandler(&IPX_ClientLoop);
+				if (ipx_replay) {
+					WriteOut("IPX Tunneling Client is replaying a packet log.\n");
+					return;
+				}
+				StopReceiving();
 				WriteOut("Sending broadcast ping:\n\n");
 				pingSend();
 				const auto ticks = GetTicks();
@@ -1059,7 +1428,7 @@ public:
 						        GetTicksSince(ticks));
 					}
 				}
-				TIMER_AddTickHandler(&IPX_ClientLoop);
+				StartReceiving();
 				return;
 			}
 		}
@@ -1103,6 +1472,7 @@ public:
 	{
 		ECBList = nullptr;
 		ESRList = nullptr;
+		listening_ecbs.clear();
 		isIpxServer = false;
 		isIpxConnected = false;
 
@@ -1115,6 +1485,13 @@ public:
 
 		IPX_NetworkInit();
 
+		const auto replay_path = section ? section->Get_path("replay_file")
+		                                 : nullptr;
+		if (replay_path && !replay_path->realpath.empty() &&
+		    !StartReplay(replay_path->realpath.string())) {
+			LOG_WARNING("IPX: Failed to start replaying the session");
+		}
+
 		DOS_AddMultiplexHandler(IPX_Multiplex);
 
 		callback_ipx.Install(&IPX_Handler,CB_RETF,"IPX Handler");
@@ -21,7 +21,17 @@
 #if C_IPX
 
 #include <atomic>
+#include <cassert>
+#include <cstring>
 #include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
 
 #include "ipx.h"
 #include "ipxserver.h"
@@ -29,11 +39,14 @@
 
 static constexpr int UDP_UNICAST = -1; // SDLNet magic number
 
+bool NetWrapper_InitializeENET(); // from misc_util.cpp
+
 static IPaddress ipxServerIp;     // IPAddress for server's listening port
 static UDPsocket ipxServerSocket; // Listening server socket
 static SDLNet_SocketSet socket_set = nullptr;
 
 static packetBuffer connBuffer[SOCKETTABLESIZE];
+static IPXClientStats client_stats[SOCKETTABLESIZE];
 
 static uint8_t inBuffer[IPXBUFFERSIZE];
 static IPaddress ipconn[SOCKETTABLESIZE]; // Active TCP/IP connection
@@ -41,6 +54,31 @@ static IPaddress ipconn[SOCKETTABLESIZE]; // Active TCP/IP connection
 static std::thread ipx_server_thread;
 static std::atomic_bool ipx_server_running = false;
 
+// With the ENet transport, the clients are the host's peers. They're told
+// apart by the IPv4 address and port they connect from, like over UDP.
+struct EnetClient {
+	IPaddress address = {};
+	ENetPeer* peer    = nullptr;
+};
+static ENetHost* enet_host = nullptr;
+static std::vector<EnetClient> enet_clients;
+
+#if defined(__linux__)
+// On Linux the server uses its own socket, so it can receive and send
+// whole batches of datagrams with one system call each. IPaddress holds
+// the host and port in network order, just like sockaddr_in.
+static int native_socket = -1;
+static int epoll_fd      = -1;
+
+constexpr int ReceiveBatchSize = 32;
+constexpr int SendBatchSize    = 64;
+
+static mmsghdr send_msgs[SendBatchSize]      = {};
+static iovec send_iovs[SendBatchSize]        = {};
+static sockaddr_in send_addrs[SendBatchSize] = {};
+static int num_sends_queued                  = 0;
+#endif
+
 uint8_t packetCRC(uint8_t* buffer, uint16_t bufSize)
 {
 	uint8_t tmpCRC = 0;
@@ -66,14 +104,116 @@ static void closeSocket(uint16_t sockidx) {
 }
 */
 
+bool IPX_EnetSend(ENetPeer* peer, const uint8_t* data, const int len)
+{
+	// Echo packets (socket 2) are registrations and pings
+	const bool is_control = len >= 18 && data[16] == 0 && data[17] == 2;
+
+	const auto packet = enet_packet_create(data,
+	                                       static_cast<size_t>(len),
+	                                       is_control ? ENET_PACKET_FLAG_RELIABLE
+	                                                  : 0);
+	if (!packet) {
+		return false;
+	}
+	const auto channel = is_control ? IPX_EnetControlChannel
+	                                : IPX_EnetDataChannel;
+	if (enet_peer_send(peer, channel, packet) < 0) {
+		enet_packet_destroy(packet);
+		return false;
+	}
+	return true;
+}
+
+// The IPv4 address of an ENet peer in the IPaddress layout; IPv6 peers get
+// the low 32 bits of their address
+static IPaddress toIPaddress(const ENetAddress& address)
+{
+	IPaddress result = {};
+	memcpy(&result.host, &address.host.s6_addr[12], sizeof(result.host));
+	SDLNet_Write16(address.port, &result.port);
+	return result;
+}
+
+// Hands the queued datagrams to the host
+static void flushSends()
+{
+	if (enet_host) {
+		enet_host_flush(enet_host);
+		return;
+	}
+#if defined(__linux__)
+	int num_sent = 0;
+	while (num_sent < num_sends_queued) {
+		const auto result = sendmmsg(native_socket,
+		                             send_msgs + num_sent,
+		                             static_cast<unsigned int>(
+		                                     num_sends_queued - num_sent),
+		                             0);
+		if (result <= 0) {
+			// Drop the one that failed, like SDLNet_UDP_Send does
+			LOG_MSG("IPXSERVER: Failed sending a packet");
+			++num_sent;
+			continue;
+		}
+		num_sent += result;
+	}
+	num_sends_queued = 0;
+#endif
+}
+
+// Sends the datagram to the client; with the native socket it's queued
+// until flushSends(), so the data has to stay put until then
+static void sendToClient(const IPaddress& address, uint8_t* data, const int len)
+{
+	if (enet_host) {
+		for (const auto& client : enet_clients) {
+			if (client.address.host == address.host &&
+			    client.address.port == address.port) {
+				IPX_EnetSend(client.peer, data, len);
+				return;
+			}
+		}
+		return;
+	}
+#if defined(__linux__)
+	if (native_socket != -1) {
+		if (num_sends_queued == SendBatchSize) {
+			flushSends();
+		}
+		const auto n = num_sends_queued++;
+
+		send_addrs[n]            = {};
+		send_addrs[n].sin_family = AF_INET;
+		send_addrs[n].sin_addr.s_addr = address.host;
+		send_addrs[n].sin_port        = address.port;
+
+		send_iovs[n] = {data, static_cast<size_t>(len)};
+
+		send_msgs[n]                    = {};
+		send_msgs[n].msg_hdr.msg_name    = &send_addrs[n];
+		send_msgs[n].msg_hdr.msg_namelen = sizeof(send_addrs[n]);
+		send_msgs[n].msg_hdr.msg_iov     = &send_iovs[n];
+		send_msgs[n].msg_hdr.msg_iovlen  = 1;
+		return;
+	}
+#endif
+	UDPpacket outPacket;
+	outPacket.channel = -1;
+	outPacket.data    = data;
+	outPacket.len     = len;
+	outPacket.maxlen  = len;
+	outPacket.address = address;
+
+	const int result = SDLNet_UDP_Send(ipxServerSocket, UDP_UNICAST, &outPacket);
+	if (result == 0) {
+		LOG_MSG("IPXSERVER: %s", SDLNet_GetError());
+	}
+}
+
 static void sendIPXPacket(uint8_t *buffer, int16_t bufSize) {
 	uint16_t srcport, destport;
 	uint32_t srchost, desthost;
-	UDPpacket outPacket;
-	outPacket.channel = -1;
-	outPacket.data = buffer;
-	outPacket.len = bufSize;
-	outPacket.maxlen = bufSize;
 	IPXHeader *tmpHeader;
 	tmpHeader = (IPXHeader *)buffer;
 
@@ -83,18 +223,14 @@ static void sendIPXPacket(uint8_t *buffer, int16_t bufSize) {
 	srcport = tmpHeader->src.addr.byIP.port;
 	destport = tmpHeader->dest.addr.byIP.port;
 
+	const auto bytes = static_cast<uint64_t>(bufSize);
 	if(desthost == 0xffffffff) {
 		// Broadcast
 		for (uint16_t i = 0; i < SOCKETTABLESIZE; ++i) {
 			if(connBuffer[i].connected && ((ipconn[i].host != srchost)||(ipconn[i].port!=srcport))) {
-				outPacket.address = ipconn[i];
-				const int result = SDLNet_UDP_Send(ipxServerSocket,
-				                                   UDP_UNICAST,
-				                                   &outPacket);
-				if (result == 0) {
-					LOG_MSG("IPXSERVER: %s", SDLNet_GetError());
-					continue;
-				}
+				sendToClient(ipconn[i], buffer, bufSize);
+				++client_stats[i].packets_out;
+				client_stats[i].bytes_out += bytes;
 				//LOG_MSG("IPXSERVER: Packet of %d bytes sent from %d.%d.%d.%d to %d.%d.%d.%d (BROADCAST) (%x CRC)", bufSize, CONVIP(srchost), CONVIP(ipconn[i].host), packetCRC(&buffer[30], bufSize-30));
 			}
 		}
@@ -102,14 +238,9 @@ static void sendIPXPacket(uint8_t *buffer, int16_t bufSize) {
 		// Specific address
 		for (uint16_t i = 0; i < SOCKETTABLESIZE; ++i) {
 			if((connBuffer[i].connected) && (ipconn[i].host == desthost) && (ipconn[i].port == destport)) {
-				outPacket.address = ipconn[i];
-				const int result = SDLNet_UDP_Send(ipxServerSocket,
-				                                   UDP_UNICAST,
-				                                   &outPacket);
-				if (result == 0) {
-					LOG_MSG("IPXSERVER: %s", SDLNet_GetError());
-					continue;
-				}
+				sendToClient(ipconn[i], buffer, bufSize);
+				++client_stats[i].packets_out;
+				client_stats[i].bytes_out += bytes;
 				//LOG_MSG("IPXSERVER: Packet sent from %d.%d.%d.%d to %d.%d.%d.%d", CONVIP(srchost), CONVIP(desthost));
 			}
 		}
@@ -122,9 +253,14 @@ bool IPX_isConnectedToServer(Bits tableNum, IPaddress ** ptrAddr) {
 	return connBuffer[tableNum].connected;
 }
 
+const IPXClientStats& IPX_GetServerClientStats(const Bits tableNum)
+{
+	assert(tableNum >= 0 && tableNum < SOCKETTABLESIZE);
+	return client_stats[tableNum];
+}
+
 static void ackClient(IPaddress clientAddr) {
 	IPXHeader regHeader = {};
-	UDPpacket regPacket;
 
 	SDLNet_Write16(0xffff, regHeader.checkSum);
 	SDLNet_Write16(sizeof(regHeader), regHeader.length);
@@ -138,72 +274,228 @@ static void ackClient(IPaddress clientAddr) {
 	SDLNet_Write16(0x2, regHeader.src.socket);
 	regHeader.transControl = 0;
 
-	regPacket.data = (Uint8 *)&regHeader;
-	regPacket.len = sizeof(regHeader);
-	regPacket.maxlen = sizeof(regHeader);
-	regPacket.address = clientAddr;
 	// Send registration string to client.  If client doesn't get this, client will not be registered
-	const int result = SDLNet_UDP_Send(ipxServerSocket, UDP_UNICAST, &regPacket);
-	if (result == 0)
-		LOG_MSG("IPXSERVER: Connection response not sent: %s",
-		        SDLNet_GetError());
+	sendToClient(clientAddr, (uint8_t*)&regHeader, sizeof(regHeader));
+	flushSends();
 }
 
-static void IPX_ServerLoop() {
-	UDPpacket inPacket;
+static void handlePacket(const IPaddress& fromAddr, uint8_t* data, const int len)
+{
 	IPaddress tmpAddr;
 
 	//char regString[] = "IPX Register\0";
 
 	uint32_t host;
 
+	if (len < static_cast<int>(sizeof(IPXHeader))) {
+		return;
+	}
+
+	for (uint16_t i = 0; i < SOCKETTABLESIZE; ++i) {
+		if (connBuffer[i].connected && ipconn[i].host == fromAddr.host &&
+		    ipconn[i].port == fromAddr.port) {
+			++client_stats[i].packets_in;
+			client_stats[i].bytes_in += static_cast<uint64_t>(len);
+			break;
+		}
+	}
+
+	// Check to see if incoming packet is a registration packet
+	// For this, I just spoofed the echo protocol packet designation 0x02
+	IPXHeader *tmpHeader;
+	tmpHeader = (IPXHeader *)data;
+
+	// Check to see if echo packet
+	if(SDLNet_Read16(tmpHeader->dest.socket) == 0x2) {
+		// Null destination node means its a server registration packet
+		if(tmpHeader->dest.addr.byIP.host == 0x0) {
+			UnpackIP(tmpHeader->src.addr.byIP, &tmpAddr);
+			for (uint16_t i = 0; i < SOCKETTABLESIZE; ++i) {
+				if(!connBuffer[i].connected) {
+					// Use prefered host IP rather than the reported source IP
+					// It may be better to use the reported source
+					ipconn[i] = fromAddr;
+
+					connBuffer[i].connected = true;
+					client_stats[i].Reset();
+					host = ipconn[i].host;
+					LOG_MSG("IPXSERVER: Connect from %d.%d.%d.%d", CONVIP(host));
+					ackClient(fromAddr);
+					return;
+				} else {
+					if((ipconn[i].host == tmpAddr.host) && (ipconn[i].port == tmpAddr.port)) {
+
+						LOG_MSG("IPXSERVER: Reconnect from %d.%d.%d.%d", CONVIP(tmpAddr.host));
+						// Update anonymous port number if changed
+						ipconn[i].port = fromAddr.port;
+						ackClient(fromAddr);
+						return;
+					}
+				}
+			}
+		}
+	}
+
+	// IPX packet is complete.  Now interpret IPX header and send to respective IP address
+	sendIPXPacket(data, static_cast<int16_t>(len));
+}
+
+static void IPX_ServerLoop() {
+	UDPpacket inPacket;
 	inPacket.channel = -1;
 	inPacket.data = &inBuffer[0];
 	inPacket.maxlen = IPXBUFFERSIZE;
 
 	const int result = SDLNet_UDP_Recv(ipxServerSocket, &inPacket);
 	if (result != 0) {
-		// Check to see if incoming packet is a registration packet
-		// For this, I just spoofed the echo protocol packet designation 0x02
-		IPXHeader *tmpHeader;
-		tmpHeader = (IPXHeader *)&inBuffer[0];
-
-		// Check to see if echo packet
-		if(SDLNet_Read16(tmpHeader->dest.socket) == 0x2) {
-			// Null destination node means its a server registration packet
-			if(tmpHeader->dest.addr.byIP.host == 0x0) {
-				UnpackIP(tmpHeader->src.addr.byIP, &tmpAddr);
-				for (uint16_t i = 0; i < SOCKETTABLESIZE; ++i) {
-					if(!connBuffer[i].connected) {
-						// Use prefered host IP rather than the reported source IP
-						// It may be better to use the reported source
-						ipconn[i] = inPacket.address;
-
-						connBuffer[i].connected = true;
-						host = ipconn[i].host;
-						LOG_MSG("IPXSERVER: Connect from %d.%d.%d.%d", CONVIP(host));
-						ackClient(inPacket.address);
-						return;
-					} else {
-						if((ipconn[i].host == tmpAddr.host) && (ipconn[i].port == tmpAddr.port)) {
-
-							LOG_MSG("IPXSERVER: Reconnect from %d.%d.%d.%d", CONVIP(tmpAddr.host));
-							// Update anonymous port number if changed
-							ipconn[i].port = inPacket.address.port;
-							ackClient(inPacket.address);
-							return;
-						}
-					}
-				}
+		handlePacket(inPacket.address, inPacket.data, inPacket.len);
+	}
+}
+
+#if defined(__linux__)
+static bool openNativeSocket(const uint16_t portnum)
+{
+	native_socket = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (native_socket == -1) {
+		return false;
+	}
+	sockaddr_in addr     = {};
+	addr.sin_family      = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port        = htons(portnum);
+
+	epoll_event event = {};
+	event.events      = EPOLLIN;
+	if (bind(native_socket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1 ||
+	    (epoll_fd = epoll_create1(EPOLL_CLOEXEC)) == -1 ||
+	    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, native_socket, &event) == -1) {
+		close(native_socket);
+		native_socket = -1;
+		if (epoll_fd != -1) {
+			close(epoll_fd);
+			epoll_fd = -1;
+		}
+		return false;
+	}
+	return true;
+}
+
+static void closeNativeSocket()
+{
+	close(epoll_fd);
+	close(native_socket);
+	epoll_fd      = -1;
+	native_socket = -1;
+}
+
+// Takes in up to a batch of datagrams per call, and sends everything they
+// result in before the buffers get reused
+static void nativeServerLoop()
+{
+	static uint8_t buffers[ReceiveBatchSize][IPXBUFFERSIZE];
+	mmsghdr msgs[ReceiveBatchSize]      = {};
+	iovec iovs[ReceiveBatchSize]        = {};
+	sockaddr_in addrs[ReceiveBatchSize] = {};
+
+	while (ipx_server_running) {
+		epoll_event event = {};
+		if (epoll_wait(epoll_fd, &event, 1, 100) <= 0) {
+			continue;
+		}
+		int num_received = ReceiveBatchSize;
+		while (num_received == ReceiveBatchSize) {
+			for (int i = 0; i < ReceiveBatchSize; ++i) {
+				iovs[i]                   = {buffers[i], IPXBUFFERSIZE};
+				msgs[i]                   = {};
+				msgs[i].msg_hdr.msg_name    = &addrs[i];
+				msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+				msgs[i].msg_hdr.msg_iov     = &iovs[i];
+				msgs[i].msg_hdr.msg_iovlen  = 1;
 			}
+			num_received = recvmmsg(native_socket, msgs, ReceiveBatchSize,
+			                        MSG_DONTWAIT, nullptr);
+			for (int i = 0; i < num_received; ++i) {
+				IPaddress from_addr = {};
+				from_addr.host = addrs[i].sin_addr.s_addr;
+				from_addr.port = addrs[i].sin_port;
+				handlePacket(from_addr, buffers[i],
+				             static_cast<int>(msgs[i].msg_len));
+			}
+			flushSends();
 		}
+	}
+}
+#endif
 
-		// IPX packet is complete.  Now interpret IPX header and send to respective IP address
-		sendIPXPacket((uint8_t*)inPacket.data,
-		              static_cast<int16_t>(inPacket.len));
+static void handleEnetEvent(const ENetEvent& event)
+{
+	const auto address = toIPaddress(event.peer->address);
+	switch (event.type) {
+	case ENET_EVENT_TYPE_CONNECT:
+		// Becomes a client once it registers
+		enet_clients.push_back({address, event.peer});
+		break;
+
+	case ENET_EVENT_TYPE_RECEIVE:
+		handlePacket(address,
+		             event.packet->data,
+		             static_cast<int>(event.packet->dataLength));
+		enet_packet_destroy(event.packet);
+		break;
+
+	case ENET_EVENT_TYPE_DISCONNECT:
+	case ENET_EVENT_TYPE_DISCONNECT_TIMEOUT:
+		for (uint16_t i = 0; i < SOCKETTABLESIZE; ++i) {
+			if (connBuffer[i].connected && ipconn[i].host == address.host &&
+			    ipconn[i].port == address.port) {
+				LOG_MSG("IPXSERVER: %d.%d.%d.%d disconnected",
+				        CONVIP(address.host));
+				connBuffer[i].connected = false;
+			}
+		}
+		std::erase_if(enet_clients, [&](const EnetClient& client) {
+			return client.peer == event.peer;
+		});
+		break;
+
+	default: break;
 	}
 }
 
+// ENet gathers everything queued for a peer into as few datagrams as fit,
+// so the sends resulting from a batch of events go out together
+static void enetServerLoop()
+{
+	while (ipx_server_running) {
+		ENetEvent event;
+		auto result = enet_host_service(enet_host, &event, 100);
+		while (result > 0) {
+			handleEnetEvent(event);
+			result = enet_host_check_events(enet_host, &event);
+		}
+		flushSends();
+	}
+}
+
+static bool openEnetHost(const uint16_t portnum)
+{
+	if (!NetWrapper_InitializeENET()) {
+		return false;
+	}
+	ENetAddress address = {};
+	address.host        = ENET_HOST_ANY;
+	address.port        = portnum;
+
+	// The clients tell how much they can take in, and the host throttles
+	// its sends to each of them accordingly
+	enet_host = enet_host_create(&address, SOCKETTABLESIZE, IPX_EnetNumChannels, 0, 0);
+	if (!enet_host) {
+		LOG_MSG("IPXSERVER: Failed to create the ENet host on port %u", portnum);
+		return false;
+	}
+	return true;
+}
+
 void IPX_StopServer() {
 	ipx_server_running = false;
 
@@ -211,22 +503,54 @@ void IPX_StopServer() {
 		ipx_server_thread.join();
 	}
 
+	if (enet_host) {
+		for (const auto& client : enet_clients) {
+			enet_peer_disconnect_now(client.peer, 0);
+		}
+		enet_clients.clear();
+		enet_host_destroy(enet_host);
+		enet_host = nullptr;
+		return;
+	}
+
+#if defined(__linux__)
+	if (native_socket != -1) {
+		closeNativeSocket();
+		return;
+	}
+#endif
 	SDLNet_FreeSocketSet(socket_set);
 	SDLNet_UDP_Close(ipxServerSocket);
 	socket_set = nullptr;
 }
 
-bool IPX_StartServer(uint16_t portnum)
+bool IPX_StartServer(const uint16_t portnum, const bool use_enet)
 {
 	if (!SDLNet_ResolveHost(&ipxServerIp, nullptr, portnum)) {
-		//serverSocketSet = SDLNet_AllocSocketSet(SOCKETTABLESIZE);
-		ipxServerSocket = SDLNet_UDP_Open(portnum);
-		if(!ipxServerSocket) return false;
-
 		for (auto& i : connBuffer) {
 			i.connected = false;
 		}
 
+		if (use_enet) {
+			if (ipx_server_running || !openEnetHost(portnum)) {
+				return false;
+			}
+			ipx_server_running = true;
+			ipx_server_thread  = std::thread(enetServerLoop);
+			return true;
+		}
+
+#if defined(__linux__)
+		if (!ipx_server_running && openNativeSocket(portnum)) {
+			ipx_server_running = true;
+			ipx_server_thread  = std::thread(nativeServerLoop);
+			return true;
+		}
+#endif
+		//serverSocketSet = SDLNet_AllocSocketSet(SOCKETTABLESIZE);
+		ipxServerSocket = SDLNet_UDP_Open(portnum);
+		if(!ipxServerSocket) return false;
+
 		if (!socket_set) {
 			socket_set = SDLNet_AllocSocketSet(1);
 			if (!socket_set) {
@@ -18,6 +18,7 @@
 
 #include "joystick.h"
 
+#include <algorithm>
 #include <cfloat>
 #include <cmath>
 #include <cstring>
@@ -61,8 +62,9 @@ struct JoyStick {
 	double xpos = 0.0;
 	double ypos = 0.0; // position as set by SDL
 
-	double xtick = 0.0;
-	double ytick = 0.0;
+	// when the axes time out, see to_tick_time()
+	uint64_t xtick = 0;
+	uint64_t ytick = 0;
 
 	double xfinal = 0.0;
 	double yfinal = 0.0; // position returned to the game for stick 0
@@ -218,10 +220,31 @@ static uint8_t read_p201(io_port_t, io_width_t)
 	return ret;
 }
 
+// The timed axes are polled in tight loops, so their deadlines are kept as
+// the millisecond tick and the cycle within it, packed into one integer
+// that orders like the time it stands for.
+static uint64_t to_tick_time(const uint32_t tick, const int32_t cycle)
+{
+	return (static_cast<uint64_t>(tick) << 32) |
+	       static_cast<uint32_t>(std::max(cycle, 0));
+}
+
+static uint64_t current_tick_time()
+{
+	return to_tick_time(PIC_Ticks, PIC_TickIndexND());
+}
+
+// From a point in time in milliseconds, as PIC_FullIndex() returns it
+static uint64_t to_tick_time(const double ms)
+{
+	const auto tick = static_cast<uint32_t>(ms);
+	return to_tick_time(tick, PIC_MakeCycles(ms - tick));
+}
+
 static uint8_t read_p201_timed(io_port_t, io_width_t)
 {
 	uint8_t ret = 0xff;
-	const auto currentTick = PIC_FullIndex();
+	const auto currentTick = current_tick_time();
 	if( stick[0].enabled ){
 		if( stick[0].xtick < currentTick ) ret &=~1;
 		if( stick[0].ytick < currentTick ) ret &=~2;
@@ -292,7 +315,8 @@ static void write_p201_timed(io_port_t, io_val_t, io_width_t)
 	// Newer calculation, derived from joycheck measurements
 	auto position_to_ticks = [&](const auto position,
 	                             const AxisRateConstants &axis_rate) {
-		return now + (position + 1.0) * axis_rate.scalar + axis_rate.offset;
+		return to_tick_time(now + (position + 1.0) * axis_rate.scalar +
+		                    axis_rate.offset);
 	};
 
 	if (stick[0].enabled) {
@@ -575,7 +599,7 @@ public:
 		configure_calibration(*section);
 
 		// Set initial time and position states
-		const auto ticks = PIC_FullIndex();
+		const auto ticks = current_tick_time();
 		stick[0].xtick = ticks;
 		stick[0].ytick = ticks;
 		stick[1].xtick = ticks;
@@ -23,6 +23,11 @@
 
 #include "dosbox.h"
 
+#include <algorithm>
+#include <cmath>
+
+#include "checks.h"
+#include "math_utils.h"
 #include "pic.h"
 #include "setup.h"
 #include "support.h"
@@ -30,6 +35,7 @@
 #include "covox.h"
 #include "disney.h"
 #include "ston1_dac.h"
+#include "tracy.h"
 
 LptDac::LptDac(const std::string_view name, const uint16_t channel_rate_hz,
                std::set<ChannelFeature> extra_features)
@@ -79,6 +85,65 @@ void LptDac::BindHandlers(const io_port_t lpt_port, const io_write_f write_data,
 	control_write_handler.Install(control_port, write_control, io_width_t::byte);
 }
 
+void LptDac::QueueLevel(const AudioFrame level)
+{
+	const auto now = PIC_FullIndex();
+
+	// Wake up the channel and update the last rendered time datum. Nothing
+	// was rendered while asleep, so the new level applies from now on.
+	assert(channel);
+	if (channel->WakeUp()) {
+		level_changes.clear();
+		current_level    = level;
+		last_rendered_ms = now;
+		return;
+	}
+	level_changes.push_back({now, level});
+}
+
+void LptDac::RenderFrames(const int num_frames)
+{
+	if (num_frames <= 0) {
+		return;
+	}
+	// The block spans from the last callback up to now
+	const auto start_ms = last_rendered_ms;
+	const auto ms_per_block_frame = std::max(PIC_FullIndex() - start_ms, 0.0) /
+	                                num_frames;
+
+	auto change = level_changes.cbegin();
+	auto frame  = 0;
+	while (frame < num_frames) {
+		const auto frame_ms = start_ms + frame * ms_per_block_frame;
+
+		// Apply the changes made up to this frame
+		while (change != level_changes.cend() &&
+		       change->timestamp_ms <= frame_ms) {
+			current_level = change->level;
+			++change;
+		}
+
+		// Hold the level until the frame of the next change
+		auto num_held = num_frames - frame;
+		if (change != level_changes.cend() && ms_per_block_frame > 0.0) {
+			const auto frames_to_change = iround(ceil(
+			        (change->timestamp_ms - frame_ms) / ms_per_block_frame));
+			num_held = std::clamp(frames_to_change, 1, num_held);
+		}
+		render_buffer.insert(render_buffer.end(),
+		                     check_cast<size_t>(num_held),
+		                     current_level);
+		frame += num_held;
+	}
+
+	// Any changes landing in the block's last frame take effect from the
+	// next block
+	if (!level_changes.empty()) {
+		current_level = level_changes.back().level;
+		level_changes.clear();
+	}
+}
+
 void LptDac::RenderUpToNow()
 {
 	const auto now = PIC_FullIndex();
@@ -89,32 +154,33 @@ void LptDac::RenderUpToNow()
 		last_rendered_ms = now;
 		return;
 	}
-	// Keep rendering until we're current
+	// Render the frames we're behind in one go
 	assert(ms_per_frame > 0.0);
-	while (last_rendered_ms < now) {
-		last_rendered_ms += ms_per_frame;
-		render_queue.emplace(Render());
+	if (last_rendered_ms < now) {
+		const auto num_frames = iround(
+		        ceil((now - last_rendered_ms) / ms_per_frame));
+
+		last_rendered_ms += num_frames * ms_per_frame;
+		RenderFrames(num_frames);
 	}
 }
 
 void LptDac::AudioCallback(const uint16_t requested_frames)
 {
+	ZoneScoped;
 	assert(channel);
 
-	auto frames_remaining = requested_frames;
+	// Render whatever the frames queued since the last callback don't cover
+	const auto num_queued = static_cast<int>(render_buffer.size());
+	RenderFrames(requested_frames - num_queued);
+
+	assert(render_buffer.size() >= requested_frames);
+	channel->AddSamples_sfloat(requested_frames, &render_buffer[0][0]);
+
+	// Keep any frames rendered ahead for the next callback
+	render_buffer.erase(render_buffer.begin(),
+	                    render_buffer.begin() + requested_frames);
 
-	// First, add any frames we've queued since the last callback
-	while (frames_remaining && render_queue.size()) {
-		channel->AddSamples_sfloat(1, &render_queue.front()[0]);
-		render_queue.pop();
-		--frames_remaining;
-	}
-	// If the queue's run dry, render the remainder and sync-up our time datum
-	while (frames_remaining) {
-		const auto frame = Render();
-		channel->AddSamples_sfloat(1, &frame[0]);
-		--frames_remaining;
-	}
 	last_rendered_ms = PIC_FullIndex();
 }
 
@@ -135,7 +201,8 @@ LptDac::~LptDac()
 	assert(channel);
 	MIXER_DeregisterChannel(channel);
 
-	render_queue = {};
+	render_buffer.clear();
+	level_changes.clear();
 }
 
 std::unique_ptr<LptDac> lpt_dac = {};
@@ -23,9 +23,9 @@
 
 #include "dosbox.h"
 
-#include <queue>
 #include <set>
 #include <string_view>
+#include <vector>
 
 #include "inout.h"
 #include "lpt.h"
@@ -55,10 +55,33 @@ public:
 
 protected:
 	// Base LPT DAC functionality
-	virtual AudioFrame Render() = 0;
-	void RenderUpToNow();
 	void AudioCallback(const uint16_t requested_frames);
-	std::queue<AudioFrame> render_queue = {};
+
+	// Most DACs simply hold the level last written to them until the next
+	// write, so their port handlers only record the new level with its
+	// emulated time, and the whole block is rendered from these changes
+	// when the mixer asks for it.
+	void QueueLevel(const AudioFrame level);
+
+	// Appends the given number of frames to the render buffer. By default,
+	// the pending level changes are spread across the frames at their
+	// relative times within the block.
+	virtual void RenderFrames(const int num_frames);
+
+	// For DACs that can't be rendered from their level changes alone, such
+	// as when their port reads depend on the rendered state, this renders
+	// frames ahead of the callback up to the current emulated time.
+	void RenderUpToNow();
+
+	std::vector<AudioFrame> render_buffer = {};
+
+	struct LevelChange {
+		double timestamp_ms = 0.0;
+		AudioFrame level    = {};
+	};
+	std::vector<LevelChange> level_changes = {};
+
+	AudioFrame current_level = {};
 
 	mixer_channel_t channel = {};
 
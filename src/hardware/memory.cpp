@@ -19,12 +19,23 @@
 
 #include "mem.h"
 
+#include <algorithm>
 #include <cstring>
+#include <map>
+#include <set>
 
+#if defined(HAVE_MMAP)
+#include <cerrno>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "host_memory.h"
 #include "inout.h"
 #include "paging.h"
 #include "pci_bus.h"
 #include "regs.h"
+#include "savestate.h"
 #include "setup.h"
 #include "support.h"
 
@@ -37,13 +48,227 @@ constexpr auto SafeMegabytesDos   = 31;
 constexpr auto SafeMegabytesWin95 = 480;
 constexpr auto SafeMegabytesWin98 = 512;
 
+struct GuestPage {
+	uint8_t bytes[dos_pagesize] = {};
+};
+
+// Host storage for the guest RAM pages, either a regular heap block or (with
+// the 'huge' memory_pages setting) an anonymous mapping backed by huge pages.
+// Large guest RAM sizes otherwise spread the hot memory access paths over
+// many host TLB entries.
+class GuestRam {
+public:
+	GuestRam() = default;
+	GuestRam(const GuestRam&)            = delete;
+	GuestRam& operator=(const GuestRam&) = delete;
+	~GuestRam()
+	{
+		Free();
+	}
+
+	void Allocate(const size_t num_pages, const bool use_huge_pages)
+	{
+		Free();
+		if (use_huge_pages && MapHugePages(num_pages)) {
+			return;
+		}
+		heap_pages.resize(num_pages);
+		pages      = heap_pages.data();
+		num_pages_ = num_pages;
+	}
+
+	size_t size() const
+	{
+		return num_pages_;
+	}
+
+	GuestPage& operator[](const size_t index)
+	{
+		assert(index < num_pages_);
+		return pages[index];
+	}
+
+private:
+	bool MapHugePages([[maybe_unused]] const size_t num_pages)
+	{
+#if defined(HAVE_MMAP)
+		// Huge pages are 2 MB on the common hosts, so round up to that
+		constexpr size_t huge_page_size = 2 * 1024 * 1024;
+		const auto bytes = num_pages * sizeof(GuestPage);
+		const auto length = (bytes + huge_page_size - 1) & ~(huge_page_size - 1);
+
+		// Prefault the whole range now, otherwise first-touch faults
+		// land in the middle of running a game
+		int prefault_flag = 0;
+#	if defined(MAP_POPULATE)
+		prefault_flag = MAP_POPULATE;
+#	endif
+		const auto prot_flags = PROT_READ | PROT_WRITE;
+		const auto map_flags  = MAP_PRIVATE | MAP_ANON | prefault_flag;
+
+		const char* page_type = nullptr;
+		void* mem = MAP_FAILED;
+#	if defined(MAP_HUGETLB)
+		// Explicit huge pages, needs pages reserved by the host admin
+		mem = mmap(nullptr, length, prot_flags, map_flags | MAP_HUGETLB, -1, 0);
+		page_type = "explicit huge pages";
+#	endif
+		if (mem == MAP_FAILED) {
+			mem = mmap(nullptr, length, prot_flags, map_flags, -1, 0);
+			if (mem == MAP_FAILED) {
+				LOG_WARNING("MEMORY: Failed to map guest memory (%s), using regular pages",
+				            strerror(errno));
+				return false;
+			}
+			page_type = "regular pages";
+#	if defined(MADV_HUGEPAGE)
+			// Transparent huge pages, up to the host kernel
+			if (madvise(mem, length, MADV_HUGEPAGE) == 0) {
+				page_type = "transparent huge pages";
+			}
+#	endif
+			if (!prefault_flag) {
+				const auto host_pagesize = static_cast<size_t>(
+				        sysconf(_SC_PAGESIZE));
+				for (size_t i = 0; i < length; i += host_pagesize) {
+					static_cast<volatile uint8_t*>(mem)[i] = 0;
+				}
+			}
+		}
+		LOG_MSG("MEMORY: Backing guest memory with %s", page_type);
+
+		pages      = static_cast<GuestPage*>(mem);
+		num_pages_ = num_pages;
+		map_length = length;
+		return true;
+#else
+		LOG_WARNING("MEMORY: Huge pages aren't supported on this platform, using regular pages");
+		return false;
+#endif
+	}
+
+	void Free()
+	{
+#if defined(HAVE_MMAP)
+		if (map_length) {
+			munmap(pages, map_length);
+			map_length = 0;
+		}
+#endif
+		heap_pages.clear();
+		heap_pages.shrink_to_fit();
+		pages      = nullptr;
+		num_pages_ = 0;
+	}
+
+	std::vector<GuestPage> heap_pages = {};
+	GuestPage* pages                  = nullptr;
+	size_t num_pages_                 = 0;
+	size_t map_length                 = 0;
+};
+
+// The runs of free extended memory pages, kept both by their start page and
+// by their size, so allocations find the best fit without scanning the
+// handle table
+class FreePages {
+public:
+	void Reset(const Bitu first_page, const Bitu end_page)
+	{
+		by_start.clear();
+		by_size.clear();
+		total = 0;
+		if (end_page > first_page) {
+			Insert(first_page, end_page - first_page);
+		}
+	}
+
+	Bitu GetTotal() const
+	{
+		return total;
+	}
+
+	Bitu GetLargest() const
+	{
+		return by_size.empty() ? 0 : by_size.rbegin()->first;
+	}
+
+	// Start of the smallest run that holds the pages, the lowest one
+	// among equally small runs, or 0 if none is big enough
+	Bitu FindBestFit(const Bitu num_pages) const
+	{
+		const auto it = by_size.lower_bound({num_pages, 0});
+		return it == by_size.end() ? 0 : it->second;
+	}
+
+	// Size of the run starting at the page, or 0 if none does
+	Bitu GetSizeAt(const Bitu page) const
+	{
+		const auto it = by_start.find(page);
+		return it == by_start.end() ? 0 : it->second;
+	}
+
+	// The pages have to lie within one free run
+	void Take(const Bitu page, const Bitu num_pages)
+	{
+		auto it = by_start.upper_bound(page);
+		assert(it != by_start.begin());
+		--it;
+		const auto [start, size] = *it;
+		assert(page + num_pages <= start + size);
+
+		Erase(it);
+		if (page > start) {
+			Insert(start, page - start);
+		}
+		if (start + size > page + num_pages) {
+			Insert(page + num_pages, start + size - page - num_pages);
+		}
+	}
+
+	// The pages get merged with the free runs they touch
+	void Give(Bitu page, Bitu num_pages)
+	{
+		auto next = by_start.lower_bound(page);
+		if (next != by_start.begin()) {
+			const auto prev = std::prev(next);
+			if (prev->first + prev->second == page) {
+				page = prev->first;
+				num_pages += prev->second;
+				Erase(prev);
+			}
+		}
+		if (next != by_start.end() && next->first == page + num_pages) {
+			num_pages += next->second;
+			Erase(next);
+		}
+		Insert(page, num_pages);
+	}
+
+private:
+	void Insert(const Bitu page, const Bitu num_pages)
+	{
+		by_start.emplace(page, num_pages);
+		by_size.emplace(num_pages, page);
+		total += num_pages;
+	}
+
+	void Erase(const std::map<Bitu, Bitu>::iterator it)
+	{
+		by_size.erase({it->second, it->first});
+		total -= it->second;
+		by_start.erase(it);
+	}
+
+	std::map<Bitu, Bitu> by_start           = {};
+	std::set<std::pair<Bitu, Bitu>> by_size = {};
+	Bitu total                              = 0;
+};
+
 static struct MemoryBlock {
-	struct page_t {
-		uint8_t bytes[dos_pagesize] = {};
-	};
-	std::vector<page_t> pages           = {};
+	GuestRam pages                      = {};
 	std::vector<PageHandler*> phandlers = {};
 	std::vector<MemHandle> mhandles     = {};
+	FreePages free_pages                = {};
 	struct {
 		Bitu start_page = 0;
 		Bitu end_page   = 0;
@@ -203,25 +428,166 @@ void mem_strcpy(PhysPt dest,PhysPt src) {
 	mem_writeb_inline(dest,0);
 }
 
-void mem_memcpy(PhysPt dest,PhysPt src,Bitu size) {
-	while (size--) mem_writeb_inline(dest++,mem_readb_inline(src++));
+#if C_DEBUG && C_HEAVY_DEBUG
+// Memory read breakpoints have to see every byte
+constexpr bool CanReadHostPages = false;
+#else
+constexpr bool CanReadHostPages = true;
+#endif
+
+// The bytes from the address up to the end of its page, at most the size
+static size_t bytes_in_page(const PhysPt pt, const size_t size)
+{
+	constexpr size_t page_size = 4096;
+	return std::min(size, page_size - (pt & 0xfff));
 }
 
-void MEM_BlockRead(PhysPt pt,void * data,Bitu size) {
-	uint8_t * write=reinterpret_cast<uint8_t *>(data);
-	while (size--) {
-		*write++=mem_readb_inline(pt++);
+// The bulk functions look up each page once. RAM and ROM pages are copied
+// in one go, while the pages behind handlers (and the ones paging hasn't
+// looked up yet) are accessed byte by byte.
+void mem_memcpy(PhysPt dest, PhysPt src, Bitu size)
+{
+	while (size) {
+		const auto num_bytes = std::min(bytes_in_page(dest, size),
+		                                bytes_in_page(src, size));
+		const auto src_host  = CanReadHostPages ? get_tlb_read(src) : nullptr;
+		const auto dest_host = get_tlb_write(dest);
+
+		bool is_copied = false;
+		if (src_host && dest_host) {
+			// Copying forward onto bytes not read yet repeats a
+			// pattern, which memmove wouldn't
+			const auto from = src_host + src;
+			const auto to   = dest_host + dest;
+			if (to <= from || to >= from + num_bytes) {
+				memmove(to, from, num_bytes);
+				is_copied = true;
+			}
+		}
+		if (!is_copied) {
+			for (size_t i = 0; i < num_bytes; ++i) {
+				const auto offset = static_cast<PhysPt>(i);
+				mem_writeb_inline(dest + offset,
+				                  mem_readb_inline(src + offset));
+			}
+		}
+		dest += static_cast<PhysPt>(num_bytes);
+		src += static_cast<PhysPt>(num_bytes);
+		size -= num_bytes;
+	}
+}
+
+// Copies the bytes within a page of both the source and the destination
+static void move_in_pages(const PhysPt dest, const PhysPt src,
+                          const size_t num_bytes, const bool is_backwards)
+{
+	const auto src_host  = CanReadHostPages ? get_tlb_read(src) : nullptr;
+	const auto dest_host = get_tlb_write(dest);
+	if (src_host && dest_host) {
+		memmove(dest_host + dest, src_host + src, num_bytes);
+		return;
+	}
+	for (size_t i = 0; i < num_bytes; ++i) {
+		const auto offset = static_cast<PhysPt>(
+		        is_backwards ? num_bytes - 1 - i : i);
+		mem_writeb_inline(dest + offset, mem_readb_inline(src + offset));
+	}
+}
+
+void MEM_BlockMove(PhysPt dest, PhysPt src, size_t size)
+{
+	// Overlapping moves to higher addresses start at the end, so they
+	// don't overwrite the source before reading it
+	const auto is_backwards = dest > src && dest - src < size;
+	if (!is_backwards) {
+		while (size) {
+			const auto num_bytes = std::min(bytes_in_page(dest, size),
+			                                bytes_in_page(src, size));
+			move_in_pages(dest, src, num_bytes, false);
+			dest += static_cast<PhysPt>(num_bytes);
+			src += static_cast<PhysPt>(num_bytes);
+			size -= num_bytes;
+		}
+		return;
+	}
+	auto dest_end = dest + static_cast<PhysPt>(size);
+	auto src_end  = src + static_cast<PhysPt>(size);
+	while (size) {
+		// The bytes from the start of the pages the last bytes are in
+		const size_t dest_in_page = ((dest_end - 1) & 0xfff) + 1;
+		const size_t src_in_page  = ((src_end - 1) & 0xfff) + 1;
+		const auto num_bytes = std::min({size, dest_in_page, src_in_page});
+		dest_end -= static_cast<PhysPt>(num_bytes);
+		src_end -= static_cast<PhysPt>(num_bytes);
+		move_in_pages(dest_end, src_end, num_bytes, true);
+		size -= num_bytes;
+	}
+}
+
+void MEM_BlockRead(PhysPt pt, void* data, Bitu size)
+{
+	auto write = static_cast<uint8_t*>(data);
+	while (size) {
+		const auto in_page = bytes_in_page(pt, size);
+		if (const auto host = CanReadHostPages ? get_tlb_read(pt) : nullptr;
+		    host) {
+			memcpy(write, host + pt, in_page);
+		} else {
+			for (size_t i = 0; i < in_page; ++i) {
+				write[i] = mem_readb_inline(pt + static_cast<PhysPt>(i));
+			}
+		}
+		pt += static_cast<PhysPt>(in_page);
+		write += in_page;
+		size -= in_page;
 	}
 }
 
 void MEM_BlockWrite(PhysPt pt, const void *data, size_t size)
 {
 	const uint8_t *read = static_cast<const uint8_t *>(data);
-	while (size--) {
-		mem_writeb_inline(pt++,*read++);
+	while (size) {
+		// Hand the bytes within the page to the handler in one go, if
+		// it can take them
+		const auto in_page = bytes_in_page(pt, size);
+		if (const auto host = get_tlb_write(pt); host) {
+			memcpy(host + pt, read, in_page);
+		} else if (const auto handler = get_tlb_writehandler(pt);
+		           in_page < 2 || !(handler->flags & PFLAG_BLOCKWRITE) ||
+		           !handler->write_block(pt, read, in_page, in_page)) {
+			for (size_t i = 0; i < in_page; ++i) {
+				mem_writeb_inline(pt + static_cast<PhysPt>(i), read[i]);
+			}
+		}
+		pt += static_cast<PhysPt>(in_page);
+		read += in_page;
+		size -= in_page;
 	}
 }
 
+MemHostSpan MEM_GetWritableSpan(const PhysPt pt, const size_t size)
+{
+	constexpr size_t page_size = 4096;
+
+	const auto first_in_page = std::min(size, page_size - (pt & 0xfff));
+	const auto tlb_addr      = get_tlb_write(pt);
+	if (!tlb_addr) {
+		return {nullptr, first_in_page};
+	}
+
+	MemHostSpan span = {tlb_addr + pt, first_in_page};
+	while (span.num_bytes < size) {
+		const auto next_pt = pt + static_cast<PhysPt>(span.num_bytes);
+		const auto next_tlb_addr = get_tlb_write(next_pt);
+		if (!next_tlb_addr ||
+		    next_tlb_addr + next_pt != span.data + span.num_bytes) {
+			break;
+		}
+		span.num_bytes += std::min(size - span.num_bytes, page_size);
+	}
+	return span;
+}
+
 void MEM_BlockCopy(PhysPt dest,PhysPt src,Bitu size) {
 	mem_memcpy(dest,src,size);
 }
@@ -242,33 +608,12 @@ uint32_t MEM_TotalPages(void)
 
 uint32_t MEM_FreeLargest()
 {
-	uint32_t size    = 0;
-	uint32_t largest = 0;
-	size_t   index   = XMS_START;
-	while (index < memory.pages.size()) {
-		if (!memory.mhandles[index]) {
-			++size;
-		} else {
-			largest = std::max(size, largest);
-			size = 0;
-		}
-		++index;
-	}
-	largest = std::max(size, largest);
-	return largest;
+	return check_cast<uint32_t>(memory.free_pages.GetLargest());
 }
 
 uint32_t MEM_FreeTotal()
 {
-	uint32_t free  = 0;
-	size_t   index = XMS_START;
-	while (index < memory.pages.size()) {
-		if (!memory.mhandles[index]) {
-			++free;
-		}
-		++index;
-	}
-	return free;
+	return check_cast<uint32_t>(memory.free_pages.GetTotal());
 }
 
 uint32_t MEM_AllocatedPages(MemHandle handle) 
@@ -284,48 +629,13 @@ uint32_t MEM_AllocatedPages(MemHandle handle)
 
 //TODO Maybe some protection for this whole allocation scheme
 
-inline Bitu BestMatch(Bitu size) {
-	Bitu index=XMS_START;	
-	Bitu first=0;
-	Bitu best=0xfffffff;
-	Bitu best_first=0;
-	while (index < memory.pages.size()) {
-		/* Check if we are searching for first free page */
-		if (!first) {
-			/* Check if this is a free page */
-			if (!memory.mhandles[index]) {
-				first=index;	
-			}
-		} else {
-			/* Check if this still is used page */
-			if (memory.mhandles[index]) {
-				Bitu pages=index-first;
-				if (pages==size) {
-					return first;
-				} else if (pages>size) {
-					if (pages<best) {
-						best=pages;
-						best_first=first;
-					}
-				}
-				first=0;			//Always reset for new search
-			}
-		}
-		index++;
-	}
-	/* Check for the final block if we can */
-	if (first && (index-first>=size) && (index-first<best)) {
-		return first;
-	}
-	return best_first;
-}
-
 MemHandle MEM_AllocatePages(Bitu pages,bool sequence) {
 	MemHandle ret;
 	if (!pages) return 0;
 	if (sequence) {
-		Bitu index=BestMatch(pages);
+		Bitu index = memory.free_pages.FindBestFit(pages);
 		if (!index) return 0;
+		memory.free_pages.Take(index, pages);
 		MemHandle * next=&ret;
 		while (pages) {
 			*next=index;
@@ -334,31 +644,42 @@ MemHandle MEM_AllocatePages(Bitu pages,bool sequence) {
 		}
 		*next=-1;
 	} else {
-		if (MEM_FreeTotal()<pages) return 0;
+		if (memory.free_pages.GetTotal() < pages) return 0;
 		MemHandle * next=&ret;
 		while (pages) {
-			Bitu index=BestMatch(1);
+			Bitu index = memory.free_pages.FindBestFit(1);
 			if (!index) E_Exit("MEM:corruption during allocate");
-			while (pages && (!memory.mhandles[index])) {
+			const auto run = std::min(pages,
+			                          memory.free_pages.GetSizeAt(index));
+			memory.free_pages.Take(index, run);
+			for (Bitu i = 0; i < run; ++i) {
 				*next=index;
 				next=&memory.mhandles[index];
 				index++;pages--;
 			}
-			*next=-1;		//Invalidate it in case we need another match
 		}
+		*next=-1;
 	}
 	return ret;
 }
 
 MemHandle MEM_GetNextFreePage(void) {
-	return (MemHandle)BestMatch(1);
+	return (MemHandle)memory.free_pages.FindBestFit(1);
 }
 
 void MEM_ReleasePages(MemHandle handle) {
-	while (handle>0) {
-		MemHandle next=memory.mhandles[handle];
-		memory.mhandles[handle]=0;
-		handle=next;
+	// Runs of consecutive pages in the chain are given back at once
+	while (handle > 0 && memory.mhandles[handle]) {
+		const auto first = handle;
+		MemHandle next   = memory.mhandles[handle];
+		memory.mhandles[handle] = 0;
+		while (next == handle + 1 && memory.mhandles[next]) {
+			handle = next;
+			next   = memory.mhandles[handle];
+			memory.mhandles[handle] = 0;
+		}
+		memory.free_pages.Give(first, handle - first + 1);
+		handle = next;
 	}
 }
 
@@ -390,27 +711,16 @@ bool MEM_ReAllocatePages(MemHandle & handle,Bitu pages,bool sequence) {
 		}
 		MemHandle next=memory.mhandles[index];
 		memory.mhandles[index]=-1;
-		index=next;
-		while (old_pages) {
-			next=memory.mhandles[index];
-			memory.mhandles[index]=0;
-			index=next;
-			old_pages--;
-		}
+		MEM_ReleasePages(next);
 		return true;
 	} else {
 		/* Increase size, check for enough free space */
 		Bitu need=pages-old_pages;
 		if (sequence) {
-			index=last+1;
-			Bitu free=0;
-			while (static_cast<uint32_t>(index) < memory.pages.size() &&
-			       !memory.mhandles[index]) {
-				index++;
-				free++;
-			}
+			const auto free = memory.free_pages.GetSizeAt(last + 1);
 			if (free>=need) {
 				/* Enough space allocate more pages */
+				memory.free_pages.Take(last + 1, need);
 				index=last;
 				while (need) {
 					memory.mhandles[index]=index+1;
@@ -730,7 +1040,11 @@ public:
 		const auto num_pages = (num_megabytes * megabyte) / dos_pagesize;
 
 		// Size the actual memory pages
-		memory.pages.resize(num_pages);
+		const auto use_huge_pages = section->Get_string("memory_pages") ==
+		                            "huge";
+		memory.pages.Allocate(num_pages, use_huge_pages);
+		HOSTMEM_SetUsage("Guest memory",
+		                 static_cast<size_t>(num_pages) * dos_pagesize);
 
 		// The MemBase is address of the first page's first byte
 		MemBase = &(memory.pages[0].bytes[0]);
@@ -748,6 +1062,7 @@ public:
 		// memory-allocation
 		memory.mhandles.clear();
 		memory.mhandles.resize(num_pages, 0);
+		memory.free_pages.Reset(XMS_START, num_pages);
 
 		using page_range_t = std::pair<uint16_t, uint16_t>;
 		auto install_rom_page_handlers = [&](const page_range_t& page_range) {
@@ -779,8 +1094,30 @@ public:
 
 static MEMORY* test;
 
+// The XMS and EMS handles aren't part of it, so snapshots have to be
+// loaded while the same memory is allocated
+static SaveStatePages saved_ram_pages = {};
+
+static void save_memory_state(SaveStateWriter& writer)
+{
+	saved_ram_pages.Save(writer, MemBase, memory.pages.size() * dos_pagesize);
+	writer.Write(memory.a20.enabled);
+	writer.Write(memory.a20.controlport);
+}
+
+static void load_memory_state(SaveStateReader& reader)
+{
+	saved_ram_pages.Load(reader, MemBase, memory.pages.size() * dos_pagesize);
+
+	bool a20_enabled = false;
+	reader.Read(a20_enabled);
+	reader.Read(memory.a20.controlport);
+	MEM_A20_Enable(a20_enabled);
+}
+
 static void MEM_ShutDown([[maybe_unused]] Section *sec)
 {
+	SAVESTATE_RemoveComponent("Memory");
 	delete test;
 }
 
@@ -791,4 +1128,7 @@ void MEM_Init(Section* sec)
 	/* shutdown function */
 	test = new MEMORY(sec);
 	sec->AddDestroyFunction(&MEM_ShutDown);
+
+	saved_ram_pages = {};
+	SAVESTATE_AddComponent("Memory", save_memory_state, load_memory_state);
 }
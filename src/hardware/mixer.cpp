@@ -28,8 +28,10 @@
 #include <cmath>
 #include <cstdint>
 #include <cstring>
+#include <mutex>
 #include <optional>
 #include <sys/types.h>
+#include <type_traits>
 
 #include <SDL.h>
 #include <speex/speex_resampler.h>
@@ -39,6 +41,7 @@
 #include "checks.h"
 #include "control.h"
 #include "cross.h"
+#include "event_counters.h"
 #include "hardware.h"
 #include "mapper.h"
 #include "math_utils.h"
@@ -46,6 +49,7 @@
 #include "midi.h"
 #include "pic.h"
 #include "setup.h"
+#include "spsc_ring.h"
 #include "string_utils.h"
 #include "timer.h"
 #include "tracy.h"
@@ -53,6 +57,7 @@
 
 #include "mverb/MVerb.h"
 #include "tal-chorus/ChorusEngine.h"
+#include "thread_placement.h"
 
 CHECK_NARROWING();
 
@@ -60,6 +65,14 @@ CHECK_NARROWING();
 
 constexpr auto MixerFrameSize = 4;
 
+// A mixed stereo frame, as handed over to the audio device
+using OutputFrame = std::array<int16_t, 2>;
+
+// Master output below one 16-bit step counts as quiet; after this long, the
+// reverb and chorus tails have faded out
+constexpr auto QuietLevel   = 1.0f;
+constexpr auto QuietChainMs = 1000;
+
 constexpr auto FreqShift = 14;
 constexpr auto FreqNext  = (1 << FreqShift);
 constexpr auto FreqMask  = (FreqNext - 1);
@@ -171,6 +184,14 @@ struct MixerSettings {
 
 	std::map<std::string, MixerChannelSettings> channel_settings_cache = {};
 
+	// Guards the work buffers and channels against the emulation and
+	// device threads; the audio device callback never takes it
+	std::recursive_mutex mutex = {};
+
+	// Mixed frames go from the emulation thread to the audio device
+	// callback through this ring
+	SpscRing<OutputFrame> output_ring{MixerBufferLength};
+
 	// Counters accessed by multiple threads
 	std::atomic<work_index_t> pos      = 0;
 	std::atomic<int> frames_done       = 0;
@@ -179,6 +200,22 @@ struct MixerSettings {
 	std::atomic<int> max_frames_needed = 0;
 	std::atomic<int> tick_add = 0; // samples needed per millisecond tick
 
+	// Buffer levels seen by the callback, in permille of the prebuffer
+	std::atomic<int> min_fill_permille = 1000;
+	std::atomic<int> underruns         = 0;
+	std::atomic<int> overruns          = 0;
+
+	// Host time and frame totals taken by MIXER /STATS
+	struct {
+		std::atomic<int64_t> start_ns      = 0;
+		std::atomic<int64_t> effects_ns    = 0;
+		std::atomic<int64_t> callback_ns   = 0;
+		std::atomic<int64_t> frames_mixed  = 0;
+		std::atomic<int64_t> frames_played = 0;
+		std::atomic<int> underruns         = 0;
+		std::atomic<int> overruns          = 0;
+	} stats = {};
+
 	int tick_counter = 0;
 	std::atomic<uint16_t> sample_rate_hz = 0; // sample rate negotiated with SDL
 	uint16_t blocksize = 0; // matches SDL AudioSpec.samples type
@@ -203,11 +240,45 @@ struct MixerSettings {
 	ChorusSettings chorus = {};
 	bool do_chorus        = false;
 
+	// How many frames in a row the master effects chain has output below
+	// QuietLevel; silent blocks skip the chain once that's long enough
+	// for the effect tails to have died out
+	int quiet_frames = 0;
+
 	bool is_manually_muted = false;
+
+	// Resample with the built-in polyphase resampler instead of Speex
+	bool use_polyphase_resampler = false;
 };
 
 static struct MixerSettings mixer = {};
 
+// Counted by the audio device's callback and the emulation respectively
+static EventCounter mixer_underruns("Mixer underruns");
+static EventCounter mixer_overruns("Mixer overruns");
+
+// Adds the host time from its construction until it goes out of scope to
+// one of the stats counters
+class StatsTimer {
+public:
+	explicit StatsTimer(std::atomic<int64_t>& _counter)
+	        : counter(_counter),
+	          start_ns(GetTicksNs())
+	{}
+
+	~StatsTimer()
+	{
+		counter += GetTicksNsSince(start_ns);
+	}
+
+	StatsTimer(const StatsTimer&)            = delete;
+	StatsTimer& operator=(const StatsTimer&) = delete;
+
+private:
+	std::atomic<int64_t>& counter;
+	const int64_t start_ns;
+};
+
 alignas(sizeof(float)) uint8_t MixTemp[MixerBufferLength] = {};
 
 void MixerChannel::SetLineoutMap(const StereoLine map)
@@ -247,17 +318,18 @@ uint16_t MIXER_GetSampleRate()
 
 void MIXER_LockAudioDevice()
 {
-	SDL_LockAudioDevice(mixer.sdldevice);
+	mixer.mutex.lock();
 }
 
 void MIXER_UnlockAudioDevice()
 {
-	SDL_UnlockAudioDevice(mixer.sdldevice);
+	mixer.mutex.unlock();
 }
 
 MixerChannel::MixerChannel(MIXER_Handler _handler, const char* _name,
                            const std::set<ChannelFeature>& _features)
         : name(_name),
+          plot_name(std::string(_name) + " handler ns"),
           envelope(_name),
           handler(_handler),
           features(_features),
@@ -926,6 +998,22 @@ void MixerChannel::ConfigureResampler()
 			return;
 		}
 
+		if (mixer.use_polyphase_resampler) {
+			if (!polyphase_resampler ||
+			    polyphase_resampler->GetInputRateHz() != in_rate_hz ||
+			    polyphase_resampler->GetOutputRateHz() != out_rate_hz) {
+				polyphase_resampler = std::make_unique<PolyphaseResampler>(
+				        in_rate_hz, out_rate_hz);
+			}
+#ifdef DEBUG_MIXER
+			LOG_DEBUG("%s: Polyphase resampler is on, input rate: %d Hz, output rate: %d Hz)",
+			          name.c_str(),
+			          in_rate_hz,
+			          out_rate_hz);
+#endif
+			break;
+		}
+
 		if (!speex_resampler.state) {
 			constexpr auto num_channels = 2; // always stereo
 			constexpr auto quality      = 5;
@@ -965,7 +1053,10 @@ void MixerChannel::ClearResampler()
 		[[fallthrough]];
 
 	case ResampleMethod::Resample:
-		if (do_resample) {
+		if (do_resample && polyphase_resampler) {
+			polyphase_resampler->Reset();
+
+		} else if (do_resample) {
 			assert(speex_resampler.state);
 			speex_resampler_reset_mem(speex_resampler.state);
 			speex_resampler_skip_zeros(speex_resampler.state);
@@ -1041,6 +1132,10 @@ void MixerChannel::Mix(const uint16_t frames_requested)
 
 	frames_needed = frames_requested;
 
+	const auto frames_done_before = frames_done.load();
+	const auto start_ns           = GetTicksNs();
+	const auto mixer_ns_before    = stats.resample_ns + stats.filter_ns;
+
 	while (frames_needed > frames_done) {
 		auto frames_remaining = frames_needed - frames_done;
 		frames_remaining *= freq_add;
@@ -1058,6 +1153,20 @@ void MixerChannel::Mix(const uint16_t frames_requested)
 		handler(static_cast<work_index_t>(frames_remaining));
 	}
 
+	// The mixer's work on the added frames is accounted separately. A
+	// device rendering on its own thread can add frames at any time, so
+	// the difference can come out negative.
+	const auto handler_ns = GetTicksNsSince(start_ns);
+	const auto mixer_ns = stats.resample_ns + stats.filter_ns - mixer_ns_before;
+	stats.device_ns += std::max(handler_ns - mixer_ns, int64_t{0});
+
+	const auto frames_delivered = std::min(frames_done.load(), frames_needed) -
+	                              frames_done_before;
+	stats.frames_requested += std::max(frames_needed - frames_done_before, 0);
+	stats.frames_delivered += std::max(frames_delivered, 0);
+
+	TracyPlot(plot_name.c_str(), handler_ns);
+
 	if (do_sleep) {
 		sleeper.MaybeSleep();
 	}
@@ -1624,12 +1733,92 @@ AudioFrame MixerChannel::ConvertNextFrame(const Type* data, const work_index_t p
 	return frame;
 }
 
+// The sample formats most devices use, which ConvertSamplesInBulk() handles
+template <class Type, bool stereo, bool signeddata, bool nativeorder>
+static constexpr bool has_bulk_conversion()
+{
+	constexpr auto s16_stereo = std::is_same_v<Type, int16_t> && stereo &&
+	                            signeddata && nativeorder;
+	constexpr auto u8_mono = std::is_same_v<Type, uint8_t> && !stereo &&
+	                         !signeddata;
+	constexpr auto float_stereo = std::is_same_v<Type, float> && stereo;
+
+	return s16_stereo || u8_mono || float_stereo;
+}
+
+template <class Type>
+static inline float decode_sample(const Type* data, const size_t i)
+{
+	if constexpr (std::is_same_v<Type, uint8_t>) {
+		return lut_u8to16[data[i]];
+	} else {
+		return static_cast<float>(data[i]);
+	}
+}
+
+// Bulk version of ConvertSamples() for when there's no channel mapping,
+// enveloping or zero-order-hold upsampling to do. Its results are the same,
+// but the samples are converted and scaled in plain loops the compiler can
+// vectorise.
+template <class Type, bool stereo>
+void MixerChannel::ConvertSamplesInBulk(const Type* data, const uint16_t frames,
+                                        std::vector<float>& out)
+{
+	assert(frames > 0);
+
+	const auto volume = combined_volume_scalar;
+
+	auto frame_at = [&](const size_t i) -> AudioFrame {
+		if constexpr (stereo) {
+			return {decode_sample(data, i * 2), decode_sample(data, i * 2 + 1)};
+		} else {
+			return {decode_sample(data, i), 0.0f};
+		}
+	};
+
+	out.resize(static_cast<size_t>(frames) * 2);
+	auto out_pos = out.data();
+
+	// The output lags a frame behind, so it starts with the last frame
+	// of the previous call
+	const auto held_frame = next_frame;
+
+	*out_pos++ = held_frame.left * volume.left;
+	*out_pos++ = (stereo ? held_frame.right : held_frame.left) * volume.right;
+
+	const auto num_frames = static_cast<size_t>(frames) - 1;
+
+	if constexpr (stereo) {
+		for (size_t i = 0; i < num_frames; ++i) {
+			out_pos[i * 2 + 0] = decode_sample(data, i * 2 + 0) * volume.left;
+			out_pos[i * 2 + 1] = decode_sample(data, i * 2 + 1) * volume.right;
+		}
+	} else {
+		for (size_t i = 0; i < num_frames; ++i) {
+			const auto sample  = decode_sample(data, i);
+			out_pos[i * 2 + 0] = sample * volume.left;
+			out_pos[i * 2 + 1] = sample * volume.right;
+		}
+	}
+
+	prev_frame = (num_frames > 0) ? frame_at(num_frames - 1) : held_frame;
+	next_frame = frame_at(num_frames);
+}
+
 // Converts sample stream to floats, performs output channel mappings, removes
 // clicks, and optionally performs zero-order-hold-upsampling.
 template <class Type, bool stereo, bool signeddata, bool nativeorder>
 void MixerChannel::ConvertSamples(const Type* data, const uint16_t frames,
                                   std::vector<float>& out)
 {
+	if constexpr (has_bulk_conversion<Type, stereo, signeddata, nativeorder>()) {
+		if (!do_zoh_upsample && envelope.IsDone() &&
+		    output_map == Stereo && channel_map == Stereo) {
+			ConvertSamplesInBulk<Type, stereo>(data, frames, out);
+			return;
+		}
+	}
+
 	// read-only aliases to avoid repeated dereferencing and to inform the
 	// compiler their values don't change
 	const auto mapped_output_left  = output_map.left;
@@ -1876,6 +2065,8 @@ void MixerChannel::AddSamples(const uint16_t frames, const Type* data)
 
 	last_samples_were_stereo = stereo;
 
+	const auto start_ns = GetTicksNs();
+
 	auto& convert_out = do_resample ? mixer.resample_temp : mixer.resample_out;
 	ConvertSamples<Type, stereo, signeddata, nativeorder>(data, frames, convert_out);
 
@@ -1935,6 +2126,12 @@ void MixerChannel::AddSamples(const uint16_t frames, const Type* data)
 			// number of temporary buffers
 
 		case ResampleMethod::Resample: {
+			if (polyphase_resampler) {
+				polyphase_resampler->Process(mixer.resample_temp,
+				                             mixer.resample_out);
+				break;
+			}
+
 			auto in_frames = check_cast<uint32_t>(
 			                         mixer.resample_temp.size()) /
 			                 2u;
@@ -1960,8 +2157,12 @@ void MixerChannel::AddSamples(const uint16_t frames, const Type* data)
 		}
 	}
 
+	stats.resample_ns += GetTicksNsSince(start_ns);
+
 	MIXER_LockAudioDevice();
 
+	const auto filter_start_ns = GetTicksNs();
+
 	// Optionally filter, apply crossfeed, then mix the results to the
 	// master output
 	const uint16_t out_frames = static_cast<uint16_t>(mixer.resample_out.size()) /
@@ -2012,9 +2213,35 @@ void MixerChannel::AddSamples(const uint16_t frames, const Type* data)
 	}
 	frames_done += out_frames;
 
+	stats.filter_ns += GetTicksNsSince(filter_start_ns);
+
 	MIXER_UnlockAudioDevice();
 }
 
+MixerChannelStats MixerChannel::TakeStats()
+{
+	MixerChannelStats s = {};
+
+	s.device_ns        = stats.device_ns.exchange(0);
+	s.resample_ns      = stats.resample_ns.exchange(0);
+	s.filter_ns        = stats.filter_ns.exchange(0);
+	s.frames_requested = stats.frames_requested.exchange(0);
+	s.frames_delivered = stats.frames_delivered.exchange(0);
+
+	s.render_ahead_frames = stats.render_ahead_frames.load();
+	s.render_underruns    = stats.render_underruns.exchange(0);
+
+	return s;
+}
+
+void MixerChannel::ReportRenderAhead(const int depth_frames, const bool had_underrun)
+{
+	stats.render_ahead_frames = depth_frames;
+	if (had_underrun) {
+		++stats.render_underruns;
+	}
+}
+
 void MixerChannel::AddStretched(const uint16_t len, int16_t* data)
 {
 	MIXER_LockAudioDevice();
@@ -2245,101 +2472,212 @@ static constexpr int calc_tickadd(const int freq)
 }
 
 // Mix a certain amount of new sample frames
-static void mix_samples(const int frames_requested)
-{
-	constexpr auto capture_buf_frames = 1024;
+// Mixes the chorus and reverb aux buffers into the master output, then
+// applies the master high-pass filter and the compressor to a contiguous span
+// of the work buffer
+static void apply_master_effects(const work_index_t start,
+                                 const work_index_t num_frames)
+{
+	assert(start + num_frames <= MixerBufferLength);
+	if (num_frames == 0) {
+		return;
+	}
 
-	const auto frames_added = check_cast<work_index_t>(
-	        std::min(frames_requested - mixer.frames_done, capture_buf_frames));
+	if (mixer.do_reverb) {
+		// MVerb operates on two non-interleaved sample streams
+		static float in_left[MixerBufferLength]  = {};
+		static float in_right[MixerBufferLength] = {};
+		static float* reverb_buf[2]              = {in_left, in_right};
+
+		// High-pass filter the reverb input
+		auto& highpass_filter = mixer.reverb.highpass_filter;
+		for (work_index_t i = 0; i < num_frames; ++i) {
+			const auto& frame = mixer.aux_reverb[start + i];
+
+			in_left[i]  = highpass_filter[0].filter(frame[0]);
+			in_right[i] = highpass_filter[1].filter(frame[1]);
+		}
 
-	const auto start_pos = check_cast<work_index_t>(
-	        (mixer.pos + mixer.frames_done) & MixerBufferMask);
+		mixer.reverb.mverb.process(reverb_buf, reverb_buf, num_frames);
 
-	// Render all channels and accumulate results in the master mixbuffer
-	for (const auto& [_, channel] : mixer.channels) {
-		channel->Mix(check_cast<work_index_t>(frames_requested));
+		for (work_index_t i = 0; i < num_frames; ++i) {
+			mixer.work[start + i][0] += in_left[i];
+			mixer.work[start + i][1] += in_right[i];
+		}
 	}
 
-	if (mixer.do_reverb) {
-		// Apply reverb effect to the reverb aux buffer, then mix the
-		// results to the master output
-		auto pos = start_pos;
-
-		for (work_index_t i = 0; i < frames_added; ++i) {
-			AudioFrame frame = {mixer.aux_reverb[pos][0],
-			                    mixer.aux_reverb[pos][1]};
+	if (mixer.do_chorus) {
+		auto& chorus_engine = mixer.chorus.chorus_engine;
+		for (work_index_t i = 0; i < num_frames; ++i) {
+			AudioFrame frame = {mixer.aux_chorus[start + i][0],
+			                    mixer.aux_chorus[start + i][1]};
 
-			// High-pass filter the reverb input
-			for (size_t ch = 0; ch < 2; ++ch) {
-				frame[ch] = mixer.reverb.highpass_filter[ch].filter(
-				        frame[ch]);
-			}
+			chorus_engine.process(&frame.left, &frame.right);
 
-			// MVerb operates on two non-interleaved sample streams
-			static float in_left[1]     = {};
-			static float in_right[1]    = {};
-			static float* reverb_buf[2] = {in_left, in_right};
+			mixer.work[start + i][0] += frame.left;
+			mixer.work[start + i][1] += frame.right;
+		}
+	}
 
-			in_left[0]  = frame.left;
-			in_right[0] = frame.right;
+	// Apply high-pass filter to the master output
+	for (size_t ch = 0; ch < 2; ++ch) {
+		auto& highpass_filter = mixer.highpass_filter[ch];
+		for (work_index_t i = 0; i < num_frames; ++i) {
+			mixer.work[start + i][ch] = highpass_filter.filter(
+			        mixer.work[start + i][ch]);
+		}
+	}
 
-			const auto in         = reverb_buf;
-			auto out              = reverb_buf;
-			constexpr auto frames = 1;
-			mixer.reverb.mverb.process(in, out, frames);
+	if (mixer.do_compressor) {
+		// Apply compressor to the master output as the very last step
+		for (work_index_t i = 0; i < num_frames; ++i) {
+			auto& sample = mixer.work[start + i];
 
-			mixer.work[pos][0] += reverb_buf[0][0];
-			mixer.work[pos][1] += reverb_buf[1][0];
+			const auto frame = mixer.compressor.Process(
+			        {sample[0], sample[1]});
 
-			pos = (pos + 1) & MixerBufferMask;
+			sample[0] = frame.left;
+			sample[1] = frame.right;
 		}
 	}
 
-	if (mixer.do_chorus) {
-		// Apply chorus effect to the chorus aux buffer, then mix the
-		// results to the master output
-		auto pos = start_pos;
+	auto peak = 0.0f;
+	for (work_index_t i = 0; i < num_frames; ++i) {
+		peak = std::max(peak, std::fabs(mixer.work[start + i][0]));
+		peak = std::max(peak, std::fabs(mixer.work[start + i][1]));
+	}
+	if (peak < QuietLevel) {
+		mixer.quiet_frames += num_frames;
+	} else {
+		mixer.quiet_frames = 0;
+	}
+}
 
-		for (work_index_t i = 0; i < frames_added; ++i) {
-			AudioFrame frame = {mixer.aux_chorus[pos][0],
-			                    mixer.aux_chorus[pos][1]};
+static bool is_silent(const work_index_t start, const work_index_t num_frames)
+{
+	assert(start + num_frames <= MixerBufferLength);
 
-			mixer.chorus.chorus_engine.process(&frame.left, &frame.right);
+	for (work_index_t i = 0; i < num_frames; ++i) {
+		const auto pos = start + i;
+		if (mixer.work[pos][0] != 0.0f || mixer.work[pos][1] != 0.0f ||
+		    mixer.aux_reverb[pos][0] != 0.0f ||
+		    mixer.aux_reverb[pos][1] != 0.0f ||
+		    mixer.aux_chorus[pos][0] != 0.0f ||
+		    mixer.aux_chorus[pos][1] != 0.0f) {
+			return false;
+		}
+	}
+	return true;
+}
 
-			mixer.work[pos][0] += frame.left;
-			mixer.work[pos][1] += frame.right;
+// Hands the finished frames over to the audio device callback
+static void commit_frames(work_index_t pos, int num_frames)
+{
+	constexpr auto chunk_frames = 1024;
+	std::array<OutputFrame, chunk_frames> frames;
+
+	while (num_frames > 0) {
+		const auto n = std::min(num_frames, chunk_frames);
+
+		for (auto i = 0; i < n; ++i) {
+			frames[i] = {clamp_to_int16(static_cast<int>(mixer.work[pos][0])),
+			             clamp_to_int16(static_cast<int>(mixer.work[pos][1]))};
 
 			pos = (pos + 1) & MixerBufferMask;
 		}
-	}
 
-	// Apply high-pass filter to the master output
-	{
-		auto pos = start_pos;
+		const auto num_written = mixer.output_ring.Write(
+		        frames.data(), static_cast<size_t>(n));
 
-		for (work_index_t i = 0; i < frames_added; ++i) {
-			for (size_t ch = 0; ch < 2; ++ch) {
-				mixer.work[pos][ch] = mixer.highpass_filter[ch].filter(
-						mixer.work[pos][ch]);
-			}
-			pos = (pos + 1) & MixerBufferMask;
+		// The callback stopped pulling frames; drop the newest ones
+		if (num_written < static_cast<size_t>(n)) {
+			++mixer.overruns;
+			++mixer.stats.overruns;
+			mixer_overruns.Add();
 		}
+		mixer.stats.frames_mixed += static_cast<int64_t>(num_written);
+		num_frames -= n;
 	}
+}
 
-	if (mixer.do_compressor) {
-		// Apply compressor to the master output as the very last step
-		auto pos = start_pos;
+static void reduce_channels_done_counts(const int at_most)
+{
+	for (const auto& [_, channel] : mixer.channels) {
+		channel->frames_done -= std::min(channel->frames_done.load(), at_most);
+	}
+}
 
-		for (work_index_t i = 0; i < frames_added; ++i) {
-			AudioFrame frame = {mixer.work[pos][0], mixer.work[pos][1]};
+// Clears the committed frames from the work buffers and starts the next
+// tick at the frame following them
+static void retire_frames()
+{
+	const auto num_frames = mixer.frames_done.load();
 
-			frame = mixer.compressor.Process(frame);
+	work_index_t pos = mixer.pos;
+	for (auto i = 0; i < num_frames; ++i) {
+		mixer.work[pos][0] = 0.0f;
+		mixer.work[pos][1] = 0.0f;
 
-			mixer.work[pos][0] = frame.left;
-			mixer.work[pos][1] = frame.right;
+		mixer.aux_reverb[pos][0] = 0.0f;
+		mixer.aux_reverb[pos][1] = 0.0f;
 
-			pos = (pos + 1) & MixerBufferMask;
+		mixer.aux_chorus[pos][0] = 0.0f;
+		mixer.aux_chorus[pos][1] = 0.0f;
+
+		pos = (pos + 1) & MixerBufferMask;
+	}
+	mixer.pos = pos;
+
+	reduce_channels_done_counts(num_frames);
+
+	mixer.frames_needed -= num_frames;
+	mixer.frames_done = 0;
+}
+
+static void mix_samples(const int frames_requested)
+{
+	constexpr auto capture_buf_frames = 1024;
+
+	const auto frames_to_commit = frames_requested - mixer.frames_done;
+
+	const auto frames_added = check_cast<work_index_t>(
+	        std::min(frames_requested - mixer.frames_done, capture_buf_frames));
+
+	const auto start_pos = check_cast<work_index_t>(
+	        (mixer.pos + mixer.frames_done) & MixerBufferMask);
+
+	// Render all awake channels and accumulate results in the master
+	// mixbuffer; sleeping channels have nothing to add
+	auto num_awake_channels = 0;
+	for (const auto& [_, channel] : mixer.channels) {
+		if (!channel->is_enabled) {
+			continue;
 		}
+		++num_awake_channels;
+		channel->Mix(check_cast<work_index_t>(frames_requested));
+	}
+
+	// The frames added form at most two contiguous spans of the ring
+	// buffer; the effects process them a span at a time
+	const auto first_span = std::min(frames_added,
+	                                  check_cast<work_index_t>(
+	                                          MixerBufferLength - start_pos));
+	const auto second_span = check_cast<work_index_t>(frames_added - first_span);
+
+	// With every channel asleep and the effect tails gone, the work
+	// buffer already holds the silent block we'd get out of the chain
+	const auto quiet_after_frames = mixer.sample_rate_hz * QuietChainMs / 1000;
+
+	const auto skip_master_effects = num_awake_channels == 0 &&
+	                                 mixer.quiet_frames >= quiet_after_frames &&
+	                                 is_silent(start_pos, first_span) &&
+	                                 is_silent(0, second_span);
+
+	if (!skip_master_effects) {
+		StatsTimer timer(mixer.stats.effects_ns);
+
+		apply_master_effects(start_pos, first_span);
+		apply_master_effects(0, second_span);
 	}
 
 	// Capture audio output if requested
@@ -2365,6 +2703,10 @@ static void mix_samples(const int frames_requested)
 		                     reinterpret_cast<int16_t*>(out));
 	}
 
+	if (mixer.state == MixerState::On) {
+		commit_frames(start_pos, frames_to_commit);
+	}
+
 	// Reset the tick_add for constant speed
 	if (is_mixer_irq_important()) {
 		mixer.tick_add = calc_tickadd(mixer.sample_rate_hz);
@@ -2378,6 +2720,8 @@ static void handle_mix_samples()
 	MIXER_LockAudioDevice();
 
 	mix_samples(mixer.frames_needed);
+	retire_frames();
+
 	mixer.tick_counter += mixer.tick_add;
 
 	const auto frames_needed = mixer.frames_needed +
@@ -2389,34 +2733,82 @@ static void handle_mix_samples()
 	MIXER_UnlockAudioDevice();
 }
 
-static void reduce_channels_done_counts(const int at_most)
+void MIXER_MixPartialTick()
 {
-	for (const auto& [_, channel] : mixer.channels) {
-		channel->frames_done -= std::min(channel->frames_done.load(), at_most);
+	if (mixer.state != MixerState::On) {
+		return;
 	}
+	MIXER_LockAudioDevice();
+
+	const auto frames_requested = static_cast<int>(PIC_TickIndex() *
+	                                               mixer.frames_needed);
+	if (frames_requested > mixer.frames_done) {
+		mix_samples(frames_requested);
+	}
+
+	MIXER_UnlockAudioDevice();
 }
 
-static void handle_mix_no_sound()
+MixerBufferStats MIXER_TakeBufferStats()
 {
-	MIXER_LockAudioDevice();
+	MixerBufferStats stats = {};
+	stats.min_fill  = static_cast<float>(mixer.min_fill_permille.exchange(1000)) /
+	                 1000.0f;
+	stats.underruns = mixer.underruns.exchange(0);
+	stats.overruns  = mixer.overruns.exchange(0);
+	return stats;
+}
 
-	mix_samples(mixer.frames_needed);
+MixerStats MIXER_TakeStats()
+{
+	const auto now_ns = GetTicksNs();
+
+	MixerStats stats = {};
 
-	/* Clear piece we've just generated */
-	for (auto i = 0; i < mixer.frames_needed; ++i) {
-		mixer.work[mixer.pos][0] = 0;
-		mixer.work[mixer.pos][1] = 0;
+	stats.elapsed_ns    = now_ns - mixer.stats.start_ns.exchange(now_ns);
+	stats.effects_ns    = mixer.stats.effects_ns.exchange(0);
+	stats.callback_ns   = mixer.stats.callback_ns.exchange(0);
+	stats.frames_mixed  = mixer.stats.frames_mixed.exchange(0);
+	stats.frames_played = mixer.stats.frames_played.exchange(0);
+	stats.underruns     = mixer.stats.underruns.exchange(0);
+	stats.overruns      = mixer.stats.overruns.exchange(0);
+	return stats;
+}
 
-		mixer.pos = (mixer.pos + 1) & MixerBufferMask;
+// Called from the audio device callback with the frames left in the
+// buffer once the request is served
+static void record_buffer_fill(const int frames_remaining)
+{
+	if (mixer.min_frames_needed <= 0) {
+		return;
 	}
+	const auto permille = std::clamp(frames_remaining * 1000 /
+	                                         mixer.min_frames_needed,
+	                                 0,
+	                                 1000);
+	TracyPlot("Mixer buffer fill (permille)",
+	          static_cast<int64_t>(permille));
 
-	reduce_channels_done_counts(mixer.frames_needed);
+	auto current = mixer.min_fill_permille.load();
+	while (permille < current &&
+	       !mixer.min_fill_permille.compare_exchange_weak(current, permille)) {
+	}
+}
+
+static void handle_mix_no_sound()
+{
+	MIXER_LockAudioDevice();
+
+	mix_samples(mixer.frames_needed);
+	mixer.stats.frames_mixed += mixer.frames_needed;
+
+	/* Throw away the piece we've just generated */
+	retire_frames();
 
 	/* Set values for next tick */
 	mixer.tick_counter += mixer.tick_add;
 	mixer.frames_needed = mixer.tick_counter >> TickShift;
 	mixer.tick_counter &= TickMask;
-	mixer.frames_done = 0;
 
 	MIXER_UnlockAudioDevice();
 }
@@ -2425,40 +2817,61 @@ static void SDLCALL mixer_callback([[maybe_unused]] void* userdata,
                                    Uint8* stream, int len)
 {
 	ZoneScoped;
+	StatsTimer timer(mixer.stats.callback_ns);
+
+	// The callback thread belongs to the audio backend, so the role can
+	// only be applied from in here
+	static thread_local bool has_applied_role = false;
+	if (!has_applied_role) {
+		THREAD_ApplyRole(ThreadRole::AudioDevice);
+		has_applied_role = true;
+	}
+
 	memset(stream, 0, static_cast<size_t>(len));
 
 	auto frames_requested = len / MixerFrameSize;
 	auto output           = reinterpret_cast<int16_t*>(stream);
 	auto reduce_frames    = 0;
-	work_index_t pos      = 0;
+
+	// Only the emulation thread writes to the ring, so the frames counted
+	// here stay available until we consume them
+	auto& ring                  = mixer.output_ring;
+	const auto frames_available = static_cast<int>(ring.GetNumReadable());
+	TracyPlot("Mixer buffered frames", static_cast<int64_t>(frames_available));
 
 	// Local resampling counter to manipulate the data when sending it off
 	// to the callback
 	auto index_add = (1 << IndexShiftLocal);
 	auto index     = (index_add % frames_requested) ? frames_requested : 0;
 
+	record_buffer_fill(frames_available - frames_requested);
+
 	/* Enough room in the buffer ? */
-	if (mixer.frames_done < frames_requested) {
+	if (frames_available < frames_requested) {
+		++mixer.underruns;
+		++mixer.stats.underruns;
+		mixer_underruns.Add();
 		//		LOG_WARNING("Full underrun requested %d, have
 		//%d, min %d", frames_requested, mixer.frames_done.load(),
 		// mixer.min_frames_needed.load());
-		if ((frames_requested - mixer.frames_done) >
+		if ((frames_requested - frames_available) >
 		    (frames_requested >> 7)) { // Max 1 percent
 			                       // stretch.
 			return;
 		}
-		reduce_frames = mixer.frames_done;
+		reduce_frames = frames_available;
 		index_add = (reduce_frames << IndexShiftLocal) / frames_requested;
 
 		mixer.tick_add = calc_tickadd(mixer.sample_rate_hz +
 		                              mixer.min_frames_needed);
 
-	} else if (mixer.frames_done < mixer.max_frames_needed) {
-		auto frames_remaining = mixer.frames_done - frames_requested;
+	} else if (frames_available < mixer.max_frames_needed) {
+		auto frames_remaining = frames_available - frames_requested;
 
 		if (frames_remaining < mixer.min_frames_needed) {
 			if (!is_mixer_irq_important()) {
-				auto frames_needed = mixer.frames_needed -
+				auto frames_needed = frames_available +
+				                     mixer.frames_needed -
 				                     frames_requested;
 
 				auto diff = (mixer.min_frames_needed > frames_needed
@@ -2523,82 +2936,41 @@ static void SDLCALL mixer_callback([[maybe_unused]] void* userdata,
 		//		LOG_WARNING("overflow run requested %u, have %u,
 		// min %u", frames_requested, mixer.frames_done.load(),
 		// mixer.min_frames_needed.load());
-		if (mixer.frames_done > MixerBufferLength) {
-			index_add = MixerBufferLength - 2 * mixer.min_frames_needed;
-		} else {
-			index_add = mixer.frames_done - 2 * mixer.min_frames_needed;
-		}
+		index_add = frames_available - 2 * mixer.min_frames_needed;
 
 		index_add = (index_add << IndexShiftLocal) / frames_requested;
-		reduce_frames = mixer.frames_done - 2 * mixer.min_frames_needed;
+		reduce_frames = frames_available - 2 * mixer.min_frames_needed;
 
 		mixer.tick_add = calc_tickadd(mixer.sample_rate_hz -
 		                              (mixer.min_frames_needed / 5));
 	}
 
-	reduce_channels_done_counts(reduce_frames);
-
 	// Reset mixer.tick_add when irqs are important
 	if (is_mixer_irq_important()) {
 		mixer.tick_add = calc_tickadd(mixer.sample_rate_hz);
 	}
 
-	mixer.frames_done -= reduce_frames;
-
-	const auto frames_needed = mixer.frames_needed - reduce_frames;
-	mixer.frames_needed      = frames_needed;
-
-	pos       = mixer.pos;
-	mixer.pos = check_cast<work_index_t>((mixer.pos + reduce_frames) &
-	                                     MixerBufferMask);
-
 	if (frames_requested != reduce_frames) {
 		while (frames_requested--) {
-			const auto i = check_cast<work_index_t>(
-			        (pos + (index >> IndexShiftLocal)) & MixerBufferMask);
+			const auto& frame = ring.Peek(
+			        static_cast<size_t>(index >> IndexShiftLocal));
 			index += index_add;
 
-			*output++ = clamp_to_int16(
-			        static_cast<int>(mixer.work[i][0]));
-			*output++ = clamp_to_int16(
-			        static_cast<int>(mixer.work[i][1]));
-		}
-		// Clean the used buffers
-		while (reduce_frames--) {
-			pos &= MixerBufferMask;
-
-			mixer.work[pos][0] = 0.0f;
-			mixer.work[pos][1] = 0.0f;
-
-			mixer.aux_reverb[pos][0] = 0.0f;
-			mixer.aux_reverb[pos][1] = 0.0f;
-
-			mixer.aux_chorus[pos][0] = 0.0f;
-			mixer.aux_chorus[pos][1] = 0.0f;
-
-			++pos;
+			*output++ = frame[0];
+			*output++ = frame[1];
 		}
 	} else {
-		while (reduce_frames--) {
-			pos &= MixerBufferMask;
-
-			*output++ = clamp_to_int16(
-			        static_cast<int>(mixer.work[pos][0]));
-			*output++ = clamp_to_int16(
-			        static_cast<int>(mixer.work[pos][1]));
-
-			mixer.work[pos][0] = 0.0f;
-			mixer.work[pos][1] = 0.0f;
+		for (auto i = 0; i < reduce_frames; ++i) {
+			const auto& frame = ring.Peek(static_cast<size_t>(i));
 
-			mixer.aux_reverb[pos][0] = 0.0f;
-			mixer.aux_reverb[pos][1] = 0.0f;
-
-			mixer.aux_chorus[pos][0] = 0.0f;
-			mixer.aux_chorus[pos][1] = 0.0f;
-
-			++pos;
+			*output++ = frame[0];
+			*output++ = frame[1];
 		}
 	}
+
+	// Hand the space back to the emulation thread
+	ring.Consume(static_cast<size_t>(reduce_frames));
+	mixer.stats.frames_played += reduce_frames;
 }
 
 static void stop_mixer([[maybe_unused]] Section* sec) {}
@@ -2644,6 +3016,10 @@ static void set_mixer_state(const MixerState requested)
 	} else if (mixer.state != MixerState::On && new_state == MixerState::On) {
 		TIMER_DelTickHandler(handle_mix_no_sound);
 		TIMER_AddTickHandler(handle_mix_samples);
+
+		// The device is still paused, so the callback can't be reading
+		// the stale frames left over from before
+		mixer.output_ring.Clear();
 		// LOG_MSG("MIXER: Changed from %s to on",
 		// MixerStateToString(mixer.state));
 
@@ -2688,10 +3064,43 @@ void MIXER_CloseAudioDevice()
 	mixer.state = MixerState::Uninitialized;
 }
 
+// Restarts SDL's audio subsystem with the requested driver, falling back to
+// SDL's own choice if it's not available
+static void select_sdl_audio_driver(const std::string& driver)
+{
+	const auto current_driver = SDL_GetCurrentAudioDriver();
+	if (current_driver && driver == current_driver) {
+		return;
+	}
+
+	SDL_AudioQuit();
+
+	if (SDL_AudioInit(driver.c_str()) == 0) {
+		LOG_MSG("MIXER: Using the '%s' audio driver", driver.c_str());
+		return;
+	}
+
+	LOG_WARNING("MIXER: Can't use the '%s' audio driver: '%s'; using the default driver",
+	            driver.c_str(),
+	            SDL_GetError());
+
+	set_section_property_value("mixer", "audio_driver", "auto");
+
+	if (SDL_AudioInit(nullptr) != 0) {
+		LOG_WARNING("MIXER: Can't initialise the default audio driver: '%s'",
+		            SDL_GetError());
+	}
+}
+
 static bool init_sdl_sound(Section_prop* section)
 {
 	const auto negotiate = section->Get_bool("negotiate");
 
+	const std::string driver = section->Get_string("audio_driver");
+	if (driver != "auto") {
+		select_sdl_audio_driver(driver);
+	}
+
 	// Start the mixer using SDL sound
 	SDL_AudioSpec spec;
 	SDL_AudioSpec obtained;
@@ -2807,6 +3216,9 @@ void MIXER_Init(Section* sec)
 	mixer.sample_rate_hz = check_cast<uint16_t>(section->Get_int("rate"));
 	mixer.blocksize = static_cast<uint16_t>(section->Get_int("blocksize"));
 
+	mixer.use_polyphase_resampler = (section->Get_string("resampler") ==
+	                                 "polyphase");
+
 	const auto configured_state = section->Get_bool("nosound")
 	                                    ? MixerState::NoSound
 	                                    : MixerState::On;
@@ -2837,6 +3249,7 @@ void MIXER_Init(Section* sec)
 
 	mixer.pos           = 0;
 	mixer.frames_done   = 0;
+	mixer.output_ring.Clear();
 	mixer.frames_needed = mixer.min_frames_needed + 1;
 	mixer.min_frames_needed = 0;
 	mixer.max_frames_needed = mixer.blocksize * 2 + 2 * prebuffer_frames;
@@ -2951,10 +3364,11 @@ void init_mixer_dosbox_settings(Section_prop& sec_prop)
 
 	int_prop = sec_prop.Add_int("blocksize", only_at_start, default_blocksize);
 	int_prop->Set_values(
-	        {"128", "256", "512", "1024", "2048", "4096", "8192"});
+	        {"64", "128", "256", "512", "1024", "2048", "4096", "8192"});
 	int_prop->Set_help(
 	        "Mixer block size in sample frames (%s by default). Larger values might help\n"
-	        "with sound stuttering but the sound will also be more lagged.");
+	        "with sound stuttering but the sound will also be more lagged. Values of 64 and\n"
+	        "128 are only reliable with a low-latency 'audio_driver'.");
 
 	int_prop = sec_prop.Add_int("prebuffer", only_at_start, default_prebuffer_ms);
 	int_prop->SetMinMax(0, MaxPrebufferMs);
@@ -2963,11 +3377,31 @@ void init_mixer_dosbox_settings(Section_prop& sec_prop)
 	        "(%s by default). Larger values might help with sound stuttering but the sound\n"
 	        "will also be more lagged.");
 
+	auto string_prop = sec_prop.Add_string("audio_driver", only_at_start, "auto");
+	string_prop->Set_help(
+	        "Audio driver used for the sound output ('auto' by default):\n"
+	        "  auto:       Let SDL pick the first driver that works.\n"
+	        "  <name>:     Use the named SDL audio driver, e.g., 'pipewire' or 'jack' on\n"
+	        "              Linux, 'wasapi' on Windows, or 'coreaudio' on macOS. These\n"
+	        "              can run with 64 to 128-frame blocks; other drivers include\n"
+	        "              'pulseaudio', 'alsa' and 'directsound'.\n"
+	        "Note: Falls back to 'auto' if the driver isn't available in your SDL build.");
+
 	bool_prop = sec_prop.Add_bool("negotiate", only_at_start, default_allow_negotiate);
 	bool_prop->Set_help(
 	        "Let the system audio driver negotiate possibly better sample rate and blocksize\n"
 	        "settings (%s by default).");
 
+	string_prop = sec_prop.Add_string("resampler", only_at_start, "speex");
+	string_prop->Set_help(
+	        "Resampler used by the channels that resample to the mixer rate with a\n"
+	        "brickwall filter (e.g., OPL, and Sound Blaster DACs in most filter modes):\n"
+	        "  speex:      Use the Speex resampler (default).\n"
+	        "  polyphase:  Use the built-in polyphase resampler; similar quality at a\n"
+	        "              fraction of the CPU cost, which helps on slow hosts when several\n"
+	        "              channels resample from odd rates.");
+	string_prop->Set_values({"speex", "polyphase"});
+
 	const auto default_on = true;
 	bool_prop = sec_prop.Add_bool("compressor", when_idle, default_on);
 	bool_prop->Set_help("Enable the auto-leveling compressor on the master channel to prevent clipping\n"
@@ -2975,7 +3409,7 @@ void init_mixer_dosbox_settings(Section_prop& sec_prop)
 	                    "  off:  Disable compressor.\n"
 	                    "  on:   Enable compressor (default).");
 
-	auto string_prop = sec_prop.Add_string("crossfeed", when_idle, "off");
+	string_prop = sec_prop.Add_string("crossfeed", when_idle, "off");
 	string_prop->Set_help(
 	        "Enable crossfeed globally on all stereo channels for headphone listening:\n"
 	        "  off:     No crossfeed (default).\n"
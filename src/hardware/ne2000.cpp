@@ -26,14 +26,17 @@
 
 #if C_NE2000
 
+#include <algorithm>
 #include <cstdarg>
 #include <cstdio>
 #include <cstring>
+#include <memory>
 
 #include "callback.h"
 #include "cpu.h"
 #include "ethernet.h"
 #include "inout.h"
+#include "network_log.h"
 #include "pic.h"
 #include "setup.h"
 #include "string_utils.h"
@@ -43,6 +46,7 @@
 /* Couldn't find a real spec for the NE2000 out there, hence this is adapted heavily from Bochs */
 
 EthernetConnection* ethernet = nullptr;
+static std::unique_ptr<NetworkLogWriter> packet_log = {};
 static void NE2000_TX_Event(uint32_t val);
 
 //Never completely fill the ne2k ring so that we never
@@ -264,7 +268,11 @@ bx_ne2k_c::write_cr(io_val_t data)
       // Send the packet to the system driver
       // BX_NE2K_THIS ethdev->sendpkt(& BX_NE2K_THIS s.mem[BX_NE2K_THIS
       // s.tx_page_start*256 - BX_NE2K_MEMSTART], BX_NE2K_THIS s.tx_bytes);
-      ethernet->SendPacket(&s.mem[s.tx_page_start * 256 - BX_NE2K_MEMSTART], s.tx_bytes);
+      const auto tx_frame = &s.mem[s.tx_page_start * 256 - BX_NE2K_MEMSTART];
+      if (packet_log) {
+	      packet_log->Write(NetworkLogDirection::FromGuest, tx_frame, s.tx_bytes);
+      }
+      ethernet->SendPacket(tx_frame, s.tx_bytes);
       // s.tx_timer_index = (64 + 96 + 4*8 + BX_NE2K_THIS s.tx_bytes*8)/10;
       s.tx_timer_active = 1;
 
@@ -1347,14 +1355,54 @@ int bx_ne2k_c::rx_frame(const void *buf, unsigned io_len)
 
   BX_NE2K_THIS s.ISR.pkt_rx = 1;
 
-  if (BX_NE2K_THIS s.IMR.rx_inte) {
-	//LOG_MSG("packet rx interrupt");
-	  PIC_ActivateIRQ(s.base_irq);
-    //DEV_pic_raise_irq(BX_NE2K_THIS s.base_irq);
-  } //else LOG_MSG("no packet rx interrupt");
+  // A burst gets a single interrupt once its last frame is in
+  BX_NE2K_THIS s.rx_irq_pending = true;
+  if (!BX_NE2K_THIS s.rx_burst) {
+	  raise_rx_irq();
+  }
   return static_cast<int>(io_len);
 }
 
+static void NE2000_RX_IRQ_Event(uint32_t /*val*/);
+
+void bx_ne2k_c::begin_rx_burst()
+{
+	BX_NE2K_THIS s.rx_burst = true;
+}
+
+void bx_ne2k_c::end_rx_burst()
+{
+	BX_NE2K_THIS s.rx_burst = false;
+	if (BX_NE2K_THIS s.rx_irq_pending) {
+		raise_rx_irq();
+	}
+}
+
+// Raises the receive interrupt, or holds it back until the coalescing
+// window since the last one has passed
+void bx_ne2k_c::raise_rx_irq()
+{
+	if (BX_NE2K_THIS s.rx_irq_scheduled) {
+		return;
+	}
+	const auto now_ms     = PIC_FullIndex();
+	const auto elapsed_ms = now_ms - BX_NE2K_THIS s.last_rx_irq_ms;
+	if (elapsed_ms >= 0.0 && elapsed_ms < BX_NE2K_THIS s.rx_irq_window_ms) {
+		PIC_AddEvent(NE2000_RX_IRQ_Event,
+		             BX_NE2K_THIS s.rx_irq_window_ms - elapsed_ms);
+		BX_NE2K_THIS s.rx_irq_scheduled = true;
+		return;
+	}
+	BX_NE2K_THIS s.rx_irq_pending = false;
+
+	// The guest may have taken the frames and acknowledged them already
+	if (BX_NE2K_THIS s.ISR.pkt_rx && BX_NE2K_THIS s.IMR.rx_inte) {
+		//LOG_MSG("packet rx interrupt");
+		PIC_ActivateIRQ(s.base_irq);
+		BX_NE2K_THIS s.last_rx_irq_ms = now_ms;
+	}
+}
+
 //uint8_t macaddr[6] = { 0xAC, 0xDE, 0x48, 0x8E, 0x89, 0x19 };
 
 io_val_t dosbox_read(io_port_t port, io_width_t width)
@@ -1429,15 +1477,26 @@ static void NE2000_TX_Event([[maybe_unused]] uint32_t val)
 	theNE2kDevice->tx_timer();
 }
 
+static void NE2000_RX_IRQ_Event(uint32_t /*val*/)
+{
+	theNE2kDevice->s.rx_irq_scheduled = false;
+	theNE2kDevice->raise_rx_irq();
+}
+
 static void NE2000_Poller(void) {
+	theNE2kDevice->begin_rx_burst();
 	ethernet->GetPackets([](const uint8_t *packet, int len) {
 		//LOG_MSG("NE2000: Received %d bytes", header->len);
 
 		// don't receive in loopback modes
 		if((theNE2kDevice->s.DCR.loop == 0) || (theNE2kDevice->s.TCR.loop_cntl != 0))
 			return -1;
+		if (packet_log) {
+			packet_log->Write(NetworkLogDirection::ToGuest, packet, len);
+		}
 		return theNE2kDevice->rx_frame(packet, check_cast<uint16_t>(len));
 	});
+	theNE2kDevice->end_rx_burst();
 }
 
 class NE2K final : public Module_base {
@@ -1460,10 +1519,11 @@ public:
 			return;
 		}
 
-		ethernet = ETHERNET_OpenConnection("slirp");
+		const std::string backend = section->Get_string("backend");
+		ethernet = ETHERNET_OpenConnection(backend);
 		if(!ethernet)
 		{
-			LOG_MSG("NE2000: Failed to open Ethernet slirp backend");
+			LOG_MSG("NE2000: Failed to open Ethernet %s backend", backend.c_str());
 			load_success = false;
 			return;
 		}
@@ -1504,9 +1564,21 @@ public:
 
 		theNE2kDevice->s.base_address = base;
 		theNE2kDevice->s.base_irq = irq;
+		theNE2kDevice->s.rx_irq_window_ms =
+		        section->Get_int("nic_irq_coalescing") / 1000.0;
 
 		theNE2kDevice->init();
 
+		const auto capture_path = section->Get_path("capture_file");
+		if (capture_path && !capture_path->realpath.empty()) {
+			NetworkLogAddress address = {};
+			std::copy_n(mac, address.size(), address.begin());
+			packet_log = NetworkLogWriter::Create(
+			        capture_path->realpath.string(),
+			        NetworkLogSource::Ethernet,
+			        address);
+		}
+
 		// install I/O-handlers and timer
 		for(io_port_t i = 0; i < 0x20; ++i) {
       const auto port_num = static_cast<io_port_t>(i + theNE2kDevice->s.base_address);
@@ -1517,12 +1589,14 @@ public:
 	}
 
 	~NE2K() {
+		packet_log.reset();
 		delete ethernet;
 		ethernet = nullptr;
 		delete theNE2kDevice;
 		theNE2kDevice = nullptr;
 		TIMER_DelTickHandler(NE2000_Poller);
 		PIC_RemoveEvents(NE2000_TX_Event);
+		PIC_RemoveEvents(NE2000_RX_IRQ_Event);
 	}
 };
 
@@ -18,6 +18,7 @@
 
 #include "opl.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
 #include <cstring>
@@ -30,11 +31,13 @@
 #include "control.h"
 #include "cpu.h"
 #include "mapper.h"
+#include "math_utils.h"
 #include "mem.h"
 #include "opl_capture.h"
 #include "setup.h"
 #include "string_utils.h"
 #include "support.h"
+#include "tracy.h"
 
 CHECK_NARROWING();
 
@@ -258,6 +261,20 @@ void Opl::Init()
 }
 
 void Opl::WriteReg(const io_port_t selected_reg, const uint8_t val)
+{
+	if (!renderer) {
+		ApplyRegisterWrite(selected_reg, val);
+		return;
+	}
+
+	// The address decoding needs this right away
+	if (selected_reg == 0x105) {
+		opl.newm = selected_reg & 0x01;
+	}
+	EnqueueWork(OplWork::Type::Register, selected_reg, val);
+}
+
+void Opl::ApplyRegisterWrite(const io_port_t selected_reg, const uint8_t val)
 {
 	if (opl.mode == OplMode::Esfm) {
 		ESFM_write_reg_buffered_fast(&esfm.chip, selected_reg, val);
@@ -339,38 +356,40 @@ int16_t remove_dc_bias(const int16_t back_sample)
 	return static_cast<int16_t>(front_sample - average);
 }
 
-AudioFrame Opl::RenderFrame()
+const std::vector<AudioFrame>& Opl::RenderFrames(const int num_frames)
 {
-	static int16_t buf[2] = {};
-
-	if (opl.mode == OplMode::Esfm) {
-		ESFM_generate_stream(&esfm.chip, buf, 1);
+	const auto n = check_cast<size_t>(num_frames);
 
-		if (ctrl.wants_dc_bias_removed) {
-			buf[0] = remove_dc_bias<Left>(buf[0]);
-			buf[1] = remove_dc_bias<Right>(buf[1]);
-		}
+	raw_buffer.resize(n * 2);
+	render_buffer.resize(n);
 
-		AudioFrame frame = {buf[0], buf[1]};
-		return frame;
+	auto raw = raw_buffer.data();
 
-	} else { // OPL
-		OPL3_GenerateStream(&opl.chip, buf, 1);
+	if (opl.mode == OplMode::Esfm) {
+		ESFM_generate_stream(&esfm.chip, raw, check_cast<uint32_t>(n));
+	} else {
+		// We run the chip at its native rate, so Nuked's resampler
+		// would only delay the output by a frame; skip it
+		for (size_t i = 0; i < n; ++i) {
+			OPL3_Generate(&opl.chip, raw + i * 2);
+		}
+	}
 
-		if (ctrl.wants_dc_bias_removed) {
-			buf[0] = remove_dc_bias<Left>(buf[0]);
-			buf[1] = remove_dc_bias<Right>(buf[1]);
+	if (ctrl.wants_dc_bias_removed) {
+		for (size_t i = 0; i < n; ++i) {
+			raw[i * 2]     = remove_dc_bias<Left>(raw[i * 2]);
+			raw[i * 2 + 1] = remove_dc_bias<Right>(raw[i * 2 + 1]);
 		}
+	}
 
-		AudioFrame frame = {};
-		if (adlib_gold) {
-			adlib_gold->Process(buf, 1, &frame[0]);
-		} else {
-			frame.left  = buf[0];
-			frame.right = buf[1];
+	if (adlib_gold) {
+		adlib_gold->Process(raw, check_cast<uint32_t>(n), &render_buffer[0][0]);
+	} else {
+		for (size_t i = 0; i < n; ++i) {
+			render_buffer[i] = {raw[i * 2], raw[i * 2 + 1]};
 		}
-		return frame;
 	}
+	return render_buffer;
 }
 
 void Opl::RenderUpToNow()
@@ -381,18 +400,44 @@ void Opl::RenderUpToNow()
 	assert(channel);
 	if (channel->WakeUp()) {
 		last_rendered_ms = now;
+		if (renderer) {
+			renderer->SetRenderedUpTo(now);
+		}
 		return;
 	}
+	if (renderer) {
+		// The render thread catches up when it applies the next write
+		return;
+	}
+
 	// Keep rendering until we're current
-	while (last_rendered_ms < now) {
-		last_rendered_ms += ms_per_frame;
-		fifo.emplace(RenderFrame());
+	if (last_rendered_ms < now) {
+		const auto num_frames = iround(
+		        ceil((now - last_rendered_ms) / ms_per_frame));
+
+		last_rendered_ms += num_frames * ms_per_frame;
+
+		for (const auto& frame : RenderFrames(num_frames)) {
+			fifo.emplace(frame);
+		}
 	}
 }
 
 void Opl::AudioCallback(const uint16_t requested_frames)
 {
+	ZoneScoped;
 	assert(channel);
+
+	if (renderer) {
+		if (renderer->DequeueFrames(requested_frames, callback_buffer)) {
+			channel->AddSamples_sfloat(requested_frames,
+			                           &callback_buffer[0][0]);
+		} else {
+			channel->AddSilence();
+		}
+		renderer->SetRenderedUpTo(PIC_FullIndex());
+		return;
+	}
 #if 0
 	if (fifo.size()) {
 		LOG_MSG("%s: Queued %2lu cycle-accurate frames",
@@ -400,23 +445,79 @@ void Opl::AudioCallback(const uint16_t requested_frames)
 		        fifo.size());
 	}
 #endif
-	auto frames_remaining = requested_frames;
+	callback_buffer.clear();
 
 	// First, send any frames we've queued since the last callback
-	while (frames_remaining && fifo.size()) {
-		channel->AddSamples_sfloat(1, &fifo.front()[0]);
+	while (callback_buffer.size() < requested_frames && fifo.size()) {
+		callback_buffer.emplace_back(fifo.front());
 		fifo.pop();
-		--frames_remaining;
 	}
 	// If the queue's run dry, render the remainder and sync-up our time datum
-	while (frames_remaining) {
-		const auto frame = RenderFrame();
-		channel->AddSamples_sfloat(1, &frame[0]);
-		--frames_remaining;
+	if (const auto frames_remaining = requested_frames - callback_buffer.size();
+	    frames_remaining > 0) {
+		const auto& frames = RenderFrames(check_cast<int>(frames_remaining));
+		callback_buffer.insert(callback_buffer.end(), frames.begin(), frames.end());
 	}
+	channel->AddSamples_sfloat(requested_frames, &callback_buffer[0][0]);
+
 	last_rendered_ms = PIC_FullIndex();
 }
 
+void Opl::StartRenderThread()
+{
+	const auto render = [this](const int num_frames,
+	                           std::vector<AudioFrame>& out) {
+		const auto& frames = RenderFrames(num_frames);
+		out.insert(out.end(), frames.begin(), frames.end());
+	};
+	const auto apply_work = std::bind(&Opl::ApplyWork,
+	                                  this,
+	                                  std::placeholders::_1);
+
+	renderer = std::make_unique<ChipRenderer<OplWork>>(ms_per_frame,
+	                                                   ms_per_frame,
+	                                                   render,
+	                                                   apply_work);
+
+	// Render ahead by the mixer's prebuffer so the frames are ready by
+	// the time the mixer asks for them
+	const auto frames_per_ms = iround(OplSampleRateHz / millis_in_second);
+	const auto render_ahead_frames =
+	        std::max(static_cast<int>(MIXER_GetPreBufferMs()), 1) * frames_per_ms;
+
+	// Games write a few hundred registers per millisecond at most when
+	// they set up all the voices at once
+	constexpr auto MaxQueuedWrites = 4096;
+
+	renderer->Start(render_ahead_frames, MaxQueuedWrites);
+	set_thread_name(renderer->GetThread(), "dosbox:opl");
+}
+
+void Opl::StopRenderThread()
+{
+	// Waits for the render thread to finish
+	renderer.reset();
+}
+
+void Opl::EnqueueWork(const OplWork::Type type, const io_port_t reg,
+                      const uint8_t val)
+{
+	assert(renderer);
+	renderer->AddWrite(PIC_FullIndex(), {type, reg, val});
+}
+
+void Opl::ApplyWork(const OplWork& work)
+{
+	switch (work.type) {
+	case OplWork::Type::Register:
+		ApplyRegisterWrite(work.reg, work.val);
+		break;
+	case OplWork::Type::AdlibGoldControl:
+		ApplyAdlibGoldControlWrite(check_cast<uint8_t>(work.reg), work.val);
+		break;
+	}
+}
+
 void Opl::CacheWrite(const io_port_t port, const uint8_t val)
 {
 	// capturing?
@@ -460,6 +561,37 @@ void Opl::DualWrite(const uint8_t index, const uint8_t port, const uint8_t value
 void Opl::AdlibGoldControlWrite(const uint8_t val)
 {
 	switch (ctrl.index) {
+	case 0x09: // Left FM Volume
+		ctrl.lvol = val;
+		goto setvol;
+
+	case 0x0a: // Right FM Volume
+		ctrl.rvol = val;
+
+	setvol:
+		if (ctrl.mixer) {
+			// Dune CD version uses 32 volume steps in an apparent
+			// mistake, should be 128
+			channel->SetAppVolume(
+			        {static_cast<float>(ctrl.lvol & 0x1f) / 31.0f,
+			         static_cast<float>(ctrl.rvol & 0x1f) / 31.0f});
+		}
+		break;
+
+	default:
+		// The stereo and surround processors are part of the render
+		// path, so they get written in step with the OPL registers
+		if (renderer) {
+			EnqueueWork(OplWork::Type::AdlibGoldControl, ctrl.index, val);
+		} else {
+			ApplyAdlibGoldControlWrite(ctrl.index, val);
+		}
+	}
+}
+
+void Opl::ApplyAdlibGoldControlWrite(const uint8_t index, const uint8_t val)
+{
+	switch (index) {
 	case 0x04:
 		adlib_gold->StereoControlWrite(StereoProcessorControlReg::VolumeLeft,
 		                               val);
@@ -481,23 +613,6 @@ void Opl::AdlibGoldControlWrite(const uint8_t val)
 		                               val);
 		break;
 
-	case 0x09: // Left FM Volume
-		ctrl.lvol = val;
-		goto setvol;
-
-	case 0x0a: // Right FM Volume
-		ctrl.rvol = val;
-
-	setvol:
-		if (ctrl.mixer) {
-			// Dune CD version uses 32 volume steps in an apparent
-			// mistake, should be 128
-			channel->SetAppVolume(
-			        {static_cast<float>(ctrl.lvol & 0x1f) / 31.0f,
-			         static_cast<float>(ctrl.rvol & 0x1f) / 31.0f});
-		}
-		break;
-
 	case 0x18: // Surround
 		adlib_gold->SurroundControlWrite(val);
 	}
@@ -818,6 +933,10 @@ Opl::Opl(Section* configuration, const OplMode _opl_mode)
 
 	Init();
 
+	if (opl.mode != OplMode::Esfm) {
+		StartRenderThread();
+	}
+
 	using namespace std::placeholders;
 
 	const auto read_from = std::bind(&Opl::PortRead, this, _1, _2);
@@ -865,6 +984,8 @@ Opl::~Opl()
 		wh.Uninstall();
 	}
 
+	StopRenderThread();
+
 	// Deregister the mixer channel, after which it's cleaned up
 	assert(channel);
 	MIXER_DeregisterChannel(channel);
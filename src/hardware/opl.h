@@ -24,8 +24,10 @@
 #include <cmath>
 #include <memory>
 #include <queue>
+#include <vector>
 
 #include "adlib_gold.h"
+#include "chip_renderer.h"
 #include "hardware.h"
 #include "inout.h"
 #include "mixer.h"
@@ -97,6 +99,15 @@ class OplCapture;
 
 enum class EsfmMode { Legacy, Native };
 
+// A write for the render thread to apply
+struct OplWork {
+	enum class Type : uint8_t { Register, AdlibGoldControl };
+
+	Type type     = Type::Register;
+	io_port_t reg = 0;
+	uint8_t val   = 0;
+};
+
 class Opl {
 public:
 	mixer_channel_t channel = {};
@@ -120,6 +131,17 @@ private:
 
 	std::queue<AudioFrame> fifo = {};
 
+	// The Nuked OPL3 modes render on their own thread. ESFM reads its
+	// registers back on the emulation thread, so it keeps rendering
+	// synchronously.
+	std::unique_ptr<ChipRenderer<OplWork>> renderer = {};
+
+	// Chip output and the processed frames of the last RenderFrames()
+	std::vector<int16_t> raw_buffer       = {};
+	std::vector<AudioFrame> render_buffer = {};
+
+	std::vector<AudioFrame> callback_buffer = {};
+
 	OplChip chip[2]  = {};
 
 	struct {
@@ -160,9 +182,15 @@ private:
 	void Init();
 
 	void AudioCallback(const uint16_t frames);
-	AudioFrame RenderFrame();
+	const std::vector<AudioFrame>& RenderFrames(const int num_frames);
 	void RenderUpToNow();
 
+	void StartRenderThread();
+	void StopRenderThread();
+	void EnqueueWork(const OplWork::Type type, const io_port_t reg,
+	                 const uint8_t val);
+	void ApplyWork(const OplWork& work);
+
 	void PortWrite(const io_port_t port, const io_val_t value,
 	               const io_width_t width);
 
@@ -170,10 +198,12 @@ private:
 
 	io_port_t WriteAddr(const io_port_t port, const uint8_t val);
 	void WriteReg(const io_port_t selected_reg, const uint8_t val);
+	void ApplyRegisterWrite(const io_port_t selected_reg, const uint8_t val);
 	void CacheWrite(const io_port_t port, const uint8_t val);
 	void DualWrite(const uint8_t index, const uint8_t reg, const uint8_t value);
 
 	void AdlibGoldControlWrite(const uint8_t val);
+	void ApplyAdlibGoldControlWrite(const uint8_t index, const uint8_t val);
 	uint8_t AdlibGoldControlRead(void);
 
 	void EsfmSetLegacyMode();
@@ -47,7 +47,7 @@ bool OplCapture::DoWrite(const io_port_t reg_full, const uint8_t val)
 
 	// Check the raw index for this register if we actually have to
 	// save it
-	if (handle) {
+	if (writer.IsOpen()) {
 		// Check if we actually care for this to be logged,
 		// else just ignore it
 		uint8_t raw = to_raw[reg_mask];
@@ -103,18 +103,19 @@ skipWrite:
 		return true;
 	}
 
-	handle = CAPTURE_CreateFile(CaptureType::RawOplStream);
+	const auto handle = CAPTURE_CreateFile(CaptureType::RawOplStream);
 	if (!handle) {
 		return false;
 	}
+	writer.Open(handle);
 
 	InitHeader();
 
 	// Prepare space at start of the file for the header
-	fwrite(&header, 1, sizeof(header), handle);
+	writer.Write(&header, sizeof(header));
 
 	// Write the Raw To Reg table
-	fwrite(&to_reg, 1, raw_used, handle);
+	writer.Write(&to_reg, raw_used);
 
 	// Write the cache of last commands
 	WriteCache();
@@ -203,7 +204,7 @@ void OplCapture::MakeTables()
 
 void OplCapture::ClearBuf()
 {
-	fwrite(buf, 1, bufUsed, handle);
+	writer.Write(buf, bufUsed);
 	header.commands += bufUsed / 2;
 	bufUsed = 0;
 }
@@ -291,7 +292,7 @@ void OplCapture::InitHeader()
 
 void OplCapture::CloseFile()
 {
-	if (handle) {
+	if (writer.IsOpen()) {
 		ClearBuf();
 
 		// Endianise the header and write it to beginning of the
@@ -301,11 +302,11 @@ void OplCapture::CloseFile()
 		header.commands     = host_to_le(header.commands);
 		header.milliseconds = host_to_le(header.milliseconds);
 
+		const auto handle = writer.Close();
+
 		fseek(handle, 0, SEEK_SET);
 		fwrite(&header, 1, sizeof(header), handle);
 		fclose(handle);
-
-		handle = nullptr;
 	}
 }
 
@@ -21,6 +21,7 @@
 
 #include "dosbox.h"
 
+#include "../capture/capture_writer.h"
 #include "inout.h"
 #include "opl.h"
 
@@ -99,8 +100,8 @@ private:
 
 	DroRawHeader header;
 
-	// File used for writing
-	FILE* handle = nullptr;
+	// Buffers the capture and writes it out on its own thread
+	CaptureWriter writer = {};
 
 	// Start used to check total raw length on end
 	uint32_t startTicks = 0;
@@ -27,6 +27,7 @@
 #include <limits>
 
 #include "checks.h"
+#include "tracy.h"
 
 CHECK_NARROWING();
 
@@ -341,6 +342,7 @@ void PcSpeakerDiscrete::SetType(const PpiPortB &b)
 
 void PcSpeakerDiscrete::ChannelCallback(const uint16_t frames)
 {
+	ZoneScoped;
 	constexpr uint16_t render_frames = 64;
 	float buf[render_frames];
 
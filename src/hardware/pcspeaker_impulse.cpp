@@ -25,8 +25,11 @@
 
 #include "pcspeaker_impulse.h"
 
+#include <algorithm>
+
 #include "checks.h"
 #include "math_utils.h"
+#include "tracy.h"
 
 CHECK_NARROWING();
 
@@ -415,60 +418,70 @@ void PcSpeakerImpulse::AddImpulse(float index, const int16_t amplitude)
 		phase = sinc_oversampling_factor - phase;
 	}
 
+	assert(offset + sinc_filter_quality <= waveform_size);
+	auto wave = waveform.data() + offset;
+
+	const auto impulse = impulse_lut.data() + phase * sinc_filter_quality;
+	const auto scalar  = static_cast<float>(amplitude);
+
 	for (uint16_t i = 0; i < sinc_filter_quality; ++i) {
-		const auto wave_i    = check_cast<uint16_t>(offset + i);
-		const auto impulse_i = check_cast<uint16_t>(
-		        phase + i * sinc_oversampling_factor);
-		waveform_deque.at(wave_i) += amplitude * impulse_lut.at(impulse_i);
+		wave[i] += scalar * impulse[i];
 	}
 }
 
 #else
 	// Mathematically intensive reference implementation
 	const auto portion_of_ms = static_cast <double>(index) / millis_in_second;
-	for (size_t i = 0; i < waveform_deque.size(); ++i) {
+	for (size_t i = 0; i < waveform.size(); ++i) {
 		const auto impulse_time = static_cast<double>(i) / sample_rate_hz -
 		                          portion_of_ms;
 
-		waveform_deque[i] += amplitude * CalcImpulse(impulse_time);
+		waveform[i] += amplitude * CalcImpulse(impulse_time);
 	}
 }
 #endif
 
 void PcSpeakerImpulse::ChannelCallback(uint16_t requested_frames)
 {
+	ZoneScoped;
 	ForwardPIT(1.0f);
 	pit.last_index = 0;
 
 	static float accumulator = 0;
-	while (requested_frames > 0 && waveform_deque.size()) {
-		// Pop the first sample off the waveform
-		accumulator += waveform_deque.front();
-		waveform_deque.pop_front();
-		waveform_deque.push_back(0.0f);
-
-		// Pass the sample to the mixer and decrement the requested frames
-		channel->AddSamples_mfloat(1, &accumulator);
-		--requested_frames;
-
-		// Keep a tally of sequential silence so we can sleep the channel
-		tally_of_silence = fabsf(accumulator) > 1.0f
-		                         ? 0
-		                         : tally_of_silence + 1;
-
-		// Scale down the running volume amplitude. Eventually it will
-		// hit 0 if no other waveforms are generated.
-		accumulator *= sinc_amplitude_fade;
-	}
 
-	// Write silence if the waveform deque ran out
-	if (requested_frames)
-		pit.prev_amplitude = neutral_amplitude;
+	frames.resize(requested_frames);
+	auto frame = frames.begin();
+
+	while (frame != frames.end()) {
+		// Take samples off the front of the waveform, then move the rest
+		// up and pad the end with silence
+		const auto num_samples = std::min(
+		        static_cast<size_t>(frames.end() - frame), waveform.size());
+
+		for (size_t i = 0; i < num_samples; ++i) {
+			accumulator += waveform[i];
+			*frame++ = accumulator;
 
-	while (requested_frames) {
-		channel->AddSamples_m16(1, &neutral_amplitude);
-		++tally_of_silence;
-		--requested_frames;
+			// Keep a tally of sequential silence so we can sleep the
+			// channel
+			tally_of_silence = fabsf(accumulator) > 1.0f
+			                         ? 0
+			                         : tally_of_silence + 1;
+
+			// Scale down the running volume amplitude. Eventually it
+			// will hit 0 if no other waveforms are generated.
+			accumulator *= sinc_amplitude_fade;
+		}
+
+		std::copy(waveform.begin() + num_samples,
+		          waveform.end(),
+		          waveform.begin());
+		std::fill(waveform.end() - num_samples, waveform.end(), 0.0f);
+	}
+
+	// Pass the samples to the mixer in one go
+	if (requested_frames) {
+		channel->AddSamples_mfloat(requested_frames, frames.data());
 	}
 }
 
@@ -476,9 +489,15 @@ void PcSpeakerImpulse::InitializeImpulseLUT()
 {
 	assert(impulse_lut.size() == sinc_filter_width);
 
+	// Group the oversampled impulse by phase, so each phase's taps are
+	// every sinc_oversampling_factor'th point of the impulse
 	for (auto i = 0u; i < sinc_filter_width; ++i) {
-		impulse_lut[i] = CalcImpulse(i / (static_cast<double>(sample_rate_hz) *
-		                                  sinc_oversampling_factor));
+		const auto phase = i % sinc_oversampling_factor;
+		const auto tap   = i / sinc_oversampling_factor;
+
+		impulse_lut[phase * sinc_filter_quality + tap] = CalcImpulse(
+		        i / (static_cast<double>(sample_rate_hz) *
+		             sinc_oversampling_factor));
 	}
 }
 
@@ -525,10 +544,6 @@ PcSpeakerImpulse::PcSpeakerImpulse()
 
 	InitializeImpulseLUT();
 
-	// Size the waveform queue
-	constexpr auto waveform_size = sinc_filter_quality + sample_rate_per_ms;
-	waveform_deque.resize(waveform_size, 0.0f);
-
 	// Register the sound channel
 	const auto callback = std::bind(&PcSpeakerImpulse::ChannelCallback,
 	                                this,
@@ -21,8 +21,8 @@
 #include "pcspeaker.h"
 
 #include <array>
-#include <deque>
 #include <string>
+#include <vector>
 
 #include "channel_names.h"
 #include "inout.h"
@@ -84,6 +84,10 @@ private:
 	static constexpr uint16_t sinc_filter_width = sinc_filter_quality *
 	                                              sinc_oversampling_factor;
 
+	// Room for a full impulse starting anywhere within the next millisecond
+	static constexpr uint16_t waveform_size = sinc_filter_quality +
+	                                          sample_rate_per_ms;
+
 	static constexpr float max_possible_pit_ms = 1320000.0f / PIT_TICK_RATE;
 
 	// Compound types and containers
@@ -109,10 +113,15 @@ private:
 		int16_t prev_amplitude = negative_amplitude;
 	} pit = {};
 
-	std::deque<float> waveform_deque = {};
+	// Upcoming samples, with the next one to play at the front
+	std::array<float, waveform_size> waveform = {};
 
+	// Impulses by phase, each holding its sinc_filter_quality taps in
+	// sequence so they can be added to the waveform in a single run
 	std::array<float, sinc_filter_width> impulse_lut = {};
 
+	std::vector<float> frames = {};
+
 	mixer_channel_t channel = nullptr;
 
 	PpiPortB prev_port_b = {};
@@ -20,9 +20,12 @@
 #include "inout.h"
 #include "cpu.h"
 #include "callback.h"
+#include "event_counters.h"
 #include "pic.h"
 #include "timer.h"
+#include "savestate.h"
 #include "setup.h"
+#include "tracy.h"
 
 // PIC Controllers
 // ~~~~~~~~~~~~~~~
@@ -190,17 +193,37 @@ void PIC_Controller::start_irq(uint8_t val) {
 }
 
 
+// Scheduled events live in a fixed pool and are ordered by a binary min-heap
+// of pool slot numbers, so adding, running and cancelling a single event are
+// all O(log n) regardless of how many devices keep timers in flight.
+//
+// Events due at the same index run in the order they were added (same as the
+// sorted list this replaced), which is what the 'order' sequence number is for.
+//
+// PIC_AddEvent returns a handle made of the slot number and a per-slot
+// generation count, so a stale handle never cancels a recycled slot.
+
+constexpr uint32_t PIC_EventSlotBits = 9;
+static_assert(PIC_QUEUESIZE == (1 << PIC_EventSlotBits));
+
+constexpr uint16_t PIC_NotQueued = UINT16_MAX;
+
 struct PICEntry {
 	double index;
-	Bitu value;
+	uint64_t order;
+	uint32_t value;
+	uint32_t generation;
 	PIC_EventHandler pic_event;
-	PICEntry * next;
+	uint16_t heap_pos;
 };
 
 static struct {
 	PICEntry entries[PIC_QUEUESIZE];
-	PICEntry * free_entry;
-	PICEntry * next_entry;
+	uint16_t heap[PIC_QUEUESIZE];
+	uint16_t free_slots[PIC_QUEUESIZE];
+	uint16_t num_queued;
+	uint16_t num_free;
+	uint64_t next_order;
 } pic_queue;
 
 static void write_command(io_port_t port, io_val_t value, io_width_t)
@@ -422,115 +445,225 @@ void PIC_SetIRQMask(uint32_t irq, bool masked)
 	pic->set_imr(newmask);
 }
 
-static void AddEntry(PICEntry * entry) {
-	PICEntry * find_entry=pic_queue.next_entry;
-	if (find_entry == nullptr) {
-		entry->next=nullptr;
-		pic_queue.next_entry=entry;
-	} else if (find_entry->index > entry->index) {
-		pic_queue.next_entry=entry;
-		entry->next=find_entry;
-	} else {
-		while (find_entry) {
-			if (find_entry->next) {
-				/* See if the next index comes later than this
-				 * one */
-				if (find_entry->next->index > entry->index) {
-					entry->next      = find_entry->next;
-					find_entry->next = entry;
-					break;
-				} else {
-					find_entry = find_entry->next;
-				}
-			} else {
-				entry->next      = find_entry->next;
-				find_entry->next = entry;
-				break;
-			}
+static bool RunsBefore(const uint16_t a, const uint16_t b)
+{
+	const auto& entry_a = pic_queue.entries[a];
+	const auto& entry_b = pic_queue.entries[b];
+	if (entry_a.index != entry_b.index) {
+		return entry_a.index < entry_b.index;
+	}
+	return entry_a.order < entry_b.order;
+}
+
+static void PlaceEntry(const uint16_t pos, const uint16_t slot)
+{
+	pic_queue.heap[pos]              = slot;
+	pic_queue.entries[slot].heap_pos = pos;
+}
+
+static void SiftUp(uint16_t pos)
+{
+	const auto slot = pic_queue.heap[pos];
+	while (pos > 0) {
+		const uint16_t parent = (pos - 1) / 2;
+		if (!RunsBefore(slot, pic_queue.heap[parent])) {
+			break;
+		}
+		PlaceEntry(pos, pic_queue.heap[parent]);
+		pos = parent;
+	}
+	PlaceEntry(pos, slot);
+}
+
+static void SiftDown(uint16_t pos)
+{
+	const auto slot = pic_queue.heap[pos];
+	const auto num  = pic_queue.num_queued;
+	for (;;) {
+		auto child = static_cast<uint16_t>(pos * 2 + 1);
+		if (child >= num) {
+			break;
+		}
+		if (child + 1 < num &&
+		    RunsBefore(pic_queue.heap[child + 1], pic_queue.heap[child])) {
+			++child;
 		}
+		if (!RunsBefore(pic_queue.heap[child], slot)) {
+			break;
+		}
+		PlaceEntry(pos, pic_queue.heap[child]);
+		pos = child;
 	}
-	Bits cycles=PIC_MakeCycles(pic_queue.next_entry->index-PIC_TickIndex());
+	PlaceEntry(pos, slot);
+}
+
+static PICEntry* NextEntry()
+{
+	return pic_queue.num_queued ? &pic_queue.entries[pic_queue.heap[0]]
+	                            : nullptr;
+}
+
+static void FreeEntry(const uint16_t slot)
+{
+	auto& entry    = pic_queue.entries[slot];
+	entry.heap_pos = PIC_NotQueued;
+	++entry.generation;
+	pic_queue.free_slots[pic_queue.num_free++] = slot;
+}
+
+// Takes the entry at the given heap position out of the queue, the caller is
+// responsible for freeing it
+static uint16_t UnqueueEntry(const uint16_t pos)
+{
+	assert(pos < pic_queue.num_queued);
+	const auto slot = pic_queue.heap[pos];
+	const auto last = --pic_queue.num_queued;
+	if (pos != last) {
+		PlaceEntry(pos, pic_queue.heap[last]);
+		const uint16_t parent = (pos - 1) / 2;
+		if (pos > 0 && RunsBefore(pic_queue.heap[pos], pic_queue.heap[parent])) {
+			SiftUp(pos);
+		} else {
+			SiftDown(pos);
+		}
+	}
+	pic_queue.entries[slot].heap_pos = PIC_NotQueued;
+	return slot;
+}
+
+static void AddEntry(const uint16_t slot)
+{
+	const auto pos = pic_queue.num_queued++;
+	PlaceEntry(pos, slot);
+	SiftUp(pos);
+
+	Bits cycles=PIC_MakeCycles(NextEntry()->index-PIC_TickIndex());
 	if (cycles<CPU_Cycles) {
 		CPU_CycleLeft+=CPU_Cycles;
 		CPU_Cycles=0;
 	}
 }
+
+// Drops every queued entry matching the predicate and restores the heap
+// property in a single linear pass
+template <typename Predicate>
+static void RemoveEntriesIf(Predicate matches)
+{
+	uint16_t kept = 0;
+	for (uint16_t pos = 0; pos < pic_queue.num_queued; ++pos) {
+		const auto slot = pic_queue.heap[pos];
+		if (matches(pic_queue.entries[slot])) {
+			FreeEntry(slot);
+		} else {
+			PlaceEntry(kept++, slot);
+		}
+	}
+	if (kept == pic_queue.num_queued) {
+		return;
+	}
+	pic_queue.num_queued = kept;
+	for (auto pos = kept / 2; pos-- > 0;) {
+		SiftDown(static_cast<uint16_t>(pos));
+	}
+}
+
 static bool InEventService = false;
 static double srv_lag = 0.0;
 
-void PIC_AddEvent(PIC_EventHandler handler, double delay, uint32_t val)
+// The cycles of the current tick that belong to slices not yet released,
+// PIC_RunQueue doesn't hand these out to the CPU core
+static struct {
+	int32_t cycles_held = 0;
+	int num_slices      = 1;
+	int slices_left     = 0;
+} tick_slices = {};
+
+static void HoldTickSliceCycles()
+{
+	tick_slices.cycles_held = static_cast<int32_t>(
+	        static_cast<int64_t>(CPU_CycleMax) * tick_slices.slices_left /
+	        tick_slices.num_slices);
+}
+
+void PIC_SetTickSlices(const int num_slices)
 {
-	if (!pic_queue.free_entry) {
+	assert(num_slices >= 1);
+	tick_slices.num_slices  = num_slices;
+	tick_slices.slices_left = 0;
+	tick_slices.cycles_held = 0;
+}
+
+bool PIC_NextTickSlice()
+{
+	if (tick_slices.slices_left == 0) {
+		return false;
+	}
+	--tick_slices.slices_left;
+	HoldTickSliceCycles();
+	return true;
+}
+
+PIC_EventId PIC_AddEvent(PIC_EventHandler handler, double delay, uint32_t val)
+{
+	if (!pic_queue.num_free) {
 		LOG(LOG_PIC,LOG_ERROR)("Event queue full");
-		return;
+		return PIC_NoEvent;
+	}
+	const auto slot = pic_queue.free_slots[--pic_queue.num_free];
+	auto& entry     = pic_queue.entries[slot];
+	if(InEventService) entry.index = delay + srv_lag;
+	else entry.index = delay + PIC_TickIndex();
+
+	entry.order     = pic_queue.next_order++;
+	entry.pic_event = handler;
+	entry.value     = val;
+	AddEntry(slot);
+
+	// slot 0 in generation 0 would collide with PIC_NoEvent
+	if (slot == 0 && (entry.generation << PIC_EventSlotBits) == 0) {
+		++entry.generation;
 	}
-	PICEntry * entry=pic_queue.free_entry;
-	if(InEventService) entry->index = delay + srv_lag;
-	else entry->index = delay + PIC_TickIndex();
+	return (entry.generation << PIC_EventSlotBits) | slot;
+}
 
-	entry->pic_event=handler;
-	entry->value=val;
-	pic_queue.free_entry=pic_queue.free_entry->next;
-	AddEntry(entry);
+bool PIC_RemoveEvent(const PIC_EventId id)
+{
+	if (id == PIC_NoEvent) {
+		return false;
+	}
+	const uint16_t slot = id & (PIC_QUEUESIZE - 1);
+	const auto& entry   = pic_queue.entries[slot];
+	if (entry.heap_pos == PIC_NotQueued ||
+	    (entry.generation << PIC_EventSlotBits) != (id & ~(PIC_QUEUESIZE - 1))) {
+		return false;
+	}
+	FreeEntry(UnqueueEntry(entry.heap_pos));
+	return true;
 }
 
 void PIC_RemoveSpecificEvents(PIC_EventHandler handler, uint32_t val)
 {
-	PICEntry *entry = pic_queue.next_entry;
-	PICEntry *prev_entry;
-	prev_entry = nullptr;
-	while (entry) {
-		if ((entry->pic_event == handler) && (entry->value == val)) {
-			if (prev_entry) {
-				prev_entry->next=entry->next;
-				entry->next=pic_queue.free_entry;
-				pic_queue.free_entry=entry;
-				entry=prev_entry->next;
-				continue;
-			} else {
-				pic_queue.next_entry=entry->next;
-				entry->next=pic_queue.free_entry;
-				pic_queue.free_entry=entry;
-				entry=pic_queue.next_entry;
-				continue;
-			}
-		}
-		prev_entry=entry;
-		entry=entry->next;
-	}
-}
-
-void PIC_RemoveEvents(PIC_EventHandler handler) {
-	PICEntry * entry=pic_queue.next_entry;
-	PICEntry * prev_entry;
-	prev_entry=nullptr;
-	while (entry) {
-		if (entry->pic_event == handler) {
-			if (prev_entry) {
-				prev_entry->next=entry->next;
-				entry->next=pic_queue.free_entry;
-				pic_queue.free_entry=entry;
-				entry=prev_entry->next;
-				continue;
-			} else {
-				pic_queue.next_entry=entry->next;
-				entry->next=pic_queue.free_entry;
-				pic_queue.free_entry=entry;
-				entry=pic_queue.next_entry;
-				continue;
-			}
-		}
-		prev_entry=entry;
-		entry=entry->next;
-	}
+	RemoveEntriesIf([=](const PICEntry& entry) {
+		return entry.pic_event == handler && entry.value == val;
+	});
+}
+
+void PIC_RemoveEvents(PIC_EventHandler handler)
+{
+	RemoveEntriesIf([=](const PICEntry& entry) {
+		return entry.pic_event == handler;
+	});
 }
 
 
+static EventCounter pic_events("PIC events");
+
 bool PIC_RunQueue(void) {
+	ZoneScoped;
 	/* Check to see if a new millisecond needs to be started */
 	CPU_CycleLeft+=CPU_Cycles;
 	CPU_Cycles=0;
-	if (CPU_CycleLeft<=0) {
+	if (CPU_CycleLeft <= tick_slices.cycles_held) {
 		return false;
 	}
 
@@ -538,34 +671,35 @@ bool PIC_RunQueue(void) {
 
 	/* Check the queue for an entry */
 	InEventService = true;
-	while (pic_queue.next_entry &&
-	       (pic_queue.next_entry->index * static_cast<double>(CPU_CycleMax) <= index_nd_f)) {
-		PICEntry *entry = pic_queue.next_entry;
-		pic_queue.next_entry = entry->next;
+	while (NextEntry() &&
+	       (NextEntry()->index * static_cast<double>(CPU_CycleMax) <= index_nd_f)) {
+		const auto slot   = UnqueueEntry(0);
+		const auto& entry = pic_queue.entries[slot];
 
-		srv_lag = entry->index;
-		(entry->pic_event)(entry->value); // call the event handler
+		srv_lag = entry.index;
+		(entry.pic_event)(entry.value); // call the event handler
+		pic_events.Add();
 
-		/* Put the entry in the free list */
-		entry->next=pic_queue.free_entry;
-		pic_queue.free_entry=entry;
+		/* Put the entry back into the pool */
+		FreeEntry(slot);
 	}
 	InEventService = false;
 
 	/* Check when to set the new cycle end */
-	if (pic_queue.next_entry) {
+	const auto slice_cycles_left = CPU_CycleLeft - tick_slices.cycles_held;
+	if (const auto next_entry = NextEntry(); next_entry) {
 		auto cycles = static_cast<int32_t>(
-		        pic_queue.next_entry->index * static_cast<double>(CPU_CycleMax) -
+		        next_entry->index * static_cast<double>(CPU_CycleMax) -
 		        index_nd_f);
 		if (!cycles) {
 			cycles = 1;
 		}
-		if (cycles < CPU_CycleLeft) {
+		if (cycles < slice_cycles_left) {
 			CPU_Cycles = cycles;
 		} else {
-			CPU_Cycles=CPU_CycleLeft;
+			CPU_Cycles = slice_cycles_left;
 		}
-	} else CPU_Cycles=CPU_CycleLeft;
+	} else CPU_Cycles = slice_cycles_left;
 	CPU_CycleLeft-=CPU_Cycles;
 	if (PIC_IRQCheck) PIC_runIRQs();
 	return true;
@@ -606,11 +740,12 @@ void TIMER_AddTick(void) {
 	CPU_CycleLeft=CPU_CycleMax;
 	CPU_Cycles=0;
 	PIC_Ticks++;
-	/* Go through the list of scheduled events and lower their index with 1000 */
-	PICEntry * entry=pic_queue.next_entry;
-	while (entry) {
-		entry->index -= 1.0f;
-		entry=entry->next;
+	tick_slices.slices_left = tick_slices.num_slices - 1;
+	HoldTickSliceCycles();
+	/* Go through the scheduled events and lower their index with 1000,
+	 * this shifts all of them equally so the heap order is kept */
+	for (uint16_t pos = 0; pos < pic_queue.num_queued; ++pos) {
+		pic_queue.entries[pic_queue.heap[pos]].index -= 1.0;
 	}
 	/* Call our list of ticker handlers */
 	TickerBlock * ticker=firstticker;
@@ -674,12 +809,15 @@ public:
 		WriteHandler[2].Install(0xa0, write_command, io_width_t::byte);
 		WriteHandler[3].Install(0xa1, write_data, io_width_t::byte);
 		/* Initialize the pic queue */
-		for (i=0;i<PIC_QUEUESIZE-1;i++) {
-			pic_queue.entries[i].next=&pic_queue.entries[i+1];
+		pic_queue.num_queued = 0;
+		pic_queue.num_free   = 0;
+		pic_queue.next_order = 0;
+		// hand out the low slots first, like the old free list did
+		for (i = PIC_QUEUESIZE; i-- > 0;) {
+			pic_queue.entries[i].heap_pos = PIC_NotQueued;
+			pic_queue.free_slots[pic_queue.num_free++] =
+			        static_cast<uint16_t>(i);
 		}
-		pic_queue.entries[PIC_QUEUESIZE-1].next=nullptr;
-		pic_queue.free_entry=&pic_queue.entries[0];
-		pic_queue.next_entry=nullptr;
 	}
 
 	~PIC_8259A(){
@@ -688,11 +826,35 @@ public:
 
 static PIC_8259A* test;
 
+// The queued events point at their handlers, which stay put within the
+// session
+static void save_pic_state(SaveStateWriter& writer)
+{
+	writer.Write(pics);
+	writer.Write(pic_queue);
+	writer.Write(tick_slices);
+	writer.Write(PIC_Ticks);
+	writer.Write(PIC_IRQCheck);
+	writer.Write(srv_lag);
+}
+
+static void load_pic_state(SaveStateReader& reader)
+{
+	reader.Read(pics);
+	reader.Read(pic_queue);
+	reader.Read(tick_slices);
+	reader.Read(PIC_Ticks);
+	reader.Read(PIC_IRQCheck);
+	reader.Read(srv_lag);
+}
+
 void PIC_Destroy(Section* /*sec*/){
+	SAVESTATE_RemoveComponent("PIC");
 	delete test;
 }
 
 void PIC_Init(Section* sec) {
 	test = new PIC_8259A(sec);
 	sec->AddDestroyFunction(&PIC_Destroy);
+	SAVESTATE_AddComponent("PIC", save_pic_state, load_pic_state);
 }
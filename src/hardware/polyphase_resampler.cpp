@@ -0,0 +1,260 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "polyphase_resampler.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <utility>
+
+#include "audio_frame.h"
+#include "checks.h"
+#include "math_utils.h"
+
+CHECK_NARROWING();
+
+// Filter taps per phase; a multiple of the lane size
+constexpr int NumTaps  = 48;
+constexpr int LaneSize = 8;
+static_assert(NumTaps % LaneSize == 0);
+
+// Ratios needing more phases than this interpolate between them
+constexpr uint32_t MaxPhases = 1024;
+
+// The Kaiser window's beta gives about 80 dB of stopband attenuation with
+// this many taps; the cutoff leaves room for the transition band below the
+// Nyquist frequency
+constexpr double KaiserBeta = 8.0;
+constexpr double Rolloff    = 0.89;
+
+struct PolyphaseResampler::FilterBank {
+	// The ratio of the output to the input rate, in lowest terms
+	uint32_t up   = 0;
+	uint32_t down = 0;
+
+	uint32_t num_phases = 0;
+	bool interpolate    = false;
+
+	// One filter for each phase plus one for a full frame of delay, so
+	// the last phase has a neighbour to interpolate with
+	std::vector<float> coeffs = {};
+
+	const float* GetPhase(const uint32_t phase) const
+	{
+		assert(phase <= num_phases);
+		return coeffs.data() + static_cast<size_t>(phase) * NumTaps;
+	}
+};
+
+// Modified Bessel function of the first kind, order zero
+static double bessel_i0(const double x)
+{
+	const auto quarter_x_squared = x * x / 4.0;
+
+	auto sum  = 1.0;
+	auto term = 1.0;
+	for (auto k = 1; k < 64 && term > sum * 1e-12; ++k) {
+		term *= quarter_x_squared / (k * k);
+		sum += term;
+	}
+	return sum;
+}
+
+static std::shared_ptr<const PolyphaseResampler::FilterBank> create_filter_bank(
+        const uint32_t up, const uint32_t down)
+{
+	auto bank  = std::make_shared<PolyphaseResampler::FilterBank>();
+	bank->up   = up;
+	bank->down = down;
+
+	bank->num_phases  = std::min(up, MaxPhases);
+	bank->interpolate = (bank->num_phases != up);
+
+	// Relative to the input's Nyquist frequency; when downsampling, the
+	// output's Nyquist frequency is lower
+	const auto cutoff = Rolloff * std::min(1.0, static_cast<double>(up) / down);
+
+	constexpr auto half_length = NumTaps / 2.0;
+	const auto window_scale    = 1.0 / bessel_i0(KaiserBeta);
+
+	bank->coeffs.resize(static_cast<size_t>(bank->num_phases + 1) * NumTaps);
+
+	for (uint32_t p = 0; p <= bank->num_phases; ++p) {
+		const auto offset = static_cast<double>(p) / bank->num_phases;
+
+		double coeffs[NumTaps] = {};
+		double sum             = 0.0;
+
+		for (auto k = 0; k < NumTaps; ++k) {
+			// Distance from the output frame to this input frame
+			const auto x = k - (half_length - 1.0) - offset;
+
+			const auto w = x / half_length;
+			const auto window = (std::fabs(w) >= 1.0)
+			                          ? 0.0
+			                          : bessel_i0(KaiserBeta *
+			                                      std::sqrt(1.0 - w * w)) *
+			                                    window_scale;
+
+			const auto t    = M_PI * cutoff * x;
+			const auto sinc = (x == 0.0) ? 1.0 : std::sin(t) / t;
+
+			coeffs[k] = cutoff * sinc * window;
+			sum += coeffs[k];
+		}
+
+		// Normalise each phase for unity gain at DC, so there's no
+		// ripple at the phase rate
+		auto out = bank->coeffs.begin() + static_cast<ptrdiff_t>(p) * NumTaps;
+		for (auto k = 0; k < NumTaps; ++k) {
+			*out++ = static_cast<float>(coeffs[k] / sum);
+		}
+	}
+	return bank;
+}
+
+static std::shared_ptr<const PolyphaseResampler::FilterBank> get_filter_bank(
+        const uint32_t up, const uint32_t down)
+{
+	static std::mutex mutex = {};
+	static std::map<std::pair<uint32_t, uint32_t>,
+	                std::weak_ptr<const PolyphaseResampler::FilterBank>>
+	        banks = {};
+
+	const std::lock_guard lock(mutex);
+
+	auto& cached = banks[{up, down}];
+	if (auto bank = cached.lock()) {
+		return bank;
+	}
+	auto bank = create_filter_bank(up, down);
+	cached    = bank;
+	return bank;
+}
+
+PolyphaseResampler::PolyphaseResampler(const uint32_t _in_rate_hz,
+                                       const uint32_t _out_rate_hz)
+        : in_rate_hz(_in_rate_hz),
+          out_rate_hz(_out_rate_hz)
+{
+	assert(in_rate_hz > 0);
+	assert(out_rate_hz > 0);
+
+	const auto divisor = std::gcd(in_rate_hz, out_rate_hz);
+	bank = get_filter_bank(out_rate_hz / divisor, in_rate_hz / divisor);
+
+	Reset();
+}
+
+PolyphaseResampler::~PolyphaseResampler() = default;
+
+void PolyphaseResampler::Reset()
+{
+	// The output frame sits right after the first half of the taps
+	constexpr auto num_priming_frames = NumTaps / 2 - 1;
+
+	history_left.assign(num_priming_frames, 0.0f);
+	history_right.assign(num_priming_frames, 0.0f);
+
+	in_index = 0;
+	phase    = 0;
+}
+
+// Each lane accumulates on its own, so the compiler is free to vectorise
+// the loop without reordering the additions. Filtering the channels one at a
+// time keeps the loads contiguous.
+static inline float apply_filter(const float* coeffs, const float* history)
+{
+	std::array<float, LaneSize> acc = {};
+
+	for (auto i = 0; i < NumTaps; i += LaneSize) {
+		for (auto j = 0; j < LaneSize; ++j) {
+			acc[j] += coeffs[i + j] * history[i + j];
+		}
+	}
+
+	auto sum = 0.0f;
+	for (auto j = 0; j < LaneSize; ++j) {
+		sum += acc[j];
+	}
+	return sum;
+}
+
+static inline AudioFrame apply_filter(const float* coeffs, const float* left,
+                                      const float* right)
+{
+	return {apply_filter(coeffs, left), apply_filter(coeffs, right)};
+}
+
+void PolyphaseResampler::Process(const std::vector<float>& in,
+                                 std::vector<float>& out)
+{
+	assert(bank);
+	const auto& b = *bank;
+
+	const auto num_in_frames = in.size() / 2;
+	for (size_t i = 0; i < num_in_frames; ++i) {
+		history_left.push_back(in[i * 2]);
+		history_right.push_back(in[i * 2 + 1]);
+	}
+
+	out.clear();
+	out.reserve((static_cast<uint64_t>(num_in_frames) * b.up / b.down + 1) * 2);
+
+	while (in_index + NumTaps <= history_left.size()) {
+		const auto left  = history_left.data() + in_index;
+		const auto right = history_right.data() + in_index;
+
+		AudioFrame frame = {};
+		if (b.interpolate) {
+			const auto pos = static_cast<uint64_t>(phase) * b.num_phases;
+			const auto p = static_cast<uint32_t>(pos / b.up);
+			const auto t = static_cast<float>(pos % b.up) /
+			               static_cast<float>(b.up);
+
+			const auto a = apply_filter(b.GetPhase(p), left, right);
+			const auto c = apply_filter(b.GetPhase(p + 1), left, right);
+
+			frame = {lerp(a.left, c.left, t), lerp(a.right, c.right, t)};
+		} else {
+			frame = apply_filter(b.GetPhase(phase), left, right);
+		}
+
+		out.emplace_back(frame.left);
+		out.emplace_back(frame.right);
+
+		phase += b.down;
+		in_index += phase / b.up;
+		phase %= b.up;
+	}
+
+	// Drop the frames the filter has moved past
+	const auto num_used = std::min(in_index, history_left.size());
+	const auto used_end = static_cast<ptrdiff_t>(num_used);
+
+	history_left.erase(history_left.begin(), history_left.begin() + used_end);
+	history_right.erase(history_right.begin(), history_right.begin() + used_end);
+	in_index -= num_used;
+}
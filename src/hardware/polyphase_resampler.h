@@ -0,0 +1,88 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_POLYPHASE_RESAMPLER_H
+#define DOSBOX_POLYPHASE_RESAMPLER_H
+
+#include "dosbox.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Resamples interleaved stereo frames with a windowed-sinc polyphase FIR
+// filter. The result is on par with Speex' default quality for a fraction
+// of its cost.
+//
+// The filter banks are computed once per rate ratio and shared between all
+// the resamplers using the same ratio (e.g., every channel resampling from
+// 22050 to 48000 Hz). Ratios that would need too many phases (odd rates like
+// the GUS' 19293 Hz) interpolate between the neighbouring phases instead.
+//
+// The inner loops work on fixed-size lanes over planar history buffers, so
+// the compiler turns them into SSE, AVX or NEON code depending on the target.
+//
+class PolyphaseResampler {
+public:
+	PolyphaseResampler(const uint32_t in_rate_hz, const uint32_t out_rate_hz);
+	~PolyphaseResampler();
+
+	uint32_t GetInputRateHz() const
+	{
+		return in_rate_hz;
+	}
+
+	uint32_t GetOutputRateHz() const
+	{
+		return out_rate_hz;
+	}
+
+	// Clears the history and primes it with zeros, so the first input
+	// frame lines up with the first output frame
+	void Reset();
+
+	// Resamples the interleaved stereo input frames; the output is
+	// replaced with as many frames as the input allows
+	void Process(const std::vector<float>& in, std::vector<float>& out);
+
+	struct FilterBank;
+
+	PolyphaseResampler()                                     = delete;
+	PolyphaseResampler(const PolyphaseResampler&)            = delete;
+	PolyphaseResampler& operator=(const PolyphaseResampler&) = delete;
+
+private:
+	uint32_t in_rate_hz  = 0;
+	uint32_t out_rate_hz = 0;
+
+	std::shared_ptr<const FilterBank> bank = {};
+
+	// Planar history of the input frames, with the filter's length
+	// worth of older frames at the front
+	std::vector<float> history_left  = {};
+	std::vector<float> history_right = {};
+
+	// Position of the next output frame: the first history frame the
+	// filter covers, and the fractional part in units of the ratio
+	size_t in_index = 0;
+	uint32_t phase  = 0;
+};
+
+#endif
@@ -41,6 +41,7 @@
 #include "mame/sn76496.h"
 
 #include "residfp/resample/TwoPassSincResampler.h"
+#include "tracy.h"
 
 struct Ps1Registers {
 	uint8_t status = 0;     // Read via port 0x202 control status
@@ -511,6 +512,7 @@ void Ps1Synth::WriteSoundGeneratorPort205(io_port_t, io_val_t value, io_width_t)
 
 void Ps1Synth::AudioCallback(const uint16_t requested_frames)
 {
+	ZoneScoped;
 	assert(channel);
 
 	// if (fifo.size())
@@ -824,6 +824,12 @@ plm_samples_t *plm_audio_decode(plm_audio_t *self);
 #include <string.h>
 #include <stdlib.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #ifndef TRUE
 #define TRUE 1
 #define FALSE 0
@@ -3370,6 +3376,115 @@ void plm_video_interpolate_macroblock(plm_video_t *self, plm_frame_t *s, int mot
 		DEST_INDEX += dest_scan; \
 	}} while(FALSE)
 
+#if defined(__SSE2__) || defined(__ARM_NEON)
+
+// Vectorised version of the PLM_MB_CASE operations below, a row of the block
+// at a time. All of them round like the scalar ones: the two-tap averages
+// are (a + b + 1) >> 1, the four-tap ones (a + b + c + d + 2) >> 2.
+#if defined(__SSE2__)
+template <int BLOCK_SIZE>
+static inline __m128i plm_simd_load(const uint8_t *p) {
+	if constexpr (BLOCK_SIZE == 16) {
+		return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+	} else {
+		return _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p));
+	}
+}
+
+template <int BLOCK_SIZE>
+static inline void plm_simd_store(uint8_t *p, const __m128i v) {
+	if constexpr (BLOCK_SIZE == 16) {
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(p), v);
+	} else {
+		_mm_storel_epi64(reinterpret_cast<__m128i *>(p), v);
+	}
+}
+
+static inline __m128i plm_simd_avg2(const __m128i a, const __m128i b) {
+	return _mm_avg_epu8(a, b);
+}
+
+static inline __m128i plm_simd_avg4(const __m128i a, const __m128i b,
+                                    const __m128i c, const __m128i d) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i two  = _mm_set1_epi16(2);
+
+	__m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+	lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(c, zero));
+	lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(d, zero));
+	lo = _mm_srli_epi16(_mm_add_epi16(lo, two), 2);
+
+	__m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+	hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(c, zero));
+	hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(d, zero));
+	hi = _mm_srli_epi16(_mm_add_epi16(hi, two), 2);
+
+	return _mm_packus_epi16(lo, hi);
+}
+#else
+template <int BLOCK_SIZE>
+static inline uint8x16_t plm_simd_load(const uint8_t *p) {
+	if constexpr (BLOCK_SIZE == 16) {
+		return vld1q_u8(p);
+	} else {
+		return vcombine_u8(vld1_u8(p), vdup_n_u8(0));
+	}
+}
+
+template <int BLOCK_SIZE>
+static inline void plm_simd_store(uint8_t *p, const uint8x16_t v) {
+	if constexpr (BLOCK_SIZE == 16) {
+		vst1q_u8(p, v);
+	} else {
+		vst1_u8(p, vget_low_u8(v));
+	}
+}
+
+static inline uint8x16_t plm_simd_avg2(const uint8x16_t a, const uint8x16_t b) {
+	return vrhaddq_u8(a, b);
+}
+
+static inline uint8x16_t plm_simd_avg4(const uint8x16_t a, const uint8x16_t b,
+                                       const uint8x16_t c, const uint8x16_t d) {
+	const uint16x8_t lo = vaddq_u16(vaddl_u8(vget_low_u8(a), vget_low_u8(b)),
+	                                vaddl_u8(vget_low_u8(c), vget_low_u8(d)));
+	const uint16x8_t hi = vaddq_u16(vaddl_u8(vget_high_u8(a), vget_high_u8(b)),
+	                                vaddl_u8(vget_high_u8(c), vget_high_u8(d)));
+	return vcombine_u8(vrshrn_n_u16(lo, 2), vrshrn_n_u16(hi, 2));
+}
+#endif
+
+template <int BLOCK_SIZE>
+static void plm_video_process_macroblock_simd(
+	const uint8_t *s, uint8_t *d, unsigned int si, unsigned int di, int dw,
+	int odd_h, int odd_v, int interpolate
+) {
+	for (int y = 0; y < BLOCK_SIZE; y++) {
+		const uint8_t *src = s + si;
+		uint8_t *dst = d + di;
+
+		auto v = plm_simd_load<BLOCK_SIZE>(src);
+		if (odd_h && odd_v) {
+			v = plm_simd_avg4(v,
+			                  plm_simd_load<BLOCK_SIZE>(src + 1),
+			                  plm_simd_load<BLOCK_SIZE>(src + dw),
+			                  plm_simd_load<BLOCK_SIZE>(src + dw + 1));
+		} else if (odd_h) {
+			v = plm_simd_avg2(v, plm_simd_load<BLOCK_SIZE>(src + 1));
+		} else if (odd_v) {
+			v = plm_simd_avg2(v, plm_simd_load<BLOCK_SIZE>(src + dw));
+		}
+		if (interpolate) {
+			v = plm_simd_avg2(plm_simd_load<BLOCK_SIZE>(dst), v);
+		}
+		plm_simd_store<BLOCK_SIZE>(dst, v);
+
+		si += dw;
+		di += dw;
+	}
+}
+#endif
+
 void plm_video_process_macroblock(
 	plm_video_t *self, uint8_t *s, uint8_t *d,
 	int motion_h, int motion_v, int block_size, int interpolate
@@ -3389,6 +3504,18 @@ void plm_video_process_macroblock(
 		return; // corrupt video
 	}
 
+#if defined(__SSE2__) || defined(__ARM_NEON)
+	// Luma blocks are 16 pixels wide, chroma blocks 8
+	if (block_size == 16) {
+		plm_video_process_macroblock_simd<16>(s, d, si, di, dw, odd_h, odd_v, interpolate);
+		return;
+	}
+	if (block_size == 8) {
+		plm_video_process_macroblock_simd<8>(s, d, si, di, dw, odd_h, odd_v, interpolate);
+		return;
+	}
+#endif
+
 	#define PLM_MB_CASE(INTERPOLATE, ODD_H, ODD_V, OP) \
 		case ((INTERPOLATE << 2) | (ODD_H << 1) | (ODD_V)): \
 			PLM_BLOCK_SET(d, di, dw, si, dw, block_size, OP); \
@@ -36,6 +36,7 @@
 #include "logging.h"
 #include "mixer.h"
 #include "setup.h"
+#include "tracy.h"
 
 // bring in the MPEG-1 decoder library...
 #define PL_MPEG_IMPLEMENTATION
@@ -763,6 +764,7 @@ static void DeactivatePlayerAudioFifo(AudioFifo& audio_fifo)
 
 static void RMMixerChannelCallback(uint16_t frames_remaining)
 {
+	ZoneScoped;
 	assert(active_fifo);
 	assert(mixer_channel);
 	assert(frames_remaining > 0);
@@ -25,6 +25,7 @@
 
 #include "reelmagic.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdarg>
 #include <cstdio>
@@ -440,20 +441,30 @@ static inline void RMR_DrawLine_VSO_VGAMPEGDoubleSameWidthSkip6Vertical(const T*
 CREATE_RMR_VGA_TYPED_FUNCTIONS(RMR_DrawLine_VSO_VGAMPEGDoubleSameWidthSkip6Vertical)
 
 //
-// the catch-all un-optimized MPEG scaling function...
+// the catch-all MPEG scaling function...
 //
-// WARNING: this ended up being kinda hacky...
-//          should we perheps re-think this; possibly using a
-//          lookup table computed at mode change time?
+// the source column of every output pixel and the source row of every output
+// line are computed once at mode change time, so drawing a line is only a
+// table lookup per pixel instead of a multiply and shift
 //
-static Bitu _RMR_DrawLine_VSO_GeneralResizeMPEGToVGA_WidthRatio     = 0;
-static Bitu _RMR_DrawLine_VSO_GeneralResizeMPEGToVGA_HeightRatio    = 0;
+static uint16_t _generalResizeColumns[SCALER_MAXWIDTH];
+static uint32_t _generalResizeRowOffsets[SCALER_MAXHEIGHT + 1];
 static void Initialize_RMR_DrawLine_VSO_GeneralResizeMPEGToVGA_Dimensions()
 {
-	_RMR_DrawLine_VSO_GeneralResizeMPEGToVGA_WidthRatio = _mpegPictureWidth << 12;
-	_RMR_DrawLine_VSO_GeneralResizeMPEGToVGA_WidthRatio /= _renderWidth;
-	_RMR_DrawLine_VSO_GeneralResizeMPEGToVGA_HeightRatio = _mpegPictureHeight << 12;
-	_RMR_DrawLine_VSO_GeneralResizeMPEGToVGA_HeightRatio /= _renderHeight;
+	const Bitu widthRatio  = (_mpegPictureWidth << 12) / _renderWidth;
+	const Bitu heightRatio = (_mpegPictureHeight << 12) / _renderHeight;
+
+	for (Bitu i = 0; i < SCALER_MAXWIDTH; ++i) {
+		const auto column = std::min<Bitu>((i * widthRatio) >> 12,
+		                                   SCALER_MAXWIDTH - 1);
+		_generalResizeColumns[i] = static_cast<uint16_t>(column);
+	}
+	for (Bitu i = 0; i <= SCALER_MAXHEIGHT; ++i) {
+		const auto row = std::min<Bitu>((i * heightRatio) >> 12,
+		                                SCALER_MAXHEIGHT - 1);
+		_generalResizeRowOffsets[i] =
+		        static_cast<uint32_t>(_mpegPictureWidth * row);
+	}
 }
 template <typename T>
 static inline void RMR_DrawLine_VSO_GeneralResizeMPEGToVGA(const T* src)
@@ -463,11 +474,11 @@ static inline void RMR_DrawLine_VSO_GeneralResizeMPEGToVGA(const T* src)
 	for (Bitu i = 0; i < lineWidth; ++i)
 		MixPixel(out[i],
 		         src[i],
-		         _mpegPictureBufferPtr[(i * _RMR_DrawLine_VSO_GeneralResizeMPEGToVGA_WidthRatio) >> 12]);
-	_mpegPictureBufferPtr =
-	        &_mpegPictureBuffer[_mpegPictureWidth * ((++_currentRenderLineNumber *
-	                                                  _RMR_DrawLine_VSO_GeneralResizeMPEGToVGA_HeightRatio) >>
-	                                                 12)];
+		         _mpegPictureBufferPtr[_generalResizeColumns[i]]);
+	if (_currentRenderLineNumber < SCALER_MAXHEIGHT)
+		++_currentRenderLineNumber;
+	_mpegPictureBufferPtr = _mpegPictureBuffer +
+	                        _generalResizeRowOffsets[_currentRenderLineNumber];
 	RENDER_DrawLine(_finalMixedRenderLineBuffer);
 }
 CREATE_RMR_VGA_TYPED_FUNCTIONS(RMR_DrawLine_VSO_GeneralResizeMPEGToVGA)
@@ -42,6 +42,7 @@
 #include "shell.h"
 #include "string_utils.h"
 #include "support.h"
+#include "tracy.h"
 
 constexpr uint8_t MixerIndex = 0x04;
 constexpr uint8_t MixerData  = 0x05;
@@ -882,6 +883,53 @@ static uint32_t read_dma_16bit(const uint32_t bytes_to_read, const uint32_t i =
 	return check_cast<uint32_t>(bytes_read);
 }
 
+static void add_mono_8bit_samples(const uint32_t num_samples,
+                                  const uint8_t* data)
+{
+	const auto frames = check_cast<uint16_t>(num_samples);
+	if (sb.dma.sign) {
+		sb.chan->AddSamples_m8s(
+		        frames,
+		        maybe_silence(num_samples,
+		                      reinterpret_cast<const int8_t*>(data)));
+	} else {
+		sb.chan->AddSamples_m8(frames, maybe_silence(num_samples, data));
+	}
+}
+
+// Mono 8-bit samples are handed to the mixer straight from guest memory
+// when it's plain RAM, otherwise they're copied through the DMA buffer
+static uint32_t play_mono_8bit_dma(const uint32_t bytes_to_read)
+{
+	uint32_t bytes_read = 0;
+	while (bytes_read < bytes_to_read) {
+		const auto spans = sb.dma.chan->GetSpans(bytes_to_read - bytes_read);
+		if (!spans) {
+			break;
+		}
+		uint32_t span_bytes = 0;
+		for (const auto& span : *spans) {
+			if (span.num_bytes) {
+				const auto num_bytes = check_cast<uint32_t>(span.num_bytes);
+				add_mono_8bit_samples(num_bytes, span.data);
+				span_bytes += num_bytes;
+			}
+		}
+		bytes_read += check_cast<uint32_t>(sb.dma.chan->Advance(span_bytes));
+
+		// Only auto-init transfers carry on past the terminal count
+		if (!sb.dma.chan->is_autoiniting) {
+			return bytes_read;
+		}
+	}
+	if (bytes_read < bytes_to_read) {
+		const auto num_bytes = read_dma_8bit(bytes_to_read - bytes_read);
+		add_mono_8bit_samples(num_bytes, sb.dma.buf.b8);
+		bytes_read += num_bytes;
+	}
+	return bytes_read;
+}
+
 static void play_dma_transfer(const uint32_t bytes_requested)
 {
 	// How many bytes should we read from DMA?
@@ -909,7 +957,9 @@ static void play_dma_transfer(const uint32_t bytes_requested)
 
 	last_dma_callback = PIC_FullIndex();
 
-	// Temporary counter for ADPCM modes
+	// Holds a whole DMA buffer's worth of decoded ADPCM samples, at up to
+	// four samples per byte
+	static std::array<uint8_t, DmaBufSize * 4> adpcm_samples = {};
 
 	auto decode_adpcm_dma =
 	        [&](auto decode_adpcm_fn) -> std::tuple<uint32_t, uint32_t, uint16_t> {
@@ -926,20 +976,21 @@ static void play_dma_transfer(const uint32_t bytes_requested)
 			++i;
 		}
 		// Decode the remaining DMA buffer into samples using the
-		// provided function
+		// provided function, then hand them to the mixer in one go
 		while (i < num_bytes) {
 			const auto decoded = decode_adpcm_fn(sb.dma.buf.b8[i]);
-			constexpr auto NumDecoded = check_cast<uint8_t>(
-			        decoded.size());
-
-			sb.chan->AddSamples_m8(NumDecoded,
-			                       maybe_silence(NumDecoded,
-			                                     decoded.data()));
-			num_samples += NumDecoded;
+			for (const auto sample : decoded) {
+				adpcm_samples[num_samples++] = sample;
+			}
 			i++;
 		}
 		// ADPCM is mono
 		num_frames = check_cast<uint16_t>(num_samples);
+		if (num_frames) {
+			sb.chan->AddSamples_m8(num_frames,
+			                       maybe_silence(num_samples,
+			                                     adpcm_samples.data()));
+		}
 		return {num_bytes, num_samples, num_frames};
 	};
 
@@ -993,22 +1044,11 @@ static void play_dma_transfer(const uint32_t bytes_requested)
 			}
 
 		} else { // Mono
-			bytes_read = read_dma_8bit(bytes_to_read);
+			bytes_read = play_mono_8bit_dma(bytes_to_read);
 			samples    = bytes_read;
 			frames     = check_cast<uint16_t>(samples / channels);
 			assert(channels == 1 && frames == samples); // sanity-check
 			                                            // mono
-			if (sb.dma.sign) {
-				sb.chan->AddSamples_m8s(
-				        frames,
-				        maybe_silence(samples,
-				                      reinterpret_cast<int8_t*>(
-				                              sb.dma.buf.b8)));
-			} else {
-				sb.chan->AddSamples_m8(frames,
-				                       maybe_silence(samples,
-				                                     sb.dma.buf.b8));
-			}
 		}
 		break;
 
@@ -2760,6 +2800,7 @@ bool SB_GetAddress(uint16_t &sbaddr, uint8_t &sbirq, uint8_t &sbdma)
 
 static void sblaster_callback(const uint32_t length)
 {
+	ZoneScoped;
 	auto len = length;
 
 	switch (sb.mode) {
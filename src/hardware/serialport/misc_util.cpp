@@ -25,6 +25,8 @@
 #include "misc_util.h"
 
 #include <cassert>
+#include <chrono>
+#include <cstring>
 
 #include "timer.h"
 
@@ -737,4 +739,142 @@ NETClientSocket *TCPServerSocket::Accept()
 	return new TCPClientSocket(new_tcpsock);
 }
 
+// --- THREADED NET INTERFACE ------------------------------------------------
+
+ThreadedClientSocket::ThreadedClientSocket(NETClientSocket *client_socket,
+                                           const std::string &name)
+        : socket(client_socket),
+          stats(name)
+{
+	assert(socket);
+	isopen = socket->isopen;
+	if (!isopen) {
+		return;
+	}
+	// The address is asked for on the emulation thread, so look it up
+	// before the socket belongs to the I/O thread
+	socket->GetRemoteAddressString(remote_address);
+
+	is_connected = true;
+	is_running   = true;
+	io_thread    = std::thread(&ThreadedClientSocket::Run, this);
+	set_thread_name(io_thread, "dosbox:modem");
+}
+
+ThreadedClientSocket::~ThreadedClientSocket()
+{
+	is_running = false;
+	if (io_thread.joinable()) {
+		io_thread.join();
+	}
+}
+
+void ThreadedClientSocket::Run()
+{
+	constexpr size_t ChunkSize = 512;
+	uint8_t buffer[ChunkSize];
+
+	while (is_running && is_connected) {
+		bool had_traffic = false;
+
+		// Whatever the emulation wrote goes out first
+		const auto num_tx = tx_bytes.Read(buffer, ChunkSize);
+		if (num_tx) {
+			if (!socket->SendArray(buffer, num_tx)) {
+				is_connected = false;
+				break;
+			}
+			stats.AddSent(num_tx);
+			had_traffic = true;
+		}
+
+		// Only take in what the ring can hold, the rest waits in the
+		// socket until the emulation caught up
+		auto num_rx = std::min(rx_bytes.GetNumWritable(), ChunkSize);
+		if (num_rx) {
+			if (!socket->ReceiveArray(buffer, num_rx)) {
+				is_connected = false;
+				break;
+			}
+			rx_bytes.Write(buffer, num_rx);
+			if (num_rx) {
+				stats.AddReceived(num_rx);
+				had_traffic = true;
+			}
+		}
+
+		if (!had_traffic) {
+			std::this_thread::sleep_for(std::chrono::microseconds(250));
+		}
+	}
+}
+
+// The connection is reported closed only after everything received
+// before it closed was read
+bool ThreadedClientSocket::IsClosedAndDrained()
+{
+	if (!is_connected && !rx_bytes.GetNumReadable()) {
+		isopen = false;
+	}
+	return !isopen;
+}
+
+// The devices read until the ring runs dry, so that's where a poll ends
+void ThreadedClientSocket::UpdateStats(const int64_t start_us)
+{
+	stats.SetQueued(rx_bytes.GetNumReadable());
+	stats.Tick(GetTicksUsSince(start_us));
+}
+
+SocketState ThreadedClientSocket::GetcharNonBlock(uint8_t &val)
+{
+	const auto start_us = GetTicksUs();
+	if (rx_bytes.Read(&val, 1)) {
+		return SocketState::Good;
+	}
+	UpdateStats(start_us);
+	return IsClosedAndDrained() ? SocketState::Closed : SocketState::Empty;
+}
+
+bool ThreadedClientSocket::Putchar(uint8_t val)
+{
+	return SendArray(&val, 1);
+}
+
+bool ThreadedClientSocket::SendArray(const uint8_t *data, size_t n)
+{
+	assert(data);
+	// A full ring means the network is stalled, so wait for it like a
+	// blocking send would
+	while (n) {
+		if (!is_connected) {
+			isopen = false;
+			return false;
+		}
+		const auto num_written = tx_bytes.Write(data, n);
+		data += num_written;
+		n -= num_written;
+		if (n) {
+			std::this_thread::yield();
+		}
+	}
+	return true;
+}
+
+bool ThreadedClientSocket::ReceiveArray(uint8_t *data, size_t &n)
+{
+	assert(data);
+	const auto start_us = GetTicksUs();
+	n = rx_bytes.Read(data, n);
+	UpdateStats(start_us);
+	return n || !IsClosedAndDrained();
+}
+
+bool ThreadedClientSocket::GetRemoteAddressString(char *buffer)
+{
+	assert(buffer);
+	strcpy(buffer, remote_address);
+	return true;
+}
+
 #endif // C_MODEM
@@ -23,8 +23,13 @@
 
 #if C_MODEM
 
+#include <atomic>
+#include <memory>
+#include <thread>
 #include <vector>
 
+#include "network_stats.h"
+#include "spsc_ring.h"
 #include "support.h"
 
 #if defined WIN32
@@ -223,6 +228,48 @@ public:
 	NETClientSocket *Accept() override;
 };
 
+// --- THREADED NET INTERFACE ------------------------------------------------
+
+// Runs the I/O of another client socket on its own thread, with byte rings
+// in both directions. Reads and writes then never touch the network on
+// the emulation thread, they only take from or add to the rings.
+
+class ThreadedClientSocket : public NETClientSocket {
+public:
+	ThreadedClientSocket(NETClientSocket *socket, const std::string &name);
+	ThreadedClientSocket(const ThreadedClientSocket &) = delete; // prevent copying
+	ThreadedClientSocket &operator=(const ThreadedClientSocket &) = delete; // prevent assignment
+
+	~ThreadedClientSocket() override;
+
+	SocketState GetcharNonBlock(uint8_t &val) override;
+	bool Putchar(uint8_t val) override;
+	bool SendArray(const uint8_t *data, size_t n) override;
+	bool ReceiveArray(uint8_t *data, size_t &n) override;
+	bool GetRemoteAddressString(char *buffer) override;
+
+private:
+	void Run();
+	bool IsClosedAndDrained();
+	void UpdateStats(int64_t start_us);
+
+	static constexpr size_t RingSize = 4096;
+
+	std::unique_ptr<NETClientSocket> socket = nullptr;
+	// Large enough for the dotted IPv4 addresses the sockets report
+	char remote_address[16] = {};
+
+	SpscRing<uint8_t> rx_bytes = SpscRing<uint8_t>(RingSize);
+	SpscRing<uint8_t> tx_bytes = SpscRing<uint8_t>(RingSize);
+
+	std::thread io_thread         = {};
+	std::atomic_bool is_running   = false;
+	std::atomic_bool is_connected = false;
+
+	// Counts the chunks moved by the I/O thread as packets
+	NetworkStats stats;
+};
+
 #endif // C_MODEM
 
 #endif
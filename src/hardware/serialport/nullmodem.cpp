@@ -24,6 +24,7 @@
 #include "control.h"
 #include "serialport.h"
 #include "nullmodem.h"
+#include "string_utils.h"
 
 CNullModem::CNullModem(const uint8_t port_idx, CommandLine *cmd)
         : CSerial(port_idx, cmd),
@@ -34,6 +35,7 @@ CNullModem::CNullModem(const uint8_t port_idx, CommandLine *cmd)
 	rx_state=N_RX_DISC;
 
 	tx_gather = 12;
+	tx_burst = true;
 	uint32_t bool_temp = 0;
 
 	// enet: Setting to 1 enables enet on the port, otherwise TCP.
@@ -201,7 +203,9 @@ SocketState CNullModem::readChar(uint8_t &val)
 bool CNullModem::ClientConnect(NETClientSocket *newsocket)
 {
 	char peernamebuf[INET_ADDRSTRLEN];
-	clientsocket = newsocket;
+	clientsocket = new ThreadedClientSocket(newsocket,
+	                                        format_str("COM%" PRIu8 " nullmodem",
+	                                                   GetPortNumber()));
  
 	if (!clientsocket->isopen) {
 		LOG_MSG("SERIAL: Port %" PRIu8 " connection failed.", GetPortNumber());
@@ -237,8 +241,11 @@ bool CNullModem::ServerListen() {
 
 bool CNullModem::ServerConnect() {
 	// check if a connection is available.
-	clientsocket=serversocket->Accept();
-	if (!clientsocket) return false;
+	NETClientSocket *newsocket = serversocket->Accept();
+	if (!newsocket) return false;
+	clientsocket = new ThreadedClientSocket(newsocket,
+	                                        format_str("COM%" PRIu8 " nullmodem",
+	                                                   GetPortNumber()));
 
 	char peeripbuf[INET_ADDRSTRLEN];
 	clientsocket->GetRemoteAddressString(peeripbuf);
@@ -297,10 +304,10 @@ void CNullModem::handleUpperEvent(uint16_t type)
 		switch (rx_state) {
 		case N_RX_IDLE:
 			if (CanReceiveByte()) {
-				if (doReceive()) {
+				if (const auto n = doReceiveBurst(); n) {
 					// a byte was received
 					rx_state = N_RX_WAIT;
-					setEvent(SERIAL_RX_EVENT, bytetime * 0.9f);
+					setEvent(SERIAL_RX_EVENT, bytetime * 0.9f * static_cast<float>(n));
 				} // else still idle
 			} else {
 #if SERIAL_DEBUG
@@ -365,13 +372,13 @@ void CNullModem::handleUpperEvent(uint16_t type)
 				case N_RX_FASTWAIT:
 					if (CanReceiveByte()) {
 						// just works or unblocked
-						if (doReceive()) {
+						if (const auto n = doReceiveBurst(); n) {
 							rx_retry=0; // not waiting anymore
-							if (rx_state==N_RX_WAIT) setEvent(SERIAL_RX_EVENT, bytetime*0.9f);
+							if (rx_state==N_RX_WAIT) setEvent(SERIAL_RX_EVENT, bytetime*0.9f*static_cast<float>(n));
 							else {
 								// maybe unblocked
 								rx_state=N_RX_FASTWAIT;
-								setEvent(SERIAL_RX_EVENT, bytetime*0.65f);
+								setEvent(SERIAL_RX_EVENT, bytetime*0.65f*static_cast<float>(n));
 							}
 						} else {
 							// didn't receive anything
@@ -467,6 +474,30 @@ bool CNullModem::doReceive () {
 	return false;
 }
 
+// Receives as many bytes as the UART takes per event; returns how many
+// byte times that took
+size_t CNullModem::doReceiveBurst()
+{
+	const auto burst_size = GetRxBurstSize();
+	size_t n = 0;
+	beginReceiveBurst();
+	while (n < burst_size && clientsocket && doReceive()) {
+		++n;
+	}
+	endReceiveBurst();
+	return n;
+}
+
+void CNullModem::transmitBytes(const uint8_t *data, size_t n)
+{
+	// the last one is done after all of their byte times
+	setEvent(SERIAL_TX_EVENT, bytetime * static_cast<float>(n));
+	for (size_t i = 0; i < n; ++i) {
+		if (!transparent && (data[i] == 0xff)) WriteChar(0xff);
+		WriteChar(data[i]);
+	}
+}
+
 void CNullModem::transmitByte(uint8_t val, bool first)
 {
 	// transmit it later in THR_Event
@@ -44,6 +44,7 @@ public:
 	void updatePortConfig(uint16_t divider, uint8_t lcr) override;
 	void updateMSR() override;
 	void transmitByte(uint8_t val, bool first) override;
+	void transmitBytes(const uint8_t *data, size_t n) override;
 	void setBreak(bool value) override;
 	
 	void setRTSDTR(bool rts, bool dtr) override;
@@ -70,6 +71,7 @@ private:
 #define N_RX_DISC		4
 
 	bool doReceive();
+	size_t doReceiveBurst();
 	bool ClientConnect(NETClientSocket *newsocket);
 	bool ServerListen();
 	bool ServerConnect();
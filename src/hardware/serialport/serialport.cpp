@@ -367,6 +367,37 @@ bool CSerial::CanReceiveByte() {
 	return !rxfifo->isFull();
 }
 
+size_t CSerial::GetRxBurstSize()
+{
+	if (!(FCR & FCR_ACTIVATE)) {
+		return CanReceiveByte() ? 1 : 0;
+	}
+	return std::min(static_cast<size_t>(rx_interrupt_threshold),
+	                rxfifo->getFree());
+}
+
+/*****************************************************************************/
+/* Bursts of received bytes                                                 **/
+/*****************************************************************************/
+void CSerial::beginReceiveBurst()
+{
+	in_rx_burst       = true;
+	rx_burst_received = false;
+	rx_burst_timeout  = false;
+}
+
+void CSerial::endReceiveBurst()
+{
+	in_rx_burst = false;
+	if (!rx_burst_received) {
+		return;
+	}
+	removeEvent(SERIAL_RX_TIMEOUT_EVENT);
+	if (rx_burst_timeout) {
+		setEvent(SERIAL_RX_TIMEOUT_EVENT, bytetime * 4.0f);
+	}
+}
+
 /*****************************************************************************/
 /* A byte was received                                                      **/
 /*****************************************************************************/
@@ -381,9 +412,16 @@ void CSerial::receiveByteEx(uint8_t data, uint8_t error)
 		// Overrun error ;o
 		error |= LSR_OVERRUN_ERROR_MASK;
 	}
-	removeEvent(SERIAL_RX_TIMEOUT_EVENT);
-	if(rxfifo->getUsage()==rx_interrupt_threshold) rise (RX_PRIORITY);
-	else setEvent(SERIAL_RX_TIMEOUT_EVENT,bytetime*4.0f);
+	if (in_rx_burst) {
+		// only the timeout after the last byte of the burst matters
+		rx_burst_received = true;
+		rx_burst_timeout  = rxfifo->getUsage() != rx_interrupt_threshold;
+		if (!rx_burst_timeout) rise (RX_PRIORITY);
+	} else {
+		removeEvent(SERIAL_RX_TIMEOUT_EVENT);
+		if(rxfifo->getUsage()==rx_interrupt_threshold) rise (RX_PRIORITY);
+		else setEvent(SERIAL_RX_TIMEOUT_EVENT,bytetime*4.0f);
+	}
 
 	if(error) {
 		// A lot of UART chips generate a framing error too when receiving break
@@ -472,6 +510,17 @@ void CSerial::ByteTransmitting() {
 /* ByteTransmitted: When a byte was sent, notify here.                      **/
 /*****************************************************************************/
 void CSerial::ByteTransmitted () {
+	if (tx_burst && (FCR & FCR_ACTIVATE) && !loopback && txfifo->getUsage() > 1) {
+		// hand over everything the FIFO holds in one go
+		uint8_t data[SERIAL_MAX_FIFO_SIZE];
+		size_t n = 0;
+		while (!txfifo->isEmpty()) {
+			data[n++] = txfifo->getb();
+		}
+		transmitBytes(data, n);
+		rise(TX_PRIORITY);
+		return;
+	}
 	if(!txfifo->isEmpty()) {
 		// there is more data
 		uint8_t data = txfifo->getb();
@@ -307,8 +307,9 @@ bool CSerialModem::Dial(const char * host) {
 	// Resolve host we're gonna dial
 	LOG_MSG("SERIAL: Port %" PRIu8 " connecting to host %s port %" PRIu16 ".",
 	        GetPortNumber(), destination, port);
-	clientsocket.reset(NETClientSocket::NETClientFactory(socketType,
-	                                                     destination, port));
+	clientsocket = std::make_unique<ThreadedClientSocket>(
+	        NETClientSocket::NETClientFactory(socketType, destination, port),
+	        format_str("COM%" PRIu8 " modem", GetPortNumber()));
 	if (!clientsocket->isopen) {
 		clientsocket.reset(nullptr);
 		LOG_MSG("SERIAL: Port %" PRIu8 " failed to connect.", GetPortNumber());
@@ -323,7 +324,9 @@ bool CSerialModem::Dial(const char * host) {
 
 void CSerialModem::AcceptIncomingCall() {
 	if (waitingclientsocket) {
-		clientsocket = std::move(waitingclientsocket);
+		clientsocket = std::make_unique<ThreadedClientSocket>(
+		        waitingclientsocket.release(),
+		        format_str("COM%" PRIu8 " modem", GetPortNumber()));
 		EnterConnectedState();
 		warmup_remain_ticks = MODEM_WARMUP_DELAY_MS;
 	} else {
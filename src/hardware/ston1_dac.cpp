@@ -48,13 +48,6 @@ void StereoOn1::ConfigureFilters(const FilterState state)
 	channel->SetLowPassFilter(state);
 }
 
-AudioFrame StereoOn1::Render()
-{
-	const float left  = lut_u8to16[stereo_data[0]];
-	const float right = lut_u8to16[stereo_data[1]];
-	return {left, right};
-}
-
 void StereoOn1::WriteData(const io_port_t, const io_val_t data, const io_width_t)
 {
 	data_reg = check_cast<uint8_t>(data);
@@ -73,17 +66,24 @@ uint8_t StereoOn1::ReadStatus(const io_port_t, const io_width_t)
 
 void StereoOn1::WriteControl(const io_port_t, const io_val_t value, const io_width_t)
 {
-	RenderUpToNow();
-
 	const auto new_control = LptControlRegister{check_cast<uint8_t>(value)};
 
+	const bool is_left_latched = control_reg.auto_lf && !new_control.auto_lf;
+	const bool is_right_latched = control_reg.strobe && !new_control.strobe;
+
 	// Write data to the left channel
-	if (control_reg.auto_lf && !new_control.auto_lf)
+	if (is_left_latched)
 		stereo_data[0] = data_reg;
 
 	// Write data to the right channel
-	if (control_reg.strobe && !new_control.strobe)
+	if (is_right_latched)
 		stereo_data[1] = data_reg;
 
+	if (is_left_latched || is_right_latched) {
+		const float left  = lut_u8to16[stereo_data[0]];
+		const float right = lut_u8to16[stereo_data[1]];
+		QueueLevel({left, right});
+	}
+
 	control_reg.data = new_control.data;
 }
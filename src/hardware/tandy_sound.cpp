@@ -45,11 +45,11 @@
 
 #include <algorithm>
 #include <array>
-#include <queue>
 #include <string_view>
 
 #include "bios.h"
 #include "channel_names.h"
+#include "chip_renderer.h"
 #include "dma.h"
 #include "hardware.h"
 #include "inout.h"
@@ -58,6 +58,8 @@
 #include "mixer.h"
 #include "pic.h"
 #include "setup.h"
+#include "support.h"
+#include "tracy.h"
 
 #include "mame/emu.h"
 #include "mame/sn76496.h"
@@ -144,6 +146,7 @@ private:
 
 	void AudioCallback(uint16_t requested_frames);
 	bool MaybeRenderFrame(float &frame);
+	void RenderFrames(const int num_renders, std::vector<float>& out);
 	void RenderUpToNow();
 	void WriteToPort(io_port_t, io_val_t value, io_width_t);
 
@@ -152,7 +155,11 @@ private:
 	IO_WriteHandleObject write_handlers[2]                   = {};
 	std::unique_ptr<sn76496_base_device> device              = {};
 	std::unique_ptr<reSIDfp::TwoPassSincResampler> resampler = {};
-	std::queue<float> fifo                                   = {};
+
+	// Renders the PSG on its own thread; the port writes are the data
+	// bytes written to the device
+	std::unique_ptr<ChipRenderer<uint8_t, float>> renderer = {};
+	std::vector<float> callback_buffer                     = {};
 
 	// Static rate-related configuration
 	static constexpr auto render_divisor = 16;
@@ -162,7 +169,6 @@ private:
 
 	// Runtime states
 	device_sound_interface *dsi       = nullptr;
-	double last_rendered_ms           = 0.0;
 };
 
 static void setup_filter(mixer_channel_t& channel, const bool filter_enabled)
@@ -421,6 +427,7 @@ void TandyDAC::WriteToPort(io_port_t port, io_val_t value, io_width_t)
 
 void TandyDAC::AudioCallback(uint16_t requested)
 {
+	ZoneScoped;
 	if (!channel || !dma.channel) {
 		LOG_DEBUG("TANDY: Skipping update until the DAC is initialized");
 		return;
@@ -521,6 +528,20 @@ TandyPSG::TandyPSG(const ConfigProfile config_profile, const bool is_dac_enabled
 	base_device->device_start();
 	device->convert_samplerate(render_rate_hz);
 
+	// Start rendering, ahead of the mixer by its prebuffer
+	const auto render = std::bind(&TandyPSG::RenderFrames, this, _1, _2);
+	const auto write  = [this](const uint8_t data) { device->write(data); };
+
+	renderer = std::make_unique<ChipRenderer<uint8_t, float>>(
+	        ms_per_render, millis_in_second / sample_rate_hz, render, write);
+
+	const auto render_ahead_frames = iround(MIXER_GetPreBufferMs() *
+	                                        sample_rate_hz / millis_in_second);
+
+	constexpr auto MaxQueuedWrites = 1024;
+	renderer->Start(render_ahead_frames, MaxQueuedWrites);
+	set_thread_name(renderer->GetThread(), "dosbox:tandy");
+
 	LOG_MSG("TANDY: Initialised audio card with a TI %s PSG",
 	        base_device->shortName);
 }
@@ -537,6 +558,9 @@ TandyPSG::~TandyPSG()
 		handler.Uninstall();
 	}
 
+	// Wait for the render thread to finish
+	renderer.reset();
+
 	// Deregister the mixer channel, after which it's cleaned up
 	assert(channel);
 	MIXER_DeregisterChannel(channel);
@@ -562,21 +586,23 @@ bool TandyPSG::MaybeRenderFrame(float& frame)
 	return frame_is_ready;
 }
 
-void TandyPSG::RenderUpToNow()
+// Runs on the render thread
+void TandyPSG::RenderFrames(const int num_renders, std::vector<float>& out)
 {
-	const auto now = PIC_FullIndex();
+	for (auto i = 0; i < num_renders; ++i) {
+		if (float frame = 0.0f; MaybeRenderFrame(frame)) {
+			out.emplace_back(frame);
+		}
+	}
+}
 
-	// Wake up the channel and update the last rendered time datum.
+void TandyPSG::RenderUpToNow()
+{
+	// Wake up the channel and update the last rendered time datum; the
+	// render thread catches up when it applies the next write
 	assert(channel);
 	if (channel->WakeUp()) {
-		last_rendered_ms = now;
-		return;
-	}
-	// Keep rendering until we're current
-	while (last_rendered_ms < now) {
-		last_rendered_ms += ms_per_render;
-		if (float frame = 0.0f; MaybeRenderFrame(frame))
-			fifo.emplace(frame);
+		renderer->SetRenderedUpTo(PIC_FullIndex());
 	}
 }
 
@@ -585,32 +611,20 @@ void TandyPSG::WriteToPort(io_port_t, io_val_t value, io_width_t)
 	RenderUpToNow();
 
 	const auto data = check_cast<uint8_t>(value);
-	device->write(data);
+	renderer->AddWrite(PIC_FullIndex(), data);
 }
 
 void TandyPSG::AudioCallback(const uint16_t requested_frames)
 {
+	ZoneScoped;
 	assert(channel);
 
-	//if (fifo.size())
-	//	LOG_MSG("TANDY: Queued %2lu cycle-accurate frames", fifo.size());
-
-	auto frames_remaining = requested_frames;
-
-	// First, send any frames we've queued since the last callback
-	while (frames_remaining && fifo.size()) {
-		channel->AddSamples_mfloat(1, &fifo.front());
-		fifo.pop();
-		--frames_remaining;
-	}
-	// If the queue's run dry, render the remainder and sync-up our time datum
-	while (frames_remaining) {
-		if (float frame = 0.0f; MaybeRenderFrame(frame)) {
-			channel->AddSamples_mfloat(1, &frame);
-		}
-		--frames_remaining;
+	if (renderer->DequeueFrames(requested_frames, callback_buffer)) {
+		channel->AddSamples_mfloat(requested_frames, callback_buffer.data());
+	} else {
+		channel->AddSilence();
 	}
-	last_rendered_ms = PIC_FullIndex();
+	renderer->SetRenderedUpTo(PIC_FullIndex());
 }
 
 // The Tandy DAC and PSG (programmable sound generator) managed pointers
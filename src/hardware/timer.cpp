@@ -18,15 +18,16 @@
 
 #include "timer.h"
 
+#include <algorithm>
 #include <array>
 #include <cassert>
-#include <cmath>
 
 #include "inout.h"
 #include "pic.h"
 #include "mem.h"
 #include "math_utils.h"
 #include "mixer.h"
+#include "savestate.h"
 #include "setup.h"
 
 const std::chrono::steady_clock::time_point system_start_time = std::chrono::steady_clock::now();
@@ -67,12 +68,42 @@ constexpr void bcd_to_decimal(uint16_t &val)
 	val = check_cast<uint16_t>(total);
 }
 
+// PIT Time
+// ~~~~~~~~
+// The channels keep time in thousandths of a PIT tick. As the PIT runs at
+// 1193.182 kHz, a millisecond of emulated time is exactly PIT_TICK_RATE of
+// these units, so they're exact at every millisecond and reading a counter
+// or its output takes only integer maths, without drifting as the uptime
+// grows.
+using pit_time_t = int64_t;
+
+constexpr pit_time_t TimeUnitsPerTick = 1000;
+
+static pit_time_t pit_now()
+{
+	const auto whole_ms = static_cast<pit_time_t>(PIC_Ticks) * PIT_TICK_RATE;
+	const auto fraction = static_cast<pit_time_t>(PIC_TickIndexND()) *
+	                      PIT_TICK_RATE / std::max(CPU_CycleMax, 1);
+	return whole_ms + fraction;
+}
+
+// Rounds to the nearest tick, like the floating-point counters did
+static int to_ticks(const pit_time_t units)
+{
+	return static_cast<int>((units + TimeUnitsPerTick / 2) / TimeUnitsPerTick);
+}
+
 struct PIT_Block {
 	// The PIT has only 16 bits that are used as frequency
 	// divider, which can represent dividers from 0 to 65535.
 	int count = 0;
+
+	// The period in milliseconds, for scheduling the IRQ 0 events
 	double delay = 0.0;
-	double start = 0.0;
+
+	// The period and the time the period started, in PIT time units
+	pit_time_t period = 0;
+	pit_time_t start  = 0;
 
 	uint16_t read_latch = 0;
 	uint16_t write_latch = 0;
@@ -165,7 +196,7 @@ constexpr int32_t get_max_count(const PIT_Block &channel)
 	return channel.bcd ? max_bcd_count : max_dec_count;
 }
 
-constexpr int update_channel_delay(PIT_Block &channel)
+static int update_channel_delay(PIT_Block &channel)
 {
 	// Since the frequency can't be divided by 0 in a sane way, many
 	// implementations use 0 to represent the value 65536 (or 10000
@@ -175,7 +206,8 @@ constexpr int update_channel_delay(PIT_Block &channel)
 	const auto freq_divider = channel.count ? channel.count
 	                                        : (get_max_count(channel) + 1);
 
-	channel.delay = 1000.0 * freq_divider / PIT_TICK_RATE;
+	channel.delay  = 1000.0 * freq_divider / PIT_TICK_RATE;
+	channel.period = freq_divider * TimeUnitsPerTick;
 	return freq_divider;
 }
 
@@ -183,7 +215,7 @@ static void PIT0_Event(uint32_t /*val*/)
 {
 	PIC_ActivateIRQ(0);
 	if (channel_0.mode != PitMode::InterruptOnTerminalCount) {
-		channel_0.start += channel_0.delay;
+		channel_0.start += channel_0.period;
 
 		if (channel_0.update_count) {
 			update_channel_delay(channel_0);
@@ -195,25 +227,25 @@ static void PIT0_Event(uint32_t /*val*/)
 
 static bool counter_output(const PIT_Block &channel)
 {
-	auto index = PIC_FullIndex() - channel.start;
+	auto index = pit_now() - channel.start;
 	switch (channel.mode) {
 	case PitMode::InterruptOnTerminalCount:
 		if (channel.mode_changed)
 			return false;
-		return (index > channel.delay);
+		return (index > channel.period);
 
 	case PitMode::RateGenerator:
 	case PitMode::RateGeneratorAlias:
 		if (channel.mode_changed)
 			return true;
-		index = fmod(index, channel.delay);
+		index %= channel.period;
 		return index>0;
 	case PitMode::SquareWave:
 	case PitMode::SquareWaveAlias:
 		if (channel.mode_changed)
 			return true;
-		index = fmod(index, channel.delay);
-		return (index * 2 < channel.delay);
+		index %= channel.period;
+		return (index * 2 < channel.period);
 	case PitMode::SoftwareStrobe:
 		// Only low on terminal count
 		//  if(fmod(index,(double)channel.delay) == 0) return false;
@@ -269,10 +301,10 @@ static void counter_latch(PIT_Block &channel)
 	if (&channel == &channel_2 && !gate2 && channel.mode != PitMode::OneShot)
 		return;
 
-	auto elapsed_ms = PIC_FullIndex() - channel.start;
-	auto save_read_latch = [&](double latch_time) {
+	auto elapsed = pit_now() - channel.start;
+	auto save_read_latch = [&](const pit_time_t latch_time) {
 		// Latch is a 16-bit counter, wrap it to ensure it doesn't overflow
-		const auto wrapped = iround(latch_time) % UINT16_MAX;
+		const auto wrapped = to_ticks(latch_time) % UINT16_MAX;
 		channel.read_latch = check_cast<uint16_t>(wrapped);
 	};
 
@@ -282,61 +314,66 @@ static void counter_latch(PIT_Block &channel)
 		// TODO figure this out on real hardware
 
 		// Ensure the remaining ticks aren't negative
-		const auto elapsed_ticks   = elapsed_ms * PIT_TICK_RATE_KHZ;
-		const auto remaining_ticks = std::max(0.0, channel.read_latch - elapsed_ticks);
-		save_read_latch(remaining_ticks);
+		const auto remaining = channel.read_latch * TimeUnitsPerTick - elapsed;
+		save_read_latch(std::max(pit_time_t{0}, remaining));
 		return;
 	}
-	const auto count = static_cast<double>(channel.count);
+	const auto count = static_cast<pit_time_t>(channel.count);
+
+	// The count is spread evenly over the period, whose divider is one
+	// more than the count for a count of zero
+	auto counted_down = [&](const pit_time_t time) {
+		return count * TimeUnitsPerTick -
+		       time * count * TimeUnitsPerTick / channel.period;
+	};
 	switch (channel.mode) {
 	case PitMode::SoftwareStrobe:
 	case PitMode::InterruptOnTerminalCount:
 		/* Counter keeps on counting after passing terminal count */
-		if (elapsed_ms > channel.delay) {
-			elapsed_ms -= channel.delay;
+		if (elapsed > channel.period) {
+			elapsed -= channel.period;
 			if (channel.bcd) {
-				elapsed_ms = fmod(elapsed_ms,
-				                  period_of_1k_pit_ticks * 10000.0);
-				save_read_latch(max_bcd_count - elapsed_ms * PIT_TICK_RATE_KHZ);
+				elapsed %= 10000 * TimeUnitsPerTick;
+				save_read_latch(max_bcd_count * TimeUnitsPerTick - elapsed);
 			} else {
-				elapsed_ms = fmod(elapsed_ms, period_of_1k_pit_ticks * max_dec_count);
-				save_read_latch(0xffff - elapsed_ms * PIT_TICK_RATE_KHZ);
+				elapsed %= max_dec_count * TimeUnitsPerTick;
+				save_read_latch(0xffff * TimeUnitsPerTick - elapsed);
 			}
 		} else {
-			save_read_latch(count - elapsed_ms * PIT_TICK_RATE_KHZ);
+			save_read_latch(count * TimeUnitsPerTick - elapsed);
 		}
 		break;
 	case PitMode::OneShot:
 		if (channel.counting) {
-			if (elapsed_ms > channel.delay) { // has timed out
-				save_read_latch(0xffff);  // unconfirmed
+			if (elapsed > channel.period) { // has timed out
+				save_read_latch(0xffff * TimeUnitsPerTick); // unconfirmed
 			} else {
-				save_read_latch(count - elapsed_ms * PIT_TICK_RATE_KHZ);
+				save_read_latch(count * TimeUnitsPerTick - elapsed);
 			}
 		}
 		break;
 	case PitMode::RateGenerator:
 	case PitMode::RateGeneratorAlias:
-		elapsed_ms = fmod(elapsed_ms, channel.delay);
-		save_read_latch(count - (elapsed_ms / channel.delay) * count);
+		elapsed %= channel.period;
+		save_read_latch(counted_down(elapsed));
 		break;
 	case PitMode::SquareWave:
 	case PitMode::SquareWaveAlias:
-		elapsed_ms = fmod(elapsed_ms, channel.delay);
-		elapsed_ms *= 2;
-		if (elapsed_ms > channel.delay)
-			elapsed_ms -= channel.delay;
-		save_read_latch(count - (elapsed_ms / channel.delay) * count);
+		elapsed %= channel.period;
+		elapsed *= 2;
+		if (elapsed > channel.period)
+			elapsed -= channel.period;
+		save_read_latch(counted_down(elapsed));
 		// In mode 3 it never returns odd numbers LSB (if odd number is
 		// written 1 will be subtracted on first clock and then always
 		// 2) fixes "Corncob 3D"
 		save_read_latch(channel.read_latch & 0xfffe);
 		break;
 	default:
-		LOG(LOG_PIT, LOG_ERROR)("Illegal Mode %s for reading counter %f",
+		LOG(LOG_PIT, LOG_ERROR)("Illegal Mode %s for reading counter %d",
 		                        pit_mode_to_string(channel.mode),
-		                        count);
-		save_read_latch(0xffff);
+		                        channel.count);
+		save_read_latch(0xffff * TimeUnitsPerTick);
 		break;
 	}
 }
@@ -386,7 +423,7 @@ static void write_latch(io_port_t port, io_val_t value, io_width_t)
 			channel.update_count = true;
 			return;
 		}
-		channel.start = PIC_FullIndex();
+		channel.start = pit_now();
 		update_channel_delay(channel);
 
 		switch (channel_num) {
@@ -512,7 +549,7 @@ static void latch_single_channel(const uint8_t channel_num, const uint8_t val)
 		channel.counterstatus_set = false;
 		latched_timerstatus_locked = false;
 	}
-	channel.start = PIC_FullIndex(); // for undocumented newmode
+	channel.start = pit_now(); // for undocumented newmode
 	channel.go_read_latch = true;
 	channel.update_count = false;
 	channel.counting = false;
@@ -590,7 +627,7 @@ void TIMER_SetGate2(bool in)
 	switch (mode) {
 	case PitMode::InterruptOnTerminalCount:
 		if (in)
-			channel_2.start = PIC_FullIndex();
+			channel_2.start = pit_now();
 		else {
 			//Fill readlatch and store it.
 			counter_latch(channel_2);
@@ -601,7 +638,7 @@ void TIMER_SetGate2(bool in)
 		// gate 1 on: reload counter; off: nothing
 		if(in) {
 			channel_2.counting = true;
-			channel_2.start = PIC_FullIndex();
+			channel_2.start = pit_now();
 		}
 		break;
 	case PitMode::RateGenerator:
@@ -611,7 +648,7 @@ void TIMER_SetGate2(bool in)
 		// If gate is enabled restart counting. If disable store the
 		// current read_latch
 		if (in)
-			channel_2.start = PIC_FullIndex();
+			channel_2.start = pit_now();
 		else
 			counter_latch(channel_2);
 		break;
@@ -690,10 +727,29 @@ public:
 };
 static TIMER* test;
 
+// Channel 0's events are in the PIC queue, which is saved along
+static void save_pit_state(SaveStateWriter& writer)
+{
+	writer.Write(pit);
+	writer.Write(gate2);
+	writer.Write(latched_timerstatus);
+	writer.Write(latched_timerstatus_locked);
+}
+
+static void load_pit_state(SaveStateReader& reader)
+{
+	reader.Read(pit);
+	reader.Read(gate2);
+	reader.Read(latched_timerstatus);
+	reader.Read(latched_timerstatus_locked);
+}
+
 void TIMER_Destroy(Section*){
+	SAVESTATE_RemoveComponent("PIT");
 	delete test;
 }
 void TIMER_Init(Section* sec) {
 	test = new TIMER(sec);
 	sec->AddDestroyFunction(&TIMER_Destroy);
+	SAVESTATE_AddComponent("PIT", save_pit_state, load_pit_state);
 }
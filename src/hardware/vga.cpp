@@ -27,6 +27,7 @@
 #include "logging.h"
 #include "math_utils.h"
 #include "pic.h"
+#include "savestate.h"
 #include "string_utils.h"
 #include "video.h"
 
@@ -390,6 +391,36 @@ void VGA_AllowPixelDoubling(const bool allow)
 	vga.draw.pixel_doubling_allowed = allow;
 }
 
+static SaveStatePages saved_vmem_pages    = {};
+static SaveStatePages saved_fastmem_pages = {};
+
+static void save_vga_state(SaveStateWriter& writer)
+{
+	// The drawing state points into the video memory
+	writer.Write(vga.mem.linear);
+	writer.Write(&vga, sizeof(vga));
+
+	saved_vmem_pages.Save(writer, vga.mem.linear, vga.vmemsize);
+	saved_fastmem_pages.Save(writer, vga.fastmem, vga.vmemsize * 2);
+}
+
+static void load_vga_state(SaveStateReader& reader)
+{
+	uint8_t* linear = nullptr;
+	reader.Read(linear);
+	if (linear != vga.mem.linear) {
+		LOG_WARNING("VGA: The video memory was set up again since the state was saved, skipping it");
+		return;
+	}
+	reader.Read(&vga, sizeof(vga));
+
+	saved_vmem_pages.Load(reader, vga.mem.linear, vga.vmemsize);
+	saved_fastmem_pages.Load(reader, vga.fastmem, vga.vmemsize * 2);
+
+	VGA_SetupHandlers();
+	VGA_StartResize();
+}
+
 void VGA_Init(Section* sec)
 {
 	vga.draw.resizing = false;
@@ -456,6 +487,7 @@ void VGA_Init(Section* sec)
 #endif
 		}
 	}
+	SAVESTATE_AddComponent("VGA", save_vga_state, load_vga_state);
 }
 
 void SVGA_Setup_Driver(void) {
@@ -126,6 +126,7 @@ static void write_p3c0(io_port_t, io_val_t value, io_width_t)
 
 	} else {
 		vga.attr.is_address_mode = true;
+		VGA_NoteMidFrameChange();
 
 		switch (vga.attr.index) {
 		// Palette Registers (EGA & VGA)
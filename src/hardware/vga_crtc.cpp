@@ -45,6 +45,15 @@ uint8_t vga_read_p3d4(io_port_t, io_width_t)
 void vga_write_p3d5(io_port_t, io_val_t value, io_width_t)
 {
 	const auto val = check_cast<uint8_t>(value);
+
+	// Registers 0x0a to 0x0f hold the text cursor, which the BIOS rewrites
+	// constantly, and the display start address, which is only latched
+	// during the vertical retrace; neither can change the current frame
+	constexpr uint8_t CursorStartReg       = 0x0a;
+	constexpr uint8_t CursorLocationLowReg = 0x0f;
+	if (vga.crtc.index < CursorStartReg || vga.crtc.index > CursorLocationLowReg) {
+		VGA_NoteMidFrameChange();
+	}
 	// if (vga.crtc.index > 0x18) {
 	// 	LOG_MSG("VGA crtc write %" sBitfs(X) " to reg %X", val, vga.crtc.index)
 	// }
@@ -168,6 +168,7 @@ static void vga_dac_send_color(const uint8_t palette_idx, const uint8_t color_id
 
 	// Map the source color into palette's requested index
 	vga.dac.palette_map[palette_idx].Set(b8, g8, r8);
+	++vga.dac.palette_generation;
 
 	ReelMagic_RENDER_SetPalette(palette_idx, r8, g8, b8);
 }
@@ -183,6 +184,7 @@ static void write_p3c6(io_port_t, io_val_t value, io_width_t)
 {
 	const auto val = check_cast<uint8_t>(value);
 	if (vga.dac.pel_mask != val) {
+		VGA_NoteMidFrameChange();
 #if 0
 		LOG_MSG("VGA:DCA: PEL mask set to %Xh", val);
 #endif
@@ -237,6 +239,8 @@ static void write_p3c9(io_port_t, io_val_t value, io_width_t)
 	auto val = check_cast<uint8_t>(value);
 	val &= 0x3f;
 
+	VGA_NoteMidFrameChange();
+
 	switch (vga.dac.pel_index) {
 	case 0:
 		vga.dac.rgb[vga.dac.write_index].red = val;
@@ -36,6 +36,7 @@
 #include "reelmagic.h"
 #include "render.h"
 #include "rgb565.h"
+#include "tracy.h"
 #include "vga.h"
 #include "video.h"
 
@@ -142,10 +143,9 @@ static uint8_t *VGA_Draw_CGA16_Line(Bitu vidstart, Bitu line)
 	return TempLine;
 }
 
-static uint8_t byte_clamp(int v)
+static uint8_t byte_clamp(const int v)
 {
-	v >>= 13;
-	return v < 0 ? 0u : (v > 255 ? 255u : static_cast<uint8_t>(v));
+	return static_cast<uint8_t>(std::clamp(v >> 13, 0, 255));
 }
 
 static uint8_t *Composite_Process(uint8_t border, uint32_t blocks, bool double_width)
@@ -153,6 +153,9 @@ static uint8_t *Composite_Process(uint8_t border, uint32_t blocks, bool double_w
 	static int temp[SCALER_MAXWIDTH + 10] = {0};
 	static int atemp[SCALER_MAXWIDTH + 2] = {0};
 	static int btemp[SCALER_MAXWIDTH + 2] = {0};
+	static int itemp[SCALER_MAXWIDTH]     = {0};
+	static int qtemp[SCALER_MAXWIDTH]     = {0};
+	static uint32_t out[SCALER_MAXWIDTH]  = {0};
 
 	int w = blocks * 4;
 
@@ -212,45 +215,51 @@ static uint8_t *Composite_Process(uint8_t border, uint32_t blocks, bool double_w
 			++i;
 		}
 
-		// Decode
+		// Take the chroma out of the luma
 		i = temp + 5;
-		i[-1] = (i[-1] << 3) - ap[-1];
-		i[0] = (i[0] << 3) - ap[0];
-
-		uint16_t idx = 0;
-
-		auto composite_convert = [&](const int ii, const int q) {
-			i[1]        = (i[1] << 3) - ap[1];
-			const int c = i[0] + i[0];
-			const int d = i[-1] + i[1];
-
-			const int y = left_shift_signed(c + d, 8) +
-			              vga.composite.sharpness * (c - d);
+		for (int x = -1; x < w + 1; ++x) {
+			i[x] = (i[x] << 3) - ap[x];
+		}
+
+		// Rotate the chroma by the phase of the colour carrier into I and Q
+		for (int x = 0; x < w; x += 4) {
+			itemp[x + 0] = ap[x + 0];
+			qtemp[x + 0] = bp[x + 0];
+			itemp[x + 1] = -bp[x + 1];
+			qtemp[x + 1] = ap[x + 1];
+			itemp[x + 2] = -ap[x + 2];
+			qtemp[x + 2] = -bp[x + 2];
+			itemp[x + 3] = bp[x + 3];
+			qtemp[x + 3] = -ap[x + 3];
+		}
+
+		// Decode; the hdots don't depend on each other anymore, so the
+		// compiler can vectorize this as long as it doesn't have to
+		// store into TempLine (which may alias anything) as it goes
+		const auto sharpness = vga.composite.sharpness;
+		const auto ri        = vga.composite.ri;
+		const auto rq        = vga.composite.rq;
+		const auto gi        = vga.composite.gi;
+		const auto gq        = vga.composite.gq;
+		const auto bi        = vga.composite.bi;
+		const auto bq        = vga.composite.bq;
 
-			const int rr = y + vga.composite.ri * (ii) +
-			               vga.composite.rq * (q);
+		for (int x = 0; x < w; ++x) {
+			const int c = i[x] + i[x];
+			const int d = i[x - 1] + i[x + 1];
 
-			const int gg = y + vga.composite.gi * (ii) +
-			               vga.composite.gq * (q);
+			const int y = left_shift_signed(c + d, 8) + sharpness * (c - d);
 
-			const int bb = y + vga.composite.bi * (ii) +
-			               vga.composite.bq * (q);
-			++i;
-			++ap;
-			++bp;
+			const int rr = y + ri * itemp[x] + rq * qtemp[x];
+			const int gg = y + gi * itemp[x] + gq * qtemp[x];
+			const int bb = y + bi * itemp[x] + bq * qtemp[x];
 
 			const auto srgb = (byte_clamp(rr) << 16) |
 			                  (byte_clamp(gg) << 8) | byte_clamp(bb);
 
-			write_unaligned_uint32_at(TempLine, idx++, srgb);
-		};
-
-		for (uint32_t x = 0; x < blocks; ++x) {
-			composite_convert(ap[0], bp[0]);
-			composite_convert(-bp[0], ap[0]);
-			composite_convert(-ap[0], -bp[0]);
-			composite_convert(bp[0], -ap[0]);
+			out[x] = srgb;
 		}
+		std::memcpy(TempLine, out, w * sizeof(uint32_t));
 	}
 	return TempLine;
 }
@@ -277,14 +286,42 @@ static uint8_t *VGA_Draw_CGA4_Composite_Line(Bitu vidstart, Bitu line)
 	return Composite_Process(vga.tandy.color_select & 0x0f, vga.draw.blocks, true);
 }
 
+// Both pixels of a 4BPP byte, looked up through the attribute palette,
+// for single and doubled pixels. They're rebuilt when the palette changes.
+static struct {
+	uint8_t palette[16] = {};
+	std::array<std::array<uint8_t, 2>, 256> pairs = {};
+	std::array<std::array<uint8_t, 4>, 256> doubled_pairs = {};
+	bool valid = false;
+} pixels_4bpp = {};
+
+static void update_4bpp_pixel_pairs()
+{
+	static_assert(sizeof(pixels_4bpp.palette) == sizeof(vga.attr.palette));
+	if (pixels_4bpp.valid &&
+	    memcmp(pixels_4bpp.palette, vga.attr.palette, sizeof(vga.attr.palette)) == 0) {
+		return;
+	}
+	memcpy(pixels_4bpp.palette, vga.attr.palette, sizeof(vga.attr.palette));
+
+	for (size_t byte = 0; byte < pixels_4bpp.pairs.size(); ++byte) {
+		const auto left  = vga.attr.palette[byte >> 4];
+		const auto right = vga.attr.palette[byte & 0x0f];
+		pixels_4bpp.pairs[byte]         = {left, right};
+		pixels_4bpp.doubled_pairs[byte] = {left, left, right, right};
+	}
+	pixels_4bpp.valid = true;
+}
+
 static uint8_t * VGA_Draw_4BPP_Line(Bitu vidstart, Bitu line) {
 	const uint8_t *base = vga.tandy.draw_base + ((line & vga.tandy.line_mask) << vga.tandy.line_shift);
+	update_4bpp_pixel_pairs();
 	uint8_t* draw=TempLine;
 	Bitu end = vga.draw.blocks*2;
 	while(end) {
-		uint8_t byte = base[vidstart & vga.tandy.addr_mask];
-		*draw++=vga.attr.palette[byte >> 4];
-		*draw++=vga.attr.palette[byte & 0x0f];
+		const uint8_t byte = base[vidstart & vga.tandy.addr_mask];
+		memcpy(draw, pixels_4bpp.pairs[byte].data(), 2);
+		draw += 2;
 		++vidstart;
 		--end;
 	}
@@ -293,14 +330,13 @@ static uint8_t * VGA_Draw_4BPP_Line(Bitu vidstart, Bitu line) {
 
 static uint8_t * VGA_Draw_4BPP_Line_Double(Bitu vidstart, Bitu line) {
 	const uint8_t *base = vga.tandy.draw_base + ((line & vga.tandy.line_mask) << vga.tandy.line_shift);
+	update_4bpp_pixel_pairs();
 	uint8_t* draw=TempLine;
 	Bitu end = vga.draw.blocks;
 	while(end) {
-		uint8_t byte = base[vidstart & vga.tandy.addr_mask];
-		uint8_t data = vga.attr.palette[byte >> 4];
-		*draw++ = data; *draw++ = data;
-		data = vga.attr.palette[byte & 0x0f];
-		*draw++ = data; *draw++ = data;
+		const uint8_t byte = base[vidstart & vga.tandy.addr_mask];
+		memcpy(draw, pixels_4bpp.doubled_pairs[byte].data(), 4);
+		draw += 4;
 		++vidstart;
 		--end;
 	}
@@ -387,6 +423,17 @@ static uint8_t* draw_unwrapped_line_from_dac_palette(Bitu vidstart,
 
 	auto linear_pos = vidstart;
 
+	// Most lines don't wrap around the end of video memory, so the
+	// palette indexes can be read without masking each position
+	const auto start_pos = vidstart & linear_mask;
+	if (start_pos + pixels_in_line - 1 <= linear_mask) {
+		const auto palette_indexes = linear_addr + start_pos;
+		for (uint16_t i = 0; i < pixels_in_line; ++i) {
+			line_addr[i] = palette_map[palette_indexes[i]];
+		}
+		return TempLine;
+	}
+
 	// Draw in batches of four to let the host pipeline deeper.
 	constexpr auto num_repeats = 4;
 	assert(pixels_in_line % num_repeats == 0);
@@ -574,6 +621,118 @@ static uint8_t* draw_unwrapped_line_from_dac_palette_with_hwcursor(Bitu vidstart
 	return reinterpret_cast<uint8_t*>(line_addr);
 }
 
+// The DOS mouse driver's software cursor, composited onto the drawn lines
+// instead of being drawn into the video memory
+struct MouseOverlay {
+	bool is_visible = false;
+
+	// Top-left corner in the video mode's pixels, can be off-screen
+	int x = 0;
+	int y = 0;
+
+	int mode_width  = 0;
+	int mode_height = 0;
+
+	std::array<uint16_t, VgaMouseOverlaySize> screen_mask = {};
+	std::array<uint16_t, VgaMouseOverlaySize> cursor_mask = {};
+};
+
+static MouseOverlay mouse_overlay = {};
+
+static bool is_drawing_from_dac_palette()
+{
+	return VGA_DrawLine == draw_linear_line_from_dac_palette ||
+	       VGA_DrawLine == draw_unwrapped_line_from_dac_palette ||
+	       VGA_DrawLine == draw_unwrapped_line_from_dac_palette_with_hwcursor;
+}
+
+bool VGA_CanDrawMouseOverlay()
+{
+	return is_drawing_from_dac_palette();
+}
+
+void VGA_SetMouseOverlay(const int x, const int y, const int mode_width,
+                         const int mode_height, const uint16_t* screen_mask,
+                         const uint16_t* cursor_mask)
+{
+	auto& overlay = mouse_overlay;
+
+	overlay.x           = x;
+	overlay.y           = y;
+	overlay.mode_width  = mode_width;
+	overlay.mode_height = mode_height;
+	std::copy_n(screen_mask, VgaMouseOverlaySize, overlay.screen_mask.begin());
+	std::copy_n(cursor_mask, VgaMouseOverlaySize, overlay.cursor_mask.begin());
+
+	overlay.is_visible = mode_width > 0 && mode_height > 0;
+}
+
+void VGA_HideMouseOverlay()
+{
+	mouse_overlay.is_visible = false;
+}
+
+// Applies the masks the same way the driver would to the video memory: the
+// screen mask keeps the pixel underneath (or clears it to colour 0) and the
+// cursor mask inverts the low four bits of the result
+static void draw_mouse_overlay(uint8_t* line, const Bitu vidstart)
+{
+	const auto& overlay = mouse_overlay;
+
+	if (vga.seq.clocking_mode.is_screen_disabled ||
+	    !is_drawing_from_dac_palette() || vga.draw.lines_total == 0) {
+		return;
+	}
+
+	// Lines and pixels can be doubled, so scale them to the video mode
+	const auto mode_y = static_cast<int>(
+	        static_cast<int64_t>(vga.draw.lines_done) * overlay.mode_height /
+	        vga.draw.lines_total);
+
+	const auto row = mode_y - overlay.y;
+	if (row < 0 || row >= VgaMouseOverlaySize) {
+		return;
+	}
+
+	const auto num_pixels = static_cast<int>(vga.draw.line_length /
+	                                         sizeof(uint32_t));
+
+	const auto first_pixel = std::max(0, overlay.x * num_pixels / overlay.mode_width);
+	const auto last_pixel = std::min(num_pixels,
+	                                 (overlay.x + VgaMouseOverlaySize) *
+	                                                 num_pixels / overlay.mode_width +
+	                                         1);
+
+	const auto pixels = reinterpret_cast<uint32_t*>(line);
+
+	for (auto i = first_pixel; i < last_pixel; ++i) {
+		const auto column = i * overlay.mode_width / num_pixels - overlay.x;
+		if (column < 0 || column >= VgaMouseOverlaySize) {
+			continue;
+		}
+		const auto mask_bit = static_cast<uint16_t>(0x8000 >> column);
+
+		uint8_t palette_index = 0;
+		if (overlay.screen_mask[row] & mask_bit) {
+			palette_index = vga.draw.linear_base[(vidstart + i) &
+			                                     vga.draw.linear_mask];
+		}
+		if (overlay.cursor_mask[row] & mask_bit) {
+			palette_index ^= 0x0f;
+		}
+		pixels[i] = vga.dac.palette_map[palette_index];
+	}
+}
+
+static uint8_t* draw_line(const Bitu vidstart, const Bitu line)
+{
+	const auto data = VGA_DrawLine(vidstart, line);
+	if (mouse_overlay.is_visible) {
+		draw_mouse_overlay(data, vidstart);
+	}
+	return data;
+}
+
 static uint8_t * VGA_Draw_LIN16_Line_HWMouse(Bitu vidstart, Bitu /*line*/) {
 	if (!svga.hardware_cursor_active || !svga.hardware_cursor_active())
 		return &vga.mem.linear[vidstart];
@@ -794,6 +953,68 @@ static uint8_t *VGA_TEXT_Herc_Draw_Line(Bitu vidstart, Bitu line)
 	}
 	return TempLine;
 }
+// Per-pixel masks of the bits in a font pattern byte, leftmost pixel first
+static constexpr auto font_bit_masks = [] {
+	std::array<std::array<uint32_t, 8>, 256> masks = {};
+	for (size_t font = 0; font < masks.size(); ++font) {
+		for (size_t n = 0; n < 8; ++n) {
+			masks[font][n] = (font & (0x80 >> n)) ? 0xffffffff : 0;
+		}
+	}
+	return masks;
+}();
+
+// Foreground and background colours of every text attribute byte, resolved
+// through the palette and the blink state. They only change with those, so
+// they're looked up once rather than for every character on every scanline.
+struct TextAttributeColours {
+	std::array<uint32_t, 256> fg = {};
+	std::array<uint32_t, 256> bg = {};
+
+	uint32_t palette_generation = 0;
+	bool blink                  = false;
+	bool blinking               = false;
+	bool is_valid               = false;
+};
+
+static TextAttributeColours text_attribute_colours = {};
+
+static const TextAttributeColours& get_text_attribute_colours()
+{
+	auto& colours = text_attribute_colours;
+
+	const bool blink    = vga.draw.blink;
+	const bool blinking = vga.draw.blinking != 0;
+
+	if (colours.is_valid && colours.blink == blink &&
+	    colours.blinking == blinking &&
+	    colours.palette_generation == vga.dac.palette_generation) {
+		return colours;
+	}
+
+	for (uint16_t attr = 0; attr < 256; ++attr) {
+		uint8_t bg_palette_idx = attr >> 4;
+		// if blinking is enabled bit7 is not mapped to attributes
+		if (blinking) {
+			bg_palette_idx &= ~0x8;
+		}
+		// choose foreground color if blinking not set for this cell or
+		// blink on
+		const uint8_t fg_palette_idx = (blink || (attr & 0x80) == 0)
+		                                     ? (attr & 0xf)
+		                                     : bg_palette_idx;
+
+		colours.fg[attr] = vga.dac.palette_map[fg_palette_idx];
+		colours.bg[attr] = vga.dac.palette_map[bg_palette_idx];
+	}
+
+	colours.palette_generation = vga.dac.palette_generation;
+	colours.blink              = blink;
+	colours.blinking           = blinking;
+	colours.is_valid           = true;
+	return colours;
+}
+
 // combined 8/9-dot wide text mode line drawing function
 static uint8_t* draw_text_line_from_dac_palette(Bitu vidstart, Bitu line)
 {
@@ -801,6 +1022,15 @@ static uint8_t* draw_text_line_from_dac_palette(Bitu vidstart, Bitu line)
 	const uint8_t* vidmem  = VGA_Text_Memwrap(vidstart);
 	const auto palette_map = vga.dac.palette_map;
 
+	const auto& colours = get_text_attribute_colours();
+
+	// Writes to TempLine may alias any of the VGA state, so read what's
+	// needed for the whole line up front
+	const auto font_tables       = vga.draw.font_tables;
+	const auto is_nine_dot       = !vga.seq.clocking_mode.is_eight_dot_mode;
+	const auto is_line_graphics  = vga.attr.mode_control.is_line_graphics_enabled;
+	const auto is_underline_line = (vga.crtc.underline_location & 0x1f) == line;
+
 	auto blocks = vga.draw.blocks;
 	if (vga.draw.panning) {
 		++blocks; // if the text is panned part of an
@@ -819,50 +1049,34 @@ static uint8_t* draw_text_line_from_dac_palette(Bitu vidstart, Bitu line)
 		const auto chr  = *vidmem++;
 		const auto attr = *vidmem++;
 		// the font pattern
-		uint16_t font = vga.draw.font_tables[(attr >> 3) & 1][(chr << 5) + line];
+		const uint8_t font = font_tables[(attr >> 3) & 1][(chr << 5) + line];
 
-		uint8_t bg_palette_idx = attr >> 4;
-		// if blinking is enabled bit7 is not mapped to attributes
-		if (vga.draw.blinking) {
-			bg_palette_idx &= ~0x8;
-		}
-		// choose foreground color if blinking not set for this cell or
-		// blink on
-		const uint8_t fg_palette_idx = (vga.draw.blink || (attr & 0x80) == 0)
-		                                     ? (attr & 0xf)
-		                                     : bg_palette_idx;
+		// The font's bits will indicate which color is used per pixel
+		const auto fg_colour = colours.fg[attr];
 
 		// underline: all foreground [freevga: 0x77, previous 0x7]
-		if (((attr & 0x77) == 0x01) &&
-		    (vga.crtc.underline_location & 0x1f) == line) {
-			bg_palette_idx = fg_palette_idx;
-		}
-
-		// The font's bits will indicate which color is used per pixel
-		const auto fg_colour = palette_map[fg_palette_idx];
-		const auto bg_colour = palette_map[bg_palette_idx];
-
-		if (vga.seq.clocking_mode.is_eight_dot_mode) {
-			for (auto n = 0; n < 8; ++n) {
-				const auto color = (font & 0x80) ? fg_colour
-				                                 : bg_colour;
-				write_unaligned_uint32_at(TempLine, draw_idx++, color);
-				font <<= 1;
-			}
-		} else {
-			font <<= 1; // 9 pixels
+		const auto bg_colour = (is_underline_line && (attr & 0x77) == 0x01)
+		                             ? fg_colour
+		                             : colours.bg[attr];
+
+		// Select between the colours without branching, so the
+		// compiler can expand the eight font bits with vector code
+		const auto& masks      = font_bit_masks[font];
+		const auto colour_diff = fg_colour ^ bg_colour;
+		for (auto n = 0; n < 8; ++n) {
+			write_unaligned_uint32_at(TempLine,
+			                          draw_idx + n,
+			                          bg_colour ^ (colour_diff & masks[n]));
+		}
+		draw_idx += 8;
+
+		if (is_nine_dot) {
 			// Extend to the 9th pixel if needed
-			if ((font & 0x2) &&
-			    vga.attr.mode_control.is_line_graphics_enabled &&
-			    (chr >= 0xc0) && (chr <= 0xdf)) {
-				font |= 1;
-			}
-			for (auto n = 0; n < 9; ++n) {
-				const auto color = (font & 0x100) ? fg_colour
-				                                  : bg_colour;
-				write_unaligned_uint32_at(TempLine, draw_idx++, color);
-				font <<= 1;
-			}
+			const auto extend = (font & 0x1) && is_line_graphics &&
+			                    (chr >= 0xc0) && (chr <= 0xdf);
+			write_unaligned_uint32_at(TempLine,
+			                          draw_idx++,
+			                          extend ? fg_colour : bg_colour);
 		}
 	}
 	// draw the text mode cursor if needed
@@ -1011,7 +1225,7 @@ static void VGA_DrawSingleLine(uint32_t /*blah*/)
 		}
 		ReelMagic_RENDER_DrawLine(TempLine);
 	} else {
-		uint8_t * data=VGA_DrawLine( vga.draw.address, vga.draw.address_line );
+		uint8_t * data=draw_line( vga.draw.address, vga.draw.address_line );
 		ReelMagic_RENDER_DrawLine(data);
 	}
 
@@ -1035,7 +1249,7 @@ static void VGA_DrawEGASingleLine(uint32_t /*blah*/)
 	} else {
 		Bitu address = vga.draw.address;
 		if (vga.mode!=M_TEXT) address += vga.draw.panning;
-		uint8_t * data=VGA_DrawLine(address, vga.draw.address_line );
+		uint8_t * data=draw_line(address, vga.draw.address_line );
 		ReelMagic_RENDER_DrawLine(data);
 	}
 
@@ -1051,10 +1265,10 @@ static void VGA_DrawEGASingleLine(uint32_t /*blah*/)
 	} else RENDER_EndUpdate(false);
 }
 
-static void VGA_DrawPart(uint32_t lines)
+static void draw_part_lines(uint32_t lines)
 {
 	while (lines--) {
-		uint8_t * data=VGA_DrawLine( vga.draw.address, vga.draw.address_line );
+		uint8_t * data=draw_line( vga.draw.address, vga.draw.address_line );
 		ReelMagic_RENDER_DrawLine(data);
 		++vga.draw.address_line;
 		if (vga.draw.address_line>=vga.draw.address_line_total) {
@@ -1072,12 +1286,20 @@ static void VGA_DrawPart(uint32_t lines)
 #endif
 		}
 	}
+}
+
+static void VGA_DrawPart(uint32_t lines)
+{
+	ZoneScoped;
+	draw_part_lines(lines);
+
 	if (--vga.draw.parts_left) {
 		PIC_AddEvent(VGA_DrawPart, vga.draw.delay.parts,
 		             (vga.draw.parts_left != 1)
 		                     ? vga.draw.parts_lines
 		                     : (vga.draw.lines_total - vga.draw.lines_done));
 	} else {
+		vga.draw.is_batching_frame = false;
 #ifdef VGA_KEEP_CHANGES
 		VGA_ChangesEnd();
 #endif
@@ -1085,6 +1307,45 @@ static void VGA_DrawPart(uint32_t lines)
 	}
 }
 
+// Number of frames without mid-frame register changes before frames are
+// drawn in a single batch
+constexpr uint8_t QuietFramesBeforeBatching = 8;
+
+void VGA_NoteMidFrameChange()
+{
+	if (!vga.draw.parts_left) {
+		return; // not within the active display period
+	}
+	vga.draw.quiet_frames = 0;
+
+	if (!vga.draw.is_batching_frame) {
+		return;
+	}
+	vga.draw.is_batching_frame = false;
+	PIC_RemoveEvents(VGA_DrawPart);
+
+	// Draw the lines the beam has already passed with the state from
+	// before the change, then continue drawing the frame in parts
+	const auto elapsed = PIC_FullIndex() - vga.draw.delay.framestart -
+	                     vga.draw.delay.first_line;
+	const auto lines_passed = elapsed > 0.0
+	                                ? static_cast<uint32_t>(
+	                                          elapsed / vga.draw.delay.per_line_ms)
+	                                : 0;
+	draw_part_lines(std::min(lines_passed, vga.draw.lines_total));
+
+	assert(vga.draw.parts_lines > 0);
+	const auto lines_left = vga.draw.lines_total - vga.draw.lines_done;
+	vga.draw.parts_left = std::max(lines_left / vga.draw.parts_lines, 1u);
+
+	const auto next_lines = (vga.draw.parts_left != 1) ? vga.draw.parts_lines
+	                                                   : lines_left;
+	const auto next_delay = (vga.draw.lines_done + next_lines) *
+	                                vga.draw.delay.per_line_ms -
+	                        elapsed;
+	PIC_AddEvent(VGA_DrawPart, std::max(next_delay, 0.0), next_lines);
+}
+
 void VGA_SetBlinking(const uint8_t enabled)
 {
 	LOG(LOG_VGA, LOG_NORMAL)("Blinking %u", enabled);
@@ -1316,8 +1577,28 @@ static void VGA_VerticalTimer(uint32_t /*val*/)
 			RENDER_EndUpdate(true);
 		}
 		vga.draw.lines_done = 0;
-		vga.draw.parts_left = vga.draw.parts_total;
-		PIC_AddEvent(VGA_DrawPart, vga.draw.delay.parts + draw_skip, vga.draw.parts_lines);
+		vga.draw.delay.first_line = draw_skip;
+
+		// Raster effects on the older machines are driven by ports not
+		// tracked for mid-frame changes, so they always draw in parts
+		if (vga.draw.quiet_frames < QuietFramesBeforeBatching) {
+			++vga.draw.quiet_frames;
+		}
+		vga.draw.is_batching_frame = IS_EGAVGA_ARCH &&
+		                             vga.draw.quiet_frames >=
+		                                     QuietFramesBeforeBatching;
+
+		if (vga.draw.is_batching_frame) {
+			vga.draw.parts_left = 1;
+			PIC_AddEvent(VGA_DrawPart,
+			             vga.draw.delay.vdend + draw_skip,
+			             vga.draw.lines_total);
+		} else {
+			vga.draw.parts_left = vga.draw.parts_total;
+			PIC_AddEvent(VGA_DrawPart,
+			             vga.draw.delay.parts + draw_skip,
+			             vga.draw.parts_lines);
+		}
 		break;
 	case DRAWLINE:
 	case EGALINE:
@@ -3020,6 +3301,7 @@ void VGA_KillDrawing(void) {
 	PIC_RemoveEvents(VGA_DrawEGASingleLine);
 	vga.draw.parts_left = 0;
 	vga.draw.lines_done = ~0;
+	vga.draw.is_batching_frame = false;
 	if (!vga.draw.vga_override) RENDER_EndUpdate(true);
 }
 
@@ -26,6 +26,8 @@
 #include <vector>
 
 #include "cpu.h"
+#include "event_counters.h"
+#include "host_memory.h"
 #include "inout.h"
 #include "mem.h"
 #include "mem_host.h"
@@ -119,21 +121,30 @@ static struct {
 	Bitu base, mask;
 } vgapages;
 
-static void read_delay()
+// Accesses that missed the TLB's direct host pointers and had to go
+// through one of the handlers below
+static EventCounter vmem_handler_reads("VGA memory handler reads");
+static EventCounter vmem_handler_writes("VGA memory handler writes");
+
+// Every handler access passes through one of the delays, so they also do
+// the counting
+static void read_delay(const int32_t num_reads = 1)
 {
+	vmem_handler_reads.Add(0, static_cast<uint64_t>(num_reads));
 	if (vga.vmem_delay_ns > 0) {
 		const int32_t delay_cycles = (CPU_CycleMax * vga.vmem_delay_ns) /
-		                             1000000;
+		                             1000000 * num_reads;
 		CPU_Cycles -= delay_cycles;
 		CPU_IODelayRemoved += delay_cycles;
 	}
 }
 
-static void write_delay()
+static void write_delay(const int32_t num_writes = 1)
 {
+	vmem_handler_writes.Add(0, static_cast<uint64_t>(num_writes));
 	if (vga.vmem_delay_ns > 0) {
 		const int32_t delay_cycles = (CPU_CycleMax * vga.vmem_delay_ns * 3) /
-		                             (1000000 * 4);
+		                             (1000000 * 4) * num_writes;
 		CPU_Cycles -= delay_cycles;
 		CPU_IODelayRemoved += delay_cycles;
 	}
@@ -320,7 +331,7 @@ public:
 	}
 public:	
 	VGA_UnchainedEGA_Handler()  {
-		flags=PFLAG_NOCODE;
+		flags = PFLAG_NOCODE | PFLAG_BLOCKWRITE;
 	}
 
 	void writeb(PhysPt addr, uint8_t val) override
@@ -356,6 +367,24 @@ public:
 		writeHandler(addr+2,(uint8_t)(val >> 16));
 		writeHandler(addr+3,(uint8_t)(val >> 24));
 	}
+
+	bool write_block(PhysPt addr, const uint8_t* data,
+	                 const Bitu num_bytes, const Bitu num_writes) override
+	{
+		write_delay(static_cast<int32_t>(num_writes));
+		addr = PAGING_GetPhysicalAddress(addr) & vgapages.mask;
+		addr += vga.svga.bank_write_full;
+
+		const auto write_size = num_bytes / num_writes;
+		for (Bitu offset = 0; offset < num_bytes; offset += write_size) {
+			const auto start = CHECKED2(addr + offset);
+			MEM_CHANGED(start << 3);
+			for (Bitu i = 0; i < write_size; ++i) {
+				writeHandler(start + i, data[offset + i]);
+			}
+		}
+		return true;
+	}
 };
 
 //Slighly unusual version, will directly write 8,16,32 bits values
@@ -530,7 +559,7 @@ public:
 	}
 public:
 	VGA_UnchainedVGA_Handler()  {
-		flags=PFLAG_NOCODE;
+		flags = PFLAG_NOCODE | PFLAG_BLOCKWRITE;
 	}
 
 	void writeb(PhysPt addr, uint8_t val) override
@@ -566,6 +595,24 @@ public:
 		writeHandler(addr+2,(uint8_t)(val >> 16));
 		writeHandler(addr+3,(uint8_t)(val >> 24));
 	}
+
+	bool write_block(PhysPt addr, const uint8_t* data,
+	                 const Bitu num_bytes, const Bitu num_writes) override
+	{
+		write_delay(static_cast<int32_t>(num_writes));
+		addr = PAGING_GetPhysicalAddress(addr) & vgapages.mask;
+		addr += vga.svga.bank_write_full;
+
+		const auto write_size = num_bytes / num_writes;
+		for (Bitu offset = 0; offset < num_bytes; offset += write_size) {
+			const auto start = CHECKED2(addr + offset);
+			MEM_CHANGED(start << 2);
+			for (Bitu i = 0; i < write_size; ++i) {
+				writeHandler(start + i, data[offset + i]);
+			}
+		}
+		return true;
+	}
 };
 
 class VGA_TEXT_PageHandler final : public PageHandler {
@@ -690,7 +737,7 @@ public:
 class VGA_LIN4_Handler final : public VGA_UnchainedEGA_Handler {
 public:
 	VGA_LIN4_Handler() {
-		flags=PFLAG_NOCODE;
+		flags = PFLAG_NOCODE | PFLAG_BLOCKWRITE;
 	}
 	void writeb(PhysPt addr, uint8_t val) override
 	{
@@ -750,6 +797,23 @@ public:
 		                             (readHandler(addr + 2) << 16) |
 		                             (readHandler(addr + 3) << 24));
 	}
+
+	bool write_block(PhysPt addr, const uint8_t* data,
+	                 const Bitu num_bytes, const Bitu num_writes) override
+	{
+		write_delay(static_cast<int32_t>(num_writes));
+		addr = vga.svga.bank_write_full + (PAGING_GetPhysicalAddress(addr) & 0xffff);
+
+		const auto write_size = num_bytes / num_writes;
+		for (Bitu offset = 0; offset < num_bytes; offset += write_size) {
+			const auto start = CHECKED4(addr + offset);
+			MEM_CHANGED(start << 3);
+			for (Bitu i = 0; i < write_size; ++i) {
+				writeHandler(start + i, data[offset + i]);
+			}
+		}
+		return true;
+	}
 };
 
 
@@ -965,6 +1029,110 @@ static struct vg {
 	VGA_Empty_Handler empty = {};
 } vgaph;
 
+// The handler of a run of video memory, if it's the same over the whole run
+// and the run isn't remapped by paging
+static PageHandler* get_block_handler(const PhysPt addr, const Bitu num_bytes)
+{
+	if (PAGING_Enabled()) {
+		return nullptr;
+	}
+	const auto handler = MEM_GetPageHandler(addr / 4096);
+	if (MEM_GetPageHandler((addr + num_bytes - 1) / 4096) != handler) {
+		return nullptr;
+	}
+	return handler;
+}
+
+// The offsets into video memory, the same as the handlers compute them
+static inline PhysPt planar_offset(const PhysPt addr, const Bitu bank)
+{
+	return CHECKED2((addr & vgapages.mask) + bank);
+}
+
+static inline PhysPt lin4_offset(const PhysPt addr, const Bitu bank)
+{
+	return CHECKED4(bank + (addr & 0xffff));
+}
+
+static inline PhysPt chained_offset(const PhysPt addr, const Bitu bank)
+{
+	return CHECKED((addr & vgapages.mask) + bank);
+}
+
+bool VGA_BlockCopy(const PhysPt dest, const PhysPt src, const Bitu num_bytes)
+{
+	if (!num_bytes) {
+		return true;
+	}
+	const auto handler = get_block_handler(dest, num_bytes);
+	if (!handler || get_block_handler(src, num_bytes) != handler) {
+		return false;
+	}
+	const auto read_bank  = vga.svga.bank_read_full;
+	const auto write_bank = vga.svga.bank_write_full;
+
+	if (handler == &vgaph.uega || handler == &vgaph.lin4) {
+		const auto to_offset = (handler == &vgaph.uega) ? planar_offset
+		                                                : lin4_offset;
+		for (Bitu i = 0; i < num_bytes; ++i) {
+			const auto val = vgaph.uega.readHandler(
+			        to_offset(src + i, read_bank));
+			const auto offset = to_offset(dest + i, write_bank);
+			MEM_CHANGED(offset << 3);
+			vgaph.uega.writeHandler(offset, val);
+		}
+	} else if (handler == &vgaph.cvga) {
+		using Chained = VGA_ChainedVGA_Handler;
+		for (Bitu i = 0; i < num_bytes; ++i) {
+			const auto val = Chained::readHandler_byte(
+			        chained_offset(src + i, read_bank));
+			const auto offset = chained_offset(dest + i, write_bank);
+			MEM_CHANGED(offset);
+			Chained::writeHandler_byte(offset, val);
+			Chained::writeCache_byte(offset, val);
+		}
+	} else {
+		return false;
+	}
+	read_delay(static_cast<int32_t>(num_bytes));
+	write_delay(static_cast<int32_t>(num_bytes));
+	return true;
+}
+
+bool VGA_BlockFill(const PhysPt dest, const uint8_t val, const Bitu num_bytes)
+{
+	if (!num_bytes) {
+		return true;
+	}
+	const auto handler = get_block_handler(dest, num_bytes);
+	if (!handler) {
+		return false;
+	}
+	const auto write_bank = vga.svga.bank_write_full;
+
+	if (handler == &vgaph.uega || handler == &vgaph.lin4) {
+		const auto to_offset = (handler == &vgaph.uega) ? planar_offset
+		                                                : lin4_offset;
+		for (Bitu i = 0; i < num_bytes; ++i) {
+			const auto offset = to_offset(dest + i, write_bank);
+			MEM_CHANGED(offset << 3);
+			vgaph.uega.writeHandler(offset, val);
+		}
+	} else if (handler == &vgaph.cvga) {
+		using Chained = VGA_ChainedVGA_Handler;
+		for (Bitu i = 0; i < num_bytes; ++i) {
+			const auto offset = chained_offset(dest + i, write_bank);
+			MEM_CHANGED(offset);
+			Chained::writeHandler_byte(offset, val);
+			Chained::writeCache_byte(offset, val);
+		}
+	} else {
+		return false;
+	}
+	write_delay(static_cast<int32_t>(num_bytes));
+	return true;
+}
+
 void VGA_ChangedBank(void) {
 #ifndef VGA_LFB_MAPPED
 	//If the mode is accurate than the correct mapper must have been installed already
@@ -1219,6 +1387,8 @@ void VGA_SetupMemory(Section* sec)
 	                                                           num_fastmem_bytes);
 	assert(reinterpret_cast<uintptr_t>(vga.fastmem) % vmem_alignment == 0);
 
+	HOSTMEM_SetUsage("Video memory", num_linear_bytes + num_fastmem_bytes);
+
 	// In most cases these values stay the same. Assumptions: vmemwrap is power of 2,
 	// vmemwrap <= vmemsize, fastmem implicitly has mem wrap twice as big
 	vga.vmemwrap = vga.vmemsize;
@@ -1352,7 +1352,7 @@ void VGA_SetupOther()
 	vga.tandy.line_shift = 13;
 
 	if (machine==MCH_CGA || IS_TANDY_ARCH) {
-		extern uint8_t int10_font_08[256 * 8];
+		extern const uint8_t int10_font_08[256 * 8];
 		for (int i = 0; i < 256; ++i) {
 			memcpy(&vga.draw.font[i * 32], &int10_font_08[i * 8], 8);
 		}
@@ -1363,7 +1363,7 @@ void VGA_SetupOther()
 		IO_RegisterWriteHandler(0x3dc, write_lightpen, io_width_t::byte);
 	}
 	if (machine==MCH_HERC) {
-		extern uint8_t int10_font_14[256 * 14];
+		extern const uint8_t int10_font_14[256 * 14];
 		for (int i = 0; i < 256; ++i) {
 			memcpy(&vga.draw.font[i * 32], &int10_font_14[i * 14], 14);
 		}
@@ -21,6 +21,7 @@
 
 #include "dosbox.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstdio>
@@ -270,6 +271,288 @@ static Bitu GetMixResult(uint32_t mixmode, Bitu srcval, Bitu dstdata)
 	return destval;
 }
 
+// Row-based fast paths for the rectangle, pattern and blit commands.
+// They work on the video memory directly instead of going through
+// XGA_GetPoint and XGA_DrawPoint per pixel, and only take rows entirely
+// within the video memory; the per-pixel code draws the others.
+
+static int xga_bytes_per_pixel()
+{
+	switch (XGA_COLOR_MODE) {
+	case M_LIN8: return 1;
+	case M_LIN15:
+	case M_LIN16: return 2;
+	case M_LIN32: return 4;
+	default: return 0;
+	}
+}
+
+// The bits kept by XGA_DrawPoint
+static uint32_t xga_pixel_mask()
+{
+	switch (XGA_COLOR_MODE) {
+	case M_LIN8: return 0xff;
+	case M_LIN15: return 0x7fff;
+	case M_LIN16: return 0xffff;
+	default: return 0xffffffff;
+	}
+}
+
+// Calls the function with a value of the pixel type of the color mode
+template <typename Func>
+static void xga_with_pixel_type(Func&& func)
+{
+	switch (XGA_COLOR_MODE) {
+	case M_LIN8: func(uint8_t{}); break;
+	case M_LIN15:
+	case M_LIN16: func(uint16_t{}); break;
+	case M_LIN32: func(uint32_t{}); break;
+	default: break;
+	}
+}
+
+template <typename T>
+static T* xga_pixel_ptr(const Bits x, const Bits y)
+{
+	return reinterpret_cast<T*>(vga.mem.linear) + y * XGA_SCREEN_WIDTH + x;
+}
+
+// Offset of a pixel into the video memory, in pixels
+static Bits xga_pixel_offset(const Bits x, const Bits y)
+{
+	return y * XGA_SCREEN_WIDTH + x;
+}
+
+// Whether a run of pixels going left (dx -1) or right (dx 1) from x lies
+// entirely within the video memory
+static bool xga_span_in_vram(const Bits x, const Bits y, const Bits dx,
+                             const Bits count)
+{
+	const auto left = (dx > 0) ? x : x - (count - 1);
+	if (left < 0 || y < 0) {
+		return false;
+	}
+	const auto end = (xga_pixel_offset(left, y) + count) * xga_bytes_per_pixel();
+	return end <= static_cast<Bits>(vga.vmemsize);
+}
+
+// The pixels of a row that XGA_DrawPoint would draw, as the index of the
+// first one and their number
+struct XGAClip {
+	Bits first = 0;
+	Bits count = 0;
+};
+
+static XGAClip xga_clip_row(const Bits x, const Bits y, const Bits dx,
+                            const Bits len)
+{
+	if (!(xga.curcommand & 0x1) || !(xga.curcommand & 0x10) ||
+	    y < xga.scissors.y1 || y > xga.scissors.y2) {
+		return {};
+	}
+	Bits first = 0;
+	Bits last  = 0;
+	if (dx > 0) {
+		first = std::max<Bits>(0, xga.scissors.x1 - x);
+		last  = std::min<Bits>(len - 1, xga.scissors.x2 - x);
+	} else {
+		first = std::max<Bits>(0, x - xga.scissors.x2);
+		last  = std::min<Bits>(len - 1, x - xga.scissors.x1);
+	}
+	if (last < first) {
+		return {};
+	}
+	return {first, last - first + 1};
+}
+
+// Mixes a colour into a row, returns false if the per-pixel code has to
+// draw it
+static bool xga_fill_row(const Bits x, const Bits y, const Bits dx,
+                         const Bits len, const uint32_t mixmode, const Bitu srcval)
+{
+	const auto clip = xga_clip_row(x, y, dx, len);
+	if (!clip.count) {
+		return true;
+	}
+	const auto start = x + dx * clip.first;
+	if (!xga_span_in_vram(start, y, dx, clip.count)) {
+		return false;
+	}
+
+	// The pixels don't depend on each other, so go left to right
+	const auto left = (dx > 0) ? start : start - (clip.count - 1);
+	const auto mask = xga_pixel_mask();
+
+	xga_with_pixel_type([&](auto pixel_type) {
+		using T = decltype(pixel_type);
+		const auto dest = xga_pixel_ptr<T>(left, y);
+
+		if ((mixmode & 0xf) == 0x07) { // SRC
+			std::fill_n(dest, clip.count, static_cast<T>(srcval & mask));
+			return;
+		}
+		for (Bits i = 0; i < clip.count; ++i) {
+			dest[i] = static_cast<T>(GetMixResult(mixmode, srcval, dest[i]) & mask);
+		}
+	});
+	return true;
+}
+
+// Whether a mix takes its source from the PIX_TRANS register, which only
+// the per-pixel code handles (by logging it)
+static bool xga_mix_wants_pix_trans(const uint32_t mixmode)
+{
+	return ((mixmode >> 5) & 0x03) == 0x02;
+}
+
+static Bitu xga_mix_source(const uint32_t mixmode, const Bitu srcdata)
+{
+	switch ((mixmode >> 5) & 0x03) {
+	case 0x00: return xga.backcolor;
+	case 0x01: return xga.forecolor;
+	case 0x03: return srcdata;
+	default: return 0;
+	}
+}
+
+// Draws a row of the 8x8 pattern at patx/paty, returns false if the
+// per-pixel code has to draw it
+static bool xga_pattern_row(const Bits patx, const Bits paty, const Bits x,
+                            const Bits y, const Bits dx, const Bits len,
+                            const Bitu mixselect, const uint32_t mixmode)
+{
+	const auto clip = xga_clip_row(x, y, dx, len);
+	if (!clip.count) {
+		return true;
+	}
+	const auto start = x + dx * clip.first;
+	if (!xga_span_in_vram(start, y, dx, clip.count)) {
+		return false;
+	}
+	if (mixselect == 0x3 ? (xga_mix_wants_pix_trans(xga.foremix) ||
+	                        xga_mix_wants_pix_trans(xga.backmix))
+	                     : xga_mix_wants_pix_trans(mixmode)) {
+		return false;
+	}
+
+	const auto left    = (dx > 0) ? start : start - (clip.count - 1);
+	const auto pat_row = paty + (y & 0x7);
+
+	// Drawing over the pattern itself changes it along the way
+	const auto dest_offset = xga_pixel_offset(left, y);
+	const auto pat_offset  = xga_pixel_offset(patx, pat_row);
+	if (dest_offset < pat_offset + 8 && pat_offset < dest_offset + clip.count) {
+		return false;
+	}
+
+	Bitu pattern[8] = {};
+	for (Bits i = 0; i < 8; ++i) {
+		pattern[i] = XGA_GetPoint(patx + i, pat_row);
+	}
+
+	const auto mask = xga_pixel_mask();
+
+	xga_with_pixel_type([&](auto pixel_type) {
+		using T = decltype(pixel_type);
+		const auto dest = xga_pixel_ptr<T>(left, y);
+
+		if (mixselect != 0x3 && (mixmode & 0xf) == 0x07) { // SRC
+			for (Bits i = 0; i < clip.count; ++i) {
+				const auto srcdata = pattern[(left + i) & 0x7];
+				dest[i] = static_cast<T>(xga_mix_source(mixmode, srcdata) & mask);
+			}
+			return;
+		}
+		for (Bits i = 0; i < clip.count; ++i) {
+			const auto srcdata = pattern[(left + i) & 0x7];
+
+			// TODO lots of guessing here but best results this way
+			const auto mix = (mixselect == 0x3)
+			                       ? (srcdata ? xga.foremix : xga.backmix)
+			                       : mixmode;
+
+			const auto srcval = xga_mix_source(mix, srcdata);
+			dest[i] = static_cast<T>(GetMixResult(mix, srcval, dest[i]) & mask);
+		}
+	});
+	return true;
+}
+
+// Blits a row of pixels, returns false if the per-pixel code has to
+// draw it
+static bool xga_blit_row(const Bits srcx, const Bits srcy, const Bits x,
+                         const Bits y, const Bits dx, const Bits len,
+                         const Bitu mixselect, const uint32_t mixmode)
+{
+	const auto clip = xga_clip_row(x, y, dx, len);
+	if (!clip.count) {
+		return true;
+	}
+	const auto start     = x + dx * clip.first;
+	const auto src_start = srcx + dx * clip.first;
+	if (!xga_span_in_vram(start, y, dx, clip.count) ||
+	    !xga_span_in_vram(src_start, srcy, dx, clip.count)) {
+		return false;
+	}
+	if (mixselect == 0x3 ? (xga_mix_wants_pix_trans(xga.foremix) ||
+	                        xga_mix_wants_pix_trans(xga.backmix))
+	                     : xga_mix_wants_pix_trans(mixmode)) {
+		return false;
+	}
+
+	const auto dest_offset = xga_pixel_offset(start, y);
+	const auto src_offset  = xga_pixel_offset(src_start, srcy);
+
+	// A straight copy is a memmove, unless the pixels are copied onto
+	// the ones still to be read (the per-pixel code smears them then)
+	const auto is_smearing = (dx > 0)
+	                               ? (src_offset < dest_offset &&
+	                                  dest_offset < src_offset + clip.count)
+	                               : (src_offset > dest_offset &&
+	                                  dest_offset > src_offset - clip.count);
+
+	const auto is_copy = mixselect != 0x3 && ((mixmode >> 5) & 0x03) == 0x03 &&
+	                     (mixmode & 0xf) == 0x07;
+
+	if (is_copy && !is_smearing && XGA_COLOR_MODE != M_LIN15) {
+		const auto bytes = xga_bytes_per_pixel();
+		const auto first = (dx > 0) ? 0 : clip.count - 1;
+		std::memmove(vga.mem.linear + (dest_offset - first) * bytes,
+		             vga.mem.linear + (src_offset - first) * bytes,
+		             static_cast<size_t>(clip.count * bytes));
+		return true;
+	}
+
+	// Go in the same order as the per-pixel code, so overlapping blits
+	// give the same results
+	const auto mask = xga_pixel_mask();
+
+	xga_with_pixel_type([&](auto pixel_type) {
+		using T = decltype(pixel_type);
+		auto dest = xga_pixel_ptr<T>(start, y);
+		auto src  = xga_pixel_ptr<T>(src_start, srcy);
+
+		for (Bits i = 0; i < clip.count; ++i, dest += dx, src += dx) {
+			const Bitu srcdata = *src;
+
+			auto mix = mixmode;
+			if (mixselect == 0x3) {
+				if (srcdata == xga.forecolor) {
+					mix = xga.foremix;
+				} else if (srcdata == xga.backcolor) {
+					mix = xga.backmix;
+				} else {
+					/* Best guess otherwise */
+					mix = 0x67; /* Source is bitmap data, mix mode is src */
+				}
+			}
+			const auto srcval = xga_mix_source(mix, srcdata);
+			*dest = static_cast<T>(GetMixResult(mix, srcval, *dest) & mask);
+		}
+	});
+	return true;
+}
+
 static void XGA_DrawLineVector(const uint32_t val, const bool skip_last_pixel)
 {
 	// No work to do with a zero-length line
@@ -531,8 +814,18 @@ static void XGA_DrawRectangle(const uint32_t val, const bool skip_last_pixel)
 	// one pixel too wide (but don't underflow below zero).
 	const auto xrun = xga.MAPcount - (xga.MAPcount && skip_last_pixel);
 
+	// Solid fills with the foreground mix are done a row at a time
+	const auto is_fill = ((xga.pix_cntl >> 6) & 0x3) == 0x00 &&
+	                     ((xga.foremix >> 5) & 0x03) <= 0x01;
+
 	for (auto yat = 0; yat <= xga.MIPcount; ++yat) {
 		srcx = xga.curx;
+		if (is_fill && xga_fill_row(srcx, srcy, dx, xrun + 1, xga.foremix,
+		                            xga_mix_source(xga.foremix, 0))) {
+			srcx += dx * (xrun + 1);
+			srcy += dy;
+			continue;
+		}
 		for (auto xat = 0; xat <= xrun; ++xat) {
 			uint32_t mixmode = (xga.pix_cntl >> 6) & 0x3;
 			Bitu dstdata;
@@ -846,6 +1139,12 @@ void XGA_BlitRect(Bitu val) {
 		srcx = xga.curx;
 		tarx = xga.destx;
 
+		if (xga_blit_row(srcx, srcy, tarx, tary, dx, xga.MAPcount + 1, mixselect, mixmode)) {
+			srcy += dy;
+			tary += dy;
+			continue;
+		}
+
 		for(xat=0;xat<=xga.MAPcount;xat++) {
 			srcdata = XGA_GetPoint(srcx, srcy);
 			dstdata = XGA_GetPoint(tarx, tary);
@@ -932,6 +1231,10 @@ void XGA_DrawPattern(Bitu val) {
 
 	for(yat=0;yat<=xga.MIPcount;yat++) {
 		tarx = xga.destx;
+		if (xga_pattern_row(srcx, srcy, tarx, tary, dx, xga.MAPcount + 1, mixselect, mixmode)) {
+			tary += dy;
+			continue;
+		}
 		for(xat=0;xat<=xga.MAPcount;xat++) {
 
 			srcdata = XGA_GetPoint(srcx + (tarx & 0x7), srcy + (tary & 0x7));
@@ -79,24 +79,24 @@
 #include <array>
 #include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cmath>
 #include <condition_variable>
 #include <cstdlib>
 #include <cstring>
 #include <mutex>
+#include <numeric>
+#include <thread>
 
 #include <SDL.h>
 #include <SDL_cpuinfo.h> // for proper SSE defines for MSVC
 
-#if defined(__SSE2__)
-#include <emmintrin.h>
-#endif
-
 #include "bitops.h"
 #include "byteorder.h"
 #include "control.h"
 #include "cross.h"
 #include "fraction.h"
+#include "host_memory.h"
 #include "math_utils.h"
 #include "mem.h"
 #include "paging.h"
@@ -106,7 +106,11 @@
 #include "semaphore_internal.h"
 #include "setup.h"
 #include "support.h"
+#include "tracy.h"
 #include "vga.h"
+#include "voodoo.h"
+#include "voodoo_bilinear.h"
+#include "worker_pool.h"
 
 #ifndef DOSBOX_VOODOO_TYPES_H
 #define DOSBOX_VOODOO_TYPES_H
@@ -199,36 +203,6 @@ inline int32_t mul_32x32_shift(int32_t a, int32_t b, int8_t shift)
 	return (int32_t)(((int64_t)a * (int64_t)b) >> shift);
 }
 
-#if defined(__SSE2__)
-static int16_t sse2_scale_table[256][8];
-#endif
-
-inline rgb_t rgba_bilinear_filter(rgb_t rgb00, rgb_t rgb01, rgb_t rgb10,
-                                  rgb_t rgb11, uint8_t u, uint8_t v)
-{
-#if defined(__SSE2__)
-	const __m128i scale_u = *(__m128i*)sse2_scale_table[u];
-	const __m128i scale_v = *(__m128i*)sse2_scale_table[v];
-	return _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(_mm_srli_epi32(_mm_madd_epi16(_mm_max_epi16(
-		_mm_slli_epi32(_mm_madd_epi16(_mm_unpacklo_epi8(_mm_unpacklo_epi8(_mm_cvtsi32_si128(rgb01), _mm_cvtsi32_si128(rgb00)), _mm_setzero_si128()), scale_u), 15),
-		_mm_srli_epi32(_mm_madd_epi16(_mm_unpacklo_epi8(_mm_unpacklo_epi8(_mm_cvtsi32_si128(rgb11), _mm_cvtsi32_si128(rgb10)), _mm_setzero_si128()), scale_u), 1)),
-		scale_v), 15), _mm_setzero_si128()), _mm_setzero_si128()));
-#else
-	uint32_t ag0, ag1, rb0, rb1;
-	rb0 = (rgb00 & 0x00ff00ff) + ((((rgb01 & 0x00ff00ff) - (rgb00 & 0x00ff00ff)) * u) >> 8);
-	rb1 = (rgb10 & 0x00ff00ff) + ((((rgb11 & 0x00ff00ff) - (rgb10 & 0x00ff00ff)) * u) >> 8);
-	rgb00 >>= 8;
-	rgb01 >>= 8;
-	rgb10 >>= 8;
-	rgb11 >>= 8;
-	ag0 = (rgb00 & 0x00ff00ff) + ((((rgb01 & 0x00ff00ff) - (rgb00 & 0x00ff00ff)) * u) >> 8);
-	ag1 = (rgb10 & 0x00ff00ff) + ((((rgb11 & 0x00ff00ff) - (rgb10 & 0x00ff00ff)) * u) >> 8);
-	rb0 = (rb0 & 0x00ff00ff) + ((((rb1 & 0x00ff00ff) - (rb0 & 0x00ff00ff)) * v) >> 8);
-	ag0 = (ag0 & 0x00ff00ff) + ((((ag1 & 0x00ff00ff) - (ag0 & 0x00ff00ff)) * v) >> 8);
-	return ((ag0 << 8) & 0xff00ff00) | (rb0 & 0x00ff00ff);
-#endif
-}
-
 struct poly_vertex
 {
 	float		x;							/* X coordinate */
@@ -255,7 +229,16 @@ enum VoodooModel
 	VOODOO_2,
 };
 
-enum { TRIANGLE_THREADS = 3, TRIANGLE_WORKERS = TRIANGLE_THREADS + 1 };
+// The emulation thread rasterizes along with the triangle threads
+constexpr int DefaultTriangleThreads = 3;
+constexpr int MaxTriangleThreads     = 31;
+constexpr int MaxTriangleWorkers     = MaxTriangleThreads + 1;
+
+// Triangles are split into this many chunks of equal pixel counts per
+// worker. The workers take the next chunk as soon as they're done with
+// one, so none of them sits idle while the others are still busy with
+// the slower (e.g., more heavily textured) parts of a triangle.
+constexpr int TriangleChunksPerWorker = 4;
 
 /* maximum number of TMUs */
 #define MAX_TMU					2
@@ -695,6 +678,23 @@ struct stats_block {
 };
 static_assert(sizeof(stats_block) == 64);
 
+// Host-side counters for profiling the emulation; unlike the statistics
+// above, the guest never sees them
+struct perf_counters {
+	uint64_t frames    = 0;
+	uint64_t triangles = 0;
+
+	// Time the emulation waited for the triangle threads
+	int64_t stall_ns = 0;
+
+	// Indexed by worker, so the threads don't share counters
+	std::array<uint64_t, MaxTriangleWorkers> pixels = {};
+	std::array<int64_t, MaxTriangleWorkers> busy_ns = {};
+
+	// When counting started
+	int64_t start_ns = 0;
+};
+
 struct fifo_state
 {
 	int32_t				size;					/* size of the FIFO */
@@ -891,15 +891,21 @@ struct draw_state {
 
 struct triangle_worker
 {
-	std::atomic_bool threads_active;
 	bool use_threads, disable_bilinear_filter;
 	uint16_t *drawbuf;
 	poly_vertex v1, v2, v3;
 	int32_t v1y, v3y, totalpix;
-	std::array<std::thread, TRIANGLE_THREADS> threads;
-	std::array<Semaphore, TRIANGLE_THREADS> sembegin;
+	int num_threads;
+	int num_chunks;
+	// The triangle's generation in the upper and the next chunk to take
+	// in the lower half, so tasks starting late can't take chunks of the
+	// following triangle
+	std::atomic<uint64_t> next_chunk;
+	std::atomic_int chunks_done;
+	std::atomic_int num_running_tasks;
+	uint32_t generation;
+	bool is_pending;
 	Semaphore semdone;
-	int done_count;
 };
 
 struct voodoo_state
@@ -925,8 +931,11 @@ struct voodoo_state
 	                                                    rasterizers */
 #endif
 
-	stats_block thread_stats[TRIANGLE_WORKERS] = {}; /* per-thread
-	                                                    statistics */
+	stats_block thread_stats[MaxTriangleWorkers] = {}; /* per-thread
+	                                                      statistics */
+
+	perf_counters perf       = {}; /* since the card was initialized */
+	perf_counters frame_perf = {}; /* as of the start of the frame */
 
 	bool send_config   = {};
 	bool clock_enabled = {};
@@ -2080,7 +2089,7 @@ do																				\
 		}																		\
 																				\
 		/* weigh in each texel */												\
-		c_local.u = rgba_bilinear_filter(texel0, texel1, texel2, texel3, sfrac, tfrac);\
+		c_local.u = voodoo::bilinear_filter(texel0, texel1, texel2, texel3, sfrac, tfrac);\
 	}																			\
 																				\
 	/* select zero/other for RGB */												\
@@ -3005,6 +3014,7 @@ iterated W    = 18.32 [48 bits]
 static voodoo_state* v = nullptr;
 static auto vtype = VOODOO_1;
 static auto voodoo_multithreading     = true;
+static auto voodoo_num_threads        = DefaultTriangleThreads;
 static auto voodoo_bilinear_filtering = false;
 
 #define LOG_VOODOO LOG_PCI
@@ -3035,9 +3045,12 @@ static double Voodoo_GetHRetracePosition();
 static dither_lut_t dither2_lookup = {};
 static dither_lut_t dither4_lookup = {};
 
-static inline void raster_generic(const voodoo_state* vs, uint32_t TMUS, uint32_t TEXMODE0,
-                                  uint32_t TEXMODE1, void* destbase, int32_t y,
-                                  const poly_extent* extent, stats_block& stats)
+// Instantiated per number of TMUs in use, so the texture pipelines of
+// unused TMUs and their iterators drop out of the pixel loop
+template <uint32_t TMUS>
+static void raster_generic(const voodoo_state* vs, uint32_t TEXMODE0,
+                           uint32_t TEXMODE1, void* destbase, int32_t y,
+                           const poly_extent* extent, stats_block& stats)
 {
 	const uint8_t* dither_lookup = nullptr;
 	const uint8_t* dither4       = nullptr;
@@ -3131,13 +3144,13 @@ static inline void raster_generic(const voodoo_state* vs, uint32_t TMUS, uint32_
 	int64_t iters1 = 0;
 	int64_t itert0 = 0;
 	int64_t itert1 = 0;
-	if (TMUS >= 1)
+	if constexpr (TMUS >= 1)
 	{
 		iterw0 = tmu0.startw + dy * tmu0.dwdy + dx * tmu0.dwdx;
 		iters0 = tmu0.starts + dy * tmu0.dsdy + dx * tmu0.dsdx;
 		itert0 = tmu0.startt + dy * tmu0.dtdy + dx * tmu0.dtdx;
 	}
-	if (TMUS >= 2)
+	if constexpr (TMUS >= 2)
 	{
 		iterw1 = tmu1.startw + dy * tmu1.dwdy + dx * tmu1.dwdx;
 		iters1 = tmu1.starts + dy * tmu1.dsdy + dx * tmu1.dsdx;
@@ -3156,7 +3169,7 @@ static inline void raster_generic(const voodoo_state* vs, uint32_t TMUS, uint32_
 		/* run the texture pipeline on TMU1 to produce a value in texel */
 		/* note that they set LOD min to 8 to "disable" a TMU */
 
-		if (TMUS >= 2 && vs->tmu[1].lodmin < (8 << 8)) {
+		if (TMUS >= 2 && tmu1.lodmin < (8 << 8)) {
 			const tmu_state* const tmus = &vs->tmu[1];
 			const rgb_t* const lookup = tmus->lookup;
 			TEXTURE_PIPELINE(tmus, x, dither4, TEXMODE1, texel,
@@ -3430,13 +3443,13 @@ static inline void raster_generic(const voodoo_state* vs, uint32_t TMUS, uint32_
 		itera += fbi.dadx;
 		iterz += fbi.dzdx;
 		iterw += fbi.dwdx;
-		if (TMUS >= 1)
+		if constexpr (TMUS >= 1)
 		{
 			iterw0 += tmu0.dwdx;
 			iters0 += tmu0.dsdx;
 			itert0 += tmu0.dtdx;
 		}
-		if (TMUS >= 2)
+		if constexpr (TMUS >= 2)
 		{
 			iterw1 += tmu1.dwdx;
 			iters1 += tmu1.dsdx;
@@ -3790,6 +3803,60 @@ static void init_tmu(voodoo_state *vs, tmu_state *t, voodoo_reg *reg, int tmem)
  *
  *************************************/
 
+static int64_t perf_now_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+	               std::chrono::steady_clock::now().time_since_epoch())
+	        .count();
+}
+
+static int perf_num_workers(const voodoo_state* vs)
+{
+	// The emulation thread takes chunks as well while waiting
+	return vs->tworker.use_threads ? vs->tworker.num_threads + 1 : 1;
+}
+
+static int64_t perf_busy_ns(const perf_counters& perf)
+{
+	return std::accumulate(perf.busy_ns.begin(), perf.busy_ns.end(), int64_t{0});
+}
+
+// Share of the time since the 'from' counters started that the triangle
+// workers were busy rasterizing
+static double perf_utilization(const voodoo_state* vs,
+                               const perf_counters& from, const int64_t now_ns)
+{
+	const auto busy_ns    = perf_busy_ns(vs->perf) - perf_busy_ns(from);
+	const auto elapsed_ns = (now_ns - from.start_ns) * perf_num_workers(vs);
+
+	return elapsed_ns > 0 ? static_cast<double>(busy_ns) / elapsed_ns : 0.0;
+}
+
+static uint64_t perf_pixels(const perf_counters& perf)
+{
+	return std::accumulate(perf.pixels.begin(), perf.pixels.end(), uint64_t{0});
+}
+
+static void plot_perf_counters(voodoo_state* vs)
+{
+	auto& perf = vs->perf;
+	auto& from = vs->frame_perf;
+
+	++perf.frames;
+	const auto now_ns = perf_now_ns();
+
+	TracyPlot("Voodoo triangles",
+	          static_cast<int64_t>(perf.triangles - from.triangles));
+	TracyPlot("Voodoo pixels",
+	          static_cast<int64_t>(perf_pixels(perf) - perf_pixels(from)));
+	TracyPlot("Voodoo worker utilization",
+	          100.0 * perf_utilization(vs, from, now_ns));
+	TracyPlot("Voodoo stall time (us)", (perf.stall_ns - from.stall_ns) / 1000);
+
+	from          = perf;
+	from.start_ns = now_ns;
+}
+
 static void voodoo_swap_buffers(voodoo_state *vs)
 {
 	//if (LOG_VBLANK_SWAP) LOG(LOG_VOODOO,LOG_WARN)("--- swap_buffers @ %d\n", video_screen_get_vpos(vs->screen));
@@ -3801,6 +3868,8 @@ static void voodoo_swap_buffers(voodoo_state *vs)
 	}
 #endif
 
+	plot_perf_counters(vs);
+
 	/* keep a history of swap intervals */
 	const auto regs = vs->reg;
 
@@ -4302,8 +4371,11 @@ static void update_statistics(voodoo_state *vs, bool accumulate)
     COMMAND HANDLERS
 ***************************************************************************/
 
-static void triangle_worker_work(triangle_worker& tworker, int32_t worktstart, int32_t worktend)
+static void triangle_worker_work(triangle_worker& tworker, const int worker,
+                                 const int32_t chunk_start, const int32_t chunk_end)
 {
+	const auto start_ns = perf_now_ns();
+
 	/* determine the number of TMUs involved */
 	uint32_t tmus     = 0;
 	uint32_t texmode0 = 0;
@@ -4336,10 +4408,18 @@ static void triangle_worker_work(triangle_worker& tworker, int32_t worktstart, i
 	const float dxdy_v2v3 = (v3.y == v2.y) ? 0.0f
 	                                       : (v3.x - v2.x) / (v3.y - v2.y);
 
+	using raster_func = void (*)(const voodoo_state*, uint32_t, uint32_t,
+	                             void*, int32_t, const poly_extent*, stats_block&);
+	const raster_func raster = (tmus == 2)   ? raster_generic<2>
+	                           : (tmus == 1) ? raster_generic<1>
+	                                         : raster_generic<0>;
+
 	stats_block my_stats = {};
 
-	const int32_t from = tworker.totalpix * worktstart / TRIANGLE_WORKERS;
-	const int32_t to   = tworker.totalpix * worktend / TRIANGLE_WORKERS;
+	const auto from = static_cast<int32_t>(int64_t{tworker.totalpix} *
+	                                       chunk_start / tworker.num_chunks);
+	const auto to = static_cast<int32_t>(int64_t{tworker.totalpix} *
+	                                     chunk_end / tworker.num_chunks);
 
 	for (int32_t curscan = tworker.v1y, scanend = tworker.v3y, sumpix = 0, lastsum = 0;
 	     curscan != scanend && lastsum < to;
@@ -4380,42 +4460,63 @@ static void triangle_worker_work(triangle_worker& tworker, int32_t worktstart, i
 			extent.stopx -= (sumpix - to);
 		}
 
-		raster_generic(v, tmus, texmode0, texmode1, tworker.drawbuf, curscan, &extent, my_stats);
+		raster(v, texmode0, texmode1, tworker.drawbuf, curscan, &extent, my_stats);
 	}
-	sum_statistics(&v->thread_stats[worktstart], &my_stats);
+	sum_statistics(&v->thread_stats[worker], &my_stats);
+
+	v->perf.pixels[worker] += static_cast<uint32_t>(my_stats.pixels_in);
+	v->perf.busy_ns[worker] += perf_now_ns() - start_ns;
 }
 
-static int triangle_worker_thread_func(int32_t p)
+// Returns true if the last chunk of the triangle was done by the caller
+static bool triangle_worker_take_chunks(triangle_worker& tworker,
+                                        const uint32_t generation, const int worker)
 {
-	triangle_worker& tworker = v->tworker;
-	for (const int32_t tnum = p; tworker.threads_active;) {
-		tworker.sembegin[tnum].wait();
-		if (tworker.threads_active) {
-			triangle_worker_work(tworker, tnum, tnum + 1);
+	const auto num_chunks = static_cast<uint32_t>(tworker.num_chunks);
+
+	bool did_last_chunk = false;
+	auto next = tworker.next_chunk.load();
+	while ((next >> 32) == generation && (next & 0xffffffff) < num_chunks) {
+		if (!tworker.next_chunk.compare_exchange_weak(next, next + 1)) {
+			continue;
 		}
-		tworker.semdone.notify();
+		const auto chunk = static_cast<int32_t>(next & 0xffffffff);
+		triangle_worker_work(tworker, worker, chunk, chunk + 1);
+
+		did_last_chunk = (++tworker.chunks_done == tworker.num_chunks);
+		next = tworker.next_chunk.load();
 	}
-	return 0;
+	return did_last_chunk;
 }
 
-static void triangle_worker_shutdown(triangle_worker& tworker)
+// The chunks are rasterized by tasks on the shared worker pool while the
+// emulation continues, until the next access to the card (or the display
+// refresh) waits for them. The waiting thread takes the chunks no task
+// has started on yet, so it never waits for the pool to get around to
+// them.
+static void triangle_worker_wait(triangle_worker& tworker)
 {
-	if (!tworker.threads_active) {
+	if (!tworker.is_pending) {
 		return;
 	}
-	tworker.threads_active = false;
-	for (size_t i = 0; i != TRIANGLE_THREADS; i++) {
-		tworker.sembegin[i].notify();
-	}
-
-	for (size_t i = 0; i != TRIANGLE_THREADS; i++) {
+	const auto start_ns = perf_now_ns();
+	if (!triangle_worker_take_chunks(tworker,
+	                                 tworker.generation,
+	                                 tworker.num_threads)) {
 		tworker.semdone.wait();
 	}
+	tworker.is_pending = false;
+	v->perf.stall_ns += perf_now_ns() - start_ns;
+}
 
-	for (auto& thread : tworker.threads) {
-		if (thread.joinable()) {
-			thread.join();
-		}
+static void triangle_worker_shutdown(triangle_worker& tworker)
+{
+	triangle_worker_wait(tworker);
+
+	// Tasks that started late still look at the state before finding
+	// nothing left to do
+	while (tworker.num_running_tasks > 0) {
+		std::this_thread::yield();
 	}
 }
 
@@ -4425,7 +4526,7 @@ static void triangle_worker_run(triangle_worker& tworker)
 	{
 		// do not use threaded calculation
 		tworker.totalpix = 0xFFFFFFF;
-		triangle_worker_work(tworker, 0, TRIANGLE_WORKERS);
+		triangle_worker_work(tworker, 0, 0, tworker.num_chunks);
 		return;
 	}
 
@@ -4464,28 +4565,24 @@ static void triangle_worker_run(triangle_worker& tworker)
 	// Don't wake up threads for just a few pixels
 	if (tworker.totalpix <= 200)
 	{
-		triangle_worker_work(tworker, 0, TRIANGLE_WORKERS);
+		triangle_worker_work(tworker, 0, 0, tworker.num_chunks);
 		return;
 	}
 
-	if (!tworker.threads_active)
-	{
-		tworker.threads_active = true;
-
-		int worker_id = 0;
-		for (auto& triangle_worker : tworker.threads) {
-			triangle_worker = std::thread([worker_id] {
-				triangle_worker_thread_func(worker_id);
-			});
-			++worker_id;
-		}
-	}
-	for (auto& begin_semaphore : tworker.sembegin) {
-		begin_semaphore.notify();
-	}
-	triangle_worker_work(tworker, TRIANGLE_THREADS, TRIANGLE_WORKERS);
-	for (size_t i = 0; i != TRIANGLE_THREADS; i++) {
-		tworker.semdone.wait();
+	const auto generation = ++tworker.generation;
+	tworker.chunks_done   = 0;
+	tworker.next_chunk    = uint64_t{generation} << 32;
+	tworker.is_pending    = true;
+
+	for (int worker_id = 0; worker_id != tworker.num_threads; ++worker_id) {
+		++tworker.num_running_tasks;
+		auto task = [&tworker, generation, worker_id] {
+			if (triangle_worker_take_chunks(tworker, generation, worker_id)) {
+				tworker.semdone.notify();
+			}
+			--tworker.num_running_tasks;
+		};
+		WORKERS_GetPool().Submit(WorkerPriority::Video, std::move(task));
 	}
 }
 
@@ -4692,6 +4789,7 @@ static void triangle(voodoo_state *vs)
 	}
 
 	triangle_worker& tworker = vs->tworker;
+	triangle_worker_wait(tworker);
 	tworker.v1 = *v1, tworker.v2 = *v2, tworker.v3 = *v3;
 	tworker.drawbuf = drawbuf;
 	tworker.v1y = v1y;
@@ -4700,6 +4798,7 @@ static void triangle(voodoo_state *vs)
 
 	/* update stats */
 	regs[fbiTrianglesOut].u++;
+	++vs->perf.triangles;
 }
 
 /*-------------------------------------------------
@@ -5934,8 +6033,93 @@ default_case:
  *  Voodoo LFB writes
  *
  *************************************/
+// Most LFB writes are pairs of 5-6-5 pixels written with the pixel pipeline
+// disabled, e.g., by titles drawing 2D overlays and movies. These are stored
+// in the frame buffer as-is (unless dithered or in BGR lane order), so they
+// skip lfb_w()'s generic format decoding and per-pixel checks.
+static bool lfb_w_565(const uint32_t offset, const uint32_t data,
+                      const uint32_t mem_mask)
+{
+	const auto lfb_mode = v->reg[lfbMode].u;
+
+	if (LFBMODE_WRITE_FORMAT(lfb_mode) != 0 ||
+	    LFBMODE_ENABLE_PIXEL_PIPELINE(lfb_mode) ||
+	    LFBMODE_WORD_SWAP_WRITES(lfb_mode) ||
+	    LFBMODE_BYTE_SWIZZLE_WRITES(lfb_mode) ||
+	    LFBMODE_WRITE_BUFFER_SELECT(lfb_mode) > 1) {
+		return false;
+	}
+#ifdef C_ENABLE_VOODOO_OPENGL
+	if (v->ogl && v->active) {
+		return false;
+	}
+#endif
+
+	const auto bufnum = LFBMODE_WRITE_BUFFER_SELECT(lfb_mode) == 0
+	                          ? v->fbi.frontbuf
+	                          : v->fbi.backbuf;
+
+	auto dest = reinterpret_cast<uint16_t*>(v->fbi.ram + v->fbi.rgboffs[bufnum]);
+	const auto destmax = (v->fbi.mask + 1 - v->fbi.rgboffs[bufnum]) / 2;
+
+	/* two 16-bit pixels per 32-bit word */
+	int x = (offset << 1) & ((1 << 10) - 1);
+	const int y = (offset >> 9) & ((1 << 10) - 1);
+
+	int scry = y;
+	if (LFBMODE_Y_ORIGIN(lfb_mode)) {
+		scry = (v->fbi.yorigin - y) & 0x3ff;
+	}
+	uint32_t bufoffs = scry * v->fbi.rowpixels + x;
+
+	const auto fbz_mode = v->reg[fbzMode].u;
+
+	const uint8_t* dither_lookup = nullptr;
+
+	[[maybe_unused]] const uint8_t* dither4 = nullptr;
+	[[maybe_unused]] const uint8_t* dither  = nullptr;
+
+	COMPUTE_DITHER_POINTERS(fbz_mode, y);
+
+	const auto is_bgr = (LFBMODE_RGBA_LANES(lfb_mode) & 1) != 0;
+	const auto is_stored_as_is = !is_bgr && !FBZMODE_ENABLE_DITHERING(fbz_mode);
+
+	for (auto pix = 0; pix < 2; ++pix, ++bufoffs, ++x) {
+		const auto shift = pix * 16;
+		if (((mem_mask >> shift) & 0xffff) == 0) {
+			continue;
+		}
+		/* track pixel writes to the frame buffer */
+		v->reg[fbiPixelsOut].u++;
+
+		if (bufoffs >= destmax) {
+			continue;
+		}
+		const auto pixel = static_cast<uint16_t>(data >> shift);
+		if (is_stored_as_is) {
+			dest[bufoffs] = pixel;
+			continue;
+		}
+		int r = 0;
+		int g = 0;
+		int b = 0;
+		if (is_bgr) {
+			EXTRACT_565_TO_888(pixel, b, g, r);
+		} else {
+			EXTRACT_565_TO_888(pixel, r, g, b);
+		}
+		APPLY_DITHER(fbz_mode, x, dither_lookup, r, g, b);
+		dest[bufoffs] = static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+	return true;
+}
+
 static void lfb_w(uint32_t offset, uint32_t data, uint32_t mem_mask) {
 	//LOG(LOG_VOODOO,LOG_WARN)("V3D:WR LFB offset %X value %08X", offset, data);
+	if (lfb_w_565(offset, data, mem_mask)) {
+		return;
+	}
+
 	uint16_t* dest  = {};
 	uint16_t* depth = {};
 
@@ -6951,6 +7135,8 @@ constexpr uint32_t next_addr(const uint32_t addr)
 
 static void voodoo_w(const uint32_t addr, const uint32_t data, const uint32_t mask)
 {
+	triangle_worker_wait(v->tworker);
+
 	const auto offset = (addr >> 2) & offset_mask;
 
 	if ((offset & offset_base) == 0) {
@@ -6962,8 +7148,10 @@ static void voodoo_w(const uint32_t addr, const uint32_t data, const uint32_t ma
 	}
 }
 
-static constexpr uint32_t voodoo_r(const uint32_t addr)
+static uint32_t voodoo_r(const uint32_t addr)
 {
+	triangle_worker_wait(v->tworker);
+
 	const auto offset = (addr >> 2) & offset_mask;
 
 	if ((offset & offset_base) == 0) {
@@ -7041,18 +7229,13 @@ static void voodoo_init() {
 
 		dither2_lookup = generate_dither_lut(dither_matrix_2x2);
 		dither4_lookup = generate_dither_lut(dither_matrix_4x4);
-
-#if defined(__SSE2__)
-		/* create sse2 scale table for rgba_bilinear_filter */
-		for (int16_t i = 0; i != 256; i++) {
-			sse2_scale_table[i][0] = sse2_scale_table[i][2] = sse2_scale_table[i][4] = sse2_scale_table[i][6] = i;
-			sse2_scale_table[i][1] = sse2_scale_table[i][3] = sse2_scale_table[i][5] = sse2_scale_table[i][7] = 256-i;
-		}
-#endif
 	}
 
 	v->tmu_config = 0x11;	// revision 1
 
+	v->perf.start_ns = perf_now_ns();
+	v->frame_perf    = v->perf;
+
 	uint32_t fbmemsize = 0;
 	uint32_t tmumem0 = 0;
 	uint32_t tmumem1 = 0;
@@ -7130,6 +7313,9 @@ static void voodoo_init() {
 		v->chipmask |= 0x04;
 		v->tmu_config |= 0x40;
 	}
+	HOSTMEM_SetUsage("3dfx Voodoo",
+	                 sizeof(voodoo_state) +
+	                         ((fbmemsize + tmumem0 + tmumem1) << 20));
 
 	/* initialize some registers */
 	v->pci.init_enable = 0;
@@ -7200,6 +7386,8 @@ static void voodoo_update_dimensions(void) {
 
 static void Voodoo_VerticalTimer(uint32_t /*val*/)
 {
+	triangle_worker_wait(v->tworker);
+
 	v->draw.frame_start = PIC_FullIndex();
 	PIC_AddEvent(Voodoo_VerticalTimer, v->draw.frame_period_ms);
 
@@ -7305,6 +7493,8 @@ static double Voodoo_GetHRetracePosition() {
 
 static void Voodoo_UpdateScreen()
 {
+	triangle_worker_wait(v->tworker);
+
 	// abort drawing
 	RENDER_EndUpdate(true);
 
@@ -7446,10 +7636,11 @@ static struct Voodoo_Real_PageHandler : public PageHandler {
 		// Is the address word-aligned?
 		if ((addr & 0b11) == 0) {
 			voodoo_w(addr, val, 0x0000ffff);
+			return;
 		}
 		// The address must be byte-aligned
 		assert((addr & 0b1) == 0);
-			voodoo_w(addr, static_cast<uint32_t>(val << 16), 0xffff0000);
+		voodoo_w(addr, static_cast<uint32_t>(val << 16), 0xffff0000);
 	}
 
 	uint32_t readd(PhysPt addr) override
@@ -7716,6 +7907,7 @@ static void voodoo_shutdown()
 
 	delete v;
 	v = nullptr;
+	HOSTMEM_SetUsage("3dfx Voodoo", 0);
 
 	PCI_RemoveDevice(PCI_SSTDevice::vendor, PCI_SSTDevice::device_voodoo_1);
 }
@@ -7731,6 +7923,8 @@ static void Voodoo_Startup() {
 	v->draw = {};
 
 	v->tworker.use_threads = voodoo_multithreading;
+	v->tworker.num_threads = voodoo_num_threads;
+	v->tworker.num_chunks  = (voodoo_num_threads + 1) * TriangleChunksPerWorker;
 	v->tworker.disable_bilinear_filter = (voodoo_bilinear_filtering == false);
 
 	// Switch the pagehandler now that v has been allocated and is in use
@@ -7738,6 +7932,23 @@ static void Voodoo_Startup() {
 	PAGING_InitTLB();
 }
 
+// The triangles are split between as many tasks on the shared worker pool,
+// more than it has threads would only queue up
+static int get_num_triangle_threads(const int requested)
+{
+	const auto max_threads = std::min(WORKERS_GetPool().GetMaxThreads(),
+	                                  MaxTriangleThreads);
+	if (requested > 0) {
+		return std::min(requested, max_threads);
+	}
+	// Leave one core to the emulation thread, which rasterizes as well
+	const auto num_cores = static_cast<int>(std::thread::hardware_concurrency());
+	if (num_cores <= 1) {
+		return std::min(DefaultTriangleThreads, max_threads);
+	}
+	return std::min(num_cores - 1, max_threads);
+}
+
 PageHandler* VOODOO_PCI_GetLFBPageHandler(Bitu page) {
 	return (page >= (voodoo_current_lfb>>12) && page < (voodoo_current_lfb>>12) + VOODOO_PAGES ? voodoo_pagehandler : nullptr);
 }
@@ -7746,6 +7957,35 @@ void VOODOO_Destroy(Section* /*sec*/) {
 	voodoo_shutdown();
 }
 
+void VOODOO_LogStats()
+{
+	if (!v) {
+		LOG_MSG("VOODOO: Not active");
+		return;
+	}
+	const auto& perf = v->perf;
+	const auto frames = std::max(perf.frames, uint64_t{1});
+
+	LOG_MSG("VOODOO: %" PRIu64 " frames, %.1f triangles and %.0f pixels per frame",
+	        perf.frames,
+	        static_cast<double>(perf.triangles) / frames,
+	        static_cast<double>(perf_pixels(perf)) / frames);
+
+	perf_counters since_start = {};
+	since_start.start_ns      = perf.start_ns;
+
+	LOG_MSG("VOODOO: Triangle workers %.1f%% busy, emulation waited %.2f ms per frame for them",
+	        100.0 * perf_utilization(v, since_start, perf_now_ns()),
+	        static_cast<double>(perf.stall_ns) / frames / 1e6);
+
+	for (int worker = 0; worker < perf_num_workers(v); ++worker) {
+		LOG_MSG("VOODOO: Worker %d rasterized %" PRIu64 " pixels in %.1f ms",
+		        worker,
+		        perf.pixels[worker],
+		        static_cast<double>(perf.busy_ns[worker]) / 1e6);
+	}
+}
+
 void VOODOO_Init(Section* sec)
 {
 	auto* section = dynamic_cast<Section_prop*>(sec);
@@ -7760,6 +8000,8 @@ void VOODOO_Init(Section* sec)
 	vtype = (memsize_pref == "4" ? VOODOO_1 : VOODOO_1_DTMU);
 
 	voodoo_multithreading = section->Get_bool("voodoo_multithreading");
+	voodoo_num_threads    = get_num_triangle_threads(
+	        section->Get_int("voodoo_threads"));
 	voodoo_bilinear_filtering = section->Get_bool("voodoo_bilinear_filtering");
 
 	sec->AddDestroyFunction(&VOODOO_Destroy,false);
@@ -7773,8 +8015,16 @@ void VOODOO_Init(Section* sec)
 	PCI_AddDevice(new PCI_SSTDevice());
 
 	// Log the startup
-	LOG_MSG("VOODOO: Initialized with %s MB of RAM, %smultithreading, and %sbilinear filtering",
-	        memsize_pref.c_str(),
-	        (voodoo_multithreading ? "" : "no "),
-	        (voodoo_bilinear_filtering ? "" : "no "));
+	if (voodoo_multithreading) {
+		LOG_MSG("VOODOO: Initialized with %s MB of RAM, multithreading (%d threads), "
+		        "and %sbilinear filtering",
+		        memsize_pref.c_str(),
+		        voodoo_num_threads + 1,
+		        (voodoo_bilinear_filtering ? "" : "no "));
+	} else {
+		LOG_MSG("VOODOO: Initialized with %s MB of RAM, no multithreading, "
+		        "and %sbilinear filtering",
+		        memsize_pref.c_str(),
+		        (voodoo_bilinear_filtering ? "" : "no "));
+	}
 }
@@ -0,0 +1,145 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_VOODOO_BILINEAR_H
+#define DOSBOX_VOODOO_BILINEAR_H
+
+// Bilinear blend of four ARGB texels, u and v being the fractional
+// positions between them in 1/256 steps. All channels are blended at
+// once: natively with SSE2 on x86 hosts, and through SIMDe on ARM hosts
+// where it maps to NEON. The per-channel reference gives the exact same
+// results, so every host renders the same pixels.
+
+// simde needs std::isnan
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "simde/x86/mmx.h"
+
+namespace voodoo {
+
+constexpr uint32_t bilinear_filter_reference(const uint32_t rgb00,
+                                             const uint32_t rgb01,
+                                             const uint32_t rgb10,
+                                             const uint32_t rgb11,
+                                             const uint8_t u, const uint8_t v)
+{
+	uint32_t result = 0;
+	for (int shift = 0; shift < 32; shift += 8) {
+		const auto c00 = static_cast<int32_t>((rgb00 >> shift) & 0xff);
+		const auto c01 = static_cast<int32_t>((rgb01 >> shift) & 0xff);
+		const auto c10 = static_cast<int32_t>((rgb10 >> shift) & 0xff);
+		const auto c11 = static_cast<int32_t>((rgb11 >> shift) & 0xff);
+
+		// The rows are halved to fit 16-bit lanes before the
+		// vertical blend
+		const auto top    = (c00 * (256 - u) + c01 * u) >> 1;
+		const auto bottom = (c10 * (256 - u) + c11 * u) >> 1;
+		const auto blended = (top * (256 - v) + bottom * v) >> 15;
+
+		result |= static_cast<uint32_t>(blended) << shift;
+	}
+	return result;
+}
+
+#if defined(__SSE2__)
+inline uint32_t bilinear_filter_sse2(const uint32_t rgb00, const uint32_t rgb01,
+                                     const uint32_t rgb10, const uint32_t rgb11,
+                                     const uint8_t u, const uint8_t v)
+{
+	// 16-bit lane pairs of (weight of the second texel, the first's)
+	const __m128i scale_u = _mm_set1_epi32(((256 - u) << 16) | u);
+	const __m128i scale_v = _mm_set1_epi32(((256 - v) << 16) | v);
+	const __m128i zero    = _mm_setzero_si128();
+
+	const auto row = [&](const uint32_t left, const uint32_t right) {
+		const __m128i texels = _mm_unpacklo_epi8(
+		        _mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(right)),
+		                          _mm_cvtsi32_si128(static_cast<int>(left))),
+		        zero);
+		return _mm_madd_epi16(texels, scale_u);
+	};
+
+	// Pack the halved rows into lane pairs of (bottom, top), the top
+	// row's lowest bit lands in the sign of the bottom's lane and
+	// gets dropped by the max
+	const __m128i rows = _mm_max_epi16(_mm_slli_epi32(row(rgb00, rgb01), 15),
+	                                   _mm_srli_epi32(row(rgb10, rgb11), 1));
+
+	const __m128i blended = _mm_srli_epi32(_mm_madd_epi16(rows, scale_v), 15);
+	return static_cast<uint32_t>(_mm_cvtsi128_si32(
+	        _mm_packus_epi16(_mm_packs_epi32(blended, zero), zero)));
+}
+#endif
+
+inline uint32_t bilinear_filter_simde(const uint32_t rgb00, const uint32_t rgb01,
+                                      const uint32_t rgb10, const uint32_t rgb11,
+                                      const uint8_t u, const uint8_t v)
+{
+	const simde__m64 scale_u = simde_mm_set1_pi32(((256 - u) << 16) | u);
+	const simde__m64 scale_v = simde_mm_set1_pi32(((256 - v) << 16) | v);
+	const simde__m64 zero    = simde_mm_setzero_si64();
+
+	// Four 16-bit lanes holding a row's halved blend per channel
+	const auto row = [&](const uint32_t left, const uint32_t right) {
+		const simde__m64 texels = simde_mm_unpacklo_pi8(
+		        simde_mm_cvtsi32_si64(static_cast<int32_t>(right)),
+		        simde_mm_cvtsi32_si64(static_cast<int32_t>(left)));
+		const auto blend = [&](const simde__m64 lanes) {
+			return simde_mm_srli_pi32(simde_mm_madd_pi16(lanes, scale_u), 1);
+		};
+		return simde_mm_packs_pi32(blend(simde_mm_unpacklo_pi8(texels, zero)),
+		                           blend(simde_mm_unpackhi_pi8(texels, zero)));
+	};
+
+	const simde__m64 top    = row(rgb00, rgb01);
+	const simde__m64 bottom = row(rgb10, rgb11);
+
+	const auto blend = [&](const simde__m64 lanes) {
+		return simde_mm_srli_pi32(simde_mm_madd_pi16(lanes, scale_v), 15);
+	};
+	const simde__m64 blended = simde_mm_packs_pi32(
+	        blend(simde_mm_unpacklo_pi16(bottom, top)),
+	        blend(simde_mm_unpackhi_pi16(bottom, top)));
+
+	return static_cast<uint32_t>(
+	        simde_mm_cvtsi64_si32(simde_mm_packs_pu16(blended, zero)));
+}
+
+inline uint32_t bilinear_filter(const uint32_t rgb00, const uint32_t rgb01,
+                                const uint32_t rgb10, const uint32_t rgb11,
+                                const uint8_t u, const uint8_t v)
+{
+#if defined(__SSE2__)
+	return bilinear_filter_sse2(rgb00, rgb01, rgb10, rgb11, u, v);
+#elif defined(__ARM_NEON)
+	return bilinear_filter_simde(rgb00, rgb01, rgb10, rgb11, u, v);
+#else
+	return bilinear_filter_reference(rgb00, rgb01, rgb10, rgb11, u, v);
+#endif
+}
+
+} // namespace voodoo
+
+#endif
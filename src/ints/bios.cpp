@@ -387,6 +387,17 @@ static Bitu INT1A_Handler(void) {
 	return CBRET_NONE;
 }	
 
+// Timer tick reads are often polled for delays; serve them without leaving
+// the CPU core
+static bool INT1A_FastHandler()
+{
+	if (reg_ah != 0x00) {
+		return false;
+	}
+	INT1A_Handler();
+	return true;
+}
+
 static Bitu INT11_Handler(void) {
 	reg_ax=mem_readw(BIOS_CONFIGURATION);
 	return CBRET_NONE;
@@ -1254,6 +1265,7 @@ public:
 
 		/* INT 1A TIME and some other functions */
 		callback[6].Install(&INT1A_Handler,CB_IRET_STI,"Int 1a Time");
+		callback[6].SetFastHandler(&INT1A_FastHandler);
 		callback[6].Set_RealVec(0x1A);
 
 		/* INT 1C System Timer tick called from INT 8 */
@@ -20,15 +20,26 @@
 
 #include <algorithm>
 #include <cassert>
+#include <limits>
 #include <utility>
 
+#if defined(HAVE_MMAP)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 #include "callback.h"
+#include "compressed_image.h"
+#include "control.h"
+#include "disk_delta.h"
 #include "regs.h"
 #include "mem.h"
 #include "dos_inc.h" /* for Drives[] */
 #include "drives.h"
 #include "mapper.h"
 #include "string_utils.h"
+#include "tracy.h"
 
 diskGeo DiskGeometryList[] = {
 	{ 160,  8, 1, 40, 0},	// SS/DD 5.25"
@@ -164,22 +175,206 @@ uint8_t imageDisk::Read_Sector(uint32_t head,uint32_t cylinder,uint32_t sector,v
 	return Read_AbsoluteSector(sectnum, data);
 }
 
+// Sectors kept around, 2 MB with the usual 512-byte sectors
+constexpr uint32_t MaxCachedSectors = 4096;
+
+// Cached writes go out once this many pile up
+constexpr uint32_t MaxDirtySectors = 128;
+
+// Read along with a sector that isn't cached yet, more of them when the
+// sectors are read one after the other
+constexpr uint32_t ReadAheadSectors           = 8;
+constexpr uint32_t SequentialReadAheadSectors = 64;
+
+// Maps the whole image, so reading and writing its sectors are copies and
+// the host's page cache does the reading ahead and writing back
+void imageDisk::MapImage()
+{
+#if defined(HAVE_MMAP)
+	const auto file = cross_fileno(diskimg);
+	if (file == -1) {
+		return;
+	}
+	struct stat file_stat;
+	if (fstat(file, &file_stat) != 0 || !S_ISREG(file_stat.st_mode) ||
+	    file_stat.st_size <= 0 ||
+	    static_cast<uint64_t>(file_stat.st_size) >
+	            std::numeric_limits<size_t>::max()) {
+		return;
+	}
+	const auto access_mode = fcntl(file, F_GETFL) & O_ACCMODE;
+	const auto is_writable = (access_mode == O_RDWR);
+
+	const auto num_bytes = static_cast<size_t>(file_stat.st_size);
+	void* mem = mmap(nullptr,
+	                 num_bytes,
+	                 is_writable ? PROT_READ | PROT_WRITE : PROT_READ,
+	                 MAP_SHARED,
+	                 file,
+	                 0);
+	if (mem == MAP_FAILED) {
+		LOG_WARNING("BIOSDISK: Could not map '%s', reading it instead: %s",
+		            diskname,
+		            strerror(errno));
+		return;
+	}
+	mapped_data        = static_cast<uint8_t*>(mem);
+	mapped_size        = num_bytes;
+	is_mapped_writable = is_writable;
+#endif
+}
+
+// Sectors past the end of the mapping, or written while it's read-only,
+// go through the file instead
+uint8_t* imageDisk::GetMappedSector(const uint32_t sectnum,
+                                    const bool for_writing) const
+{
+	if (!mapped_data || (for_writing && !is_mapped_writable) ||
+	    !deltas.empty()) {
+		return nullptr;
+	}
+	const auto bytenum = static_cast<uint64_t>(sectnum) * sector_size;
+	if (bytenum + sector_size > mapped_size) {
+		return nullptr;
+	}
+	return mapped_data + bytenum;
+}
+
 uint8_t imageDisk::Read_AbsoluteSector(uint32_t sectnum, void *data)
+{
+	ZoneScoped;
+	if (const auto sector = GetMappedSector(sectnum, false); sector) {
+		memcpy(data, sector, sector_size);
+		return 0x00;
+	}
+
+	const auto is_sequential = last_read_sectnum &&
+	                           sectnum == *last_read_sectnum + 1;
+	last_read_sectnum = sectnum;
+
+	if (const auto it = sector_cache.find(sectnum); it != sector_cache.end()) {
+		auto& cached = it->second;
+		lru_sectors.splice(lru_sectors.begin(), lru_sectors, cached.lru_pos);
+		memcpy(data, cached.data.data(), sector_size);
+		return 0x00;
+	}
+
+	// Stop short of the next cached sector, it might be newer than the
+	// sector in the image
+	const auto max_sectors = is_sequential ? SequentialReadAheadSectors
+	                                       : ReadAheadSectors;
+	uint32_t num_sectors = 1;
+	while (num_sectors < max_sectors && sectnum + num_sectors > sectnum &&
+	       !sector_cache.count(sectnum + num_sectors)) {
+		++num_sectors;
+	}
+	return ReadFromImage(sectnum, num_sectors, static_cast<uint8_t*>(data));
+}
+
+// Reads the sector into data and caches it along with the ones after it
+uint8_t imageDisk::ReadFromImage(const uint32_t sectnum,
+                                 const uint32_t num_sectors, uint8_t* data)
 {
 	const auto bytenum = check_cast<cross_off_t>(sectnum) * sector_size;
 
+	std::vector<uint8_t> buffer(num_sectors * sector_size);
+	const auto num_bytes = ReadBytes(bytenum, buffer);
+	if (!num_bytes) {
+		LOG_ERR("BIOSDISK: Could not read sector %u from file '%s'",
+		        sectnum, diskname);
+		return 0xff;
+	}
+	const auto ret = *num_bytes;
+
+	// A sector that's cut short by the end of the image gets as much as
+	// was there, and isn't cached
+	memcpy(data, buffer.data(), std::min(ret, static_cast<size_t>(sector_size)));
+
+	const auto num_read = static_cast<uint32_t>(ret / sector_size);
+	for (uint32_t i = 0; i < num_read; ++i) {
+		memcpy(CacheSector(sectnum + i).data.data(),
+		       buffer.data() + i * sector_size,
+		       sector_size);
+	}
+	return 0x00;
+}
+
+// Reads the bytes from the image file with the blocks of the deltas copied
+// over them, and returns how many of them the image file had
+std::optional<size_t> imageDisk::ReadBytes(const cross_off_t bytenum,
+                                           std::vector<uint8_t>& buffer)
+{
 	if (last_action == WRITE || bytenum != current_fpos) {
 		if (cross_fseeko(diskimg, bytenum, SEEK_SET) != 0) {
-			LOG_ERR("BIOSDISK: Could not seek to sector %u in file '%s': %s",
-			        sectnum, diskname, strerror(errno));
-			return 0xff;
+			LOG_ERR("BIOSDISK: Could not seek to byte %lld in file '%s': %s",
+			        static_cast<long long int>(bytenum),
+			        diskname,
+			        strerror(errno));
+			return {};
 		}
 	}
-	size_t ret = fread(data, 1, sector_size, diskimg);
-	current_fpos=bytenum+ret;
-	last_action=READ;
+	size_t ret = 0;
+	if (compressed) {
+		const auto offset   = static_cast<uint64_t>(bytenum);
+		const auto num_read = compressed->Read(offset,
+		                                       buffer.size(),
+		                                       buffer.data());
+		if (!num_read) {
+			return {};
+		}
+		ret = *num_read;
+	} else {
+		ret = fread(buffer.data(), 1, buffer.size(), diskimg);
+		current_fpos = bytenum + ret;
+		last_action  = READ;
+	}
 
-	return 0x00;
+	const auto offset = static_cast<uint64_t>(bytenum);
+	const auto num_bytes = static_cast<uint32_t>(buffer.size());
+	for (const auto& delta : deltas) {
+		if (!delta->ReadOver(offset, num_bytes, buffer.data())) {
+			LOG_ERR("BIOSDISK: Could not read from delta file '%s'",
+			        delta->GetPath().string().c_str());
+			return {};
+		}
+	}
+	return ret;
+}
+
+// Returns the sector's cache entry, making room for it if it isn't cached
+imageDisk::CachedSector& imageDisk::CacheSector(const uint32_t sectnum)
+{
+	if (const auto it = sector_cache.find(sectnum); it != sector_cache.end()) {
+		auto& cached = it->second;
+		lru_sectors.splice(lru_sectors.begin(), lru_sectors, cached.lru_pos);
+		return cached;
+	}
+
+	std::vector<uint8_t> data = {};
+	if (sector_cache.size() >= MaxCachedSectors) {
+		const auto oldest = sector_cache.find(lru_sectors.back());
+		if (oldest->second.is_dirty) {
+			Flush();
+		}
+		data = std::move(oldest->second.data);
+		sector_cache.erase(oldest);
+		lru_sectors.pop_back();
+	}
+	data.resize(sector_size);
+
+	lru_sectors.push_front(sectnum);
+	auto& cached   = sector_cache[sectnum];
+	cached.data    = std::move(data);
+	cached.lru_pos = lru_sectors.begin();
+	return cached;
+}
+
+void imageDisk::ClearCache()
+{
+	sector_cache.clear();
+	lru_sectors.clear();
+	num_dirty         = 0;
+	last_read_sectnum = {};
 }
 
 uint8_t imageDisk::Write_Sector(uint32_t head,uint32_t cylinder,uint32_t sector,void * data) {
@@ -190,10 +385,55 @@ uint8_t imageDisk::Write_Sector(uint32_t head,uint32_t cylinder,uint32_t sector,
 	return Write_AbsoluteSector(sectnum, data);
 }
 
-
 uint8_t imageDisk::Write_AbsoluteSector(uint32_t sectnum, void *data) {
+	ZoneScoped;
+	if (const auto mapped = GetMappedSector(sectnum, true); mapped) {
+		memcpy(mapped, data, sector_size);
+		return 0x00;
+	}
+
+	const auto sector = static_cast<const uint8_t*>(data);
+
+	// Written through until the image took a write, so the writes to
+	// read-only images fail right away
+	if (!is_writable) {
+		const auto result = WriteToImage(sectnum, 1, sector);
+		if (result == 0x00) {
+			memcpy(CacheSector(sectnum).data.data(), sector, sector_size);
+		}
+		if (result != 0xff) {
+			is_writable = (result == 0x00);
+		}
+		return result;
+	}
+	if (!*is_writable) {
+		return 0x05;
+	}
+
+	auto& cached = CacheSector(sectnum);
+	memcpy(cached.data.data(), sector, sector_size);
+	if (!cached.is_dirty) {
+		cached.is_dirty = true;
+		++num_dirty;
+	}
+	if (num_dirty >= MaxDirtySectors) {
+		Flush();
+	}
+	return 0x00;
+}
+
+uint8_t imageDisk::WriteToImage(const uint32_t sectnum,
+                                const uint32_t num_sectors, const uint8_t* data)
+{
 	const auto bytenum = check_cast<cross_off_t>(sectnum) * sector_size;
 
+	if (!deltas.empty()) {
+		return WriteToDeltas(bytenum, num_sectors * sector_size, data);
+	}
+	if (compressed) {
+		return 0x05;
+	}
+
 	//LOG_MSG("Writing sectors to %ld at bytenum %d", sectnum, bytenum);
 
 	if (last_action == READ || bytenum != current_fpos) {
@@ -205,12 +445,191 @@ uint8_t imageDisk::Write_AbsoluteSector(uint32_t sectnum, void *data) {
 			return 0xff;
 		}
 	}
-	size_t ret = fwrite(data, 1, sector_size, diskimg);
+	size_t ret = fwrite(data, 1, num_sectors * sector_size, diskimg);
 	current_fpos=bytenum+ret;
 	last_action=WRITE;
 
 	return ((ret>0)?0x00:0x05);
+}
+
+void imageDisk::Flush()
+{
+	if (num_dirty == 0) {
+		return;
+	}
+	std::vector<uint32_t> dirty_sectors = {};
+	dirty_sectors.reserve(num_dirty);
+	for (auto& [sectnum, cached] : sector_cache) {
+		if (cached.is_dirty) {
+			dirty_sectors.push_back(sectnum);
+			cached.is_dirty = false;
+		}
+	}
+	num_dirty = 0;
+	std::sort(dirty_sectors.begin(), dirty_sectors.end());
+
+	// Consecutive sectors go out in a single write
+	std::vector<uint8_t> run = {};
+	for (size_t start = 0; start < dirty_sectors.size();) {
+		auto end = start + 1;
+		while (end < dirty_sectors.size() &&
+		       dirty_sectors[end] == dirty_sectors[end - 1] + 1) {
+			++end;
+		}
+		run.clear();
+		for (auto i = start; i < end; ++i) {
+			const auto& data = sector_cache[dirty_sectors[i]].data;
+			run.insert(run.end(), data.begin(), data.end());
+		}
+		const auto num_sectors = static_cast<uint32_t>(end - start);
+		if (WriteToImage(dirty_sectors[start], num_sectors, run.data()) != 0x00) {
+			LOG_ERR("BIOSDISK: Could not write %u sectors from sector %u to file '%s'",
+			        num_sectors,
+			        dirty_sectors[start],
+			        diskname);
+		}
+		start = end;
+	}
+}
+
+// Writes go to the top delta. Blocks that are only partly written are
+// filled in with what the image and the deltas hold first.
+uint8_t imageDisk::WriteToDeltas(const cross_off_t bytenum,
+                                 const uint32_t num_bytes, const uint8_t* data)
+{
+	auto& delta = *deltas.back();
+
+	const auto block_size = delta.GetBlockSize();
+	const auto offset     = static_cast<uint64_t>(bytenum);
+	const auto start      = offset / block_size * block_size;
+	const auto end = (offset + num_bytes + block_size - 1) / block_size *
+	                 block_size;
+
+	if (start == offset && end == offset + num_bytes) {
+		return delta.Write(offset, num_bytes, data) ? 0x00 : 0x05;
+	}
+	std::vector<uint8_t> blocks(end - start);
+	if (!ReadBytes(check_cast<cross_off_t>(start), blocks)) {
+		return 0xff;
+	}
+	memcpy(blocks.data() + (offset - start), data, num_bytes);
+	return delta.Write(start, static_cast<uint32_t>(blocks.size()), blocks.data())
+	             ? 0x00
+	             : 0x05;
+}
+
+// The first delta has the given name, the snapshots after it get their
+// number appended
+std::unique_ptr<DiskDelta> imageDisk::OpenDelta(const size_t index) const
+{
+	assert(index == deltas.size());
+	if (index == 0) {
+		return DiskDelta::Open(delta_path, image_size);
+	}
+	auto path = delta_path;
+	path += "." + std::to_string(index);
+	return DiskDelta::Open(path, image_size);
+}
+
+bool imageDisk::AttachDeltas(const std_fs::path& path)
+{
+	Flush();
+	ClearCache();
+	deltas.clear();
+
+	const auto size = compressed
+	                        ? static_cast<int64_t>(compressed->GetSize())
+	                        : stdio_size_bytes(diskimg);
+	if (size <= 0) {
+		LOG_ERR("BIOSDISK: Could not get the size of file '%s'", diskname);
+		return false;
+	}
+	image_size = static_cast<uint64_t>(size);
+	delta_path = path;
+
+	std::error_code ec = {};
+	do {
+		auto delta = OpenDelta(deltas.size());
+		if (!delta) {
+			deltas.clear();
+			return false;
+		}
+		deltas.emplace_back(std::move(delta));
+		auto next_path = delta_path;
+		next_path += "." + std::to_string(deltas.size());
+		if (!std_fs::exists(next_path, ec)) {
+			break;
+		}
+	} while (true);
+
+#if defined(HAVE_MMAP)
+	if (mapped_data) {
+		munmap(mapped_data, mapped_size);
+		mapped_data = nullptr;
+	}
+#endif
+	// The writes go to the deltas, whatever the image file allows
+	is_writable = {};
+	return true;
+}
+
+bool imageDisk::TakeSnapshot()
+{
+	if (deltas.empty()) {
+		return false;
+	}
+	Flush();
+
+	// Leftovers from an earlier snapshot that was rolled back while its
+	// file couldn't be removed
+	auto path = delta_path;
+	path += "." + std::to_string(deltas.size());
+	std::error_code ec = {};
+	std_fs::remove(path, ec);
+
+	auto delta = OpenDelta(deltas.size());
+	if (!delta) {
+		return false;
+	}
+	deltas.emplace_back(std::move(delta));
+	return true;
+}
+
+bool imageDisk::RollBack()
+{
+	if (deltas.empty()) {
+		return false;
+	}
+	// The cached writes are the newest ones, so they're dropped as well
+	const auto has_writes = num_dirty > 0 || !deltas.back()->IsEmpty();
+	ClearCache();
+
+	std::error_code ec = {};
+	if (!has_writes && deltas.size() > 1) {
+		const auto path = deltas.back()->GetPath();
+		deltas.pop_back();
+		std_fs::remove(path, ec);
+	}
+	if (deltas.back()->IsEmpty()) {
+		return true;
+	}
 
+	// Starting over with an empty delta; if the old one is still there,
+	// it's opened again and nothing is lost
+	const auto path = deltas.back()->GetPath();
+	deltas.pop_back();
+	const auto is_removed = std_fs::remove(path, ec);
+	if (!is_removed) {
+		LOG_ERR("BIOSDISK: Could not remove delta file '%s': %s",
+		        path.string().c_str(),
+		        ec.message().c_str());
+	}
+	auto delta = OpenDelta(deltas.size());
+	if (!delta) {
+		return false;
+	}
+	deltas.emplace_back(std::move(delta));
+	return is_removed;
 }
 
 imageDisk::imageDisk(FILE *img_file, const char *img_name, uint32_t img_size_k, bool is_hdd)
@@ -228,6 +647,9 @@ imageDisk::imageDisk(FILE *img_file, const char *img_name, uint32_t img_size_k,
 	fseek(diskimg,0,SEEK_SET);
 	memset(diskname,0,512);
 	safe_strcpy(diskname, img_name);
+	if (CompressedImage::IsCompressed(diskimg)) {
+		compressed = CompressedImage::Open(img_name);
+	}
 	if (!is_hdd) {
 		uint8_t i=0;
 		bool founddisk = false;
@@ -252,9 +674,32 @@ imageDisk::imageDisk(FILE *img_file, const char *img_name, uint32_t img_size_k,
 			incrementFDD();
 		}
 	}
+
+	const auto section = control ? static_cast<Section_prop*>(
+	                                       control->GetSection("dosbox"))
+	                             : nullptr;
+	if (section && section->Get_bool("map_disk_images") && !compressed) {
+		MapImage();
+	}
+}
+
+imageDisk::~imageDisk()
+{
+	Flush();
+#if defined(HAVE_MMAP)
+	if (mapped_data) {
+		munmap(mapped_data, mapped_size);
+	}
+#endif
+	if (diskimg != nullptr)
+		fclose(diskimg);
 }
 
 void imageDisk::Set_Geometry(uint32_t setHeads, uint32_t setCyl, uint32_t setSect, uint32_t setSectSize) {
+	if (setSectSize != sector_size) {
+		Flush();
+		ClearCache();
+	}
 	heads = setHeads;
 	cylinders = setCyl;
 	sectors = setSect;
@@ -345,6 +790,11 @@ static Bitu INT13_DiskHandler(void) {
 	switch(reg_ah) {
 	case 0x0: /* Reset disk */
 		{
+			for (const auto disk : imageDiskList) {
+				if (disk) {
+					disk->Flush();
+				}
+			}
 			/* if there aren't any diskimages (so only localdrives and virtual drives)
 			 * always succeed on reset disk. If there are diskimages then and only then
 			 * do real checks
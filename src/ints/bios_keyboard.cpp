@@ -20,6 +20,7 @@
 #include "bios.h"
 
 #include "callback.h"
+#include "cpu.h"
 #include "mem.h"
 #include "keyboard.h"
 #include "regs.h"
@@ -535,9 +536,11 @@ static Bitu INT16_Handler(void) {
 		if ((get_key(temp)) && (!IsEnhancedKey(temp))) {
 			/* normal key found, return translated key in ax */
 			reg_ax=temp;
+			CPU_IdlePoll(IdleSource::KeyboardPoll, true);
 		} else {
 			/* enter small idle loop to allow for irqs to happen */
 			reg_ip+=1;
+			CPU_IdlePoll(IdleSource::KeyboardPoll, false);
 		}
 		break;
 	case 0x10: /* GET KEYSTROKE (enhanced keyboards only) */
@@ -547,16 +550,21 @@ static Bitu INT16_Handler(void) {
 				temp&=0xff00;
 			}
 			reg_ax=temp;
+			CPU_IdlePoll(IdleSource::KeyboardPoll, true);
 		} else {
 			/* enter small idle loop to allow for irqs to happen */
 			reg_ip+=1;
+			CPU_IdlePoll(IdleSource::KeyboardPoll, false);
 		}
 		break;
 	case 0x01: /* CHECK FOR KEYSTROKE */
+	{
 		// enable interrupt-flag after IRET of this int16
 		CALLBACK_SIF(true);
+		bool has_key = false;
 		for (;;) {
-			if (check_key(temp)) { //  check_key changes ZF and CF as required
+			has_key = check_key(temp); // check_key changes ZF and CF as required
+			if (has_key) {
 				if (!IsEnhancedKey(temp)) {
 					/* normal key, return translated key in ax */
 					break;
@@ -570,19 +578,25 @@ static Bitu INT16_Handler(void) {
 			}
 //			CALLBACK_Idle();
 		}
+		CPU_IdlePoll(IdleSource::KeyboardPoll, has_key);
 		reg_ax=temp;
 		break;
+	}
 	case 0x11: /* CHECK FOR KEYSTROKE (enhanced keyboards only) */
+	{
 		// enable interrupt-flag after IRET of this int16
 		CALLBACK_SIF(true);
-		if (check_key(temp)) { // check_key changes ZF and CF as required
+		const bool has_key = check_key(temp); // check_key changes ZF and CF as required
+		if (has_key) {
 			if (((temp&0xff)==0xf0) && (temp>>8)) {
 				/* special enhanced key, clear low part before returning key */
 				temp&=0xff00;
 			}
 		}
+		CPU_IdlePoll(IdleSource::KeyboardPoll, has_key);
 		reg_ax=temp;
 		break;
+	}
 	case 0x02:	/* GET SHIFT FLAGS */
 		reg_al=mem_readb(BIOS_KEYBOARD_FLAGS1);
 		break;
@@ -623,6 +637,21 @@ static Bitu INT16_Handler(void) {
 	return CBRET_NONE;
 }
 
+// Keystroke checks and shift state reads are what programs poll the BIOS
+// with in tight loops; serve them without leaving the CPU core
+static bool INT16_FastHandler()
+{
+	switch (reg_ah) {
+	case 0x01: // CHECK FOR KEYSTROKE
+	case 0x02: // GET SHIFT FLAGS
+	case 0x11: // CHECK FOR KEYSTROKE (enhanced keyboards only)
+	case 0x12: // GET EXTENDED SHIFT STATES
+		INT16_Handler();
+		return true;
+	default: return false;
+	}
+}
+
 //Keyboard initialisation. src/gui/sdlmain.cpp
 extern bool startup_state_numlock;
 extern bool startup_state_capslock;
@@ -649,6 +678,7 @@ void BIOS_SetupKeyboard(void) {
 	/* Allocate/setup a callback for int 0x16 and for standard IRQ 1 handler */
 	call_int16=CALLBACK_Allocate();	
 	CALLBACK_Setup(call_int16,&INT16_Handler,CB_INT16,"Keyboard");
+	CALLBACK_SetFastHandler(call_int16, &INT16_FastHandler);
 	RealSetVec(0x16,CALLBACK_RealPointer(call_int16));
 
 	call_irq1=CALLBACK_Allocate();	
@@ -0,0 +1,261 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "disk_delta.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+#include "byteorder.h"
+#include "cross.h"
+#include "logging.h"
+
+constexpr char Magic[]           = "DBDELTA1";
+constexpr size_t MagicSize       = sizeof(Magic) - 1;
+constexpr uint64_t HeaderSize    = 32;
+constexpr uint32_t MaxBlockSize  = 64 * 1024;
+constexpr uint64_t DataAlignment = 4096;
+
+// Header layout, all values little-endian:
+//  0  magic
+//  8  uint32_t block size
+// 12  uint32_t reserved, zero
+// 16  uint64_t size of the image
+// 24  uint64_t offset of the data area
+struct DeltaHeader {
+	uint8_t magic[MagicSize] = {};
+	uint32_t block_size      = 0;
+	uint32_t reserved        = 0;
+	uint64_t image_size      = 0;
+	uint64_t data_start      = 0;
+};
+static_assert(sizeof(DeltaHeader) == HeaderSize);
+
+static uint64_t get_num_blocks(const uint64_t image_size,
+                               const uint32_t block_size)
+{
+	return (image_size + block_size - 1) / block_size;
+}
+
+static uint64_t get_data_start(const uint64_t num_blocks)
+{
+	const auto bitmap_end = HeaderSize + (num_blocks + 7) / 8;
+	return (bitmap_end + DataAlignment - 1) / DataAlignment * DataAlignment;
+}
+
+static bool seek_to(FILE* file, const uint64_t offset)
+{
+	return cross_fseeko(file, static_cast<cross_off_t>(offset), SEEK_SET) == 0;
+}
+
+std::unique_ptr<DiskDelta> DiskDelta::Open(const std_fs::path& path,
+                                           const uint64_t image_size)
+{
+	const auto name    = path.string();
+	std::error_code ec = {};
+
+	if (image_size == 0) {
+		LOG_ERR("BIOSDISK: Can't add delta file '%s' to an empty image",
+		        name.c_str());
+		return {};
+	}
+
+	if (!std_fs::exists(path, ec)) {
+		FILE* file = fopen(name.c_str(), "wb+");
+		if (!file) {
+			LOG_ERR("BIOSDISK: Could not create delta file '%s': %s",
+			        name.c_str(),
+			        strerror(errno));
+			return {};
+		}
+		std::unique_ptr<DiskDelta> delta(
+		        new DiskDelta(path, file, DefaultBlockSize, image_size));
+
+		DeltaHeader header = {};
+		memcpy(header.magic, Magic, MagicSize);
+		header.block_size = host_to_le32(delta->block_size);
+		header.image_size = host_to_le64(image_size);
+		header.data_start = host_to_le64(delta->data_start);
+
+		if (fwrite(&header, sizeof(header), 1, file) != 1 ||
+		    !delta->WriteBitmap(0, delta->num_blocks - 1) || fflush(file) != 0) {
+			LOG_ERR("BIOSDISK: Could not write delta file '%s': %s",
+			        name.c_str(),
+			        strerror(errno));
+			delta.reset();
+			std_fs::remove(path, ec);
+			return {};
+		}
+		return delta;
+	}
+
+	FILE* file = fopen(name.c_str(), "rb+");
+	if (!file) {
+		LOG_ERR("BIOSDISK: Could not open delta file '%s': %s",
+		        name.c_str(),
+		        strerror(errno));
+		return {};
+	}
+	DeltaHeader header = {};
+	if (fread(&header, sizeof(header), 1, file) != 1 ||
+	    memcmp(header.magic, Magic, MagicSize) != 0) {
+		LOG_ERR("BIOSDISK: '%s' is not a delta file", name.c_str());
+		fclose(file);
+		return {};
+	}
+	const auto block_size = le32_to_host(header.block_size);
+	if (block_size == 0 || block_size > MaxBlockSize ||
+	    le64_to_host(header.data_start) !=
+	            get_data_start(get_num_blocks(image_size, block_size))) {
+		LOG_ERR("BIOSDISK: Delta file '%s' is damaged", name.c_str());
+		fclose(file);
+		return {};
+	}
+	if (le64_to_host(header.image_size) != image_size) {
+		LOG_ERR("BIOSDISK: Delta file '%s' was made for an image of %llu bytes, not %llu bytes",
+		        name.c_str(),
+		        static_cast<unsigned long long>(le64_to_host(header.image_size)),
+		        static_cast<unsigned long long>(image_size));
+		fclose(file);
+		return {};
+	}
+
+	std::unique_ptr<DiskDelta> delta(
+	        new DiskDelta(path, file, block_size, image_size));
+	if (!delta->ReadBitmap()) {
+		LOG_ERR("BIOSDISK: Could not read the bitmap of delta file '%s'",
+		        name.c_str());
+		return {};
+	}
+	return delta;
+}
+
+DiskDelta::DiskDelta(const std_fs::path& _path, FILE* _file,
+                     const uint32_t _block_size, const uint64_t _image_size)
+        : path(_path),
+          file(_file),
+          block_size(_block_size),
+          image_size(_image_size),
+          num_blocks(get_num_blocks(_image_size, _block_size)),
+          data_start(get_data_start(num_blocks)),
+          bitmap((num_blocks + 7) / 8)
+{
+	assert(file);
+	assert(block_size > 0);
+}
+
+DiskDelta::~DiskDelta()
+{
+	fclose(file);
+}
+
+bool DiskDelta::ReadBitmap()
+{
+	if (!seek_to(file, HeaderSize) ||
+	    fread(bitmap.data(), 1, bitmap.size(), file) != bitmap.size()) {
+		return false;
+	}
+	num_stored_blocks = 0;
+	for (uint64_t block = 0; block < num_blocks; ++block) {
+		num_stored_blocks += HasBlock(block) ? 1 : 0;
+	}
+	return true;
+}
+
+// Writes the bytes of the bitmap holding the bits of the blocks
+bool DiskDelta::WriteBitmap(const uint64_t first_block,
+                            const uint64_t last_block)
+{
+	if (bitmap.empty()) {
+		return true;
+	}
+	const auto first_byte = first_block / 8;
+	const auto num_bytes  = last_block / 8 - first_byte + 1;
+	return seek_to(file, HeaderSize + first_byte) &&
+	       fwrite(bitmap.data() + first_byte, 1, num_bytes, file) == num_bytes;
+}
+
+bool DiskDelta::ReadOver(const uint64_t offset, const uint32_t num_bytes,
+                         uint8_t* data)
+{
+	if (num_bytes == 0 || IsEmpty() || offset >= image_size) {
+		return true;
+	}
+	const auto end         = std::min(offset + num_bytes, image_size);
+	const auto first_block = offset / block_size;
+	const auto last_block  = (end - 1) / block_size;
+
+	// Runs of consecutive blocks held by the delta are read at once
+	std::vector<uint8_t> buffer = {};
+	for (auto block = first_block; block <= last_block;) {
+		if (!HasBlock(block)) {
+			++block;
+			continue;
+		}
+		auto run_end = block + 1;
+		while (run_end <= last_block && HasBlock(run_end)) {
+			++run_end;
+		}
+		const auto run_start_byte = block * block_size;
+		buffer.resize((run_end - block) * block_size);
+		if (!seek_to(file, data_start + run_start_byte) ||
+		    fread(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+			return false;
+		}
+		const auto copy_start = std::max(offset, run_start_byte);
+		const auto copy_end   = std::min(end, run_end * block_size);
+		memcpy(data + (copy_start - offset),
+		       buffer.data() + (copy_start - run_start_byte),
+		       copy_end - copy_start);
+		block = run_end;
+	}
+	return true;
+}
+
+bool DiskDelta::Write(const uint64_t offset, const uint32_t num_bytes,
+                      const uint8_t* data)
+{
+	assert(offset % block_size == 0 && num_bytes % block_size == 0);
+	if (num_bytes == 0) {
+		return true;
+	}
+	const auto first_block = offset / block_size;
+	const auto last_block  = first_block + num_bytes / block_size - 1;
+	if (last_block >= num_blocks) {
+		return false;
+	}
+
+	// The data goes out before the bitmap points to it
+	if (!seek_to(file, data_start + offset) ||
+	    fwrite(data, 1, num_bytes, file) != num_bytes) {
+		return false;
+	}
+	bool has_new_blocks = false;
+	for (auto block = first_block; block <= last_block; ++block) {
+		if (!HasBlock(block)) {
+			bitmap[block / 8] |= static_cast<uint8_t>(1 << (block % 8));
+			++num_stored_blocks;
+			has_new_blocks = true;
+		}
+	}
+	return !has_new_blocks || WriteBitmap(first_block, last_block);
+}
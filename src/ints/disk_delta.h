@@ -0,0 +1,106 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_DISK_DELTA_H
+#define DOSBOX_DISK_DELTA_H
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "std_filesystem.h"
+
+/*
+DiskDelta Class
+~~~~~~~~~~~~~~~
+A copy-on-write layer over a disk image that's kept read-only. The image is
+split into blocks, and the blocks written to are stored in the delta file
+instead of the image.
+
+The file starts with a header, followed by a bitmap with one bit per block
+of the image telling whether the delta holds that block. Each block has a
+fixed place in the data area after the bitmap, so the host's file system
+only allocates space for the blocks actually written.
+
+Deltas can be stacked: reading copies the blocks of each layer over what
+the layers below it (and eventually the image) hold.
+*/
+
+class DiskDelta {
+public:
+	static constexpr uint32_t DefaultBlockSize = 512;
+
+	// Opens the delta at the path, or creates an empty one, for an image
+	// of the given size. Existing deltas keep their own block size, but
+	// must have been made for an image of the same size.
+	static std::unique_ptr<DiskDelta> Open(const std_fs::path& path,
+	                                       uint64_t image_size);
+
+	DiskDelta(const DiskDelta&)            = delete; // prevent copying
+	DiskDelta& operator=(const DiskDelta&) = delete; // prevent assignment
+
+	~DiskDelta();
+
+	const std_fs::path& GetPath() const
+	{
+		return path;
+	}
+
+	uint32_t GetBlockSize() const
+	{
+		return block_size;
+	}
+
+	bool IsEmpty() const
+	{
+		return num_stored_blocks == 0;
+	}
+
+	// Copies the blocks held by the delta within the byte range over the
+	// data, which holds the bytes from the layers below
+	bool ReadOver(uint64_t offset, uint32_t num_bytes, uint8_t* data);
+
+	// The byte range has to start and end on block boundaries
+	bool Write(uint64_t offset, uint32_t num_bytes, const uint8_t* data);
+
+private:
+	DiskDelta(const std_fs::path& path, FILE* file, uint32_t block_size,
+	          uint64_t image_size);
+
+	bool ReadBitmap();
+	bool WriteBitmap(uint64_t first_block, uint64_t last_block);
+	bool HasBlock(uint64_t block) const
+	{
+		return bitmap[block / 8] & (1 << (block % 8));
+	}
+
+	std_fs::path path          = {};
+	FILE* file                 = nullptr;
+	uint32_t block_size        = 0;
+	uint64_t image_size        = 0;
+	uint64_t num_blocks        = 0;
+	uint64_t data_start        = 0;
+	uint64_t num_stored_blocks = 0;
+
+	std::vector<uint8_t> bitmap = {};
+};
+
+#endif
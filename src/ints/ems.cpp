@@ -20,8 +20,11 @@
 #include "dosbox.h"
 
 #include <algorithm>
+#include <array>
 #include <cstring>
 #include <cstdlib>
+#include <optional>
+#include <vector>
 
 #include "callback.h"
 #include "mem.h"
@@ -100,6 +103,56 @@ static EMM_Handle emm_handles[EMM_MAX_HANDLES];
 static EMM_Mapping emm_mappings[EMM_MAX_PHYS];
 static EMM_Mapping emm_segmentmappings[0x40];
 
+// What the page frame's windows are actually mapped to, so mapping the same
+// logical page again can be skipped. Unlike emm_mappings, these only change
+// along with the paging tables. Empty when not known.
+static std::optional<EMM_Mapping> frame_windows[EMM_MAX_PHYS];
+
+static void forget_frame_windows(const uint16_t handle)
+{
+	for (auto& window : frame_windows) {
+		if (window && window->handle == handle) {
+			window = {};
+		}
+	}
+}
+
+// Points the four 4 KB pages of a 16 KB window at the memory pages. With
+// paging disabled, remapping a page already drops its own TLB entry, so the
+// whole TLB only has to be flushed when paging is enabled.
+static void map_window(const Bitu lin_page,
+                       const std::array<Bitu, 4>& phys_pages)
+{
+	bool is_changed = false;
+	for (Bitu i = 0; i < phys_pages.size(); ++i) {
+		if (paging.firstmb[lin_page + i] != phys_pages[i]) {
+			PAGING_MapPage(lin_page + i, phys_pages[i]);
+			is_changed = true;
+		}
+	}
+	if (is_changed && PAGING_Enabled()) {
+		PAGING_ClearTLB();
+	}
+}
+
+static void unmap_window(const Bitu lin_page)
+{
+	map_window(lin_page, {lin_page, lin_page + 1, lin_page + 2, lin_page + 3});
+}
+
+// Maps the window to the 16 KB logical page of the handle
+static void map_window(const Bitu lin_page, const uint16_t handle,
+                       const uint16_t log_page)
+{
+	std::array<Bitu, 4> phys_pages = {};
+	MemHandle memh = MEM_NextHandleAt(emm_handles[handle].mem, log_page * 4);
+	for (auto& phys_page : phys_pages) {
+		phys_page = static_cast<Bitu>(memh);
+		memh      = MEM_NextHandle(memh);
+	}
+	map_window(lin_page, phys_pages);
+}
+
 
 static uint16_t GEMMIS_seg;
 
@@ -296,6 +349,7 @@ static uint8_t EMM_AllocateSystemHandle(uint16_t pages) {
 	/* Release memory if already allocated */
 	if (emm_handles[handle].pages != NULL_HANDLE) {
 		MEM_ReleasePages(emm_handles[handle].mem);
+		forget_frame_windows(handle);
 	}
 	MemHandle mem = MEM_AllocatePages(pages*4,false);
 	if (!mem) E_Exit("EMS:System handle memory allocation failure");
@@ -307,6 +361,7 @@ static uint8_t EMM_AllocateSystemHandle(uint16_t pages) {
 static uint8_t EMM_ReallocatePages(uint16_t handle,uint16_t & pages) {
 	/* Check for valid handle */
 	if (!ValidHandle(handle)) return EMM_INVALID_HANDLE;
+	forget_frame_windows(handle);
 	if (emm_handles[handle].pages != 0) {
 		/* Check for enough pages */
 		if (!MEM_ReAllocatePages(emm_handles[handle].mem,pages*4,false)) return EMM_OUT_OF_LOG;
@@ -330,9 +385,11 @@ static uint8_t EMM_MapPage(Bitu phys_page,uint16_t handle,uint16_t log_page) {
 		/* Unmapping */
 		emm_mappings[phys_page].handle=NULL_HANDLE;
 		emm_mappings[phys_page].page=NULL_PAGE;
-		for (Bitu i=0;i<4;i++)
-			PAGING_MapPage(EMM_PAGEFRAME4K+phys_page*4+i,EMM_PAGEFRAME4K+phys_page*4+i);
-		PAGING_ClearTLB();
+		auto& window = frame_windows[phys_page];
+		if (!window || window->page != NULL_PAGE) {
+			unmap_window(EMM_PAGEFRAME4K + phys_page * 4);
+			window = emm_mappings[phys_page];
+		}
 		return EMM_NO_ERROR;
 	}
 	/* Check for valid handle */
@@ -343,12 +400,13 @@ static uint8_t EMM_MapPage(Bitu phys_page,uint16_t handle,uint16_t log_page) {
 		emm_mappings[phys_page].handle=handle;
 		emm_mappings[phys_page].page=log_page;
 
-		MemHandle memh=MEM_NextHandleAt(emm_handles[handle].mem,log_page*4);;
-		for (Bitu i=0;i<4;i++) {
-			PAGING_MapPage(EMM_PAGEFRAME4K+phys_page*4+i,memh);
-			memh=MEM_NextHandle(memh);
+		// Games often map the same page over and over again
+		auto& window = frame_windows[phys_page];
+		if (!window || window->handle != handle ||
+		    window->page != log_page) {
+			map_window(EMM_PAGEFRAME4K + phys_page * 4, handle, log_page);
+			window = emm_mappings[phys_page];
 		}
-		PAGING_ClearTLB();
 		return EMM_NO_ERROR;
 	} else  {
 		/* Illegal logical page it is */
@@ -378,6 +436,14 @@ static uint8_t EMM_MapSegment(Bitu segment,uint16_t handle,uint16_t log_page) {
 	if (valid_segment) {
 		int32_t tphysPage = ((int32_t)segment-EMM_PAGEFRAME)/(0x1000/EMM_MAX_PHYS);
 
+		// The window can cover parts of the page frame's ones
+		if (segment + 0x400 > EMM_PAGEFRAME &&
+		    segment < EMM_PAGEFRAME + 0x1000) {
+			for (auto& window : frame_windows) {
+				window = {};
+			}
+		}
+
 		/* unmapping doesn't need valid handle (as handle isn't used) */
 		if (log_page==NULL_PAGE) {
 			/* Unmapping */
@@ -388,9 +454,7 @@ static uint8_t EMM_MapSegment(Bitu segment,uint16_t handle,uint16_t log_page) {
 				emm_segmentmappings[segment>>10].handle=NULL_HANDLE;
 				emm_segmentmappings[segment>>10].page=NULL_PAGE;
 			}
-			for (Bitu i=0;i<4;i++)
-				PAGING_MapPage(segment*16/4096+i,segment*16/4096+i);
-			PAGING_ClearTLB();
+			unmap_window(segment * 16 / 4096);
 			return EMM_NO_ERROR;
 		}
 		/* Check for valid handle */
@@ -406,12 +470,7 @@ static uint8_t EMM_MapSegment(Bitu segment,uint16_t handle,uint16_t log_page) {
 				emm_segmentmappings[segment>>10].page=log_page;
 			}
 
-			MemHandle memh=MEM_NextHandleAt(emm_handles[handle].mem,log_page*4);;
-			for (Bitu i=0;i<4;i++) {
-				PAGING_MapPage(segment*16/4096+i,memh);
-				memh=MEM_NextHandle(memh);
-			}
-			PAGING_ClearTLB();
+			map_window(segment * 16 / 4096, handle, log_page);
 			return EMM_NO_ERROR;
 		} else  {
 			/* Illegal logical page it is */
@@ -433,6 +492,7 @@ static uint8_t EMM_ReleaseMemory(uint16_t handle) {
 	if (emm_handles[handle].pages != 0) {
 		MEM_ReleasePages(emm_handles[handle].mem);
 	}
+	forget_frame_windows(handle);
 	/* Reset handle */
 	emm_handles[handle].mem=0;
 	if (handle==0) {
@@ -651,6 +711,67 @@ static void LoadMoveRegion(PhysPt data,MoveRegion & region) {
 	region.dest_page_seg=mem_readw(data+0x10);
 }
 
+// One side of a move or exchange, either conventional memory or the pages
+// of an EMS handle
+struct RegionSide {
+	bool is_ems = false;
+	PhysPt mem  = 0;
+	// Of the handle, the 4 KB pages from the one the region starts in
+	std::vector<MemHandle> pages = {};
+	uint32_t offset              = 0;
+
+	PhysPt GetAddress(const uint32_t pos) const
+	{
+		if (!is_ems) {
+			return mem + pos;
+		}
+		const auto page_pos = offset + pos;
+		return pages[page_pos / MEM_PAGE_SIZE] * MEM_PAGE_SIZE +
+		       page_pos % MEM_PAGE_SIZE;
+	}
+};
+
+static uint8_t LoadRegionSide(const uint8_t type, const uint16_t handle,
+                              const uint16_t offset, const uint16_t page_seg,
+                              const uint32_t bytes, RegionSide& side)
+{
+	if (!type) {
+		side.mem = page_seg * 16 + offset;
+		return EMM_NO_ERROR;
+	}
+	if (!ValidHandle(handle)) {
+		return EMM_INVALID_HANDLE;
+	}
+	if ((emm_handles[handle].pages * EMM_PAGE_SIZE) <
+	    ((page_seg * EMM_PAGE_SIZE) + offset + bytes)) {
+		return EMM_LOG_OUT_RANGE;
+	}
+	side.is_ems = true;
+	side.offset = offset & (MEM_PAGE_SIZE - 1);
+
+	MemHandle mem_handle = emm_handles[handle].mem;
+	Bitu pages = page_seg * 4 + (offset / MEM_PAGE_SIZE);
+	for (; pages > 0; pages--) {
+		mem_handle = MEM_NextHandle(mem_handle);
+	}
+	const auto num_pages = (side.offset + bytes + MEM_PAGE_SIZE - 1) /
+	                       MEM_PAGE_SIZE;
+	side.pages.reserve(num_pages);
+	for (uint32_t i = 0; i < num_pages; ++i) {
+		side.pages.push_back(mem_handle);
+		mem_handle = MEM_NextHandle(mem_handle);
+	}
+	return EMM_NO_ERROR;
+}
+
+// The offset of the region within conventional memory or its handle, for
+// telling whether the source and destination overlap
+static uint32_t get_region_start(const uint8_t type, const uint16_t offset,
+                                 const uint16_t page_seg)
+{
+	return type ? page_seg * EMM_PAGE_SIZE + offset : page_seg * 16 + offset;
+}
+
 static uint8_t MemoryRegion()
 {
 	MoveRegion region;
@@ -661,97 +782,91 @@ static uint8_t MemoryRegion()
 	}
 	LoadMoveRegion(SegPhys(ds)+reg_si,region);
 	/* Parse the region for information */
-	PhysPt src_mem = 0,dest_mem = 0;
-	MemHandle src_handle = 0,dest_handle = 0;
-	Bitu src_off = 0,dest_off = 0 ;Bitu src_remain = 0,dest_remain = 0;
-	if (!region.src_type) {
-		src_mem=region.src_page_seg*16+region.src_offset;
-	} else {
-		if (!ValidHandle(region.src_handle)) return EMM_INVALID_HANDLE;
-		if ((emm_handles[region.src_handle].pages*EMM_PAGE_SIZE) < ((region.src_page_seg*EMM_PAGE_SIZE)+region.src_offset+region.bytes)) return EMM_LOG_OUT_RANGE;
-		src_handle=emm_handles[region.src_handle].mem;
-		Bitu pages=region.src_page_seg*4+(region.src_offset/MEM_PAGE_SIZE);
-		for (;pages>0;pages--) src_handle=MEM_NextHandle(src_handle);
-		src_off=region.src_offset&(MEM_PAGE_SIZE-1);
-		src_remain=MEM_PAGE_SIZE-src_off;
+	RegionSide src  = {};
+	RegionSide dest = {};
+	if (const auto result = LoadRegionSide(region.src_type,
+	                                       region.src_handle,
+	                                       region.src_offset,
+	                                       region.src_page_seg,
+	                                       region.bytes,
+	                                       src);
+	    result != EMM_NO_ERROR) {
+		return result;
 	}
-	if (!region.dest_type) {
-		dest_mem=region.dest_page_seg*16+region.dest_offset;
-	} else {
-		if (!ValidHandle(region.dest_handle)) return EMM_INVALID_HANDLE;
-		if (emm_handles[region.dest_handle].pages*EMM_PAGE_SIZE < (region.dest_page_seg*EMM_PAGE_SIZE)+region.dest_offset+region.bytes) return EMM_LOG_OUT_RANGE;
-		dest_handle=emm_handles[region.dest_handle].mem;
-		Bitu pages=region.dest_page_seg*4+(region.dest_offset/MEM_PAGE_SIZE);
-		for (;pages>0;pages--) dest_handle=MEM_NextHandle(dest_handle);
-		dest_off=region.dest_offset&(MEM_PAGE_SIZE-1);
-		dest_remain=MEM_PAGE_SIZE-dest_off;
+	if (const auto result = LoadRegionSide(region.dest_type,
+	                                       region.dest_handle,
+	                                       region.dest_offset,
+	                                       region.dest_page_seg,
+	                                       region.bytes,
+	                                       dest);
+	    result != EMM_NO_ERROR) {
+		return result;
 	}
 
-	uint8_t buf_src[MEM_PAGE_SIZE];
-	uint8_t buf_dest[MEM_PAGE_SIZE];
-
-	while (region.bytes > 0) {
-		const size_t toread = std::min<size_t>(region.bytes, MEM_PAGE_SIZE);
-
-		/* Read from the source */
-		if (!region.src_type) {
-			MEM_BlockRead(src_mem,buf_src,toread);
-		} else {
-			assert(toread <= MEM_PAGE_SIZE);
-			if (toread <= src_remain) {
-				MEM_BlockRead((src_handle*MEM_PAGE_SIZE)+src_off,buf_src,toread);
-			} else {
-				MEM_BlockRead((src_handle*MEM_PAGE_SIZE)+src_off,buf_src,src_remain);
-				MEM_BlockRead((MEM_NextHandle(src_handle)*MEM_PAGE_SIZE),&buf_src[src_remain],toread-src_remain);
-			}
+	const auto src_start = get_region_start(region.src_type,
+	                                        region.src_offset,
+	                                        region.src_page_seg);
+	const auto dest_start = get_region_start(region.dest_type,
+	                                         region.dest_offset,
+	                                         region.dest_page_seg);
+	const auto is_overlapping = region.bytes > 0 &&
+	                            region.src_type == region.dest_type &&
+	                            (!region.src_type ||
+	                             region.src_handle == region.dest_handle) &&
+	                            src_start < dest_start + region.bytes &&
+	                            dest_start < src_start + region.bytes;
+
+	// Each step stays within a page of both sides, so the moves copy
+	// whole runs of host memory
+	auto get_step = [&](const uint32_t pos, const uint32_t remain) {
+		const auto src_pt  = src.GetAddress(pos);
+		const auto dest_pt = dest.GetAddress(pos);
+		return std::min({remain,
+		                 MEM_PAGE_SIZE - (src_pt & (MEM_PAGE_SIZE - 1)),
+		                 MEM_PAGE_SIZE - (dest_pt & (MEM_PAGE_SIZE - 1))});
+	};
+
+	if (reg_al == 1) {
+		/* Exchange */
+		if (is_overlapping) {
+			return EMM_MOVE_OVLAPI;
 		}
-		/* Check for a move */
-		if (reg_al==1) {
-			/* Read from the destination */
-			if (!region.dest_type) {
-				MEM_BlockRead(dest_mem,buf_dest,toread);
-			} else {
-				assert(toread <= MEM_PAGE_SIZE);
-				if (toread <= dest_remain) {
-					MEM_BlockRead((dest_handle*MEM_PAGE_SIZE)+dest_off,buf_dest,toread);
-				} else {
-					MEM_BlockRead((dest_handle*MEM_PAGE_SIZE)+dest_off,buf_dest,dest_remain);
-					MEM_BlockRead((MEM_NextHandle(dest_handle)*MEM_PAGE_SIZE),&buf_dest[dest_remain],toread-dest_remain);
-				}
-			}
-			/* Write to the source */
-			if (!region.src_type) {
-				MEM_BlockWrite(src_mem,buf_dest,toread);
-			} else {
-				assert(toread <= MEM_PAGE_SIZE);
-				if (toread <= src_remain) {
-					MEM_BlockWrite((src_handle*MEM_PAGE_SIZE)+src_off,buf_dest,toread);
-				} else {
-					MEM_BlockWrite((src_handle*MEM_PAGE_SIZE)+src_off,buf_dest,src_remain);
-					MEM_BlockWrite((MEM_NextHandle(src_handle)*MEM_PAGE_SIZE),&buf_dest[src_remain],toread-src_remain);
-				}
-			}
+		uint8_t buf_src[MEM_PAGE_SIZE];
+		uint8_t buf_dest[MEM_PAGE_SIZE];
+		for (uint32_t pos = 0; pos < region.bytes;) {
+			const auto step    = get_step(pos, region.bytes - pos);
+			const auto src_pt  = src.GetAddress(pos);
+			const auto dest_pt = dest.GetAddress(pos);
+			MEM_BlockRead(src_pt, buf_src, step);
+			MEM_BlockRead(dest_pt, buf_dest, step);
+			MEM_BlockWrite(src_pt, buf_dest, step);
+			MEM_BlockWrite(dest_pt, buf_src, step);
+			pos += step;
 		}
-		/* Write to the destination */
-		if (!region.dest_type) {
-			MEM_BlockWrite(dest_mem,buf_src,toread);
-		} else {
-			assert(toread <= MEM_PAGE_SIZE);
-			if (toread <= dest_remain) {
-				MEM_BlockWrite((dest_handle*MEM_PAGE_SIZE)+dest_off,buf_src,toread);
-			} else {
-				MEM_BlockWrite((dest_handle*MEM_PAGE_SIZE)+dest_off,buf_src,dest_remain);
-				MEM_BlockWrite((MEM_NextHandle(dest_handle)*MEM_PAGE_SIZE),&buf_src[dest_remain],toread-dest_remain);
-			}
+		return EMM_NO_ERROR;
+	}
+
+	/* Move */
+	if (is_overlapping && dest_start > src_start) {
+		// Starting from the end, so the source isn't overwritten
+		// before it's read
+		for (uint32_t pos = region.bytes; pos > 0;) {
+			const auto src_pt  = src.GetAddress(pos - 1);
+			const auto dest_pt = dest.GetAddress(pos - 1);
+			const auto step    = std::min({pos,
+			                               (src_pt & (MEM_PAGE_SIZE - 1)) + 1,
+			                               (dest_pt & (MEM_PAGE_SIZE - 1)) + 1});
+			pos -= step;
+			MEM_BlockMove(dest.GetAddress(pos), src.GetAddress(pos), step);
+		}
+	} else {
+		for (uint32_t pos = 0; pos < region.bytes;) {
+			const auto step = get_step(pos, region.bytes - pos);
+			MEM_BlockMove(dest.GetAddress(pos), src.GetAddress(pos), step);
+			pos += step;
 		}
-		/* Advance the pointers */
-		if (!region.src_type) src_mem+=toread;
-		else src_handle=MEM_NextHandle(src_handle);
-		if (!region.dest_type) dest_mem+=toread;
-		else dest_handle=MEM_NextHandle(dest_handle);
-		region.bytes-=toread;
 	}
-	return EMM_NO_ERROR;
+	return is_overlapping ? EMM_MOVE_OVLAP : EMM_NO_ERROR;
 }
 
 static Bitu INT67_Handler(void) {
@@ -1451,6 +1566,7 @@ public:
 		for (i=0;i<EMM_MAX_PHYS;i++) {
 			emm_mappings[i].page=NULL_PAGE;
 			emm_mappings[i].handle=NULL_HANDLE;
+			frame_windows[i] = {};
 		}
 		for (i=0;i<0x40;i++) {
 			emm_segmentmappings[i].page=NULL_PAGE;
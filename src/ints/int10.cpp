@@ -731,6 +731,24 @@ static void SetupTandyBios(void) {
 	}
 }
 
+bool INT10_IsHooked()
+{
+	return RealGetVec(0x10) != CALLBACK_RealPointer(call_10);
+}
+
+// Cursor and video mode queries only read the BIOS data area; serve them
+// without leaving the CPU core
+static bool INT10_FastHandler()
+{
+	switch (reg_ah) {
+	case 0x03: // Get cursor position and shape
+	case 0x0f: // Get video mode
+		INT10_Handler();
+		return true;
+	default: return false;
+	}
+}
+
 void INT10_Init(Section* /*sec*/) {
 	INT10_SetupPalette();
 	INT10_InitVGA();
@@ -738,6 +756,7 @@ void INT10_Init(Section* /*sec*/) {
 	/* Setup the INT 10 vector */
 	call_10=CALLBACK_Allocate();	
 	CALLBACK_Setup(call_10,&INT10_Handler,CB_IRET,"Int 10 video");
+	CALLBACK_SetFastHandler(call_10, &INT10_FastHandler);
 	RealSetVec(0x10,CALLBACK_RealPointer(call_10));
 	//Init the 0x40 segment and init the datastructures in the video rom area
 	INT10_SetupRomMemory();
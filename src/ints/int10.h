@@ -112,11 +112,11 @@ constexpr uint16_t MaxVesaBiosModeNumber = 0x7ff;
 uint16_t INT10_GetTextColumns();
 uint16_t INT10_GetTextRows();
 
-extern uint8_t int10_font_08[256 * 8];
-extern uint8_t int10_font_14[256 * 14];
-extern uint8_t int10_font_16[256 * 16];
-extern uint8_t int10_font_14_alternate[20 * 15 + 1];
-extern uint8_t int10_font_16_alternate[19 * 17 + 1];
+extern const uint8_t int10_font_08[256 * 8];
+extern const uint8_t int10_font_14[256 * 14];
+extern const uint8_t int10_font_16[256 * 16];
+extern const uint8_t int10_font_14_alternate[20 * 15 + 1];
+extern const uint8_t int10_font_16_alternate[19 * 17 + 1];
 
 struct palette_t {
 	// 64 entries
@@ -253,6 +253,17 @@ void INT10_TeletypeOutputAttrViaInterrupt(const uint8_t char_value,
                                           const uint8_t attribute,
                                           const bool use_attribute);
 
+// Teletype output of a run of characters in text modes, with the cursor set
+// and the screen scrolled as needed once per row instead of per character.
+// Only done while INT 10h isn't hooked, as the run skips the interrupt; it
+// stops at the characters with special meanings and returns how many it
+// wrote, which is zero if the caller has to use the regular output.
+uint16_t INT10_TeletypeOutputRun(const uint8_t* chars, const uint16_t num_chars,
+                                 const uint8_t attribute,
+                                 const bool use_attribute);
+
+bool INT10_IsHooked();
+
 void INT10_ReadCharAttr(uint16_t* result, uint8_t page);
 
 void INT10_WriteChar(const uint8_t char_value, const uint8_t attribute,
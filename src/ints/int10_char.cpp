@@ -27,6 +27,7 @@
 #include "mem.h"
 #include "pic.h"
 #include "regs.h"
+#include "vga.h"
 
 static void CGA2_CopyRow(uint8_t cleft,uint8_t cright,uint8_t rold,uint8_t rnew,PhysPt base) {
 	BIOS_CHEIGHT;
@@ -78,7 +79,10 @@ static void EGA16_CopyRow(uint8_t cleft,uint8_t cright,uint8_t rold,uint8_t rnew
 	Bitu rowsize=(cright-cleft);
 	copy=cheight;
 	for (;copy>0;copy--) {
-		for (Bitu x=0;x<rowsize;x++) mem_writeb(dest+x,mem_readb(src+x));
+		if (!VGA_BlockCopy(dest, src, rowsize)) {
+			for (Bitu x=0;x<rowsize;x++)
+				mem_writeb(dest+x,mem_readb(src+x));
+		}
 		dest+=nextline;src+=nextline;
 	}
 	/* Restore registers */
@@ -94,7 +98,10 @@ static void VGA_CopyRow(uint8_t cleft,uint8_t cright,uint8_t rold,uint8_t rnew,P
 	Bitu rowsize=8*(cright-cleft);
 	copy=cheight;
 	for (;copy>0;copy--) {
-		for (Bitu x=0;x<rowsize;x++) mem_writeb(dest+x,mem_readb(src+x));
+		if (!VGA_BlockCopy(dest, src, rowsize)) {
+			for (Bitu x=0;x<rowsize;x++)
+				mem_writeb(dest+x,mem_readb(src+x));
+		}
 		dest+=nextline;src+=nextline;
 	}
 }
@@ -162,7 +169,9 @@ static void EGA16_FillRow(uint8_t cleft,uint8_t cright,uint8_t row,PhysPt base,u
 	Bitu nextline=CurMode->twidth;
 	Bitu copy = cheight;Bitu rowsize=(cright-cleft);
 	for (;copy>0;copy--) {
-		for (Bitu x=0;x<rowsize;x++) mem_writeb(dest+x,0xff);
+		if (!VGA_BlockFill(dest, 0xff, rowsize)) {
+			for (Bitu x=0;x<rowsize;x++) mem_writeb(dest+x,0xff);
+		}
 		dest+=nextline;
 	}
 	IO_Write(0x3cf,0);
@@ -175,7 +184,9 @@ static void VGA_FillRow(uint8_t cleft,uint8_t cright,uint8_t row,PhysPt base,uin
 	Bitu nextline=8*CurMode->twidth;
 	Bitu copy = cheight;Bitu rowsize=8*(cright-cleft);
 	for (;copy>0;copy--) {
-		for (Bitu x=0;x<rowsize;x++) mem_writeb(dest+x,attr);
+		if (!VGA_BlockFill(dest, attr, rowsize)) {
+			for (Bitu x=0;x<rowsize;x++) mem_writeb(dest+x,attr);
+		}
 		dest+=nextline;
 	}
 }
@@ -836,6 +847,82 @@ void INT10_TeletypeOutputAttrViaInterrupt(const uint8_t char_value,
 	                                               page);
 }
 
+uint16_t INT10_TeletypeOutputRun(const uint8_t* chars, const uint16_t num_chars,
+                                 const uint8_t attribute,
+                                 const bool use_attribute)
+{
+	if (CurMode->type != M_TEXT || INT10_IsHooked()) {
+		return 0;
+	}
+	const auto page = real_readb(BIOSMEM_SEG, BIOSMEM_CURRENT_PAGE);
+	BIOS_NCOLS;
+	BIOS_NROWS;
+	uint8_t cur_row = CURSOR_POS_ROW(page);
+	uint8_t cur_col = CURSOR_POS_COL(page);
+	if (cur_col >= ncols || cur_row >= nrows) {
+		return 0;
+	}
+	const uint16_t page_offset = page *
+	                             real_readw(BIOSMEM_SEG, BIOSMEM_PAGE_SIZE);
+
+	auto is_printable = [](const uint8_t chr) {
+		return chr != 7 && chr != 8 && chr != '\r' && chr != '\n';
+	};
+
+	uint8_t cells[2 * UINT8_MAX + 2];
+	uint16_t count = 0;
+	while (count < num_chars) {
+		// Write the characters up to the end of the row in one go
+		uint16_t num_in_row = 0;
+		while (count + num_in_row < num_chars &&
+		       cur_col + num_in_row < ncols &&
+		       num_in_row * 2 < sizeof(cells) &&
+		       is_printable(chars[count + num_in_row])) {
+			++num_in_row;
+		}
+		if (!num_in_row) {
+			break;
+		}
+		const uint16_t address = page_offset +
+		                         (cur_row * ncols + cur_col) * 2;
+		const PhysPt where = CurMode->pstart + address;
+		if (!use_attribute) {
+			MEM_BlockRead(where, cells, num_in_row * 2);
+		}
+		for (uint16_t i = 0; i < num_in_row; ++i) {
+			cells[i * 2] = chars[count + i];
+			if (use_attribute) {
+				cells[i * 2 + 1] = attribute;
+			}
+		}
+		MEM_BlockWrite(where, cells, num_in_row * 2);
+
+		count += num_in_row;
+		cur_col += num_in_row;
+		if (cur_col == ncols) {
+			cur_col = 0;
+			cur_row++;
+		}
+		// Scroll with the attribute at the cursor, which was on the
+		// last character written
+		if (cur_row == nrows) {
+			const auto fill = cells[num_in_row * 2 - 1];
+			INT10_ScrollWindow(0,
+			                   0,
+			                   (uint8_t)(nrows - 1),
+			                   (uint8_t)(ncols - 1),
+			                   -1,
+			                   fill,
+			                   page);
+			cur_row--;
+		}
+	}
+	if (count) {
+		INT10_SetCursorPos(cur_row, cur_col, page);
+	}
+	return count;
+}
+
 void INT10_TeletypeOutput(uint8_t chr,uint8_t attr) {
 	INT10_TeletypeOutputAttr(chr,attr,CurMode->type!=M_TEXT);
 }
@@ -39,11 +39,49 @@ static uint8_t static_functionality[0x10]=
  /* f */ 0x00   // reserved
 };
 
-static uint16_t map_offset[8]={
+static const uint16_t map_offset[8]={
 	0x0000,0x4000,0x8000,0xc000,
 	0x2000,0x6000,0xa000,0xe000
 };
 
+// Mode sets reload the same font over and over. In text modes the font map
+// is kept apart from the other planes, so it can be checked cheaply before
+// writing it byte by byte through the video memory handler.
+static bool is_font_loaded(PhysPt font, const Bitu count, const Bitu font_offset,
+                           const Bitu map, const Bitu height)
+{
+	if (vga.mode != M_TEXT || (vga.gfx.miscellaneous & 0x2)) {
+		return false;
+	}
+
+	auto is_char_loaded = [&](const Bitu chr, const PhysPt pattern) {
+		const auto char_offset = font_offset + chr * 32;
+		for (Bitu line = 0; line < height; ++line) {
+			if (vga.draw.font[(char_offset + line) & 0xffff] !=
+			    mem_readb(pattern + line)) {
+				return false;
+			}
+		}
+		return true;
+	};
+
+	for (Bitu i = 0; i < count; ++i) {
+		if (!is_char_loaded(i, font)) {
+			return false;
+		}
+		font += height;
+	}
+	if (map & 0x80) {
+		while (Bitu chr = mem_readb(font++)) {
+			if (!is_char_loaded(chr, font)) {
+				return false;
+			}
+			font += height;
+		}
+	}
+	return true;
+}
+
 void INT10_LoadFont(PhysPt font,bool reload,Bitu count,Bitu offset,Bitu map,Bitu height) {
 	PhysPt ftwhere=PhysicalMake(0xa000,map_offset[map & 0x7]+(uint16_t)(offset*32));
 	uint16_t base=real_readw(BIOSMEM_SEG,BIOSMEM_CRTC_ADDRESS);
@@ -56,17 +94,21 @@ void INT10_LoadFont(PhysPt font,bool reload,Bitu count,Bitu offset,Bitu map,Bitu
 	IO_Write(0x3ce,0x05);IO_Write(0x3cf,0x00); // write mode 0, odd/even off in GFX
 	IO_Write(0x3ce,0x06);IO_Write(0x3cf,0x04); // CPU memory window A0000-AFFFF
 
-	//Load character patterns
-	for (Bitu i=0;i<count;i++) {
-		MEM_BlockCopy(ftwhere+i*32,font,height);
-		font+=height;
-	}
-	//Load alternate character patterns
-	if (map & 0x80) {
-		while (Bitu chr=(Bitu)mem_readb(font++)) {
-			MEM_BlockCopy(ftwhere+chr*32,font,height);
+	const auto font_offset = map_offset[map & 0x7] + offset * 32;
+
+	if (!is_font_loaded(font, count, font_offset, map, height)) {
+		//Load character patterns
+		for (Bitu i=0;i<count;i++) {
+			MEM_BlockCopy(ftwhere+i*32,font,height);
 			font+=height;
 		}
+		//Load alternate character patterns
+		if (map & 0x80) {
+			while (Bitu chr=(Bitu)mem_readb(font++)) {
+				MEM_BlockCopy(ftwhere+chr*32,font,height);
+				font+=height;
+			}
+		}
 	}
 
 	//Return to normal text mode
@@ -332,7 +374,7 @@ void INT10_SetupRomMemoryChecksum(void) {
 }
 
 
-uint8_t int10_font_08[256 * 8] = {
+const uint8_t int10_font_08[256 * 8] = {
   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
   0x7e, 0x81, 0xa5, 0x81, 0xbd, 0x99, 0x81, 0x7e,
   0x7e, 0xff, 0xdb, 0xff, 0xc3, 0xe7, 0xff, 0x7e,
@@ -591,7 +633,7 @@ uint8_t int10_font_08[256 * 8] = {
   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
 };
 
-uint8_t int10_font_14[256 * 14] = {
+const uint8_t int10_font_14[256 * 14] = {
   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
   0x7e, 0x81, 0xa5, 0x81, 0x81, 0xbd, 0x99, 0x81,
@@ -1042,7 +1084,7 @@ uint8_t int10_font_14[256 * 14] = {
   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
 };
 
-uint8_t int10_font_16[256 * 16] = {
+const uint8_t int10_font_16[256 * 16] = {
   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
   0x00, 0x00, 0x7e, 0x81, 0xa5, 0x81, 0x81, 0xbd,
@@ -1557,7 +1599,7 @@ uint8_t int10_font_16[256 * 16] = {
   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
 };
 
-uint8_t int10_font_14_alternate[20 * 15 + 1] = {
+const uint8_t int10_font_14_alternate[20 * 15 + 1] = {
   0x1d,
   0x00, 0x00, 0x00, 0x00, 0x24, 0x66, 0xff,
   0x66, 0x24, 0x00, 0x00, 0x00, 0x00, 0x00,
@@ -1621,7 +1663,7 @@ uint8_t int10_font_14_alternate[20 * 15 + 1] = {
   0x00
 };
 
-uint8_t int10_font_16_alternate[19 * 17 + 1] = {
+const uint8_t int10_font_16_alternate[19 * 17 + 1] = {
   0x1d,
   0x00, 0x00, 0x00, 0x00, 0x00, 0x24, 0x66, 0xff,
   0x66, 0x24, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
@@ -19,6 +19,7 @@
 
 #include "int10.h"
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cstring>
@@ -1021,6 +1022,17 @@ static bool INT10_SetVideoMode_OTHER(uint16_t mode, bool clearmem)
 
 static void write_palette_dac_data(const std::vector<Rgb666>& colors)
 {
+	// Mode sets usually load the palette the DAC already holds, so skip
+	// the port writes and just leave the write index where they would
+	const auto is_loaded = colors.size() <= NumVgaColors &&
+	                       std::equal(colors.begin(),
+	                                  colors.end(),
+	                                  std::begin(vga.dac.rgb));
+	if (is_loaded && vga.dac.write_index == 0 && vga.dac.pel_index == 0) {
+		vga.dac.write_index = static_cast<uint8_t>(colors.size());
+		return;
+	}
+
 	for (const auto& c : colors) {
 		IO_Write(VGAREG_DAC_DATA, c.red);
 		IO_Write(VGAREG_DAC_DATA, c.green);
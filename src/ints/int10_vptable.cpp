@@ -93,7 +93,7 @@ const uint8_t vparams_tandy_td[] = {
 };
 #endif
 
-static uint8_t video_parameter_table_vga[0x40*0x1d]={
+static const uint8_t video_parameter_table_vga[0x40*0x1d]={
 // video parameter table for mode 0 (cga emulation)
   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
@@ -325,7 +325,7 @@ static uint8_t video_parameter_table_vga[0x40*0x1d]={
   0x00, 0x00, 0x00, 0x00, 0x00, 0x40, 0x05, 0x0f, 0xff  // graphics registers 0-8
 };
 
-static uint8_t video_parameter_table_ega[0x40*0x17]={
+static const uint8_t video_parameter_table_ega[0x40*0x17]={
 // video parameter table for mode 0 (cga emulation)
   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
@@ -32,6 +32,13 @@
 
 #ifdef HAVE_CONFIG_H
 #  include "config.h"
+#else
+// Without a configure step, pick the intrinsics the compiler targets
+#  if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define HAVE_EMMINTRIN_H 1
+#  elif defined(__ARM_NEON) || defined(_M_ARM64)
+#    define HAVE_ARM_NEON_H 1
+#  endif
 #endif
 
 #ifdef HAVE_EMMINTRIN_H
@@ -102,14 +109,17 @@ int convolve(const short* a, const short* b, int bLength)
     {
         if (offset)
         {
-            const int l = (0x10 - offset)/2;
+            int l = (0x10 - offset)/2;
+
+            if (l > bLength)
+                l = bLength;
 
             for (int i = 0; i < l; i++)
             {
                 out += *a++ * *b++;
             }
 
-            bLength -= offset;
+            bLength -= l;
         }
 
         __m128i acc = _mm_setzero_si128();
@@ -119,7 +129,7 @@ int convolve(const short* a, const short* b, int bLength)
         for (int i = 0; i < n; i++)
         {
             const __m128i tmp = _mm_madd_epi16(*(__m128i*)a, *(__m128i*)b);
-            acc = _mm_add_epi16(acc, tmp);
+            acc = _mm_add_epi32(acc, tmp);
             a += 8;
             b += 8;
         }
@@ -18,11 +18,14 @@
 
 #include "zmbv.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <thread>
 
 #include "math_utils.h"
 #include "mem_unaligned.h"
@@ -36,12 +39,17 @@ constexpr uint8_t DBZV_VERSION_LOW  = 1;
 
 constexpr uint8_t MAX_VECTOR = 16;
 
+// The motion search is spread across threads for the larger frames; 640x480
+// has 1200 blocks
+constexpr size_t MinBlocksPerThread = 512;
+constexpr unsigned MaxSearchThreads = 4;
+
 constexpr uint8_t Mask_KeyFrame     = 0x01;
 constexpr uint8_t Mask_DeltaPalette = 0x02;
 
 // Compression flags
 constexpr uint8_t COMPRESSION_ZLIB     = 1;
-constexpr int ZLIB_COMPRESSION_LEVEL   = 6;          // 0 to 9 (0 = no compression)
+constexpr int ZLIB_COMPRESSION_LEVEL   = 6;          // 1 to 9 (default)
 constexpr auto ZLIB_COMPRESSION_METHOD = Z_DEFLATED; // currently the only option
 constexpr int ZLIB_MEM_LEVEL           = 9;          // 1 to 9 (default 8)
 constexpr auto ZLIB_STRATEGY           = Z_FILTERED; // Z_DEFAULT_STRATEGY, Z_FILTERED,
@@ -122,6 +130,7 @@ bool VideoCodec::SetupBuffers(const ZMBV_FORMAT _format, const int blockwidth, c
 	for (auto y = 0; y < yblocks; ++y) {
 		for (auto x = 0; x < xblocks; ++x) {
 			blocks[i].start = ((y * blockheight) + MAX_VECTOR) * pitch + (x * blockwidth) + MAX_VECTOR;
+			blocks[i].y     = y * blockheight;
 			if (xleft && x == (xblocks - 1)) {
 				blocks[i].dx = xleft;
 			} else {
@@ -160,20 +169,20 @@ void VideoCodec::CreateVectorTable()
 	}
 }
 
+// Only the 24 bits of colour count in the 32-bit formats
 template <class P>
-int VideoCodec::PossibleBlock(const int vx, const int vy, const FrameBlock & block)
+constexpr P PixelMask = static_cast<P>(0x00ffffff);
+
+// Returns the number of differing pixels in a row. Written so the compiler
+// can vectorize it, knowing the width helps with that.
+template <class P, int Width = 0>
+static int count_differences(const P *pold, const P *pnew, const int width)
 {
+	const auto n = Width ? Width : width;
+
 	int ret = 0;
-	P *pold = reinterpret_cast<P *>(oldframe) + block.start + (vy * pitch) + vx;
-	P *pnew = reinterpret_cast<P *>(newframe) + block.start;
-	;
-	for (auto y = 0; y < block.dy; y += 4) {
-		for (auto x = 0; x < block.dx; x += 4) {
-			const auto test = 0 - ((pold[x] - pnew[x]) & 0x00ffffff);
-			ret -= check_cast<int>(test >> 31);
-		}
-		pold += pitch * 4;
-		pnew += pitch * 4;
+	for (auto x = 0; x < n; ++x) {
+		ret += ((pold[x] ^ pnew[x]) & PixelMask<P>) != 0;
 	}
 	return ret;
 }
@@ -181,21 +190,42 @@ int VideoCodec::PossibleBlock(const int vx, const int vy, const FrameBlock & blo
 template <class P>
 int VideoCodec::CompareBlock(const int vx, const int vy, const FrameBlock & block)
 {
+	constexpr auto BlockWidth = 16;
+
 	int ret = 0;
 	P *pold = reinterpret_cast<P *>(oldframe) + block.start + (vy * pitch) + vx;
 	P *pnew = reinterpret_cast<P *>(newframe) + block.start;
-	;
 	for (auto y = 0; y < block.dy; y++) {
-		for (auto x = 0; x < block.dx; x++) {
-			const auto test = 0 - ((pold[x] - pnew[x]) & 0x00ffffff);
-			ret -= check_cast<int>(test >> 31);
-		}
+		ret += (block.dx == BlockWidth)
+		             ? count_differences<P, BlockWidth>(pold, pnew, block.dx)
+		             : count_differences<P>(pold, pnew, block.dx);
 		pold += pitch;
 		pnew += pitch;
 	}
 	return ret;
 }
 
+// Like CompareBlock(), but only samples every 4th pixel of every 4th row.
+// The motion search only wants to know whether there are fewer than 4
+// differences, so this stops counting after a row that got there.
+template <class P>
+int VideoCodec::PossibleBlock(const int vx, const int vy, const FrameBlock & block)
+{
+	int ret = 0;
+	P *pold = reinterpret_cast<P *>(oldframe) + block.start + (vy * pitch) + vx;
+	P *pnew = reinterpret_cast<P *>(newframe) + block.start;
+	for (auto y = 0; y < block.dy; y += 4) {
+		for (auto x = 0; x < block.dx; x += 4) {
+			ret += ((pold[x] ^ pnew[x]) & PixelMask<P>) != 0;
+		}
+		if (ret >= 4)
+			return ret;
+		pold += pitch * 4;
+		pnew += pitch * 4;
+	}
+	return ret;
+}
+
 template <class P>
 void VideoCodec::AddXorBlock(const int vx, const int vy, const FrameBlock & block)
 {
@@ -223,16 +253,28 @@ void VideoCodec::AddXorFrame()
 
 	AlignWork(workUsed);
 
-	size_t b = 0;
-	for (const auto & block : blocks) {
+	// Blocks that only cover unchanged lines are the same as in the
+	// previous frame, no need to compare them
+	auto is_unchanged = [this](const FrameBlock & block) {
+		if (!changedLines)
+			return false;
+		for (auto y = block.y; y < block.y + block.dy; ++y) {
+			if (changedLines[y])
+				return false;
+		}
+		return true;
+	};
+
+	auto search_block = [&](const FrameBlock & block, BlockVector & best) {
+		best = {};
+		if (is_unchanged(block))
+			return;
 
-		int8_t bestvx   = 0;
-		int8_t bestvy   = 0;
-		auto bestchange = CompareBlock<P>(0, 0, block);
-		auto possibles  = 64;
+		best.change    = CompareBlock<P>(0, 0, block);
+		auto possibles = 64;
 
 		for (auto v = 0; v < VectorCount && possibles; v++) {
-			if (bestchange < 4)
+			if (best.change < 4)
 				break;
 			auto vx = VectorTable[v].x;
 			auto vy = VectorTable[v].y;
@@ -241,20 +283,59 @@ void VideoCodec::AddXorFrame()
 				// if (!possibles) Msg("Ran out of possibles, at
 				// %d of %d best%d\n",v,VectorCount,bestchange);
 				auto testchange = CompareBlock<P>(vx, vy, block);
-				if (testchange < bestchange) {
-					bestchange = testchange;
-					bestvx     = check_cast<int8_t>(vx);
-					bestvy     = check_cast<int8_t>(vy);
+				if (testchange < best.change) {
+					best.change = testchange;
+					best.vx     = check_cast<int8_t>(vx);
+					best.vy     = check_cast<int8_t>(vy);
 				}
 			}
 		}
-		vectors[b * 2 + 0] = static_cast<uint8_t>(left_shift_signed(bestvx, 1));
-		vectors[b * 2 + 1] = static_cast<uint8_t>(left_shift_signed(bestvy, 1));
-		if (bestchange) {
+	};
+
+	// The search of each block only reads the old and the new frame, so
+	// the blocks are spread across threads. They take a row of blocks at
+	// a time until none are left.
+	blockVectors.resize(blocks.size());
+
+	std::atomic<size_t> next_block = 0;
+	const auto blocks_per_take     = static_cast<size_t>(width / 16 + 1);
+
+	auto search_blocks = [&]() {
+		for (auto first = next_block.fetch_add(blocks_per_take);
+		     first < blocks.size();
+		     first = next_block.fetch_add(blocks_per_take)) {
+			const auto last = std::min(first + blocks_per_take, blocks.size());
+			for (auto b = first; b < last; ++b)
+				search_block(blocks[b], blockVectors[b]);
+		}
+	};
+
+	const auto max_threads = std::clamp(std::thread::hardware_concurrency(),
+	                                    1u,
+	                                    MaxSearchThreads);
+	const auto num_threads = std::clamp(blocks.size() / MinBlocksPerThread,
+	                                    static_cast<size_t>(1),
+	                                    static_cast<size_t>(max_threads));
+
+	std::vector<std::thread> helpers = {};
+	for (size_t i = 1; i < num_threads; ++i)
+		helpers.emplace_back(search_blocks);
+
+	search_blocks();
+
+	for (auto & helper : helpers)
+		helper.join();
+
+	// Serialize the results in order
+	for (size_t b = 0; b < blocks.size(); ++b) {
+		const auto & best = blockVectors[b];
+
+		vectors[b * 2 + 0] = static_cast<uint8_t>(left_shift_signed(best.vx, 1));
+		vectors[b * 2 + 1] = static_cast<uint8_t>(left_shift_signed(best.vy, 1));
+		if (best.change) {
 			vectors[b * 2 + 0] |= 1;
-			AddXorBlock<P>(bestvx, bestvy, block);
+			AddXorBlock<P>(best.vx, best.vy, blocks[b]);
 		}
-		++b;
 	}
 }
 
@@ -264,7 +345,7 @@ bool VideoCodec::SetupCompress(const int _width, const int _height)
 	height = _height;
 	pitch  = _width + 2 * MAX_VECTOR;
 	format = ZMBV_FORMAT::NONE;
-	if (deflateInit2(&zstream, ZLIB_COMPRESSION_LEVEL, ZLIB_COMPRESSION_METHOD, ZLIB_MEM_LEVEL, ZLIB_MEM_LEVEL, ZLIB_STRATEGY) !=
+	if (deflateInit2(&zstream, compressionLevel, ZLIB_COMPRESSION_METHOD, ZLIB_MEM_LEVEL, ZLIB_MEM_LEVEL, ZLIB_STRATEGY) !=
 	    Z_OK)
 		return false;
 	return true;
@@ -336,6 +417,7 @@ bool VideoCodec::PrepareCompressFrame(int flags, const ZMBV_FORMAT _format, cons
 		}
 		/* Restart deflate */
 		deflateReset(&zstream);
+		deflateParams(&zstream, compressionLevel, ZLIB_STRATEGY);
 	} else {
 		const auto palette_bytes = palsize * 4;
 		if (palsize && pal && memcmp(pal, palette, palette_bytes)) {
@@ -367,6 +449,27 @@ void VideoCodec::CompressLines(const int lineCount, const uint8_t *lineData[])
 	}
 }
 
+// Lets the blocks of the current delta frame which only cover lines flagged
+// as unchanged skip the comparison. The flags need to stay valid until
+// FinishCompressFrame() is called.
+void VideoCodec::SetChangedLines(const uint8_t *lineFlags)
+{
+	changedLines = lineFlags;
+}
+
+// Changing the level mid-stream would need an extra flush, so the new level
+// only applies from the next keyframe on. Any level results in a standard
+// ZMBV stream; 1 is the fastest.
+void VideoCodec::SetCompressionLevel(const int level)
+{
+	compressionLevel = std::clamp(level, 1, 9);
+}
+
+int VideoCodec::GetCompressionLevel() const
+{
+	return compressionLevel;
+}
+
 int VideoCodec::FinishCompressFrame()
 {
 	assert(compress.writeBuf);
@@ -393,6 +496,8 @@ int VideoCodec::FinishCompressFrame()
 		default: break;
 		}
 	}
+	changedLines = nullptr;
+
 	/* Create the actual frame with compression */
 	zstream.next_in  = work.data();
 	zstream.avail_in = check_cast<uint32_t>(workUsed);
@@ -607,4 +712,5 @@ VideoCodec::VideoCodec()
 {
 	CreateVectorTable();
 	memset(&zstream, 0, sizeof(zstream));
+	compressionLevel = ZLIB_COMPRESSION_LEVEL;
 }
@@ -27,6 +27,7 @@
 #if defined(C_SYSTEM_ZLIB_NG)
 #include <zlib-ng.h>
 #define deflateInit2 zng_deflateInit2
+#define deflateParams zng_deflateParams
 #define deflateReset zng_deflateReset
 #define deflate zng_deflate
 #define deflateEnd zng_deflateEnd
@@ -58,9 +59,15 @@ class VideoCodec {
 private:
 	struct FrameBlock {
 		int start = 0;
+		int y = 0;
 		int dx = 0;
 		int dy = 0;
 	};
+	struct BlockVector {
+		int8_t vx = 0;
+		int8_t vy = 0;
+		int change = 0;
+	};
 	struct CodecVector {
 		int x = 0;
 		int y = 0;
@@ -96,6 +103,7 @@ private:
 	uint32_t bufsize = 0;
 
 	std::vector<FrameBlock> blocks = {};
+	std::vector<BlockVector> blockVectors = {};
 	size_t workUsed = 0;
 	size_t workPos = 0;
 
@@ -110,6 +118,13 @@ private:
 	Compress compress = {};
 	z_stream zstream = {};
 
+	// Optional flags for the lines of the frame being compressed, zero
+	// for the lines known to be the same as in the previous frame
+	const uint8_t *changedLines = nullptr;
+
+	// Deflate level of the frames from the next keyframe on
+	int compressionLevel = 0;
+
 	// methods
 	void CreateVectorTable();
 	bool SetupBuffers(ZMBV_FORMAT format, int blockwidth, int blockheight);
@@ -143,6 +158,9 @@ public:
 	int NeededSize(int _width, int _height, ZMBV_FORMAT _format);
 
 	void CompressLines(const int lineCount, const uint8_t *lineData[]);
+	void SetChangedLines(const uint8_t *lineFlags);
+	void SetCompressionLevel(int level);
+	int GetCompressionLevel() const;
 	bool PrepareCompressFrame(int flags, ZMBV_FORMAT _format, const uint8_t *pal, uint8_t *writeBuf, uint32_t writeSize);
 	int FinishCompressFrame();
 	void FinishVideo();
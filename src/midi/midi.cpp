@@ -587,6 +587,12 @@ bool MIDI_Available()
 	return midi.is_available;
 }
 
+static void midi_flush_tick()
+{
+	assert(midi.handler);
+	midi.handler->Flush();
+}
+
 // We'll adapt the RtMidi library, eventually, so hold off any substantial
 // rewrites on the MIDI stuff until then to unnecessary work.
 class MIDI final {
@@ -650,7 +656,10 @@ public:
 		if (!midi.is_available) {
 			LOG_MSG("MIDI: Can't find device: '%s', MIDI is not available",
 			        device_choice.c_str());
+			return;
 		}
+
+		TIMER_AddTickHandler(midi_flush_tick);
 	}
 
 	~MIDI()
@@ -661,6 +670,7 @@ public:
 		}
 
 		assert(midi.handler);
+		TIMER_DelTickHandler(midi_flush_tick);
 		midi.handler->Close();
 		midi.handler      = {};
 		midi.is_available = false;
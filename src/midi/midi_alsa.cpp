@@ -85,9 +85,24 @@ void MidiHandler_alsa::send_event(int do_flush)
 	snd_seq_ev_set_source(&ev, output_port);
 	snd_seq_ev_set_dest(&ev, seq.client, seq.port);
 
+	// Short messages stay in the sequencer's output buffer and are
+	// drained together once per emulated millisecond
 	snd_seq_event_output(seq_handle, &ev);
-	if (do_flush)
+	if (do_flush) {
 		snd_seq_drain_output(seq_handle);
+		has_pending_output = false;
+	} else {
+		has_pending_output = true;
+	}
+}
+
+void MidiHandler_alsa::Flush()
+{
+	if (!has_pending_output)
+		return;
+
+	snd_seq_drain_output(seq_handle);
+	has_pending_output = false;
 }
 
 static bool parse_addr(const std::string &in, int *client, int *port)
@@ -140,19 +155,19 @@ void MidiHandler_alsa::PlayMsg(const MidiMessage& msg)
 	switch (status) {
 	case MidiStatus::NoteOff:
 		snd_seq_ev_set_noteoff(&ev, channel, msg[1], msg[2]);
-		send_event(1);
+		send_event(0);
 		break;
 	case MidiStatus::NoteOn:
 		snd_seq_ev_set_noteon(&ev, channel, msg[1], msg[2]);
-		send_event(1);
+		send_event(0);
 		break;
 	case MidiStatus::PolyKeyPressure:
 		snd_seq_ev_set_keypress(&ev, channel, msg[1], msg[2]);
-		send_event(1);
+		send_event(0);
 		break;
 	case MidiStatus::ControlChange:
 		snd_seq_ev_set_controller(&ev, channel, msg[1], msg[2]);
-		send_event(1);
+		send_event(0);
 		break;
 	case MidiStatus::ProgramChange:
 		snd_seq_ev_set_pgmchange(&ev, channel, msg[1]);
@@ -165,7 +180,7 @@ void MidiHandler_alsa::PlayMsg(const MidiMessage& msg)
 	case MidiStatus::PitchBend: {
 		long theBend = ((long)msg[1] + (long)(msg[2] << 7)) - 0x2000;
 		snd_seq_ev_set_pitchbend(&ev, channel, theBend);
-		send_event(1);
+		send_event(0);
 		break;
 	}
 	default:
@@ -175,7 +190,7 @@ void MidiHandler_alsa::PlayMsg(const MidiMessage& msg)
 		            status_byte,
 		            msg[1],
 		            msg[2]);
-		send_event(1);
+		send_event(0);
 		break;
 	}
 }
@@ -184,6 +199,7 @@ void MidiHandler_alsa::Close()
 {
 	if (seq_handle) {
 		Reset();
+		Flush();
 		snd_seq_close(seq_handle);
 	}
 	seq = {-1, -1};
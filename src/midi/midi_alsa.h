@@ -39,6 +39,7 @@ private:
 	snd_seq_t *seq_handle = nullptr;
 	alsa_address seq = {-1, -1}; // address of input port we're connected to
 	int output_port = 0;
+	bool has_pending_output = false;
 
 	void send_event(int do_flush);
 
@@ -62,6 +63,7 @@ public:
 	void Close() override;
 	void PlayMsg(const MidiMessage& msg) override;
 	void PlaySysex(uint8_t *sysex, size_t len) override;
+	void Flush() override;
 	MIDI_RC ListAll(Program *caller) override;
 };
 
@@ -40,6 +40,12 @@ private:
 	MIDIEndpointRef m_endpoint;
 	MIDIPacket *m_pCurPacket;
 
+	// Short messages are collected here and sent as a single packet list
+	// once per emulated millisecond
+	Byte m_pendingBuf[1024];
+	MIDIPacketList* m_pendingList = nullptr;
+	MIDIPacket* m_pendingPacket   = nullptr;
+
 public:
 	MidiHandler_coremidi()
 	        : MidiHandler(),
@@ -120,6 +126,7 @@ public:
 	{
 		if (m_port && m_client) {
 			Reset();
+			Flush();
 		}
 
 		// Dispose the port
@@ -135,27 +142,46 @@ public:
 
 	void PlayMsg(const MidiMessage& msg) override
 	{
-		// Acquire a MIDIPacketList
-		Byte packetBuf[128];
-		MIDIPacketList* packetList = (MIDIPacketList*)packetBuf;
-		m_pCurPacket               = MIDIPacketListInit(packetList);
-
 		const auto len = MIDI_message_len_by_status[msg.status()];
 
-		// Add msg to the MIDIPacketList
-		MIDIPacketListAdd(packetList,
-		                  (ByteCount)sizeof(packetBuf),
-		                  m_pCurPacket,
-		                  (MIDITimeStamp)0,
-		                  len,
-		                  msg.data.data());
+		auto add_to_pending = [&]() {
+			if (!m_pendingList) {
+				m_pendingList = (MIDIPacketList*)m_pendingBuf;
+				m_pendingPacket = MIDIPacketListInit(m_pendingList);
+			}
+			m_pendingPacket = MIDIPacketListAdd(m_pendingList,
+			                                    (ByteCount)sizeof(m_pendingBuf),
+			                                    m_pendingPacket,
+			                                    (MIDITimeStamp)0,
+			                                    len,
+			                                    msg.data.data());
+			return m_pendingPacket != nullptr;
+		};
+
+		// Send what has been collected so far if the list is full
+		if (!add_to_pending()) {
+			Flush();
+			add_to_pending();
+		}
+	}
+
+	void Flush() override
+	{
+		if (!m_pendingList) {
+			return;
+		}
 
 		// Send the MIDIPacketList
-		MIDISend(m_port, m_endpoint, packetList);
+		MIDISend(m_port, m_endpoint, m_pendingList);
+		m_pendingList   = nullptr;
+		m_pendingPacket = nullptr;
 	}
 
 	void PlaySysex(uint8_t *sysex, size_t len) override
 	{
+		// Keep the ordering with any pending short messages
+		Flush();
+
 		// Acquire a MIDIPacketList
 		Byte packetBuf[MIDI_SYSEX_SIZE * 4];
 		MIDIPacketList *packetList = (MIDIPacketList *)packetBuf;
@@ -41,6 +41,8 @@
 #include "programs.h"
 #include "string_utils.h"
 #include "support.h"
+#include "thread_placement.h"
+#include "tracy.h"
 
 MidiHandlerFluidsynth instance;
 
@@ -62,6 +64,14 @@ static void init_fluid_dosbox_settings(Section_prop& secprop)
 	        "E.g. 'my_soundfont.sf2 50' will attenuate the volume by 50%.\n"
 	        "The percentage value can range from 1 to 800.");
 
+	auto* bool_prop = secprop.Add_bool("fsynth_dynamic_samples", when_idle, false);
+	bool_prop->Set_help(
+	        "Load the SoundFont's sample data when an instrument is first selected,\n"
+	        "rather than all of it when the device opens (disabled by default).\n"
+	        "This speeds up starting with large General MIDI SoundFonts and only keeps\n"
+	        "the instruments in use in memory, at the cost of reading from the SoundFont\n"
+	        "file as programs change.");
+
 	str_prop = secprop.Add_string("fsynth_chorus", when_idle, "auto");
 	str_prop->Set_help(
 	        "Chorus effect: 'auto' (default), 'on', 'off', or custom values.\n"
@@ -263,6 +273,13 @@ bool MidiHandlerFluidsynth::Open([[maybe_unused]] const char* conf)
 	                      "synth.sample-rate",
 	                      sample_rate_hz);
 
+	// With dynamic sample loading, loading the SoundFont only parses its
+	// presets; the samples of a preset are read in when a program change
+	// selects it and dropped again when no channel uses it anymore.
+	fluid_settings_setint(fluid_settings.get(),
+	                      "synth.dynamic-sample-loading",
+	                      section->Get_bool("fsynth_dynamic_samples") ? 1 : 0);
+
 	fsynth_ptr_t fluid_synth(new_fluid_synth(fluid_settings.get()),
 	                         delete_fluid_synth);
 	if (!fluid_synth) {
@@ -276,11 +293,9 @@ bool MidiHandlerFluidsynth::Open([[maybe_unused]] const char* conf)
 
 	const std::string soundfont = find_sf_file(sf_filename).string();
 
-	if (!soundfont.empty() && fluid_synth_sfcount(fluid_synth.get()) == 0) {
-		constexpr auto reset_presets = true;
-		fluid_synth_sfload(fluid_synth.get(), soundfont.c_str(), reset_presets);
-	}
-	if (fluid_synth_sfcount(fluid_synth.get()) == 0) {
+	// Only the header is checked here; the SoundFont itself is loaded by
+	// the rendering thread (see Render())
+	if (soundfont.empty() || !fluid_is_soundfont(soundfont.c_str())) {
 		LOG_WARNING("FSYNTH: FluidSynth failed to load '%s', check the path.",
 		            sf_filename.c_str());
 		return false;
@@ -294,15 +309,7 @@ bool MidiHandlerFluidsynth::Open([[maybe_unused]] const char* conf)
 	}
 	fluid_synth_set_gain(fluid_synth.get(),
 	                     static_cast<float>(scale_by_percent) / 100.0f);
-
-	// Let the user know that the SoundFont was loaded
-	if (scale_by_percent == 100) {
-		LOG_MSG("FSYNTH: Using SoundFont '%s'", soundfont.c_str());
-	} else {
-		LOG_MSG("FSYNTH: Using SoundFont '%s' with volume scaled to %d%%",
-		        soundfont.c_str(),
-		        scale_by_percent);
-	}
+	soundfont_scale_by_percent = scale_by_percent;
 
 	constexpr int fx_group = -1; // applies setting to all groups
 
@@ -522,18 +529,21 @@ bool MidiHandlerFluidsynth::Open([[maybe_unused]] const char* conf)
 		set_section_property_value("fluidsynth", "fsynth_filter", "off");
 	}
 
-	// Double the baseline PCM prebuffer because MIDI is demanding and
-	// bursty. The Mixer's default of ~20 ms becomes 40 ms here, which gives
-	// slower systems a better to keep up (and prevent their audio frame
-	// FIFO from running dry).
-	const auto render_ahead_ms = MIXER_GetPreBufferMs() * 2;
-
 	// Size the out-bound audio frame FIFO
 	assertm(sample_rate_hz >= 8000, "Sample rate must be at least 8 kHz");
 
+	// Start at double the baseline PCM prebuffer because MIDI is demanding
+	// and bursty. The Mixer's default of ~20 ms becomes 40 ms here, which
+	// gives slower systems a better chance to keep up (and prevent their
+	// audio frame FIFO from running dry). The depth then adapts to how
+	// steadily the mixer pulls frames, between one and four prebuffers.
 	const auto audio_frames_per_ms = iround(sample_rate_hz / millis_in_second);
-	audio_frame_fifo.Resize(
-	        check_cast<size_t>(render_ahead_ms * audio_frames_per_ms));
+	const auto prebuffer_frames = MIXER_GetPreBufferMs() * audio_frames_per_ms;
+
+	render_ahead.Configure(prebuffer_frames,
+	                       prebuffer_frames * 4,
+	                       prebuffer_frames * 2);
+	audio_frame_fifo.Resize(check_cast<size_t>(render_ahead.GetDepth()));
 
 	// Size the in-bound work FIFO
 
@@ -740,13 +750,15 @@ void MidiHandlerFluidsynth::ApplySysexMessage(const std::vector<uint8_t>& msg)
 // the mixer until the requested numbers of audio frames is met.
 void MidiHandlerFluidsynth::MixerCallBack(const uint16_t requested_audio_frames)
 {
+	ZoneScoped;
 	assert(mixer_channel);
 
-	// Report buffer underruns
-	constexpr auto warning_percent = 5.0f;
+	// The mixer has to wait for the renderer when fewer frames are queued
+	// than it asks for
+	const auto queued_frames = check_cast<int>(audio_frame_fifo.Size());
+	const auto had_underrun  = queued_frames < requested_audio_frames;
 
-	if (const auto percent_full = audio_frame_fifo.GetPercentFull();
-	    percent_full < warning_percent) {
+	if (had_underrun) {
 		static auto iteration = 0;
 		if (iteration++ % 100 == 0) {
 			LOG_WARNING("FSYNTH: Audio buffer underrun");
@@ -754,6 +766,12 @@ void MidiHandlerFluidsynth::MixerCallBack(const uint16_t requested_audio_frames)
 		had_underruns = true;
 	}
 
+	// Render further ahead after underruns and less far when the mixer
+	// pulls frames steadily
+	const auto depth = render_ahead.Update(queued_frames, requested_audio_frames);
+	audio_frame_fifo.Resize(check_cast<size_t>(depth));
+	mixer_channel->ReportRenderAhead(depth, had_underrun);
+
 	static std::vector<AudioFrame> audio_frames = {};
 
 	const auto has_dequeued = audio_frame_fifo.BulkDequeue(audio_frames,
@@ -822,9 +840,39 @@ void MidiHandlerFluidsynth::ProcessWorkFromFifo()
 	}
 }
 
+void MidiHandlerFluidsynth::LoadSoundFont()
+{
+	ZoneScoped;
+
+	constexpr auto reset_presets = true;
+	if (fluid_synth_sfload(synth.get(), selected_font.c_str(), reset_presets) ==
+	    FLUID_FAILED) {
+		LOG_WARNING("FSYNTH: FluidSynth failed to load '%s'",
+		            selected_font.c_str());
+		return;
+	}
+
+	// Let the user know that the SoundFont was loaded
+	if (soundfont_scale_by_percent == 100) {
+		LOG_MSG("FSYNTH: Using SoundFont '%s'", selected_font.c_str());
+	} else {
+		LOG_MSG("FSYNTH: Using SoundFont '%s' with volume scaled to %d%%",
+		        selected_font.c_str(),
+		        soundfont_scale_by_percent);
+	}
+}
+
 // Keep the fifo populated with freshly rendered buffers
 void MidiHandlerFluidsynth::Render()
 {
+	THREAD_ApplyRole(ThreadRole::Audio);
+
+	// Large SoundFonts take a while to load, so that's done here rather
+	// than in Open() to not hold up the rest of the startup. MIDI work
+	// sent meanwhile waits in the FIFO, and the mixer waits for the first
+	// frames should it ask for them before the load finished.
+	LoadSoundFont();
+
 	while (work_fifo.IsRunning()) {
 		work_fifo.IsEmpty() ? RenderAudioFramesToFifo()
 		                    : ProcessWorkFromFifo();
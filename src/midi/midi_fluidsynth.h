@@ -32,6 +32,7 @@
 #include <thread>
 
 #include "mixer.h"
+#include "render_ahead.h"
 #include "rwqueue.h"
 
 class MidiHandlerFluidsynth final : public MidiHandler {
@@ -64,6 +65,7 @@ private:
 
 	uint16_t GetNumPendingAudioFrames();
 	void RenderAudioFramesToFifo(const uint16_t num_audio_frames = 1);
+	void LoadSoundFont();
 	void Render();
 
 	using fluid_settings_ptr_t =
@@ -75,10 +77,12 @@ private:
 
 	mixer_channel_t mixer_channel = nullptr;
 	RWQueue<AudioFrame> audio_frame_fifo{1};
+	RenderAhead render_ahead = {};
 	RWQueue<MidiWork> work_fifo{1};
 	std::thread renderer = {};
 
 	std::string selected_font = "";
+	int soundfont_scale_by_percent = 100;
 
 	// Used to track the balance of time between the last mixer callback
 	// versus the current MIDI Sysex or Msg event.
@@ -67,6 +67,10 @@ public:
 	                       [[maybe_unused]] size_t len)
 	{}
 
+	// Handlers may buffer short messages; any pending output is delivered
+	// here, which is called once per emulated millisecond
+	virtual void Flush() {}
+
 	virtual MIDI_RC ListAll(Program*)
 	{
 		return MIDI_RC::ERR_DEVICE_LIST_NOT_SUPPORTED;
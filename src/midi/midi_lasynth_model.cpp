@@ -23,6 +23,7 @@
 #if C_MT32EMU
 
 #include <cassert>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "fs_utils.h"
@@ -50,6 +51,48 @@ LASynthModel::LASynthModel(const std::string &rom_name,
 	assert(ctrl_full || (ctrl_a && ctrl_b));
 }
 
+// The ROM IDs of a file in a ROM directory
+struct RomFileIds {
+	std_fs::file_time_type modified = {};
+	uintmax_t size                  = 0;
+
+	std::string pcm_rom_id     = {};
+	std::string control_rom_id = {};
+	bool is_rom                = false;
+};
+
+// Identifying a file reads and hashes all of it, and the model lookups ask
+// for the same files many times over: once per ROM of every model in every
+// directory. The results are kept for the life of the process, so only new or
+// changed files are read again when the device is reopened.
+static const RomFileIds& identify_rom_file(MT32Emu::Service& service,
+                                           const std::string& filename)
+{
+	static std::unordered_map<std::string, RomFileIds> rom_files;
+
+	std::error_code ec;
+	const auto modified = std_fs::last_write_time(filename, ec);
+	const auto size     = std_fs::file_size(filename, ec);
+
+	auto& ids = rom_files[filename];
+	if (ids.modified == modified && ids.size == size && !ec) {
+		return ids;
+	}
+
+	ids          = {};
+	ids.modified = modified;
+	ids.size     = size;
+
+	mt32emu_rom_info info;
+	if (service.identifyROMFile(&info, filename.c_str(), nullptr) ==
+	    MT32EMU_RC_OK) {
+		ids.is_rom         = true;
+		ids.pcm_rom_id     = info.pcm_rom_id ? info.pcm_rom_id : "";
+		ids.control_rom_id = info.control_rom_id ? info.control_rom_id : "";
+	}
+	return ids;
+}
+
 std::optional<std_fs::path> LASynthModel::find_rom(const service_t& service,
                                                    const std_fs::path& dir,
                                                    const Rom* rom)
@@ -69,10 +112,8 @@ std::optional<std_fs::path> LASynthModel::find_rom(const service_t& service,
 		if (ec) {
 			continue;
 		}
-		mt32emu_rom_info info;
-		if (service->identifyROMFile(&info,
-		                             filename.c_str(),
-		                             nullptr) != MT32EMU_RC_OK) {
+		const auto& ids = identify_rom_file(*service, filename);
+		if (!ids.is_rom) {
 			// Only log unknwon files one time (if not already in the unknown_files set).
 			if (unknown_files.insert(filename).second) {
 				LOG_WARNING("MT32: Unknown file in ROM folder: %s", filename.c_str());
@@ -80,14 +121,14 @@ std::optional<std_fs::path> LASynthModel::find_rom(const service_t& service,
 			continue;
 		}
 
-		const char* rom_id = nullptr;
+		const std::string* rom_id = nullptr;
 		if (rom->type == ROM_TYPE::PCM) {
-			rom_id = info.pcm_rom_id;
+			rom_id = &ids.pcm_rom_id;
 		} else if (rom->type == ROM_TYPE::CONTROL) {
-			rom_id = info.control_rom_id;
+			rom_id = &ids.control_rom_id;
 		}
 
-		if (rom_id && rom->id == rom_id) {
+		if (rom_id && !rom_id->empty() && rom->id == *rom_id) {
 			return entry.path();
 		}
 	}
@@ -46,6 +46,8 @@
 #include "pic.h"
 #include "string_utils.h"
 #include "support.h"
+#include "thread_placement.h"
+#include "tracy.h"
 
 // mt32emu Settings
 // ----------------
@@ -823,18 +825,21 @@ bool MidiHandler_mt32::Open([[maybe_unused]] const char* conf)
 		set_section_property_value("mt32", "mt32_filter", "off");
 	}
 
-	// Double the baseline PCM prebuffer because MIDI is demanding and
-	// bursty. The Mixer's default of ~20 ms becomes 40 ms here, which gives
-	// slower systems a better to keep up (and prevent their audio frame
-	// FIFO from running dry).
-	const auto render_ahead_ms = MIXER_GetPreBufferMs() * 2;
-
 	// Size the out-bound audio frame FIFO
 	assertm(sample_rate_hz >= 8000, "Sample rate must be at least 8 kHz");
 
+	// Start at double the baseline PCM prebuffer because MIDI is demanding
+	// and bursty. The Mixer's default of ~20 ms becomes 40 ms here, which
+	// gives slower systems a better chance to keep up (and prevent their
+	// audio frame FIFO from running dry). The depth then adapts to how
+	// steadily the mixer pulls frames, between one and four prebuffers.
 	const auto audio_frames_per_ms = iround(sample_rate_hz / millis_in_second);
-	audio_frame_fifo.Resize(
-	        check_cast<size_t>(render_ahead_ms * audio_frames_per_ms));
+	const auto prebuffer_frames = MIXER_GetPreBufferMs() * audio_frames_per_ms;
+
+	render_ahead.Configure(prebuffer_frames,
+	                       prebuffer_frames * 4,
+	                       prebuffer_frames * 2);
+	audio_frame_fifo.Resize(check_cast<size_t>(render_ahead.GetDepth()));
 
 	// Size the in-bound work FIFO
 
@@ -964,13 +969,15 @@ void MidiHandler_mt32::PlaySysex(uint8_t* sysex, size_t len)
 // the mixer until the requested numbers of audio frames is met.
 void MidiHandler_mt32::MixerCallBack(const uint16_t requested_audio_frames)
 {
+	ZoneScoped;
 	assert(channel);
 
-	// Report buffer underruns
-	constexpr auto warning_percent = 5.0f;
+	// The mixer has to wait for the renderer when fewer frames are queued
+	// than it asks for
+	const auto queued_frames = check_cast<int>(audio_frame_fifo.Size());
+	const auto had_underrun  = queued_frames < requested_audio_frames;
 
-	if (const auto percent_full = audio_frame_fifo.GetPercentFull();
-	    percent_full < warning_percent) {
+	if (had_underrun) {
 		static auto iteration = 0;
 		if (iteration++ % 100 == 0) {
 			LOG_WARNING("MT32: Audio buffer underrun");
@@ -978,6 +985,12 @@ void MidiHandler_mt32::MixerCallBack(const uint16_t requested_audio_frames)
 		had_underruns = true;
 	}
 
+	// Render further ahead after underruns and less far when the mixer
+	// pulls frames steadily
+	const auto depth = render_ahead.Update(queued_frames, requested_audio_frames);
+	audio_frame_fifo.Resize(check_cast<size_t>(depth));
+	channel->ReportRenderAhead(depth, had_underrun);
+
 	static std::vector<AudioFrame> audio_frames = {};
 
 	const auto has_dequeued = audio_frame_fifo.BulkDequeue(audio_frames,
@@ -1054,6 +1067,8 @@ void MidiHandler_mt32::ProcessWorkFromFifo()
 // Keep the fifo populated with freshly rendered buffers
 void MidiHandler_mt32::Render()
 {
+	THREAD_ApplyRole(ThreadRole::Audio);
+
 	while (work_fifo.IsRunning()) {
 		work_fifo.IsEmpty() ? RenderAudioFramesToFifo()
 		                    : ProcessWorkFromFifo();
@@ -38,6 +38,7 @@
 #include <mt32emu/mt32emu.h>
 
 #include "mixer.h"
+#include "render_ahead.h"
 #include "rwqueue.h"
 #include "std_filesystem.h"
 
@@ -86,6 +87,7 @@ private:
 	// Managed objects
 	mixer_channel_t channel = nullptr;
 	RWQueue<AudioFrame> audio_frame_fifo{1};
+	RenderAhead render_ahead = {};
 	RWQueue<MidiWork> work_fifo{1};
 
 	std::mutex service_mutex = {};
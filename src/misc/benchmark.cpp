@@ -0,0 +1,353 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "benchmark.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cpu.h"
+#include "dosbox.h"
+#include "event_counters.h"
+#include "host_memory.h"
+#include "mixer.h"
+#include "pic.h"
+#include "render.h"
+#include "string_utils.h"
+#include "support.h"
+#include "timer.h"
+#include "video.h"
+
+extern bool ticksLocked;
+
+static struct {
+	bool is_running = false;
+
+	int64_t emulated_ms_wanted = 0;
+	int64_t emulated_ms        = 0;
+	int64_t cycles             = 0;
+
+	int64_t start_ns     = 0;
+	int64_t start_frames = 0;
+
+	std::string report_path = {};
+} benchmark = {};
+
+struct BenchmarkResults {
+	double emulated_seconds = 0.0;
+	double host_seconds     = 0.0;
+
+	double emulated_mips          = 0.0;
+	int64_t cycles_per_emulated_ms = 0;
+
+	int64_t num_frames            = 0;
+	double frames_per_host_second = 0.0;
+
+	int64_t audio_frames_mixed = 0;
+
+	// Host time per mixer channel, in ms
+	std::vector<std::pair<std::string, double>> channel_ms = {};
+
+	double effects_ms   = 0.0;
+	double audio_ms     = 0.0;
+	double present_ms   = 0.0;
+	double emulation_ms = 0.0;
+};
+
+// Slots listed per event counter in the report (e.g., the busiest I/O ports)
+constexpr size_t MaxReportedSlots = 16;
+
+static BenchmarkResults take_results()
+{
+	constexpr auto ns_per_ms = 1'000'000.0;
+
+	BenchmarkResults results = {};
+
+	const auto elapsed_ns = std::max(GetTicksNs() - benchmark.start_ns,
+	                                 int64_t{1});
+	results.host_seconds = static_cast<double>(elapsed_ns) /
+	                       (ns_per_ms * 1000.0);
+	results.emulated_seconds = static_cast<double>(benchmark.emulated_ms) /
+	                           1000.0;
+
+	results.emulated_mips = static_cast<double>(benchmark.cycles) /
+	                        (results.host_seconds * 1e6);
+	results.cycles_per_emulated_ms = benchmark.cycles /
+	                                 std::max(benchmark.emulated_ms, int64_t{1});
+
+	results.num_frames = RENDER_GetFrameCount() - benchmark.start_frames;
+	results.frames_per_host_second = static_cast<double>(results.num_frames) /
+	                                 results.host_seconds;
+
+	MIXER_LockAudioDevice();
+
+	const auto mixer_stats = MIXER_TakeStats();
+
+	int64_t audio_ns = mixer_stats.effects_ns;
+	for (auto& [name, chan] : MIXER_GetChannels()) {
+		const auto stats = chan->TakeStats();
+
+		const auto total_ns = stats.device_ns + stats.resample_ns +
+		                      stats.filter_ns;
+		if (total_ns == 0) {
+			continue;
+		}
+		audio_ns += total_ns;
+		results.channel_ms.emplace_back(name,
+		                                static_cast<double>(total_ns) / ns_per_ms);
+	}
+
+	MIXER_UnlockAudioDevice();
+
+	results.audio_frames_mixed = mixer_stats.frames_mixed;
+
+	const auto present_ns = GFX_TakePresentTimeUs() * 1000;
+	const auto emulation_ns = std::max(elapsed_ns - audio_ns - present_ns,
+	                                   int64_t{0});
+
+	results.effects_ms   = static_cast<double>(mixer_stats.effects_ns) / ns_per_ms;
+	results.audio_ms     = static_cast<double>(audio_ns) / ns_per_ms;
+	results.present_ms   = static_cast<double>(present_ns) / ns_per_ms;
+	results.emulation_ms = static_cast<double>(emulation_ns) / ns_per_ms;
+
+	return results;
+}
+
+static void log_results(const BenchmarkResults& results)
+{
+	LOG_MSG("BENCHMARK: Ran %.1f emulated seconds in %.3f host seconds (%.2fx real time)",
+	        results.emulated_seconds,
+	        results.host_seconds,
+	        results.emulated_seconds / results.host_seconds);
+
+	LOG_MSG("BENCHMARK: %.2f emulated MIPS, %" PRId64 " cycles per emulated ms",
+	        results.emulated_mips,
+	        results.cycles_per_emulated_ms);
+
+	LOG_MSG("BENCHMARK: %" PRId64 " frames rendered (%.1f per host second)",
+	        results.num_frames,
+	        results.frames_per_host_second);
+
+	LOG_MSG("BENCHMARK: %" PRId64 " audio frames mixed",
+	        results.audio_frames_mixed);
+
+	std::string channel_times = {};
+	for (const auto& [name, ms] : results.channel_ms) {
+		channel_times += format_str(" %s %.1f ms,", name.c_str(), ms);
+	}
+	LOG_MSG("BENCHMARK: Host time:%s master effects %.1f ms",
+	        channel_times.c_str(),
+	        results.effects_ms);
+
+	LOG_MSG("BENCHMARK: Host time: audio %.1f ms, presenting %.1f ms, CPU and devices %.1f ms",
+	        results.audio_ms,
+	        results.present_ms,
+	        results.emulation_ms);
+}
+
+static std::string to_json_string(const std::string& str)
+{
+	std::string escaped = "\"";
+	for (const auto c : str) {
+		switch (c) {
+		case '"': escaped += "\\\""; break;
+		case '\\': escaped += "\\\\"; break;
+		case '\n': escaped += "\\n"; break;
+		case '\t': escaped += "\\t"; break;
+		default:
+			if (static_cast<unsigned char>(c) < 0x20) {
+				escaped += format_str("\\u%04x", c);
+			} else {
+				escaped += c;
+			}
+		}
+	}
+	return escaped + "\"";
+}
+
+static std::string to_json_counter(const EventCounter& counter)
+{
+	auto json = format_str("    {\"name\": %s, \"total\": %" PRIu64,
+	                       to_json_string(counter.GetName()).c_str(),
+	                       counter.GetTotal());
+
+	if (counter.GetNumSlots() > 1) {
+		std::vector<std::pair<uint64_t, size_t>> slots = {};
+		for (size_t slot = 0; slot < counter.GetNumSlots(); ++slot) {
+			if (const auto count = counter.Get(slot); count) {
+				slots.emplace_back(count, slot);
+			}
+		}
+		// Busiest first, and in slot order among equal counts
+		std::sort(slots.begin(), slots.end(), [](const auto& a, const auto& b) {
+			return a.first != b.first ? a.first > b.first
+			                          : a.second < b.second;
+		});
+		if (slots.size() > MaxReportedSlots) {
+			slots.resize(MaxReportedSlots);
+		}
+
+		json += ", \"busiest\": [";
+		for (size_t i = 0; i < slots.size(); ++i) {
+			char label[32];
+			safe_sprintf(label, counter.GetSlotFormat(), slots[i].second);
+			json += format_str("%s{\"slot\": %s, \"count\": %" PRIu64 "}",
+			                   i ? ", " : "",
+			                   to_json_string(label).c_str(),
+			                   slots[i].first);
+		}
+		json += "]";
+	}
+	return json + "}";
+}
+
+// Writes the results and the event counters (the dynrec and I/O port
+// counters among them) as JSON, for comparing runs with scripts
+static void write_json_report(const BenchmarkResults& results, const std::string& path)
+{
+	std::string json = "{\n";
+
+	json += format_str("  \"version\": %s,\n",
+	                   to_json_string(DOSBOX_GetDetailedVersion()).c_str());
+	json += format_str("  \"cycles\": %s,\n",
+	                   CPU_CycleAutoAdjust ? "\"max\"" : "\"fixed\"");
+	json += format_str("  \"emulated_seconds\": %.3f,\n", results.emulated_seconds);
+	json += format_str("  \"host_seconds\": %.6f,\n", results.host_seconds);
+	json += format_str("  \"emulated_mips\": %.3f,\n", results.emulated_mips);
+	json += format_str("  \"cycles_per_emulated_ms\": %" PRId64 ",\n",
+	                   results.cycles_per_emulated_ms);
+	json += format_str("  \"frames\": %" PRId64 ",\n", results.num_frames);
+	json += format_str("  \"frames_per_host_second\": %.3f,\n",
+	                   results.frames_per_host_second);
+	json += format_str("  \"audio_frames_mixed\": %" PRId64 ",\n",
+	                   results.audio_frames_mixed);
+
+	json += "  \"audio_host_ms\": {";
+	for (const auto& [name, ms] : results.channel_ms) {
+		json += format_str("%s: %.3f, ", to_json_string(name).c_str(), ms);
+	}
+	json += format_str("\"master_effects\": %.3f},\n", results.effects_ms);
+
+	json += format_str(
+	        "  \"host_ms\": {\"audio\": %.3f, \"presenting\": %.3f, \"emulation\": %.3f},\n",
+	        results.audio_ms,
+	        results.present_ms,
+	        results.emulation_ms);
+
+	if (const auto peak_bytes = HOSTMEM_GetPeakResidentBytes(); peak_bytes) {
+		json += format_str("  \"peak_resident_bytes\": %zu,\n", *peak_bytes);
+	} else {
+		json += "  \"peak_resident_bytes\": null,\n";
+	}
+
+	json += "  \"counters\": [";
+	auto is_first = true;
+	for (const auto counter : COUNTERS_GetAll()) {
+		if (counter->GetTotal() == 0) {
+			continue;
+		}
+		json += is_first ? "\n" : ",\n";
+		json += to_json_counter(*counter);
+		is_first = false;
+	}
+	json += is_first ? "]\n" : "\n  ]\n";
+	json += "}\n";
+
+	const auto file = make_fopen(path.c_str(), "wb");
+	if (!file || fwrite(json.data(), 1, json.size(), file.get()) != json.size()) {
+		LOG_WARNING("BENCHMARK: Failed writing the report to '%s'", path.c_str());
+		return;
+	}
+	LOG_MSG("BENCHMARK: Wrote the report to '%s'", path.c_str());
+}
+
+static void reset_counters()
+{
+	MIXER_LockAudioDevice();
+	MIXER_TakeStats();
+	for (auto& [_, chan] : MIXER_GetChannels()) {
+		chan->TakeStats();
+	}
+	MIXER_UnlockAudioDevice();
+
+	GFX_TakePresentTimeUs();
+	COUNTERS_ResetAll();
+
+	benchmark.start_frames = RENDER_GetFrameCount();
+	benchmark.start_ns     = GetTicksNs();
+}
+
+static void start_run()
+{
+	// Fixed cycles don't depend on the host's clock, so there's no need
+	// to wait for it; 'cycles = max' needs it to find the host's limit
+	if (!CPU_CycleAutoAdjust) {
+		ticksLocked = true;
+	}
+
+	LOG_MSG("BENCHMARK: Running for %" PRId64 " emulated seconds with %s cycles",
+	        benchmark.emulated_ms_wanted / 1000,
+	        CPU_CycleAutoAdjust ? "max" : "fixed");
+
+	reset_counters();
+}
+
+static void benchmark_tick()
+{
+	// The run starts with the first emulated millisecond, once all the
+	// modules are set up
+	if (benchmark.emulated_ms == 0) {
+		start_run();
+	}
+
+	benchmark.cycles += CPU_CycleMax;
+
+	if (++benchmark.emulated_ms < benchmark.emulated_ms_wanted) {
+		return;
+	}
+
+	const auto results = take_results();
+	log_results(results);
+	if (!benchmark.report_path.empty()) {
+		write_json_report(results, benchmark.report_path);
+	}
+
+	TIMER_DelTickHandler(benchmark_tick);
+	benchmark.is_running = false;
+	GFX_RequestExit(true);
+}
+
+void BENCHMARK_Start(const int emulated_seconds, const std::string& report_path)
+{
+	if (benchmark.is_running) {
+		return;
+	}
+
+	benchmark = {};
+
+	benchmark.is_running         = true;
+	benchmark.emulated_ms_wanted = int64_t{std::max(emulated_seconds, 1)} * 1000;
+	benchmark.report_path        = report_path;
+
+	TIMER_AddTickHandler(benchmark_tick);
+}
@@ -23,24 +23,37 @@
 #include <cstring>
 
 #include "control.h"
+#include "ethernet_replay.h"
 #include "ethernet_slirp.h"
+#include "ethernet_tap.h"
 
 EthernetConnection *ETHERNET_OpenConnection([[maybe_unused]] const std::string &backend)
 {
 	EthernetConnection *conn = nullptr;
 #if C_SLIRP
-	// Currently only slirp is supported
-	if (backend == "slirp") {
+	if (backend == "slirp")
 		conn = new SlirpEthernetConnection;
-		assert(control);
-		const auto settings = control->GetSection("ethernet");
-		if (!conn->Initialize(settings)) {
-			LOG_WARNING("Failed to initialize the slirp Ethernet backend");
-			delete conn;
-			conn = nullptr;
-		}
-	}
 #endif
+#if C_NE2000 && !defined(WIN32)
+	if (backend == "tap")
+		conn = new TapEthernetConnection;
+#endif
+#if C_NE2000
+	if (backend == "replay")
+		conn = new ReplayEthernetConnection;
+#endif
+	if (!conn) {
+		LOG_WARNING("The '%s' Ethernet backend isn't available on this platform",
+		            backend.c_str());
+		return nullptr;
+	}
 
+	assert(control);
+	const auto settings = control->GetSection("ethernet");
+	if (!conn->Initialize(settings)) {
+		LOG_WARNING("Failed to initialize the %s Ethernet backend", backend.c_str());
+		delete conn;
+		conn = nullptr;
+	}
 	return conn;
 }
@@ -0,0 +1,57 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "ethernet_replay.h"
+
+#if C_NE2000
+
+#include <cassert>
+
+#include "setup.h"
+
+bool ReplayEthernetConnection::Initialize(Section* dosbox_config)
+{
+	const auto section = static_cast<Section_prop*>(dosbox_config);
+	assert(section);
+
+	const auto path = section->Get_path("replay_file");
+	if (!path || path->realpath.empty()) {
+		LOG_WARNING("REPLAY: No 'replay_file' was set");
+		return false;
+	}
+	log = NetworkLogReader::Open(path->realpath.string(),
+	                             NetworkLogSource::Ethernet);
+	return log != nullptr;
+}
+
+void ReplayEthernetConnection::SendPacket([[maybe_unused]] const uint8_t* packet,
+                                          [[maybe_unused]] const int len)
+{}
+
+void ReplayEthernetConnection::GetPackets(std::function<int(const uint8_t*, int)> callback)
+{
+	while (log->NextDue(record)) {
+		if (record.direction == NetworkLogDirection::ToGuest) {
+			callback(record.data.data(), static_cast<int>(record.data.size()));
+		}
+	}
+}
+
+#endif
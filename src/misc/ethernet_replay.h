@@ -0,0 +1,61 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_ETHERNET_REPLAY_H
+#define DOSBOX_ETHERNET_REPLAY_H
+
+#include "dosbox.h"
+
+#if C_NE2000
+
+#include <memory>
+
+#include "config.h"
+#include "ethernet.h"
+#include "network_log.h"
+
+/** An Ethernet connection replaying a packet log
+ * This backend feeds the frames a capture recorded as received back to the
+ * card at the same emulated times, without touching the network. Frames the
+ * guest sends are discarded, so a recorded session plays out the same way
+ * as long as the guest behaves like it did during the capture.
+ *
+ * Captures are made with the 'capture_file' setting of any other backend.
+ */
+class ReplayEthernetConnection : public EthernetConnection {
+public:
+	ReplayEthernetConnection() = default;
+
+	/* We can't copy this */
+	ReplayEthernetConnection(const ReplayEthernetConnection&) = delete;
+	ReplayEthernetConnection& operator=(const ReplayEthernetConnection&) = delete;
+
+	bool Initialize(Section* config) override;
+	void SendPacket(const uint8_t* packet, int len) override;
+	void GetPackets(std::function<int(const uint8_t*, int)> callback) override;
+
+private:
+	std::unique_ptr<NetworkLogReader> log = {};
+	NetworkLogRecord record               = {};
+};
+
+#endif
+
+#endif
@@ -23,6 +23,8 @@
 #if C_SLIRP
 
 #include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <map>
 #include <stdexcept>
 
@@ -34,6 +36,7 @@
 #include "ethernet_slirp.h"
 #include "setup.h"
 #include "string_utils.h"
+#include "support.h"
 #include "timer.h"
 
 /* Begin boilerplate to map libslirp's C-based callbacks to our C++
@@ -129,7 +132,6 @@ SlirpEthernetConnection::SlirpEthernetConnection()
         : EthernetConnection(),
           config(),
           timers(),
-          get_packet_callback(),
           registered_fds(),
 #ifdef WIN32
           readfds(),
@@ -152,6 +154,10 @@ SlirpEthernetConnection::SlirpEthernetConnection()
 
 SlirpEthernetConnection::~SlirpEthernetConnection()
 {
+	is_running = false;
+	if (network_thread.joinable())
+		network_thread.join();
+
 	if (slirp)
 		slirp_cleanup(slirp);
 }
@@ -172,7 +178,7 @@ bool SlirpEthernetConnection::Initialize(Section *dosbox_config)
 	config.disable_host_loopback = false;
 
 	// The maximum transmission and receive unit sizes.
-	constexpr auto ethernet_frame_size = 14 + 1500; // header + payload
+	constexpr auto ethernet_frame_size = EthernetFrame::MaxSize;
 	config.if_mtu = ethernet_frame_size;
 	config.if_mru = ethernet_frame_size;
 
@@ -217,6 +223,11 @@ bool SlirpEthernetConnection::Initialize(Section *dosbox_config)
 		ClearPortForwards(is_udp, forwarded_udp_ports);
 		forwarded_udp_ports = SetupPortForwards(is_udp, section->Get_string("udp_port_forwards"));
 
+		// From here on only the network thread uses libslirp
+		is_running = true;
+		network_thread = std::thread(&SlirpEthernetConnection::Run, this);
+		set_thread_name(network_thread, "dosbox:slirp");
+
 		LOG_MSG("SLIRP: Successfully initialized");
 		return true;
 	} else {
@@ -368,19 +379,65 @@ void SlirpEthernetConnection::SendPacket(const uint8_t *packet, int len)
 		            len, GetMTU());
 		return;
 	}
-	slirp_input(slirp, packet, len);
+	const auto frame = tx_frames.BeginWrite();
+	if (!frame) {
+		LOG_DEBUG("SLIRP: dropped a sent packet, the queue is full");
+		stats.AddDropped();
+		return;
+	}
+	frame->len = len;
+	memcpy(frame->data.data(), packet, static_cast<size_t>(len));
+	tx_frames.CommitWrite();
+	stats.AddSent(static_cast<uint64_t>(len));
 }
 
 void SlirpEthernetConnection::GetPackets(std::function<int(const uint8_t *, int)> callback)
 {
-	get_packet_callback = callback;
-	uint32_t timeout_ms = 0;
-	PollsClear();
-	PollsAddRegistered();
-	slirp_pollfds_fill(slirp, &timeout_ms, slirp_add_poll, this);
-	const bool poll_failed = !PollsPoll(timeout_ms);
-	slirp_pollfds_poll(slirp, poll_failed, slirp_get_revents, this);
-	TimersRun();
+	// Only pass on what was there when we started, so a busy network
+	// can't keep us here
+	const auto start_us   = GetTicksUs();
+	const auto num_frames = rx_frames.GetNumReadable();
+	stats.SetQueued(num_frames);
+	for (size_t i = 0; i < num_frames; ++i) {
+		const auto& frame = rx_frames.Peek(i);
+		stats.AddLatency(GetTicksUs() - frame.received_us);
+		callback(frame.data.data(), frame.len);
+	}
+	rx_frames.Consume(num_frames);
+	stats.Tick(GetTicksUsSince(start_us));
+}
+
+void SlirpEthernetConnection::TransmitQueued()
+{
+	const auto num_frames = tx_frames.GetNumReadable();
+	for (size_t i = 0; i < num_frames; ++i) {
+		const auto& frame = tx_frames.Peek(i);
+		slirp_input(slirp, frame.data.data(), frame.len);
+	}
+	tx_frames.Consume(num_frames);
+}
+
+void SlirpEthernetConnection::Run()
+{
+	// Caps how long a frame sent by the guest waits for the poll to end
+	constexpr uint32_t MaxPollMs = 1;
+
+	while (is_running) {
+		TransmitQueued();
+
+		uint32_t timeout_ms = MaxPollMs;
+		PollsClear();
+		PollsAddRegistered();
+		slirp_pollfds_fill(slirp, &timeout_ms, slirp_add_poll, this);
+		timeout_ms = std::min(timeout_ms, MaxPollMs);
+		const bool poll_failed = !PollsPoll(timeout_ms);
+		slirp_pollfds_poll(slirp, poll_failed, slirp_get_revents, this);
+		TimersRun();
+
+		// Without any sockets the poll returns right away
+		if (poll_failed)
+			std::this_thread::sleep_for(std::chrono::milliseconds(MaxPollMs));
+	}
 }
 
 int SlirpEthernetConnection::ReceivePacket(const uint8_t *packet, int len)
@@ -393,7 +450,18 @@ int SlirpEthernetConnection::ReceivePacket(const uint8_t *packet, int len)
 		            len, GetMRU());
 		return -1;
 	}
-	return get_packet_callback(packet, len);
+	const auto frame = rx_frames.BeginWrite();
+	if (!frame) {
+		LOG_DEBUG("SLIRP: dropped a received packet, the queue is full");
+		stats.AddDropped();
+		return len;
+	}
+	frame->len = len;
+	memcpy(frame->data.data(), packet, static_cast<size_t>(len));
+	frame->received_us = GetTicksUs();
+	rx_frames.CommitWrite();
+	stats.AddReceived(static_cast<uint64_t>(len));
+	return len;
 }
 
 struct slirp_timer *SlirpEthernetConnection::TimerNew(SlirpTimerCb cb, void *cb_opaque)
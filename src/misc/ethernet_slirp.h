@@ -25,8 +25,10 @@
 
 #if C_SLIRP
 
+#include <atomic>
 #include <map>
 #include <deque>
+#include <thread>
 #include <vector>
 
 // Specific unreleased slirp to work with MSVC
@@ -40,6 +42,8 @@
 
 #include "config.h"
 #include "ethernet.h"
+#include "network_stats.h"
+#include "spsc_ring.h"
 
 /*
  * libslirp really wants a poll() API, so we'll use that when we're
@@ -70,6 +74,11 @@ struct slirp_timer {
  * This backend uses a virtual Ethernet device. Only TCP, UDP and some ICMP
  * work over this interface. This is because libslirp terminates guest
  * connections during routing and passes them to sockets created in the host.
+ *
+ * Once initialized, libslirp is only touched by its own network thread,
+ * which polls the host sockets and runs the timers. Frames are handed
+ * between that thread and the emulated adapter through lock-free rings,
+ * so the emulation thread never waits on the host's network.
  */
 class SlirpEthernetConnection : public EthernetConnection {
 public:
@@ -85,7 +94,8 @@ public:
 	void SendPacket(const uint8_t* packet, int len) override;
 	void GetPackets(std::function<int(const uint8_t*, int)> callback) override;
 
-	/* Called by libslirp when it has a packet for us */
+	/* Called by libslirp (on the network thread) when it has a packet
+	 * for us */
 	int ReceivePacket(const uint8_t* packet, int len);
 
 	// Used in callbacks to bounds-check packet lengths
@@ -110,6 +120,12 @@ public:
 	void PollUnregister(int fd);
 
 private:
+	/* The network thread's loop */
+	void Run();
+
+	/* Hands the queued guest frames to libslirp */
+	void TransmitQueued();
+
 	/* Runs and clears all the timers*/
 	void TimersRun();
 	void TimersClear();
@@ -127,15 +143,18 @@ private:
 	SlirpCb slirp_callbacks = {};  /*!< Callbacks used by libslirp */
 	std::deque<struct slirp_timer *> timers = {}; /*!< Stored timers */
 
-	/** The GetPacket callback
-	 * When libslirp has a new packet for us it calls ReceivePacket,
-	 * but the EthernetConnection interface requires users to poll
-	 * for new packets using GetPackets. We temporarily store the
-	 * callback from GetPackets here for ReceivePacket.
-	 * This might seem racy, but keep in mind we control when
-	 * libslirp sends us packets via our polling system.
+	/** Frames queued for the guest by ReceivePacket, and for libslirp by
+	 * SendPacket. Frames that don't fit are dropped, like on a real
+	 * network.
 	 */
-	std::function<int(const uint8_t *, int)> get_packet_callback = nullptr;
+	static constexpr size_t FrameRingSize = 128;
+	SpscRing<EthernetFrame> rx_frames{FrameRingSize};
+	SpscRing<EthernetFrame> tx_frames{FrameRingSize};
+
+	std::thread network_thread = {};
+	std::atomic<bool> is_running = false;
+
+	NetworkStats stats{"Ethernet (slirp)"};
 
 	std::deque<int> registered_fds = {}; /*!< File descriptors to watch */
 
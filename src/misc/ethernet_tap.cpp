@@ -0,0 +1,186 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "ethernet_tap.h"
+
+#if C_NE2000 && !defined(WIN32)
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/if_tun.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#endif
+
+#include "setup.h"
+#include "string_utils.h"
+#include "support.h"
+#include "timer.h"
+
+TapEthernetConnection::~TapEthernetConnection()
+{
+	is_running = false;
+	if (network_thread.joinable()) {
+		network_thread.join();
+	}
+	if (fd != -1) {
+		close(fd);
+	}
+}
+
+bool TapEthernetConnection::Open(const std::string& interface_name)
+{
+#if defined(__linux__)
+	fd = open("/dev/net/tun", O_RDWR | O_NONBLOCK);
+	if (fd == -1) {
+		LOG_WARNING("TAP: Failed opening /dev/net/tun: %s",
+		            strerror(errno));
+		return false;
+	}
+	struct ifreq request = {};
+	request.ifr_flags = IFF_TAP | IFF_NO_PI;
+	safe_strcpy(request.ifr_name, interface_name.c_str());
+	if (ioctl(fd, TUNSETIFF, &request) == -1) {
+		LOG_WARNING("TAP: Failed attaching to interface '%s': %s",
+		            interface_name.c_str(),
+		            strerror(errno));
+		return false;
+	}
+#else
+	const auto device_path = "/dev/" + interface_name;
+	fd = open(device_path.c_str(), O_RDWR | O_NONBLOCK);
+	if (fd == -1) {
+		LOG_WARNING("TAP: Failed opening %s: %s",
+		            device_path.c_str(),
+		            strerror(errno));
+		return false;
+	}
+#endif
+	return true;
+}
+
+bool TapEthernetConnection::Initialize(Section* dosbox_config)
+{
+	const auto section = static_cast<Section_prop*>(dosbox_config);
+	assert(section);
+
+	const std::string interface_name = section->Get_string("tap_interface");
+	if (interface_name.empty()) {
+		LOG_WARNING("TAP: No interface set in 'tap_interface'");
+		return false;
+	}
+	if (!Open(interface_name)) {
+		return false;
+	}
+
+	is_running     = true;
+	network_thread = std::thread(&TapEthernetConnection::Run, this);
+	set_thread_name(network_thread, "dosbox:tap");
+
+	LOG_MSG("TAP: Attached to interface '%s'", interface_name.c_str());
+	return true;
+}
+
+void TapEthernetConnection::SendPacket(const uint8_t* packet, const int len)
+{
+	if (len <= 0 || len > EthernetFrame::MaxSize) {
+		return;
+	}
+	const auto frame = tx_frames.BeginWrite();
+	if (!frame) {
+		LOG_DEBUG("TAP: dropped a sent packet, the queue is full");
+		stats.AddDropped();
+		return;
+	}
+	frame->len = len;
+	memcpy(frame->data.data(), packet, static_cast<size_t>(len));
+	tx_frames.CommitWrite();
+	stats.AddSent(static_cast<uint64_t>(len));
+}
+
+void TapEthernetConnection::GetPackets(
+        std::function<int(const uint8_t*, int)> callback)
+{
+	const auto start_us   = GetTicksUs();
+	const auto num_frames = rx_frames.GetNumReadable();
+	stats.SetQueued(num_frames);
+	for (size_t i = 0; i < num_frames; ++i) {
+		const auto& frame = rx_frames.Peek(i);
+		stats.AddLatency(GetTicksUs() - frame.received_us);
+		callback(frame.data.data(), frame.len);
+	}
+	rx_frames.Consume(num_frames);
+	stats.Tick(GetTicksUsSince(start_us));
+}
+
+void TapEthernetConnection::Run()
+{
+	// Caps how long a frame sent by the guest waits for the poll to end
+	constexpr int MaxPollMs = 1;
+
+	while (is_running) {
+		// Writes go straight out of the ring, as do reads into it
+		const auto num_to_send = tx_frames.GetNumReadable();
+		for (size_t i = 0; i < num_to_send; ++i) {
+			const auto& frame = tx_frames.Peek(i);
+			const auto num_bytes = static_cast<size_t>(frame.len);
+			if (write(fd, frame.data.data(), num_bytes) == -1 &&
+			    errno != EAGAIN) {
+				LOG_DEBUG("TAP: Failed sending a packet: %s",
+				          strerror(errno));
+			}
+		}
+		tx_frames.Consume(num_to_send);
+
+		// Leave the frames waiting in the device until the guest
+		// has made room
+		if (!rx_frames.GetNumWritable()) {
+			std::this_thread::sleep_for(
+			        std::chrono::milliseconds(MaxPollMs));
+			continue;
+		}
+		struct pollfd device = {fd, POLLIN, 0};
+		if (poll(&device, 1, MaxPollMs) <= 0 ||
+		    !(device.revents & POLLIN)) {
+			continue;
+		}
+		while (auto frame = rx_frames.BeginWrite()) {
+			const auto num_read = read(fd,
+			                           frame->data.data(),
+			                           frame->data.size());
+			if (num_read <= 0) {
+				break;
+			}
+			frame->len         = static_cast<int>(num_read);
+			frame->received_us = GetTicksUs();
+			rx_frames.CommitWrite();
+			stats.AddReceived(static_cast<uint64_t>(num_read));
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,83 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_ETHERNET_TAP_H
+#define DOSBOX_ETHERNET_TAP_H
+
+#include "dosbox.h"
+
+#if C_NE2000 && !defined(WIN32)
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "config.h"
+#include "ethernet.h"
+#include "network_stats.h"
+#include "spsc_ring.h"
+
+/** A TAP-based Ethernet connection
+ * This backend exchanges raw Ethernet frames with a TAP interface on the
+ * host, which can be bridged to a real network. Unlike libslirp, every
+ * protocol works over it (IPX, NetBIOS, etc.) and frames aren't processed
+ * on the way.
+ *
+ * The interface has to exist and be up already; on Linux it can be made
+ * with 'ip tuntap add dev tap0 mode tap user <name>', on macOS and the BSDs
+ * the /dev/tapN devices are used.
+ *
+ * Like the slirp backend, a network thread does the reads and writes, and
+ * hands the frames over through lock-free rings.
+ */
+class TapEthernetConnection : public EthernetConnection {
+public:
+	TapEthernetConnection() = default;
+	~TapEthernetConnection() override;
+
+	/* We can't copy this */
+	TapEthernetConnection(const TapEthernetConnection&) = delete;
+	TapEthernetConnection& operator=(const TapEthernetConnection&) = delete;
+
+	bool Initialize(Section* config) override;
+	void SendPacket(const uint8_t* packet, int len) override;
+	void GetPackets(std::function<int(const uint8_t*, int)> callback) override;
+
+private:
+	bool Open(const std::string& interface_name);
+
+	/* The network thread's loop */
+	void Run();
+
+	int fd = -1; /*!< The TAP device */
+
+	static constexpr size_t FrameRingSize = 256;
+	SpscRing<EthernetFrame> rx_frames{FrameRingSize};
+	SpscRing<EthernetFrame> tx_frames{FrameRingSize};
+
+	std::thread network_thread = {};
+	std::atomic<bool> is_running = false;
+
+	NetworkStats stats{"Ethernet (tap)"};
+};
+
+#endif
+
+#endif
@@ -0,0 +1,81 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "event_counters.h"
+
+#include <algorithm>
+#include <cassert>
+
+// Counters are static objects in the modules that count, so the list has to
+// exist before they do
+static std::vector<EventCounter*>& registered_counters()
+{
+	static std::vector<EventCounter*> counters = {};
+	return counters;
+}
+
+EventCounter::EventCounter(const char* _name, const size_t _num_slots,
+                           const char* _slot_format)
+        : name(_name),
+          slot_format(_slot_format),
+          num_slots(_num_slots),
+          slots(std::make_unique<std::atomic<uint64_t>[]>(_num_slots))
+{
+	assert(num_slots > 0);
+	Reset();
+	registered_counters().push_back(this);
+}
+
+EventCounter::~EventCounter()
+{
+	auto& counters = registered_counters();
+
+	const auto it = std::find(counters.begin(), counters.end(), this);
+	assert(it != counters.end());
+	counters.erase(it);
+}
+
+uint64_t EventCounter::GetTotal() const
+{
+	uint64_t total = 0;
+	for (size_t slot = 0; slot < num_slots; ++slot) {
+		total += Get(slot);
+	}
+	return total;
+}
+
+void EventCounter::Reset()
+{
+	for (size_t slot = 0; slot < num_slots; ++slot) {
+		slots[slot].store(0, std::memory_order_relaxed);
+	}
+}
+
+std::vector<EventCounter*> COUNTERS_GetAll()
+{
+	return registered_counters();
+}
+
+void COUNTERS_ResetAll()
+{
+	for (auto counter : registered_counters()) {
+		counter->Reset();
+	}
+}
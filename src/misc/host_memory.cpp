@@ -0,0 +1,164 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "host_memory.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+#if defined(WIN32)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <sys/resource.h>
+#elif defined(__linux__)
+#include <string>
+#include <unistd.h>
+#endif
+
+#include "checks.h"
+#include "dosbox.h"
+
+CHECK_NARROWING();
+
+struct SubsystemUsage {
+	const char* subsystem = nullptr;
+	size_t num_bytes      = 0;
+};
+
+// Subsystems can allocate from other threads (e.g., the Voodoo's memory is
+// only allocated once the card is used)
+static std::mutex usage_mutex = {};
+
+// In the order the subsystems were first recorded
+static std::vector<SubsystemUsage> usages = {};
+
+static SubsystemUsage& find_or_add(const char* subsystem)
+{
+	for (auto& usage : usages) {
+		if (strcmp(usage.subsystem, subsystem) == 0) {
+			return usage;
+		}
+	}
+	return usages.emplace_back(SubsystemUsage{subsystem, 0});
+}
+
+void HOSTMEM_SetUsage(const char* subsystem, const size_t num_bytes)
+{
+	std::lock_guard lock(usage_mutex);
+	find_or_add(subsystem).num_bytes = num_bytes;
+}
+
+void HOSTMEM_AddUsage(const char* subsystem, const ptrdiff_t num_bytes)
+{
+	std::lock_guard lock(usage_mutex);
+	auto& usage = find_or_add(subsystem);
+
+	const auto total = static_cast<ptrdiff_t>(usage.num_bytes) + num_bytes;
+	usage.num_bytes  = static_cast<size_t>(std::max(total, ptrdiff_t{0}));
+}
+
+std::optional<size_t> HOSTMEM_GetResidentBytes()
+{
+#if defined(WIN32)
+	PROCESS_MEMORY_COUNTERS counters = {};
+	if (K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		return counters.WorkingSetSize;
+	}
+#elif defined(__APPLE__)
+	mach_task_basic_info info = {};
+	mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+	if (task_info(mach_task_self(),
+	              MACH_TASK_BASIC_INFO,
+	              reinterpret_cast<task_info_t>(&info),
+	              &count) == KERN_SUCCESS) {
+		return static_cast<size_t>(info.resident_size);
+	}
+#elif defined(__linux__)
+	// The second field is the number of resident pages
+	std::ifstream statm("/proc/self/statm");
+	size_t num_pages = 0;
+	if (statm >> num_pages >> num_pages) {
+		return num_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	}
+#endif
+	return {};
+}
+
+std::optional<size_t> HOSTMEM_GetPeakResidentBytes()
+{
+#if defined(WIN32)
+	PROCESS_MEMORY_COUNTERS counters = {};
+	if (K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		return counters.PeakWorkingSetSize;
+	}
+#elif defined(__APPLE__)
+	// The maximum resident set size is in bytes on macOS
+	rusage usage = {};
+	if (getrusage(RUSAGE_SELF, &usage) == 0) {
+		return static_cast<size_t>(usage.ru_maxrss);
+	}
+#elif defined(__linux__)
+	// The high water mark of the resident set, in kB
+	std::ifstream status("/proc/self/status");
+	std::string field = {};
+	while (status >> field) {
+		if (field == "VmHWM:") {
+			size_t num_kilobytes = 0;
+			if (status >> num_kilobytes) {
+				return num_kilobytes * 1024;
+			}
+			break;
+		}
+	}
+#endif
+	return {};
+}
+
+static double to_megabytes(const size_t num_bytes)
+{
+	constexpr auto BytesPerMegabyte = 1024.0 * 1024.0;
+	return static_cast<double>(num_bytes) / BytesPerMegabyte;
+}
+
+void HOSTMEM_LogUsage()
+{
+	std::lock_guard lock(usage_mutex);
+
+	size_t total_bytes = 0;
+	for (const auto& usage : usages) {
+		if (usage.num_bytes == 0) {
+			continue;
+		}
+		LOG_MSG("HOSTMEM: %-24s %8.2f MB", usage.subsystem, to_megabytes(usage.num_bytes));
+		total_bytes += usage.num_bytes;
+	}
+	LOG_MSG("HOSTMEM: %-24s %8.2f MB", "Total allocated", to_megabytes(total_bytes));
+
+	if (const auto resident_bytes = HOSTMEM_GetResidentBytes(); resident_bytes) {
+		LOG_MSG("HOSTMEM: %-24s %8.2f MB",
+		        "Process resident",
+		        to_megabytes(*resident_bytes));
+	}
+}
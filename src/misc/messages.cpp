@@ -25,12 +25,13 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
-#include <deque>
 #include <map>
 
 #include "std_filesystem.h"
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "ansi_code_markup.h"
 #include "checks.h"
@@ -118,15 +119,44 @@ public:
 	}
 };
 
+// The built-in messages number in the thousands
+constexpr size_t ExpectedNumMessages = 4096;
+
 static std::unordered_map<std::string, Message> messages;
-static std::deque<std::string> messages_order;
+
+// Points to the names held by the map, which stay put when it grows
+static std::vector<const std::string*> messages_order;
+
+// The language file selected by MSG_Init(); it's only read once a message
+// is needed, so runs that never print one don't pay for it
+static std_fs::path pending_message_file = {};
+
+static bool load_message_file(const std_fs::path& filename);
+
+static void load_pending_message_file()
+{
+	if (pending_message_file.empty()) {
+		return;
+	}
+	const auto filename = std::move(pending_message_file);
+	pending_message_file.clear();
+
+	if (!load_message_file(filename)) {
+		LOG_WARNING("LANG: The '%s' language resource file could not be loaded, using internal English messages",
+		            control->GetLanguage().c_str());
+	}
+}
 
 // Add the message if it doesn't exist yet
 void MSG_Add(const char* name, const char* markup_msg)
 {
+	if (messages.empty()) {
+		messages.reserve(ExpectedNumMessages);
+		messages_order.reserve(ExpectedNumMessages);
+	}
 	const auto pair = messages.try_emplace(name, markup_msg);
 	if (pair.second) { // if the insertion was successful
-		messages_order.emplace_back(name);
+		messages_order.push_back(&pair.first->first);
 	} else if ((control->GetLanguage() == "en" || control->GetLanguage().empty()) &&
 	           strcmp(pair.first->second.GetRaw(), markup_msg) != 0) {
 		// Detect duplicates in the English language
@@ -210,6 +240,8 @@ static bool load_message_file(const std_fs::path &filename)
 
 const char* MSG_Get(const char* requested_name)
 {
+	load_pending_message_file();
+
 	const auto it = messages.find(requested_name);
 	if (it != messages.end()) {
 		return it->second.GetRendered();
@@ -220,6 +252,8 @@ const char* MSG_Get(const char* requested_name)
 
 const char* MSG_GetRaw(const char* requested_name)
 {
+	load_pending_message_file();
+
 	const auto it = messages.find(requested_name);
 	if (it != messages.end()) {
 		return it->second.GetRaw();
@@ -230,6 +264,8 @@ const char* MSG_GetRaw(const char* requested_name)
 
 bool MSG_Exists(const char *requested_name)
 {
+	load_pending_message_file();
+
 	return contains(messages, requested_name);
 }
 
@@ -239,8 +275,13 @@ bool MSG_Write(const char * location) {
 	if (!out)
 		return false;
 
-	for (const auto &name : messages_order)
-		fprintf(out, ":%s\n%s\n.\n", name.c_str(), messages.at(name).GetRaw());
+	load_pending_message_file();
+
+	for (const auto name : messages_order)
+		fprintf(out,
+		        ":%s\n%s\n.\n",
+		        name->c_str(),
+		        messages.at(*name).GetRaw());
 
 	fclose(out);
 	return true;
@@ -256,6 +297,8 @@ bool MSG_Write(const char * location) {
 //    filename or path: `-lang ru`. In this case, it constructs a path into the
 //    platform's config path/translations/<lang>[.utf8].lng.
 
+// The file is only read when the first message is requested.
+
 void MSG_Init([[maybe_unused]] Section_prop *section)
 {
 	// TODO: After migration to C++20 try to switch to constexpr
@@ -270,17 +313,9 @@ void MSG_Init([[maybe_unused]] Section_prop *section)
 		return;
 	}
 
-	bool result = false;
 	if (lang.ends_with(".lng"))
-		result = load_message_file(GetResourcePath(subdir, lang));
+		pending_message_file = GetResourcePath(subdir, lang);
 	else
 		// If a short-hand name was provided then add the file extension
-		result = load_message_file(GetResourcePath(subdir, lang + extension));
-
-	if (result)
-		return;
-
-	// If we got here, then the language was not found
-	LOG_WARNING("LANG: The '%s' language resource file could not be loaded, using internal English messages",
-	            lang.c_str());
+		pending_message_file = GetResourcePath(subdir, lang + extension);
 }
@@ -0,0 +1,162 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "network_log.h"
+
+#include <cassert>
+#include <cstring>
+
+#include "dosbox.h"
+#include "mem_host.h"
+#include "pic.h"
+
+constexpr char LogMagic[8]    = {'D', 'B', 'N', 'E', 'T', 'L', 'O', 'G'};
+constexpr uint8_t LogVersion  = 1;
+constexpr size_t HeaderSize   = sizeof(LogMagic) + 2 + 6;
+constexpr size_t RecordHeader = 8 + 1 + 2;
+
+std::unique_ptr<NetworkLogWriter> NetworkLogWriter::Create(
+        const std::string& path, const NetworkLogSource source,
+        const NetworkLogAddress& address)
+{
+	FILE* file = fopen(path.c_str(), "wb");
+	if (!file) {
+		LOG_WARNING("NETWORK: Failed creating the packet log '%s'",
+		            path.c_str());
+		return nullptr;
+	}
+	uint8_t header[HeaderSize];
+	memcpy(header, LogMagic, sizeof(LogMagic));
+	header[8] = LogVersion;
+	header[9] = static_cast<uint8_t>(source);
+	memcpy(header + 10, address.data(), address.size());
+
+	if (fwrite(header, sizeof(header), 1, file) != 1) {
+		LOG_WARNING("NETWORK: Failed writing the packet log '%s'",
+		            path.c_str());
+		fclose(file);
+		return nullptr;
+	}
+	LOG_MSG("NETWORK: Logging packets to '%s'", path.c_str());
+	return std::unique_ptr<NetworkLogWriter>(new NetworkLogWriter(file));
+}
+
+NetworkLogWriter::NetworkLogWriter(FILE* _file)
+        : file(_file),
+          start_ms(PIC_FullIndex())
+{}
+
+NetworkLogWriter::~NetworkLogWriter()
+{
+	fclose(file);
+}
+
+void NetworkLogWriter::Write(const NetworkLogDirection direction,
+                             const uint8_t* data, const int len)
+{
+	assert(len >= 0 && len <= UINT16_MAX);
+
+	const auto elapsed_us = static_cast<uint64_t>(
+	        (PIC_FullIndex() - start_ms) * 1000.0);
+
+	uint8_t header[RecordHeader];
+	host_writeq(header, elapsed_us);
+	host_writeb(header + 8, static_cast<uint8_t>(direction));
+	host_writew(header + 9, static_cast<uint16_t>(len));
+
+	fwrite(header, sizeof(header), 1, file);
+	fwrite(data, static_cast<size_t>(len), 1, file);
+}
+
+std::unique_ptr<NetworkLogReader> NetworkLogReader::Open(const std::string& path,
+                                                         const NetworkLogSource source)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file) {
+		LOG_WARNING("NETWORK: Failed opening the packet log '%s'",
+		            path.c_str());
+		return nullptr;
+	}
+	uint8_t header[HeaderSize];
+	if (fread(header, sizeof(header), 1, file) != 1 ||
+	    memcmp(header, LogMagic, sizeof(LogMagic)) != 0 ||
+	    header[8] != LogVersion || header[9] != static_cast<uint8_t>(source)) {
+		LOG_WARNING("NETWORK: '%s' isn't a packet log of this device",
+		            path.c_str());
+		fclose(file);
+		return nullptr;
+	}
+	NetworkLogAddress address = {};
+	memcpy(address.data(), header + 10, address.size());
+
+	LOG_MSG("NETWORK: Replaying packets from '%s'", path.c_str());
+	return std::unique_ptr<NetworkLogReader>(new NetworkLogReader(file, address));
+}
+
+NetworkLogReader::NetworkLogReader(FILE* _file, const NetworkLogAddress& _address)
+        : file(_file),
+          address(_address),
+          start_ms(PIC_FullIndex())
+{}
+
+NetworkLogReader::~NetworkLogReader()
+{
+	fclose(file);
+}
+
+int64_t NetworkLogReader::GetElapsedUs() const
+{
+	return static_cast<int64_t>((PIC_FullIndex() - start_ms) * 1000.0);
+}
+
+bool NetworkLogReader::ReadNext()
+{
+	uint8_t header[RecordHeader];
+	if (fread(header, sizeof(header), 1, file) != 1) {
+		at_end = true;
+		return false;
+	}
+	next.time_us   = static_cast<int64_t>(host_readq(header));
+	next.direction = static_cast<NetworkLogDirection>(host_readb(header + 8));
+	next.data.resize(host_readw(header + 9));
+	if (!next.data.empty() &&
+	    fread(next.data.data(), next.data.size(), 1, file) != 1) {
+		LOG_WARNING("NETWORK: The packet log ends in the middle of a packet");
+		at_end = true;
+		return false;
+	}
+	return true;
+}
+
+bool NetworkLogReader::NextDue(NetworkLogRecord& record)
+{
+	if (!has_next) {
+		if (at_end || !ReadNext()) {
+			return false;
+		}
+		has_next = true;
+	}
+	if (next.time_us > GetElapsedUs()) {
+		return false;
+	}
+	std::swap(record, next);
+	has_next = false;
+	return true;
+}
@@ -0,0 +1,113 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "network_stats.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "dosbox.h"
+#include "timer.h"
+#include "tracy.h"
+
+// Backends come and go on the emulation thread only; some of them are
+// static, so the list has to exist before they do
+static std::vector<const NetworkStats*>& registered_stats()
+{
+	static std::vector<const NetworkStats*> stats = {};
+	return stats;
+}
+
+NetworkStats::NetworkStats(const std::string& _name)
+        : name(_name),
+          rx_plot_name(_name + " RX bytes/s"),
+          tx_plot_name(_name + " TX bytes/s"),
+          latency_plot_name(_name + " RX latency us")
+{
+	registered_stats().push_back(this);
+	last_rates_ms = GetTicks();
+	TracyPlotConfig(latency_plot_name.c_str(),
+	                tracy::PlotFormatType::Number,
+	                false,
+	                true,
+	                0);
+}
+
+NetworkStats::~NetworkStats()
+{
+	auto& stats = registered_stats();
+
+	const auto it = std::find(stats.begin(), stats.end(), this);
+	assert(it != stats.end());
+	stats.erase(it);
+}
+
+void NetworkStats::SetQueued(const uint64_t num_items)
+{
+	queued     = num_items;
+	max_queued = std::max(max_queued, num_items);
+}
+
+void NetworkStats::AddLatency(const int64_t latency_us)
+{
+	++num_latencies;
+	total_latency_us += latency_us;
+	max_latency_us = std::max(max_latency_us, latency_us);
+
+	TracyPlot(latency_plot_name.c_str(), latency_us);
+}
+
+void NetworkStats::Tick(const int64_t poll_us)
+{
+	++num_polls;
+	total_poll_us += poll_us;
+	max_poll_us = std::max(max_poll_us, poll_us);
+
+	const auto now_ms = GetTicks();
+	const auto elapsed_ms = now_ms - last_rates_ms;
+	if (elapsed_ms < 1000) {
+		return;
+	}
+	const Rates counts = {rx_packets, rx_bytes, tx_packets, tx_bytes};
+
+	const auto per_second = [elapsed_ms](const uint64_t count) {
+		return count * 1000 / static_cast<uint64_t>(elapsed_ms);
+	};
+	rates = {per_second(counts.rx_packets - last_counts.rx_packets),
+	         per_second(counts.rx_bytes - last_counts.rx_bytes),
+	         per_second(counts.tx_packets - last_counts.tx_packets),
+	         per_second(counts.tx_bytes - last_counts.tx_bytes)};
+
+	last_counts   = counts;
+	last_rates_ms = now_ms;
+
+	TracyPlot(rx_plot_name.c_str(), static_cast<int64_t>(rates.rx_bytes));
+	TracyPlot(tx_plot_name.c_str(), static_cast<int64_t>(rates.tx_bytes));
+}
+
+NetworkStats::Rates NetworkStats::GetRates() const
+{
+	return rates;
+}
+
+std::vector<const NetworkStats*> NETSTATS_GetAll()
+{
+	return registered_stats();
+}
@@ -21,7 +21,19 @@
 
 #include "pacer.h"
 
+#include <algorithm>
 #include <cinttypes>
+#include <thread>
+
+#if defined(WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <cerrno>
+#include <ctime>
+#endif
+
+#include "event_counters.h"
+#include "tracy.h"
 
 Pacer::Pacer(const std::string &name, const int timeout, const LogLevel level)
         : pacer_name(name),
@@ -96,3 +108,96 @@ void Pacer::SetTimeout(const int timeout)
 	assert(timeout >= 0);
 	skip_timeout = timeout;
 }
+
+// The spin margin follows the host's sleep overshoot, quickly up and
+// slowly back down, within these bounds
+constexpr int64_t MinSpinMarginUs = 50;
+constexpr int64_t MaxSpinMarginUs = 2000;
+
+static PacingStats pacing_stats = {};
+static int64_t spin_margin_us   = MaxSpinMarginUs / 4;
+
+static EventCounter late_waits("Waits woken over 100 us late");
+
+static void sleep_for_us(const int64_t duration_us)
+{
+#if defined(WIN32)
+#	if !defined(CREATE_WAITABLE_TIMER_HIGH_RESOLUTION)
+#		define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#	endif
+	// High-resolution timers need Windows 10 1803, older versions fall
+	// back to the regular one with the system's timer granularity
+	static HANDLE timer = [] {
+		auto handle = CreateWaitableTimerExW(nullptr,
+		                                     nullptr,
+		                                     CREATE_WAITABLE_TIMER_HIGH_RESOLUTION,
+		                                     TIMER_ALL_ACCESS);
+		if (!handle) {
+			handle = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+		}
+		return handle;
+	}();
+	if (timer) {
+		// Relative due times are negative, in 100 ns units
+		LARGE_INTEGER due_time = {};
+		due_time.QuadPart      = -duration_us * 10;
+		if (SetWaitableTimer(timer, &due_time, 0, nullptr, nullptr, FALSE)) {
+			WaitForSingleObject(timer, INFINITE);
+			return;
+		}
+	}
+	Sleep(static_cast<DWORD>((duration_us + 999) / 1000));
+
+#elif defined(__linux__)
+	timespec duration = {};
+	duration.tv_sec   = static_cast<time_t>(duration_us / 1'000'000);
+	duration.tv_nsec  = static_cast<long>((duration_us % 1'000'000) * 1000);
+	// Continue after signals with the time that was left
+	while (clock_nanosleep(CLOCK_MONOTONIC, 0, &duration, &duration) == EINTR) {
+	}
+#else
+	std::this_thread::sleep_for(std::chrono::microseconds(duration_us));
+#endif
+}
+
+void PACER_WaitUntilUs(const int64_t deadline_us)
+{
+	ZoneScoped;
+
+	const auto now_us = GetTicksUs();
+	if (deadline_us - now_us > spin_margin_us) {
+		const auto wake_us = deadline_us - spin_margin_us;
+		sleep_for_us(wake_us - now_us);
+
+		const auto overshoot_us = GetTicksUsSince(wake_us);
+		spin_margin_us = overshoot_us > spin_margin_us
+		                       ? overshoot_us
+		                       : spin_margin_us - (spin_margin_us - overshoot_us) / 16;
+		spin_margin_us = std::clamp(spin_margin_us, MinSpinMarginUs, MaxSpinMarginUs);
+	}
+
+	while (GetTicksUs() < deadline_us) {
+		std::this_thread::yield();
+	}
+
+	const auto error_us = GetTicksUsSince(deadline_us);
+	++pacing_stats.num_waits;
+	pacing_stats.total_error_us += error_us;
+	pacing_stats.max_error_us = std::max(pacing_stats.max_error_us, error_us);
+	pacing_stats.spin_margin_us = spin_margin_us;
+
+	if (error_us > 100) {
+		late_waits.Add();
+	}
+	TracyPlot("Pacing error (us)", error_us);
+}
+
+PacingStats PACER_GetPacingStats()
+{
+	return pacing_stats;
+}
+
+void PACER_ResetPacingStats()
+{
+	pacing_stats = {};
+}
@@ -33,9 +33,16 @@ RWQueue<T>::RWQueue(size_t queue_capacity)
 template <typename T>
 void RWQueue<T>::Resize(size_t queue_capacity)
 {
-	std::lock_guard<std::mutex> lock(mutex);
-	capacity = queue_capacity;
+	std::unique_lock<std::mutex> lock(mutex);
+	const auto has_grown = queue_capacity > capacity;
+	capacity             = queue_capacity;
 	assert(capacity > 0);
+
+	// Writers waiting for room might fit now
+	if (has_grown) {
+		lock.unlock();
+		has_room.notify_all();
+	}
 }
 
 template <typename T>
@@ -145,8 +152,9 @@ bool RWQueue<T>::BulkEnqueue(std::vector<T>& from_source, const size_t num_reque
 	while (num_remaining > 0) {
 		std::unique_lock<std::mutex> lock(mutex);
 
-		const auto free_capacity = static_cast<size_t>(capacity -
-		                                               queue.size());
+		// The queue can hold more than its capacity after shrinking
+		const auto free_capacity = static_cast<size_t>(
+		        capacity > queue.size() ? capacity - queue.size() : 0);
 
 		const auto num_items = std::max(min_items,
 		                                std::min(num_remaining,
@@ -155,7 +163,8 @@ bool RWQueue<T>::BulkEnqueue(std::vector<T>& from_source, const size_t num_reque
 		// wait until we're stopped or the queue has enough room for the
 		// items
 		has_room.wait(lock, [&] {
-			return !is_running || capacity - queue.size() >= num_items;
+			return !is_running || (capacity > queue.size() &&
+			                       capacity - queue.size() >= num_items);
 		});
 
 		if (is_running) {
@@ -271,3 +280,12 @@ template class RWQueue<MidiWork>;
 
 #include "render.h"
 template class RWQueue<SaveImageTask>;
+
+#include "../capture/capture_video.h"
+template class RWQueue<VideoFrameTask>;
+
+// Capture file writer
+template class RWQueue<std::vector<uint8_t>>;
+
+// CD-DA decode-ahead
+template class RWQueue<int16_t>;
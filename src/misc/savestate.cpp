@@ -0,0 +1,328 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "savestate.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <memory>
+
+#include <zlib.h>
+
+#include "dosbox.h"
+#include "mapper.h"
+
+// Snapshots build on the one before up to this many times, then a full one
+// starts the next chain, so loads don't have to replay too many
+constexpr int MaxChainLength = 16;
+constexpr int NumSlots       = 8;
+
+constexpr uint32_t EndOfPages = UINT32_MAX;
+
+void SaveStateWriter::Write(const void* data, const size_t num_bytes)
+{
+	const auto bytes = static_cast<const uint8_t*>(data);
+	out.insert(out.end(), bytes, bytes + num_bytes);
+}
+
+void SaveStateReader::Read(void* data, const size_t num_bytes)
+{
+	if (has_failed || num_bytes > in.size() - pos) {
+		has_failed = true;
+		return;
+	}
+	memcpy(data, in.data() + pos, num_bytes);
+	pos += num_bytes;
+}
+
+void SaveStatePages::Save(SaveStateWriter& writer, const uint8_t* area,
+                          const size_t size)
+{
+	writer.Write(static_cast<uint64_t>(size));
+
+	const bool is_full = writer.IsFull() || reference.size() != size;
+	if (reference.size() != size) {
+		reference.resize(size);
+	}
+	for (size_t offset = 0; offset < size; offset += PageSize) {
+		const auto num_bytes = std::min(PageSize, size - offset);
+		if (!is_full && memcmp(area + offset, reference.data() + offset, num_bytes) == 0) {
+			continue;
+		}
+		memcpy(reference.data() + offset, area + offset, num_bytes);
+		writer.Write(static_cast<uint32_t>(offset / PageSize));
+		writer.Write(area + offset, num_bytes);
+	}
+	writer.Write(EndOfPages);
+}
+
+void SaveStatePages::Load(SaveStateReader& reader, uint8_t* area, const size_t size)
+{
+	uint64_t saved_size = 0;
+	reader.Read(saved_size);
+	if (saved_size != size) {
+		LOG_WARNING("SAVESTATE: Skipping a memory area that changed size");
+		return;
+	}
+	const bool has_reference = reference.size() == size;
+
+	uint32_t page = 0;
+	reader.Read(page);
+	while (!reader.HasFailed() && page != EndOfPages) {
+		const auto offset = static_cast<size_t>(page) * PageSize;
+		if (offset >= size) {
+			LOG_WARNING("SAVESTATE: Skipping a page outside of the memory area");
+			return;
+		}
+		const auto num_bytes = std::min(PageSize, size - offset);
+		reader.Read(area + offset, num_bytes);
+		if (has_reference) {
+			memcpy(reference.data() + offset, area + offset, num_bytes);
+		}
+		reader.Read(page);
+	}
+	if (!has_reference) {
+		reference.assign(area, area + size);
+	}
+}
+
+struct SaveStateComponent {
+	std::string name            = {};
+	SaveStateSaveFunction save  = {};
+	SaveStateLoadFunction load  = {};
+};
+
+static std::vector<SaveStateComponent> components = {};
+
+void SAVESTATE_AddComponent(const std::string& name,
+                            SaveStateSaveFunction save, SaveStateLoadFunction load)
+{
+	for (auto& component : components) {
+		if (component.name == name) {
+			component.save = std::move(save);
+			component.load = std::move(load);
+			return;
+		}
+	}
+	components.push_back({name, std::move(save), std::move(load)});
+}
+
+void SAVESTATE_RemoveComponent(const std::string& name)
+{
+	std::erase_if(components, [&](const SaveStateComponent& component) {
+		return component.name == name;
+	});
+}
+
+struct Snapshot {
+	struct Part {
+		std::string name          = {};
+		size_t raw_size           = 0;
+		std::vector<uint8_t> data = {};
+	};
+
+	std::shared_ptr<const Snapshot> parent = {};
+	int chain_length                       = 1;
+	int run_depth                          = 0;
+	std::vector<Part> parts                = {};
+};
+
+static std::shared_ptr<const Snapshot> slots[NumSlots] = {};
+static int current_slot = 0;
+
+// The snapshot the machine was last saved to or loaded from, which the
+// next one builds on
+static std::shared_ptr<const Snapshot> last_snapshot = {};
+static bool needs_full_snapshot = false;
+
+static std::vector<uint8_t> compress_part(const std::vector<uint8_t>& raw)
+{
+	auto size = compressBound(static_cast<uLong>(raw.size()));
+	std::vector<uint8_t> data(size);
+	if (compress2(data.data(), &size, raw.data(),
+	              static_cast<uLong>(raw.size()), Z_BEST_SPEED) != Z_OK) {
+		return {};
+	}
+	data.resize(size);
+	data.shrink_to_fit();
+	return data;
+}
+
+static bool decompress_part(const Snapshot::Part& part, std::vector<uint8_t>& raw)
+{
+	raw.resize(part.raw_size);
+	auto size = static_cast<uLong>(raw.size());
+	return uncompress(raw.data(), &size, part.data.data(),
+	                  static_cast<uLong>(part.data.size())) == Z_OK &&
+	       size == raw.size();
+}
+
+static void save_snapshot(const int slot, const int run_depth)
+{
+	auto snapshot = std::make_shared<Snapshot>();
+
+	const bool is_full = !last_snapshot || needs_full_snapshot ||
+	                     last_snapshot->chain_length >= MaxChainLength ||
+	                     last_snapshot->run_depth != run_depth;
+	if (!is_full) {
+		snapshot->parent       = last_snapshot;
+		snapshot->chain_length = last_snapshot->chain_length + 1;
+	}
+	snapshot->run_depth = run_depth;
+
+	size_t raw_size        = 0;
+	size_t compressed_size = 0;
+
+	std::vector<uint8_t> raw = {};
+	for (const auto& component : components) {
+		raw.clear();
+		SaveStateWriter writer(raw, is_full);
+		component.save(writer);
+
+		Snapshot::Part part = {component.name, raw.size(), compress_part(raw)};
+		if (part.data.empty()) {
+			LOG_WARNING("SAVESTATE: Failed compressing the %s state",
+			            component.name.c_str());
+			return;
+		}
+		raw_size += part.raw_size;
+		compressed_size += part.data.size();
+		snapshot->parts.push_back(std::move(part));
+	}
+
+	slots[slot]         = snapshot;
+	last_snapshot       = std::move(snapshot);
+	needs_full_snapshot = false;
+
+	LOG_MSG("SAVESTATE: Saved slot %d (%s, %zu KB compressed from %zu KB)",
+	        slot + 1,
+	        is_full ? "full" : "incremental",
+	        compressed_size / 1024,
+	        raw_size / 1024);
+}
+
+static void load_snapshot(const int slot, const int run_depth)
+{
+	const auto& snapshot = slots[slot];
+	if (!snapshot) {
+		LOG_MSG("SAVESTATE: Slot %d is empty", slot + 1);
+		return;
+	}
+	if (snapshot->run_depth != run_depth) {
+		LOG_WARNING("SAVESTATE: Slot %d was saved while another program was running, it can't be loaded now",
+		            slot + 1);
+		return;
+	}
+
+	std::vector<const Snapshot*> chain = {};
+	for (auto s = snapshot.get(); s; s = s->parent.get()) {
+		chain.push_back(s);
+	}
+	std::reverse(chain.begin(), chain.end());
+
+	std::vector<uint8_t> raw = {};
+	for (const auto s : chain) {
+		for (const auto& part : s->parts) {
+			const auto component = std::find_if(
+			        components.begin(),
+			        components.end(),
+			        [&](const SaveStateComponent& c) {
+				        return c.name == part.name;
+			        });
+			if (component == components.end()) {
+				continue;
+			}
+			if (!decompress_part(part, raw)) {
+				LOG_WARNING("SAVESTATE: Failed decompressing the %s state",
+				            part.name.c_str());
+				continue;
+			}
+			SaveStateReader reader(raw);
+			component->load(reader);
+			if (reader.HasFailed()) {
+				LOG_WARNING("SAVESTATE: The %s state ended early",
+				            part.name.c_str());
+			}
+		}
+	}
+
+	// Components the snapshot doesn't know about kept their state, so
+	// a delta against it would miss their changes
+	needs_full_snapshot = std::any_of(
+	        components.begin(), components.end(), [&](const SaveStateComponent& c) {
+		        return std::none_of(snapshot->parts.begin(),
+		                            snapshot->parts.end(),
+		                            [&](const Snapshot::Part& part) {
+			                            return part.name == c.name;
+		                            });
+	        });
+	last_snapshot = snapshot;
+
+	LOG_MSG("SAVESTATE: Loaded slot %d", slot + 1);
+}
+
+enum class SaveStateRequest { None, Save, Load };
+
+static SaveStateRequest pending_request = SaveStateRequest::None;
+
+void SAVESTATE_RunPending(const int run_depth)
+{
+	const auto request = pending_request;
+	pending_request    = SaveStateRequest::None;
+
+	switch (request) {
+	case SaveStateRequest::Save: save_snapshot(current_slot, run_depth); break;
+	case SaveStateRequest::Load: load_snapshot(current_slot, run_depth); break;
+	case SaveStateRequest::None: break;
+	}
+}
+
+static void request_save(const bool pressed)
+{
+	if (pressed) {
+		pending_request = SaveStateRequest::Save;
+	}
+}
+
+static void request_load(const bool pressed)
+{
+	if (pressed) {
+		pending_request = SaveStateRequest::Load;
+	}
+}
+
+static void select_next_slot(const bool pressed)
+{
+	if (!pressed) {
+		return;
+	}
+	current_slot = (current_slot + 1) % NumSlots;
+	LOG_MSG("SAVESTATE: Selected slot %d%s",
+	        current_slot + 1,
+	        slots[current_slot] ? "" : " (empty)");
+}
+
+void SAVESTATE_AddMapperHandlers()
+{
+	MAPPER_AddHandler(request_save, SDL_SCANCODE_F5, MMOD2, "savestate", "Save State");
+	MAPPER_AddHandler(request_load, SDL_SCANCODE_F9, MMOD2, "loadstate", "Load State");
+	MAPPER_AddHandler(select_next_slot, SDL_SCANCODE_F6, MMOD2, "nextslot", "Next Slot");
+}
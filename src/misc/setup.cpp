@@ -1919,6 +1919,8 @@ void Config::ParseArguments()
 	arguments.machine = cmdline->FindRemoveStringArgument("machine");
 
 	arguments.socket = cmdline->FindRemoveIntArgument("socket");
+	arguments.benchmark_report = cmdline->FindRemoveStringArgument("benchmark-report");
+	arguments.benchmark = cmdline->FindRemoveIntArgument("benchmark");
 
 	arguments.conf = cmdline->FindRemoveVectorArgument("conf");
 	arguments.set  = cmdline->FindRemoveVectorArgument("set");
@@ -0,0 +1,355 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "thread_placement.h"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#if defined(WIN32)
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#elif defined(__linux__)
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "checks.h"
+#include "dosbox.h"
+#include "string_utils.h"
+
+CHECK_NARROWING();
+
+constexpr auto NumRoles = static_cast<size_t>(ThreadRole::Worker) + 1;
+
+// The logical CPUs each role may run on, none meaning any of them
+static std::array<std::vector<int>, NumRoles> role_cpus = {};
+
+// Threads inherit the CPUs of the thread starting them, so the roles
+// without CPUs of their own are moved back to all of them
+static std::vector<int> all_cpus = {};
+
+static bool adjust_priorities = false;
+
+static std::vector<int>& cpus_of(const ThreadRole role)
+{
+	// The audio device's callback runs next to our own audio renderers
+	const auto cpus_role = role == ThreadRole::AudioDevice ? ThreadRole::Audio
+	                                                       : role;
+	return role_cpus[static_cast<size_t>(cpus_role)];
+}
+
+static std::string to_string(const std::vector<int>& cpus)
+{
+	std::string str = {};
+	for (const auto cpu : cpus) {
+		if (!str.empty()) {
+			str += ',';
+		}
+		str += std::to_string(cpu);
+	}
+	return str;
+}
+
+// Parses lists like "0-3,6" as used by Linux' sysfs and taskset
+static std::optional<std::vector<int>> parse_cpu_list(const std::string& list)
+{
+	std::vector<int> cpus = {};
+	for (const auto& range : split(list, ",")) {
+		const auto bounds = split_with_empties(range, '-');
+		if (bounds.size() > 2) {
+			return {};
+		}
+		const auto first = parse_int(bounds.front());
+		const auto last  = parse_int(bounds.back());
+		if (!first || !last || *first < 0 || *last < *first) {
+			return {};
+		}
+		for (auto cpu = *first; cpu <= *last; ++cpu) {
+			cpus.push_back(cpu);
+		}
+	}
+	if (cpus.empty()) {
+		return {};
+	}
+	return cpus;
+}
+
+// Returns the fastest cores of hybrid CPUs (e.g., the performance cores of
+// Intel's Alder Lake and later, or the big cores of Arm big.LITTLE
+// designs), or nothing if all cores are alike or it can't be told
+static std::vector<int> find_performance_cores()
+{
+	const auto num_cpus = static_cast<int>(std::thread::hardware_concurrency());
+
+#if defined(WIN32) && _WIN32_WINNT >= 0x0A00
+	// CPU sets need Windows 10
+	ULONG size = 0;
+	GetSystemCpuSetInformation(nullptr, 0, &size, GetCurrentProcess(), 0);
+	std::vector<uint8_t> buffer(size);
+	auto info = reinterpret_cast<SYSTEM_CPU_SET_INFORMATION*>(buffer.data());
+	if (size == 0 ||
+	    !GetSystemCpuSetInformation(info, size, &size, GetCurrentProcess(), 0)) {
+		return {};
+	}
+
+	// Windows rates the cores of hybrid CPUs by their efficiency class,
+	// where a higher class means more performance
+	std::vector<std::pair<int, int>> classes = {};
+	for (ULONG offset = 0; offset < size;) {
+		const auto entry = reinterpret_cast<SYSTEM_CPU_SET_INFORMATION*>(
+		        buffer.data() + offset);
+		if (entry->Type == CpuSetInformation && entry->CpuSet.Group == 0) {
+			classes.emplace_back(entry->CpuSet.LogicalProcessorIndex,
+			                     entry->CpuSet.EfficiencyClass);
+		}
+		offset += entry->Size;
+	}
+#elif defined(__linux__)
+	// Intel's hybrid CPUs list their performance cores as a separate PMU
+	std::ifstream core_pmu("/sys/devices/cpu_core/cpus");
+	if (std::string list = {}; core_pmu >> list) {
+		const auto cpus = parse_cpu_list(list);
+		return cpus && static_cast<int>(cpus->size()) < num_cpus
+		             ? *cpus
+		             : std::vector<int>{};
+	}
+
+	// Arm's describe the relative capacity of each core
+	std::vector<std::pair<int, int>> classes = {};
+	for (auto cpu = 0; cpu < num_cpus; ++cpu) {
+		std::ifstream file("/sys/devices/system/cpu/cpu" +
+		                   std::to_string(cpu) + "/cpu_capacity");
+		int capacity = 0;
+		if (!(file >> capacity)) {
+			return {};
+		}
+		classes.emplace_back(cpu, capacity);
+	}
+#else
+	(void)num_cpus;
+	std::vector<std::pair<int, int>> classes = {};
+#endif
+
+	if (classes.empty()) {
+		return {};
+	}
+	const auto [min_class, max_class] = std::minmax_element(
+	        classes.begin(), classes.end(), [](const auto& a, const auto& b) {
+		        return a.second < b.second;
+	        });
+	if (min_class->second == max_class->second) {
+		return {};
+	}
+	std::vector<int> cpus = {};
+	for (const auto& [cpu, cpu_class] : classes) {
+		if (cpu_class == max_class->second) {
+			cpus.push_back(cpu);
+		}
+	}
+	return cpus;
+}
+
+static std::optional<ThreadRole> to_role(const std::string& name)
+{
+	if (name == "emulation") {
+		return ThreadRole::Emulation;
+	} else if (name == "audio") {
+		return ThreadRole::Audio;
+	} else if (name == "video") {
+		return ThreadRole::Video;
+	} else if (name == "workers") {
+		return ThreadRole::Worker;
+	}
+	return {};
+}
+
+static void set_all_cpus_if_restricted()
+{
+	const auto is_restricted = std::any_of(role_cpus.begin(),
+	                                       role_cpus.end(),
+	                                       [](const auto& cpus) {
+		                                       return !cpus.empty();
+	                                       });
+	if (!is_restricted) {
+		return;
+	}
+	const auto num_cpus = static_cast<int>(std::thread::hardware_concurrency());
+	for (auto cpu = 0; cpu < num_cpus; ++cpu) {
+		all_cpus.push_back(cpu);
+	}
+}
+
+void THREAD_SetPlacementPolicy(const std::string& affinity_pref,
+                               const bool _adjust_priorities)
+{
+	adjust_priorities = _adjust_priorities;
+	for (auto& cpus : role_cpus) {
+		cpus.clear();
+	}
+	all_cpus.clear();
+
+	if (affinity_pref == "off") {
+		return;
+	}
+
+	// Keep the threads the frame and audio timing depends on off the
+	// efficiency cores; the others can use any core
+	if (affinity_pref == "auto") {
+		const auto performance_cores = find_performance_cores();
+		if (performance_cores.empty()) {
+			return;
+		}
+		cpus_of(ThreadRole::Emulation) = performance_cores;
+		cpus_of(ThreadRole::Audio)     = performance_cores;
+		set_all_cpus_if_restricted();
+
+		LOG_MSG("THREADS: Running the emulation and audio threads on the "
+		        "performance cores (CPUs %s)",
+		        to_string(performance_cores).c_str());
+		return;
+	}
+
+	for (const auto& assignment : split(affinity_pref)) {
+		const auto parts = split_with_empties(assignment, ':');
+		const auto role  = parts.size() == 2 ? to_role(parts[0])
+		                                     : std::nullopt;
+		const auto cpus  = role ? parse_cpu_list(parts[1]) : std::nullopt;
+		if (!cpus) {
+			LOG_WARNING("THREADS: Invalid 'thread_affinity' entry '%s', ignoring it",
+			            assignment.c_str());
+			continue;
+		}
+		cpus_of(*role) = *cpus;
+	}
+	set_all_cpus_if_restricted();
+}
+
+static void set_affinity(const std::vector<int>& cpus)
+{
+	if (cpus.empty()) {
+		return;
+	}
+#if defined(WIN32)
+	DWORD_PTR mask = 0;
+	for (const auto cpu : cpus) {
+		if (cpu < static_cast<int>(sizeof(mask) * 8)) {
+			mask |= DWORD_PTR{1} << cpu;
+		}
+	}
+	if (!mask || !SetThreadAffinityMask(GetCurrentThread(), mask)) {
+		LOG_WARNING("THREADS: Failed to restrict a thread to CPUs %s",
+		            to_string(cpus).c_str());
+	}
+#elif defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (const auto cpu : cpus) {
+		if (cpu < CPU_SETSIZE) {
+			CPU_SET(cpu, &set);
+		}
+	}
+	if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+		LOG_WARNING("THREADS: Failed to restrict a thread to CPUs %s",
+		            to_string(cpus).c_str());
+	}
+#else
+	// macOS only takes affinity hints between threads, not CPUs
+	static bool has_warned = false;
+	if (!has_warned) {
+		LOG_WARNING("THREADS: Thread affinity is not supported on this host");
+		has_warned = true;
+	}
+#endif
+}
+
+static void set_priority(const ThreadRole role)
+{
+#if defined(WIN32)
+	// Opt out of being throttled on the efficiency cores (EcoQoS), which
+	// Windows otherwise does to threads of unfocused windows
+	auto opt_out_of_throttling = []() {
+#if defined(THREAD_POWER_THROTTLING_CURRENT_VERSION)
+		THREAD_POWER_THROTTLING_STATE state = {};
+		state.Version     = THREAD_POWER_THROTTLING_CURRENT_VERSION;
+		state.ControlMask = THREAD_POWER_THROTTLING_EXECUTION_SPEED;
+		state.StateMask   = 0;
+		SetThreadInformation(GetCurrentThread(),
+		                     ThreadPowerThrottling,
+		                     &state,
+		                     sizeof(state));
+#endif
+	};
+	switch (role) {
+	case ThreadRole::Emulation:
+		opt_out_of_throttling();
+		SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_ABOVE_NORMAL);
+		break;
+	case ThreadRole::Audio:
+		opt_out_of_throttling();
+		SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
+		break;
+	case ThreadRole::AudioDevice: opt_out_of_throttling(); break;
+	case ThreadRole::Video:
+		SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+		break;
+	case ThreadRole::Worker: break;
+	}
+#elif defined(__APPLE__)
+	switch (role) {
+	case ThreadRole::Emulation:
+	case ThreadRole::Audio:
+		pthread_set_qos_class_self_np(QOS_CLASS_USER_INTERACTIVE, 0);
+		break;
+	case ThreadRole::AudioDevice: break;
+	case ThreadRole::Video:
+		pthread_set_qos_class_self_np(QOS_CLASS_UTILITY, 0);
+		break;
+	case ThreadRole::Worker:
+		pthread_set_qos_class_self_np(QOS_CLASS_USER_INITIATED, 0);
+		break;
+	}
+#elif defined(__linux__)
+	// Raising a thread's priority takes privileges we don't have, but the
+	// video encoder can make way for the others
+	if (role == ThreadRole::Video) {
+		const auto tid = static_cast<id_t>(syscall(SYS_gettid));
+		setpriority(PRIO_PROCESS, tid, getpriority(PRIO_PROCESS, tid) + 5);
+	}
+#else
+	(void)role;
+#endif
+}
+
+void THREAD_ApplyRole(const ThreadRole role)
+{
+	const auto& cpus = cpus_of(role);
+	set_affinity(cpus.empty() ? all_cpus : cpus);
+	if (adjust_priorities) {
+		set_priority(role);
+	}
+}
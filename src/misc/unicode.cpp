@@ -636,8 +636,6 @@ static void wide_to_utf8(const std::vector<uint16_t>& str_in, std::string& str_o
 			push(to_byte_3 | 0b1'000'0000);
 		}
 	}
-
-	str_out.shrink_to_fit();
 }
 
 static void warn_code_point(const uint16_t code_point)
@@ -839,7 +837,6 @@ static bool wide_to_dos(const std::vector<uint16_t>& str_in, std::string& str_ou
 		push_unknown(original_code_point);
 	}
 
-	str_out.shrink_to_fit();
 	return status;
 }
 
@@ -2004,13 +2001,39 @@ uint16_t get_utf8_code_page()
 	return 0;
 }
 
+// Most strings passing through here (file names, console output, messages)
+// are plain 7-bit ASCII, which every conversion maps onto itself
+static bool is_7bit_ascii(const std::string& str)
+{
+	return std::all_of(str.begin(), str.end(), [](const char character) {
+		return static_cast<uint8_t>(character) < decode_threshold_non_ascii;
+	});
+}
+
+static bool is_printable_ascii(const std::string& str)
+{
+	return std::all_of(str.begin(), str.end(), [](const char character) {
+		const auto byte = static_cast<uint8_t>(character);
+		return byte >= 0x20 && byte < 0x7f;
+	});
+}
+
+// Scratch buffer shared by the conversions below; reusing it avoids a heap
+// allocation per converted string
+static std::vector<uint16_t> wide_scratch = {};
+
 static bool utf8_to_dos_common(const std::string& in_str, std::string& out_str,
                                const UnicodeFallback fallback,
                                const uint16_t code_page)
 {
+	if (is_7bit_ascii(in_str)) {
+		out_str = in_str;
+		return true;
+	}
+
 	load_config_if_needed();
 
-	std::vector<uint16_t> tmp = {};
+	auto& tmp = wide_scratch;
 
 	const bool status1 = utf8_to_wide(in_str, tmp);
 	const bool status2 = wide_to_dos(tmp, out_str, fallback, code_page);
@@ -2035,9 +2058,16 @@ bool utf8_to_dos(const std::string& in_str, std::string& out_str,
 static void dos_to_utf8_common(const std::string& in_str, std::string& out_str,
                                const uint16_t code_page)
 {
+	// Control codes and 0x7f are rendered as screen glyphs, so only
+	// printable ASCII is passed through unchanged
+	if (is_printable_ascii(in_str)) {
+		out_str = in_str;
+		return;
+	}
+
 	load_config_if_needed();
 
-	std::vector<uint16_t> tmp = {};
+	auto& tmp = wide_scratch;
 
 	dos_to_wide(in_str, tmp, code_page);
 	wide_to_utf8(tmp, out_str);
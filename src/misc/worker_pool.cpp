@@ -0,0 +1,123 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "worker_pool.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "support.h"
+#include "thread_placement.h"
+
+static int get_num_host_threads()
+{
+	return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+WorkerPool::WorkerPool(const int _max_threads)
+{
+	SetMaxThreads(_max_threads);
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard lock(mutex);
+		is_stopping = true;
+	}
+	has_tasks.notify_all();
+
+	for (auto& thread : threads) {
+		if (thread.joinable()) {
+			thread.join();
+		}
+	}
+}
+
+void WorkerPool::SetMaxThreads(const int _max_threads)
+{
+	assert(_max_threads >= 0);
+
+	std::lock_guard lock(mutex);
+	max_threads = _max_threads > 0 ? _max_threads : get_num_host_threads();
+}
+
+int WorkerPool::GetMaxThreads() const
+{
+	std::lock_guard lock(mutex);
+	return max_threads;
+}
+
+void WorkerPool::Submit(const WorkerPriority priority, Task task)
+{
+	assert(task);
+	{
+		std::lock_guard lock(mutex);
+		queues[static_cast<size_t>(priority)].emplace_back(std::move(task));
+		++num_queued;
+
+		// Only start another thread when the idle ones already have a
+		// task each to pick up
+		if (num_queued > idle_threads &&
+		    static_cast<int>(threads.size()) < max_threads) {
+			threads.emplace_back(&WorkerPool::Run, this);
+			set_thread_name(threads.back(), "dosbox:worker");
+			return;
+		}
+	}
+	has_tasks.notify_one();
+}
+
+void WorkerPool::Run()
+{
+	THREAD_ApplyRole(ThreadRole::Worker);
+
+	std::unique_lock lock(mutex);
+	while (true) {
+		const auto queue = std::find_if(queues.begin(),
+		                                queues.end(),
+		                                [](const auto& q) {
+			                                return !q.empty();
+		                                });
+		if (queue == queues.end()) {
+			if (is_stopping) {
+				return;
+			}
+			++idle_threads;
+			has_tasks.wait(lock);
+			--idle_threads;
+			continue;
+		}
+
+		auto task = std::move(queue->front());
+		queue->pop_front();
+		--num_queued;
+
+		lock.unlock();
+		task();
+		lock.lock();
+	}
+}
+
+WorkerPool& WORKERS_GetPool()
+{
+	static WorkerPool pool;
+	return pool;
+}
@@ -36,34 +36,63 @@ FileReader::FileReader(std::string filename)
           cursor(0)
 {}
 
-std::optional<std::string> FileReader::Read()
+bool FileReader::Refresh()
 {
 	uint16_t entry = {};
 	if (!DOS_OpenFile(filename.c_str(), (DOS_NOT_INHERIT | OPEN_READ), &entry)) {
-		return {};
+		return false;
 	}
-	DOS_SeekFile(entry, &cursor, DOS_SEEK_SET);
 
-	uint8_t data           = 0;
-	uint16_t bytes_to_read = 1;
-	std::string line       = {};
+	// Batch files can be changed while they run, even by themselves, so
+	// each line has to come from the file as it is now
+	uint16_t time = 0;
+	uint16_t date = 0;
+	DOS_GetFileDate(entry, &time, &date);
+
+	uint32_t size = 0;
+	DOS_SeekFile(entry, &size, DOS_SEEK_END);
+
+	if (!is_loaded || time != file_time || date != file_date ||
+	    size != contents.size()) {
+		contents.clear();
+
+		uint32_t pos = 0;
+		DOS_SeekFile(entry, &pos, DOS_SEEK_SET);
 
-	while (data != '\n') {
-		bool result = DOS_ReadFile(entry, &data, &bytes_to_read);
-		if (!result || bytes_to_read == 0) {
-			break;
+		uint8_t data[4096];
+		while (contents.size() < size) {
+			uint16_t bytes_read = sizeof(data);
+			if (!DOS_ReadFile(entry, data, &bytes_read) ||
+			    bytes_read == 0) {
+				break;
+			}
+			contents.append(reinterpret_cast<char*>(data),
+			                bytes_read);
 		}
-		line += static_cast<char>(data);
+
+		is_loaded = true;
+		file_time = time;
+		file_date = date;
+		++revision;
 	}
 
-	cursor = 0;
-	DOS_SeekFile(entry, &cursor, DOS_SEEK_CUR);
 	DOS_CloseFile(entry);
+	return true;
+}
 
-	if (line.empty()) {
+std::optional<std::string> FileReader::Read()
+{
+	if (!Refresh() || cursor >= contents.size()) {
 		return {};
 	}
 
+	const auto line_end = contents.find('\n', cursor);
+	const auto next_line = (line_end == std::string::npos)
+	                             ? contents.size()
+	                             : line_end + 1;
+
+	auto line = contents.substr(cursor, next_line - cursor);
+	cursor    = static_cast<uint32_t>(next_line);
 	return line;
 }
 
@@ -71,3 +100,19 @@ void FileReader::Reset()
 {
 	cursor = 0;
 }
+
+uint32_t FileReader::GetPosition() const
+{
+	return cursor;
+}
+
+void FileReader::SetPosition(const uint32_t position)
+{
+	cursor = position;
+}
+
+uint32_t FileReader::GetRevision()
+{
+	Refresh();
+	return revision;
+}
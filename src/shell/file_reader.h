@@ -33,6 +33,10 @@ public:
 	void Reset() final;
 	std::optional<std::string> Read() final;
 
+	uint32_t GetPosition() const final;
+	void SetPosition(uint32_t position) final;
+	uint32_t GetRevision() final;
+
 	FileReader(const FileReader&)            = delete;
 	FileReader& operator=(const FileReader&) = delete;
 	FileReader(FileReader&&)                 = default;
@@ -42,8 +46,19 @@ public:
 private:
 	explicit FileReader(std::string filename);
 
+	// Reads the file again if its size or modification time changed;
+	// false if it can't be opened anymore
+	bool Refresh();
+
 	std::string filename;
 	uint32_t cursor;
+
+	// The whole file, as it was when it was last read
+	std::string contents = {};
+	bool is_loaded       = false;
+	uint16_t file_date   = 0;
+	uint16_t file_time   = 0;
+	uint32_t revision    = 0;
 };
 
 #endif
@@ -20,11 +20,13 @@
 
 #include <algorithm>
 #include <cstring>
+#include <vector>
 
 #include "logging.h"
 #include "string_utils.h"
 
-[[nodiscard]] static bool found_label(std::string_view line, std::string_view label);
+[[nodiscard]] static std::vector<std::string> label_names(
+        std::string_view line);
 
 BatchFile::BatchFile(const Environment& host, std::unique_ptr<LineReader> input_reader,
                      const std::string_view entered_name,
@@ -135,15 +137,39 @@ std::string BatchFile::ExpandedBatchLine(std::string_view line) const
 
 bool BatchFile::Goto(const std::string_view label)
 {
+	const auto revision = reader->GetRevision();
+	if (labels_revision != revision) {
+		IndexLabels();
+		labels_revision = revision;
+	}
+
+	auto name = std::string(label);
+	lowcase(name);
+
+	const auto it = labels.find(name);
+	if (it == labels.end()) {
+		return false;
+	}
+	reader->SetPosition(it->second);
+	return true;
+}
+
+void BatchFile::IndexLabels()
+{
+	labels.clear();
+
+	const auto position = reader->GetPosition();
 	reader->Reset();
 
+	// The first of the labels with the same name is the one found
 	while (auto line = GetLine()) {
-		if (found_label(*line, label)) {
-			return true;
+		for (auto& name : label_names(*line)) {
+			labels.try_emplace(std::move(name),
+			                   reader->GetPosition());
 		}
 	}
 
-	return false;
+	reader->SetPosition(position);
 }
 
 void BatchFile::Shift()
@@ -151,24 +177,31 @@ void BatchFile::Shift()
 	cmd.Shift(1);
 }
 
-static bool found_label(std::string_view line, const std::string_view label)
+// The lowercase names a GOTO finds the label on the line by: the first word
+// after the colon, or all of the rest of the line
+static std::vector<std::string> label_names(std::string_view line)
 {
 	const auto label_start  = line.find_first_not_of("=\t :");
 	const auto label_prefix = line.substr(0, label_start);
 
 	if (label_start == std::string::npos ||
 	    std::count(label_prefix.begin(), label_prefix.end(), ':') != 1) {
-		return false;
+		return {};
 	}
 
 	line = line.substr(label_start);
 
+	auto whole_line = std::string(line);
+	lowcase(whole_line);
+
 	const auto label_end = line.find_first_of("\t\r\n ");
-	if (label_end != std::string::npos && label_end == label.size()) {
-		line = line.substr(0, label_end);
+	if (label_end == std::string::npos) {
+		return {whole_line};
 	}
 
-	return iequals(line, label);
+	auto first_word = std::string(line.substr(0, label_end));
+	lowcase(first_word);
+	return {first_word, whole_line};
 }
 
 void BatchFile::SetEcho(const bool echo_on)
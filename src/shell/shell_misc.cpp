@@ -500,30 +500,75 @@ std::string DOS_Shell::Which(const std::string_view name) const
 {
 	static constexpr auto extensions = {"", ".COM", ".EXE", ".BAT"};
 
-	std::vector<std::string> prefixes = {""};
+	auto find_in = [&](const std::string& prefix) -> std::string {
+		for (const auto& extension : extensions) {
+			auto file = prefix;
+			file.append(name).append(extension);
+			if (DOS_FileExists(file.c_str())) {
+				return file;
+			}
+		}
+		return "";
+	};
 
-	if (const auto path = psp->GetEnvironmentValue("PATH")) {
-		auto path_directories = split_with_empties(*path, ';');
+	// The current directory changes too often to be worth caching
+	if (auto file = find_in(""); !file.empty()) {
+		return file;
+	}
 
-		remove_empties(path_directories);
+	const auto path = psp->GetEnvironmentValue("PATH");
+	if (!path) {
+		return "";
+	}
 
-		for (auto& directory : path_directories) {
-			if (directory.back() != '\\') {
-				directory += '\\';
-			}
+	auto path_directories = split_with_empties(*path, ';');
+
+	remove_empties(path_directories);
+
+	for (auto& directory : path_directories) {
+		if (directory.back() != '\\') {
+			directory += '\\';
 		}
+	}
 
-		prefixes.insert(prefixes.end(),
-		                std::make_move_iterator(path_directories.begin()),
-		                std::make_move_iterator(path_directories.end()));
+	// Directories relative to the current drive or directory can't be
+	// cached either
+	auto is_absolute = [](const std::string& directory) {
+		return directory.size() >= 3 && directory[1] == ':' &&
+		       directory[2] == '\\';
+	};
+	const auto is_cacheable = std::all_of(path_directories.begin(),
+	                                      path_directories.end(),
+	                                      is_absolute);
+
+	auto& cache = which_cache;
+	if (cache.path != *path ||
+	    cache.file_system_changes != DOS_GetFileSystemChanges() ||
+	    cache.drives != Drives) {
+		cache.path                = *path;
+		cache.file_system_changes = DOS_GetFileSystemChanges();
+		cache.drives              = Drives;
+		cache.files.clear();
 	}
 
-	for (const auto& prefix : prefixes) {
-		for (const auto& extension : extensions) {
-			std::string file = prefix + std::string(name) + extension;
-			if (DOS_FileExists(file.c_str())) {
-				return file;
+	auto command = std::string(name);
+	upcase(command);
+
+	// Files can still disappear on the host behind the drive caches' backs
+	if (const auto it = cache.files.find(command);
+	    is_cacheable && it != cache.files.end()) {
+		if (DOS_FileExists(it->second.c_str())) {
+			return it->second;
+		}
+		cache.files.erase(it);
+	}
+
+	for (const auto& directory : path_directories) {
+		if (auto file = find_in(directory); !file.empty()) {
+			if (is_cacheable) {
+				cache.files[command] = file;
 			}
+			return file;
 		}
 	}
 
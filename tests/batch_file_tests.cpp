@@ -40,6 +40,18 @@ public:
 		++index;
 		return data;
 	}
+	uint32_t GetPosition() const override
+	{
+		return static_cast<uint32_t>(index);
+	}
+	void SetPosition(const uint32_t position) override
+	{
+		index = position;
+	}
+	uint32_t GetRevision() override
+	{
+		return 0;
+	}
 
 	explicit FakeReader(std::string&& str) : contents(split(std::move(str))) {}
 
@@ -217,3 +229,24 @@ TEST(BatchFileGoto, SkipLines)
 	batchfile.ReadLine(line);
 	ASSERT_STREQ(line, "after");
 }
+
+TEST(BatchFileGoto, FirstOfDuplicateLabels)
+{
+	const auto shell = FakeShell({});
+	auto batchfile   = BatchFile(shell,
+                                   std::make_unique<FakeReader>(":label\nfirst\n:LABEL\nsecond"),
+                                   "",
+                                   "",
+                                   true);
+	char line[CMD_MAXLINE];
+
+	batchfile.ReadLine(line);
+	batchfile.ReadLine(line);
+	ASSERT_STREQ(line, "second");
+
+	const auto found_label = batchfile.Goto("Label");
+	ASSERT_TRUE(found_label);
+
+	batchfile.ReadLine(line);
+	ASSERT_STREQ(line, "first");
+}
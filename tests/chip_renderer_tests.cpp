@@ -0,0 +1,100 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "../src/hardware/chip_renderer.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+// A chip that outputs the last value written to it, one frame per step
+struct ValueChip {
+	int value = 0;
+
+	ChipRenderer<int, float> renderer{
+	        1.0,
+	        1.0,
+	        [this](const int num_steps, std::vector<float>& out) {
+		        out.insert(out.end(),
+		                   static_cast<size_t>(num_steps),
+		                   static_cast<float>(value));
+	        },
+	        [this](const int& write) { value = write; }};
+};
+
+TEST(ChipRenderer, AppliesWritesInOrderAfterTheirSteps)
+{
+	ValueChip chip = {};
+	chip.renderer.Start(64, 16);
+
+	// Each write comes 10 steps after the previous one
+	for (int i = 1; i <= 5; ++i) {
+		chip.renderer.AddWrite(i * 10.0, i);
+	}
+
+	std::vector<float> frames = {};
+	ASSERT_TRUE(chip.renderer.DequeueFrames(200, frames));
+	chip.renderer.Stop();
+
+	std::vector<int> num_frames_per_value(6, 0);
+	float prev_value = 0.0f;
+	for (const auto frame : frames) {
+		EXPECT_GE(frame, prev_value);
+		prev_value = frame;
+		++num_frames_per_value[static_cast<size_t>(frame)];
+	}
+	for (size_t value = 0; value < 5; ++value) {
+		EXPECT_GE(num_frames_per_value[value], 10);
+	}
+	EXPECT_GT(num_frames_per_value[5], 0);
+}
+
+TEST(ChipRenderer, KeepsTakingWritesWhenTheMixerStalls)
+{
+	ValueChip chip = {};
+	chip.renderer.Start(32, 4);
+
+	// Without anyone pulling frames, these would fill up both rings
+	for (int i = 1; i <= 1000; ++i) {
+		chip.renderer.AddWrite(i * 10.0, i);
+	}
+
+	std::vector<float> frames = {};
+	ASSERT_TRUE(chip.renderer.DequeueFrames(16, frames));
+	EXPECT_EQ(frames.size(), 16u);
+	chip.renderer.Stop();
+
+	EXPECT_FALSE(chip.renderer.IsRunning());
+}
+
+TEST(ChipRenderer, StopsWhileTheMixerWaits)
+{
+	ValueChip chip = {};
+	chip.renderer.Start(16, 4);
+
+	std::vector<float> frames = {};
+	ASSERT_TRUE(chip.renderer.DequeueFrames(8, frames));
+
+	chip.renderer.Stop();
+	EXPECT_FALSE(chip.renderer.DequeueFrames(1000, frames));
+	EXPECT_LT(frames.size(), 1000u);
+}
+
+} // namespace
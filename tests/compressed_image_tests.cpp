@@ -0,0 +1,178 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "compressed_image.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+namespace {
+
+std::vector<uint8_t> make_image(const size_t num_bytes)
+{
+	std::vector<uint8_t> image(num_bytes);
+	uint32_t value = 1;
+	for (auto& byte : image) {
+		// Compressible, but not trivially so
+		value = value * 1103515245 + 12345;
+		byte  = static_cast<uint8_t>((value >> 16) & 0x0f);
+	}
+	return image;
+}
+
+void append_le(std::vector<uint8_t>& out, const uint32_t value,
+               const int num_bytes)
+{
+	for (int i = 0; i < num_bytes; ++i) {
+		out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+	}
+}
+
+// Writes the image as bgzip does, followed by the empty end-of-file block
+std::vector<uint8_t> make_bgzf(const std::vector<uint8_t>& image,
+                               const size_t block_size)
+{
+	std::vector<uint8_t> out = {};
+	auto add_block = [&](const uint8_t* data, const size_t num_bytes) {
+		std::vector<uint8_t> deflated(compressBound(num_bytes) + 64);
+		z_stream stream  = {};
+		stream.next_in   = const_cast<uint8_t*>(data);
+		stream.avail_in  = static_cast<uInt>(num_bytes);
+		stream.next_out  = deflated.data();
+		stream.avail_out = static_cast<uInt>(deflated.size());
+		deflateInit2(&stream,
+		             Z_DEFAULT_COMPRESSION,
+		             Z_DEFLATED,
+		             -MAX_WBITS,
+		             8,
+		             Z_DEFAULT_STRATEGY);
+		EXPECT_EQ(deflate(&stream, Z_FINISH), Z_STREAM_END);
+		deflated.resize(stream.total_out);
+		deflateEnd(&stream);
+
+		// The extra field length, then the 'BC' subfield with the
+		// block size follows
+		const uint8_t header[] = {
+		        0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0};
+		out.insert(out.end(), std::begin(header), std::end(header));
+		const auto total_size = sizeof(header) + 2 + deflated.size() +
+		                        8;
+		append_le(out, static_cast<uint32_t>(total_size - 1), 2);
+		out.insert(out.end(), deflated.begin(), deflated.end());
+		append_le(out, crc32(0, data, static_cast<uInt>(num_bytes)), 4);
+		append_le(out, static_cast<uint32_t>(num_bytes), 4);
+	};
+	for (size_t pos = 0; pos < image.size(); pos += block_size) {
+		const auto num_bytes = std::min(block_size, image.size() - pos);
+		add_block(image.data() + pos, num_bytes);
+	}
+	add_block(nullptr, 0);
+	return out;
+}
+
+std::string write_file(const std::string& name,
+                       const std::vector<uint8_t>& data)
+{
+	const auto path = (std_fs::temp_directory_path() / name).string();
+	FILE* file      = fopen(path.c_str(), "wb");
+	EXPECT_NE(file, nullptr);
+	fwrite(data.data(), 1, data.size(), file);
+	fclose(file);
+	return path;
+}
+
+TEST(CompressedImage, ReadsAcrossBlocks)
+{
+	const auto image = make_image(300 * 1024 + 123);
+	const auto path  = write_file("dosbox_compressed_image.img.gz",
+                                     make_bgzf(image, 65280));
+
+	auto compressed = CompressedImage::Open(path);
+	ASSERT_NE(compressed, nullptr);
+	EXPECT_EQ(compressed->GetSize(), image.size());
+
+	// Sequential reads, which have the worker inflate the next blocks
+	std::vector<uint8_t> data(2048);
+	for (size_t pos = 0; pos < image.size(); pos += data.size()) {
+		const auto num_read = compressed->Read(pos,
+		                                       data.size(),
+		                                       data.data());
+		ASSERT_TRUE(num_read);
+		ASSERT_EQ(*num_read, std::min(data.size(), image.size() - pos));
+		ASSERT_TRUE(std::equal(data.begin(),
+		                       data.begin() + *num_read,
+		                       image.begin() + pos))
+		        << "at byte " << pos;
+	}
+
+	// Scattered reads spanning block boundaries
+	for (const size_t pos : {65000, 130000, 1, 200000, 65280 * 3 - 5}) {
+		ASSERT_EQ(compressed->Read(pos, data.size(), data.data()),
+		          data.size());
+		ASSERT_TRUE(
+		        std::equal(data.begin(), data.end(), image.begin() + pos))
+		        << "at byte " << pos;
+	}
+	EXPECT_EQ(compressed->Read(image.size(), data.size(), data.data()), 0u);
+
+	compressed.reset();
+	std_fs::remove(path);
+}
+
+TEST(CompressedImage, ReportsTheUncompressedSize)
+{
+	const auto image = make_image(1440 * 1024);
+	const auto path  = write_file("dosbox_compressed_floppy.img.gz",
+                                     make_bgzf(image, 65280));
+
+	FILE* file = fopen(path.c_str(), "rb");
+	ASSERT_NE(file, nullptr);
+	EXPECT_TRUE(CompressedImage::IsCompressed(file));
+	EXPECT_EQ(image_file_size_kb(file), 1440);
+	EXPECT_EQ(ftell(file), 0);
+	fclose(file);
+
+	std_fs::remove(path);
+}
+
+TEST(CompressedImage, RejectsOtherFiles)
+{
+	const auto image = make_image(4096);
+	const auto raw   = write_file("dosbox_raw_image.img", image);
+	EXPECT_FALSE(CompressedImage::IsCompressed(std_fs::path(raw)));
+	EXPECT_EQ(CompressedImage::Open(raw), nullptr);
+
+	// Cut off in the middle of a block
+	auto bgzf = make_bgzf(make_image(100 * 1024), 65280);
+	bgzf.resize(bgzf.size() / 2);
+	const auto damaged = write_file("dosbox_damaged_image.img.gz", bgzf);
+	EXPECT_TRUE(CompressedImage::IsCompressed(std_fs::path(damaged)));
+	EXPECT_EQ(CompressedImage::Open(damaged), nullptr);
+
+	std_fs::remove(raw);
+	std_fs::remove(damaged);
+}
+
+} // namespace
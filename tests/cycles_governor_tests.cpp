@@ -0,0 +1,129 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "../src/cpu/cycles_governor.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+constexpr int32_t MinCycles = 200;
+constexpr int32_t MaxCycles = 2'000'000;
+
+// A host that needs a fixed amount of time per emulated cycle
+struct SimulatedHost {
+	double load_per_cycle = 1.0 / 100'000;
+	double present_load   = 0.0;
+
+	CyclesGovernor::Sample Measure(const int32_t cycles) const
+	{
+		CyclesGovernor::Sample sample = {};
+		sample.emulation_load = cycles * load_per_cycle;
+		sample.present_load   = present_load;
+		return sample;
+	}
+};
+
+int32_t run(CyclesGovernor& governor, const SimulatedHost& host,
+            int32_t cycles, const int updates, int32_t* peak = nullptr)
+{
+	for (int i = 0; i < updates; ++i) {
+		cycles = governor.Update(
+		        cycles, 100, host.Measure(cycles), MinCycles, MaxCycles);
+		if (peak) {
+			*peak = std::max(*peak, cycles);
+		}
+	}
+	return cycles;
+}
+
+TEST(CyclesGovernor, SettlesAtHeadroom)
+{
+	CyclesGovernor governor = {};
+	governor.SetHeadroom(10);
+
+	// 100k cycles take all of the host's time, so we aim for 90k
+	const SimulatedHost host = {};
+	int32_t peak             = 0;
+	const auto cycles        = run(governor, host, 3000, 40, &peak);
+
+	EXPECT_NEAR(cycles, 90'000, 2'000);
+	EXPECT_LE(peak, 95'000);
+}
+
+TEST(CyclesGovernor, BacksOffWhenOverloaded)
+{
+	CyclesGovernor governor = {};
+	governor.SetHeadroom(20);
+
+	const SimulatedHost host = {};
+	const auto cycles        = run(governor, host, 300'000, 40);
+	EXPECT_NEAR(cycles, 80'000, 2'000);
+}
+
+TEST(CyclesGovernor, LeavesRoomForPresenting)
+{
+	CyclesGovernor governor = {};
+	governor.SetHeadroom(10);
+
+	SimulatedHost host = {};
+	host.present_load  = 0.2;
+	const auto cycles  = run(governor, host, 50'000, 40);
+	EXPECT_NEAR(cycles, 70'000, 2'000);
+}
+
+TEST(CyclesGovernor, BacksOffOnAudioUnderruns)
+{
+	CyclesGovernor governor = {};
+	governor.SetHeadroom(10);
+
+	const SimulatedHost host = {};
+	auto sample              = host.Measure(90'000);
+	sample.audio_min_fill    = 0.0;
+	sample.audio_underruns   = 3;
+
+	const auto cycles = governor.Update(90'000, 100, sample, MinCycles, MaxCycles);
+	EXPECT_LT(cycles, 90'000);
+}
+
+TEST(CyclesGovernor, StaysWithinLimits)
+{
+	CyclesGovernor governor = {};
+
+	SimulatedHost idle  = {};
+	idle.load_per_cycle = 1e-9;
+	EXPECT_EQ(run(governor, idle, 1'000'000, 40), MaxCycles);
+
+	SimulatedHost slow  = {};
+	slow.load_per_cycle = 5e-3;
+	governor.Reset();
+	EXPECT_EQ(run(governor, slow, 1'000, 40), MinCycles);
+}
+
+TEST(CyclesGovernor, IgnoresHostStalls)
+{
+	CyclesGovernor governor = {};
+
+	CyclesGovernor::Sample stall = {};
+	stall.emulation_load         = 50.0;
+	EXPECT_EQ(governor.Update(40'000, 100, stall, MinCycles, MaxCycles), 40'000);
+}
+
+} // namespace
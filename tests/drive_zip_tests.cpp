@@ -0,0 +1,274 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "drives.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+namespace {
+
+struct ArchivedFile {
+	std::string name          = {};
+	std::vector<uint8_t> data = {};
+	bool deflate              = false;
+};
+
+std::vector<uint8_t> make_data(const size_t num_bytes)
+{
+	std::vector<uint8_t> data(num_bytes);
+	uint32_t value = 7;
+	for (auto& byte : data) {
+		value = value * 1103515245 + 12345;
+		byte  = static_cast<uint8_t>((value >> 16) & 0x0f);
+	}
+	return data;
+}
+
+void append_le(std::vector<uint8_t>& out, const uint32_t value,
+               const int num_bytes)
+{
+	for (int i = 0; i < num_bytes; ++i) {
+		out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+	}
+}
+
+std::vector<uint8_t> deflate_raw(const std::vector<uint8_t>& data)
+{
+	std::vector<uint8_t> deflated(compressBound(data.size()) + 64);
+	z_stream stream  = {};
+	stream.next_in   = const_cast<uint8_t*>(data.data());
+	stream.avail_in  = static_cast<uInt>(data.size());
+	stream.next_out  = deflated.data();
+	stream.avail_out = static_cast<uInt>(deflated.size());
+	deflateInit2(&stream,
+	             Z_DEFAULT_COMPRESSION,
+	             Z_DEFLATED,
+	             -MAX_WBITS,
+	             8,
+	             Z_DEFAULT_STRATEGY);
+	EXPECT_EQ(deflate(&stream, Z_FINISH), Z_STREAM_END);
+	deflated.resize(stream.total_out);
+	deflateEnd(&stream);
+	return deflated;
+}
+
+// Writes the files as a ZIP archive, with a comment after the central
+// directory so its end has to be searched for
+std::vector<uint8_t> make_zip(const std::vector<ArchivedFile>& files)
+{
+	std::vector<uint8_t> out       = {};
+	std::vector<uint8_t> directory = {};
+
+	for (const auto& file : files) {
+		const auto stored = file.deflate ? deflate_raw(file.data)
+		                                 : file.data;
+		const auto crc    = crc32(0,
+                                       file.data.data(),
+                                       static_cast<uInt>(file.data.size()));
+		const uint32_t method = file.deflate ? 8 : 0;
+		const auto offset     = static_cast<uint32_t>(out.size());
+
+		const auto stored_size = static_cast<uint32_t>(stored.size());
+		const auto size = static_cast<uint32_t>(file.data.size());
+		const auto name_size = static_cast<uint32_t>(file.name.size());
+
+		auto add_common = [&](std::vector<uint8_t>& header) {
+			append_le(header, 20, 2);     // version needed
+			append_le(header, 0, 2);      // flags
+			append_le(header, method, 2);
+			append_le(header, 0x6000, 2); // 12:00
+			append_le(header, 0x5821, 2); // 2024-01-01
+			append_le(header, crc, 4);
+			append_le(header, stored_size, 4);
+			append_le(header, size, 4);
+			append_le(header, name_size, 2);
+		};
+
+		// The local header has a padding extra field the central
+		// one doesn't
+		append_le(out, 0x04034b50, 4);
+		add_common(out);
+		append_le(out, 4, 2);
+		out.insert(out.end(), file.name.begin(), file.name.end());
+		append_le(out, 0xcafe, 2);
+		append_le(out, 0, 2);
+		out.insert(out.end(), stored.begin(), stored.end());
+
+		append_le(directory, 0x02014b50, 4);
+		append_le(directory, 20, 2); // version made by
+		add_common(directory);
+		append_le(directory, 0, 2); // extra field
+		append_le(directory, 0, 2); // comment
+		append_le(directory, 0, 2); // disk
+		append_le(directory, 0, 2); // internal attributes
+		append_le(directory, 0, 4); // external attributes
+		append_le(directory, offset, 4);
+		directory.insert(directory.end(),
+		                 file.name.begin(),
+		                 file.name.end());
+	}
+
+	const auto dir_offset = static_cast<uint32_t>(out.size());
+	out.insert(out.end(), directory.begin(), directory.end());
+
+	const std::string comment = "made for the tests";
+	append_le(out, 0x06054b50, 4);
+	append_le(out, 0, 4);
+	append_le(out, static_cast<uint32_t>(files.size()), 2);
+	append_le(out, static_cast<uint32_t>(files.size()), 2);
+	append_le(out, static_cast<uint32_t>(directory.size()), 4);
+	append_le(out, dir_offset, 4);
+	append_le(out, static_cast<uint32_t>(comment.size()), 2);
+	out.insert(out.end(), comment.begin(), comment.end());
+	return out;
+}
+
+std::string write_file(const std::string& name,
+                       const std::vector<uint8_t>& data)
+{
+	const auto path = (std_fs::temp_directory_path() / name).string();
+	FILE* file      = fopen(path.c_str(), "wb");
+	EXPECT_NE(file, nullptr);
+	fwrite(data.data(), 1, data.size(), file);
+	fclose(file);
+	return path;
+}
+
+std::vector<uint8_t> read_all(DOS_File* file)
+{
+	std::vector<uint8_t> data = {};
+	uint8_t buffer[1000];
+	while (true) {
+		uint16_t num_bytes = sizeof(buffer);
+		EXPECT_TRUE(file->Read(buffer, &num_bytes));
+		if (!num_bytes) {
+			return data;
+		}
+		data.insert(data.end(), buffer, buffer + num_bytes);
+	}
+}
+
+TEST(ZipDrive, ReadsStoredAndDeflatedFiles)
+{
+	const auto stored   = make_data(5000);
+	const auto deflated = make_data(70000);
+
+	const auto zip  = make_zip({{"GAME.EXE", stored, false},
+	                            {"DATA/LEVELS.DAT", deflated, true}});
+	const auto path = write_file("dosbox_drive_zip.zip", zip);
+	int error = 0;
+	zipDrive drive(path.c_str(), 0xF8, error);
+	ASSERT_EQ(error, 0);
+
+	char exe_name[] = "GAME.EXE";
+	DOS_File* file  = nullptr;
+	ASSERT_TRUE(drive.FileOpen(&file, exe_name, OPEN_READ));
+	EXPECT_EQ(read_all(file), stored);
+	delete file;
+
+	char dat_name[] = "data\\levels.dat";
+	ASSERT_TRUE(drive.FileOpen(&file, dat_name, OPEN_READ));
+	EXPECT_EQ(file->date, 0x5821);
+	EXPECT_EQ(read_all(file), deflated);
+
+	uint32_t pos = 60000;
+	ASSERT_TRUE(file->Seek(&pos, DOS_SEEK_SET));
+	uint8_t byte       = 0;
+	uint16_t num_bytes = 1;
+	ASSERT_TRUE(file->Read(&byte, &num_bytes));
+	EXPECT_EQ(num_bytes, 1);
+	EXPECT_EQ(byte, deflated[60000]);
+	delete file;
+
+	FileStat_Block stat = {};
+	ASSERT_TRUE(drive.FileStat("DATA\\LEVELS.DAT", &stat));
+	EXPECT_EQ(stat.size, deflated.size());
+
+	std_fs::remove(path);
+}
+
+TEST(ZipDrive, ShortensLongNames)
+{
+	const std::string dir = "Long Directory Name/";
+
+	const auto zip  = make_zip({{dir + "readme file.txt", make_data(10)},
+	                            {dir + "readme files.txt", make_data(20)},
+	                            {"empty/", {}}});
+	const auto path = write_file("dosbox_drive_zip_names.zip", zip);
+	int error = 0;
+	zipDrive drive(path.c_str(), 0xF8, error);
+	ASSERT_EQ(error, 0);
+
+	char short_dir[] = "LONGDI~1";
+	char empty[]     = "EMPTY";
+	EXPECT_TRUE(drive.TestDir(short_dir));
+	EXPECT_TRUE(drive.TestDir(empty));
+	EXPECT_TRUE(drive.FileExists("LONGDI~1\\README~1.TXT"));
+	EXPECT_TRUE(drive.FileExists("LONGDI~1\\README~2.TXT"));
+	EXPECT_FALSE(drive.FileExists("LONGDI~1"));
+
+	FileStat_Block stat = {};
+	ASSERT_TRUE(drive.FileStat("LONGDI~1\\README~2.TXT", &stat));
+	EXPECT_EQ(stat.size, 20u);
+
+	std_fs::remove(path);
+}
+
+TEST(ZipDrive, IsReadOnly)
+{
+	const auto zip  = make_zip({{"SAVE.DAT", make_data(10)}});
+	const auto path = write_file("dosbox_drive_zip_writes.zip", zip);
+	int error = 0;
+	zipDrive drive(path.c_str(), 0xF8, error);
+	ASSERT_EQ(error, 0);
+
+	char name[]    = "SAVE.DAT";
+	DOS_File* file = nullptr;
+	EXPECT_FALSE(drive.FileOpen(&file, name, OPEN_WRITE));
+	EXPECT_FALSE(drive.FileCreate(&file, name, {}));
+	EXPECT_FALSE(drive.FileUnlink(name));
+
+	ASSERT_TRUE(drive.FileOpen(&file, name, OPEN_READWRITE));
+	uint8_t data[4]    = {};
+	uint16_t num_bytes = sizeof(data);
+	EXPECT_FALSE(file->Write(data, &num_bytes));
+	delete file;
+
+	std_fs::remove(path);
+}
+
+TEST(ZipDrive, RejectsOtherFiles)
+{
+	const auto path = write_file("dosbox_drive_zip_other.zip",
+	                             make_data(4096));
+	int error = 0;
+	zipDrive drive(path.c_str(), 0xF8, error);
+	EXPECT_NE(error, 0);
+
+	std_fs::remove(path);
+}
+
+} // namespace
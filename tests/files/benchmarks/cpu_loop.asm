@@ -0,0 +1,71 @@
+# SPDX-License-Identifier: GPL-2.0-or-later
+# Copyright (C) 2024-2024  The DOSBox Staging Team
+#
+# Benchmark workload: integer ALU, multiply/divide, and string moves
+#
+# Runs until a key is pressed (or the benchmark run ends).
+#
+#   as --32 -o cpu_loop.o cpu_loop.asm
+#   ld -m elf_i386 -Ttext=0x100 -e _start --oformat=binary -o cpu_loop.com cpu_loop.o
+
+	.intel_syntax noprefix
+	.code16
+	.text
+	.globl _start
+_start:
+	cld
+
+outer:
+	# Fill the buffer with a xorshift sequence
+	mov	di, offset buffer
+	mov	cx, 2048
+	mov	ax, 0xace1
+fill:
+	mov	dx, ax
+	shl	dx, 7
+	xor	ax, dx
+	mov	dx, ax
+	shr	dx, 9
+	xor	ax, dx
+	mov	dx, ax
+	shl	dx, 8
+	xor	ax, dx
+	stosw
+	loop	fill
+
+	# Checksum it with adds, rotates, and multiplies
+	mov	si, offset buffer
+	mov	cx, 2048
+	xor	bx, bx
+checksum:
+	lodsw
+	add	bx, ax
+	rol	bx, 3
+	mul	bx
+	xor	bx, dx
+	loop	checksum
+
+	# Divide it down
+	mov	ax, bx
+	xor	dx, dx
+	mov	cx, 251
+	div	cx
+
+	# Copy the buffer to the next 4 KB
+	mov	si, offset buffer
+	mov	di, offset buffer + 4096
+	mov	cx, 2048
+	rep	movsw
+
+	# Stop when a key is pressed
+	mov	ah, 1
+	int	0x16
+	jz	outer
+
+	xor	ah, ah
+	int	0x16
+	mov	ax, 0x4c00
+	int	0x21
+
+	.p2align 4
+buffer:
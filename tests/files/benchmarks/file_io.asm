@@ -0,0 +1,93 @@
+# SPDX-License-Identifier: GPL-2.0-or-later
+# Copyright (C) 2024-2024  The DOSBox Staging Team
+#
+# Benchmark workload: DOS file I/O, repeatedly writing a 256 KB file in
+# 32 KB blocks to the current directory, reading it back, and deleting it
+#
+# Runs until a key is pressed (or the benchmark run ends).
+#
+#   as --32 -o file_io.o file_io.asm
+#   ld -m elf_i386 -Ttext=0x100 -e _start --oformat=binary -o file_io.com file_io.o
+
+	.intel_syntax noprefix
+	.code16
+	.text
+	.globl _start
+_start:
+	cld
+
+	# Fill the buffer with a counting pattern
+	mov	di, offset buffer
+	mov	cx, 16384
+	xor	ax, ax
+fill:
+	stosw
+	inc	ax
+	loop	fill
+
+outer:
+	# Create the file and write it
+	mov	ah, 0x3c
+	xor	cx, cx
+	mov	dx, offset filename
+	int	0x21
+	jc	fail
+	mov	bx, ax
+	mov	si, 8
+write:
+	mov	ah, 0x40
+	mov	cx, 32768
+	mov	dx, offset buffer
+	int	0x21
+	jc	fail
+	dec	si
+	jnz	write
+	mov	ah, 0x3e
+	int	0x21
+
+	# Read it back
+	mov	ax, 0x3d00
+	mov	dx, offset filename
+	int	0x21
+	jc	fail
+	mov	bx, ax
+read:
+	mov	ah, 0x3f
+	mov	cx, 32768
+	mov	dx, offset buffer
+	int	0x21
+	jc	fail
+	or	ax, ax
+	jnz	read
+	mov	ah, 0x3e
+	int	0x21
+
+	# Delete it
+	mov	ah, 0x41
+	mov	dx, offset filename
+	int	0x21
+
+	# Stop when a key is pressed
+	mov	ah, 1
+	int	0x16
+	jz	outer
+
+	xor	ah, ah
+	int	0x16
+	mov	ax, 0x4c00
+	int	0x21
+
+fail:
+	mov	ah, 9
+	mov	dx, offset error_message
+	int	0x21
+	mov	ax, 0x4c01
+	int	0x21
+
+filename:
+	.asciz	"BENCH.TMP"
+error_message:
+	.ascii	"File I/O failed\r\n$"
+
+	.p2align 4
+buffer:
@@ -0,0 +1,53 @@
+# SPDX-License-Identifier: GPL-2.0-or-later
+# Copyright (C) 2024-2024  The DOSBox Staging Team
+#
+# Benchmark workload: x87 loads, arithmetic, square roots, and sines
+#
+# Runs until a key is pressed (or the benchmark run ends).
+#
+#   as --32 -o fpu_loop.o fpu_loop.asm
+#   ld -m elf_i386 -Ttext=0x100 -e _start --oformat=binary -o fpu_loop.com fpu_loop.o
+
+	.intel_syntax noprefix
+	.code16
+	.text
+	.globl _start
+_start:
+	finit
+
+outer:
+	# Sum sin(sqrt(n)) * sqrt(n), decaying the sum as it goes
+	mov	word ptr [n], 1
+	mov	cx, 4096
+	fldz
+sum:
+	fild	word ptr [n]
+	fsqrt
+	fld	st(0)
+	fsin
+	fmulp	st(1), st
+	faddp	st(1), st
+	fmul	qword ptr [decay]
+	inc	word ptr [n]
+	loop	sum
+
+	fstp	qword ptr [result]
+	fwait
+
+	# Stop when a key is pressed
+	mov	ah, 1
+	int	0x16
+	jz	outer
+
+	xor	ah, ah
+	int	0x16
+	mov	ax, 0x4c00
+	int	0x21
+
+	.p2align 3
+decay:
+	.double	0.999
+result:
+	.double	0.0
+n:
+	.word	0
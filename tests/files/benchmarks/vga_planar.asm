@@ -0,0 +1,88 @@
+# SPDX-License-Identifier: GPL-2.0-or-later
+# Copyright (C) 2024-2024  The DOSBox Staging Team
+#
+# Benchmark workload: planar VGA writes in mode 12h (640x480, 16 colours)
+# through the map mask, the latches (write mode 1), and set/reset (write
+# mode 2)
+#
+# Runs until a key is pressed (or the benchmark run ends).
+#
+#   as --32 -o vga_planar.o vga_planar.asm
+#   ld -m elf_i386 -Ttext=0x100 -e _start --oformat=binary -o vga_planar.com vga_planar.o
+
+	.intel_syntax noprefix
+	.code16
+	.text
+	.globl _start
+_start:
+	mov	ax, 0x0012
+	int	0x10
+
+	mov	ax, 0xa000
+	mov	es, ax
+	cld
+	xor	bl, bl
+
+outer:
+	# Fill each plane separately through the map mask
+	mov	bh, 1
+plane:
+	mov	dx, 0x3c4
+	mov	al, 2
+	mov	ah, bh
+	out	dx, ax
+	xor	di, di
+	mov	cx, 19200
+	mov	al, bl
+	mov	ah, bl
+	not	ah
+	rep	stosw
+	inc	bl
+	shl	bh, 1
+	cmp	bh, 0x10
+	jb	plane
+
+	# Enable all planes again
+	mov	ax, 0x0f02
+	out	dx, ax
+
+	# Copy the top half of the screen over the bottom half through the
+	# latches
+	mov	dx, 0x3ce
+	mov	ax, 0x0105
+	out	dx, ax
+	push	ds
+	push	es
+	pop	ds
+	xor	si, si
+	mov	di, 19200
+	mov	cx, 19200
+	rep	movsb
+	pop	ds
+
+	# Draw colour bars with set/reset
+	mov	ax, 0x0205
+	out	dx, ax
+	xor	di, di
+	mov	cx, 38400
+	mov	al, bl
+bars:
+	stosb
+	inc	al
+	loop	bars
+
+	# Back to write mode 0
+	mov	ax, 0x0005
+	out	dx, ax
+
+	# Stop when a key is pressed
+	mov	ah, 1
+	int	0x16
+	jz	outer
+
+	xor	ah, ah
+	int	0x16
+	mov	ax, 0x0003
+	int	0x10
+	mov	ax, 0x4c00
+	int	0x21
@@ -0,0 +1,231 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "float80.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+
+// With the precision control set to 53 bits the kernel must produce the
+// exact same results as the host's IEEE double arithmetic
+constexpr int DoublePrecision = 53;
+
+std::vector<double> random_doubles(const size_t count)
+{
+	std::mt19937_64 rng(0x8087);
+	std::uniform_real_distribution<double> mant(1.0, 2.0);
+	std::uniform_int_distribution<int> exp(-60, 60);
+	std::vector<double> values(count);
+	for (auto& val : values) {
+		val = std::ldexp(mant(rng), exp(rng));
+		if (rng() & 1) {
+			val = -val;
+		}
+	}
+	return values;
+}
+
+double via_f80(Float80 (*op)(Float80, Float80, int, F80Rounding),
+               const double a, const double b)
+{
+	return f80_to_double(op(f80_from_double(a),
+	                        f80_from_double(b),
+	                        DoublePrecision,
+	                        F80Rounding::Nearest));
+}
+
+TEST(Float80, DoubleRoundTrip)
+{
+	for (const auto val : random_doubles(1000)) {
+		EXPECT_EQ(f80_to_double(f80_from_double(val)), val);
+	}
+	const auto denormal = std::numeric_limits<double>::denorm_min();
+	EXPECT_EQ(f80_to_double(f80_from_double(denormal)), denormal);
+	EXPECT_EQ(f80_to_double(f80_from_double(-0.0)), -0.0);
+	EXPECT_TRUE(std::signbit(f80_to_double(f80_from_double(-0.0))));
+}
+
+TEST(Float80, MatchesDoubleArithmetic)
+{
+	const auto a = random_doubles(10000);
+	const auto b = random_doubles(a.size() + 1);
+
+	for (size_t i = 0; i < a.size(); ++i) {
+		const auto x = a[i];
+		const auto y = b[i + 1];
+		EXPECT_EQ(via_f80(f80_add, x, y), x + y);
+		EXPECT_EQ(via_f80(f80_sub, x, y), x - y);
+		EXPECT_EQ(via_f80(f80_mul, x, y), x * y);
+		EXPECT_EQ(via_f80(f80_div, x, y), x / y);
+		const auto root = f80_sqrt(f80_from_double(std::fabs(x)),
+		                           DoublePrecision,
+		                           F80Rounding::Nearest);
+		EXPECT_EQ(f80_to_double(root), std::sqrt(std::fabs(x)));
+	}
+}
+
+TEST(Float80, KeepsExtendedPrecision)
+{
+	// 1 + 2^-60 can't be represented by a double
+	const auto one  = f80_from_double(1.0);
+	const auto tiny = f80_from_double(std::ldexp(1.0, -60));
+	const auto sum  = f80_add(one, tiny);
+	EXPECT_EQ(sum.sign_exp, F80Bias);
+	EXPECT_EQ(sum.mant, F80IntBit | (uint64_t(1) << 3));
+	EXPECT_EQ(f80_sub(sum, one), tiny);
+
+	// 1/3 in extended precision, round to nearest
+	const auto third = f80_div(one, f80_from_double(3.0));
+	EXPECT_EQ(third.sign_exp, F80Bias - 2);
+	EXPECT_EQ(third.mant, 0xaaaa'aaaa'aaaa'aaabULL);
+}
+
+TEST(Float80, RoundingControl)
+{
+	const auto one   = f80_from_double(1.0);
+	const auto three = f80_from_double(3.0);
+
+	const auto down = f80_div(one, three, 64, F80Rounding::Down);
+	const auto chop = f80_div(one, three, 64, F80Rounding::Chop);
+	const auto up   = f80_div(one, three, 64, F80Rounding::Up);
+	EXPECT_EQ(down.mant, 0xaaaa'aaaa'aaaa'aaaaULL);
+	EXPECT_EQ(chop.mant, 0xaaaa'aaaa'aaaa'aaaaULL);
+	EXPECT_EQ(up.mant, 0xaaaa'aaaa'aaaa'aaabULL);
+
+	// 24-bit precision clears the low mantissa bits
+	const auto single = f80_div(one, three, 24, F80Rounding::Nearest);
+	EXPECT_EQ(single.mant & 0xff'ffff'ffffULL, 0u);
+	EXPECT_EQ(f80_to_double(single), static_cast<double>(1.0f / 3.0f));
+}
+
+TEST(Float80, SpecialValues)
+{
+	const auto inf  = f80_from_double(std::numeric_limits<double>::infinity());
+	const auto zero = f80_from_double(0.0);
+	const auto one  = f80_from_double(1.0);
+
+	EXPECT_EQ(f80_div(one, zero), inf);
+	EXPECT_EQ(f80_add(inf, one), inf);
+	EXPECT_EQ(f80_mul(zero, inf), F80DefaultNaN);
+	EXPECT_EQ(f80_sub(inf, inf), F80DefaultNaN);
+	EXPECT_EQ(f80_div(zero, zero), F80DefaultNaN);
+	EXPECT_EQ(f80_sqrt(f80_from_double(-1.0)), F80DefaultNaN);
+	EXPECT_TRUE(std::isnan(f80_to_double(F80DefaultNaN)));
+	EXPECT_EQ(f80_sqrt(f80_from_double(4.0)), f80_from_double(2.0));
+
+	// x - x is +0 in all rounding modes except rounding down
+	EXPECT_EQ(f80_sub(one, one).sign_exp, 0);
+	EXPECT_EQ(f80_sub(one, one, 64, F80Rounding::Down).sign_exp, 0x8000);
+}
+
+// Reading back varying results keeps the benchmarked loops from
+// being optimized away
+volatile uint64_t benchmark_sink = 0;
+
+// Microbenchmark of the soft-float kernel against the double path used
+// by the FPU core on non-x86 hosts, run it with:
+//   tests/float80 --gtest_also_run_disabled_tests --gtest_filter='*Benchmark*'
+TEST(Float80, DISABLED_Benchmark)
+{
+	constexpr size_t NumValues = 4096;
+	constexpr int NumRounds    = 500;
+
+	const auto values = random_doubles(NumValues);
+	std::vector<Float80> values_80 = {};
+	for (const auto val : values) {
+		values_80.push_back(f80_from_double(val));
+	}
+
+	auto time_ms = [](auto&& body) {
+		const auto start = std::chrono::steady_clock::now();
+		body();
+		const std::chrono::duration<double, std::milli> elapsed =
+		        std::chrono::steady_clock::now() - start;
+		return elapsed.count();
+	};
+
+	// Independent operations on neighbouring values, so the timings are
+	// of throughput and not skewed by overflowing results
+	auto run_double = [&](auto op) {
+		std::vector<double> out(NumValues);
+		return time_ms([&] {
+			for (int round = 0; round < NumRounds; ++round) {
+				for (size_t i = 0; i < NumValues; ++i) {
+					out[i] = op(values[i], values[(i + 1) % NumValues]);
+				}
+				benchmark_sink = static_cast<uint64_t>(out[round]);
+			}
+		});
+	};
+	auto run_f80 = [&](auto op) {
+		std::vector<Float80> out(NumValues);
+		return time_ms([&] {
+			for (int round = 0; round < NumRounds; ++round) {
+				for (size_t i = 0; i < NumValues; ++i) {
+					out[i] = op(values_80[i],
+					            values_80[(i + 1) % NumValues]);
+				}
+				benchmark_sink = out[round].mant;
+			}
+		});
+	};
+
+	struct Result {
+		const char* name;
+		double double_ms;
+		double f80_ms;
+	};
+	const Result results[] = {
+	        {"add",
+	         run_double([](double a, double b) { return a + b; }),
+	         run_f80([](Float80 a, Float80 b) { return f80_add(a, b); })},
+	        {"mul",
+	         run_double([](double a, double b) { return a * b; }),
+	         run_f80([](Float80 a, Float80 b) { return f80_mul(a, b); })},
+	        {"div",
+	         run_double([](double a, double b) { return a / b; }),
+	         run_f80([](Float80 a, Float80 b) { return f80_div(a, b); })},
+	        {"sqrt",
+	         run_double([](double a, double) { return std::sqrt(std::fabs(a)); }),
+	         run_f80([](Float80 a, Float80) {
+		         a.sign_exp &= 0x7fff;
+		         return f80_sqrt(a);
+	         })},
+	};
+
+	const auto num_ops = static_cast<double>(NumValues) * NumRounds;
+	for (const auto& r : results) {
+		printf("%-5s double: %6.2f ns/op, float80: %6.2f ns/op (%.1fx)\n",
+		       r.name,
+		       r.double_ms * 1e6 / num_ops,
+		       r.f80_ms * 1e6 / num_ops,
+		       r.f80_ms / r.double_ms);
+	}
+}
+
+} // namespace
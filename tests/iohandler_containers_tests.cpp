@@ -195,4 +195,30 @@ TEST(iohandler_containers, adjacent_dword_write)
 	EXPECT_EQ(read_word_from_port(word_port_start), val >> 16);
 }
 
+TEST(iohandler_containers, free_range)
+{
+	constexpr io_port_t range_start = 0xf000;
+	constexpr io_port_t range_size  = 8;
+
+	IO_RegisterReadHandler(range_start, read_byte_new, io_width_t::byte, range_size);
+	byte_val_new = 0x12;
+	for (io_port_t port = range_start; port < range_start + range_size; ++port) {
+		EXPECT_EQ(read_byte_from_port(port), 0x12);
+	}
+
+	// free the middle of the range, the rest keeps its handler
+	IO_FreeReadHandler(range_start + 2, io_width_t::byte, 4);
+	EXPECT_EQ(read_byte_from_port(range_start + 1), 0x12);
+	EXPECT_EQ(read_byte_from_port(range_start + 2), 0xff);
+	EXPECT_EQ(read_byte_from_port(range_start + 5), 0xff);
+	EXPECT_EQ(read_byte_from_port(range_start + 6), 0x12);
+
+	// reinstalling replaces the blocking handler
+	IO_RegisterReadHandler(range_start + 2, read_byte_new, io_width_t::byte, 4);
+	EXPECT_EQ(read_byte_from_port(range_start + 3), 0x12);
+
+	IO_FreeReadHandler(range_start, io_width_t::byte, range_size);
+	EXPECT_EQ(read_byte_from_port(range_start), 0xff);
+}
+
 } // namespace
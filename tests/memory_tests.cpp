@@ -0,0 +1,236 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "mem.h"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <chrono>
+#include <vector>
+
+#include "paging.h"
+
+#include "dosbox_test_fixture.h"
+
+namespace {
+
+// Conventional memory, well past the interrupt vectors and the BIOS data
+constexpr PhysPt RamStart = 0x20000;
+
+// A page without host memory, like the ones of memory-mapped devices
+constexpr PhysPt DevicePage  = 0x30;
+constexpr PhysPt DeviceStart = DevicePage * 4096;
+
+class DevicePageHandler final : public PageHandler {
+public:
+	DevicePageHandler()
+	{
+		flags = PFLAG_NOCODE;
+	}
+	uint8_t readb(PhysPt addr) override
+	{
+		++num_reads;
+		return bytes[addr & 0xfff];
+	}
+	void writeb(PhysPt addr, uint8_t val) override
+	{
+		++num_writes;
+		bytes[addr & 0xfff] = val;
+	}
+
+	std::array<uint8_t, 4096> bytes = {};
+	size_t num_reads  = 0;
+	size_t num_writes = 0;
+};
+
+class MemoryTest : public DOSBoxTestFixture {
+protected:
+	void SetUp() override
+	{
+		DOSBoxTestFixture::SetUp();
+		MEM_SetPageHandler(DevicePage, 1, &device);
+		PAGING_ClearTLB();
+	}
+	void TearDown() override
+	{
+		MEM_ResetPageHandler(DevicePage, 1);
+		PAGING_ClearTLB();
+		DOSBoxTestFixture::TearDown();
+	}
+
+	DevicePageHandler device = {};
+};
+
+std::vector<uint8_t> make_pattern(const size_t size)
+{
+	std::vector<uint8_t> pattern(size);
+	for (size_t i = 0; i < size; ++i) {
+		pattern[i] = static_cast<uint8_t>(i * 7 + i / 251);
+	}
+	return pattern;
+}
+
+TEST_F(MemoryTest, BlockReadWriteAcrossPages)
+{
+	// Starts in the middle of a page and ends in the middle of another
+	const auto pattern = make_pattern(3 * 4096 + 123);
+	const PhysPt start = RamStart + 4096 - 77;
+	MEM_BlockWrite(start, pattern.data(), pattern.size());
+
+	std::vector<uint8_t> read(pattern.size());
+	MEM_BlockRead(start, read.data(), read.size());
+	EXPECT_EQ(read, pattern);
+
+	for (const size_t i : {size_t(0), size_t(76), size_t(77), pattern.size() - 1}) {
+		EXPECT_EQ(mem_readb(start + static_cast<PhysPt>(i)), pattern[i]);
+	}
+}
+
+TEST_F(MemoryTest, BlockReadWriteThroughHandlers)
+{
+	const auto pattern = make_pattern(4000);
+	MEM_BlockWrite(DeviceStart + 50, pattern.data(), pattern.size());
+	EXPECT_EQ(device.num_writes, pattern.size());
+	EXPECT_TRUE(std::equal(pattern.begin(),
+	                       pattern.end(),
+	                       device.bytes.begin() + 50));
+
+	std::vector<uint8_t> read(pattern.size());
+	MEM_BlockRead(DeviceStart + 50, read.data(), read.size());
+	EXPECT_EQ(device.num_reads, pattern.size());
+	EXPECT_EQ(read, pattern);
+}
+
+TEST_F(MemoryTest, BlockCopyBetweenRamAndHandlers)
+{
+	// The copies start in RAM and run into the device's page, and back
+	const auto pattern = make_pattern(6000);
+	MEM_BlockWrite(RamStart, pattern.data(), pattern.size());
+
+	const PhysPt device_copy = DeviceStart - 2000;
+	MEM_BlockCopy(device_copy, RamStart, pattern.size());
+	std::vector<uint8_t> read(pattern.size());
+	MEM_BlockRead(device_copy, read.data(), read.size());
+	EXPECT_EQ(read, pattern);
+	EXPECT_EQ(device.num_writes, size_t{4000});
+
+	MEM_BlockCopy(RamStart + 0x8000, device_copy, pattern.size());
+	MEM_BlockRead(RamStart + 0x8000, read.data(), read.size());
+	EXPECT_EQ(read, pattern);
+}
+
+TEST_F(MemoryTest, OverlappingCopies)
+{
+	const auto pattern = make_pattern(3 * 4096);
+
+	// Copying backwards moves the bytes down
+	MEM_BlockWrite(RamStart, pattern.data(), pattern.size());
+	mem_memcpy(RamStart, RamStart + 10, pattern.size() - 10);
+	std::vector<uint8_t> read(pattern.size() - 10);
+	MEM_BlockRead(RamStart, read.data(), read.size());
+	EXPECT_TRUE(std::equal(read.begin(), read.end(), pattern.begin() + 10));
+
+	// Copying forward onto itself repeats the first bytes, like the
+	// byte-by-byte copy always did
+	MEM_BlockWrite(RamStart, pattern.data(), pattern.size());
+	mem_memcpy(RamStart + 3, RamStart, pattern.size() - 3);
+	MEM_BlockRead(RamStart, read.data(), read.size());
+	for (size_t i = 0; i < read.size(); ++i) {
+		ASSERT_EQ(read[i], pattern[i % 3]) << "at byte " << i;
+	}
+}
+
+TEST_F(MemoryTest, AllocationsFillTheBestFittingHole)
+{
+	const auto free_total   = MEM_FreeTotal();
+	const auto free_largest = MEM_FreeLargest();
+
+	const auto first  = MEM_AllocatePages(10, true);
+	const auto second = MEM_AllocatePages(4, true);
+	const auto third  = MEM_AllocatePages(10, true);
+	ASSERT_GT(first, 0);
+	ASSERT_GT(second, 0);
+	ASSERT_GT(third, 0);
+	EXPECT_EQ(MEM_FreeTotal(), free_total - 24);
+
+	// The small hole is used before the bigger ones
+	MEM_ReleasePages(first);
+	MEM_ReleasePages(second);
+	EXPECT_EQ(MEM_FreeTotal(), free_total - 10);
+	const auto refill = MEM_AllocatePages(12, true);
+	EXPECT_EQ(refill, first);
+
+	// Scattered allocations also start with the smallest hole
+	MEM_ReleasePages(refill);
+	const auto scattered = MEM_AllocatePages(20, false);
+	EXPECT_EQ(scattered, first);
+	EXPECT_EQ(MEM_AllocatedPages(scattered), 20u);
+
+	MEM_ReleasePages(scattered);
+	MEM_ReleasePages(third);
+	EXPECT_EQ(MEM_FreeTotal(), free_total);
+	EXPECT_EQ(MEM_FreeLargest(), free_largest);
+}
+
+TEST_F(MemoryTest, OverlappingMoves)
+{
+	const auto pattern = make_pattern(3 * 4096);
+	std::vector<uint8_t> read(pattern.size() - 5000);
+
+	// Moving up keeps the source intact, unlike mem_memcpy
+	MEM_BlockWrite(RamStart, pattern.data(), pattern.size());
+	MEM_BlockMove(RamStart + 5000, RamStart, read.size());
+	MEM_BlockRead(RamStart + 5000, read.data(), read.size());
+	EXPECT_TRUE(std::equal(read.begin(), read.end(), pattern.begin()));
+
+	MEM_BlockWrite(RamStart, pattern.data(), pattern.size());
+	MEM_BlockMove(RamStart, RamStart + 5000, read.size());
+	MEM_BlockRead(RamStart, read.data(), read.size());
+	EXPECT_TRUE(std::equal(read.begin(), read.end(), pattern.begin() + 5000));
+}
+
+// Not so much a test as a measurement; the results end up in the XML output
+// of the test run
+TEST_F(MemoryTest, BlockCopyThroughput)
+{
+	constexpr size_t block_size = 60 * 1024;
+	constexpr int rounds        = 256;
+	const auto pattern          = make_pattern(block_size);
+	std::vector<uint8_t> read(block_size);
+
+	using namespace std::chrono;
+	const auto start = steady_clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		MEM_BlockWrite(RamStart, pattern.data(), block_size);
+		MEM_BlockCopy(RamStart + block_size, RamStart, block_size);
+		MEM_BlockRead(RamStart + block_size, read.data(), block_size);
+	}
+	const auto elapsed_us =
+	        duration_cast<microseconds>(steady_clock::now() - start).count();
+
+	EXPECT_EQ(read, pattern);
+
+	const auto num_mb = 3.0 * rounds * block_size / (1024 * 1024);
+	const auto elapsed_s = std::max<int64_t>(elapsed_us, 1) / 1e6;
+	RecordProperty("ram_mb_per_second", static_cast<int>(num_mb / elapsed_s));
+}
+
+} // namespace
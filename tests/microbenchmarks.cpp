@@ -0,0 +1,419 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/* Microbenchmarks of the emulator's hot paths, built with Google Benchmark
+ * when it's installed. Run them with:
+ *
+ *   meson test -C build --benchmark -v
+ *
+ * or run build/tests/microbenchmarks directly to pass Google Benchmark's
+ * options, like --benchmark_filter=<regex>.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "control.h"
+#include "cpu.h"
+#include "cross.h"
+#include "dos_system.h"
+#include "dosbox.h"
+#include "inout.h"
+#include "mem.h"
+#include "mixer.h"
+#include "nuked/opl3.h"
+#include "pic.h"
+#include "render.h"
+#include "std_filesystem.h"
+#include "video.h"
+#include "zmbv/zmbv.h"
+
+#include "../src/gui/render_scalers.h"
+
+// Conventional memory, well past the interrupt vectors and the BIOS data
+constexpr PhysPt RamStart = 0x20000;
+
+// Starts the same modules as the DOSBoxTestFixture of the unit tests
+static void init_dosbox()
+{
+	static const char* argv[] = {
+	        "-conf tests/files/dosbox-staging-tests.conf"};
+	static CommandLine com_line(1, argv);
+
+	control = std::make_unique<Config>(&com_line);
+
+	InitConfigDir();
+	control->ParseConfigFiles(GetConfigDir());
+
+	DOSBOX_Init();
+	for (const auto name : {"dosbox", "cpu", "mixer"}) {
+		control->GetSection(name)->ExecuteInit();
+	}
+}
+
+// I/O port dispatch
+// ~~~~~~~~~~~~~~~~~
+
+static void BM_IoReadB(benchmark::State& state)
+{
+	// A port no emulated device uses
+	constexpr io_port_t Port = 0x2f0;
+
+	IO_RegisterReadHandler(
+	        Port,
+	        [](io_port_t, io_width_t) -> io_val_t { return 0x55; },
+	        io_width_t::byte);
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(IO_ReadB(Port));
+	}
+	IO_FreeReadHandler(Port, io_width_t::byte);
+}
+BENCHMARK(BM_IoReadB);
+
+// Guest memory
+// ~~~~~~~~~~~~
+
+static void BM_MemReaddThroughTlb(benchmark::State& state)
+{
+	constexpr PhysPt Size = 64 * 1024;
+
+	for (auto _ : state) {
+		uint32_t sum = 0;
+		for (auto addr = RamStart; addr < RamStart + Size; addr += 4) {
+			sum += mem_readd(addr);
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetBytesProcessed(state.iterations() * Size);
+}
+BENCHMARK(BM_MemReaddThroughTlb);
+
+static void BM_MemBlockWrite(benchmark::State& state)
+{
+	const auto size = static_cast<size_t>(state.range(0));
+	const std::vector<uint8_t> data(size, 0xa5);
+
+	for (auto _ : state) {
+		MEM_BlockWrite(RamStart, data.data(), size);
+		benchmark::ClobberMemory();
+	}
+	state.SetBytesProcessed(state.iterations() *
+	                        static_cast<int64_t>(size));
+}
+BENCHMARK(BM_MemBlockWrite)->Arg(16)->Arg(512)->Arg(64 * 1024);
+
+// PIC event queue
+// ~~~~~~~~~~~~~~~
+
+static void count_event(uint32_t val)
+{
+	benchmark::DoNotOptimize(val);
+}
+
+static void BM_PicAddEventRunQueue(benchmark::State& state)
+{
+	const auto num_events = static_cast<uint32_t>(state.range(0));
+
+	for (auto _ : state) {
+		// Start of a millisecond, so the events due now are run
+		CPU_CycleLeft = CPU_CycleMax;
+		CPU_Cycles    = 0;
+
+		for (uint32_t i = 0; i < num_events; ++i) {
+			PIC_AddEvent(count_event, 0.0, i);
+		}
+		PIC_RunQueue();
+	}
+	state.SetItemsProcessed(state.iterations() * num_events);
+}
+BENCHMARK(BM_PicAddEventRunQueue)->Arg(1)->Arg(16)->Arg(64);
+
+static void BM_PicAddRemoveEvents(benchmark::State& state)
+{
+	const auto num_events = static_cast<uint32_t>(state.range(0));
+
+	for (auto _ : state) {
+		for (uint32_t i = 0; i < num_events; ++i) {
+			PIC_AddEvent(count_event, 0.5 + i * 0.01, i);
+		}
+		PIC_RemoveEvents(count_event);
+	}
+	state.SetItemsProcessed(state.iterations() * num_events);
+}
+BENCHMARK(BM_PicAddRemoveEvents)->Arg(16)->Arg(64);
+
+// Render scalers
+// ~~~~~~~~~~~~~~
+
+// Scales a 640x400 frame of 8-bit pixels to 32-bit output; with the
+// argument set, every line differs from the previous frame
+static void scale_frames(benchmark::State& state,
+                         const ScalerSimpleBlock_t& scaler)
+{
+	constexpr int Width  = 640;
+	constexpr int Height = 400;
+
+	const bool lines_change = state.range(0) != 0;
+
+	std::array<std::vector<uint8_t>, 2> frames = {
+	        std::vector<uint8_t>(Width * Height, 0x11),
+	        std::vector<uint8_t>(Width * Height, 0x22),
+	};
+	const auto out_pitch = Width * scaler.xscale * 4;
+	std::vector<uint8_t> out(static_cast<size_t>(out_pitch) * Height *
+	                         scaler.yscale);
+
+	render.src.width        = Width;
+	render.src.height       = Height;
+	render.scale.cachePitch = Width;
+	render.scale.outPitch   = out_pitch;
+	render.pal.changed      = false;
+
+	const auto line_handler = scaler.Linear[0][scalerMode32];
+
+	size_t frame_index = 0;
+	for (auto _ : state) {
+		render.scale.outWrite   = out.data();
+		render.scale.cacheRead  = reinterpret_cast<uint8_t*>(
+		        &scalerSourceCache);
+		render.scale.outLine    = 0;
+		Scaler_ChangedLines[0]  = 0;
+		Scaler_ChangedLineIndex = 0;
+		Scaler_NumRows          = 0;
+
+		Scaler_ChangedColumnsStart = INT32_MAX;
+		Scaler_ChangedColumnsEnd   = 0;
+
+		if (lines_change) {
+			frame_index ^= 1;
+		}
+		const auto frame = frames[frame_index].data();
+		for (int y = 0; y < Height; ++y) {
+			line_handler(frame + y * Width);
+		}
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * Width * Height);
+}
+
+static void BM_ScaleNormal1x(benchmark::State& state)
+{
+	scale_frames(state, ScaleNormal1x);
+}
+BENCHMARK(BM_ScaleNormal1x)->Arg(0)->Arg(1);
+
+static void BM_ScaleNormal2x(benchmark::State& state)
+{
+	scale_frames(state, ScaleNormal2x);
+}
+BENCHMARK(BM_ScaleNormal2x)->Arg(0)->Arg(1);
+
+// Mixer sample conversion
+// ~~~~~~~~~~~~~~~~~~~~~~~
+
+static void ignore_frames_request(const uint16_t) {}
+
+// AddSamples() converts the frames and mixes them into the mixer's buffer;
+// at the mixer's rate there's no resampling in between
+static void BM_MixerAddSamplesS16(benchmark::State& state)
+{
+	constexpr uint16_t NumFrames = 1024;
+
+	MixerChannel channel(ignore_frames_request,
+	                     "BENCH",
+	                     {ChannelFeature::Stereo});
+	channel.SetSampleRate(MIXER_GetSampleRate());
+
+	std::vector<int16_t> samples(NumFrames * 2);
+	for (size_t i = 0; i < samples.size(); ++i) {
+		samples[i] = static_cast<int16_t>(i * 37);
+	}
+
+	for (auto _ : state) {
+		channel.AddSamples_s16(NumFrames, samples.data());
+	}
+	state.SetItemsProcessed(state.iterations() * NumFrames);
+}
+BENCHMARK(BM_MixerAddSamplesS16);
+
+// Nuked OPL3
+// ~~~~~~~~~~
+
+static void BM_NukedOplGenerateStream(benchmark::State& state)
+{
+	constexpr uint32_t NumFrames = 1024;
+
+	opl3_chip chip = {};
+	OPL3_Reset(&chip, 49716);
+
+	// A sustained note on the first channel
+	constexpr std::array<std::pair<uint16_t, uint8_t>, 10> Registers = {{
+	        {0x20, 0x01},
+	        {0x40, 0x10},
+	        {0x60, 0xf0},
+	        {0x80, 0x77},
+	        {0x23, 0x01},
+	        {0x43, 0x00},
+	        {0x63, 0xf0},
+	        {0x83, 0x77},
+	        {0xa0, 0x98},
+	        {0xb0, 0x31},
+	}};
+	for (const auto& [reg, val] : Registers) {
+		OPL3_WriteReg(&chip, reg, val);
+	}
+
+	std::vector<int16_t> out(NumFrames * 2);
+	for (auto _ : state) {
+		OPL3_GenerateStream(&chip, out.data(), NumFrames);
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * NumFrames);
+}
+BENCHMARK(BM_NukedOplGenerateStream);
+
+// ZMBV video compression
+// ~~~~~~~~~~~~~~~~~~~~~~
+
+// Compresses 320x200 8-bit frames of a pattern scrolling by a pixel per
+// frame, so the motion search has some work to do
+static void BM_ZmbvCompressLines(benchmark::State& state)
+{
+	constexpr int Width  = 320;
+	constexpr int Height = 200;
+
+	VideoCodec codec;
+	codec.SetupCompress(Width, Height);
+
+	const auto buf_size = codec.NeededSize(Width,
+	                                       Height,
+	                                       ZMBV_FORMAT::BPP_8);
+	std::vector<uint8_t> buf(static_cast<size_t>(buf_size));
+
+	std::vector<uint8_t> palette(256 * 4);
+	std::vector<uint8_t> frame(Width * Height);
+
+	int frame_num = 0;
+	for (auto _ : state) {
+		state.PauseTiming();
+		for (int y = 0; y < Height; ++y) {
+			for (int x = 0; x < Width; ++x) {
+				frame[y * Width + x] = static_cast<uint8_t>(
+				        ((x + frame_num) ^ y) & 0x3f);
+			}
+		}
+		state.ResumeTiming();
+
+		const int flags = (frame_num % 300 == 0) ? 1 : 0;
+		codec.PrepareCompressFrame(flags,
+		                           ZMBV_FORMAT::BPP_8,
+		                           palette.data(),
+		                           buf.data(),
+		                           static_cast<uint32_t>(buf.size()));
+		for (int y = 0; y < Height; ++y) {
+			const uint8_t* row = frame.data() + y * Width;
+			codec.CompressLines(1, &row);
+		}
+		benchmark::DoNotOptimize(codec.FinishCompressFrame());
+		++frame_num;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ZmbvCompressLines);
+
+// Directory cache
+// ~~~~~~~~~~~~~~~
+
+// Lists a directory of the given number of files; with the cache emptied
+// before each listing, it's read from the host every time
+static void find_all_files(benchmark::State& state, const bool read_from_host)
+{
+	const auto num_files = static_cast<int>(state.range(0));
+
+	const auto dir = std_fs::temp_directory_path() /
+	                 ("dosbox_bench_" + std::to_string(num_files));
+	std_fs::create_directories(dir);
+	for (int i = 0; i < num_files; ++i) {
+		const auto name = dir / ("FILE" + std::to_string(i) + ".TXT");
+		if (!std_fs::exists(name)) {
+			FILE* file = fopen(name.string().c_str(), "wb");
+			if (file) {
+				fclose(file);
+			}
+		}
+	}
+
+	auto path = dir.string() + CROSS_FILESPLIT;
+	DOS_Drive_Cache cache(path.c_str());
+
+	std::vector<char> search(path.begin(), path.end());
+	search.push_back('\0');
+
+	for (auto _ : state) {
+		if (read_from_host) {
+			cache.EmptyCache();
+		}
+		uint16_t id = 0;
+		if (!cache.FindFirst(search.data(), id)) {
+			state.SkipWithError("FindFirst failed");
+			break;
+		}
+		char* result = nullptr;
+		int num_found = 0;
+		while (cache.FindNext(id, result)) {
+			++num_found;
+		}
+		benchmark::DoNotOptimize(num_found);
+	}
+	state.SetItemsProcessed(state.iterations() * num_files);
+}
+
+static void BM_DriveCacheFindFirst(benchmark::State& state)
+{
+	find_all_files(state, false);
+}
+BENCHMARK(BM_DriveCacheFindFirst)->Arg(256)->Arg(4096);
+
+static void BM_DriveCacheFindFirstFromHost(benchmark::State& state)
+{
+	find_all_files(state, true);
+}
+BENCHMARK(BM_DriveCacheFindFirstFromHost)->Arg(256)->Arg(4096);
+
+int main(int argc, char** argv)
+{
+	init_dosbox();
+
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+		return 1;
+	}
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+
+	GFX_RequestExit(true);
+	return 0;
+}
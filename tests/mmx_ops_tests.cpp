@@ -0,0 +1,433 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "../src/cpu/mmx_ops.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+
+// Scalar reference implementation, working on one lane at a time
+
+template <int Bits>
+int64_t lane(const uint64_t q, const int i, const bool is_signed)
+{
+	constexpr uint64_t Mask = (Bits == 64) ? ~uint64_t(0)
+	                                       : (uint64_t(1) << Bits) - 1;
+	const auto val = (q >> (i * Bits)) & Mask;
+	if (is_signed && Bits < 64 && (val >> (Bits - 1))) {
+		return static_cast<int64_t>(val | ~Mask);
+	}
+	return static_cast<int64_t>(val);
+}
+
+template <int Bits>
+uint64_t set_lane(const uint64_t q, const int i, const int64_t val)
+{
+	constexpr uint64_t Mask = (Bits == 64) ? ~uint64_t(0)
+	                                       : (uint64_t(1) << Bits) - 1;
+	const auto shift = i * Bits;
+	return (q & ~(Mask << shift)) | ((static_cast<uint64_t>(val) & Mask) << shift);
+}
+
+template <int Bits>
+constexpr int64_t signed_max()
+{
+	return (int64_t(1) << (Bits - 1)) - 1;
+}
+
+template <int Bits>
+constexpr int64_t unsigned_max()
+{
+	return (int64_t(1) << Bits) - 1;
+}
+
+int64_t saturate(const int64_t val, const int64_t lo, const int64_t hi)
+{
+	return std::clamp(val, lo, hi);
+}
+
+template <int Bits, typename Op>
+uint64_t ref_lanes(const uint64_t a, const uint64_t b, const bool is_signed, Op op)
+{
+	uint64_t res = 0;
+	for (int i = 0; i < 64 / Bits; ++i) {
+		res = set_lane<Bits>(res,
+		                     i,
+		                     op(lane<Bits>(a, i, is_signed),
+		                        lane<Bits>(b, i, is_signed)));
+	}
+	return res;
+}
+
+template <int Bits>
+uint64_t ref_add(const uint64_t a, const uint64_t b)
+{
+	return ref_lanes<Bits>(a, b, false, [](auto x, auto y) { return x + y; });
+}
+
+template <int Bits>
+uint64_t ref_sub(const uint64_t a, const uint64_t b)
+{
+	return ref_lanes<Bits>(a, b, false, [](auto x, auto y) { return x - y; });
+}
+
+template <int Bits>
+uint64_t ref_adds(const uint64_t a, const uint64_t b)
+{
+	return ref_lanes<Bits>(a, b, true, [](auto x, auto y) {
+		return saturate(x + y, -signed_max<Bits>() - 1, signed_max<Bits>());
+	});
+}
+
+template <int Bits>
+uint64_t ref_subs(const uint64_t a, const uint64_t b)
+{
+	return ref_lanes<Bits>(a, b, true, [](auto x, auto y) {
+		return saturate(x - y, -signed_max<Bits>() - 1, signed_max<Bits>());
+	});
+}
+
+template <int Bits>
+uint64_t ref_addus(const uint64_t a, const uint64_t b)
+{
+	return ref_lanes<Bits>(a, b, false, [](auto x, auto y) {
+		return saturate(x + y, 0, unsigned_max<Bits>());
+	});
+}
+
+template <int Bits>
+uint64_t ref_subus(const uint64_t a, const uint64_t b)
+{
+	return ref_lanes<Bits>(a, b, false, [](auto x, auto y) {
+		return saturate(x - y, 0, unsigned_max<Bits>());
+	});
+}
+
+template <int Bits>
+uint64_t ref_cmpeq(const uint64_t a, const uint64_t b)
+{
+	return ref_lanes<Bits>(a, b, false, [](auto x, auto y) {
+		return x == y ? -1 : 0;
+	});
+}
+
+template <int Bits>
+uint64_t ref_cmpgt(const uint64_t a, const uint64_t b)
+{
+	return ref_lanes<Bits>(a, b, true, [](auto x, auto y) {
+		return x > y ? -1 : 0;
+	});
+}
+
+uint64_t ref_pmulhw(const uint64_t a, const uint64_t b)
+{
+	return ref_lanes<16>(a, b, true, [](auto x, auto y) { return (x * y) >> 16; });
+}
+
+uint64_t ref_pmullw(const uint64_t a, const uint64_t b)
+{
+	return ref_lanes<16>(a, b, true, [](auto x, auto y) { return x * y; });
+}
+
+uint64_t ref_pmaddwd(const uint64_t a, const uint64_t b)
+{
+	uint64_t res = 0;
+	for (int i = 0; i < 2; ++i) {
+		const auto sum = lane<16>(a, 2 * i, true) * lane<16>(b, 2 * i, true) +
+		                 lane<16>(a, 2 * i + 1, true) *
+		                         lane<16>(b, 2 * i + 1, true);
+		res = set_lane<32>(res, i, sum);
+	}
+	return res;
+}
+
+// Packs the lanes of a into the low half and those of b into the high half
+template <int Bits>
+uint64_t ref_pack(const uint64_t a, const uint64_t b, const bool is_unsigned)
+{
+	constexpr int Half     = Bits / 2;
+	constexpr int NumLanes = 64 / Bits;
+	const int64_t lo = is_unsigned ? 0 : -signed_max<Half>() - 1;
+	const int64_t hi = is_unsigned ? unsigned_max<Half>() : signed_max<Half>();
+	uint64_t res = 0;
+	for (int i = 0; i < NumLanes; ++i) {
+		res = set_lane<Half>(res, i, saturate(lane<Bits>(a, i, true), lo, hi));
+		res = set_lane<Half>(res,
+		                     i + NumLanes,
+		                     saturate(lane<Bits>(b, i, true), lo, hi));
+	}
+	return res;
+}
+
+// Interleaves the lanes of the low or high halves of a and b
+template <int Bits>
+uint64_t ref_unpack(const uint64_t a, const uint64_t b, const bool high)
+{
+	constexpr int NumLanes = 64 / Bits;
+	const int first        = high ? NumLanes / 2 : 0;
+	uint64_t res           = 0;
+	for (int i = 0; i < NumLanes / 2; ++i) {
+		res = set_lane<Bits>(res, 2 * i, lane<Bits>(a, first + i, false));
+		res = set_lane<Bits>(res, 2 * i + 1, lane<Bits>(b, first + i, false));
+	}
+	return res;
+}
+
+template <int Bits>
+uint64_t ref_shift(const uint64_t a, const uint64_t count, const int kind)
+{
+	uint64_t res = 0;
+	for (int i = 0; i < 64 / Bits; ++i) {
+		int64_t val = 0;
+		if (kind == 0) { // shift left logical
+			val = count >= Bits ? 0 : lane<Bits>(a, i, false) << count;
+		} else if (kind == 1) { // shift right logical
+			val = count >= Bits
+			            ? 0
+			            : static_cast<int64_t>(
+			                      static_cast<uint64_t>(lane<Bits>(a, i, false)) >>
+			                      count);
+		} else { // shift right arithmetic
+			const auto n = std::min<uint64_t>(count, Bits - 1);
+			val          = lane<Bits>(a, i, true) >> n;
+		}
+		res = set_lane<Bits>(res, i, val);
+	}
+	return res;
+}
+
+MMX_reg reg(const uint64_t q)
+{
+	MMX_reg r = {};
+	r.q       = q;
+	return r;
+}
+
+std::vector<uint64_t> test_values()
+{
+	// edge cases for the saturation and comparisons in all lane widths
+	std::vector<uint64_t> values = {0,
+	                                ~uint64_t(0),
+	                                0x8000'0000'8000'0000,
+	                                0x7fff'ffff'7fff'ffff,
+	                                0x8000'8000'8000'8000,
+	                                0x7fff'7fff'7fff'7fff,
+	                                0x8080'8080'8080'8080,
+	                                0x7f7f'7f7f'7f7f'7f7f,
+	                                0x0001'00ff'ff00'0100,
+	                                0x0123'4567'89ab'cdef};
+	std::mt19937_64 rng(0x4d4d58);
+	for (int i = 0; i < 200; ++i) {
+		values.push_back(rng());
+	}
+	return values;
+}
+
+using BinaryOp = MMX_reg (*)(MMX_reg, MMX_reg);
+using RefOp    = uint64_t (*)(uint64_t, uint64_t);
+
+void expect_matches(const BinaryOp op, const RefOp ref)
+{
+	const auto values = test_values();
+	for (const auto a : values) {
+		for (const auto b : values) {
+			ASSERT_EQ(op(reg(a), reg(b)).q, ref(a, b))
+			        << std::hex << "a=" << a << " b=" << b;
+		}
+	}
+}
+
+TEST(MmxOps, AddSub)
+{
+	expect_matches(mmx::paddb, ref_add<8>);
+	expect_matches(mmx::paddw, ref_add<16>);
+	expect_matches(mmx::paddd, ref_add<32>);
+	expect_matches(mmx::psubb, ref_sub<8>);
+	expect_matches(mmx::psubw, ref_sub<16>);
+	expect_matches(mmx::psubd, ref_sub<32>);
+}
+
+TEST(MmxOps, SaturatingAddSub)
+{
+	expect_matches(mmx::paddsb, ref_adds<8>);
+	expect_matches(mmx::paddsw, ref_adds<16>);
+	expect_matches(mmx::paddusb, ref_addus<8>);
+	expect_matches(mmx::paddusw, ref_addus<16>);
+	expect_matches(mmx::psubsb, ref_subs<8>);
+	expect_matches(mmx::psubsw, ref_subs<16>);
+	expect_matches(mmx::psubusb, ref_subus<8>);
+	expect_matches(mmx::psubusw, ref_subus<16>);
+}
+
+TEST(MmxOps, Multiply)
+{
+	expect_matches(mmx::pmulhw, ref_pmulhw);
+	expect_matches(mmx::pmullw, ref_pmullw);
+	expect_matches(mmx::pmaddwd, ref_pmaddwd);
+}
+
+TEST(MmxOps, Compare)
+{
+	expect_matches(mmx::pcmpeqb, ref_cmpeq<8>);
+	expect_matches(mmx::pcmpeqw, ref_cmpeq<16>);
+	expect_matches(mmx::pcmpeqd, ref_cmpeq<32>);
+	expect_matches(mmx::pcmpgtb, ref_cmpgt<8>);
+	expect_matches(mmx::pcmpgtw, ref_cmpgt<16>);
+	expect_matches(mmx::pcmpgtd, ref_cmpgt<32>);
+}
+
+TEST(MmxOps, PackUnpack)
+{
+	expect_matches(mmx::packsswb, [](uint64_t a, uint64_t b) {
+		return ref_pack<16>(a, b, false);
+	});
+	expect_matches(mmx::packssdw, [](uint64_t a, uint64_t b) {
+		return ref_pack<32>(a, b, false);
+	});
+	expect_matches(mmx::packuswb, [](uint64_t a, uint64_t b) {
+		return ref_pack<16>(a, b, true);
+	});
+	expect_matches(mmx::punpcklbw, [](uint64_t a, uint64_t b) {
+		return ref_unpack<8>(a, b, false);
+	});
+	expect_matches(mmx::punpcklwd, [](uint64_t a, uint64_t b) {
+		return ref_unpack<16>(a, b, false);
+	});
+	expect_matches(mmx::punpckldq, [](uint64_t a, uint64_t b) {
+		return ref_unpack<32>(a, b, false);
+	});
+	expect_matches(mmx::punpckhbw, [](uint64_t a, uint64_t b) {
+		return ref_unpack<8>(a, b, true);
+	});
+	expect_matches(mmx::punpckhwd, [](uint64_t a, uint64_t b) {
+		return ref_unpack<16>(a, b, true);
+	});
+	expect_matches(mmx::punpckhdq, [](uint64_t a, uint64_t b) {
+		return ref_unpack<32>(a, b, true);
+	});
+}
+
+TEST(MmxOps, Logical)
+{
+	expect_matches(mmx::pand, [](uint64_t a, uint64_t b) { return a & b; });
+	expect_matches(mmx::pandn, [](uint64_t a, uint64_t b) { return ~a & b; });
+	expect_matches(mmx::por, [](uint64_t a, uint64_t b) { return a | b; });
+	expect_matches(mmx::pxor, [](uint64_t a, uint64_t b) { return a ^ b; });
+}
+
+TEST(MmxOps, Shifts)
+{
+	// counts past the lane width, and ones with high bits set
+	const std::vector<uint64_t> counts = {
+	        0, 1, 7, 8, 15, 16, 31, 32, 63, 64, 255, 0x1'0000'0001};
+
+	for (const auto a : test_values()) {
+		for (const auto count : counts) {
+			const auto c = reg(count);
+			EXPECT_EQ(mmx::psllw(reg(a), c).q, ref_shift<16>(a, count, 0));
+			EXPECT_EQ(mmx::pslld(reg(a), c).q, ref_shift<32>(a, count, 0));
+			EXPECT_EQ(mmx::psllq(reg(a), c).q, ref_shift<64>(a, count, 0));
+			EXPECT_EQ(mmx::psrlw(reg(a), c).q, ref_shift<16>(a, count, 1));
+			EXPECT_EQ(mmx::psrld(reg(a), c).q, ref_shift<32>(a, count, 1));
+			EXPECT_EQ(mmx::psrlq(reg(a), c).q, ref_shift<64>(a, count, 1));
+			EXPECT_EQ(mmx::psraw(reg(a), c).q, ref_shift<16>(a, count, 2));
+			EXPECT_EQ(mmx::psrad(reg(a), c).q, ref_shift<32>(a, count, 2));
+
+			if (count > 255) {
+				continue;
+			}
+			const auto imm = static_cast<uint8_t>(count);
+			EXPECT_EQ(mmx::psllwi(reg(a), imm).q, ref_shift<16>(a, count, 0));
+			EXPECT_EQ(mmx::pslldi(reg(a), imm).q, ref_shift<32>(a, count, 0));
+			EXPECT_EQ(mmx::psllqi(reg(a), imm).q, ref_shift<64>(a, count, 0));
+			EXPECT_EQ(mmx::psrlwi(reg(a), imm).q, ref_shift<16>(a, count, 1));
+			EXPECT_EQ(mmx::psrldi(reg(a), imm).q, ref_shift<32>(a, count, 1));
+			EXPECT_EQ(mmx::psrlqi(reg(a), imm).q, ref_shift<64>(a, count, 1));
+			EXPECT_EQ(mmx::psrawi(reg(a), imm).q, ref_shift<16>(a, count, 2));
+			EXPECT_EQ(mmx::psradi(reg(a), imm).q, ref_shift<32>(a, count, 2));
+		}
+	}
+}
+
+// Reading back varying results keeps the benchmarked loops from
+// being optimized away
+volatile uint64_t benchmark_sink = 0;
+
+// Microbenchmark of the SIMDe backed operations against the scalar
+// reference, run it with:
+//   tests/mmx_ops --gtest_also_run_disabled_tests --gtest_filter='*Benchmark*'
+TEST(MmxOps, DISABLED_Benchmark)
+{
+	constexpr size_t NumValues = 4096;
+	constexpr int NumRounds    = 2000;
+
+	std::mt19937_64 rng(0x4d4d58);
+	std::vector<uint64_t> values(NumValues);
+	for (auto& val : values) {
+		val = rng();
+	}
+
+	auto time_ns = [&](auto op) {
+		std::vector<uint64_t> out(NumValues);
+		const auto start = std::chrono::steady_clock::now();
+		for (int round = 0; round < NumRounds; ++round) {
+			for (size_t i = 0; i < NumValues; ++i) {
+				out[i] = op(values[i], values[(i + 1) % NumValues]);
+			}
+			benchmark_sink = out[round % NumValues];
+		}
+		const std::chrono::duration<double, std::nano> elapsed =
+		        std::chrono::steady_clock::now() - start;
+		return elapsed.count() / (static_cast<double>(NumValues) * NumRounds);
+	};
+
+	auto report = [&](const char* name, const BinaryOp op, auto ref) {
+		const auto simde_ns = time_ns(
+		        [op](uint64_t a, uint64_t b) { return op(reg(a), reg(b)).q; });
+		const auto scalar_ns = time_ns(ref);
+		printf("%-10s simde: %5.2f ns/op, scalar: %5.2f ns/op\n",
+		       name,
+		       simde_ns,
+		       scalar_ns);
+	};
+
+	report("paddb", mmx::paddb, ref_add<8>);
+	report("paddsw", mmx::paddsw, ref_adds<16>);
+	report("paddusb", mmx::paddusb, ref_addus<8>);
+	report("psubusw", mmx::psubusw, ref_subus<16>);
+	report("pmulhw", mmx::pmulhw, ref_pmulhw);
+	report("pmaddwd", mmx::pmaddwd, ref_pmaddwd);
+	report("pcmpgtb", mmx::pcmpgtb, ref_cmpgt<8>);
+	report("packuswb", mmx::packuswb, [](uint64_t a, uint64_t b) {
+		return ref_pack<16>(a, b, true);
+	});
+	report("punpcklbw", mmx::punpcklbw, [](uint64_t a, uint64_t b) {
+		return ref_unpack<8>(a, b, false);
+	});
+}
+
+} // namespace
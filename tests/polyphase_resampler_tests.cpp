@@ -0,0 +1,123 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "../src/hardware/polyphase_resampler.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+namespace {
+
+constexpr double Pi = 3.14159265358979323846;
+
+// Resamples a stereo sine wave in blocks, returning the interleaved output
+std::vector<float> resample_sine(PolyphaseResampler& resampler,
+                                 const double freq_hz, const int num_frames,
+                                 const int block_frames = 64)
+{
+	std::vector<float> in  = {};
+	std::vector<float> out = {};
+	std::vector<float> all = {};
+
+	for (auto n = 0; n < num_frames;) {
+		in.clear();
+		for (auto i = 0; i < block_frames && n < num_frames; ++i, ++n) {
+			const auto sample = static_cast<float>(std::sin(
+			        2 * Pi * freq_hz * n / resampler.GetInputRateHz()));
+			in.push_back(sample);
+			in.push_back(-sample);
+		}
+		resampler.Process(in, out);
+		all.insert(all.end(), out.begin(), out.end());
+	}
+	return all;
+}
+
+double max_error_from_sine(const PolyphaseResampler& resampler,
+                           const std::vector<float>& out, const double freq_hz)
+{
+	// Skip the filter ringing in from the silence before the first frame
+	constexpr size_t settle_frames = 200;
+
+	double max_error = 0.0;
+	for (size_t k = settle_frames; k < out.size() / 2; ++k) {
+		const auto expected = std::sin(
+		        2 * Pi * freq_hz * static_cast<double>(k) /
+		        resampler.GetOutputRateHz());
+		max_error = std::max(max_error, std::fabs(out[k * 2] - expected));
+		max_error = std::max(max_error, std::fabs(out[k * 2 + 1] + expected));
+	}
+	return max_error;
+}
+
+TEST(PolyphaseResampler, ProducesFramesAtTheOutputRate)
+{
+	PolyphaseResampler resampler(22050, 48000);
+	const auto out = resample_sine(resampler, 1000.0, 22050);
+
+	// Half the filter length is still queued up at the end
+	EXPECT_NEAR(out.size() / 2, 48000, 64);
+}
+
+TEST(PolyphaseResampler, PassesAudibleFrequencies)
+{
+	PolyphaseResampler up(11025, 48000);
+	EXPECT_LT(max_error_from_sine(up, resample_sine(up, 1000.0, 8000), 1000.0),
+	          1e-3);
+
+	PolyphaseResampler down(48000, 22050);
+	EXPECT_LT(max_error_from_sine(down, resample_sine(down, 440.0, 8000), 440.0),
+	          1e-3);
+}
+
+TEST(PolyphaseResampler, InterpolatesOddRatios)
+{
+	// 48000 / 19293 can't be reduced, so there are too many phases to
+	// keep them all
+	PolyphaseResampler resampler(19293, 48000);
+	EXPECT_LT(max_error_from_sine(resampler,
+	                              resample_sine(resampler, 1000.0, 8000),
+	                              1000.0),
+	          1e-3);
+}
+
+TEST(PolyphaseResampler, BlocksizeDoesNotMatter)
+{
+	PolyphaseResampler a(44100, 48000);
+	PolyphaseResampler b(44100, 48000);
+
+	EXPECT_EQ(resample_sine(a, 3000.0, 4000, 1),
+	          resample_sine(b, 3000.0, 4000, 1000));
+}
+
+TEST(PolyphaseResampler, ResetStartsOver)
+{
+	PolyphaseResampler resampler(32000, 48000);
+
+	const auto first = resample_sine(resampler, 500.0, 1000);
+	resampler.Reset();
+	const auto second = resample_sine(resampler, 500.0, 1000);
+
+	EXPECT_EQ(first, second);
+}
+
+} // namespace
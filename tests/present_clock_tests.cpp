@@ -0,0 +1,119 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "present_clock.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+namespace {
+
+// A 60 Hz display whose vblanks are slightly off the reported rate
+constexpr int NominalPeriodUs = 16'667;
+constexpr double ActualPeriodUs = 16'683.0;
+constexpr int64_t FirstVblankUs = 1'000'000;
+
+int64_t vblank(const int n)
+{
+	return FirstVblankUs + static_cast<int64_t>(n * ActualPeriodUs);
+}
+
+// Feeds presentations that return up to the given jitter after each vblank
+void present_frames(PresentClock& clock, const int first, const int count,
+                    const int max_jitter_us = 500)
+{
+	std::mt19937 rng(60);
+	std::uniform_int_distribution<int> jitter(0, max_jitter_us);
+	for (int n = first; n < first + count; ++n) {
+		clock.AddPresent(vblank(n) + jitter(rng));
+	}
+}
+
+TEST(PresentClock, LocksOntoVblanks)
+{
+	PresentClock clock = {};
+	clock.SetNominalPeriod(NominalPeriodUs);
+	EXPECT_FALSE(clock.IsLocked());
+
+	present_frames(clock, 0, 600);
+	EXPECT_TRUE(clock.IsLocked());
+	EXPECT_NEAR(clock.GetPeriodUs(), ActualPeriodUs, 10.0);
+
+	// Halfway between two vblanks
+	const auto now = vblank(600) + NominalPeriodUs / 2;
+	EXPECT_NEAR(clock.PredictNextVblank(now), vblank(601), 600);
+	EXPECT_NEAR(clock.PredictLastVblank(now), vblank(600), 600);
+}
+
+TEST(PresentClock, SkippedVblanksKeepTheLock)
+{
+	PresentClock clock = {};
+	clock.SetNominalPeriod(NominalPeriodUs);
+	present_frames(clock, 0, 100);
+
+	// Every other vblank, as with 30 FPS content
+	for (int n = 100; n < 200; n += 2) {
+		clock.AddPresent(vblank(n) + 200);
+	}
+	EXPECT_TRUE(clock.IsLocked());
+	const auto now = vblank(200) + 1000;
+	EXPECT_NEAR(clock.PredictNextVblank(now), vblank(201), 600);
+}
+
+TEST(PresentClock, RelocksAfterPhaseChange)
+{
+	PresentClock clock = {};
+	clock.SetNominalPeriod(NominalPeriodUs);
+	present_frames(clock, 0, 100);
+
+	// The display moved its vblanks by half a period, e.g. after a mode
+	// switch
+	constexpr auto shift_us = NominalPeriodUs / 2;
+	for (int n = 100; n < 200; ++n) {
+		clock.AddPresent(vblank(n) + shift_us + 100);
+	}
+	EXPECT_TRUE(clock.IsLocked());
+	const auto now = vblank(200) + shift_us + 2000;
+	EXPECT_NEAR(clock.PredictNextVblank(now), vblank(201) + shift_us, 600);
+}
+
+TEST(PresentClock, Histogram)
+{
+	PresentClock clock = {};
+	EXPECT_EQ(clock.GetPercentileMs(50), 0);
+
+	int64_t now = 0;
+	for (int i = 0; i < 100; ++i) {
+		// One in ten frames takes twice as long
+		now += (i % 10 == 9) ? 33'400 : 16'700;
+		clock.AddPresent(now);
+	}
+	EXPECT_EQ(clock.GetNumIntervals(), 99u);
+	EXPECT_EQ(clock.GetHistogram()[16], 89u);
+	EXPECT_EQ(clock.GetHistogram()[33], 10u);
+	EXPECT_EQ(clock.GetPercentileMs(50), 17);
+	EXPECT_EQ(clock.GetPercentileMs(99), 34);
+
+	clock.ClearHistogram();
+	EXPECT_EQ(clock.GetNumIntervals(), 0u);
+}
+
+} // namespace
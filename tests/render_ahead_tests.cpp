@@ -0,0 +1,86 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "render_ahead.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+constexpr int Block = 512;
+
+TEST(RenderAhead, StartsWithinLimits)
+{
+	RenderAhead render_ahead = {};
+	render_ahead.Configure(1000, 4000, 8000);
+	EXPECT_EQ(render_ahead.GetDepth(), 4000);
+
+	render_ahead.Configure(1000, 4000, 10);
+	EXPECT_EQ(render_ahead.GetDepth(), 1000);
+}
+
+TEST(RenderAhead, GrowsOnUnderruns)
+{
+	RenderAhead render_ahead = {};
+	render_ahead.Configure(1000, 4000, 2000);
+
+	EXPECT_EQ(render_ahead.Update(100, Block), 2000 + Block);
+	EXPECT_EQ(render_ahead.GetNumUnderruns(), 1);
+
+	for (int i = 0; i < 10; ++i) {
+		render_ahead.Update(0, Block);
+	}
+	EXPECT_EQ(render_ahead.GetDepth(), 4000);
+}
+
+TEST(RenderAhead, ShrinksWhenTheQueueNeverRunsLow)
+{
+	RenderAhead render_ahead = {};
+	render_ahead.Configure(1000, 4000, 4000);
+
+	// The queue stays nearly full, so most of it isn't needed
+	auto depth = render_ahead.GetDepth();
+	for (int i = 0; i < 256 * 20; ++i) {
+		depth = render_ahead.Update(depth, Block);
+	}
+	EXPECT_EQ(depth, 1000);
+	EXPECT_EQ(render_ahead.GetNumUnderruns(), 0);
+}
+
+TEST(RenderAhead, KeepsTheMarginThatWasNeeded)
+{
+	RenderAhead render_ahead = {};
+	render_ahead.Configure(256, 8000, 4000);
+
+	// Once per window the host stalls and the queue drops to 1.5 blocks
+	auto depth = render_ahead.GetDepth();
+	for (int i = 0; i < 256 * 40; ++i) {
+		const auto queued = (i % 256 == 100) ? Block * 3 / 2 : depth;
+		depth = render_ahead.Update(queued, Block);
+	}
+	EXPECT_GE(depth, 256);
+	EXPECT_EQ(render_ahead.GetNumUnderruns(), 0);
+
+	// The dip only leaves half a block of margin, which isn't enough to
+	// shrink any further
+	EXPECT_EQ(render_ahead.Update(Block * 3 / 2, Block), depth);
+}
+
+} // namespace
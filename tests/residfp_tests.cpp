@@ -0,0 +1,158 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "residfp/SID.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace reSIDfp {
+// The sinc resampler's FIR kernel, vectorized where the host allows it
+int convolve(const short* a, const short* b, int bLength);
+} // namespace reSIDfp
+
+namespace {
+
+constexpr double ChipClock    = 894886.25;
+constexpr double SampleRateHz = 48000.0;
+
+int convolve_reference(const short* a, const short* b, const int length)
+{
+	int out = 0;
+	for (int i = 0; i < length; ++i) {
+		out += a[i] * b[i];
+	}
+	return (out + (1 << 14)) >> 15;
+}
+
+std::unique_ptr<reSIDfp::SID> make_sid(const reSIDfp::ChipModel model,
+                                       const reSIDfp::SamplingMethod method)
+{
+	auto sid = std::make_unique<reSIDfp::SID>();
+	sid->setChipModel(model);
+	sid->enableFilter(true);
+	sid->setSamplingParameters(ChipClock, method, SampleRateHz,
+	                           0.9 * SampleRateHz / 2);
+
+	// A sawtooth and a pulse through the low-pass filter at full volume
+	constexpr uint8_t Registers[][2] = {{0x00, 0x00}, {0x01, 0x10},
+	                                    {0x05, 0x00}, {0x06, 0xf0},
+	                                    {0x04, 0x21}, {0x07, 0x00},
+	                                    {0x08, 0x08}, {0x09, 0x00},
+	                                    {0x0a, 0x08}, {0x0c, 0x00},
+	                                    {0x0d, 0xf0}, {0x0b, 0x41},
+	                                    {0x15, 0x00}, {0x16, 0x40},
+	                                    {0x17, 0xf3}, {0x18, 0x1f}};
+	for (const auto& [reg, val] : Registers) {
+		sid->write(reg, val);
+	}
+	return sid;
+}
+
+TEST(ReSidFp, ConvolveMatchesReference)
+{
+	std::mt19937 rng(0x51d);
+	std::uniform_int_distribution<int> dist(-32768, 32767);
+
+	// Offsets cover both aligned and misaligned buffers. The values are
+	// scaled like samples and sinc coefficients so the sums fit in 32 bits.
+	std::vector<short> a(256 + 8);
+	std::vector<short> b(256 + 8);
+	for (auto& v : a) {
+		v = static_cast<short>(dist(rng) / 2);
+	}
+	for (auto& v : b) {
+		v = static_cast<short>(dist(rng) / 128);
+	}
+
+	for (const int length : {1, 3, 7, 8, 15, 16, 17, 63, 255}) {
+		for (const int a_offset : {0, 1, 4, 7}) {
+			for (const int b_offset : {0, 1, 4}) {
+				const auto* pa = a.data() + a_offset;
+				const auto* pb = b.data() + b_offset;
+				EXPECT_EQ(reSIDfp::convolve(pa, pb, length),
+				          convolve_reference(pa, pb, length))
+				        << "length " << length << ", offsets "
+				        << a_offset << " and " << b_offset;
+			}
+		}
+	}
+}
+
+TEST(ReSidFp, SamplingMethodsProduceTheOutputRate)
+{
+	constexpr auto NumClocks = static_cast<unsigned int>(ChipClock);
+	std::vector<short> buffer(NumClocks);
+
+	for (const auto method : {reSIDfp::RESAMPLE, reSIDfp::DECIMATE}) {
+		auto sid = make_sid(reSIDfp::MOS6581, method);
+
+		const auto num_samples = sid->clock(NumClocks, buffer.data());
+		EXPECT_NEAR(num_samples, SampleRateHz, SampleRateHz / 1000);
+
+		auto peak = 0;
+		for (auto i = 0; i < num_samples; ++i) {
+			peak = std::max(peak, std::abs(static_cast<int>(buffer[i])));
+		}
+		EXPECT_GT(peak, 1000);
+	}
+}
+
+// Host time to render one second of SID output per chip model and
+// sampling method, run it with:
+//   tests/residfp --gtest_also_run_disabled_tests --gtest_filter='*Benchmark*'
+TEST(ReSidFp, DISABLED_Benchmark)
+{
+	constexpr auto NumClocks  = static_cast<unsigned int>(ChipClock);
+	constexpr auto NumSeconds = 5;
+	std::vector<short> buffer(NumClocks);
+
+	auto time_ms = [&](const reSIDfp::ChipModel model,
+	                   const reSIDfp::SamplingMethod method) {
+		auto sid = make_sid(model, method);
+
+		// Batches as the card renders them between port writes
+		constexpr unsigned int BatchClocks = 1024;
+
+		const auto start = std::chrono::steady_clock::now();
+		for (auto second = 0; second < NumSeconds; ++second) {
+			for (unsigned int c = 0; c < NumClocks; c += BatchClocks) {
+				sid->clock(std::min(BatchClocks, NumClocks - c),
+				           buffer.data());
+			}
+		}
+		const std::chrono::duration<double, std::milli> elapsed =
+		        std::chrono::steady_clock::now() - start;
+		return elapsed.count() / NumSeconds;
+	};
+
+	for (const auto model : {reSIDfp::MOS6581, reSIDfp::MOS8580}) {
+		printf("%s  resample: %6.2f ms/s, decimate: %6.2f ms/s\n",
+		       model == reSIDfp::MOS6581 ? "6581" : "8580",
+		       time_ms(model, reSIDfp::RESAMPLE),
+		       time_ms(model, reSIDfp::DECIMATE));
+	}
+}
+
+} // namespace
@@ -0,0 +1,110 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "spsc_ring.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+namespace {
+
+TEST(SpscRing, RoundsUpCapacity)
+{
+	SpscRing<int> ring(100);
+	EXPECT_EQ(ring.MaxCapacity(), 128);
+	EXPECT_EQ(ring.GetNumWritable(), 128);
+	EXPECT_EQ(ring.GetNumReadable(), 0);
+}
+
+TEST(SpscRing, WritesWhatFits)
+{
+	SpscRing<int> ring(4);
+
+	const std::vector<int> in = {1, 2, 3, 4, 5, 6};
+	EXPECT_EQ(ring.Write(in.data(), in.size()), 4);
+	EXPECT_EQ(ring.GetNumWritable(), 0);
+	EXPECT_EQ(ring.GetNumReadable(), 4);
+
+	std::vector<int> out(6);
+	EXPECT_EQ(ring.Read(out.data(), out.size()), 4);
+	EXPECT_EQ(out[0], 1);
+	EXPECT_EQ(out[3], 4);
+	EXPECT_EQ(ring.Read(out.data(), out.size()), 0);
+}
+
+TEST(SpscRing, PeeksAndWrapsAround)
+{
+	SpscRing<int> ring(4);
+
+	for (int i = 0; i < 10; ++i) {
+		const int in[3] = {i, i + 1, i + 2};
+		ASSERT_EQ(ring.Write(in, 3), 3);
+		EXPECT_EQ(ring.Peek(0), i);
+		EXPECT_EQ(ring.Peek(2), i + 2);
+		ring.Consume(3);
+		EXPECT_EQ(ring.GetNumReadable(), 0);
+	}
+}
+
+TEST(SpscRing, Clear)
+{
+	SpscRing<int> ring(8);
+
+	const int in[5] = {};
+	ring.Write(in, 5);
+	ring.Clear();
+	EXPECT_EQ(ring.GetNumReadable(), 0);
+	EXPECT_EQ(ring.GetNumWritable(), 8);
+}
+
+TEST(SpscRing, KeepsOrderAcrossThreads)
+{
+	constexpr int num_items = 100'000;
+	SpscRing<int> ring(64);
+
+	std::thread producer([&] {
+		int next = 0;
+		while (next < num_items) {
+			const int in[7] = {next,     next + 1, next + 2, next + 3,
+			                   next + 4, next + 5, next + 6};
+			const auto n = std::min(7, num_items - next);
+			next += static_cast<int>(ring.Write(in, static_cast<size_t>(n)));
+		}
+	});
+
+	int expected  = 0;
+	bool in_order  = true;
+	while (expected < num_items) {
+		int out[16];
+		const auto n = ring.Read(out, 16);
+		for (size_t i = 0; i < n; ++i) {
+			in_order = in_order && (out[i] == expected);
+			++expected;
+		}
+	}
+	producer.join();
+
+	EXPECT_TRUE(in_order);
+	EXPECT_EQ(ring.GetNumReadable(), 0);
+}
+
+} // namespace
@@ -0,0 +1,74 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "../src/cpu/string_ops.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+constexpr uint32_t Mask16 = 0xffff;
+constexpr uint32_t Mask32 = 0xffffffff;
+
+TEST(StringOps, RunForwardToPageEnd)
+{
+	EXPECT_EQ(string_max_run(0x1000, 0x10, Mask16, true, 1), 4096 - 0x10);
+	EXPECT_EQ(string_max_run(0x1000, 0x10, Mask16, true, 4), (4096 - 0x10) / 4);
+	EXPECT_EQ(string_max_run(0, 0x12345000, Mask32, true, 2), 2048);
+}
+
+TEST(StringOps, RunForwardToOffsetWrap)
+{
+	// the linear range continues, but the 16-bit offset wraps to zero
+	EXPECT_EQ(string_max_run(0x100, 0xfff0, Mask16, true, 1), 16);
+	EXPECT_EQ(string_max_run(0x100, 0xfff0, Mask16, true, 4), 4);
+	EXPECT_EQ(string_max_run(0x100, 0xfff0, Mask32, true, 1), 4096 - 0xf0);
+}
+
+TEST(StringOps, RunBackward)
+{
+	EXPECT_EQ(string_max_run(0, 0x20, Mask16, false, 4), 9);
+	EXPECT_EQ(string_max_run(0x1000, 0x8, Mask16, false, 2), 5);
+	EXPECT_EQ(string_max_run(0x1ff0, 0x8, Mask16, false, 1), 9);
+
+	EXPECT_EQ(string_run_start(0x20, 9, 4, false), 0u);
+	EXPECT_EQ(string_run_start(0x20, 9, 4, true), 0x20u);
+}
+
+TEST(StringOps, ElementCrossingStopsRun)
+{
+	// element straddles a page boundary
+	EXPECT_EQ(string_max_run(0, 0xfff, Mask32, true, 2), 0);
+	EXPECT_EQ(string_max_run(0, 0xffe, Mask32, false, 4), 0);
+
+	// element straddles the 16-bit offset wrap
+	EXPECT_EQ(string_max_run(0x10, 0xffff, Mask16, true, 2), 0);
+}
+
+TEST(StringOps, Advance)
+{
+	EXPECT_EQ(string_advance(0x10, 3, 2, Mask16), 0x16u);
+	EXPECT_EQ(string_advance(0x10, 3, -2, Mask16), 0xau);
+	EXPECT_EQ(string_advance(0x2, 3, -2, Mask16), 0xfffcu);
+	EXPECT_EQ(string_advance(0xfffe, 2, 1, Mask16), 0u);
+	EXPECT_EQ(string_advance(0xfffe, 2, 1, Mask32), 0x10000u);
+}
+
+} // namespace
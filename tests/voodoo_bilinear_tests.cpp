@@ -0,0 +1,109 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "../src/hardware/voodoo_bilinear.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+namespace {
+
+using voodoo::bilinear_filter_reference;
+
+struct Texels {
+	uint32_t rgb00 = 0;
+	uint32_t rgb01 = 0;
+	uint32_t rgb10 = 0;
+	uint32_t rgb11 = 0;
+};
+
+std::vector<Texels> make_texels()
+{
+	std::vector<Texels> texels = {
+	        {0x00000000, 0x00000000, 0x00000000, 0x00000000},
+	        {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+	        {0x00000000, 0xffffffff, 0xffffffff, 0x00000000},
+	        {0xff00ff00, 0x00ff00ff, 0x80808080, 0x7f7f7f7f},
+	        {0x12345678, 0x9abcdef0, 0x0fedcba9, 0x87654321},
+	};
+
+	std::mt19937 rng(1234);
+	for (int i = 0; i < 16; ++i) {
+		texels.push_back({static_cast<uint32_t>(rng()),
+		                  static_cast<uint32_t>(rng()),
+		                  static_cast<uint32_t>(rng()),
+		                  static_cast<uint32_t>(rng())});
+	}
+	return texels;
+}
+
+template <typename Filter>
+void expect_matches_reference(Filter filter)
+{
+	for (const auto& t : make_texels()) {
+		for (int u = 0; u < 256; ++u) {
+			for (int v = 0; v < 256; ++v) {
+				const auto expected = bilinear_filter_reference(
+				        t.rgb00, t.rgb01, t.rgb10, t.rgb11, u, v);
+				const auto result = filter(
+				        t.rgb00, t.rgb01, t.rgb10, t.rgb11, u, v);
+				if (result != expected) {
+					FAIL() << std::hex << "texels " << t.rgb00
+					       << " " << t.rgb01 << " " << t.rgb10
+					       << " " << t.rgb11 << std::dec
+					       << " at u " << u << " v " << v;
+				}
+			}
+		}
+	}
+}
+
+TEST(VoodooBilinear, ReferenceCorners)
+{
+	constexpr Texels t = {0x11223344, 0x55667788, 0x99aabbcc, 0xddeeff00};
+
+	EXPECT_EQ(bilinear_filter_reference(t.rgb00, t.rgb01, t.rgb10, t.rgb11, 0, 0),
+	          t.rgb00);
+	EXPECT_EQ(bilinear_filter_reference(0x00000000, 0xfefefefe, 0, 0xfefefefe, 128, 0),
+	          0x7f7f7f7fu);
+	EXPECT_EQ(bilinear_filter_reference(0, 0, 0xfefefefe, 0xfefefefe, 0, 128),
+	          0x7f7f7f7fu);
+}
+
+#if defined(__SSE2__)
+TEST(VoodooBilinear, Sse2MatchesReference)
+{
+	expect_matches_reference(voodoo::bilinear_filter_sse2);
+}
+#endif
+
+TEST(VoodooBilinear, SimdeMatchesReference)
+{
+	expect_matches_reference(voodoo::bilinear_filter_simde);
+}
+
+TEST(VoodooBilinear, FilterMatchesReference)
+{
+	expect_matches_reference(voodoo::bilinear_filter);
+}
+
+} // namespace
@@ -0,0 +1,78 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "worker_pool.h"
+
+#include <atomic>
+#include <future>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+TEST(WorkerPool, RunsAllTasksBeforeBeingDestroyed)
+{
+	std::atomic_int num_run = 0;
+	{
+		WorkerPool pool(4);
+		for (int i = 0; i < 100; ++i) {
+			pool.Submit(WorkerPriority::Background, [&] { ++num_run; });
+		}
+	}
+	EXPECT_EQ(num_run, 100);
+}
+
+TEST(WorkerPool, PicksTasksOfHigherPriorityFirst)
+{
+	std::vector<WorkerPriority> order = {};
+
+	std::promise<void> release = {};
+	auto released              = release.get_future();
+	{
+		WorkerPool pool(1);
+
+		// Keep the only thread busy until all tasks are queued
+		pool.Submit(WorkerPriority::Audio, [&] { released.wait(); });
+
+		for (const auto priority : {WorkerPriority::Background,
+		                            WorkerPriority::Capture,
+		                            WorkerPriority::Audio,
+		                            WorkerPriority::Video}) {
+			pool.Submit(priority, [&order, priority] {
+				order.push_back(priority);
+			});
+		}
+		release.set_value();
+	}
+	const std::vector<WorkerPriority> expected = {WorkerPriority::Audio,
+	                                              WorkerPriority::Video,
+	                                              WorkerPriority::Capture,
+	                                              WorkerPriority::Background};
+	EXPECT_EQ(order, expected);
+}
+
+TEST(WorkerPool, DefaultsToTheHostsThreads)
+{
+	WorkerPool pool(0);
+	EXPECT_GE(pool.GetMaxThreads(), 1);
+}
+
+} // namespace